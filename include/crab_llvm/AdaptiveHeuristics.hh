@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * Selection of the abstract domain with --crab-relational-threshold-loops
+ * and --crab-relational-threshold-packs.
+ *
+ * With the first option only the blocks inside loops are
+ * considered to decide whether the relational domain is too
+ * expensive. Blocks outside loops are analyzed once so a large
+ * number of live variables there (e.g., initialization code)
+ * should not make the whole function fall back to intervals. With
+ * the second option the size of the largest pack of related
+ * variables is used instead if it is smaller.
+ **/
+
+namespace llvm {
+  class Function;
+  class Module;
+}
+
+namespace crab_llvm {
+namespace adaptive_impl {
+
+  // Return the max number of tracked LLVM values that are live at
+  // the exit of a block of F (only blocks inside loops if
+  // only_loops).
+  unsigned maxLiveOut(const llvm::Function &F, bool only_loops);
+
+  unsigned maxLiveInLoops(const llvm::Function &F);
+
+  // Return the size of the largest pack of F. A pack is a set of
+  // tracked LLVM values that can be related by the translation.
+  unsigned maxPackSize(const llvm::Function &F);
+
+  // Return an upper bound of the number of terms that a term
+  // domain creates for F.
+  unsigned numTerms(const llvm::Function &F);
+
+  // Return the jump set size of F if --crab-widening-auto-jump-set
+  // (0 otherwise)
+  unsigned autoJumpSet(const llvm::Function &F);
+
+  // Return the max number of tracked parameters and return values
+  // of the functions of a SCC of the call graph of M.
+  unsigned maxSccBoundary(llvm::Module &M);
+
+} // end namespace adaptive_impl
+} // end namespace crab_llvm
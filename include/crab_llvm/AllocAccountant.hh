@@ -0,0 +1,60 @@
+#pragma once
+
+/** 
+ * Allocations of each phase of the analysis and of each function
+ * (--crab-alloc-stats), printed with --crab-stats.
+ *
+ * A phase is charged with the allocations done by the thread that
+ * runs it. Its live bytes are the bytes allocated minus the bytes
+ * freed by the phase, so they can be negative for phases that free
+ * what previous phases allocated. Phases that are nested (e.g., the
+ * intra-procedural phases inside the heap analysis or inter) are
+ * also charged to their parents.
+ **/
+
+#include "crab_llvm/Support/AllocStats.hh"
+#include "llvm/ADT/StringRef.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace llvm {
+  class Function;
+  class raw_ostream;
+}
+
+namespace crab_llvm {
+namespace alloc_stats_impl {
+
+  class accountant {
+    std::map<std::string, alloc_sample> m_phases;
+    std::map<std::string, alloc_sample> m_functions;
+    std::mutex m_mutex;
+
+  public:
+
+    void add(const std::string &fn, const std::string &phase, const alloc_sample &s);
+
+    void print(llvm::raw_ostream &o, unsigned top);
+  };
+
+  // Charge the allocations done in the scope to phase (and F if
+  // any) in acc (if not null)
+  class scoped_alloc {
+    accountant *m_acc;
+    bool m_enabled;
+    std::string m_fn;
+    std::string m_phase;
+    alloc_sample m_start;
+
+  public:
+
+    scoped_alloc(accountant *acc, llvm::StringRef phase, const llvm::Function *F = nullptr);
+
+    ~scoped_alloc();
+  };
+
+} // end namespace alloc_stats_impl
+} // end namespace crab_llvm
@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * --crab-heap-analysis=auto-sea-dsa. Context-sensitive sea-dsa
+ * cannot be interrupted, so it runs in a child process limited by
+ * --crab-dsa-auto-ms and --crab-dsa-auto-mb that sends back its
+ * regions as a heap snapshot. If the child does not finish, the
+ * whole module uses context-insensitive sea-dsa. Otherwise, only
+ * the functions that access more than --crab-dsa-auto-fn-regions
+ * regions (e.g., a recursive cluster where the contexts blow up)
+ * use context-insensitive sea-dsa. With --crab-inter, callers and
+ * callees must agree on the regions, so the whole module does.
+ **/
+
+#include <boost/shared_ptr.hpp>
+
+namespace llvm {
+  class Module;
+  class CallGraph;
+  class TargetLibraryInfo;
+}
+
+namespace crab_llvm {
+  class HeapAbstraction;
+
+namespace auto_dsa_impl {
+
+  boost::shared_ptr<HeapAbstraction>
+  build(llvm::Module &M, llvm::CallGraph &cg, const llvm::TargetLibraryInfo &tli);
+
+} // end namespace auto_dsa_impl
+} // end namespace crab_llvm
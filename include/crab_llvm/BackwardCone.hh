@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * Restrict the backward analysis to the blocks that can reach an
+ * assertion not proven by the forward analysis
+ * (--crab-backward-cone).
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+#include "crab/analysis/abs_transformer.hpp"
+
+#include <boost/range/iterator_range.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <memory>
+#include <vector>
+
+namespace crab_llvm {
+namespace cone_impl {
+  typedef boost::unordered_set<basic_block_label_t> block_set_t;
+  typedef std::vector<std::pair<crab::checker::check_kind_t,
+				crab::cfg::debug_info>> block_checks_t;
+
+  /* 
+   * Check the assertions of each block with the forward invariants
+   * of analyzer. Return the status of the checks of each block
+   * whose checks are all proven (as crab's assertion checker) and
+   * fill unproven with the other blocks. Blocks with pointer or
+   * boolean assertions are considered unproven.
+   */
+  template<typename Dom, typename Analyzer>
+  boost::unordered_map<basic_block_label_t, block_checks_t>
+  getProvenChecks(cfg_ref_t cfg, Analyzer &analyzer, block_set_t &unproven) {
+    typedef typename cfg_ref_t::basic_block_t::assert_t assert_t;
+    typedef crab::analyzer::intra_abs_transformer<Dom> abs_tr_t;
+    boost::unordered_map<basic_block_label_t, block_checks_t> res;
+    for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+      auto &b = cfg.get_node(bl);
+      bool has_checks = false;
+      bool is_proven = true;
+      block_checks_t checks;
+      Dom inv = analyzer.get_pre(bl);
+      abs_tr_t vis(&inv);
+      for (auto &s: b) {
+	if (s.is_ptr_assert() || s.is_bool_assert()) {
+	  has_checks = true;
+	  is_proven = false;
+	  break;
+	}
+	if (s.is_assert()) {
+	  has_checks = true;
+	  const assert_t *a = static_cast<const assert_t*>(&s);
+	  crab::checker::check_kind_t kind = checkAssertion(inv, *a);
+	  if (kind == crab::checker::_WARN) {
+	    is_proven = false;
+	    break;
+	  }
+	  checks.push_back(std::make_pair(kind, a->get_debug_info()));
+	}
+	s.accept(&vis);
+      }
+      if (!is_proven) {
+	unproven.insert(bl);
+      } else if (has_checks) {
+	res[bl] = std::move(checks);
+      }
+    }
+    return res;
+  }
+
+  // blocks that can reach some block in targets (including targets)
+  block_set_t getCone(cfg_ref_t cfg, const block_set_t &targets);
+
+  /* 
+   * Return a copy of cfg with only the blocks of cone (and the exit
+   * so the backward analysis has a start point). The other blocks
+   * cannot reach cone so the forward invariants of the blocks of
+   * cone do not change and their contribution to the necessary
+   * preconditions is bottom.
+   */
+  std::unique_ptr<cfg_t> restrict(const cfg_t &cfg, const block_set_t &cone);
+
+} // end namespace cone_impl
+} // end namespace crab_llvm
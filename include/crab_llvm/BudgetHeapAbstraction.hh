@@ -0,0 +1,105 @@
+#pragma once
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/HeapAbstraction.hh"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace llvm {
+  class Module;
+  class Function;
+  class Value;
+  class CallInst;
+}
+
+namespace crab_llvm {
+
+  /*
+   * Heap abstraction that bounds the number of regions accessed by
+   * each function. If a function accesses more than budget regions
+   * of the underlying heap abstraction then its least accessed
+   * regions are merged with the other regions of the same type and
+   * bitwidth into summary regions. A summary region is never a
+   * singleton.
+   *
+   * The regions of a callsite are those of the caller, so they are not
+   * merged as the regions of the callee. Hence, it cannot be used by
+   * the inter-procedural analysis.
+   */
+  class BudgetHeapAbstraction: public HeapAbstraction {
+
+   public:
+
+     using typename HeapAbstraction::region_t;
+     using typename HeapAbstraction::region_set_t;
+
+   private:
+
+    enum set_kind_t { ACCESSED = 0, ONLY_READ = 1, MODIFIED = 2, NEW = 3, NUM_SET_KINDS = 4};
+
+    boost::shared_ptr<HeapAbstraction> m_base;
+    unsigned m_budget;
+    // merged region id -> id of its summary region
+    llvm::DenseMap<int, int> m_rep;
+    // ids of the summary regions
+    llvm::DenseSet<int> m_summaries;
+    // (region type, bitwidth) -> id of its summary region
+    llvm::DenseMap<std::pair<int, unsigned>, int> m_class_summary;
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_sets[NUM_SET_KINDS];
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_sets[NUM_SET_KINDS];
+    region_set_t m_empty_set;
+
+    region_t map(const region_t &r);
+    region_set_t map(const region_set_t &s);
+
+    // merge the least accessed regions of F until it fits the budget
+    void mergeRegions(llvm::Function &F);
+
+    // map the sets of the underlying heap abstraction such that mod
+    // regions are a subset of the read regions and the new regions
+    // are disjoint from the read regions.
+    void mapSets(region_set_t sets[NUM_SET_KINDS]);
+
+    const region_set_t& lookup(const llvm::Function &F, set_kind_t k) const;
+    const region_set_t& lookup(const llvm::CallInst &I, set_kind_t k) const;
+
+   public:
+
+    BudgetHeapAbstraction(llvm::Module &M, boost::shared_ptr<HeapAbstraction> base,
+			  unsigned budget);
+
+    // number of regions merged into summary regions
+    unsigned numMergedRegions() const { return m_rep.size(); }
+
+    virtual region_t getRegion(const llvm::Function &F, llvm::Value *V) override;
+
+    virtual const llvm::Value* getSingleton(int region) const override;
+
+    virtual const llvm::Value* getLocalSingleton(const llvm::Function &F,
+						 int region) const override;
+
+    virtual const region_set_t& getAccessedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getOnlyReadRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getModifiedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getNewRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getAccessedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getOnlyReadRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getModifiedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getNewRegions(llvm::CallInst &I) override;
+
+    virtual llvm::StringRef getName() const override {
+      return "BudgetHeapAbstraction";
+    }
+  };
+
+} // end namespace crab_llvm
@@ -7,6 +7,10 @@
 
 #include <boost/optional.hpp>
 #include <boost/noncopyable.hpp>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "llvm/ADT/DenseSet.h"
 #include "crab_llvm/crab_cfg.hh"
 
 // forward declarations
@@ -28,7 +32,9 @@ namespace crab_llvm {
   class crabLit;
   class crabLitFactoryImpl;
   
-  typedef boost::shared_ptr<crabLit> crab_lit_ref_t;
+  // Non-owning handle: literals are owned by the crabLitFactory
+  // that created them.
+  typedef const crabLit* crab_lit_ref_t;
   
   /** 
       Factory to create crab literals: typed variable or number.
@@ -89,6 +95,23 @@ namespace crab_llvm {
     }
   };
   
+  /** 
+      Cost of translating each kind of instruction (only used for
+      benchmarking).
+  **/
+  struct CfgBuilderProfile {
+    struct cost {
+      unsigned count;
+      double secs;
+      size_t allocs;
+      cost(): count(0), secs(0), allocs(0) {}
+    };
+    // indexed by llvm opcode
+    std::vector<cost> costs;
+    // if set, return the number of allocations done so far
+    std::function<size_t()> num_allocs;
+  };
+  
   /** 
      Build a Crab CFG from LLVM Function
   **/
@@ -105,15 +128,53 @@ namespace crab_llvm {
     // The caller owns the pointer and it will be in charge of freeing it.
     cfg_t* get_cfg();
 
+    // Record in profile the cost of each instruction translated by
+    // get_cfg (nullptr disables it).
+    void set_profile(CfgBuilderProfile *profile) { m_profile = profile; }
+
+    typedef llvm::DenseSet<const llvm::Function*> function_set_t;
+    
+    // Calls to the functions in pruned are not translated (nullptr
+    // disables it). The functions must not have effects on their
+    // callers: they do not return tracked values, modify or create
+    // regions.
+    void set_pruned_functions(const function_set_t *pruned) { m_pruned = pruned; }
+
+    // Fill order with the iteration order of the CFG built by get_cfg
+    // (nullptr disables it). The extra blocks of the branches follow
+    // their source block.
+    void set_loop_order(cfg_loop_order *order) { m_loop_order = order; }
+
     // expose internal details
     typedef boost::unordered_map<std::pair<const llvm::BasicBlock*,
 					   const llvm::BasicBlock*>,
 			       basic_block_label_t, pair_hash> edge_to_bb_map_t;
 
     // expose internal details.
-    // return by value because it is intended to survive CfgBuilder.
-    edge_to_bb_map_t getEdgeToBBMap() const
+    const edge_to_bb_map_t& getEdgeToBBMap() const
     { return m_edge_bb_map; }
+
+    // Move the map out of CfgBuilder so it can survive it. It must
+    // be called after get_cfg.
+    edge_to_bb_map_t releaseEdgeToBBMap()
+    { return std::move(m_edge_bb_map); }
+
+    // Return a stable hash of func together with all the options that
+    // affect its translation. Two functions with the same fingerprint
+    // are translated to the same crab CFG.
+    static std::string fingerprint(const llvm::Function& func, HeapAbstraction &mem,
+				   crab::cfg::tracked_precision tracklev,
+				   bool isInterProc);
+
+    // Return the number of calls to assertions and error functions in
+    // func. It does not require building the CFG.
+    static unsigned num_checks(const llvm::Function& func);
+
+    // Compute the layout of all the structs used by func. DataLayout
+    // computes a layout the first time it is queried and caches it
+    // without a lock, so this must be called before func is
+    // translated by several threads at the same time.
+    static void compute_struct_layouts(const llvm::Function& func);
     
    private:
 
@@ -135,9 +196,18 @@ namespace crab_llvm {
     bool m_is_inter_proc;
     const llvm::DataLayout* m_dl;
     const llvm::TargetLibraryInfo *m_tli;
+    CfgBuilderProfile *m_profile;
+    const function_set_t *m_pruned;
+    cfg_loop_order *m_loop_order;
     
     void build_cfg();
 
+    // compute the iteration order of m_cfg from the loops of m_func
+    void compute_loop_order(cfg_loop_order &order);
+
+    // havoc array variables of regions that are not read anymore
+    void forget_dead_regions();
+
     void add_block(llvm::BasicBlock &BB);
 
     opt_basic_block_t lookup(const llvm::BasicBlock &);
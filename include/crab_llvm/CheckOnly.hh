@@ -0,0 +1,77 @@
+#pragma once
+
+/**
+ * Check a single assertion given by its file and line
+ * (--crab-check-only). Only the functions needed to discharge it
+ * are analyzed and the other checks are removed from their CFGs.
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <boost/range/iterator_range.hpp>
+#include <boost/unordered_set.hpp>
+#include <set>
+#include <vector>
+
+namespace llvm {
+  class Module;
+  class CallGraph;
+}
+
+namespace crab_llvm {
+namespace check_only_impl {
+
+  bool enabled();
+
+  /*
+   * The assertions at --crab-check-only and the functions that must
+   * be analyzed to check them.
+   */
+  class target_set {
+    // debug locations of the assertions at file:line (there can be
+    // several copies of an assertion, e.g., after inlining)
+    std::set<crab::cfg::debug_info> m_targets;
+    // functions to be analyzed
+    boost::unordered_set<const llvm::Function*> m_relevant;
+
+  public:
+
+    /*
+     * Find the assertions at --crab-check-only and the functions
+     * that must be analyzed: the functions with the assertions and,
+     * with the inter-procedural analysis, all their callers and the
+     * functions called by any of them. Return false if file:line
+     * does not contain any assertion.
+     */
+    bool init(llvm::Module &M, llvm::CallGraph &cg, bool inter);
+
+    bool empty() const { return m_targets.empty(); }
+
+    bool isRelevant(const llvm::Function &F) const;
+
+    // Remove from cfg all checks but the targets. Return the number
+    // of removed checks.
+    template<typename CFG>
+    unsigned removeOtherChecks(CFG &cfg) const {
+      typedef typename CFG::statement_t stmt_t;
+      unsigned num_removed = 0;
+      for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+	auto &b = cfg.get_node(bl);
+	std::vector<stmt_t*> others;
+	for (auto &s: b) {
+	  if ((s.is_assert() || s.is_ptr_assert() || s.is_bool_assert()) &&
+	      !m_targets.count(s.get_debug_info())) {
+	    others.push_back(&s);
+	  }
+	}
+	for (stmt_t *s: others) {
+	  b.remove(s);
+	}
+	num_removed += others.size();
+      }
+      return num_removed;
+    }
+  };
+
+} // end namespace check_only_impl
+} // end namespace crab_llvm
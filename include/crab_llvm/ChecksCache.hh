@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * Persistent cache of the checks of each function
+ * (--crab-checks-cache).
+ *
+ * Unlike --crab-incremental only the number of safe, error and
+ * warning checks is stored so an entry is a few bytes. The key is
+ * the same as --crab-incremental (plus --crab-check-layered). With
+ * --crab-inter the checks of a function also depend on its callers
+ * and callees so there is only one entry for the whole module,
+ * keyed by all the functions. A function (or module) whose checks
+ * are replayed from the cache is not analyzed so it has no
+ * invariants.
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <string>
+
+namespace llvm {
+  class Module;
+}
+
+namespace crab_llvm {
+  class HeapAbstraction;
+
+namespace checks_cache_impl {
+
+  // the entry of F
+  std::string getFileName(const std::string &dir, const llvm::Function &F,
+			  const AnalysisParams &params, HeapAbstraction &mem);
+
+  // the entry of the whole module (--crab-inter)
+  std::string getFileName(const std::string &dir, llvm::Module &M,
+			  const AnalysisParams &params, HeapAbstraction &mem);
+
+  // Add the checks of file to checks. Return false if file does not
+  // exist or it cannot be read.
+  bool load(const std::string &file, checks_db_t &checks);
+
+  void store(const std::string &file, const checks_db_t &checks);
+
+} // end namespace checks_cache_impl
+} // end namespace crab_llvm
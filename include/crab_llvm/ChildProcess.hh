@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * Run part of the analysis in a child process bounded in time and
+ * memory (the function budgets, --crab-dom=adapt-rtz and
+ * --crab-heap-analysis=auto-sea-dsa). The child sends back its
+ * results through a file.
+ **/
+
+#include <functional>
+#include <string>
+
+namespace crab_llvm {
+namespace child_impl {
+
+  enum status_t {
+    // the child finished and wrote its results
+    FINISHED,
+    // the child exceeded its time or its memory: it timed out, it
+    // could not allocate within its limit or it was killed with
+    // SIGKILL (e.g., by the kernel when memory is exhausted)
+    EXCEEDED,
+    // anything else: the child could not be run, it could not write
+    // its results or it crashed
+    FAILED
+  };
+
+  /* 
+   * Run body in a child process. The child is killed after
+   * timeout_ms (0: no limit) and it can allocate mem_mb (0: no
+   * limit) on top of what this process already uses. body returns
+   * false if it could not write its results. If the child does not
+   * finish, error is set to the reason.
+   */
+  status_t run(const std::function<bool()> &body,
+	       unsigned timeout_ms, unsigned mem_mb, std::string &error);
+
+} // end namespace child_impl
+} // end namespace crab_llvm
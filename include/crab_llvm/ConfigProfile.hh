@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+ * Per-function analysis options learned from previous runs
+ * (--crab-config-profile). Each function is keyed by the
+ * fingerprint of its translation so the options of a function that
+ * changed are not reused. The file has one line per function:
+ *
+ *   <key> <dom> <widening delay> <narrowing iterations> <jump set>
+ *   <ms> <unproven checks> <name>
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <boost/unordered_map.hpp>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace llvm {
+  class Module;
+}
+
+namespace crab_llvm {
+  class HeapAbstraction;
+
+namespace config_profile_impl {
+
+  struct entry {
+    CrabDomain dom;
+    unsigned widening_delay;
+    unsigned narrowing_iters;
+    unsigned widening_jumpset;
+    // observed cost of the analysis
+    unsigned ms;
+    unsigned unproven;
+    std::string name;
+  };
+
+  class profile {
+    // computed once so that workers only read it
+    boost::unordered_map<const llvm::Function*, std::string> m_keys;
+    std::map<std::string, entry> m_loaded;
+    std::map<std::string, entry> m_recorded;
+    std::mutex m_mutex;
+
+  public:
+
+    profile(llvm::Module &M, HeapAbstraction &mem);
+
+    // A missing file is not an error: it is the first run
+    bool load(const std::string &file);
+
+    // the entries of this run replace the loaded ones
+    bool store(const std::string &file);
+
+    const entry* find(const llvm::Function &F) const;
+
+    // Use the options recorded for F, if any
+    void apply(const llvm::Function &F, AnalysisParams &params) const;
+
+    // params are the options after the analysis of F (e.g., the
+    // domain of the last layer)
+    void record(const llvm::Function &F, const AnalysisParams &params,
+		const checks_db_t &checks, unsigned ms);
+  };
+
+  unsigned elapsed_ms(std::chrono::steady_clock::time_point start);
+
+} // end namespace config_profile_impl
+} // end namespace crab_llvm
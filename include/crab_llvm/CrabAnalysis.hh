@@ -0,0 +1,89 @@
+#pragma once
+
+/* 
+ * Crab invariants as an analysis of the new LLVM pass manager.
+ */
+
+#include "llvm/IR/PassManager.h"
+#include "crab_llvm/CrabLlvm.hh"
+
+#include <memory>
+
+namespace llvm {
+  class Function;
+  class BasicBlock;
+}
+
+namespace crab_llvm {
+
+  /**
+   * Intra-procedural analysis of a function for the new pass
+   * manager. Its results are cached by the FunctionAnalysisManager
+   * so a function is analyzed again only if a transformation does
+   * not preserve CrabAnalysis on it. Thus, passes that query the
+   * invariants between transformations do not pay for the functions
+   * that did not change.
+   *
+   * Basic usage:
+   *    FunctionAnalysisManager FAM;
+   *    FAM.registerPass(TargetLibraryAnalysis());
+   *    FAM.registerPass(CrabAnalysis(params));
+   *    auto &res = FAM.getResult<CrabAnalysis>(F);
+   *    if (auto dom_ptr = res.get_pre(&F.getEntryBlock())) { ... }
+   *
+   * The heap abstraction, if any, is shared by all the functions and
+   * it is not recomputed when the module changes.
+   **/
+  class CrabAnalysis {
+    static char PassID;
+    AnalysisParams m_params;
+    crab::cfg::tracked_precision m_cfg_precision;
+    IntraCrabLlvm::heap_abs_ptr m_heap_abs;
+
+  public:
+
+    typedef IntraCrabLlvm::wrapper_dom_ptr wrapper_dom_ptr;
+    typedef IntraCrabLlvm::checks_db_t checks_db_t;
+
+    class Result {
+      friend class CrabAnalysis;
+      // m_crab refers to the cfg owned by m_cfg_man
+      std::unique_ptr<CfgManager> m_cfg_man;
+      std::unique_ptr<IntraCrabLlvm> m_crab;
+
+      Result();
+
+    public:
+
+      Result(Result &&o);
+      ~Result();
+
+      /**
+       * Return invariants that hold at the entry of b
+       **/
+      wrapper_dom_ptr get_pre(const llvm::BasicBlock *b, bool keep_shadows=false) const;
+
+      /**
+       * Return invariants that hold at the exit of b
+       **/
+      wrapper_dom_ptr get_post(const llvm::BasicBlock *b, bool keep_shadows=false) const;
+
+      /**
+       * Return a database with all checks of the function.
+       **/
+      const checks_db_t& get_checks_db() const;
+    };
+
+    static void *ID() { return (void *)&PassID; }
+
+    static llvm::StringRef name() { return "CrabAnalysis"; }
+
+    explicit CrabAnalysis(const AnalysisParams &params = AnalysisParams(),
+			  crab::cfg::tracked_precision cfg_precision = crab::cfg::NUM,
+			  IntraCrabLlvm::heap_abs_ptr heap_abs = nullptr)
+      : m_params(params), m_cfg_precision(cfg_precision), m_heap_abs(heap_abs) {}
+
+    Result run(llvm::Function &F, llvm::FunctionAnalysisManager *AM);
+  };
+
+} // end namespace crab_llvm
@@ -7,14 +7,24 @@
 
 #include "llvm/Pass.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "crab_llvm/crab_cfg.hh"
 #include "crab/checkers/base_property.hpp"
+#include "crab/domains/intervals.hpp"
 #include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 // forward declarations
 
 namespace llvm {
   class TargetLibraryInfo;
+  class CallGraph;
 }
 
 namespace crab_llvm {
@@ -22,6 +32,7 @@ namespace crab_llvm {
   struct GenericAbsDomWrapper;
   class IntraCrabLlvm_Impl;
   class InterCrabLlvm_Impl;
+  struct ModuleState;
 }
 
 
@@ -36,6 +47,8 @@ namespace crab_llvm {
        , DIS_INTERVALS
        /*, ZONES_SPARSE_DBM*/
        , ZONES_SPLIT_DBM
+         // ZONES_SPLIT_DBM with int64 weights
+       , ZONES_SPLIT_DBM_FAST
        , TERMS_INTERVALS
        , TERMS_DIS_INTERVALS
          //TERMS_INTERVALS x  ZONES_SPLIT_DBM
@@ -45,6 +58,13 @@ namespace crab_llvm {
        , OCT
        , PK
        , WRAPPED_INTERVALS
+       , DENSE_INTERVALS
+         // WRAPPED_INTERVALS with native uint64_t bounds
+       , WRAPPED_INTERVALS_FAST
+         // DENSE_INTERVALS x (base region, offset interval) of pointers
+       , PTR_OFFSETS
+         // ZONES_SPLIT_DBM_FAST with dense DBMs for small dense states
+       , ZONES_DENSE_DBM
      };
 
   ////
@@ -56,7 +76,12 @@ namespace crab_llvm {
       // use context-insensitive sea-dsa
       CI_SEA_DSA = 1,
       // use context-sensitive sea-dsa
-      CS_SEA_DSA = 2
+      CS_SEA_DSA = 2,
+      // use the types of the program (no pointer analysis)
+      TYPE_BASED = 3,
+      // use context-sensitive sea-dsa if it fits a budget, otherwise
+      // context-insensitive sea-dsa
+      AUTO_SEA_DSA = 4
   };
   
   ////
@@ -68,6 +93,28 @@ namespace crab_llvm {
       NULLITY = 2
     };
 
+  ////
+  // How invariants are stored after the analysis
+  ////
+  enum invariants_storage_t
+    { // copy the invariants at the entry and exit of each block
+      EAGER_STORAGE = 0,
+      // keep the analyzer alive and build invariants on demand
+      LAZY_STORAGE = 1,
+      // copy only the invariants at the entry of each block and
+      // recompute the ones at the exit on demand
+      PRE_ONLY_STORAGE = 2,
+      // write the invariants at the entry and exit of each block to
+      // a temporary file and keep in memory only the most recently
+      // used ones (AnalysisParams::invariants_in_memory)
+      SPILL_STORAGE = 3,
+      // copy the invariants at the entry of each block as the
+      // constraints added and removed with respect to the invariant of
+      // its immediate dominator and recompute the ones at the exit on
+      // demand
+      DELTA_STORAGE = 4
+    };
+
 }
 
 namespace crab_llvm {
@@ -75,6 +122,19 @@ namespace crab_llvm {
   /**
    * Class to set analysis options
    **/
+  /**
+   * Progress of the analysis of a module reported to clients (see
+   * AnalysisParams::progress).
+   **/
+  struct AnalysisProgress {
+    // functions already analyzed (or skipped)
+    unsigned functions_done;
+    unsigned total_functions;
+    // the function that has just been analyzed. The whole module
+    // for the inter-procedural analysis.
+    std::string function;
+  };
+  
   struct AnalysisParams {
     CrabDomain dom;
     CrabDomain sum_dom;
@@ -82,6 +142,8 @@ namespace crab_llvm {
     bool run_liveness;
     bool run_inter;
     unsigned relational_threshold;
+    bool relational_threshold_loops;
+    bool relational_threshold_packs;
     unsigned widening_delay;
     unsigned narrowing_iters;
     unsigned widening_jumpset;
@@ -91,21 +153,44 @@ namespace crab_llvm {
     bool print_unjustified_assumptions;
     bool print_summaries;
     bool store_invariants;
+    invariants_storage_t invariants_storage;
+    unsigned invariants_in_memory;
     bool keep_shadow_vars;
     assert_check_kind_t check;
     unsigned check_verbose;
+    // Domains tried in order by the path analysis with layered
+    // solving, after boolean reasoning. If empty then only dom is
+    // used.
+    std::vector<CrabDomain> path_layers;
+    // If not null then the analysis stops as soon as it is set. It is
+    // polled before each function, each phase of the analysis of a
+    // function and each path analysis (a crab fixpoint cannot be
+    // interrupted). Functions that are not analyzed have neither
+    // invariants nor checks.
+    const std::atomic<bool> *cancel;
+    // If set then it is called by CrabLlvmPass after each function is
+    // analyzed and after the inter-procedural analysis. Calls are
+    // serialized if functions are analyzed by several threads.
+    std::function<void(const AnalysisProgress&)> progress;
     
     AnalysisParams()
       : dom(INTERVALS), sum_dom(ZONES_SPLIT_DBM),
 	run_backward(false), run_liveness(false), run_inter(false),
-	relational_threshold(10000),
+	relational_threshold(10000), relational_threshold_loops(false),
+	relational_threshold_packs(false),
 	widening_delay(1), narrowing_iters(10), widening_jumpset(0),
 	stats(false),
 	print_invars(false), print_preconds(false),
 	print_unjustified_assumptions(false), print_summaries(false),
-	store_invariants(true), keep_shadow_vars(false),
-	check(NOCHECKS), check_verbose(0) { }
-
+	store_invariants(true), invariants_storage(EAGER_STORAGE),
+	invariants_in_memory(10000),
+	keep_shadow_vars(false),
+	check(NOCHECKS), check_verbose(0), cancel(nullptr) { }
+
+    bool is_cancelled() const {
+      return cancel && cancel->load();
+    }
+    
     std::string abs_dom_to_str() const;
     
     std::string sum_abs_dom_to_str() const;
@@ -113,16 +198,65 @@ namespace crab_llvm {
 
   /**
    * A manager that keeps all the crab CFGs 
+   *
+   * If a builder is set then at most capacity CFGs are kept after
+   * evict is called. The least recently used ones are freed and
+   * rebuilt by the builder when they are requested again.
    **/
   class CfgManager {
-    // The manager owns the pointers to cfg's
-    llvm::DenseMap<const llvm::Function*, cfg_t*> m_cfg_map;
+    typedef std::list<const llvm::Function*> lru_t;
+    typedef std::function<cfg_t*(const llvm::Function&)> builder_t;
+    // The manager shares the ownership of the cfg's with the analyses
+    // and the stored invariants that still use them
+    mutable llvm::DenseMap<const llvm::Function*, cfg_ptr_t> m_cfg_map;
+    // Reverse mapping
+    mutable llvm::DenseMap<const cfg_t*, const llvm::Function*> m_func_map;
+    // Most recently used last
+    mutable lru_t m_lru;
+    mutable llvm::DenseMap<const llvm::Function*, lru_t::iterator> m_lru_pos;
+    // Functions whose cfg has been evicted or deferred
+    mutable llvm::DenseSet<const llvm::Function*> m_evicted;
+    unsigned m_capacity;
+    builder_t m_builder;
+    // The manager can be queried and updated by several threads
+    mutable std::mutex m_mutex;
+
+    void touch(const llvm::Function &f) const;
+    void insert(const llvm::Function &f, cfg_ptr_t cfg) const;
+    void erase(const llvm::Function &f) const;
+    
   public:
     CfgManager();
     ~CfgManager();
     bool has_cfg(const llvm::Function &f) const;
+    // The cfg is rebuilt if it has been evicted
     cfg_ref_t operator[](const llvm::Function &f) const;
+    // Same as operator[] but the caller shares the ownership of the
+    // cfg so it is not freed by evict
+    cfg_ptr_t get_ptr(const llvm::Function &f) const;
+    // Return null if cfg is not managed
+    const llvm::Function* get_function(const cfg_t &cfg) const;
     void add(const llvm::Function &f, cfg_t *cfg);
+    void add(const llvm::Function &f, cfg_ptr_t cfg);
+    // The cfg of f is built by the builder when it is first
+    // requested (e.g., its analysis results were reused)
+    void defer(const llvm::Function &f);
+    // Free the cfg of f (if any). It is not rebuilt.
+    void release(const llvm::Function &f);
+    // Free all cfg's
+    void clear();
+    // Max number of cfg's kept by evict (0: no limit)
+    void set_capacity(unsigned capacity) { m_capacity = capacity; }
+    // builder must build the same cfg as the one added for the
+    // function (same options and no later modification)
+    void set_builder(builder_t builder) { m_builder = builder; }
+    // Drop the least recently used cfg's above capacity. A cfg is
+    // freed once no owner obtained with get_ptr is left (e.g., the
+    // lazily stored invariants of its function). References returned
+    // by operator[] are not valid anymore so it should be called only
+    // when no cfg is in use (e.g., between the analysis of two
+    // functions).
+    void evict();
   };
   
   /**
@@ -149,6 +283,9 @@ namespace crab_llvm {
     typedef llvm::DenseMap<const llvm::BasicBlock*, lin_cst_sys_t> assumption_map_t;
     typedef crab::checker::checks_db checks_db_t;
     typedef boost::shared_ptr<HeapAbstraction> heap_abs_ptr;
+    // assumptions already converted to an abstract domain
+    struct domain_assumptions;
+    typedef std::shared_ptr<domain_assumptions> domain_assumptions_ptr;
     
   private:
 
@@ -157,6 +294,9 @@ namespace crab_llvm {
     variable_factory_t m_vfac;    
     invariant_map_t m_pre_map;
     invariant_map_t m_post_map;
+    // cache of invariants without shadow variables
+    mutable invariant_map_t m_pre_map_no_shadows;
+    mutable invariant_map_t m_post_map_no_shadows;
     checks_db_t m_checks_db;
     
   public:
@@ -188,6 +328,40 @@ namespace crab_llvm {
     void analyze(AnalysisParams &params, const llvm::BasicBlock *entry,
 		 const assumption_map_t &assumptions);
     
+    /**
+     * Re-analyze after strengthening the assumptions of the blocks in
+     * changed. assumptions must contain all the assumptions (old and
+     * new). The invariants of the previous call to analyze are
+     * refined instead of recomputed from scratch so only the blocks
+     * reachable from changed are visited. It runs a full analysis if
+     * there are no previous invariants for params.dom, checks are
+     * enabled or invariants are not stored eagerly.
+     **/
+    void reanalyze(AnalysisParams &params, const assumption_map_t &assumptions,
+		   const std::vector<const llvm::BasicBlock*> &changed);
+    
+    /**
+     * Convert assumptions to the abstract domain params.dom. The
+     * result can be passed to analyze many times without being
+     * rebuilt and extended with add_domain_assumption.
+     **/
+    domain_assumptions_ptr make_domain_assumptions(const AnalysisParams &params,
+						   const assumption_map_t &assumptions) const;
+
+    /**
+     * Conjoin csts to the assumption of b.
+     **/
+    void add_domain_assumption(domain_assumptions &assumptions,
+			       const llvm::BasicBlock &b, const lin_cst_sys_t &csts) const;
+    
+    /**
+     * Same as analyze but the assumptions are already converted to
+     * the abstract domain. If the analysis runs with another domain
+     * (e.g., --crab-relational-threshold) they are converted again.
+     **/
+    void analyze(AnalysisParams &params, const llvm::BasicBlock *entry,
+		 const domain_assumptions &assumptions);
+    
     /**
      * Compute strongest post-condition of an acyclic path.
      * Return false iff the path implies false.
@@ -212,6 +386,45 @@ namespace crab_llvm {
 		      bool layered_solving,
 		      std::vector<Statement>& core) const;
 
+    /**
+     * Same as path_analyze for many paths of the same function. The
+     * paths are analyzed in parallel by at most num_threads
+     * threads. res[i] is false iff paths[i] implies false and then
+     * cores[i] is a minimal subset of statements that implies false.
+     **/
+    template<typename Statement>
+    void path_analyze_batch(const AnalysisParams& params,
+			    const std::vector<std::vector<const llvm::BasicBlock*>>& paths,
+			    /* use gradually more expensive domains until unsat is proven*/
+			    bool layered_solving, unsigned num_threads,
+			    std::vector<bool>& res,
+			    std::vector<std::vector<Statement>>& cores) const;
+    
+    /**
+     * Incremental version of path_analyze for paths that share
+     * prefixes. Blocks are pushed and popped as in a stack and the
+     * post-condition of each prefix is kept so only the new blocks
+     * are analyzed.
+     **/
+    class path_checker {
+    public:
+      virtual ~path_checker() {}
+      // Extend the path with b. Return false iff the path implies false.
+      virtual bool push(const llvm::BasicBlock *b) = 0;
+      // Remove the last block of the path.
+      virtual void pop() = 0;
+      // Return false iff the path implies false.
+      virtual bool is_feasible() const = 0;
+      // Number of blocks of the path.
+      virtual unsigned size() const = 0;
+    };
+
+    /**
+     * Return a path checker that starts with the empty path and uses
+     * the domain in params.
+     **/
+    std::unique_ptr<path_checker> make_path_checker(const AnalysisParams& params) const;
+    
     /**
      * Return invariants that hold at the entry of b
      **/
@@ -247,6 +460,9 @@ namespace crab_llvm {
     variable_factory_t m_vfac;    
     invariant_map_t m_pre_map;
     invariant_map_t m_post_map;
+    // cache of invariants without shadow variables
+    mutable invariant_map_t m_pre_map_no_shadows;
+    mutable invariant_map_t m_post_map_no_shadows;
     checks_db_t m_checks_db;
     
   public:
@@ -292,20 +508,62 @@ namespace crab_llvm {
    * LLVM Module pass that computes invariants using Crab.
    **/
   class CrabLlvmPass : public llvm::ModulePass {
+   public:
+    
+    // result of get_range
+    typedef ikos::interval<number_t> interval_t;
 
+   private:
+    
     typedef typename IntraCrabLlvm::wrapper_dom_ptr wrapper_dom_ptr;
     typedef typename IntraCrabLlvm::invariant_map_t invariant_map_t;
     typedef typename IntraCrabLlvm::checks_db_t checks_db_t;
     typedef typename IntraCrabLlvm::heap_abs_ptr heap_abs_ptr;
+    typedef llvm::DenseMap<const llvm::Value*, interval_t> range_map_t;
     
     invariant_map_t m_pre_map;
     invariant_map_t m_post_map;
+    // cache of invariants without shadow variables
+    mutable invariant_map_t m_pre_map_no_shadows;
+    mutable invariant_map_t m_post_map_no_shadows;
+    // cache of the intervals of the values queried by get_range at
+    // the entry of each block and right after each instruction
+    llvm::DenseMap<const llvm::BasicBlock*, range_map_t> m_block_ranges;
+    llvm::DenseMap<const llvm::Instruction*, range_map_t> m_inst_ranges;
+    // get_pre, get_post and get_range can be called by several
+    // threads (e.g., --crab-add-invariants-threads)
+    mutable std::mutex m_cache_mutex;
     heap_abs_ptr m_mem;    
     variable_factory_t m_vfac;
     CfgManager m_cfg_man;
     checks_db_t m_checks_db; 
     AnalysisParams m_params;
     const llvm::TargetLibraryInfo *m_tli;
+    // do not free the results when the pass manager is done with the pass
+    bool m_keep_results;
+    // set by the client (see AnalysisParams)
+    const std::atomic<bool> *m_cancel;
+    std::function<void(const AnalysisProgress&)> m_progress;
+    // set by the client (see set_streaming_callback)
+    std::function<bool(llvm::Function&, llvm::CallGraph*)> m_stream;
+    // serialize the calls to m_progress
+    std::mutex m_progress_mutex;
+    // options of the analysis written in the reproducers
+    // (see set_command_line)
+    std::vector<std::string> m_command_line;
+    // created by runOnModule (see ModuleState)
+    std::unique_ptr<ModuleState> m_state;
+    
+    // Call m_progress (if any) after F has been analyzed
+    void report_progress(const std::string &F, unsigned done, unsigned total);
+
+    // Run the intra-procedural analysis of all functions in M using
+    // NumThreads workers
+    void runOnModuleParallel(llvm::Module &M, unsigned NumThreads);
+
+    // Load the heap abstraction from --crab-heap-snapshot. Return
+    // false if the snapshot cannot be used.
+    bool loadHeapSnapshot(llvm::Module &M);
     
    public:
 
@@ -313,6 +571,8 @@ namespace crab_llvm {
 
     CrabLlvmPass();
 
+    ~CrabLlvmPass();
+
     /* begin ModulePass API */    
     virtual void releaseMemory();
     
@@ -325,18 +585,57 @@ namespace crab_llvm {
     virtual const char* getPassName() const {return "CrabLlvm";}
     /* end ModulePass API */
 
+    // Keep the results alive after the pass manager releases the pass
+    // (e.g., to query them after running all the passes).
+    void set_keep_results(bool v) { m_keep_results = v; }
+
+    // The options of the analysis (argv without the program and the
+    // input file) so that the reproducers (--crab-extract-slow) can
+    // be replayed with the same options.
+    void set_command_line(const std::vector<std::string> &args) { m_command_line = args; }
+
+    // The analysis stops as soon as *cancel is set (e.g., by another
+    // thread when a deadline expires).
+    void set_cancel_token(const std::atomic<bool> *cancel) { m_cancel = cancel; }
+
+    // f is called after each function has been analyzed
+    void set_progress_callback(std::function<void(const AnalysisProgress&)> f) {
+      m_progress = f;
+    }
+
+    // If set then each function is handled completely before the
+    // next one: f is called right after the function is analyzed
+    // (e.g., to instrument it with its invariants) and then the
+    // invariants and the CFG of the function are released, so memory
+    // does not grow with the size of the module. f returns true if it
+    // modifies the function. Functions are analyzed sequentially
+    // and, with the inter-procedural analysis, f is called only after
+    // the whole module is analyzed.
+    void set_streaming_callback(std::function<bool(llvm::Function&, llvm::CallGraph*)> f) {
+      m_stream = f;
+    }
+
+    // Release the invariants and the CFG of F
+    void release_function(llvm::Function &F);
+    
     variable_factory_t& get_var_factory() { return m_vfac; }
 
     heap_abs_ptr get_heap_abstraction() { return m_mem; }
 
     const AnalysisParams& get_analysis_params() { return m_params;}
+
+    // Whether the invariants of different functions can be used by
+    // parallel threads: the domains of the analysis do not share a
+    // library manager and crab statistics are disabled.
+    bool can_run_in_parallel() const;
     
     bool has_cfg(llvm::Function &F);
     
     cfg_ref_t get_cfg(llvm::Function &F);
     
     /**
-     * return invariants that hold at the entry of BB
+     * return invariants that hold at the entry of BB. It can be
+     * called concurrently for different blocks.
      **/
     wrapper_dom_ptr get_pre(const llvm::BasicBlock *BB, bool KeepShadows=false) const;
 
@@ -344,6 +643,31 @@ namespace crab_llvm {
      * return invariants that hold at the exit of BB
      **/
     wrapper_dom_ptr get_post(const llvm::BasicBlock *BB, bool KeepShadows=false) const;
+
+    /**
+     * return the interval of V at the entry of BB (top if V has no
+     * crab variable or BB no invariants). The intervals are cached
+     * per block so a repeated query is a hash lookup. It can be
+     * called concurrently.
+     **/
+    interval_t get_range(const llvm::Value *V, const llvm::BasicBlock *BB);
+
+    /**
+     * return the interval of V right after I. The invariants at the
+     * entry of the block of I are propagated through the statements
+     * of I and of the instructions before it. The intervals of I and
+     * its operands are cached together the first time one of them
+     * is queried.
+     **/
+    interval_t get_range(const llvm::Value *V, const llvm::Instruction *I);
+
+    /**
+     * Analyze again F with params (e.g., with another domain) reusing
+     * the heap abstraction of the last run. The invariants of F are
+     * replaced and its checks are returned but not added to the
+     * totals.
+     **/
+    checks_db_t analyze_function(llvm::Function &F, const AnalysisParams &params);
     
     /**
      * To query and view the analysis results 
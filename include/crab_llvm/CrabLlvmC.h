@@ -0,0 +1,59 @@
+#ifndef __CRAB_LLVM_C_H_
+#define __CRAB_LLVM_C_H_
+
+/*
+ * C interface of the crab-llvm library (libCrabLlvmC) so that clients
+ * (e.g., py/crabllvm_lib.py through ctypes) can load a module once,
+ * analyze it and query its invariants and checks in the same
+ * process.
+ *
+ * The results are returned as JSON strings that must be released
+ * with crabllvm_free. Functions that fail return NULL (or 0) and
+ * crabllvm_last_error returns the reason.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct crabllvm_module *crabllvm_module_ref;
+
+/* Parse the options of crabllvm (e.g., "--crab-dom=zones") used by
+   all the analyses of the process. argv[0] is the program name. Only
+   the first call has effect. */
+int crabllvm_init(int argc, const char **argv);
+
+/* Load the bitcode (or assembly) in filename in its own context and
+   analyze it. The normalizations of crabllvm-pp are applied if the
+   module was not produced by crabllvm-pp. */
+crabllvm_module_ref crabllvm_load(const char *filename);
+
+void crabllvm_dispose(crabllvm_module_ref m);
+
+/* [{"name": F, "blocks": [B, ...]}, ...] */
+char *crabllvm_functions(crabllvm_module_ref m);
+
+/* {"bottom": bool, "constraints": [C, ...]} with the invariants at
+   the entry (post = 0) or exit (post != 0) of the block */
+char *crabllvm_invariant(crabllvm_module_ref m, const char *function,
+                         const char *block, int post);
+
+/* {"safe": N, "error": N, "warning": N} with the checks of the module */
+char *crabllvm_checks(crabllvm_module_ref m);
+
+/* Analyze again function with the domain (e.g., "zones") or with the
+   domain of crabllvm_init if domain is NULL. Its invariants are
+   replaced and its checks are returned as crabllvm_checks does. */
+char *crabllvm_analyze(crabllvm_module_ref m, const char *function,
+                       const char *domain);
+
+/* The error of the last call of the calling thread that failed */
+const char *crabllvm_last_error(void);
+
+void crabllvm_free(char *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
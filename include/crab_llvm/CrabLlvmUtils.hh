@@ -0,0 +1,154 @@
+#pragma once
+
+/*
+ * Types and helpers shared by CrabLlvmPass and the analysis
+ * subsystems (incremental analysis, function budgets, export, ...).
+ */
+
+#include "crab_llvm/CrabLlvm.hh"
+#include "llvm/IR/Function.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace crab_llvm {
+
+  /** Begin typedefs **/
+  typedef llvm::DenseMap<const llvm::BasicBlock*, lin_cst_sys_t> assumption_map_t;
+  typedef typename IntraCrabLlvm::wrapper_dom_ptr wrapper_dom_ptr;
+  typedef typename IntraCrabLlvm::checks_db_t checks_db_t;
+  typedef typename IntraCrabLlvm::invariant_map_t invariant_map_t;
+  typedef typename IntraCrabLlvm::heap_abs_ptr heap_abs_ptr;
+  /** End typedefs **/
+
+  inline bool isRelationalDomain(CrabDomain dom) {
+    return (dom == ZONES_SPLIT_DBM || dom == ZONES_SPLIT_DBM_FAST ||
+	    dom == ZONES_DENSE_DBM || dom == OCT || dom == PK || dom == TERMS_ZONES);
+  }
+
+  // relational domains whose cost depends on the number of related
+  // variables rather than on the number of variables
+  inline bool isSparseRelationalDomain(CrabDomain dom) {
+    return (dom == ZONES_SPLIT_DBM || dom == ZONES_SPLIT_DBM_FAST ||
+	    dom == TERMS_ZONES);
+  }
+
+  // domains that keep a term table (--crab-terms-max) and the
+  // domain each one reduces to if the table is dropped
+  inline bool isTermDomain(CrabDomain dom, CrabDomain &base) {
+    switch (dom) {
+    case TERMS_INTERVALS:     base = INTERVALS; return true;
+    case TERMS_DIS_INTERVALS: base = DIS_INTERVALS; return true;
+    case TERMS_ZONES:         base = ZONES_SPLIT_DBM; return true;
+    default:                  return false;
+    }
+  }
+
+  // domains that can be analyzed with --crab-sparse
+  inline bool isNonRelationalDomain(CrabDomain dom) {
+    return (dom == INTERVALS || dom == INTERVALS_CONGRUENCES ||
+	    dom == WRAPPED_INTERVALS || dom == DENSE_INTERVALS ||
+	    dom == WRAPPED_INTERVALS_FAST);
+  }
+
+  inline bool isTrackable(const llvm::Function &fun) {
+    return !fun.isDeclaration () && !fun.empty () && !fun.isVarArg ();
+  }
+
+  // The CFGs are always built with the call sites (even if the
+  // analysis is intra-procedural). The fingerprints of the functions
+  // (--crab-incremental and --crab-config-profile) must use the same
+  // flag.
+  static const bool cfg_has_callsites = true;
+
+  // --crab-dom=adapt-rtz measures the cost of each function in a
+  // child process as the function budgets do
+  bool hasFunctionBudget();
+
+  // Domains tried in order by --crab-check-layered
+  static const CrabDomain layered_domains[] = { INTERVALS, TERMS_ZONES, OCT, PK };
+
+  // OCT and PK are implemented by Apron or Elina and BOXES by
+  // LDDs. Crab keeps the library manager in a static member of the
+  // domain so it is shared by all the threads, and the manager is not
+  // thread-safe.
+  inline bool usesLibraryManager(CrabDomain dom) {
+    return dom == OCT || dom == PK || dom == BOXES;
+  }
+
+  template<typename Range>
+  inline bool anyUsesLibraryManager(const Range &doms) {
+    return std::any_of(std::begin(doms), std::end(doms),
+		       [](CrabDomain d) { return usesLibraryManager(d); });
+  }
+
+  // Domains used by the analysis of a function, including the ones
+  // of --crab-check-layered and --crab-portfolio
+  bool usesLibraryManager(const AnalysisParams &params);
+
+  // The analysis of a function can print things, update the
+  // statistics of crab (crab::CrabStats) or use a library manager which are
+  // not thread-safe. The statistics of crab-llvm are kept per thread
+  // (Support/Stats.hh).
+  bool canRunInParallel(const AnalysisParams &params);
+
+  // The debug location of I as in the assertions built by
+  // CfgBuilder.
+  crab::cfg::debug_info getDebugInfo(const llvm::Instruction &I);
+
+  /** convenient wrapper for the invariance analysis datastructures **/
+  struct InvarianceAnalysisResults {
+    // invariants that hold at the entry of a block
+    invariant_map_t &premap;
+    // invariants that hold at the exit of a block
+    invariant_map_t &postmap;
+    // database with all the checks
+    checks_db_t &checksdb;
+
+    InvarianceAnalysisResults(invariant_map_t &pre, invariant_map_t &post,
+			      checks_db_t &db)
+      : premap(pre), postmap(post), checksdb(db) {}
+  };
+
+  // Add the checks of src to dst by inserting the smaller database
+  // into the larger one. src must not be used afterwards.
+  inline void mergeChecks(checks_db_t &dst, checks_db_t &&src) {
+    auto size = [](const checks_db_t &db) {
+      return db.get_total_safe() + db.get_total_error() + db.get_total_warning();
+    };
+    if (size(dst) < size(src)) std::swap(dst, src);
+    dst += src;
+  }
+
+  /** update table with pre or post invariants **/
+  inline bool update(invariant_map_t &table,
+		     const llvm::BasicBlock &block, wrapper_dom_ptr absval) {
+    bool already = false;
+    auto it = table.find(&block);
+    if (it == table.end()) {
+      table.insert(std::make_pair(&block, absval));
+    } else {
+      it->second = absval;
+      already = true;
+    }
+    return already;
+  }
+
+  // Status of the numerical assertion a given the invariant inv that
+  // holds right before it (as crab's assertion checker).
+  template<typename Dom, typename Assert>
+  crab::checker::check_kind_t checkAssertion(Dom &inv, const Assert &a) {
+    if (inv.is_bottom()) {
+      return crab::checker::_SAFE;
+    }
+    Dom cst_inv = Dom::top();
+    cst_inv += a.constraint();
+    if (inv <= cst_inv) {
+      return crab::checker::_SAFE;
+    }
+    Dom tmp(inv);
+    tmp += a.constraint();
+    return tmp.is_bottom() ? crab::checker::_ERR : crab::checker::_WARN;
+  }
+
+} // end namespace crab_llvm
@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+ * Analysis of structurally identical functions
+ * (--crab-dedup-functions).
+ *
+ * Two functions are identical if their bodies are the same once
+ * their arguments, blocks and instructions are replaced by their
+ * positions. Only the first function of each group (its
+ * representative) is analyzed. The invariants of the other ones are
+ * the invariants of the representative over the corresponding
+ * values: as with --crab-incremental, the constraints over other
+ * variables are dropped. Their checks are the checks of the
+ * representative at the debug locations of the corresponding
+ * instructions.
+ *
+ * The shadow variables of a heap abstraction cannot be renamed so
+ * the pass does not merge functions if memory is tracked.
+ **/
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <boost/unordered_map.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class Value;
+}
+
+namespace crab_llvm {
+namespace dedup_impl {
+
+  typedef std::vector<const llvm::Value*> values_t;
+
+  class table {
+    struct result {
+      CrabDomain dom;
+      unsigned safe, err, warn;
+    };
+
+    boost::unordered_map<std::string, const llvm::Function*> m_reps;
+    boost::unordered_map<const llvm::Function*, result> m_results;
+    unsigned m_merged;
+    std::mutex m_mutex;
+
+    lin_cst_sys_t rename(const lin_cst_sys_t &csts,
+			 const boost::unordered_map<const llvm::Value*, const llvm::Value*> &corr,
+			 llvm_variable_factory &vfac) const;
+
+  public:
+
+    table();
+
+    // Return the function identical to F seen before, if any.
+    // Otherwise, F becomes the representative of its group.
+    const llvm::Function* getRepresentative(const llvm::Function &F);
+
+    // the representative rep was analyzed with dom
+    void setResults(const llvm::Function &rep, CrabDomain dom, const checks_db_t &checks);
+
+    // Add the results of F from those of its representative rep
+    // whose CFG is rep_cfg. Return false if rep was not analyzed
+    // (e.g., the analysis was cancelled).
+    bool copyResults(const llvm::Function &rep, cfg_ref_t rep_cfg, const llvm::Function &F,
+		     llvm_variable_factory &vfac, InvarianceAnalysisResults &results);
+
+    unsigned num_merged() const { return m_merged; }
+  };
+
+} // end namespace dedup_impl
+} // end namespace crab_llvm
@@ -13,6 +13,8 @@ struct DummyHeapAbstraction: public HeapAbstraction {
   using typename HeapAbstraction::region_t;
   using typename HeapAbstraction::region_set_t;
   
+  region_set_t m_empty;
+  
   DummyHeapAbstraction(): HeapAbstraction() { }
   
   const llvm::Value* getSingleton(int) const {
@@ -23,36 +25,36 @@ struct DummyHeapAbstraction: public HeapAbstraction {
     return region_t();
   }
   
-  region_set_t getAccessedRegions(const llvm::Function&) {
-    return region_set_t();
+  const region_set_t& getAccessedRegions(const llvm::Function&) {
+    return m_empty;
   }
   
-  region_set_t getOnlyReadRegions(const llvm::Function&) {
-    return region_set_t();
+  const region_set_t& getOnlyReadRegions(const llvm::Function&) {
+    return m_empty;
   }
   
-  region_set_t getModifiedRegions(const llvm::Function&) {
-    return region_set_t();
+  const region_set_t& getModifiedRegions(const llvm::Function&) {
+    return m_empty;
   }
   
-  region_set_t getNewRegions(const llvm::Function&) {
-    return region_set_t();
+  const region_set_t& getNewRegions(const llvm::Function&) {
+    return m_empty;
   }
   
-  region_set_t getAccessedRegions(llvm::CallInst&) {
-    return region_set_t();
+  const region_set_t& getAccessedRegions(llvm::CallInst&) {
+    return m_empty;
   }
   
-  region_set_t getOnlyReadRegions(llvm::CallInst&) {
-    return region_set_t();
+  const region_set_t& getOnlyReadRegions(llvm::CallInst&) {
+    return m_empty;
   }
   
-  region_set_t getModifiedRegions(llvm::CallInst&) {
-    return region_set_t();
+  const region_set_t& getModifiedRegions(llvm::CallInst&) {
+    return m_empty;
   }
   
-  region_set_t getNewRegions(llvm::CallInst&) {
-    return region_set_t();
+  const region_set_t& getNewRegions(llvm::CallInst&) {
+    return m_empty;
   }
   
   llvm::StringRef getName() const {
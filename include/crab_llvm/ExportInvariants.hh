@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ * Export of invariants and checks for other tools
+ * (--crab-export-invariants, --crab-checks-stream and
+ * --crab-export-invariants-db).
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+#include "llvm/ADT/StringRef.h"
+
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace llvm {
+  class Module;
+}
+
+namespace crab_llvm {
+namespace export_impl {
+
+  // Write str as a JSON string
+  void writeJsonString(std::ostream &o, llvm::StringRef str);
+
+  /*
+   * Write the invariants of each function as soon as the function
+   * is analyzed. The binary format is:
+   *
+   *   file     := "CRABINV" version:u8 function*
+   *   function := name:str num_blocks:u32 block*
+   *   block    := name:str pre:csts post:csts
+   *   csts     := num:u32 cst*
+   *   cst      := kind:u8 (0:=, 1:<=, 2:!=) constant:str num_terms:u32 (coeff:str var:str)*
+   *   str      := length:u32 bytes
+   *
+   * where integers are little-endian and a constraint means
+   * constant + sum coeff*var kind 0. Numbers are written in decimal
+   * since they can be arbitrarily large. The JSON format writes one
+   * object per line and function with the same information.
+   **/
+  class invariant_writer {
+    std::ofstream m_out;
+    bool m_json;
+    bool m_keep_shadows;
+    // functions can be written by several threads
+    std::mutex m_mutex;
+
+    void writeU32(uint32_t n);
+    void writeString(llvm::StringRef str);
+    std::vector<lin_cst_t> getConstraints(wrapper_dom_ptr absval);
+    void writeBinary(wrapper_dom_ptr absval);
+    void writeJson(wrapper_dom_ptr absval);
+
+  public:
+
+    invariant_writer(const std::string &file, bool json, bool keep_shadows);
+
+    bool good() const { return static_cast<bool>(m_out); }
+
+    void write(const llvm::Function &F, const invariant_map_t &premap,
+	       const invariant_map_t &postmap);
+  };
+
+  /*
+   * Write the checks of each function as soon as the function is
+   * analyzed. Each function is a JSON object in a separate line:
+   *
+   *   {"function":"foo","status":"error","safe":3,"error":1,"warning":0}
+   *
+   * where status is error if some check fails, warning if some
+   * check cannot be proven and safe otherwise.
+   **/
+  class checks_writer {
+    std::ofstream m_out;
+    // functions can be written by several threads
+    std::mutex m_mutex;
+
+  public:
+
+    checks_writer(const std::string &file): m_out(file) {}
+
+    bool good() const { return static_cast<bool>(m_out); }
+
+    void write(llvm::StringRef function, const checks_db_t &checks);
+  };
+
+  /*
+   * Write the invariants of all the blocks of M in file as a
+   * database that can be memory-mapped by clients
+   * (crab_llvm/InvariantDb.hh).
+   **/
+  bool writeInvariantDb(const std::string &file, llvm::Module &M,
+			const invariant_map_t &premap,
+			const invariant_map_t &postmap, bool keep_shadows);
+
+} // end namespace export_impl
+} // end namespace crab_llvm
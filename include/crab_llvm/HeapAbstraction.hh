@@ -52,6 +52,10 @@ namespace crab_llvm {
      friend class LlvmDsaHeapAbstraction;
      #endif 
      friend class SeaDsaHeapAbstraction;
+     friend class SnapshotHeapAbstraction;
+     friend class TypeHeapAbstraction;
+     friend class BudgetHeapAbstraction;
+     friend class MixedHeapAbstraction;
      
      Mem *m_mem;
      int m_id;
@@ -80,6 +84,16 @@ namespace crab_llvm {
          return m_mem->getSingleton(m_id);
      }
 
+     // Return a value if the region is a global singleton or a
+     // single-cell local object of F that does not escape.
+     const llvm::Value* getSingleton(const llvm::Function& F) const {
+       if (!m_mem)
+         return nullptr;
+       if (const llvm::Value* v = m_mem->getSingleton(m_id))
+         return v;
+       return m_mem->getLocalSingleton(F, m_id);
+     }
+
      region_type_t get_type() const { return m_info.get_type();}
 
      unsigned get_bitwidth() const { return m_info.get_bitwidth();}
@@ -114,9 +128,9 @@ namespace crab_llvm {
 
    template<typename Mem>
    inline llvm::raw_ostream& operator<<(llvm::raw_ostream &o,
-					std::set<Region<Mem> > s) {
+					const std::set<Region<Mem> >& s) {
      o << "{";
-     for (typename std::set<Region<Mem> >::iterator it=s.begin(),
+     for (typename std::set<Region<Mem> >::const_iterator it=s.begin(),
 	    et=s.end(); it!=et; ){
        o << *it;
        ++it;
@@ -130,12 +144,24 @@ namespace crab_llvm {
     
      template<typename Any>
      friend class Region;
+     // they forward the singleton queries to the abstractions they wrap
+     friend class BudgetHeapAbstraction;
+     friend class MixedHeapAbstraction;
+     // it stores the singletons of the abstraction it is written from
+     friend class SnapshotHeapAbstraction;
 
     protected:
 
      // return a value if the region corresponds to a single-cell
      // global memory cell, or nullptr otherwise.
      virtual const llvm::Value* getSingleton(int region) const = 0;
+
+     // return an alloca if the region corresponds to a single-cell
+     // stack object of F whose address does not escape (it is only
+     // used by loads and stores), or nullptr otherwise.
+     virtual const llvm::Value* getLocalSingleton(const llvm::Function&, int) const {
+       return nullptr;
+     }
      
     public:
 
@@ -151,29 +177,32 @@ namespace crab_llvm {
     // Function is used to know in which function the Value lives
      virtual region_t getRegion(const llvm::Function&, llvm::Value*) = 0;
 
+     // The region sets are computed once so they are returned by
+     // reference. They are valid while the heap abstraction is alive.
+
      // read and written regions by the function
-     virtual region_set_t getAccessedRegions(const llvm::Function& ) = 0;
+     virtual const region_set_t& getAccessedRegions(const llvm::Function& ) = 0;
 
      // only read regions by the function
-     virtual region_set_t getOnlyReadRegions(const llvm::Function& ) = 0;
+     virtual const region_set_t& getOnlyReadRegions(const llvm::Function& ) = 0;
 
      // written regions by the function     
-     virtual region_set_t getModifiedRegions(const llvm::Function& ) = 0;
+     virtual const region_set_t& getModifiedRegions(const llvm::Function& ) = 0;
 
      // regions that are reachable only from the return of the function     
-     virtual region_set_t getNewRegions(const llvm::Function& ) = 0;
+     virtual const region_set_t& getNewRegions(const llvm::Function& ) = 0;
 
     // read and written regions by the callee     
-     virtual region_set_t getAccessedRegions(llvm::CallInst& ) = 0;
+     virtual const region_set_t& getAccessedRegions(llvm::CallInst& ) = 0;
 
      // only read regions by the function     
-     virtual region_set_t getOnlyReadRegions(llvm::CallInst& ) = 0;
+     virtual const region_set_t& getOnlyReadRegions(llvm::CallInst& ) = 0;
 
      // written regions by the callee
-     virtual region_set_t getModifiedRegions(llvm::CallInst& ) = 0;
+     virtual const region_set_t& getModifiedRegions(llvm::CallInst& ) = 0;
 
      // regions that are reachable only from the return of the callee     
-     virtual region_set_t getNewRegions(llvm::CallInst& ) = 0;
+     virtual const region_set_t& getNewRegions(llvm::CallInst& ) = 0;
 
      virtual llvm::StringRef getName() const = 0;
    }; 
@@ -0,0 +1,89 @@
+#pragma once
+
+/**
+ * Persistent storage of the results of the intra-procedural
+ * analysis of a function (--crab-incremental).
+ *
+ * The name of the file is a hash of the function, the options used
+ * to translate it and the analysis options so a file is only
+ * reused if none of them changed. Invariants are stored as linear
+ * constraints over the names of the llvm values. Constraints over
+ * shadow variables are not stored.
+ *
+ * Besides the number of checks of each kind, the status of each
+ * numerical assertion is stored with the position of the first
+ * instruction with its debug location so that the location is
+ * restored when the file is loaded. Loading a file does not need
+ * the CFG of the function, so the pass only builds it if the file
+ * cannot be used.
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+#include "llvm/ADT/StringRef.h"
+
+#include <boost/optional.hpp>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+  class Value;
+}
+
+namespace crab_llvm {
+  class HeapAbstraction;
+
+namespace incremental_impl {
+
+  // the function, the options used to translate it and the analysis
+  // options.
+  std::string getKey(const llvm::Function &F, const AnalysisParams &params,
+		     HeapAbstraction &mem);
+
+  // dir/<md5 of key><ext>
+  std::string getHashedFileName(const std::string &dir, const std::string &key,
+				const std::string &ext);
+
+  std::string getFileName(const std::string &dir, const llvm::Function &F,
+			  const AnalysisParams &params, HeapAbstraction &mem);
+
+  // names are written as <length>:<name> since they can contain spaces
+  void writeName(std::ostream &o, llvm::StringRef name);
+
+  bool readName(std::istream &i, std::string &name);
+
+  // the crab variable of v (none if v is neither an integer nor a
+  // pointer)
+  boost::optional<var_t> mkVar(const llvm::Value &v, llvm_variable_factory &vfac);
+
+  // the abstract value of dom that satisfies csts
+  wrapper_dom_ptr mkWrapper(CrabDomain dom, const lin_cst_sys_t &csts);
+
+  // The numerical assertions of cfg with their debug location and
+  // their status given the invariants of premap (the assertions of
+  // the blocks without invariant are not returned).
+  std::vector<std::pair<crab::checker::check_kind_t, crab::cfg::debug_info>>
+  locateChecks(cfg_ref_t cfg, const invariant_map_t &premap);
+
+  /**
+   * Store the invariants of F and its checks in file. cfg is the
+   * CFG of F before it is sliced or its checks are discharged.
+   * Return false if file cannot be written.
+   **/
+  bool store(const std::string &file, const llvm::Function &F, cfg_ref_t cfg,
+	     const invariant_map_t &premap, const invariant_map_t &postmap,
+	     const checks_db_t &checks);
+
+  /**
+   * Load the invariants of F and its checks from file. Return false
+   * (and leave results untouched) if file does not exist or it
+   * cannot be read.
+   **/
+  bool load(const std::string &file, const llvm::Function &F,
+	    CrabDomain dom, llvm_variable_factory &vfac,
+	    InvarianceAnalysisResults &results);
+
+} // end namespace incremental_impl
+} // end namespace crab_llvm
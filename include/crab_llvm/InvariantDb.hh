@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Memory-mappable database of invariants (--crab-export-invariants-db).
+ *
+ * The file stores the linear constraints that hold at the entry (pre)
+ * and exit (post) of each block, indexed by function and block
+ * name. All names and numbers are interned in a string table and
+ * constraints are stored by columns, so a reader only maps the file
+ * and answers queries without copying or parsing anything. Many
+ * processes can share the same file.
+ *
+ * The reader depends neither on LLVM nor on Crab so clients can link
+ * only with this library.
+ */
+namespace crab_llvm {
+
+  // Non-owning reference to a string of an invariant database
+  struct idb_string_ref {
+    const char *data;
+    uint32_t size;
+
+    std::string str() const { return std::string(data, size); }
+  };
+
+  /* Build an invariant database and write it to a file */
+  class InvariantDbWriter {
+   public:
+
+    // constant + sum coeff*var kind 0 where kind is 0:=, 1:<= or 2:!=
+    struct constraint {
+      unsigned kind;
+      std::string constant;
+      // (coefficient, variable)
+      std::vector<std::pair<std::string, std::string>> terms;
+    };
+    typedef std::vector<constraint> constraints_t;
+
+   private:
+
+    typedef std::pair<constraints_t, constraints_t> pre_post_t;
+    // sorted by function and block names
+    std::map<std::string, std::map<std::string, pre_post_t>> m_functions;
+
+   public:
+
+    void add(const std::string &function, const std::string &block,
+	     const constraints_t &pre, const constraints_t &post);
+
+    // Return false if file cannot be written
+    bool write(const std::string &file) const;
+  };
+
+  /* Read-only access to an invariant database mapped in memory */
+  class InvariantDb {
+   public:
+
+    class constraints;
+
+    class constraint {
+      friend class constraints;
+      const InvariantDb *m_db;
+      uint32_t m_id;
+      constraint(const InvariantDb *db, uint32_t id): m_db(db), m_id(id) {}
+     public:
+      // 0:=, 1:<=, 2:!=
+      unsigned kind() const;
+      idb_string_ref constant() const;
+      unsigned num_terms() const;
+      idb_string_ref coefficient(unsigned i) const;
+      idb_string_ref variable(unsigned i) const;
+    };
+
+    class constraints {
+      friend class InvariantDb;
+      const InvariantDb *m_db;
+      uint32_t m_first;
+      uint32_t m_size;
+     public:
+      constraints(): m_db(nullptr), m_first(0), m_size(0) {}
+      unsigned size() const { return m_size; }
+      constraint operator[](unsigned i) const { return constraint(m_db, m_first + i); }
+    };
+
+   private:
+
+    const char *m_data;
+    std::size_t m_size;
+    // sections of the file
+    const uint32_t *m_functions;
+    const uint32_t *m_blocks;
+    const uint32_t *m_cst_kind;
+    const uint32_t *m_cst_constant;
+    const uint32_t *m_cst_first_term;
+    const uint32_t *m_cst_num_terms;
+    const uint32_t *m_term_coeff;
+    const uint32_t *m_term_var;
+    const uint32_t *m_string_offsets;
+    const char *m_string_pool;
+    uint32_t m_num_functions;
+    uint32_t m_num_strings;
+
+    InvariantDb(): m_data(nullptr), m_size(0) {}
+
+    idb_string_ref get_string(uint32_t id) const;
+
+    int compare(uint32_t id, const std::string &str) const;
+
+    // Return the index of the entry of block or -1 if not found
+    int64_t find_block(const std::string &function, const std::string &block) const;
+
+   public:
+
+    InvariantDb(const InvariantDb &o) = delete;
+
+    InvariantDb& operator=(const InvariantDb &o) = delete;
+
+    ~InvariantDb();
+
+    // Return null if file cannot be mapped or it is not a valid
+    // database. The reason is stored in error.
+    static std::unique_ptr<InvariantDb> open(const std::string &file, std::string &error);
+
+    unsigned num_functions() const { return m_num_functions; }
+
+    // Return false if there are no invariants for block
+    bool get_pre(const std::string &function, const std::string &block,
+		 constraints &csts) const;
+
+    bool get_post(const std::string &function, const std::string &block,
+		  constraints &csts) const;
+  };
+
+} // end namespace crab_llvm
@@ -0,0 +1,379 @@
+#pragma once
+
+/*
+ * Invariants that are not kept as abstract values after the analysis
+ * (--crab-invariants-storage, --crab-share-invariants and
+ * --crab-boxes-scoped). They are wrappers whose abstract value is
+ * built only when needed.
+ */
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/crab_domains.hh"
+#include "crab_llvm/wrapper_domain.hh"
+#include "crab_llvm/CrabLlvmUtils.hh"
+#include "crab_llvm/Support/Stats.hh"
+#include "crab/analysis/abs_transformer.hpp"
+
+#include <boost/shared_ptr.hpp>
+#include <cstdio>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crab_llvm {
+namespace lazy_impl {
+
+  /**
+   * A wrapper whose abstract value is built only when needed. Its
+   * id is the one of the wrapper it builds but it is not an
+   * instance of it, so it must be materialized before
+   * getAbsDomWrappee. It never leaves crab-llvm: get_pre and
+   * get_post materialize it.
+   *
+   * The built value is cached unless the wrapper is backed by a
+   * store that bounds the values kept in memory. It is never
+   * modified: the first write (forget or project) modifies a copy
+   * that replaces the cached value.
+   **/
+  class lazy_wrapper: public GenericAbsDomWrapper {
+    id_t m_id;
+    bool m_cache_enabled;
+    // the value is kept once it is modified
+    wrapper_dom_ptr m_val;
+    // the value built by materialize (null if not built yet or
+    // m_val is set)
+    mutable wrapper_dom_ptr m_cache;
+    // several threads can materialize the same invariant
+    mutable std::mutex m_mutex;
+
+    // return m_val, built the first time
+    wrapper_dom_ptr getValueForWrite();
+
+  protected:
+    // the result can be shared (e.g., by the cache of a store) so it
+    // is not modified
+    virtual wrapper_dom_ptr build() const = 0;
+
+  public:
+    lazy_wrapper(id_t id, bool cache_enabled = true)
+      : GenericAbsDomWrapper(), m_id(id), m_cache_enabled(cache_enabled) {}
+
+    // return a wrapper that owns its abstract value
+    wrapper_dom_ptr materialize() const;
+
+    id_t getId() const { return m_id;}
+
+    wrapper_dom_ptr clone() const;
+    lin_cst_sys_t to_linear_constraints();
+    lin_cst_sys_t to_linear_constraints(const std::vector<var_t>& vars) const;
+    void for_each_constraint(const constraint_fn_t &f) const;
+    void accept(GenericAbsDomVisitor &v) const;
+    unsigned num_finite_bounds(const std::vector<var_t>& vars);
+    void write(crab::crab_os& o);
+    void forget(const std::vector<var_t>& vars);
+    void project(const std::vector<var_t>& vars);
+    std::size_t fingerprint() const;
+    bool shares_value(const GenericAbsDomWrapper &o) const;
+    bool equals(const GenericAbsDomWrapper &o) const;
+  };
+
+  // return a wrapper that is not lazy
+  wrapper_dom_ptr materialize(wrapper_dom_ptr absval);
+
+  /** Pre or post of a block extracted from the analyzer **/
+  template<typename Analyzer>
+  class analyzer_wrapper: public lazy_wrapper {
+    // the analyzer refers to the cfg
+    cfg_ptr_t m_cfg;
+    boost::shared_ptr<Analyzer> m_analyzer;
+    basic_block_label_t m_bl;
+    bool m_is_pre;
+
+    wrapper_dom_ptr build() const {
+      return (m_is_pre ?
+	      mkGenericAbsDomWrapper(m_analyzer->get_pre(m_bl)) :
+	      mkGenericAbsDomWrapper(m_analyzer->get_post(m_bl)));
+    }
+
+  public:
+    analyzer_wrapper(id_t id, cfg_ptr_t cfg, boost::shared_ptr<Analyzer> analyzer,
+		     basic_block_label_t bl, bool is_pre)
+      : lazy_wrapper(id), m_cfg(cfg), m_analyzer(analyzer), m_bl(bl), m_is_pre(is_pre) {}
+  };
+
+  /** Post of a block recomputed from its pre **/
+  template<typename Dom>
+  class post_wrapper: public lazy_wrapper {
+    typedef crab::analyzer::intra_abs_transformer<Dom> abs_tr_t;
+
+    wrapper_dom_ptr m_pre;
+    cfg_ptr_t m_cfg;
+    basic_block_label_t m_bl;
+
+    wrapper_dom_ptr build() const {
+      Dom inv;
+      // the pre can be lazy too (e.g., delta_wrapper)
+      getAbsDomWrappee(lazy_impl::materialize(m_pre), inv);
+      abs_tr_t vis(&inv);
+      for (auto &s: m_cfg->get_node(m_bl)) {
+	s.accept(&vis);
+      }
+      return mkGenericAbsDomWrapper(inv);
+    }
+
+  public:
+    post_wrapper(wrapper_dom_ptr pre, cfg_ptr_t cfg, basic_block_label_t bl)
+      : lazy_wrapper(pre->getId()), m_pre(pre), m_cfg(cfg), m_bl(bl) {}
+  };
+
+  /**
+   * Wrappers of equal abstract values share the same value
+   * (--crab-share-invariants). Candidates are found by fingerprint
+   * and confirmed with the abstract order.
+   **/
+  template<typename Dom>
+  class hash_cons_table {
+    std::unordered_map<std::size_t, std::vector<wrapper_dom_ptr>> m_table;
+
+  public:
+    wrapper_dom_ptr get(Dom absval) {
+      wrapper_dom_ptr res = mkGenericAbsDomWrapper(absval);
+      std::vector<wrapper_dom_ptr> &bucket = m_table[res->fingerprint()];
+      for (auto &w: bucket) {
+	Dom other;
+	getAbsDomWrappee(w, other);
+	if (other <= absval && absval <= other) {
+	  // a new wrapper so each block can modify its own copy
+	  return w->clone();
+	}
+      }
+      bucket.push_back(res);
+      return res;
+    }
+  };
+
+  /**
+   * Invariants spilled to a temporary file
+   * (--crab-invariants-storage=spill). Each invariant is written
+   * once as a linear constraint system and only the most recently
+   * used ones are kept in memory. Variables are interned in memory
+   * since they cannot be rebuilt from their names.
+   *
+   * The space of a released record is reused by the next records
+   * that fit in it and the file is truncated once all records are
+   * released (e.g., after each function when streaming).
+   **/
+  class spill_store {
+    struct record {
+      long offset;
+      std::size_t size;
+      // bytes of the file reserved for the record (at least size)
+      std::size_t reserved;
+    };
+    std::mutex m_mutex;
+    std::FILE *m_file;
+    const unsigned m_capacity;
+    std::vector<record> m_records;
+    // released records whose space can be reused
+    std::vector<unsigned> m_free;
+    unsigned m_num_live;
+    std::vector<var_t> m_vars;
+    std::map<var_t, unsigned> m_var_ids;
+    // most recently used first
+    typedef std::list<std::pair<unsigned, wrapper_dom_ptr>> lru_t;
+    lru_t m_lru;
+    std::unordered_map<unsigned, lru_t::iterator> m_cached;
+
+    unsigned getVarId(const var_t &v);
+
+    // as --crab-export-invariants but variables are stored by id
+    lin_cst_sys_t read(unsigned id);
+
+    void evictLeastRecentlyUsed();
+
+    // forget all records and truncate the file
+    void clear();
+
+  public:
+
+    // at most capacity invariants are kept in memory
+    explicit spill_store(unsigned capacity);
+
+    ~spill_store();
+
+    // write csts to the file and return its record
+    unsigned spill(const lin_cst_sys_t &csts);
+
+    // return the invariant of record id. If it is not in memory then
+    // it is built from its constraints by rebuild.
+    template<typename F>
+    wrapper_dom_ptr get(unsigned id, F rebuild) {
+      lin_cst_sys_t csts;
+      {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_cached.find(id);
+	if (it != m_cached.end()) {
+	  m_lru.splice(m_lru.begin(), m_lru, it->second);
+	  return it->second->second;
+	}
+	csts = read(id);
+      }
+      wrapper_dom_ptr res = rebuild(csts);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_capacity > 0 && m_cached.find(id) == m_cached.end()) {
+	m_lru.push_front(std::make_pair(id, res));
+	m_cached.insert(std::make_pair(id, m_lru.begin()));
+	evictLeastRecentlyUsed();
+      }
+      return res;
+    }
+
+    // the record is not needed anymore
+    void release(unsigned id);
+  };
+
+  /** Invariant of a block reloaded from the spill store **/
+  template<typename Dom>
+  class spilled_wrapper: public lazy_wrapper {
+    boost::shared_ptr<spill_store> m_store;
+    unsigned m_record;
+
+    wrapper_dom_ptr build() const {
+      return m_store->get(m_record, [](const lin_cst_sys_t &csts) {
+	  Dom inv = Dom::top();
+	  inv += csts;
+	  return mkGenericAbsDomWrapper(inv);
+	});
+    }
+
+  public:
+    spilled_wrapper(id_t id, boost::shared_ptr<spill_store> store, const Dom &inv)
+      : lazy_wrapper(id, false), m_store(store),
+	m_record(store->spill(inv.to_linear_constraint_system())) {}
+
+    ~spilled_wrapper() { m_store->release(m_record); }
+  };
+
+  /**
+   * Invariant of a block kept as linear constraints and rebuilt
+   * on demand (--crab-boxes-scoped). The boxes domain allocates its
+   * decision diagrams in a manager that lives as long as the
+   * process so the diagrams of a function are released only if no
+   * stored invariant refers to them.
+   **/
+  template<typename Dom>
+  class csts_wrapper: public lazy_wrapper {
+    lin_cst_sys_t m_csts;
+
+    wrapper_dom_ptr build() const {
+      Dom inv = Dom::top();
+      inv += m_csts;
+      return mkGenericAbsDomWrapper(inv);
+    }
+
+  public:
+    // not cached so the diagrams are released once they are used
+    csts_wrapper(id_t id, const Dom &inv)
+      : lazy_wrapper(id, false), m_csts(inv.to_linear_constraint_system()) {}
+  };
+
+  // Domains whose abstract values are decision diagrams
+  template<typename Dom>
+  struct is_ldd_domain { static const bool value = false; };
+  template<>
+  struct is_ldd_domain<boxes_domain_t> { static const bool value = true; };
+
+  /**
+   * Invariants of the blocks of a function stored as differences
+   * (--crab-invariants-storage=delta). An invariant is a set of
+   * linear constraints stored as the constraints added to and
+   * removed from the invariant of its parent (the immediate
+   * dominator of its block). Constraints are interned so each
+   * one is kept once per function. The constraints and the values
+   * of the most recently used invariants are cached.
+   **/
+  class delta_store {
+    struct record {
+      // -1 if none
+      int parent;
+      std::vector<unsigned> added;
+      std::vector<unsigned> removed;
+    };
+    struct cached_record {
+      unsigned id;
+      std::vector<unsigned> csts;
+      // built on demand
+      wrapper_dom_ptr val;
+    };
+    static const unsigned cache_size = 64;
+
+    std::mutex m_mutex;
+    std::vector<lin_cst_t> m_csts;
+    std::unordered_map<std::string, unsigned> m_cst_ids;
+    std::map<var_t, unsigned> m_var_ids;
+    std::vector<record> m_records;
+    // most recently used first
+    typedef std::list<cached_record> lru_t;
+    lru_t m_lru;
+    std::unordered_map<unsigned, lru_t::iterator> m_cached;
+
+    unsigned getCstId(const lin_cst_t &cst);
+
+    void cache(unsigned id, const std::vector<unsigned> &csts);
+
+    // sorted constraints of record id. The records from the closest
+    // cached ancestor are applied in order.
+    std::vector<unsigned> getCsts(unsigned id);
+
+  public:
+
+    // add csts as a child of parent (-1 if none) and return its record
+    unsigned add(int parent, const lin_cst_sys_t &csts);
+
+    // return the invariant of record id built from its constraints
+    // by rebuild if it is not cached
+    template<typename F>
+    wrapper_dom_ptr get(unsigned id, F rebuild) {
+      lin_cst_sys_t csts;
+      {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_cached.find(id);
+	if (it != m_cached.end() && it->second->val) {
+	  m_lru.splice(m_lru.begin(), m_lru, it->second);
+	  return it->second->val;
+	}
+	for (unsigned i: getCsts(id)) csts += m_csts[i];
+      }
+      count_stat("CrabLlvm.count.rebuilt_invariants");
+      wrapper_dom_ptr res = rebuild(csts);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_cached.find(id);
+      if (it != m_cached.end()) it->second->val = res;
+      return res;
+    }
+  };
+
+  /** Invariant of a block rebuilt from the delta store **/
+  template<typename Dom>
+  class delta_wrapper: public lazy_wrapper {
+    boost::shared_ptr<delta_store> m_store;
+    unsigned m_record;
+
+    wrapper_dom_ptr build() const {
+      return m_store->get(m_record, [](const lin_cst_sys_t &csts) {
+	  Dom inv = Dom::top();
+	  inv += csts;
+	  return mkGenericAbsDomWrapper(inv);
+	});
+    }
+
+  public:
+    delta_wrapper(id_t id, boost::shared_ptr<delta_store> store, unsigned record)
+      : lazy_wrapper(id, false), m_store(store), m_record(record) {}
+  };
+
+} // end namespace lazy_impl
+} // end namespace crab_llvm
@@ -7,6 +7,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "crab_llvm/HeapAbstraction.hh"
 #include <boost/unordered_map.hpp>
+#include <mutex>
 
 #include "dsa/DSNode.h" // not enough forward declaration
 
@@ -42,14 +43,21 @@ namespace crab_llvm {
     bool m_disambiguate_unknown;
     bool m_disambiguate_ptr_cast;
     bool m_disambiguate_external;
+    // Queries can assign new ids so they are serialized to allow
+    // building CFGs from several threads.
+    mutable std::mutex m_mutex;
     
     llvm::DenseMap<const llvm::Function*, region_set_t> m_func_accessed;
     llvm::DenseMap<const llvm::Function*, region_set_t> m_func_mods;
     llvm::DenseMap<const llvm::Function*, region_set_t> m_func_news;
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_onlyreads;
 
     llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_accessed;
     llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_mods;
     llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_news;
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_onlyreads;
+    // returned for functions and callsites without regions
+    region_set_t m_empty_set;
 
     int getId(const llvm::DSNode* n, unsigned offset);
             
@@ -73,22 +81,25 @@ namespace crab_llvm {
     virtual region_t getRegion(const llvm::Function &F, llvm::Value *V) override;
     
     virtual const llvm::Value* getSingleton(int region) const override;
+
+    virtual const llvm::Value* getLocalSingleton(const llvm::Function &F,
+						 int region) const override;
     
-    virtual region_set_t getAccessedRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getAccessedRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getOnlyReadRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getOnlyReadRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getModifiedRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getModifiedRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getNewRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getNewRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getAccessedRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getAccessedRegions(llvm::CallInst &I) override;
     
-    virtual region_set_t getOnlyReadRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getOnlyReadRegions(llvm::CallInst &I) override;
     
-    virtual region_set_t getModifiedRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getModifiedRegions(llvm::CallInst &I) override;
     
-    virtual region_set_t getNewRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getNewRegions(llvm::CallInst &I) override;
     
     virtual llvm::StringRef getName() const override {
       return "LlvmDsaHeapAbstraction";
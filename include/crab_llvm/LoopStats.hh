@@ -0,0 +1,29 @@
+#pragma once
+
+/** 
+ * Statistics of the invariants of each loop (--crab-stats). Crab
+ * iterates over the weak topological order of the CFG, whose
+ * components are the loops of the function, so they point to the
+ * loops where the analysis is expensive or imprecise.
+ **/
+
+#include "llvm/ADT/DenseMap.h"
+
+namespace llvm {
+  class BasicBlock;
+  class Function;
+}
+
+namespace crab_llvm {
+namespace loop_stats_impl {
+
+  typedef llvm::DenseMap<const llvm::BasicBlock*, unsigned> block_size_map_t;
+
+  // Print one line per loop of F with the number of constraints of
+  // the invariants at its header and the maximum over its blocks
+  // (sizes). The lines of F are written at once since functions can
+  // be analyzed in parallel.
+  void print(const llvm::Function &F, const block_size_map_t &sizes);
+
+} // end namespace loop_stats_impl
+} // end namespace crab_llvm
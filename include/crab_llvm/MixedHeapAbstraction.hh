@@ -0,0 +1,96 @@
+#pragma once
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/HeapAbstraction.hh"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace llvm {
+  class Module;
+  class Function;
+  class Value;
+  class CallInst;
+}
+
+namespace crab_llvm {
+
+  /*
+   * Heap abstraction that answers the queries of most functions with
+   * one heap abstraction (e.g., context-sensitive sea-dsa) and those
+   * of some functions with another one (e.g., context-insensitive
+   * sea-dsa). All the queries about a function, including those about
+   * its callsites, are answered by the same abstraction, so the regions
+   * of a function are consistent. The regions of the callsites of a
+   * caller and those of its callee may come from different
+   * abstractions, so it must not be used by the inter-procedural
+   * analysis. The region i of the first abstraction is 2*i and the
+   * one of the second is 2*i+1.
+   */
+  class MixedHeapAbstraction: public HeapAbstraction {
+
+   public:
+
+     using typename HeapAbstraction::region_t;
+     using typename HeapAbstraction::region_set_t;
+
+   private:
+
+    boost::shared_ptr<HeapAbstraction> m_main;
+    boost::shared_ptr<HeapAbstraction> m_fallback;
+    // functions whose queries are answered by m_fallback
+    llvm::DenseSet<const llvm::Function*> m_fallback_funcs;
+
+    enum set_kind_t { ACCESSED = 0, ONLY_READ = 1, MODIFIED = 2, NEW = 3, NUM_SET_KINDS = 4};
+
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_sets[NUM_SET_KINDS];
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_sets[NUM_SET_KINDS];
+    region_set_t m_empty_set;
+
+    region_t map(const region_t &r, bool fallback);
+    region_set_t map(const region_set_t &s, bool fallback);
+
+    const region_set_t& lookup(const llvm::Function &F, set_kind_t k) const;
+    const region_set_t& lookup(const llvm::CallInst &I, set_kind_t k) const;
+
+   public:
+
+    MixedHeapAbstraction(llvm::Module &M,
+			 boost::shared_ptr<HeapAbstraction> main,
+			 boost::shared_ptr<HeapAbstraction> fallback,
+			 const llvm::DenseSet<const llvm::Function*> &fallback_funcs);
+
+    // number of functions answered by the fallback abstraction
+    unsigned numFallbackFunctions() const { return m_fallback_funcs.size(); }
+
+    virtual region_t getRegion(const llvm::Function &F, llvm::Value *V) override;
+
+    virtual const llvm::Value* getSingleton(int region) const override;
+
+    virtual const llvm::Value* getLocalSingleton(const llvm::Function &F,
+						 int region) const override;
+
+    virtual const region_set_t& getAccessedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getOnlyReadRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getModifiedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getNewRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getAccessedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getOnlyReadRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getModifiedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getNewRegions(llvm::CallInst &I) override;
+
+    virtual llvm::StringRef getName() const override {
+      return "MixedHeapAbstraction";
+    }
+  };
+
+} // end namespace crab_llvm
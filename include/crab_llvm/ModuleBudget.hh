@@ -0,0 +1,70 @@
+#pragma once
+
+/**
+ * Split of the time of --crab-module-budget among the functions
+ * that are not analyzed yet. The cost of a function is its time in
+ * --crab-config-profile if any, otherwise its number of instructions
+ * times the time per instruction observed so far in this run. If
+ * the pending functions are expected to exceed the remaining time
+ * then the functions expected to take more than an even share of it
+ * give up the backward analysis and then relational domains. The
+ * remaining time is read from the clock before each function so the
+ * time left by the functions that finish early goes to the next
+ * ones.
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <boost/unordered_map.hpp>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace llvm {
+  class Module;
+}
+
+namespace crab_llvm {
+  struct ModuleState;
+
+namespace budget_impl {
+
+  class scheduler {
+    typedef std::chrono::steady_clock clock_t;
+    clock_t::time_point m_deadline;
+    unsigned m_threads;
+    boost::unordered_map<const llvm::Function*, unsigned> m_sizes;
+    boost::unordered_map<const llvm::Function*, double> m_history_ms;
+    // pending functions: number, total recorded time and total size
+    // of those without recorded time
+    unsigned m_pending;
+    double m_pending_history_ms;
+    double m_pending_size;
+    // observed by the functions without recorded time
+    double m_analyzed_ms;
+    double m_analyzed_size;
+    unsigned m_downgraded;
+    std::mutex m_mutex;
+
+    double ms_per_inst() const;
+
+    double estimate(const llvm::Function &F) const;
+
+  public:
+
+    // Only the functions of M analyzed by the pass share the budget
+    scheduler(llvm::Module &M, const ModuleState &state, unsigned seconds,
+	      unsigned threads);
+
+    // Make params cheaper if F is not expected to fit in its share
+    void apply(const llvm::Function &F, AnalysisParams &params);
+
+    void done(const llvm::Function &F, unsigned ms);
+
+    unsigned num_downgraded() const { return m_downgraded; }
+
+    bool exceeded() const { return clock_t::now() > m_deadline; }
+  };
+
+} // end namespace budget_impl
+} // end namespace crab_llvm
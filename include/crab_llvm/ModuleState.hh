@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * State of CrabLlvmPass shared by the analysis of all the functions
+ * of a module. The pass creates a fresh one each time it runs so
+ * nothing is carried from one module to the next one (batch mode or
+ * the C API) and two passes never share it.
+ **/
+
+#include "crab_llvm/AllocAccountant.hh"
+#include "crab_llvm/CheckOnly.hh"
+#include "crab_llvm/ConfigProfile.hh"
+#include "crab_llvm/DedupFunctions.hh"
+#include "crab_llvm/ExportInvariants.hh"
+#include "crab_llvm/ModuleBudget.hh"
+#include "crab_llvm/PhaseProfile.hh"
+#include "crab_llvm/Reproducers.hh"
+#include "crab_llvm/Roots.hh"
+
+#include <boost/shared_ptr.hpp>
+#include <memory>
+
+namespace llvm {
+  class Function;
+}
+
+namespace crab_llvm {
+  namespace lazy_impl {
+    class spill_store;
+  }
+
+  struct ModuleState {
+    // --crab-roots
+    roots_impl::reachable_set roots;
+    // --crab-check-only
+    check_only_impl::target_set check_only;
+    // Non-null if --crab-export-invariants
+    std::unique_ptr<export_impl::invariant_writer> invariant_exporter;
+    // Non-null if --crab-checks-stream
+    std::unique_ptr<export_impl::checks_writer> checks_streamer;
+    // Non-null if --crab-config-profile
+    std::unique_ptr<config_profile_impl::profile> config_profile;
+    // Non-null if --crab-module-budget
+    std::unique_ptr<budget_impl::scheduler> budget;
+    // Non-null if --crab-dedup-functions
+    std::unique_ptr<dedup_impl::table> dedup;
+    // Non-null if --crab-profile
+    std::unique_ptr<profile_impl::profiler> profile;
+    // Non-null if --crab-extract-slow
+    std::unique_ptr<repro_impl::recorder> reproducers;
+    // Non-null if --crab-alloc-stats and operator new is hooked
+    std::unique_ptr<alloc_stats_impl::accountant> alloc_stats;
+    // Non-null if --crab-invariants-storage=spill. The invariants
+    // spilled to it keep it alive after the pass releases it.
+    boost::shared_ptr<lazy_impl::spill_store> spill_store;
+
+    // Functions analyzed by the pass: the ones reachable from
+    // --crab-roots that are relevant for --crab-check-only
+    bool is_analyzed(const llvm::Function &F) const {
+      return roots.isReachable(F) && check_only.isRelevant(F);
+    }
+  };
+
+} // end namespace crab_llvm
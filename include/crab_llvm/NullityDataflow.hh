@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ * Nullity of the pointer variables of a crab CFG for
+ * --crab-check=null with --crab-check-null-fast.
+ *
+ * Each pointer variable is either null, non-null or unknown (a
+ * bit for each possibility so join and meet are bitwise). Blocks
+ * are numbered in reverse post-order and the lattice has height
+ * two so the worklist terminates without widening. Only the
+ * pointer statements are interpreted: the others forget the
+ * pointers they define. The checks of ptr_load and ptr_store are
+ * the same as crab's null_property_checker.
+ **/
+
+#include "crab_llvm/crab_cfg.hh"
+#include "crab/checkers/base_property.hpp"
+
+#include <boost/range/iterator_range.hpp>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace crab_llvm {
+namespace nullity_impl {
+
+  enum : uint8_t { BOT = 0, IS_NULL = 1, NON_NULL = 2, TOP = 3 };
+
+  template<typename CFG>
+  class null_dataflow {
+    typedef typename CFG::basic_block_label_t label_t;
+    typedef typename CFG::statement_t stmt_t;
+    typedef typename CFG::variable_t variable_t;
+    typedef number_t N;
+    typedef varname_t V;
+    // -- the values of the pointer variables followed by an extra
+    //    element so that it is only empty if unreachable.
+    typedef std::vector<uint8_t> state_t;
+
+    CFG m_cfg;
+    std::vector<label_t> m_blocks;
+    std::map<label_t, unsigned> m_block_ids;
+    std::map<variable_t, unsigned> m_var_ids;
+    std::vector<state_t> m_pre;
+
+    class transfer: public crab::cfg::statement_visitor<N,V> {
+      null_dataflow &m_df;
+      state_t &m_s;
+      crab::checker::checks_db *m_checks;
+      unsigned m_verbose;
+
+      uint8_t &val(const variable_t &v) { return m_s[m_df.m_var_ids[v]]; }
+
+      void meet(const variable_t &v, uint8_t x) {
+	if ((val(v) &= x) == BOT) m_s.clear();
+      }
+
+      void check(const stmt_t &s, const variable_t &ptr) {
+	if (!m_checks) return;
+	crab::checker::check_kind_t k = crab::checker::_WARN;
+	if (m_s.empty() || val(ptr) == NON_NULL) {
+	  k = crab::checker::_SAFE;
+	} else if (val(ptr) == IS_NULL) {
+	  k = crab::checker::_ERR;
+	}
+	if (m_verbose >= 2 && k != crab::checker::_SAFE) {
+	  crab::outs() << (k == crab::checker::_ERR ? "Error: null dereference "
+						    : "Warning: possible null dereference ")
+		       << s << "\n";
+	}
+	m_checks->add(k, s.get_debug_info());
+      }
+
+      void assume(const ptr_cst_t &cst) {
+	if (cst.is_tautology()) return;
+	if (cst.is_contradiction()) {
+	  m_s.clear();
+	} else if (cst.is_unary()) {
+	  meet(cst.lhs(), cst.is_equality() ? IS_NULL : NON_NULL);
+	} else if (cst.is_equality()) {
+	  uint8_t x = val(cst.lhs()) & val(cst.rhs());
+	  meet(cst.lhs(), x);
+	  if (!m_s.empty()) meet(cst.rhs(), x);
+	} else if (val(cst.lhs()) == IS_NULL) {
+	  meet(cst.rhs(), NON_NULL);
+	} else if (val(cst.rhs()) == IS_NULL) {
+	  meet(cst.lhs(), NON_NULL);
+	}
+      }
+
+     public:
+      bool handled;
+
+      transfer(null_dataflow &df, state_t &s, crab::checker::checks_db *checks,
+	       unsigned verbose)
+	: m_df(df), m_s(s), m_checks(checks), m_verbose(verbose), handled(false) {}
+
+      void visit(crab::cfg::ptr_null_stmt<N,V> &s) {
+	handled = true;
+	val(s.lhs()) = IS_NULL;
+      }
+      void visit(crab::cfg::ptr_assign_stmt<N,V> &s) {
+	handled = true;
+	val(s.lhs()) = val(s.rhs());
+      }
+      void visit(crab::cfg::ptr_object_stmt<N,V> &s) {
+	handled = true;
+	val(s.lhs()) = NON_NULL;
+      }
+      void visit(crab::cfg::ptr_function_stmt<N,V> &s) {
+	handled = true;
+	val(s.lhs()) = NON_NULL;
+      }
+      void visit(crab::cfg::ptr_load_stmt<N,V> &s) {
+	handled = true;
+	check(s, s.rhs());
+	if (!m_s.empty() && s.lhs().get_type() == crab::PTR_TYPE) val(s.lhs()) = TOP;
+      }
+      void visit(crab::cfg::ptr_store_stmt<N,V> &s) {
+	handled = true;
+	check(s, s.lhs());
+      }
+      void visit(crab::cfg::ptr_assume_stmt<N,V> &s) {
+	handled = true;
+	assume(s.constraint());
+      }
+      void visit(crab::cfg::ptr_assert_stmt<N,V> &s) {
+	handled = true;
+	assume(s.constraint());
+      }
+      void visit(crab::cfg::unreachable_stmt<N,V> &) {
+	handled = true;
+	m_s.clear();
+      }
+    };
+
+    // Apply the statements of the block i to s. The checks are
+    // added to checks (if not null).
+    void apply(unsigned i, state_t &s, crab::checker::checks_db *checks,
+	       unsigned verbose) {
+      for (auto &st: m_cfg.get_node(m_blocks[i])) {
+	if (s.empty() && !checks) return;
+	transfer vis(*this, s, checks, verbose);
+	if (!s.empty() || st.is_ptr_read() || st.is_ptr_write()) st.accept(&vis);
+	if (vis.handled || s.empty()) continue;
+	const typename stmt_t::live_t &ls = st.get_live();
+	for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	  if (v.get_type() == crab::PTR_TYPE) s[m_var_ids[v]] = TOP;
+	}
+      }
+    }
+
+    static void join(state_t &dst, const state_t &src) {
+      if (src.empty()) return;
+      if (dst.empty()) {
+	dst = src;
+	return;
+      }
+      for (unsigned k = 0, n = dst.size(); k < n; ++k) dst[k] |= src[k];
+    }
+
+   public:
+
+    explicit null_dataflow(CFG cfg): m_cfg(cfg) {
+      // -- number blocks in reverse post-order from the entry.
+      //    Unreachable blocks go last.
+      std::vector<std::pair<label_t, std::vector<label_t>>> stack;
+      auto push = [&](const label_t &bl) {
+	m_block_ids.insert(std::make_pair(bl, UINT_MAX));
+	std::vector<label_t> succs;
+	for (auto s: cfg.next_nodes(bl)) succs.push_back(s);
+	stack.push_back(std::make_pair(bl, std::move(succs)));
+      };
+      push(cfg.entry());
+      while (!stack.empty()) {
+	std::vector<label_t> &succs = stack.back().second;
+	if (succs.empty()) {
+	  m_blocks.push_back(stack.back().first);
+	  stack.pop_back();
+	  continue;
+	}
+	label_t s = succs.back();
+	succs.pop_back();
+	if (m_block_ids.count(s) == 0) push(s);
+      }
+      std::reverse(m_blocks.begin(), m_blocks.end());
+      for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+	if (m_block_ids.insert(std::make_pair(bl, UINT_MAX)).second) m_blocks.push_back(bl);
+      }
+      unsigned num_blocks = m_blocks.size();
+      for (unsigned i = 0; i < num_blocks; ++i) m_block_ids[m_blocks[i]] = i;
+
+      // -- number the pointer variables
+      for (auto &bl: m_blocks) {
+	for (auto &s: cfg.get_node(bl)) {
+	  const typename stmt_t::live_t &ls = s.get_live();
+	  for (auto v: boost::make_iterator_range(ls.uses_begin(), ls.uses_end())) {
+	    if (v.get_type() == crab::PTR_TYPE) m_var_ids.insert(std::make_pair(v, m_var_ids.size()));
+	  }
+	  for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	    if (v.get_type() == crab::PTR_TYPE) m_var_ids.insert(std::make_pair(v, m_var_ids.size()));
+	  }
+	}
+      }
+
+      // -- forward fixpoint. The pointers are unknown at the entry.
+      m_pre.assign(num_blocks, state_t());
+      if (num_blocks == 0) return;
+      m_pre[0].assign(m_var_ids.size() + 1, TOP);
+      std::set<unsigned> worklist;
+      worklist.insert(0);
+      while (!worklist.empty()) {
+	unsigned i = *worklist.begin();
+	worklist.erase(worklist.begin());
+	state_t post(m_pre[i]);
+	apply(i, post, nullptr, 0);
+	if (post.empty()) continue;
+	for (auto s: cfg.next_nodes(m_blocks[i])) {
+	  unsigned j = m_block_ids[s];
+	  state_t old(m_pre[j]);
+	  join(m_pre[j], post);
+	  if (m_pre[j] != old) worklist.insert(j);
+	}
+      }
+    }
+
+    // Same records as crab's null_property_checker: one for each
+    // ptr_load and ptr_store (safe if unreachable).
+    crab::checker::checks_db check(unsigned verbose) {
+      crab::checker::checks_db checks;
+      for (unsigned i = 0, n = m_blocks.size(); i < n; ++i) {
+	state_t s(m_pre[i]);
+	apply(i, s, &checks, verbose);
+      }
+      return checks;
+    }
+  };
+
+} // end namespace nullity_impl
+} // end namespace crab_llvm
@@ -9,15 +9,22 @@ namespace crab_llvm {
   // Preprocessor passes
   llvm::Pass* createLowerCstExprPass ();
   llvm::Pass* createLowerGvInitializersPass ();
-  llvm::Pass* createLowerSelectPass ();
+  // only_relevant: lower only the selects that flow into assertions
+  // or loop guards
+  llvm::Pass* createLowerSelectPass (bool only_relevant = false);
   llvm::Pass* createLowerUnsignedICmpPass ();
-  llvm::Pass* createMarkInternalInlinePass ();
+  // budget: max number of instructions of a caller after inlining
+  // (0: inline all internal functions)
+  llvm::Pass* createMarkInternalInlinePass (unsigned budget = 0);
   llvm::Pass* createRemoveUnreachableBlocksPass ();
-  llvm::Pass* createSimplifyAssumePass ();
+  // promote: promote verifier.assume to llvm.assume intrinsics
+  llvm::Pass* createSimplifyAssumePass (bool promote = false);
   llvm::Pass* createDevirtualizeFunctionsPass();
   llvm::Pass* createExternalizeAddressTakenFunctionsPass ();
   llvm::Pass* createPromoteMallocPass ();
   llvm::Pass* createPromoteAssumePass ();
+  // lower the !crab.inv metadata to verifier.assume
+  llvm::Pass* createLowerInvariantMetadataPass ();
 }
 
 #endif /* CRABLLVM_PASSES__HH_ */
@@ -0,0 +1,91 @@
+#pragma once
+
+/** 
+ * Per-function profile of the intra-procedural analysis
+ * (--crab-profile).
+ *
+ * The time (in seconds) of each phase, the size of the largest
+ * invariant (number of linear constraints), the size of the CFG and
+ * the domain of each function are written in JSON at the end of the
+ * analysis.
+ **/
+
+#include "crab_llvm/AllocAccountant.hh"
+#include "crab_llvm/Support/PerfCounters.hh"
+#include "crab_llvm/Support/Trace.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace llvm {
+  class Function;
+}
+
+namespace crab_llvm {
+  struct ModuleState;
+
+namespace profile_impl {
+
+  class profiler {
+    struct function_profile {
+      std::map<std::string, double> phases;
+      std::map<std::string, perf_sample> counters;
+      size_t max_csts;
+      size_t blocks;
+      size_t stmts;
+      std::string domain;
+      function_profile(): max_csts(0), blocks(0), stmts(0) {}
+    };
+    std::map<std::string, function_profile> m_profiles;
+    // whether the hardware counters are read (--crab-profile-counters)
+    bool m_counters;
+    // functions can be analyzed by several threads
+    std::mutex m_mutex;
+
+  public:
+
+    explicit profiler(bool counters): m_counters(counters) {}
+
+    bool hasCounters() const { return m_counters; }
+
+    void addTime(const llvm::Function &F, const std::string &phase, double secs);
+
+    void addCounters(const llvm::Function &F, const std::string &phase,
+		     const perf_sample &s);
+
+    void addSize(const llvm::Function &F, size_t csts);
+
+    void addCfgSize(const llvm::Function &F, size_t blocks, size_t stmts);
+
+    // the domain of the last analysis of F
+    void setDomain(const llvm::Function &F, const std::string &dom);
+
+    void write(const std::string &file);
+  };
+
+  // Add the time spent in the scope to phase of F in the profiler of
+  // state (if any). The phase is also a duration event of the
+  // timeline (--crab-trace).
+  class scoped_phase {
+    profiler *m_prof;
+    const llvm::Function &m_fun;
+    std::string m_phase;
+    std::chrono::steady_clock::time_point m_start;
+    perf_sample m_start_counters;
+    bool m_counters;
+    trace_scope m_trace;
+    alloc_stats_impl::scoped_alloc m_alloc;
+
+  public:
+
+    scoped_phase(const ModuleState *state, const llvm::Function &F, std::string phase);
+
+    ~scoped_phase();
+  };
+
+} // end namespace profile_impl
+} // end namespace crab_llvm
@@ -0,0 +1,27 @@
+#pragma once
+
+/** Functions that can be removed from the call graph (--crab-inter-prune) **/
+
+#include "crab_llvm/CfgBuilder.hh"
+
+#include <vector>
+
+namespace llvm {
+  class Function;
+}
+
+namespace crab_llvm {
+  class HeapAbstraction;
+
+namespace prune_impl {
+
+  typedef CfgBuilder::function_set_t function_set_t;
+
+  // Return the functions of funcs without checks nor effects on their
+  // callers that only call functions that can be pruned too.
+  // Otherwise, their callees would lose calling contexts.
+  function_set_t getPrunable(const std::vector<llvm::Function*> &funcs,
+			     HeapAbstraction &mem, crab::cfg::tracked_precision tracklev);
+
+} // end namespace prune_impl
+} // end namespace crab_llvm
@@ -0,0 +1,104 @@
+#pragma once
+
+/**
+ * Intervals of llvm values at arbitrary instructions for crab-llvm
+ * clients (CrabLlvmPass::get_ranges).
+ **/
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Instruction.h"
+#include "crab_llvm/IncrementalAnalysis.hh"
+#include "crab/analysis/abs_transformer.hpp"
+
+#include <boost/optional.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <mutex>
+#include <vector>
+
+namespace crab_llvm {
+namespace range_impl {
+
+  typedef ikos::interval<number_t> interval_t;
+
+  //! Push in res the intervals of vals in the abstract value of a
+  //! wrapper, whatever its domain is. The value is not copied.
+  struct projector {
+    const std::vector<const llvm::Value*> &m_vals;
+    llvm_variable_factory &m_vfac;
+    // protects m_vfac
+    std::mutex &m_mutex;
+    std::vector<interval_t> &m_res;
+
+    projector(const std::vector<const llvm::Value*> &vals, llvm_variable_factory &vfac,
+	      std::mutex &mutex, std::vector<interval_t> &res)
+      : m_vals(vals), m_vfac(vfac), m_mutex(mutex), m_res(res) {}
+
+    template<typename AbsDomain>
+    void operator()(const AbsDomain &inv) {
+      std::vector<boost::optional<var_t>> vars;
+      {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const llvm::Value *v: m_vals) {
+	  vars.push_back(incremental_impl::mkVar(*v, m_vfac));
+	}
+      }
+      AbsDomain &a = const_cast<AbsDomain&>(inv);
+      for (auto &v: vars) {
+	m_res.push_back(v ? a[*v] : interval_t::top());
+      }
+    }
+  };
+
+  //! Propagate the abstract value of a wrapper through the
+  //! statements of bb up to the ones of inst and then project it
+  //! with proj. The statements of inst are the ones before the
+  //! first statement that mentions an instruction after inst, so
+  //! the statements that do not mention any instruction of bb are
+  //! kept with the previous ones. Callsites are ignored, as in
+  //! InsertInvariants::collect_loads.
+  struct propagator {
+    basic_block_t &m_bb;
+    const llvm::Instruction &m_inst;
+    projector m_proj;
+
+    propagator(basic_block_t &bb, const llvm::Instruction &inst, projector proj)
+      : m_bb(bb), m_inst(inst), m_proj(proj) {}
+
+    bool after_inst(const var_t &v,
+		    const llvm::DenseMap<const llvm::Value*, unsigned> &pos,
+		    unsigned inst_pos) const {
+      if (boost::optional<const llvm::Value*> val = v.name().get()) {
+	auto it = pos.find(*val);
+	return it != pos.end() && it->second > inst_pos;
+      }
+      return false;
+    }
+
+    template<typename AbsDomain>
+    void operator()(const AbsDomain &pre) {
+      llvm::DenseMap<const llvm::Value*, unsigned> pos;
+      unsigned inst_pos = 0;
+      for (auto &I: *m_inst.getParent()) {
+	if (&I == &m_inst) inst_pos = pos.size();
+	pos[&I] = pos.size();
+      }
+      AbsDomain inv(pre);
+      crab::analyzer::intra_abs_transformer<AbsDomain> vis(&inv);
+      for (auto &s: m_bb) {
+	auto &ls = s.get_live();
+	bool stop = false;
+	for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	  stop |= after_inst(v, pos, inst_pos);
+	}
+	for (auto v: boost::make_iterator_range(ls.uses_begin(), ls.uses_end())) {
+	  stop |= after_inst(v, pos, inst_pos);
+	}
+	if (stop) break;
+	s.accept(&vis);
+      }
+      m_proj(inv);
+    }
+  };
+
+} // end namespace range_impl
+} // end namespace crab_llvm
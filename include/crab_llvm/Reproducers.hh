@@ -0,0 +1,50 @@
+#pragma once
+
+/** 
+ * Reproducers of the functions whose analysis is slow
+ * (--crab-extract-slow).
+ *
+ * For each slow function F, the directory --crab-extract-dir
+ * contains F.bc (the module with only the body of F), F.args (the
+ * options of the analysis, one per line), F.params (the parameters
+ * of the analysis that actually ran, e.g., after the domain was
+ * downgraded) and F.crab (the Crab CFG as analyzed by the fixpoint,
+ * for reading). crabllvm-replay runs the analysis of F.bc again
+ * with the options of F.args.
+ *
+ * The functions are recorded while they are analyzed and the files
+ * are written at the end of the analysis: the module cannot be
+ * cloned while other threads are analyzing it.
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace crab_llvm {
+namespace repro_impl {
+
+  struct slow_function {
+    llvm::Function *fun;
+    unsigned ms;
+    std::string params;
+    std::string cfg;
+  };
+
+  class recorder {
+    std::vector<slow_function> m_funcs;
+    std::mutex m_mutex;
+
+  public:
+
+    void add(llvm::Function &F, unsigned ms, const AnalysisParams &params,
+	     const std::string &cfg);
+
+    void write(const std::string &dir, const std::vector<std::string> &args);
+  };
+
+} // end namespace repro_impl
+} // end namespace crab_llvm
@@ -0,0 +1,37 @@
+#pragma once
+
+/**
+ * Only the functions reachable from the roots in the call graph
+ * are analyzed (--crab-roots).
+ **/
+
+#include <boost/unordered_set.hpp>
+
+namespace llvm {
+  class Function;
+  class Module;
+  class CallGraph;
+}
+
+namespace crab_llvm {
+namespace roots_impl {
+
+  bool enabled();
+
+  // The functions reachable from the roots
+  class reachable_set {
+    boost::unordered_set<const llvm::Function*> m_reachable;
+
+  public:
+
+    // An indirect call can call any function whose address is
+    // taken. Return the number of roots found in M.
+    unsigned init(llvm::Module &M, llvm::CallGraph &cg);
+
+    unsigned size() const { return m_reachable.size(); }
+
+    bool isReachable(const llvm::Function &F) const;
+  };
+
+} // end namespace roots_impl
+} // end namespace crab_llvm
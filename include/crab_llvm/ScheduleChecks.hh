@@ -0,0 +1,39 @@
+#pragma once
+
+/** 
+ * Order in which functions are analyzed (--crab-schedule-checks).
+ *
+ * Functions that failed in the last run go first, then functions
+ * with more assertions and, among them, smaller functions. The
+ * functions that failed are stored in the directory of
+ * --crab-incremental (if any).
+ **/
+
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <vector>
+
+namespace llvm {
+  class Module;
+}
+
+namespace crab_llvm {
+  struct ModuleState;
+
+namespace schedule_impl {
+
+  // Store the functions that failed in this run
+  void storeHistory();
+
+  // Forget the functions of the previous module: a process can
+  // analyze several modules (batch mode or the C API)
+  void reset();
+
+  void record(const llvm::Function &F, const checks_db_t &checks);
+
+  // Return all the functions of M analyzed by the pass in the order
+  // they should be analyzed
+  std::vector<llvm::Function*> getSchedule(llvm::Module &M, const ModuleState &state);
+
+} // end namespace schedule_impl
+} // end namespace crab_llvm
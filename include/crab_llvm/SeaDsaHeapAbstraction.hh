@@ -5,6 +5,8 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/ImmutableSet.h"
+#include <mutex>
+#include <vector>
 
 // forward declarations
 namespace sea_dsa {
@@ -41,12 +43,23 @@ namespace crab_llvm {
     llvm::DenseMap<const llvm::Function*, region_set_t> m_func_accessed;
     llvm::DenseMap<const llvm::Function*, region_set_t> m_func_mods;
     llvm::DenseMap<const llvm::Function*, region_set_t> m_func_news;
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_onlyreads;
     llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_accessed;
     llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_mods;
     llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_news;
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_onlyreads;
+    // returned for functions and callsites without regions
+    region_set_t m_empty_set;
 
     int getId(const sea_dsa::Cell& c);
 
+    // return true if the cell (n, offset) overlaps neither with other
+    // cells nor with other offsets of an array node
+    bool isValidCell(const sea_dsa::Node* n, unsigned offset);
+
+    // getRegion without caching
+    region_t computeRegion(const llvm::Function &F, llvm::Value *V);
+
     // compute and cache the set of read, mod and new nodes of a whole
     // function such that mod nodes are a subset of the read nodes and
     // the new nodes are disjoint from mod nodes.
@@ -72,22 +85,25 @@ namespace crab_llvm {
     virtual region_t getRegion(const llvm::Function &F, llvm::Value *V) override;
     
     virtual const llvm::Value* getSingleton(int region) const override;
+
+    virtual const llvm::Value* getLocalSingleton(const llvm::Function &F,
+						 int region) const override;
     
-    virtual region_set_t getAccessedRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getAccessedRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getOnlyReadRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getOnlyReadRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getModifiedRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getModifiedRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getNewRegions(const llvm::Function &F) override;
+    virtual const region_set_t& getNewRegions(const llvm::Function &F) override;
     
-    virtual region_set_t getAccessedRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getAccessedRegions(llvm::CallInst &I) override;
     
-    virtual region_set_t getOnlyReadRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getOnlyReadRegions(llvm::CallInst &I) override;
     
-    virtual region_set_t getModifiedRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getModifiedRegions(llvm::CallInst &I) override;
     
-    virtual region_set_t getNewRegions(llvm::CallInst &I) override;
+    virtual const region_set_t& getNewRegions(llvm::CallInst &I) override;
     
     virtual llvm::StringRef getName() const override {
       return "SeaDsaHeapAbstraction";
@@ -99,14 +115,22 @@ namespace crab_llvm {
     const llvm::DataLayout& m_dl;
     sea_dsa::GlobalAnalysis* m_dsa;
     SetFactory* m_fac;
-    /// map from Node to id
-    llvm::DenseMap<const sea_dsa::Node*, unsigned> m_node_ids;
-    /// reverse map
-    boost::unordered_map<unsigned, const sea_dsa::Node*> m_rev_node_ids;
+    /// map from accessed cell (Node and offset) to id
+    llvm::DenseMap<std::pair<const sea_dsa::Node*, unsigned>, unsigned> m_cell_ids;
+    /// reverse map indexed by id (only cells at offset 0, otherwise null)
+    std::vector<const sea_dsa::Node*> m_rev_node_ids;
     unsigned m_max_id;
+    /// cache of getRegion: the sea-dsa graphs do not change after
+    /// the analysis so the region of a value is always the same.
+    llvm::DenseMap<std::pair<const llvm::Function*, const llvm::Value*>, region_t> m_region_cache;
+    /// cache of isValidCell
+    llvm::DenseMap<std::pair<const sea_dsa::Node*, unsigned>, bool> m_valid_cells;
     bool m_disambiguate_unknown;
     bool m_disambiguate_ptr_cast;
     bool m_disambiguate_external;
+    // Queries can assign new ids so they are serialized to allow
+    // building CFGs from several threads.
+    mutable std::mutex m_mutex;
 
   };
 
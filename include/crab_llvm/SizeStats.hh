@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+ * Size of the invariants for --crab-stats. By default, it is the
+ * number of finite bounds of the integer variables, which does not
+ * require converting the invariants into linear constraints.
+ **/
+
+#include "llvm/Support/CommandLine.h"
+#include "crab_llvm/crab_cfg.hh"
+#include "crab_llvm/wrapper_domain.hh"
+
+#include <boost/range/iterator_range.hpp>
+#include <set>
+#include <vector>
+
+extern llvm::cl::opt<bool> CrabStatsConstraints;
+
+namespace crab_llvm {
+namespace size_stats_impl {
+
+  // Return the integer variables of cfg
+  template<typename CFG>
+  std::vector<var_t> getVariables(CFG cfg) {
+    typedef typename CFG::statement_t stmt_t;
+    std::set<var_t> vars;
+    for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+      for (auto &s: cfg.get_node(bl)) {
+	const typename stmt_t::live_t &ls = s.get_live();
+	for (auto v: boost::make_iterator_range(ls.uses_begin(), ls.uses_end())) {
+	  if (v.get_type() == crab::INT_TYPE) vars.insert(v);
+	}
+	for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	  if (v.get_type() == crab::INT_TYPE) vars.insert(v);
+	}
+      }
+    }
+    return std::vector<var_t>(vars.begin(), vars.end());
+  }
+
+  template<typename Dom>
+  unsigned getSize(Dom &absval, const std::vector<var_t> &vars) {
+    // XXX: for boxes it would be more useful to get a measure from
+    // to_disjunctive_linear_constraint_system() but it can be
+    // really slow.
+    if (CrabStatsConstraints) {
+      return absval.to_linear_constraint_system().size();
+    } else {
+      return num_finite_bounds(absval, vars);
+    }
+  }
+
+} // end namespace size_stats_impl
+} // end namespace crab_llvm
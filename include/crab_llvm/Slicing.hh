@@ -0,0 +1,83 @@
+#pragma once
+
+/**
+ * Slicing of a crab CFG with respect to its checks (--crab-slice-checks).
+ *
+ * A variable is relevant if it is used by a statement that does
+ * not define any variable (assume, assert, return, etc) or by a
+ * callsite, or if it is used by a statement that defines some
+ * relevant variable. The computation is flow-insensitive. The
+ * statements that only define irrelevant variables are removed
+ * since their values cannot flow into a relevant variable.
+ **/
+
+#include <boost/range/iterator_range.hpp>
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace crab_llvm {
+namespace slicing_impl {
+
+  // Return the number of removed statements
+  template<typename CFG>
+  unsigned slice(CFG &cfg) {
+    typedef typename CFG::statement_t stmt_t;
+    typedef typename CFG::variable_t variable_t;
+
+    std::set<variable_t> relevant;
+    std::vector<stmt_t*> stmts;
+    for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+      for (auto &s: cfg.get_node(bl)) {
+	const typename stmt_t::live_t &ls = s.get_live();
+	if (ls.defs_begin() == ls.defs_end() || s.is_callsite()) {
+	  relevant.insert(ls.uses_begin(), ls.uses_end());
+	} else {
+	  stmts.push_back(&s);
+	}
+      }
+    }
+
+    // -- propagate relevance from definitions to uses
+    bool change = true;
+    while (change) {
+      change = false;
+      for (stmt_t *s: stmts) {
+	const typename stmt_t::live_t &ls = s->get_live();
+	if (std::none_of(ls.defs_begin(), ls.defs_end(),
+			 [&relevant](const variable_t &v) {
+			   return relevant.count(v) > 0;
+			 })) {
+	  continue;
+	}
+	for (auto v: boost::make_iterator_range(ls.uses_begin(), ls.uses_end())) {
+	  change |= relevant.insert(v).second;
+	}
+      }
+    }
+
+    // -- remove irrelevant statements
+    unsigned num_removed = 0;
+    for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+      auto &b = cfg.get_node(bl);
+      std::vector<stmt_t*> dead;
+      for (auto &s: b) {
+	const typename stmt_t::live_t &ls = s.get_live();
+	if (ls.defs_begin() == ls.defs_end() || s.is_callsite()) continue;
+	if (std::none_of(ls.defs_begin(), ls.defs_end(),
+			 [&relevant](const variable_t &v) {
+			   return relevant.count(v) > 0;
+			 })) {
+	  dead.push_back(&s);
+	}
+      }
+      for (stmt_t *s: dead) {
+	b.remove(s);
+      }
+      num_removed += dead.size();
+    }
+    return num_removed;
+  }
+
+} // end namespace slicing_impl
+} // end namespace crab_llvm
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/HeapAbstraction.hh"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/DenseMap.h"
+
+#include <memory>
+#include <string>
+
+namespace llvm {
+  class Module;
+  class Function;
+  class Value;
+  class CallInst;
+}
+
+namespace crab_llvm {
+
+  /*
+   * Heap abstraction loaded from a file written by a previous run
+   * (--crab-heap-snapshot). The file stores, for each function, the
+   * regions of its values, the read/mod/new regions of the function
+   * and of its callsites and the (global and local) singleton
+   * regions. Values are identified by their position in the module
+   * so the snapshot is only valid for the same module: it is
+   * discarded if the module hash does not match.
+   */
+  class SnapshotHeapAbstraction: public HeapAbstraction {
+
+   public:
+
+     using typename HeapAbstraction::region_t;
+     using typename HeapAbstraction::region_set_t;
+
+   private:
+
+    enum set_kind_t { ACCESSED = 0, ONLY_READ = 1, MODIFIED = 2, NEW = 3, NUM_SET_KINDS = 4};
+
+    llvm::DenseMap<std::pair<const llvm::Function*, const llvm::Value*>, region_t> m_regions;
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_sets[NUM_SET_KINDS];
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_sets[NUM_SET_KINDS];
+    llvm::DenseMap<int, const llvm::Value*> m_singletons;
+    llvm::DenseMap<std::pair<const llvm::Function*, int>, const llvm::Value*> m_local_singletons;
+    region_set_t m_empty_set;
+
+    SnapshotHeapAbstraction() { }
+
+    const region_set_t& lookup(const llvm::Function &F, set_kind_t k) const;
+    const region_set_t& lookup(const llvm::CallInst &I, set_kind_t k) const;
+
+   public:
+
+    // Return null if the snapshot cannot be read or it was not
+    // computed for M and config. The reason is stored in error.
+    static std::unique_ptr<SnapshotHeapAbstraction>
+    load(llvm::Module &M, const std::string &file, const std::string &config,
+	 std::string &error);
+
+    // Write the regions of mem for M in file. config describes the
+    // options used to compute mem and it must match when loading.
+    static bool write(HeapAbstraction &mem, llvm::Module &M,
+		      const std::string &file, const std::string &config);
+
+    virtual region_t getRegion(const llvm::Function &F, llvm::Value *V) override;
+
+    virtual const llvm::Value* getSingleton(int region) const override;
+
+    virtual const llvm::Value* getLocalSingleton(const llvm::Function &F,
+						 int region) const override;
+
+    virtual const region_set_t& getAccessedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getOnlyReadRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getModifiedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getNewRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getAccessedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getOnlyReadRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getModifiedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getNewRegions(llvm::CallInst &I) override;
+
+    virtual llvm::StringRef getName() const override {
+      return "SnapshotHeapAbstraction";
+    }
+  };
+
+} // end namespace crab_llvm
@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * Function summaries of the inter-procedural analysis
+ * (--crab-export-summaries and --crab-import-summaries).
+ **/
+
+#include "crab_llvm/CrabLlvm.hh"
+
+#include <map>
+#include <string>
+#include <utility>
+
+namespace llvm {
+  class Function;
+}
+
+namespace crab_llvm {
+  class HeapAbstraction;
+
+namespace summaries_impl {
+
+  // function name -> (key, summary)
+  typedef std::map<std::string, std::pair<std::string, std::string>> summary_db_t;
+
+  // The summary of F depends on F and on all the functions
+  // reachable from F through direct calls.
+  std::string getKey(const llvm::Function &F, const AnalysisParams &params,
+		     HeapAbstraction &mem);
+
+  // Return false if file does not exist or it cannot be read
+  bool load(const std::string &file, summary_db_t &db);
+
+  void store(const std::string &file, const summary_db_t &db);
+
+  // Report the summaries that still hold, the ones of functions
+  // that changed and the ones that differ for the same function.
+  void compare(const summary_db_t &imported, const summary_db_t &computed);
+
+} // end namespace summaries_impl
+} // end namespace crab_llvm
@@ -0,0 +1,123 @@
+#ifndef __ALLOC_STATS_HH_
+#define __ALLOC_STATS_HH_
+
+/// Allocation counters of the calling thread (--crab-alloc-stats)
+///
+/// The counters are only updated if the executable replaces operator
+/// new and delete with the hooks of tools/AllocHooks.cc, which call
+/// on_alloc and on_free. Otherwise read_alloc_counters returns false.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace crab_llvm
+{
+  // Allocations done by the calling thread. net_bytes is the
+  // difference between the bytes allocated and the bytes freed by the
+  // thread, that is, the bytes that are still live if nothing was
+  // freed by another thread.
+  struct alloc_sample {
+    uint64_t allocs;
+    uint64_t bytes;
+    int64_t net_bytes;
+
+    alloc_sample(): allocs(0), bytes(0), net_bytes(0) {}
+
+    alloc_sample& operator+=(const alloc_sample &o) {
+      allocs += o.allocs;
+      bytes += o.bytes;
+      net_bytes += o.net_bytes;
+      return *this;
+    }
+
+    alloc_sample operator-(const alloc_sample &o) const {
+      alloc_sample r;
+      r.allocs = allocs - o.allocs;
+      r.bytes = bytes - o.bytes;
+      r.net_bytes = net_bytes - o.net_bytes;
+      return r;
+    }
+  };
+
+  namespace alloc_impl {
+    // zero-initialized so it can be used by operator new before and
+    // after the dynamic initialization of the thread
+    struct thread_counts {
+      uint64_t allocs;
+      uint64_t bytes;
+      uint64_t freed;
+    };
+
+    inline thread_counts& get_thread_counts() {
+      static thread_local thread_counts c;
+      return c;
+    }
+
+    // set by the hooks
+    inline std::atomic<bool>& installed() {
+      static std::atomic<bool> v(false);
+      return v;
+    }
+
+    // set by --crab-alloc-stats: the hooks only count when enabled
+    inline std::atomic<bool>& enabled() {
+      static std::atomic<bool> v(false);
+      return v;
+    }
+
+    // live bytes of the process and its peak since enabled
+    inline std::atomic<int64_t>& live_bytes() {
+      static std::atomic<int64_t> v(0);
+      return v;
+    }
+
+    inline std::atomic<int64_t>& peak_bytes() {
+      static std::atomic<int64_t> v(0);
+      return v;
+    }
+
+    inline void on_alloc(size_t n) {
+      if (!enabled().load(std::memory_order_relaxed)) return;
+      thread_counts &c = get_thread_counts();
+      c.allocs++;
+      c.bytes += n;
+      int64_t live = live_bytes().fetch_add(n, std::memory_order_relaxed) + n;
+      int64_t peak = peak_bytes().load(std::memory_order_relaxed);
+      while (live > peak &&
+	     !peak_bytes().compare_exchange_weak(peak, live, std::memory_order_relaxed));
+    }
+
+    inline void on_free(size_t n) {
+      if (!enabled().load(std::memory_order_relaxed)) return;
+      get_thread_counts().freed += n;
+      live_bytes().fetch_sub(n, std::memory_order_relaxed);
+    }
+  }
+
+  // Start counting. Return false if the hooks are not installed.
+  inline bool enable_alloc_counters() {
+    if (!alloc_impl::installed()) return false;
+    alloc_impl::enabled() = true;
+    return true;
+  }
+
+  inline bool alloc_counters_enabled() {
+    return alloc_impl::enabled().load(std::memory_order_relaxed);
+  }
+
+  inline bool read_alloc_counters(alloc_sample &s) {
+    if (!alloc_counters_enabled()) return false;
+    const alloc_impl::thread_counts &c = alloc_impl::get_thread_counts();
+    s.allocs = c.allocs;
+    s.bytes = c.bytes;
+    s.net_bytes = (int64_t) c.bytes - (int64_t) c.freed;
+    return true;
+  }
+
+  // peak of the live bytes of the process since counting started
+  inline int64_t peak_alloc_bytes() {
+    return alloc_impl::peak_bytes().load(std::memory_order_relaxed);
+  }
+}
+#endif
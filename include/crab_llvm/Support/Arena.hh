@@ -0,0 +1,145 @@
+#ifndef __ARENA_HH_
+#define __ARENA_HH_
+
+/// Thread-local pools for the temporaries of the abstract domains
+#include <gmp.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+
+namespace crab_llvm
+{
+  namespace arena_impl {
+    // Blocks up to max_size bytes (GMP allocates limbs of 8 bytes)
+    // are cached per thread. Each free list keeps at most max_blocks.
+    const size_t limb_size = 8;
+    const size_t max_size = 512;
+    const size_t num_lists = max_size / limb_size + 1;
+    const unsigned max_blocks = 1 << 14;
+
+    struct block { block *next; };
+
+    struct pool {
+      // number of active scopes of the calling thread
+      unsigned depth;
+      block *lists[num_lists];
+      unsigned length[num_lists];
+
+      pool(): depth(0) {
+	for (size_t i = 0; i < num_lists; ++i) {
+	  lists[i] = nullptr;
+	  length[i] = 0;
+	}
+      }
+
+      ~pool() { release(); }
+
+      void release() {
+	for (size_t i = 0; i < num_lists; ++i) {
+	  while (block *b = lists[i]) {
+	    lists[i] = b->next;
+	    std::free(b);
+	  }
+	  length[i] = 0;
+	}
+      }
+    };
+
+    inline pool& get_pool() {
+      static thread_local pool p;
+      return p;
+    }
+
+    // The size passed by GMP to free is always the size of the
+    // allocation so a cached block is reused only for a request of the
+    // same size. This is why blocks allocated before the hooks were
+    // installed or by another thread can be cached safely.
+    inline bool is_cached_size(size_t sz) {
+      return sz >= sizeof(block) && sz <= max_size && sz % limb_size == 0;
+    }
+
+    inline void* alloc(size_t sz) {
+      pool &p = get_pool();
+      if (p.depth > 0 && is_cached_size(sz)) {
+	size_t i = sz / limb_size;
+	if (block *b = p.lists[i]) {
+	  p.lists[i] = b->next;
+	  p.length[i]--;
+	  return b;
+	}
+      }
+      void *ptr = std::malloc(sz);
+      if (!ptr) std::abort();
+      return ptr;
+    }
+
+    inline void* realloc(void *ptr, size_t old_sz, size_t new_sz) {
+      // -- GMP often reallocates to the same number of limbs
+      if (old_sz == new_sz) return ptr;
+      void *res = std::realloc(ptr, new_sz);
+      if (!res) std::abort();
+      return res;
+    }
+
+    inline void free(void *ptr, size_t sz) {
+      pool &p = get_pool();
+      if (p.depth > 0 && is_cached_size(sz)) {
+	size_t i = sz / limb_size;
+	if (p.length[i] < max_blocks) {
+	  block *b = static_cast<block*>(ptr);
+	  b->next = p.lists[i];
+	  p.lists[i] = b;
+	  p.length[i]++;
+	  return;
+	}
+      }
+      std::free(ptr);
+    }
+
+    inline void install() {
+      static std::once_flag flag;
+      std::call_once(flag, []() {
+	mp_set_memory_functions(&alloc, &realloc, &free);
+      });
+    }
+  }
+
+  /*
+   * While a scope is alive the big numbers of the calling thread
+   * (i.e., the temporaries created by the abstract domains) are
+   * recycled from thread-local free lists rather than going through
+   * malloc. Scopes can be nested: the cached blocks are released all
+   * at once when the outermost scope of the thread is destroyed,
+   * typically after the analysis of a function.
+   */
+  class arena_scope {
+    bool m_enabled;
+
+  public:
+
+    explicit arena_scope(bool enabled = true): m_enabled(enabled) {
+      if (!m_enabled) return;
+      arena_impl::install();
+      arena_impl::get_pool().depth++;
+    }
+
+    ~arena_scope() {
+      if (!m_enabled) return;
+      arena_impl::pool &p = arena_impl::get_pool();
+      if (--p.depth == 0) {
+	p.release();
+      }
+    }
+
+    arena_scope(const arena_scope&) = delete;
+    arena_scope& operator=(const arena_scope&) = delete;
+  };
+
+  // True if the calling thread is inside an arena_scope. Used to open
+  // a scope in the worker threads of a phase run inside one.
+  inline bool in_arena_scope() {
+    return arena_impl::get_pool().depth > 0;
+  }
+}
+#endif
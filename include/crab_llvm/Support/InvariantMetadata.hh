@@ -0,0 +1,35 @@
+#ifndef __INVARIANT_METADATA_HH_
+#define __INVARIANT_METADATA_HH_
+
+/// Invariants attached as metadata (--crab-add-invariants-metadata)
+///
+/// Metadata nodes cannot refer to SSA values (function-local
+/// metadata is only allowed as a call argument) so the values of the
+/// invariants are the arguments of a call to the marker function
+/// crab.inv and the constraints are the !crab.inv metadata of the
+/// call:
+///
+///   call void (...) @crab.inv(i32 %x, i32 %y), !crab.inv !0
+///   !0 = !{!1, !2}
+///   !1 = !{!"le", i64 10, i32 0, i64 1, i32 1, i64 -1}  ; x - y <= 10
+///   !2 = !{!"ne", i64 0, i32 1, i64 1}                  ; y != 0
+///
+/// Each constraint is its kind ("le", "eq" or "ne"), its constant
+/// and a list of pairs (argument index, coefficient). The call is
+/// placed at the entry of a block (after its phi nodes) or after a
+/// load instruction. It has no other effect so it can be ignored or
+/// lowered to verifier.assume calls (createLowerInvariantMetadataPass).
+
+#include "llvm/ADT/StringRef.h"
+
+namespace crab_llvm
+{
+  namespace inv_metadata {
+    inline llvm::StringRef markerName() { return "crab.inv"; }
+    inline llvm::StringRef kindName() { return "crab.inv"; }
+    inline llvm::StringRef le() { return "le"; }
+    inline llvm::StringRef eq() { return "eq"; }
+    inline llvm::StringRef ne() { return "ne"; }
+  }
+}
+#endif
@@ -0,0 +1,108 @@
+#ifndef __LOG_HH_
+#define __LOG_HH_
+
+/// Lines of the verbose log (--crab-verbose)
+#include "crab/common/debug.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace crab_llvm
+{
+  namespace log_impl {
+    typedef std::chrono::steady_clock clock_t;
+
+    struct state {
+      clock_t::time_point start;
+      std::mutex mutex;
+      // max number of lines per second (0: no limit)
+      unsigned rate_limit;
+      clock_t::time_point window;
+      unsigned lines_in_window;
+      unsigned dropped;
+
+      state(): start(clock_t::now()), rate_limit(0), window(start),
+	       lines_in_window(0), dropped(0) {}
+    };
+
+    inline state& get_state() {
+      static state s;
+      return s;
+    }
+
+    // the clock starts when the program is loaded
+    static state &init_state = get_state();
+  }
+
+  // Drop the lines of the log above lines_per_sec (0: no limit). The
+  // number of dropped lines is written once the rate goes down.
+  inline void set_log_rate_limit(unsigned lines_per_sec) {
+    log_impl::state &s = log_impl::get_state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.rate_limit = lines_per_sec;
+  }
+
+  /*
+   * A line of the log. The calling thread buffers it and writes it
+   * all at once to crab::outs() when the line is destroyed, that is,
+   * at the end of the expression get_crab_os() << ... Lines of
+   * different threads are not interleaved. The timestamp is
+   * monotonic and it counts the seconds since the program started.
+   */
+  class log_line {
+    std::unique_ptr<crab::crab_string_os> m_os;
+    log_impl::clock_t::time_point m_time;
+    bool m_show_time;
+
+  public:
+
+    explicit log_line(bool show_time)
+      : m_os(new crab::crab_string_os()),
+	m_time(show_time ? log_impl::clock_t::now() : log_impl::clock_t::time_point()),
+	m_show_time(show_time) {}
+
+    log_line(log_line &&o) = default;
+
+    ~log_line() {
+      if (!m_os) return;
+      log_impl::state &s = log_impl::get_state();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (s.rate_limit > 0) {
+	auto now = log_impl::clock_t::now();
+	if (now - s.window >= std::chrono::seconds(1)) {
+	  if (s.dropped > 0) {
+	    crab::outs() << "... " << s.dropped << " lines dropped\n";
+	  }
+	  s.window = now;
+	  s.lines_in_window = 0;
+	  s.dropped = 0;
+	}
+	if (s.lines_in_window >= s.rate_limit) {
+	  s.dropped++;
+	  return;
+	}
+	s.lines_in_window++;
+      }
+      if (m_show_time) {
+	std::chrono::duration<double> d = m_time - s.start;
+	char buf[32];
+	snprintf(buf, sizeof(buf), "[+%.3fs] ", d.count());
+	crab::outs() << buf;
+      }
+      crab::outs() << m_os->str();
+    }
+
+    template<typename T>
+    log_line& operator<<(const T &x) {
+      *m_os << x;
+      return *this;
+    }
+  };
+
+  inline log_line get_crab_os(bool show_time = true) {
+    return log_line(show_time);
+  }
+}
+#endif
@@ -15,6 +15,9 @@ namespace crab_llvm {
     static char ID;
 
     NameValues () : ModulePass (ID) {}
+
+    // Whether values are left unnamed (--crab-lazy-names)
+    static bool lazy ();
     
     bool runOnModule (Module &M);
 
@@ -0,0 +1,64 @@
+#ifndef __NUMBERS_HH_
+#define __NUMBERS_HH_
+
+/// Conversions between LLVM integers and crab numbers
+#include "llvm/ADT/APInt.h"
+#include "crab/common/types.hpp"
+
+#include <gmpxx.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace crab_llvm
+{
+  /*
+   * Numbers that fit in 64 bits are converted directly. Only wider
+   * numbers go through the words of the APInt (or the decimal
+   * string), which is rare since most constants and offsets are
+   * small.
+   */
+
+  // Return true if n fits in int64_t
+  inline bool fitsInt64(const ikos::z_number &n) {
+    static const ikos::z_number min((int64_t) INT64_MIN);
+    static const ikos::z_number max((int64_t) INT64_MAX);
+    return n >= min && n <= max;
+  }
+
+  // Return false if n does not fit in int64_t. Otherwise, res is n.
+  inline bool toInt64(const ikos::z_number &n, int64_t &res) {
+    if (!fitsInt64(n)) return false;
+    res = (int64_t) (long) n;
+    return true;
+  }
+
+  // Assume that v is signed
+  inline ikos::z_number toZNumber(const llvm::APInt &v) {
+    if (v.getMinSignedBits() <= 64) {
+      return ikos::z_number((int64_t) v.getSExtValue());
+    }
+    // Based on:
+    // https://llvm.org/svn/llvm-project/polly/trunk/lib/Support/GICHelper.cpp
+    llvm::APInt abs = v.isNegative() ? v.abs() : v;
+    mpz_class res;
+    mpz_import(res.get_mpz_t(), abs.getNumWords(), -1, sizeof(uint64_t), 0, 0,
+	       abs.getRawData());
+    return ikos::z_number(v.isNegative() ? mpz_class(-res) : res);
+  }
+
+  // Signed value of n with bitwidth bits. It is truncated if it does
+  // not fit.
+  inline llvm::APInt toAPInt(const ikos::z_number &n, unsigned bitwidth) {
+    int64_t k;
+    if (toInt64(n, k)) {
+      return llvm::APInt(bitwidth, (uint64_t) k, true);
+    }
+    // -- a decimal digit needs less than 4 bits (plus the sign)
+    std::string str = n.get_str();
+    unsigned numBits = std::max(bitwidth, (unsigned) str.size() * 4 + 1);
+    llvm::APInt res(numBits, str, 10);
+    return (numBits > bitwidth ? res.trunc(bitwidth) : res);
+  }
+}
+#endif
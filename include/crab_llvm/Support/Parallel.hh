@@ -0,0 +1,46 @@
+#ifndef __PARALLEL_HH_
+#define __PARALLEL_HH_
+
+/// Minimal support to run independent tasks in parallel
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace crab_llvm
+{
+  /*
+   * Call f(worker, i) for each i in [0, n) using at most num_threads
+   * workers. Tasks are dispatched dynamically so long tasks do not
+   * delay the others. worker is in [0, num_threads) and it can be
+   * used to index per-worker data. If num_threads <= 1 then all tasks
+   * are executed by the calling thread in order.
+   */
+  template<typename F>
+  inline void parallel_for(unsigned n, unsigned num_threads, F f) {
+    num_threads = std::max(1U, std::min(num_threads, n));
+    if (num_threads == 1) {
+      for (unsigned i = 0; i < n; ++i) {
+	f(0U, i);
+      }
+      return;
+    }
+
+    std::atomic<unsigned> next(0);
+    auto worker = [&](unsigned id) {
+      for (unsigned i = next++; i < n; i = next++) {
+	f(id, i);
+      }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(num_threads);
+    for (unsigned id = 0; id < num_threads; ++id) {
+      pool.emplace_back(worker, id);
+    }
+    for (auto &t : pool) {
+      t.join();
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef __PERF_COUNTERS_HH_
+#define __PERF_COUNTERS_HH_
+
+/// Hardware performance counters of the calling thread (Linux only)
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace crab_llvm
+{
+  // Counts of the calling thread in user space
+  struct perf_sample {
+    enum { CYCLES = 0, INSTRUCTIONS, CACHE_REFS, CACHE_MISSES,
+	   BRANCHES, BRANCH_MISSES, NUM_COUNTERS };
+    uint64_t values[NUM_COUNTERS];
+
+    perf_sample() { std::memset(values, 0, sizeof(values)); }
+
+    perf_sample& operator+=(const perf_sample &o) {
+      for (unsigned i = 0; i < NUM_COUNTERS; ++i) values[i] += o.values[i];
+      return *this;
+    }
+
+    perf_sample operator-(const perf_sample &o) const {
+      perf_sample r;
+      for (unsigned i = 0; i < NUM_COUNTERS; ++i) {
+	r.values[i] = values[i] >= o.values[i] ? values[i] - o.values[i] : 0;
+      }
+      return r;
+    }
+
+    static const char* name(unsigned i) {
+      static const char *names[] = {"cycles", "instructions", "llc_refs",
+				    "llc_misses", "branches", "branch_misses"};
+      return names[i];
+    }
+
+    double ipc() const {
+      return values[CYCLES] ? (double) values[INSTRUCTIONS] / values[CYCLES] : 0.0;
+    }
+
+    double llc_miss_rate() const {
+      return values[CACHE_REFS] ? (double) values[CACHE_MISSES] / values[CACHE_REFS] : 0.0;
+    }
+
+    double branch_miss_rate() const {
+      return values[BRANCHES] ? (double) values[BRANCH_MISSES] / values[BRANCHES] : 0.0;
+    }
+  };
+
+  namespace perf_impl {
+#ifdef __linux__
+    // One group of counters per thread, opened by its first read. The
+    // counters of a group are scheduled together so their ratios are
+    // meaningful.
+    class thread_counters {
+      int m_fds[perf_sample::NUM_COUNTERS];
+      bool m_ok;
+
+      static int open(uint64_t config, int group) {
+	struct perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP |
+	  PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return syscall(__NR_perf_event_open, &attr, 0 /*this thread*/, -1 /*any cpu*/,
+		       group, 0);
+      }
+
+    public:
+
+      thread_counters(): m_ok(true) {
+	static const uint64_t configs[] =
+	  {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+	   PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES,
+	   PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES};
+	for (unsigned i = 0; i < perf_sample::NUM_COUNTERS; ++i) {
+	  m_fds[i] = open(configs[i], i == 0 ? -1 : m_fds[0]);
+	  if (m_fds[i] < 0) m_ok = false;
+	}
+      }
+
+      ~thread_counters() {
+	for (int fd: m_fds) {
+	  if (fd >= 0) close(fd);
+	}
+      }
+
+      bool ok() const { return m_ok; }
+
+      bool read(perf_sample &s) const {
+	if (!m_ok) return false;
+	// nr, time_enabled, time_running, values
+	uint64_t buf[3 + perf_sample::NUM_COUNTERS];
+	if (::read(m_fds[0], buf, sizeof(buf)) != (ssize_t) sizeof(buf) ||
+	    buf[0] != perf_sample::NUM_COUNTERS) {
+	  return false;
+	}
+	// scale if the group was multiplexed with other events
+	double scale = (buf[2] > 0 ? (double) buf[1] / buf[2] : 1.0);
+	for (unsigned i = 0; i < perf_sample::NUM_COUNTERS; ++i) {
+	  s.values[i] = (uint64_t) (buf[3 + i] * scale);
+	}
+	return true;
+      }
+
+      thread_counters(const thread_counters&) = delete;
+      thread_counters& operator=(const thread_counters&) = delete;
+    };
+
+    inline thread_counters& get_thread_counters() {
+      static thread_local thread_counters c;
+      return c;
+    }
+#endif
+  }
+
+  // Read the counters of the calling thread. Return false if they are
+  // not available (e.g., not Linux, no PMU or perf_event_paranoid).
+  inline bool read_perf_counters(perf_sample &s) {
+#ifdef __linux__
+    return perf_impl::get_thread_counters().read(s);
+#else
+    return false;
+#endif
+  }
+}
+#endif
@@ -0,0 +1,88 @@
+#ifndef __RAW_CRAB_OS_HH_
+#define __RAW_CRAB_OS_HH_
+
+/// A crab::crab_os that writes into an llvm::raw_ostream
+#include "llvm/Support/raw_ostream.h"
+#include "crab/common/os.hpp"
+
+#include <ostream>
+#include <streambuf>
+
+namespace crab_llvm
+{
+  namespace raw_crab_os_impl {
+    // Stream buffer that flushes into a raw_ostream each time its
+    // fixed-size buffer is full.
+    class raw_ostream_buf: public std::streambuf {
+      llvm::raw_ostream &m_os;
+      char m_buf[4096];
+
+      void flush_buf() {
+	if (pptr() > pbase()) {
+	  m_os.write(pbase(), pptr() - pbase());
+	  setp(m_buf, m_buf + sizeof(m_buf));
+	}
+      }
+
+    protected:
+
+      virtual int_type overflow(int_type c) override {
+	flush_buf();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+	  *pptr() = traits_type::to_char_type(c);
+	  pbump(1);
+	}
+	return traits_type::not_eof(c);
+      }
+
+      virtual std::streamsize xsputn(const char *s, std::streamsize n) override {
+	if (n >= (std::streamsize) sizeof(m_buf)) {
+	  // -- large writes bypass the buffer
+	  flush_buf();
+	  m_os.write(s, n);
+	  return n;
+	}
+	return std::streambuf::xsputn(s, n);
+      }
+
+      virtual int sync() override {
+	flush_buf();
+	return 0;
+      }
+
+    public:
+
+      explicit raw_ostream_buf(llvm::raw_ostream &os): m_os(os) {
+	setp(m_buf, m_buf + sizeof(m_buf));
+      }
+
+      ~raw_ostream_buf() { flush_buf(); }
+    };
+
+    // constructed before the crab_os base of raw_crab_os
+    struct raw_crab_os_base {
+      raw_ostream_buf m_buf;
+      std::ostream m_stream;
+      explicit raw_crab_os_base(llvm::raw_ostream &os): m_buf(os), m_stream(&m_buf) {}
+    };
+  }
+
+  /*
+   * Print crab objects (CFGs, invariants, constraints) directly into
+   * an llvm::raw_ostream instead of formatting the whole object in a
+   * crab::crab_string_os first. The output is buffered and it is
+   * flushed into the raw_ostream when the object is destroyed.
+   */
+  class raw_crab_os: private raw_crab_os_impl::raw_crab_os_base, public crab::crab_os {
+  public:
+
+    explicit raw_crab_os(llvm::raw_ostream &os)
+      : raw_crab_os_impl::raw_crab_os_base(os), crab::crab_os(&m_stream) {}
+
+    ~raw_crab_os() { m_stream.flush(); }
+
+    raw_crab_os(const raw_crab_os&) = delete;
+    raw_crab_os& operator=(const raw_crab_os&) = delete;
+  };
+}
+#endif
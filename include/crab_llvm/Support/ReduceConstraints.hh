@@ -0,0 +1,168 @@
+#ifndef __REDUCE_CONSTRAINTS_HH_
+#define __REDUCE_CONSTRAINTS_HH_
+
+/// Removal of redundant constraints (--crab-reduce-constraints)
+///
+/// The constraints produced by relational domains contain many
+/// constraints implied by the other ones (e.g., the transitive
+/// differences of a closed DBM). They are removed before the
+/// invariants are exported or inserted in the IR. The checks are
+/// syntactic so not all redundant constraints are found but the
+/// result is always equivalent to the original system.
+
+#include "crab_llvm/crab_cfg.hh"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace crab_llvm
+{
+  namespace reduce_impl {
+    // The terms of e (or of -e if negate) as a string. The variables
+    // of a linear expression are ordered so equal terms give the same
+    // string.
+    inline std::string termsKey(const lin_exp_t &e, bool negate,
+				std::map<var_t, unsigned> &var_ids) {
+      std::string key;
+      for (auto t: e) {
+	unsigned v = var_ids.insert(std::make_pair(t.second, var_ids.size())).first->second;
+	number_t coeff = (negate ? number_t(0) - t.first : t.first);
+	key += coeff.get_str() + "*" + std::to_string(v) + ";";
+      }
+      return key;
+    }
+
+    // Return true if cst is x - y + c <= 0, x + c <= 0 or -y + c <= 0
+    // where x and y are the nodes of the difference graph (0 is the
+    // zero node and the variables start at 1). Then x <= y + w.
+    inline bool asDifference(const lin_cst_t &cst, std::map<var_t, unsigned> &var_ids,
+			     unsigned &x, unsigned &y, number_t &w) {
+      if (!cst.is_inequality()) return false;
+      const lin_exp_t &e = cst.expression();
+      x = 0;
+      y = 0;
+      unsigned num_terms = 0;
+      for (auto t: e) {
+	unsigned v = var_ids.insert(std::make_pair(t.second, var_ids.size())).first->second + 1;
+	if (++num_terms > 2) return false;
+	if (t.first == number_t(1) && x == 0) {
+	  x = v;
+	} else if (t.first == number_t(-1) && y == 0) {
+	  y = v;
+	} else {
+	  return false;
+	}
+      }
+      w = number_t(0) - e.constant();
+      return num_terms > 0;
+    }
+  }
+
+  // Return the constraints of csts without (some of) the ones that
+  // are implied by the others:
+  //  - tautologies and duplicates,
+  //  - inequalities over the same terms as a tighter inequality or
+  //    an equality that implies them,
+  //  - differences (and unit bounds) x <= y + w implied by x <= z + w1
+  //    and z <= y + w2 with w1 + w2 <= w. The constraints used to
+  //    remove another one are kept at that time so the result still
+  //    implies all the removed constraints.
+  inline lin_cst_sys_t reduceConstraints(const lin_cst_sys_t &csts) {
+    using namespace reduce_impl;
+    std::vector<lin_cst_t> in;
+    for (auto &cst: csts) {
+      if (cst.is_contradiction()) {
+	lin_cst_sys_t res;
+	res += cst;
+	return res;
+      }
+      if (!cst.is_tautology()) in.push_back(cst);
+    }
+    std::vector<char> keep(in.size(), true);
+    std::map<var_t, unsigned> var_ids;
+
+    // -- same terms: the tightest inequality (largest constant) and
+    //    one copy of each equality and disequality
+    std::map<std::string, unsigned> tightest;
+    std::map<std::string, unsigned> exact;
+    for (unsigned i = 0; i < in.size(); ++i) {
+      const lin_exp_t &e = in[i].expression();
+      std::string terms = termsKey(e, false, var_ids);
+      if (in[i].is_inequality()) {
+	auto res = tightest.insert(std::make_pair(terms, i));
+	if (!res.second) {
+	  unsigned &j = res.first->second;
+	  if (in[j].expression().constant() < e.constant()) {
+	    keep[j] = false;
+	    j = i;
+	  } else {
+	    keep[i] = false;
+	  }
+	}
+      } else {
+	std::string key = (in[i].is_equality() ? "=" : "!") + e.constant().get_str() + ":" + terms;
+	if (!exact.insert(std::make_pair(key, i)).second) keep[i] = false;
+      }
+    }
+    // -- inequalities implied by an equality: t + c <= 0 by t + c' = 0
+    //    if c <= c', and -t + c <= 0 if c <= -c'
+    for (unsigned i = 0; i < in.size(); ++i) {
+      if (!keep[i] || !in[i].is_equality()) continue;
+      const lin_exp_t &e = in[i].expression();
+      auto it = tightest.find(termsKey(e, false, var_ids));
+      if (it != tightest.end() && keep[it->second] &&
+	  in[it->second].expression().constant() <= e.constant()) {
+	keep[it->second] = false;
+      }
+      it = tightest.find(termsKey(e, true, var_ids));
+      if (it != tightest.end() && keep[it->second] &&
+	  in[it->second].expression().constant() <= number_t(0) - e.constant()) {
+	keep[it->second] = false;
+      }
+    }
+
+    // -- differences implied by two other differences (the zero node
+    //    relates the unit bounds)
+    typedef std::pair<number_t, unsigned> edge_t;
+    std::map<unsigned, std::map<unsigned, edge_t>> succs;
+    std::vector<std::pair<std::pair<unsigned, unsigned>, unsigned>> edges;
+    for (unsigned i = 0; i < in.size(); ++i) {
+      unsigned x, y;
+      number_t w;
+      if (keep[i] && asDifference(in[i], var_ids, x, y, w)) {
+	// edge y -> x
+	succs[y].insert(std::make_pair(x, edge_t(w, i)));
+	edges.push_back(std::make_pair(std::make_pair(y, x), i));
+      }
+    }
+    for (auto &e: edges) {
+      unsigned y = e.first.first, x = e.first.second;
+      std::map<unsigned, edge_t> &out = succs[y];
+      const number_t w = out.find(x)->second.first;
+      bool redundant = false;
+      for (auto &kv: out) {
+	if (kv.first == x) continue;
+	auto zt = succs.find(kv.first);
+	if (zt == succs.end()) continue;
+	auto xt = zt->second.find(x);
+	if (xt != zt->second.end() && kv.second.first + xt->second.first <= w) {
+	  redundant = true;
+	  break;
+	}
+      }
+      if (redundant) {
+	keep[e.second] = false;
+	out.erase(x);
+      }
+    }
+
+    lin_cst_sys_t res;
+    for (unsigned i = 0; i < in.size(); ++i) {
+      if (keep[i]) res += in[i];
+    }
+    return res;
+  }
+}
+#endif
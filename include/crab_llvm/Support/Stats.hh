@@ -0,0 +1,141 @@
+#ifndef __STATS_HH_
+#define __STATS_HH_
+
+/// Counters and timers of crab-llvm (printed by --crab-stats)
+///
+/// Each thread updates its own table without any lock, so the
+/// counters are always on, also in parallel runs. The table of a
+/// thread is merged into the global one when the thread exits, so the
+/// workers of parallel_for are accounted once it returns. The readers
+/// (stat_value and print_stats) merge the global table with the one
+/// of the calling thread: they only see the threads that are joined.
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace crab_llvm
+{
+  namespace stats_impl {
+    struct table {
+      // summed
+      llvm::StringMap<uint64_t> counts;
+      // max
+      llvm::StringMap<uint64_t> maxes;
+      // summed, in seconds
+      llvm::StringMap<double> times;
+
+      void merge(const table &o) {
+	for (auto &kv: o.counts) counts[kv.getKey()] += kv.getValue();
+	for (auto &kv: o.maxes) {
+	  uint64_t &v = maxes[kv.getKey()];
+	  v = std::max(v, kv.getValue());
+	}
+	for (auto &kv: o.times) times[kv.getKey()] += kv.getValue();
+      }
+    };
+
+    inline std::mutex& global_mutex() {
+      static std::mutex m;
+      return m;
+    }
+
+    // tables of the threads that exited
+    inline table& global_table() {
+      static table t;
+      return t;
+    }
+
+    struct thread_table {
+      table t;
+      ~thread_table() {
+	std::lock_guard<std::mutex> lock(global_mutex());
+	global_table().merge(t);
+      }
+    };
+
+    inline table& get_thread_table() {
+      static thread_local thread_table t;
+      return t.t;
+    }
+
+    // global table merged with the one of the calling thread
+    inline table snapshot() {
+      table res;
+      {
+	std::lock_guard<std::mutex> lock(global_mutex());
+	res.merge(global_table());
+      }
+      res.merge(get_thread_table());
+      return res;
+    }
+
+    template<typename T>
+    std::vector<std::pair<std::string, T>> sorted(const llvm::StringMap<T> &m) {
+      std::vector<std::pair<std::string, T>> res;
+      for (auto &kv: m) res.push_back(std::make_pair(kv.getKey().str(), kv.getValue()));
+      std::sort(res.begin(), res.end());
+      return res;
+    }
+  }
+
+  // Add n to the counter name
+  inline void count_stat(llvm::StringRef name, uint64_t n = 1) {
+    stats_impl::get_thread_table().counts[name] += n;
+  }
+
+  // Keep the max of the values of name
+  inline void count_max_stat(llvm::StringRef name, uint64_t v) {
+    uint64_t &m = stats_impl::get_thread_table().maxes[name];
+    m = std::max(m, v);
+  }
+
+  // Add the time spent in the scope to the timer name
+  class scoped_stats_timer {
+    typedef std::chrono::steady_clock clock_t;
+    std::string m_name;
+    clock_t::time_point m_start;
+
+  public:
+
+    explicit scoped_stats_timer(const std::string &name)
+      : m_name(name), m_start(clock_t::now()) {}
+
+    ~scoped_stats_timer() {
+      std::chrono::duration<double> secs = clock_t::now() - m_start;
+      stats_impl::get_thread_table().times[m_name] += secs.count();
+    }
+  };
+
+  // Value of the counter (or max) name
+  inline uint64_t stat_value(llvm::StringRef name) {
+    stats_impl::table t = stats_impl::snapshot();
+    auto it = t.counts.find(name);
+    if (it != t.counts.end()) return it->getValue();
+    auto jt = t.maxes.find(name);
+    return (jt == t.maxes.end() ? 0 : jt->getValue());
+  }
+
+  // One BRUNCH_STAT line per counter, max and timer, sorted by name
+  inline void print_stats(llvm::raw_ostream &o) {
+    stats_impl::table t = stats_impl::snapshot();
+    for (auto &kv: stats_impl::sorted(t.counts)) {
+      o << "BRUNCH_STAT " << kv.first << " " << kv.second << "\n";
+    }
+    for (auto &kv: stats_impl::sorted(t.maxes)) {
+      o << "BRUNCH_STAT " << kv.first << " " << kv.second << "\n";
+    }
+    for (auto &kv: stats_impl::sorted(t.times)) {
+      o << "BRUNCH_STAT " << kv.first << " " << llvm::format("%.2f", kv.second) << "sec.\n";
+    }
+  }
+}
+#endif
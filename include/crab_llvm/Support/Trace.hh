@@ -0,0 +1,239 @@
+#ifndef __TRACE_HH_
+#define __TRACE_HH_
+
+/// Timeline of the analysis in Chrome trace-event format (--crab-trace)
+#include "llvm/ADT/StringRef.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+namespace crab_llvm
+{
+  namespace trace_impl {
+    typedef std::chrono::steady_clock clock_t;
+
+    inline void write_json_string(std::ostream &o, const std::string &s) {
+      o << '"';
+      for (char c: s) {
+	switch (c) {
+	case '"':  o << "\\\""; break;
+	case '\\': o << "\\\\"; break;
+	case '\n': o << "\\n"; break;
+	case '\t': o << "\\t"; break;
+	default:
+	  if ((unsigned char) c < 0x20) {
+	    char buf[8];
+	    snprintf(buf, sizeof(buf), "\\u%04x", c);
+	    o << buf;
+	  } else {
+	    o << c;
+	  }
+	}
+      }
+      o << '"';
+    }
+
+    // resident set size in MB, or 0 if unknown
+    inline double rss_mb() {
+      std::ifstream statm("/proc/self/statm");
+      unsigned long size, resident;
+      if (statm >> size >> resident) {
+	return (double) resident * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+      }
+      return 0.0;
+    }
+
+    class tracer {
+      std::ofstream m_os;
+      clock_t::time_point m_start;
+      std::mutex m_mutex;
+      bool m_first;
+      // small thread ids are easier to read in the viewers
+      std::map<std::thread::id, unsigned> m_tids;
+      // RSS sampler
+      std::thread m_sampler;
+      std::mutex m_sampler_mutex;
+      std::condition_variable m_sampler_cv;
+      bool m_stop;
+
+      unsigned tid() {
+	auto it = m_tids.find(std::this_thread::get_id());
+	if (it != m_tids.end()) return it->second;
+	unsigned id = m_tids.size();
+	m_tids[std::this_thread::get_id()] = id;
+	return id;
+      }
+
+      long long micros(clock_t::time_point t) const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(t - m_start).count();
+      }
+
+      void begin_event() {
+	m_os << (m_first ? "\n" : ",\n");
+	m_first = false;
+      }
+
+    public:
+
+      tracer(const std::string &file, unsigned sample_ms)
+	: m_os(file), m_start(clock_t::now()), m_first(true), m_stop(false) {
+	if (!m_os) return;
+	m_os << "{\"traceEvents\":[";
+	if (sample_ms > 0) {
+	  m_sampler = std::thread([this, sample_ms]() {
+	      std::unique_lock<std::mutex> lock(m_sampler_mutex);
+	      while (!m_stop) {
+		counter("rss_mb", rss_mb());
+		m_sampler_cv.wait_for(lock, std::chrono::milliseconds(sample_ms));
+	      }
+	    });
+	}
+      }
+
+      ~tracer() {
+	{ std::lock_guard<std::mutex> lock(m_sampler_mutex);
+	  m_stop = true;
+	}
+	m_sampler_cv.notify_all();
+	if (m_sampler.joinable()) m_sampler.join();
+	if (!m_os) return;
+	counter("rss_mb", rss_mb());
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+      }
+
+      bool good() const { return (bool) m_os; }
+
+      // duration event of the calling thread
+      void complete(const std::string &name, const std::string &fn,
+		    const std::string &dom,
+		    clock_t::time_point start, clock_t::time_point end) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	begin_event();
+	m_os << "{\"name\":";
+	write_json_string(m_os, name);
+	m_os << ",\"cat\":\"crab\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid()
+	     << ",\"ts\":" << micros(start)
+	     << ",\"dur\":" << micros(end) - micros(start)
+	     << ",\"args\":{";
+	bool sep = false;
+	if (!fn.empty()) {
+	  m_os << "\"function\":";
+	  write_json_string(m_os, fn);
+	  sep = true;
+	}
+	if (!dom.empty()) {
+	  m_os << (sep ? "," : "") << "\"domain\":";
+	  write_json_string(m_os, dom);
+	}
+	m_os << "}}";
+      }
+
+      void counter(const std::string &name, double value) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	begin_event();
+	m_os << "{\"name\":";
+	write_json_string(m_os, name);
+	m_os << ",\"ph\":\"C\",\"pid\":0,\"ts\":" << micros(clock_t::now())
+	     << ",\"args\":{\"value\":" << value << "}}";
+      }
+    };
+
+    inline std::unique_ptr<tracer>& get_tracer() {
+      static std::unique_ptr<tracer> t;
+      return t;
+    }
+
+    // domain of the analysis run by the calling thread
+    inline std::string& current_domain() {
+      static thread_local std::string dom;
+      return dom;
+    }
+  }
+
+  // Start writing the timeline in file. The RSS is sampled every
+  // sample_ms milliseconds (0: never). Return false if file cannot be
+  // opened. The timeline is closed by stop_trace or at exit so the
+  // passes running after the analysis (e.g., the instrumentation) are
+  // also traced.
+  inline bool start_trace(const std::string &file, unsigned sample_ms = 100) {
+    std::unique_ptr<trace_impl::tracer> t(new trace_impl::tracer(file, sample_ms));
+    if (!t->good()) return false;
+    trace_impl::get_tracer() = std::move(t);
+    return true;
+  }
+
+  // Close the timeline. All the scopes must have been destroyed.
+  inline void stop_trace() {
+    trace_impl::get_tracer().reset();
+  }
+
+  inline bool is_tracing() {
+    return (bool) trace_impl::get_tracer();
+  }
+
+  /*
+   * Duration event from the construction to the destruction of the
+   * scope, tagged with the function being analyzed and the domain set
+   * by the enclosing trace_domain, if any. It only reads the clock if
+   * the timeline is enabled.
+   */
+  class trace_scope {
+    bool m_enabled;
+    std::string m_name;
+    std::string m_fn;
+    trace_impl::clock_t::time_point m_start;
+
+  public:
+
+    explicit trace_scope(llvm::StringRef name, llvm::StringRef fn = "")
+      : m_enabled(is_tracing()) {
+      if (!m_enabled) return;
+      m_name = name.str();
+      m_fn = fn.str();
+      m_start = trace_impl::clock_t::now();
+    }
+
+    ~trace_scope() {
+      if (!m_enabled || !is_tracing()) return;
+      trace_impl::get_tracer()->complete(m_name, m_fn, trace_impl::current_domain(),
+					 m_start, trace_impl::clock_t::now());
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+  };
+
+  // The trace scopes of the calling thread are tagged with dom while
+  // this object is alive.
+  class trace_domain {
+    bool m_enabled;
+    std::string m_old;
+
+  public:
+
+    explicit trace_domain(const std::string &dom)
+      : m_enabled(is_tracing()) {
+      if (!m_enabled) return;
+      m_old = trace_impl::current_domain();
+      trace_impl::current_domain() = dom;
+    }
+
+    ~trace_domain() {
+      if (m_enabled) trace_impl::current_domain() = m_old;
+    }
+
+    trace_domain(const trace_domain&) = delete;
+    trace_domain& operator=(const trace_domain&) = delete;
+  };
+}
+#endif
@@ -0,0 +1,87 @@
+#ifndef __VAR_REGISTRY_HH_
+#define __VAR_REGISTRY_HH_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace crab_llvm {
+
+  /*
+   * Crab variables by index in the variable factory. Domains that
+   * identify variables by their index (dense_interval_domain,
+   * native_wrapped_interval_domain and
+   * bitset_boolean_numerical_domain) only need the variables to
+   * print the values and to convert them into linear constraints.
+   * The registry is shared by all the abstract values.
+   *
+   * add is called each time a variable gets a non-top value so each
+   * thread remembers the variables it already added and only takes
+   * the lock for the new ones.
+   */
+  template<typename Variable>
+  class var_registry {
+    std::mutex m_mutex;
+    std::vector<const Variable*> m_vars;
+    std::deque<Variable> m_storage;
+    // number of variables replaced by another one with the same index
+    std::atomic<unsigned> m_replaced;
+
+    var_registry(): m_replaced(0) {}
+
+  public:
+
+    static var_registry& get() {
+      static var_registry r;
+      return r;
+    }
+
+    void add(const Variable &v) {
+      // -- variables added by this thread. The stored variables are
+      //    never removed so the pointers stay valid. The cache is
+      //    dropped if another variable took the index of one of them.
+      struct thread_cache {
+	std::vector<const Variable*> vars;
+	unsigned replaced;
+	thread_cache(): replaced(0) {}
+      };
+      static thread_local thread_cache added;
+      std::size_t i = v.index();
+      unsigned replaced = m_replaced.load(std::memory_order_acquire);
+      if (added.replaced != replaced) {
+	added.vars.clear();
+	added.replaced = replaced;
+      }
+      if (i < added.vars.size() && added.vars[i] && *added.vars[i] == v) {
+	return;
+      }
+      
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (i >= m_vars.size()) {
+	m_vars.resize(i + 1, nullptr);
+      }
+      // a new factory may reuse the index
+      if (!m_vars[i] || !(*m_vars[i] == v)) {
+	if (m_vars[i]) {
+	  m_replaced.fetch_add(1, std::memory_order_release);
+	}
+	m_storage.push_back(v);
+	m_vars[i] = &m_storage.back();
+      }
+      if (i >= added.vars.size()) {
+	added.vars.resize(i + 1, nullptr);
+      }
+      added.vars[i] = m_vars[i];
+    }
+
+    // Return null if there is no variable with index i
+    const Variable* find(std::size_t i) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return (i < m_vars.size() ? m_vars[i] : nullptr);
+    }
+  };
+
+} // end namespace crab_llvm
+#endif
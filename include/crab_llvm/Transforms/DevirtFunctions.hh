@@ -14,6 +14,7 @@ class Module;
 class Function;
 class CallSite;
 class PointerType;
+class FunctionType;
 class CallGraph;
 } // namespace llvm
 
@@ -153,6 +154,11 @@ private:
   // allow creating of indirect calls during devirtualization
   // (required for soundness)
   bool m_allowIndirectCalls;
+  // callsites with more targets than this number are replaced with a
+  // call to an external function. If 0 then unlimited.
+  unsigned m_maxBounceTargets;
+  // -- map bounce type to its external function
+  llvm::DenseMap<llvm::FunctionType *, llvm::Function *> m_havoc_map;
 
   // Worklist of call sites to transform
   llvm::SmallVector<llvm::Instruction *, 32> m_worklist;
@@ -160,6 +166,7 @@ private:
   // for stats
   unsigned m_num_indirect_calls;
   unsigned m_num_resolved_calls;
+  unsigned m_num_havoc_calls;
   
   /// turn the indirect call-site into a direct one
   void mkDirectCall(llvm::CallSite CS, CallSiteResolver *CSR);
@@ -167,8 +174,13 @@ private:
   /// create a bounce function that calls functions directly
   llvm::Function *mkBounceFn(llvm::CallSite &CS, CallSiteResolver *CSR);
 
+  /// return an external function with the type of the bounce
+  /// function of CS
+  llvm::Function *mkHavocFn(llvm::CallSite &CS);
+
 public:
-  DevirtualizeFunctions(llvm::CallGraph *cg, bool allowIndirectCalls);
+  DevirtualizeFunctions(llvm::CallGraph *cg, bool allowIndirectCalls,
+			unsigned maxBounceTargets = 0);
 
   ~DevirtualizeFunctions();
   
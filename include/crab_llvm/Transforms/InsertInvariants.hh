@@ -3,7 +3,9 @@
 
 /* 
  * Instrument LLVM bitecode by inserting invariants computed by
- * crab. The invariants are inserted as verifier.assume instructions.
+ * crab. The invariants are inserted as verifier.assume instructions
+ * or attached as !crab.inv metadata to calls to crab.inv
+ * (--crab-add-invariants-metadata).
  */
 
 #include "llvm/Pass.h"
@@ -13,28 +15,62 @@ namespace llvm {
   class Function;
   class Module;
   class CallGraph;
+  class LoadInst;
 }
 
 namespace crab_llvm {
 
+  struct CodeExpander;
+  struct InstrumentationPlan;
+  class CrabLlvmPass;
+  
   class InsertInvariants : public llvm::ModulePass {
 
     llvm::Function* m_assumeFn;
+    // marker function of the metadata
+    llvm::Function* m_invFn;
 
     // TODO: move this to InsertInvariants.cc so this header file does
     // not expose crab_llvm/crab_cfg.hh
     bool instrument_entries (lin_cst_sys_t csts, llvm::BasicBlock* bb, 
-                             llvm::LLVMContext &ctx, llvm::CallGraph* cg);
+                             llvm::LLVMContext &ctx, llvm::CallGraph* cg,
+                             CodeExpander &g);
       
+    bool instrument_load (lin_cst_sys_t csts, const llvm::LoadInst* I,
+                          llvm::LLVMContext &ctx, llvm::CallGraph* cg);
+
     template<typename AbsDomain> 
-    bool instrument_loads (AbsDomain pre, basic_block_t& bb,  
-                           llvm::LLVMContext& ctx, llvm::CallGraph* cg);
+    void collect_loads (const AbsDomain &pre, basic_block_t& bb,  
+                        InstrumentationPlan &plan);
+
+    // calls collect_loads with the domain of a wrapper
+    struct load_collector;
+
+    // Compute the constraints to be inserted in F without modifying
+    // it. It can be called concurrently for different functions.
+    void collect (CrabLlvmPass &crab, llvm::Function &F, InstrumentationPlan &plan);
+
+    // Insert in F the constraints computed by collect
+    bool apply (llvm::Function &F, InstrumentationPlan &plan, llvm::CallGraph* cg);
 
   public:
     
     static char ID;        
     
-    InsertInvariants (): llvm::ModulePass (ID), m_assumeFn (0) {} 
+    InsertInvariants (): llvm::ModulePass (ID), m_assumeFn (0), m_invFn (0) {} 
+
+    // Declare verifier.assume in M. Return false if no invariants
+    // are inserted (--crab-add-invariants=none).
+    bool initialize (llvm::Module &M, llvm::CallGraph* cg);
+
+    // Insert the invariants of F without running the pass (e.g., to
+    // instrument each function as soon as it is analyzed). cg can be
+    // null.
+    bool instrument (CrabLlvmPass &crab, llvm::Function &F, llvm::CallGraph* cg);
+
+    // Whether the invariants are attached as metadata so the
+    // verifier.assume cleanup passes are not needed.
+    static bool usesMetadata ();
 
     virtual bool runOnModule (llvm::Module& M);
 
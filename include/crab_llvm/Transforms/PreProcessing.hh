@@ -0,0 +1,112 @@
+#ifndef __PRE_PROCESSING_HH_
+#define __PRE_PROCESSING_HH_
+
+/* 
+ * The pipeline of crabllvm-pp. It is shared by crabllvm-pp and by
+ * crabllvm --with-pp so that the preprocessing and the analysis can
+ * run in the same pass manager without writing bitcode in between.
+ */
+
+#include <climits>
+#include <vector>
+
+namespace llvm {
+  class Module;
+  namespace legacy {
+    class PassManager;
+  }
+}
+
+namespace crab_llvm {
+
+  struct PreProcessingOptions {
+    bool inline_all;
+    // inline only when callers stay below inline_budget instructions
+    // (0: disabled)
+    unsigned inline_budget;
+    bool devirtualize;
+    bool lower_select;
+    // lower only the selects that flow into assertions or loop guards
+    bool lower_relevant_select;
+    bool lower_gv;
+    bool externalize_addr_taken_funcs;
+    bool lower_unsigned_icmp;
+    bool optimize_loops;
+    bool turn_undef_nondet;
+    // thresholds for ScalarReplAggregates
+    int sroa_threshold;
+    int sroa_struct_mem_threshold;
+    int sroa_array_element_threshold;
+    int sroa_scalar_load_threshold;
+    // functions that are not internalized (only main if empty)
+    std::vector<const char*> export_list;
+    
+    PreProcessingOptions()
+      : inline_all(false), inline_budget(0), devirtualize(false), lower_select(false),
+	lower_relevant_select(false),
+	lower_gv(true), externalize_addr_taken_funcs(false),
+	lower_unsigned_icmp(false), optimize_loops(false),
+	turn_undef_nondet(false),
+	sroa_threshold(INT_MAX), sroa_struct_mem_threshold(INT_MAX),
+	sroa_array_element_threshold(INT_MAX), sroa_scalar_load_threshold(-1) {}
+  };
+
+  // Add the passes of crabllvm-pp to pass_manager. The last pass
+  // records in the module the normalizations that have been applied.
+  void addPreProcessingPasses(llvm::legacy::PassManager &pass_manager,
+			      const PreProcessingOptions &opts);
+
+  // Whether opts inline functions. The inliner needs the whole module
+  // so the pipeline cannot be split into partitions of the module.
+  bool needsInlining(const PreProcessingOptions &opts);
+
+  /*
+   * The same pipeline as addPreProcessingPasses split in three parts
+   * (only if !needsInlining(opts)): the interprocedural passes that
+   * run first on the whole module, the passes that transform each
+   * function independently (they can run on partitions of the module)
+   * and the final passes on the whole module again. The last pass
+   * records the normalizations as addPreProcessingPasses does.
+   */
+  void addPreProcessingModulePasses(llvm::legacy::PassManager &pass_manager,
+				    const PreProcessingOptions &opts);
+  void addPreProcessingFunctionPasses(llvm::legacy::PassManager &pass_manager,
+				      const PreProcessingOptions &opts);
+  void addPreProcessingFinalPasses(llvm::legacy::PassManager &pass_manager,
+				   const PreProcessingOptions &opts);
+
+  /*
+   * Normalizations required by the analysis. crabllvm only runs the
+   * ones that are not recorded in the module (module flag
+   * "crab-llvm.normalized") so bitcode produced by crabllvm-pp is not
+   * normalized twice.
+   */
+  enum normalization_t {
+    // Internalize + GlobalDCE + RemoveUnreachableBlocks
+    NORM_INTERNALIZE    = 1 << 0,
+    // Mem2Reg
+    NORM_MEM2REG        = 1 << 1,
+    // LowerInvoke + SimplifyCFG
+    NORM_LOWER_INVOKE   = 1 << 2,
+    // UnifyFunctionExitNodes + RemoveUnreachableBlocks
+    NORM_UNIFY_EXITS    = 1 << 3,
+    // LowerSwitch + SimplifyCFG
+    NORM_LOWER_SWITCH   = 1 << 4,
+    // LowerCstExpr + DCE
+    NORM_LOWER_CST_EXPR = 1 << 5,
+    // NondetInit + DeadNondetElim
+    NORM_UNDEF_NONDET   = 1 << 6,
+    NORM_ALL            = (1 << 7) - 1
+  };
+
+  // Return the normalizations applied by addPreProcessingPasses with opts
+  unsigned getPreProcessingNormalizations(const PreProcessingOptions &opts);
+  
+  // Return the normalizations recorded in M (0 if none)
+  unsigned getNormalizations(const llvm::Module &M);
+
+  // Record in M that the normalizations norms have been applied
+  void setNormalizations(llvm::Module &M, unsigned norms);
+}
+
+#endif
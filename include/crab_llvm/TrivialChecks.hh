@@ -0,0 +1,321 @@
+#pragma once
+
+/**
+ * Assertions decided by constant propagation on the crab CFG
+ * (--crab-discharge-trivial-checks). The outcome is the same as
+ * the one of the assertion checker with any domain that keeps the
+ * constants: safe if the constraint holds for the constant values
+ * of its variables or the assertion is unreachable, and an error
+ * (a warning if the constraint is a contradiction) if it does not
+ * hold and some path reaches it along which all the assumptions
+ * hold. The other assertions are left to the analysis.
+ **/
+
+#include "crab_llvm/crab_cfg.hh"
+#include "crab_llvm/Support/Stats.hh"
+#include "crab/checkers/base_property.hpp"
+
+#include <boost/optional.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace crab_llvm {
+namespace trivial_impl {
+
+  template<typename CFG>
+  class const_dataflow {
+    typedef typename CFG::basic_block_label_t label_t;
+    typedef typename CFG::statement_t stmt_t;
+    typedef typename CFG::variable_t variable_t;
+    typedef typename CFG::basic_block_t::assert_t assert_t;
+    typedef number_t N;
+    typedef varname_t V;
+    typedef boost::optional<N> value_t;
+
+    // -- the constant value of each numerical variable (none if
+    //    unknown) followed by an extra element so that it is only
+    //    empty if unreachable. must is set if the state is reached
+    //    along a path whose assumptions all hold.
+    struct state_t {
+      std::vector<value_t> vals;
+      bool must;
+      state_t(): must(false) {}
+      bool operator==(const state_t &o) const {
+	return must == o.must && vals == o.vals;
+      }
+      bool operator!=(const state_t &o) const { return !(*this == o); }
+    };
+
+    CFG m_cfg;
+    std::vector<label_t> m_blocks;
+    std::map<label_t, unsigned> m_block_ids;
+    std::map<variable_t, unsigned> m_var_ids;
+    std::vector<state_t> m_pre;
+
+    class transfer: public crab::cfg::statement_visitor<N,V> {
+      const_dataflow &m_df;
+      state_t &m_s;
+
+      value_t val(const variable_t &v) const {
+	auto it = m_df.m_var_ids.find(v);
+	return (it == m_df.m_var_ids.end() ? value_t() : m_s.vals[it->second]);
+      }
+
+      void set(const variable_t &v, value_t x) {
+	auto it = m_df.m_var_ids.find(v);
+	if (it != m_df.m_var_ids.end()) m_s.vals[it->second] = x;
+      }
+
+      value_t eval(const lin_exp_t &e) const {
+	N res = e.constant();
+	for (auto t: e) {
+	  value_t x = val(t.second);
+	  if (!x) return value_t();
+	  res += t.first * (*x);
+	}
+	return res;
+      }
+
+      // 1 if cst holds, 0 if it does not hold and -1 if unknown
+      int eval(const lin_cst_t &cst) const {
+	if (cst.is_tautology()) return 1;
+	if (cst.is_contradiction()) return 0;
+	value_t x = eval(cst.expression());
+	if (!x) return -1;
+	if (cst.is_equality()) return *x == N(0);
+	if (cst.is_inequality()) return *x <= N(0);
+	if (cst.is_disequation()) return *x != N(0);
+	return -1;
+      }
+
+      void assume(const lin_cst_t &cst) {
+	switch (eval(cst)) {
+	case 1: break;
+	case 0: m_s.vals.clear(); break;
+	default:
+	  m_s.must = false;
+	  // -- x == k
+	  if (cst.is_equality() && cst.expression().size() == 1) {
+	    auto t = *cst.expression().begin();
+	    if (t.first == N(1)) set(t.second, -cst.expression().constant());
+	    else if (t.first == N(-1)) set(t.second, cst.expression().constant());
+	  }
+	}
+      }
+
+     public:
+      bool handled;
+
+      transfer(const_dataflow &df, state_t &s)
+	: m_df(df), m_s(s), handled(false) {}
+
+      // -- the outcome of a (see the comment of trivial_impl)
+      bool decide(const assert_t &a, crab::checker::check_kind_t &k) {
+	if (m_s.vals.empty()) {
+	  k = crab::checker::_SAFE;
+	  return true;
+	}
+	int holds = eval(a.constraint());
+	if (holds == 1) {
+	  k = crab::checker::_SAFE;
+	  return true;
+	} else if (holds == 0 && m_s.must) {
+	  k = (a.constraint().is_contradiction() ? crab::checker::_WARN : crab::checker::_ERR);
+	  return true;
+	}
+	return false;
+      }
+
+      void visit(crab::cfg::binary_op<N,V> &s) {
+	handled = true;
+	value_t x = eval(s.left());
+	value_t y = eval(s.right());
+	value_t z;
+	if (x && y) {
+	  switch (s.op()) {
+	  case crab::BINOP_ADD: z = *x + *y; break;
+	  case crab::BINOP_SUB: z = *x - *y; break;
+	  case crab::BINOP_MUL: z = *x * *y; break;
+	  default: break;
+	  }
+	}
+	set(s.lhs(), z);
+      }
+      void visit(crab::cfg::assignment<N,V> &s) {
+	handled = true;
+	set(s.lhs(), eval(s.rhs()));
+      }
+      void visit(crab::cfg::assume_stmt<N,V> &s) {
+	handled = true;
+	assume(s.constraint());
+      }
+      void visit(crab::cfg::assert_stmt<N,V> &s) {
+	handled = true;
+	assume(s.constraint());
+      }
+      void visit(crab::cfg::unreachable_stmt<N,V> &) {
+	handled = true;
+	m_s.vals.clear();
+      }
+    };
+
+    // Apply the statements of the block i to s. The decided
+    // assertions are added to decided (if not null).
+    void apply(unsigned i, state_t &s,
+	       std::vector<std::pair<const assert_t*, crab::checker::check_kind_t>> *decided) {
+      for (auto &st: m_cfg.get_node(m_blocks[i])) {
+	if (s.vals.empty() && !decided) return;
+	transfer vis(*this, s);
+	if (decided && st.is_assert()) {
+	  const assert_t &a = static_cast<const assert_t&>(st);
+	  crab::checker::check_kind_t k;
+	  if (vis.decide(a, k)) decided->push_back(std::make_pair(&a, k));
+	}
+	if (s.vals.empty()) continue;
+	st.accept(&vis);
+	if (vis.handled || s.vals.empty()) continue;
+	const typename stmt_t::live_t &ls = st.get_live();
+	for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	  auto it = m_var_ids.find(v);
+	  if (it != m_var_ids.end()) s.vals[it->second] = value_t();
+	}
+      }
+    }
+
+    static void join(state_t &dst, const state_t &src) {
+      if (src.vals.empty()) return;
+      if (dst.vals.empty()) {
+	dst = src;
+	return;
+      }
+      for (unsigned k = 0, n = dst.vals.size(); k < n; ++k) {
+	if (dst.vals[k] != src.vals[k]) dst.vals[k] = value_t();
+      }
+      dst.must |= src.must;
+    }
+
+   public:
+
+    explicit const_dataflow(CFG cfg): m_cfg(cfg) {
+      // -- number blocks in reverse post-order from the entry.
+      //    Unreachable blocks go last.
+      std::vector<std::pair<label_t, std::vector<label_t>>> stack;
+      auto push = [&](const label_t &bl) {
+	m_block_ids.insert(std::make_pair(bl, UINT_MAX));
+	std::vector<label_t> succs;
+	for (auto s: cfg.next_nodes(bl)) succs.push_back(s);
+	stack.push_back(std::make_pair(bl, std::move(succs)));
+      };
+      push(cfg.entry());
+      while (!stack.empty()) {
+	std::vector<label_t> &succs = stack.back().second;
+	if (succs.empty()) {
+	  m_blocks.push_back(stack.back().first);
+	  stack.pop_back();
+	  continue;
+	}
+	label_t s = succs.back();
+	succs.pop_back();
+	if (m_block_ids.count(s) == 0) push(s);
+      }
+      std::reverse(m_blocks.begin(), m_blocks.end());
+      for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+	if (m_block_ids.insert(std::make_pair(bl, UINT_MAX)).second) m_blocks.push_back(bl);
+      }
+      unsigned num_blocks = m_blocks.size();
+      for (unsigned i = 0; i < num_blocks; ++i) m_block_ids[m_blocks[i]] = i;
+
+      // -- number the numerical variables
+      auto is_num = [](const variable_t &v) {
+	return v.get_type() == crab::INT_TYPE || v.get_type() == crab::UNK_TYPE;
+      };
+      for (auto &bl: m_blocks) {
+	for (auto &s: cfg.get_node(bl)) {
+	  const typename stmt_t::live_t &ls = s.get_live();
+	  for (auto v: boost::make_iterator_range(ls.uses_begin(), ls.uses_end())) {
+	    if (is_num(v)) m_var_ids.insert(std::make_pair(v, m_var_ids.size()));
+	  }
+	  for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	    if (is_num(v)) m_var_ids.insert(std::make_pair(v, m_var_ids.size()));
+	  }
+	}
+      }
+
+      // -- forward fixpoint. The variables are unknown at the entry,
+      //    which is always reached. The lattice of each variable is
+      //    flat so it terminates without widening.
+      m_pre.assign(num_blocks, state_t());
+      if (num_blocks == 0) return;
+      m_pre[0].vals.assign(m_var_ids.size() + 1, value_t());
+      m_pre[0].must = true;
+      std::set<unsigned> worklist;
+      worklist.insert(0);
+      while (!worklist.empty()) {
+	unsigned i = *worklist.begin();
+	worklist.erase(worklist.begin());
+	state_t post(m_pre[i]);
+	apply(i, post, nullptr);
+	if (post.vals.empty()) continue;
+	for (auto s: cfg.next_nodes(m_blocks[i])) {
+	  unsigned j = m_block_ids[s];
+	  state_t old(m_pre[j]);
+	  join(m_pre[j], post);
+	  if (m_pre[j] != old) worklist.insert(j);
+	}
+      }
+    }
+
+    // The assertions that can be decided and their outcome
+    std::vector<std::pair<const assert_t*, crab::checker::check_kind_t>> decide() {
+      std::vector<std::pair<const assert_t*, crab::checker::check_kind_t>> decided;
+      for (unsigned i = 0, n = m_blocks.size(); i < n; ++i) {
+	state_t s(m_pre[i]);
+	apply(i, s, &decided);
+      }
+      return decided;
+    }
+  };
+
+  // Remove from cfg the assertions decided by constant propagation
+  // and add their outcome to checks. Return true if cfg has no
+  // other assertion.
+  template<typename CFG>
+  bool discharge(CFG &cfg, crab::checker::checks_db &checks, unsigned verbose) {
+    typedef typename CFG::statement_t stmt_t;
+    const_dataflow<cfg_ref_t> df(cfg);
+    auto decided = df.decide();
+    std::set<const stmt_t*> removed;
+    for (auto &kv: decided) {
+      const stmt_t *s = kv.first;
+      if (verbose >= 2 && kv.second != crab::checker::_SAFE) {
+	crab::outs() << (kv.second == crab::checker::_ERR ? "Error: assertion violation "
+							  : "Warning: possible assertion violation ")
+		     << *s << "\n";
+      }
+      checks.add(kv.second, s->get_debug_info());
+      removed.insert(s);
+      count_stat("CrabLlvm.count.discharged_checks");
+    }
+    bool others = false;
+    for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+      auto &b = cfg.get_node(bl);
+      std::vector<stmt_t*> to_remove;
+      for (auto &s: b) {
+	if (removed.count(&s)) {
+	  to_remove.push_back(&s);
+	} else if (s.is_assert() || s.is_ptr_assert() || s.is_bool_assert()) {
+	  others = true;
+	}
+      }
+      for (stmt_t *s: to_remove) {
+	b.remove(s);
+      }
+    }
+    return !others;
+  }
+
+} // end namespace trivial_impl
+} // end namespace crab_llvm
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/HeapAbstraction.hh"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <tuple>
+
+namespace llvm {
+  class Module;
+  class Function;
+  class Value;
+  class CallInst;
+  class Type;
+  class StructType;
+  class DataLayout;
+}
+
+namespace crab_llvm {
+
+  /*
+   * Heap abstraction that does not run any pointer analysis. The
+   * region of a pointer only depends on the type of the memory it
+   * points to: fields of structs are split by struct type and byte
+   * offset and the rest of integer cells are split by bitwidth. The
+   * regions are computed by one linear pass over the module so it is
+   * meant for fast triage: it trusts the types of the program (as
+   * with strict aliasing) rather than proving that two regions cannot
+   * alias.
+   *
+   * A field falls back to the region of its integer type if its
+   * address is used by something else than loads, stores and GEPs or
+   * if its struct is cast from/to another type.
+   */
+  class TypeHeapAbstraction: public HeapAbstraction {
+
+   public:
+
+     using typename HeapAbstraction::region_t;
+     using typename HeapAbstraction::region_set_t;
+
+   private:
+
+    // (struct type or null, byte offset inside the struct, bitwidth)
+    typedef std::tuple<const llvm::StructType*, uint64_t, unsigned> cell_key_t;
+
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_accessed;
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_mods;
+    llvm::DenseMap<const llvm::Function*, region_set_t> m_func_onlyreads;
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_accessed;
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_mods;
+    llvm::DenseMap<const llvm::CallInst*, region_set_t> m_callsite_onlyreads;
+    // returned for functions and callsites without regions and for
+    // all the new regions: types do not tell which objects are only
+    // reachable from the return value.
+    region_set_t m_empty_set;
+
+    const llvm::DataLayout& m_dl;
+    // structs whose fields are not split
+    llvm::DenseSet<const llvm::StructType*> m_collapsed_structs;
+    // fields whose address is taken
+    std::set<cell_key_t> m_collapsed_fields;
+    std::map<cell_key_t, int> m_ids;
+    // Queries can assign new ids so they are serialized to allow
+    // building CFGs from several threads.
+    mutable std::mutex m_mutex;
+
+    // return false if V is not a pointer to an integer cell
+    bool computeKey(const llvm::Value *V, cell_key_t &key) const;
+
+    // collapse the structs and fields whose regions are not reliable
+    void collapse(llvm::Module &M);
+
+    // compute the read and mod regions of each function and callsite
+    void cacheReadModRegions(llvm::Module &M);
+
+   public:
+
+    TypeHeapAbstraction(llvm::Module &M, const llvm::DataLayout &dl);
+
+    virtual region_t getRegion(const llvm::Function &F, llvm::Value *V) override;
+
+    virtual const llvm::Value* getSingleton(int region) const override;
+
+    virtual const region_set_t& getAccessedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getOnlyReadRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getModifiedRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getNewRegions(const llvm::Function &F) override;
+
+    virtual const region_set_t& getAccessedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getOnlyReadRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getModifiedRegions(llvm::CallInst &I) override;
+
+    virtual const region_set_t& getNewRegions(llvm::CallInst &I) override;
+
+    virtual llvm::StringRef getName() const override {
+      return "TypeHeapAbstraction";
+    }
+  };
+
+} // end namespace crab_llvm
@@ -0,0 +1,664 @@
+#ifndef __BITSET_BOOLEAN_DOMAIN_HH__
+#define __BITSET_BOOLEAN_DOMAIN_HH__
+
+#include "crab/config.h"
+#include "crab/common/types.hpp"
+#include "crab/domains/abstract_domain.hpp"
+#include "crab/domains/intervals.hpp"
+#include "crab_llvm/Support/VarRegistry.hh"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Reduced product of a flat boolean domain with a numerical domain
+ * (same semantics as crab::domains::flat_boolean_numerical_domain).
+ *
+ * The flat boolean value of each variable (true, false or top) is
+ * stored as two bitsets indexed by the variable factory index: a bit
+ * is set in m_true (m_false) if the variable is known to be true
+ * (false). Join and meet are then word-parallel AND and OR.
+ *
+ * A boolean variable defined by a linear constraint (b := cst) is
+ * linked to its constraint so that assume(b) adds the constraint to
+ * the numerical domain. The links are only created by such
+ * assignments so the domain costs nothing else if the CFG does not
+ * have them. A link is removed as soon as a variable of its
+ * constraint is modified.
+ */
+
+namespace crab_llvm {
+
+  template<typename NumDom>
+  class bitset_boolean_numerical_domain:
+    public crab::domains::abstract_domain<typename NumDom::number_t,
+					  typename NumDom::varname_t,
+					  bitset_boolean_numerical_domain<NumDom>> {
+  public:
+
+    typedef typename NumDom::number_t number_t;
+    typedef typename NumDom::varname_t varname_t;
+    typedef bitset_boolean_numerical_domain<NumDom> bool_num_domain_t;
+    typedef crab::domains::abstract_domain<number_t, varname_t,
+					   bool_num_domain_t> abstract_domain_t;
+    using typename abstract_domain_t::linear_expression_t;
+    using typename abstract_domain_t::linear_constraint_t;
+    using typename abstract_domain_t::linear_constraint_system_t;
+    using typename abstract_domain_t::variable_t;
+    using typename abstract_domain_t::variable_vector_t;
+    using typename abstract_domain_t::pointer_constraint_t;
+    typedef ikos::interval<number_t> interval_t;
+
+  private:
+
+    typedef var_registry<variable_t> registry_t;
+    typedef boost::shared_ptr<const linear_constraint_system_t> csts_ptr;
+    // links by index of the boolean variable. Two values share a
+    // link if it was created by the same assignment.
+    typedef std::map<std::size_t, csts_ptr> links_t;
+
+    typedef enum { BOOL_TOP, BOOL_TRUE, BOOL_FALSE } bool_value_t;
+
+    static const std::size_t word_bits = 64;
+
+    bool m_is_bottom;
+    // index of the first word
+    std::size_t m_base;
+    std::vector<uint64_t> m_true;
+    std::vector<uint64_t> m_false;
+    links_t m_links;
+    NumDom m_num;
+
+    bitset_boolean_numerical_domain(bool is_bottom, NumDom num)
+      : m_is_bottom(is_bottom), m_base(0), m_num(num) {}
+
+    std::size_t end() const { return m_base + m_true.size(); }
+
+    // False if no boolean is known and there are no links: the value
+    // is then only its numerical part. This is the common case for
+    // functions without booleans, so the lattice operations skip the
+    // boolean layer.
+    bool has_bools() const { return !m_true.empty() || !m_links.empty(); }
+
+    // Extend the bitsets so they cover the words [first, last). The
+    // new words are top.
+    void extend(std::size_t first, std::size_t last) {
+      if (m_true.empty()) {
+	m_base = first;
+	m_true.assign(last - first, 0);
+	m_false.assign(last - first, 0);
+	return;
+      }
+      if (first < m_base) {
+	std::size_t n = m_base - first;
+	m_true.insert(m_true.begin(), n, 0);
+	m_false.insert(m_false.begin(), n, 0);
+	m_base = first;
+      }
+      if (last > end()) {
+	m_true.resize(last - m_base, 0);
+	m_false.resize(last - m_base, 0);
+      }
+    }
+
+    // Make both values cover the same words
+    void align(bool_num_domain_t &o) {
+      if (m_true.empty() && o.m_true.empty()) return;
+      std::size_t first, last;
+      if (m_true.empty()) {
+	first = o.m_base; last = o.end();
+      } else if (o.m_true.empty()) {
+	first = m_base; last = end();
+      } else {
+	first = std::min(m_base, o.m_base);
+	last = std::max(end(), o.end());
+      }
+      extend(first, last);
+      o.extend(first, last);
+    }
+
+    bool_value_t get_bool(std::size_t i) const {
+      std::size_t w = i / word_bits;
+      if (w < m_base || w >= end()) return BOOL_TOP;
+      uint64_t mask = ((uint64_t) 1) << (i % word_bits);
+      if (m_true[w - m_base] & mask) return BOOL_TRUE;
+      if (m_false[w - m_base] & mask) return BOOL_FALSE;
+      return BOOL_TOP;
+    }
+
+    void set_bool(const variable_t &v, bool_value_t val) {
+      std::size_t i = v.index();
+      std::size_t w = i / word_bits;
+      if (val == BOOL_TOP && (w < m_base || w >= end())) return;
+      if (val != BOOL_TOP) {
+	registry_t::get().add(v);
+	extend(m_true.empty() ? w : std::min(w, m_base),
+	       m_true.empty() ? w + 1 : std::max(w + 1, end()));
+      }
+      uint64_t mask = ((uint64_t) 1) << (i % word_bits);
+      m_true[w - m_base] &= ~mask;
+      m_false[w - m_base] &= ~mask;
+      if (val == BOOL_TRUE) m_true[w - m_base] |= mask;
+      if (val == BOOL_FALSE) m_false[w - m_base] |= mask;
+    }
+
+    static bool_value_t negate(bool_value_t val) {
+      switch (val) {
+      case BOOL_TRUE:  return BOOL_FALSE;
+      case BOOL_FALSE: return BOOL_TRUE;
+      default:         return BOOL_TOP;
+      }
+    }
+
+    static bool mentions(const linear_constraint_system_t &csts, const variable_t &x) {
+      for (auto const &cst: csts) {
+	for (auto t: cst.expression()) {
+	  if (t.second == x) return true;
+	}
+      }
+      return false;
+    }
+
+    // x has been modified so its links are not valid anymore
+    void invalidate(const variable_t &x) {
+      if (m_links.empty()) return;
+      m_links.erase(x.index());
+      for (auto it = m_links.begin(); it != m_links.end(); ) {
+	if (mentions(*(it->second), x)) {
+	  it = m_links.erase(it);
+	} else {
+	  ++it;
+	}
+      }
+    }
+
+    void check_num_bottom() {
+      if (m_num.is_bottom()) {
+	set_to_bottom();
+      }
+    }
+
+    // Join of the booleans of this and o. num is the numerical part
+    // of the result.
+    bool_num_domain_t join_bools(bool_num_domain_t &o, NumDom num) const {
+      if (!has_bools() || !o.has_bools()) {
+	// -- all the booleans of one side are top
+	return bool_num_domain_t(false, num);
+      }
+      bool_num_domain_t res(false, num);
+      res.m_base = m_base;
+      res.m_true = m_true;
+      res.m_false = m_false;
+      res.align(o);
+      uint64_t *t = res.m_true.data(), *f = res.m_false.data();
+      const uint64_t *ot = o.m_true.data(), *of = o.m_false.data();
+      std::size_t n = res.m_true.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	t[k] &= ot[k];
+	f[k] &= of[k];
+      }
+      // -- only the links of both values
+      for (auto &kv: m_links) {
+	auto it = o.m_links.find(kv.first);
+	if (it != o.m_links.end() && it->second == kv.second) {
+	  res.m_links.insert(kv);
+	}
+      }
+      return res;
+    }
+
+    // Meet of the booleans of this and o. num is the numerical part
+    // of the result.
+    bool_num_domain_t meet_bools(bool_num_domain_t &o, NumDom num) const {
+      if (!has_bools() && !o.has_bools()) {
+	bool_num_domain_t res(false, num);
+	res.check_num_bottom();
+	return res;
+      }
+      bool_num_domain_t res(false, num);
+      res.m_base = m_base;
+      res.m_true = m_true;
+      res.m_false = m_false;
+      res.align(o);
+      uint64_t *t = res.m_true.data(), *f = res.m_false.data();
+      const uint64_t *ot = o.m_true.data(), *of = o.m_false.data();
+      std::size_t n = res.m_true.size();
+      uint64_t conflict = 0;
+      for (std::size_t k = 0; k < n; ++k) {
+	t[k] |= ot[k];
+	f[k] |= of[k];
+	conflict |= t[k] & f[k];
+      }
+      if (conflict != 0) return bottom();
+      // -- both links hold so any of them can be kept
+      res.m_links = m_links;
+      res.m_links.insert(o.m_links.begin(), o.m_links.end());
+      res.check_num_bottom();
+      return res;
+    }
+
+  public:
+
+    bitset_boolean_numerical_domain()
+      : m_is_bottom(false), m_base(0), m_num(NumDom::top()) {}
+
+    static bool_num_domain_t top() {
+      return bool_num_domain_t(false, NumDom::top());
+    }
+
+    static bool_num_domain_t bottom() {
+      return bool_num_domain_t(true, NumDom::bottom());
+    }
+
+    void set_to_top() {
+      *this = top();
+    }
+
+    void set_to_bottom() {
+      *this = bottom();
+    }
+
+    bool is_bottom() {
+      return m_is_bottom || m_num.is_bottom();
+    }
+
+    bool is_top() {
+      if (is_bottom()) return false;
+      uint64_t bits = 0;
+      for (std::size_t k = 0; k < m_true.size(); ++k) {
+	bits |= m_true[k] | m_false[k];
+      }
+      return bits == 0 && m_num.is_top();
+    }
+
+    interval_t operator[](variable_t v) {
+      return m_num[v];
+    }
+
+    bool operator<=(bool_num_domain_t o) {
+      if (is_bottom()) return true;
+      if (o.is_bottom()) return false;
+      if (!o.has_bools()) return m_num <= o.m_num;
+      align(o);
+      uint64_t missing = 0;
+      for (std::size_t k = 0; k < m_true.size(); ++k) {
+	missing |= (o.m_true[k] & ~m_true[k]) | (o.m_false[k] & ~m_false[k]);
+      }
+      return missing == 0 && m_num <= o.m_num;
+    }
+
+    void operator|=(bool_num_domain_t o) {
+      *this = *this | o;
+    }
+
+    bool_num_domain_t operator|(bool_num_domain_t o) {
+      if (is_bottom()) return o;
+      if (o.is_bottom()) return *this;
+      return join_bools(o, m_num | o.m_num);
+    }
+
+    bool_num_domain_t operator&(bool_num_domain_t o) {
+      if (is_bottom() || o.is_bottom()) return bottom();
+      return meet_bools(o, m_num & o.m_num);
+    }
+
+    // the boolean domain is finite so widening is join
+    bool_num_domain_t operator||(bool_num_domain_t o) {
+      if (is_bottom()) return o;
+      if (o.is_bottom()) return *this;
+      return join_bools(o, m_num || o.m_num);
+    }
+
+    template<typename Thresholds>
+    bool_num_domain_t widening_thresholds(bool_num_domain_t o, const Thresholds &ts) {
+      if (is_bottom()) return o;
+      if (o.is_bottom()) return *this;
+      return join_bools(o, m_num.widening_thresholds(o.m_num, ts));
+    }
+
+    bool_num_domain_t operator&&(bool_num_domain_t o) {
+      if (is_bottom() || o.is_bottom()) return bottom();
+      return meet_bools(o, m_num && o.m_num);
+    }
+
+    /* numerical operations */
+
+    void operator+=(linear_constraint_system_t csts) {
+      if (is_bottom()) return;
+      m_num += csts;
+      check_num_bottom();
+    }
+
+    void operator-=(variable_t v) {
+      if (is_bottom()) return;
+      set_bool(v, BOOL_TOP);
+      m_num -= v;
+      invalidate(v);
+    }
+
+    void assign(variable_t x, linear_expression_t e) {
+      if (is_bottom()) return;
+      m_num.assign(x, e);
+      invalidate(x);
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (is_bottom()) return;
+      m_num.apply(op, x, y, z);
+      invalidate(x);
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, number_t k) {
+      if (is_bottom()) return;
+      m_num.apply(op, x, y, k);
+      invalidate(x);
+    }
+
+    void apply(crab::domains::int_conv_operation_t op, variable_t dst, variable_t src) {
+      if (is_bottom()) return;
+      m_num.apply(op, dst, src);
+      invalidate(dst);
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (is_bottom()) return;
+      m_num.apply(op, x, y, z);
+      invalidate(x);
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, number_t k) {
+      if (is_bottom()) return;
+      m_num.apply(op, x, y, k);
+      invalidate(x);
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (is_bottom()) return;
+      m_num.apply(op, x, y, z);
+      invalidate(x);
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, number_t k) {
+      if (is_bottom()) return;
+      m_num.apply(op, x, y, k);
+      invalidate(x);
+    }
+
+    void backward_assign(variable_t x, linear_expression_t e, bool_num_domain_t invariant) {
+      if (is_bottom()) return;
+      m_num.backward_assign(x, e, invariant.m_num);
+      invalidate(x);
+      check_num_bottom();
+    }
+
+    void backward_apply(crab::domains::operation_t op, variable_t x, variable_t y, number_t z,
+			bool_num_domain_t invariant) {
+      if (is_bottom()) return;
+      m_num.backward_apply(op, x, y, z, invariant.m_num);
+      invalidate(x);
+      check_num_bottom();
+    }
+
+    void backward_apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z,
+			bool_num_domain_t invariant) {
+      if (is_bottom()) return;
+      m_num.backward_apply(op, x, y, z, invariant.m_num);
+      invalidate(x);
+      check_num_bottom();
+    }
+
+    /* boolean operations */
+
+    // lhs := cst
+    void assign_bool_cst(variable_t lhs, linear_constraint_t cst) {
+      if (is_bottom()) return;
+      linear_constraint_system_t csts(cst);
+      bool_value_t val = BOOL_TOP;
+      NumDom t(m_num);
+      t += csts;
+      if (t.is_bottom()) {
+	val = BOOL_FALSE;
+      } else {
+	NumDom f(m_num);
+	f += linear_constraint_system_t(cst.negate());
+	if (f.is_bottom()) val = BOOL_TRUE;
+      }
+      invalidate(lhs);
+      set_bool(lhs, val);
+      m_links[lhs.index()] = boost::make_shared<const linear_constraint_system_t>(csts);
+    }
+
+    // lhs := rhs or lhs := not(rhs)
+    void assign_bool_var(variable_t lhs, variable_t rhs, bool is_not_rhs) {
+      if (is_bottom()) return;
+      bool_value_t val = get_bool(rhs.index());
+      csts_ptr link;
+      auto it = m_links.find(rhs.index());
+      if (!is_not_rhs && it != m_links.end()) {
+	link = it->second;
+      }
+      invalidate(lhs);
+      set_bool(lhs, is_not_rhs ? negate(val) : val);
+      if (link) {
+	m_links[lhs.index()] = link;
+      }
+    }
+
+    void apply_binary_bool(crab::domains::bool_operation_t op,
+			   variable_t x, variable_t y, variable_t z) {
+      if (is_bottom()) return;
+      bool_value_t a = get_bool(y.index());
+      bool_value_t b = get_bool(z.index());
+      bool_value_t val = BOOL_TOP;
+      switch (op) {
+      case crab::domains::OP_BAND:
+	if (a == BOOL_FALSE || b == BOOL_FALSE) val = BOOL_FALSE;
+	else if (a == BOOL_TRUE && b == BOOL_TRUE) val = BOOL_TRUE;
+	break;
+      case crab::domains::OP_BOR:
+	if (a == BOOL_TRUE || b == BOOL_TRUE) val = BOOL_TRUE;
+	else if (a == BOOL_FALSE && b == BOOL_FALSE) val = BOOL_FALSE;
+	break;
+      case crab::domains::OP_BXOR:
+	if (a != BOOL_TOP && b != BOOL_TOP) val = (a != b ? BOOL_TRUE : BOOL_FALSE);
+	break;
+      default:
+	break;
+      }
+      invalidate(x);
+      set_bool(x, val);
+    }
+
+    void assume_bool(variable_t v, bool is_negated) {
+      if (is_bottom()) return;
+      bool_value_t val = (is_negated ? BOOL_FALSE : BOOL_TRUE);
+      bool_value_t old = get_bool(v.index());
+      if (old != BOOL_TOP && old != val) {
+	set_to_bottom();
+	return;
+      }
+      set_bool(v, val);
+      auto it = m_links.find(v.index());
+      if (it == m_links.end()) return;
+      const linear_constraint_system_t &csts = *(it->second);
+      if (!is_negated) {
+	m_num += csts;
+      } else if (std::distance(csts.begin(), csts.end()) == 1) {
+	m_num += linear_constraint_system_t(csts.begin()->negate());
+      }
+      check_num_bottom();
+    }
+
+    void backward_assign_bool_cst(variable_t lhs, linear_constraint_t /*rhs*/,
+				  bool_num_domain_t invariant) {
+      if (is_bottom()) return;
+      *this -= lhs;
+      *this = *this & invariant;
+    }
+
+    void backward_assign_bool_var(variable_t lhs, variable_t /*rhs*/, bool /*is_not_rhs*/,
+				  bool_num_domain_t invariant) {
+      if (is_bottom()) return;
+      *this -= lhs;
+      *this = *this & invariant;
+    }
+
+    void backward_apply_binary_bool(crab::domains::bool_operation_t /*op*/,
+				    variable_t x, variable_t /*y*/, variable_t /*z*/,
+				    bool_num_domain_t invariant) {
+      if (is_bottom()) return;
+      *this -= x;
+      *this = *this & invariant;
+    }
+
+    /* arrays and pointers are handled by the numerical domain */
+
+    void array_init(variable_t a, linear_expression_t elem_size,
+		    linear_expression_t lb_idx, linear_expression_t ub_idx,
+		    linear_expression_t val) {
+      m_num.array_init(a, elem_size, lb_idx, ub_idx, val);
+    }
+
+    void array_load(variable_t lhs, variable_t a,
+		    linear_expression_t elem_size, linear_expression_t i) {
+      m_num.array_load(lhs, a, elem_size, i);
+      set_bool(lhs, BOOL_TOP);
+      invalidate(lhs);
+    }
+
+    void array_store(variable_t a, linear_expression_t elem_size,
+		     linear_expression_t i, linear_expression_t v, bool is_singleton) {
+      m_num.array_store(a, elem_size, i, v, is_singleton);
+    }
+
+    void array_assign(variable_t lhs, variable_t rhs) {
+      m_num.array_assign(lhs, rhs);
+    }
+
+    void pointer_load(variable_t lhs, variable_t rhs) { m_num.pointer_load(lhs, rhs); }
+    void pointer_store(variable_t lhs, variable_t rhs) { m_num.pointer_store(lhs, rhs); }
+    void pointer_assign(variable_t lhs, variable_t rhs, linear_expression_t offset)
+    { m_num.pointer_assign(lhs, rhs, offset); }
+    void pointer_mk_obj(variable_t lhs, ikos::index_t address)
+    { m_num.pointer_mk_obj(lhs, address); }
+    void pointer_function(variable_t lhs, varname_t func) { m_num.pointer_function(lhs, func); }
+    void pointer_mk_null(variable_t lhs) { m_num.pointer_mk_null(lhs); }
+    void pointer_assume(pointer_constraint_t cst) { m_num.pointer_assume(cst); }
+    void pointer_assert(pointer_constraint_t cst) { m_num.pointer_assert(cst); }
+
+    void forget(const variable_vector_t& vars) {
+      if (is_bottom()) return;
+      for (auto const &v: vars) {
+	set_bool(v, BOOL_TOP);
+	invalidate(v);
+      }
+      m_num.forget(vars);
+    }
+
+    void project(const variable_vector_t& vars) {
+      if (is_bottom()) return;
+      if (!has_bools()) {
+	m_num.project(vars);
+	return;
+      }
+      std::vector<std::pair<variable_t, bool_value_t>> vals;
+      links_t links;
+      for (auto const &v: vars) {
+	vals.push_back(std::make_pair(v, get_bool(v.index())));
+	auto it = m_links.find(v.index());
+	if (it != m_links.end()) links.insert(*it);
+      }
+      m_base = 0;
+      m_true.clear();
+      m_false.clear();
+      for (auto &kv: vals) {
+	set_bool(kv.first, kv.second);
+      }
+      // -- links on variables that are not kept are removed
+      m_links.clear();
+      for (auto &kv: links) {
+	bool keep = true;
+	for (auto const &cst: *(kv.second)) {
+	  for (auto t: cst.expression()) {
+	    keep &= (std::find(vars.begin(), vars.end(), t.second) != vars.end());
+	  }
+	}
+	if (keep) m_links.insert(kv);
+      }
+      m_num.project(vars);
+    }
+
+    void expand(variable_t x, variable_t new_x) {
+      if (is_bottom()) return;
+      set_bool(new_x, get_bool(x.index()));
+      auto it = m_links.find(x.index());
+      if (it != m_links.end()) {
+	m_links[new_x.index()] = it->second;
+      }
+      m_num.expand(x, new_x);
+    }
+
+    void normalize() {
+      m_num.normalize();
+    }
+
+    linear_constraint_system_t to_linear_constraint_system() {
+      if (is_bottom()) {
+	linear_constraint_system_t res;
+	res += linear_constraint_t::get_false();
+	return res;
+      }
+      linear_constraint_system_t res = m_num.to_linear_constraint_system();
+      registry_t &vars = registry_t::get();
+      for (std::size_t w = m_base; w < end(); ++w) {
+	uint64_t bits = m_true[w - m_base] | m_false[w - m_base];
+	for (std::size_t b = 0; bits != 0 && b < word_bits; ++b, bits >>= 1) {
+	  if (!(bits & 1)) continue;
+	  std::size_t i = w * word_bits + b;
+	  const variable_t *v = vars.find(i);
+	  if (!v) continue;
+	  res += (linear_expression_t(*v) ==
+		  number_t(get_bool(i) == BOOL_TRUE ? 1 : 0));
+	}
+      }
+      return res;
+    }
+
+    void write(crab::crab_os& o) {
+      if (is_bottom()) {
+	o << "_|_";
+	return;
+      }
+      registry_t &vars = registry_t::get();
+      o << "({";
+      bool first = true;
+      for (std::size_t w = m_base; w < end(); ++w) {
+	uint64_t bits = m_true[w - m_base] | m_false[w - m_base];
+	for (std::size_t b = 0; bits != 0 && b < word_bits; ++b, bits >>= 1) {
+	  if (!(bits & 1)) continue;
+	  std::size_t i = w * word_bits + b;
+	  const variable_t *v = vars.find(i);
+	  if (!v) continue;
+	  if (!first) o << "; ";
+	  first = false;
+	  o << *v << " -> " << (get_bool(i) == BOOL_TRUE ? "true" : "false");
+	}
+      }
+      o << "}, ";
+      m_num.write(o);
+      o << ")";
+    }
+
+    static std::string getDomainName() {
+      return "Bitset Boolean x " + NumDom::getDomainName();
+    }
+  };
+
+} // end namespace crab_llvm
+#endif
@@ -9,35 +9,63 @@
 
 #include "llvm/IR/Value.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "crab/cfg/cfg.hpp"
 #include "crab/cfg/var_factory.hpp"
+#include "crab_llvm/Support/RawCrabOs.hh"
 
 #include <boost/functional/hash.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 namespace crab_llvm {
 
+  // Name of a value without name (--crab-lazy-names) after its slot
+  // number in the LLVM printer. It is only computed when printing.
+  std::string get_slot_name(const llvm::Value *v);
+
+  inline std::string get_value_name(const llvm::Value *v) {
+    return v->hasName() ? v->getName().str() : get_slot_name(v);
+  }
+  
   // This wrapper is needed because we can have crab blocks which do
   // not correspond to llvm blocks.
+  //
+  // Labels are compared and hashed without touching strings: a block
+  // label is identified by its llvm basic block while a label for an
+  // edge is identified by a number assigned by CfgBuilder. The name
+  // is only built when printing.
   class llvm_basic_block_wrapper {
     
   public:
 
     // the new block represents that the control is at b
     llvm_basic_block_wrapper(const llvm::BasicBlock *b)
-      : m_bb(b), m_edge(nullptr, nullptr), m_name(b->getName()) {
-      assert(b->hasName());
-    }
+      : m_bb(b), m_edge(nullptr, nullptr), m_id(0) {}
 
     // the new block represents that the control goes from src to dst
-    llvm_basic_block_wrapper(const llvm::BasicBlock *src, const llvm::BasicBlock *dst, std::string name)
-      : m_bb(nullptr), m_edge(src, dst), m_name(name){}
+    // id must be unique (and non-zero) within the enclosing function.
+    llvm_basic_block_wrapper(const llvm::BasicBlock *src, const llvm::BasicBlock *dst,
+			     unsigned id)
+      : m_bb(nullptr), m_edge(src, dst), m_id(id) {
+      assert(id > 0);
+    }
 
     llvm_basic_block_wrapper()
-      : m_bb(nullptr), m_edge(nullptr, nullptr), m_name("") {}
+      : m_bb(nullptr), m_edge(nullptr, nullptr), m_id(0) {}
 
-    std::string get_name() const { return m_name; }
+    std::string get_name() const {
+      if (m_bb) {
+	return get_value_name(m_bb);
+      } else if (m_id > 0) {
+	return std::string("__@bb_") + std::to_string(m_id);
+      } else {
+	return "";
+      }
+    }
 
     bool is_edge() const {
       return !m_bb && (m_edge.first && m_edge.second);
@@ -52,24 +80,40 @@ namespace crab_llvm {
     }
 
     bool operator==(const llvm_basic_block_wrapper &other) const
-    { return m_name == other.m_name; }
+    { return m_bb == other.m_bb && m_id == other.m_id; }
     
     bool operator!=(const llvm_basic_block_wrapper &other) const
     { return !(this->operator==(other)); }
-    
-    bool operator<(const llvm_basic_block_wrapper &other) const
-    { return m_name < other.m_name; }
+
+    // Deterministic order: llvm blocks (by name) before edge blocks
+    // (by id).
+    bool operator<(const llvm_basic_block_wrapper &other) const {
+      if (m_bb && other.m_bb) {
+	if (m_bb == other.m_bb) return false;
+	if (m_bb->hasName() && other.m_bb->hasName())
+	  return m_bb->getName() < other.m_bb->getName();
+	return get_value_name(m_bb) < get_value_name(other.m_bb);
+      } else if (!m_bb && !other.m_bb) {
+	return m_id < other.m_id;
+      } else {
+	return m_bb != nullptr;
+      }
+    }
 
     std::size_t index() const {
-      boost::hash<std::string> hasher;
-      return hasher(m_name);
+      if (m_bb) {
+	boost::hash<const llvm::BasicBlock*> hasher;
+	return hasher(m_bb);
+      } else {
+	return m_id;
+      }
     }
 
   private:
     
     const llvm::BasicBlock *m_bb;
     std::pair<const llvm::BasicBlock *, const llvm::BasicBlock *> m_edge;
-    std::string m_name;
+    unsigned m_id;
   };
   
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream &o,
@@ -94,7 +138,7 @@ namespace crab {
       namespace indexed_string_impl {
         // To print variable names
         template<> inline std::string get_str(const llvm::Value *v) 
-        {return v->getName().str();}
+        {return crab_llvm::get_value_name(v);}
       } 
     }
   }
@@ -108,18 +152,79 @@ namespace crab {
 
 namespace crab_llvm {
        
-     // Variable factory from llvm::Value's
-     class llvm_variable_factory :
-      public crab::cfg::var_factory_impl::
-             variable_factory<const llvm::Value*> {
+     // Variable factory from llvm::Value's. It wraps the factory of
+     // crab rather than deriving from it: the methods of the crab
+     // factory are not virtual and not thread-safe, so they must not
+     // be reachable through a reference to it.
+     class llvm_variable_factory {
        typedef crab::cfg::var_factory_impl::
-               variable_factory<const llvm::Value*> variable_factory_t;
+               variable_factory<const llvm::Value*> crab_factory_t;
       public: 
        
-       typedef variable_factory_t::varname_t varname_t;
-       typedef variable_factory_t::const_var_range const_var_range;
+       typedef crab_factory_t::varname_t varname_t;
+       typedef crab_factory_t::const_var_range const_var_range;
        
-       llvm_variable_factory(): variable_factory_t() {}
+       llvm_variable_factory() {}
+
+       // The factory can be shared by several threads (e.g.,
+       // --crab-threads). Names of values that already exist are
+       // found in a sharded cache so concurrent lookups only contend
+       // if they fall in the same shard. Creation of new names is
+       // serialized.
+       varname_t operator[](const llvm::Value* v) {
+	 shard &s = get_shard(v);
+	 {
+	   std::lock_guard<std::mutex> lock(s.mutex);
+	   auto it = s.names.find(v);
+	   if (it != s.names.end()) {
+	     return it->second;
+	   }
+	 }
+	 varname_t res = create(v);
+	 std::lock_guard<std::mutex> lock(s.mutex);
+	 s.names.insert(std::make_pair(v, res));
+	 return res;
+       }
+
+       // A shadow variable (not associated with any llvm::Value)
+       template<typename... Args>
+       varname_t get(Args&&... args) {
+	 std::lock_guard<std::mutex> lock(m_mutex);
+	 return m_factory.get(std::forward<Args>(args)...);
+       }
+
+       const_var_range get_shadow_vars() const {
+	 std::lock_guard<std::mutex> lock(m_mutex);
+	 return m_factory.get_shadow_vars();
+       }
+
+       // Create the names of all values of f in program order. Names
+       // are numbered in creation order so calling this for all
+       // functions before building their CFGs in parallel makes the
+       // numbering of values independent of thread scheduling.
+       void add_names(const llvm::Function &f);
+
+      private:
+       struct shard {
+	 std::mutex mutex;
+	 llvm::DenseMap<const llvm::Value*, varname_t> names;
+       };
+       static const unsigned num_shards = 16;
+       
+       crab_factory_t m_factory;
+       shard m_shards[num_shards];
+       // serializes the accesses to m_factory
+       mutable std::mutex m_mutex;
+
+       shard& get_shard(const llvm::Value *v) {
+	 // the lowest bits are always zero because of alignment
+	 return m_shards[(reinterpret_cast<std::uintptr_t>(v) >> 4) % num_shards];
+       }
+       
+       varname_t create(const llvm::Value *v) {
+	 std::lock_guard<std::mutex> lock(m_mutex);
+	 return m_factory[v];
+       }
      };
   
      typedef llvm_variable_factory variable_factory_t;
@@ -140,6 +245,15 @@ namespace crab_llvm {
      typedef ikos::disjunctive_linear_constraint_system<number_t, varname_t> disj_lin_cst_sys_t;
      typedef crab::pointer_constraint<var_t> ptr_cst_t;
 
+     // Iteration order of a CFG computed by CfgBuilder from the loops
+     // of LLVM: the blocks of each loop are contiguous and its head
+     // comes first. The heads are the only targets of the edges that
+     // go backwards. Empty if the CFG of LLVM is irreducible.
+     struct cfg_loop_order {
+       std::vector<basic_block_label_t> blocks;
+       std::vector<basic_block_label_t> heads;
+     };
+
 } // end namespace crab_llvm
 
 namespace crab {
@@ -168,17 +282,15 @@ namespace crab {
 namespace {
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o, 
 				       const crab_llvm::cfg_t& cfg) {
-    crab::crab_string_os s;
+    crab_llvm::raw_crab_os s(o);
     s << cfg;
-    o << s.str ();
     return o;
   }
 
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o, 
 				       crab_llvm::cfg_ref_t cfg) {
-    crab::crab_string_os s;
+    crab_llvm::raw_crab_os s(o);
     s << cfg;
-    o << s.str ();
     return o;
   }
 }
@@ -18,6 +18,12 @@
 #include "crab/domains/flat_boolean_domain.hpp"
 #include "crab/domains/combined_domains.hpp"
 #include "crab/domains/wrapped_interval_domain.hpp"
+#include "crab_llvm/dense_interval_domain.hh"
+#include "crab_llvm/native_wrapped_interval_domain.hh"
+#include "crab_llvm/offset_pointer_domain.hh"
+#include "crab_llvm/bitset_boolean_domain.hh"
+#include "crab_llvm/fast_zones_domain.hh"
+#include "crab_llvm/dense_zones_domain.hh"
 //#include "crab/domains/array_sparse_graph.hpp"
 //#include "crab/domains/nullity.hpp"
 
@@ -34,9 +40,9 @@ namespace crab_llvm {
   // The base numerical domain 
   #define BASE(DOM) base_ ## DOM
   // Array functor domain where the base domain is a reduced product
-  // of a boolean domain with the numerical domain DOM.
+  // of a (bit-packed) boolean domain with the numerical domain DOM.
   #define ARRAY_BOOL_NUM(DOM) \
-    typedef array_smashing<flat_boolean_numerical_domain<BASE(DOM)>> DOM
+    typedef array_smashing<bitset_boolean_numerical_domain<BASE(DOM)>> DOM
   // Array functor domain where the base domain is DOM
   #define ARRAY_NUM(DOM) \
     typedef array_smashing<BASE(DOM)> DOM;
@@ -51,10 +57,20 @@ namespace crab_llvm {
   // // -- enable apron version for more precise backward operations
   // typedef apron_domain<number_t, varname_t, apron_domain_id_t::APRON_INT>
   // BASE(interval_domain_t);
+  /// -- Intervals with bounds in dense int64 arrays
+  typedef dense_interval_domain<number_t, varname_t> BASE(dense_interval_domain_t);
   /// -- Wrapped interval domain (APLAS'12)
   typedef wrapped_interval_domain<number_t, varname_t> BASE(wrapped_interval_domain_t);
+  /// -- Wrapped intervals with native uint64_t bounds
+  typedef native_wrapped_interval_domain<number_t, varname_t> BASE(wrapped_interval_fast_domain_t);
+  /// -- Dense intervals with a (base region, offset interval) per pointer
+  typedef offset_pointer_domain<number_t, varname_t> BASE(offset_pointer_domain_t);
   /// -- Zones using sparse DBMs in split normal form (SAS'16)
   typedef SplitDBM<number_t, varname_t> BASE(split_dbm_domain_t);
+  /// -- Zones with int64 weights (GMP weights after an overflow)
+  typedef fast_zones_domain<number_t, varname_t> BASE(split_dbm_fast_domain_t);
+  /// -- Fast zones with dense DBMs for small and dense states
+  typedef dense_zones_domain<number_t, varname_t> BASE(dense_dbm_domain_t);
   /// -- Boxes
   typedef boxes_domain<number_t, varname_t> BASE(boxes_domain_t);
   // typedef diff_domain<flat_boolean_numerical_domain<BASE(interval_domain_t)>,
@@ -91,7 +107,11 @@ namespace crab_llvm {
 					    reduced_product_impl::term_dbm_params> BASE(num_domain_t);
 
   ARRAY_BOOL_NUM(interval_domain_t);
+  ARRAY_BOOL_NUM(dense_interval_domain_t);
+  ARRAY_BOOL_NUM(offset_pointer_domain_t);
   ARRAY_BOOL_NUM(split_dbm_domain_t);
+  ARRAY_BOOL_NUM(split_dbm_fast_domain_t);
+  ARRAY_BOOL_NUM(dense_dbm_domain_t);
   ARRAY_BOOL_NUM(dis_interval_domain_t);
   ARRAY_BOOL_NUM(oct_domain_t);
   ARRAY_BOOL_NUM(pk_domain_t);
@@ -104,6 +124,7 @@ namespace crab_llvm {
   ARRAY_NUM(boxes_domain_t);
   /* domains that preserve machine arithmetic semantics */
   ARRAY_BOOL_NUM(wrapped_interval_domain_t);
+  ARRAY_BOOL_NUM(wrapped_interval_fast_domain_t);
   
 } // end namespace crab-llvm
 
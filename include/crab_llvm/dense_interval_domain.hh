@@ -0,0 +1,723 @@
+#ifndef __DENSE_INTERVAL_DOMAIN_HH__
+#define __DENSE_INTERVAL_DOMAIN_HH__
+
+#include "crab/config.h"
+#include "crab/common/types.hpp"
+#include "crab/domains/intervals.hpp"
+#include "crab_llvm/Support/VarRegistry.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+/*
+ * Interval domain with a dense representation.
+ *
+ * Variables are identified by their index in the variable factory
+ * and the bounds of a contiguous range of indexes are stored as
+ * int64 in two parallel arrays (lower and upper bounds). INT64_MIN
+ * and INT64_MAX stand for -oo and +oo. Join, meet, widening,
+ * narrowing and inclusion are then loops over the arrays that the
+ * compiler can vectorize. Bounds that do not fit in int64 are kept
+ * exactly (GMP) in a small side map.
+ *
+ * It is meant for the large flat functions where we fall back to
+ * intervals: almost all variables are bounded and the values are
+ * joined and compared many times. Transfer functions and
+ * constraints use the same interval arithmetic as
+ * crab::domains::interval_domain.
+ */
+
+namespace crab_llvm {
+
+  template<typename Number, typename VariableName>
+  class dense_interval_domain:
+    public crab::domains::abstract_domain<Number, VariableName,
+					  dense_interval_domain<Number,VariableName>> {
+  public:
+
+    typedef dense_interval_domain<Number, VariableName> dense_interval_domain_t;
+    typedef crab::domains::abstract_domain<Number, VariableName,
+					   dense_interval_domain_t> abstract_domain_t;
+    using typename abstract_domain_t::linear_expression_t;
+    using typename abstract_domain_t::linear_constraint_t;
+    using typename abstract_domain_t::linear_constraint_system_t;
+    using typename abstract_domain_t::variable_t;
+    using typename abstract_domain_t::variable_vector_t;
+    using typename abstract_domain_t::pointer_constraint_t;
+    typedef Number number_t;
+    typedef VariableName varname_t;
+    typedef ikos::interval<Number> interval_t;
+    typedef ikos::bound<Number> bound_t;
+
+  private:
+
+    typedef var_registry<variable_t> registry_t;
+    // exact intervals of the slots whose bounds do not fit in int64
+    // (the slots are top)
+    typedef std::map<std::size_t, interval_t> wide_map_t;
+    typedef std::vector<std::pair<std::size_t, interval_t>> slot_values_t;
+
+    // max number of passes over a constraint system
+    static const unsigned max_reduction_cycles = 10;
+
+    bool m_is_bottom;
+    // index of the variable of the first slot
+    std::size_t m_base;
+    std::vector<int64_t> m_lo;
+    std::vector<int64_t> m_hi;
+    wide_map_t m_wide;
+
+    static int64_t minus_inf() { return INT64_MIN; }
+    static int64_t plus_inf() { return INT64_MAX; }
+
+    // finite bounds must not clash with -oo and +oo
+    static bool fits(const Number &n) {
+      static const Number min("-9223372036854775807");
+      static const Number max("9223372036854775806");
+      return n >= min && n <= max;
+    }
+
+    static bool to_int64(const bound_t &b, int64_t &n) {
+      if (b.is_infinite()) {
+	n = (b.is_plus_infinity() ? plus_inf() : minus_inf());
+	return true;
+      }
+      Number k = *(b.number());
+      if (!fits(k)) return false;
+      n = (int64_t) (long) k;
+      return true;
+    }
+
+    static bound_t to_bound(int64_t n) {
+      if (n == minus_inf()) return bound_t::minus_infinity();
+      if (n == plus_inf()) return bound_t::plus_infinity();
+      return bound_t(Number((long) n));
+    }
+
+    // floor(k/a) and ceil(k/a) with a != 0
+    static Number floor_div(const Number &k, const Number &a) {
+      Number q = k / a;
+      Number r = k % a;
+      if (r != 0 && ((r < 0) != (a < 0))) q = q - 1;
+      return q;
+    }
+
+    static Number ceil_div(const Number &k, const Number &a) {
+      Number q = k / a;
+      Number r = k % a;
+      if (r != 0 && ((r < 0) == (a < 0))) q = q + 1;
+      return q;
+    }
+
+    explicit dense_interval_domain(bool is_bottom)
+      : m_is_bottom(is_bottom), m_base(0) {}
+
+    std::size_t end() const { return m_base + m_lo.size(); }
+
+    // Extend the slots so they cover the indexes [first, last). The
+    // new slots are top.
+    void extend(std::size_t first, std::size_t last) {
+      if (m_lo.empty()) {
+	m_base = first;
+	m_lo.assign(last - first, minus_inf());
+	m_hi.assign(last - first, plus_inf());
+	return;
+      }
+      if (first < m_base) {
+	std::size_t n = m_base - first;
+	m_lo.insert(m_lo.begin(), n, minus_inf());
+	m_hi.insert(m_hi.begin(), n, plus_inf());
+	m_base = first;
+      }
+      if (last > end()) {
+	m_lo.resize(last - m_base, minus_inf());
+	m_hi.resize(last - m_base, plus_inf());
+      }
+    }
+
+    // Make both values cover the same slots
+    void align(dense_interval_domain_t &o) {
+      if (o.m_lo.empty() && m_lo.empty()) return;
+      std::size_t first, last;
+      if (m_lo.empty()) {
+	first = o.m_base; last = o.end();
+      } else if (o.m_lo.empty()) {
+	first = m_base; last = end();
+      } else {
+	first = std::min(m_base, o.m_base);
+	last = std::max(end(), o.end());
+      }
+      extend(first, last);
+      o.extend(first, last);
+    }
+
+    interval_t get(std::size_t i) const {
+      auto it = m_wide.find(i);
+      if (it != m_wide.end()) {
+	return it->second;
+      }
+      if (i < m_base || i >= end()) {
+	return interval_t::top();
+      }
+      std::size_t k = i - m_base;
+      return interval_t(to_bound(m_lo[k]), to_bound(m_hi[k]));
+    }
+
+    // Precondition: x is not bottom and the variable of slot i was
+    // registered.
+    void set_slot(std::size_t i, const interval_t &x) {
+      m_wide.erase(i);
+      if (x.is_top()) {
+	if (i >= m_base && i < end()) {
+	  m_lo[i - m_base] = minus_inf();
+	  m_hi[i - m_base] = plus_inf();
+	}
+	return;
+      }
+      extend(m_lo.empty() ? i : std::min(i, m_base),
+	     m_lo.empty() ? i + 1 : std::max(i + 1, end()));
+      std::size_t k = i - m_base;
+      int64_t lo, hi;
+      if (to_int64(x.lb(), lo) && to_int64(x.ub(), hi)) {
+	m_lo[k] = lo;
+	m_hi[k] = hi;
+      } else {
+	m_lo[k] = minus_inf();
+	m_hi[k] = plus_inf();
+	m_wide.insert(std::make_pair(i, x));
+      }
+    }
+
+    // Exact values of the slots that are wide in this or o. They
+    // must be computed before the loops over the arrays.
+    template<typename Op>
+    slot_values_t wide_slots(const dense_interval_domain_t &o, Op op) const {
+      slot_values_t res;
+      for (auto &kv: m_wide) {
+	res.push_back(std::make_pair(kv.first, op(kv.second, o.get(kv.first))));
+      }
+      for (auto &kv: o.m_wide) {
+	if (m_wide.count(kv.first) == 0) {
+	  res.push_back(std::make_pair(kv.first, op(get(kv.first), kv.second)));
+	}
+      }
+      return res;
+    }
+
+    void set_wide_slots(const slot_values_t &vals) {
+      m_wide.clear();
+      for (auto &kv: vals) {
+	if (kv.second.is_bottom()) {
+	  set_to_bottom();
+	  return;
+	}
+	set_slot(kv.first, kv.second);
+      }
+    }
+
+    bool has_empty_slot() const {
+      const int64_t *lo = m_lo.data();
+      const int64_t *hi = m_hi.data();
+      std::size_t n = m_lo.size();
+      bool res = false;
+      for (std::size_t k = 0; k < n; ++k) {
+	res |= (lo[k] > hi[k]);
+      }
+      return res;
+    }
+
+    // Refine the variables of sign*e <= 0
+    void refine_leq(const linear_expression_t &e, int sign, bool &change) {
+      Number s(sign);
+      for (auto t: e) {
+	Number a = s * t.first;
+	if (a == 0) continue;
+	// -- rest := sign*c + sum sign*a_j*x_j with x_j != x
+	interval_t rest(s * e.constant());
+	for (auto u: e) {
+	  if (u.second == t.second) continue;
+	  rest = rest + interval_t(s * u.first) * get(u.second.index());
+	}
+	bound_t r = rest.lb();
+	if (r.is_infinite()) continue;
+	// -- a*x <= -rest.lb
+	Number k = Number(0) - *(r.number());
+	interval_t x = (a > 0 ?
+			interval_t(bound_t::minus_infinity(), bound_t(floor_div(k, a))) :
+			interval_t(bound_t(ceil_div(k, a)), bound_t::plus_infinity()));
+	interval_t old = get(t.second.index());
+	interval_t refined = old & x;
+	if (!(old <= refined)) {
+	  set(t.second, refined);
+	  change = true;
+	  if (m_is_bottom) return;
+	}
+      }
+    }
+
+    // a*x + c != 0 only refines a bound of x
+    void refine_neq(const linear_expression_t &e, bool &change) {
+      if (std::distance(e.begin(), e.end()) != 1) return;
+      auto t = *(e.begin());
+      Number a = t.first;
+      Number c = Number(0) - e.constant();
+      if (a == 0 || c % a != 0) return;
+      Number k = c / a;
+      interval_t old = get(t.second.index());
+      boost::optional<Number> lb = old.lb().number();
+      boost::optional<Number> ub = old.ub().number();
+      if (lb && *lb == k) {
+	set(t.second, interval_t(bound_t(k + 1), old.ub()));
+	change = true;
+      } else if (ub && *ub == k) {
+	set(t.second, interval_t(old.lb(), bound_t(k - 1)));
+	change = true;
+      }
+    }
+
+    void add_constraint(const linear_constraint_t &cst, bool &change) {
+      if (cst.is_tautology()) return;
+      if (cst.is_contradiction()) {
+	set_to_bottom();
+	return;
+      }
+      if (cst.is_inequality()) {
+	refine_leq(cst.expression(), 1, change);
+      } else if (cst.is_equality()) {
+	refine_leq(cst.expression(), 1, change);
+	if (!m_is_bottom) {
+	  refine_leq(cst.expression(), -1, change);
+	}
+      } else if (cst.is_disequation()) {
+	refine_neq(cst.expression(), change);
+      }
+      // other constraints are ignored (sound)
+    }
+
+    interval_t eval(const linear_expression_t &e) const {
+      interval_t r(e.constant());
+      for (auto t: e) {
+	r = r + interval_t(t.first) * get(t.second.index());
+      }
+      return r;
+    }
+
+    static interval_t eval(crab::domains::operation_t op, interval_t y, interval_t z) {
+      switch (op) {
+      case crab::domains::OP_ADDITION:       return y + z;
+      case crab::domains::OP_SUBTRACTION:    return y - z;
+      case crab::domains::OP_MULTIPLICATION: return y * z;
+      case crab::domains::OP_DIVISION:       return y / z;
+      default:                               return interval_t::top();
+      }
+    }
+
+    static interval_t eval(crab::domains::bitwise_operation_t op, interval_t y, interval_t z) {
+      switch (op) {
+      case crab::domains::OP_AND:  return y.And(z);
+      case crab::domains::OP_OR:   return y.Or(z);
+      case crab::domains::OP_XOR:  return y.Xor(z);
+      case crab::domains::OP_SHL:  return y.Shl(z);
+      case crab::domains::OP_LSHR: return y.LShr(z);
+      case crab::domains::OP_ASHR: return y.AShr(z);
+      default:                     return interval_t::top();
+      }
+    }
+
+    static interval_t eval(crab::domains::div_operation_t op, interval_t y, interval_t z) {
+      switch (op) {
+      case crab::domains::OP_SDIV: return y.SDiv(z);
+      case crab::domains::OP_UDIV: return y.UDiv(z);
+      case crab::domains::OP_SREM: return y.SRem(z);
+      case crab::domains::OP_UREM: return y.URem(z);
+      default:                     return interval_t::top();
+      }
+    }
+
+  public:
+
+    dense_interval_domain(): m_is_bottom(false), m_base(0) {}
+
+    static dense_interval_domain_t top() { return dense_interval_domain_t(false); }
+
+    static dense_interval_domain_t bottom() { return dense_interval_domain_t(true); }
+
+    void set_to_top() {
+      m_is_bottom = false;
+      m_base = 0;
+      m_lo.clear();
+      m_hi.clear();
+      m_wide.clear();
+    }
+
+    void set_to_bottom() {
+      set_to_top();
+      m_is_bottom = true;
+    }
+
+    bool is_bottom() { return m_is_bottom; }
+
+    bool is_top() {
+      if (m_is_bottom || !m_wide.empty()) return false;
+      const int64_t *lo = m_lo.data();
+      const int64_t *hi = m_hi.data();
+      std::size_t n = m_lo.size();
+      bool res = true;
+      for (std::size_t k = 0; k < n; ++k) {
+	res &= (lo[k] == minus_inf()) & (hi[k] == plus_inf());
+      }
+      return res;
+    }
+
+    interval_t operator[](variable_t v) const {
+      return (m_is_bottom ? interval_t::bottom() : get(v.index()));
+    }
+
+    void set(variable_t v, interval_t x) {
+      if (m_is_bottom) return;
+      if (x.is_bottom()) {
+	set_to_bottom();
+	return;
+      }
+      if (!x.is_top()) {
+	registry_t::get().add(v);
+      }
+      set_slot(v.index(), x);
+    }
+
+    bool operator<=(dense_interval_domain_t o) {
+      if (m_is_bottom) return true;
+      if (o.m_is_bottom) return false;
+      align(o);
+      const int64_t *lo = m_lo.data(), *hi = m_hi.data();
+      const int64_t *olo = o.m_lo.data(), *ohi = o.m_hi.data();
+      std::size_t n = m_lo.size();
+      bool res = true;
+      for (std::size_t k = 0; k < n; ++k) {
+	res &= (lo[k] >= olo[k]) & (hi[k] <= ohi[k]);
+      }
+      if (!res) return false;
+      // -- the slots of wide values of o are top
+      for (auto &kv: o.m_wide) {
+	if (!(get(kv.first) <= kv.second)) return false;
+      }
+      return true;
+    }
+
+    void operator|=(dense_interval_domain_t o) {
+      *this = *this | o;
+    }
+
+    dense_interval_domain_t operator|(dense_interval_domain_t o) {
+      if (m_is_bottom) return o;
+      if (o.m_is_bottom) return *this;
+      dense_interval_domain_t res(*this);
+      res.align(o);
+      slot_values_t wide =
+	res.wide_slots(o, [](interval_t x, interval_t y) { return x | y; });
+      int64_t *lo = res.m_lo.data(), *hi = res.m_hi.data();
+      const int64_t *olo = o.m_lo.data(), *ohi = o.m_hi.data();
+      std::size_t n = res.m_lo.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	lo[k] = std::min(lo[k], olo[k]);
+	hi[k] = std::max(hi[k], ohi[k]);
+      }
+      res.set_wide_slots(wide);
+      return res;
+    }
+
+    dense_interval_domain_t operator&(dense_interval_domain_t o) {
+      if (m_is_bottom || o.m_is_bottom) return bottom();
+      dense_interval_domain_t res(*this);
+      res.align(o);
+      slot_values_t wide =
+	res.wide_slots(o, [](interval_t x, interval_t y) { return x & y; });
+      int64_t *lo = res.m_lo.data(), *hi = res.m_hi.data();
+      const int64_t *olo = o.m_lo.data(), *ohi = o.m_hi.data();
+      std::size_t n = res.m_lo.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	lo[k] = std::max(lo[k], olo[k]);
+	hi[k] = std::min(hi[k], ohi[k]);
+      }
+      if (res.has_empty_slot()) return bottom();
+      res.set_wide_slots(wide);
+      return res;
+    }
+
+    dense_interval_domain_t operator||(dense_interval_domain_t o) {
+      if (m_is_bottom) return o;
+      if (o.m_is_bottom) return *this;
+      dense_interval_domain_t res(*this);
+      res.align(o);
+      slot_values_t wide =
+	res.wide_slots(o, [](interval_t x, interval_t y) { return x || y; });
+      int64_t *lo = res.m_lo.data(), *hi = res.m_hi.data();
+      const int64_t *olo = o.m_lo.data(), *ohi = o.m_hi.data();
+      std::size_t n = res.m_lo.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	lo[k] = (olo[k] < lo[k] ? minus_inf() : lo[k]);
+	hi[k] = (ohi[k] > hi[k] ? plus_inf() : hi[k]);
+      }
+      res.set_wide_slots(wide);
+      return res;
+    }
+
+    template<typename Thresholds>
+    dense_interval_domain_t widening_thresholds(dense_interval_domain_t o,
+						const Thresholds &ts) {
+      if (m_is_bottom) return o;
+      if (o.m_is_bottom) return *this;
+      dense_interval_domain_t res(*this);
+      res.align(o);
+      slot_values_t wide =
+	res.wide_slots(o, [&ts](interval_t x, interval_t y) {
+	    return x.widening_thresholds(y, ts);
+	  });
+      // -- only the unstable slots are widened with thresholds
+      std::size_t n = res.m_lo.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	if (o.m_lo[k] < res.m_lo[k] || o.m_hi[k] > res.m_hi[k]) {
+	  std::size_t i = res.m_base + k;
+	  if (res.m_wide.count(i) == 0 && o.m_wide.count(i) == 0) {
+	    wide.push_back(std::make_pair(i, res.get(i).widening_thresholds(o.get(i), ts)));
+	  }
+	}
+      }
+      res.set_wide_slots(wide);
+      return res;
+    }
+
+    dense_interval_domain_t operator&&(dense_interval_domain_t o) {
+      if (m_is_bottom || o.m_is_bottom) return bottom();
+      dense_interval_domain_t res(*this);
+      res.align(o);
+      slot_values_t wide =
+	res.wide_slots(o, [](interval_t x, interval_t y) { return x && y; });
+      int64_t *lo = res.m_lo.data(), *hi = res.m_hi.data();
+      const int64_t *olo = o.m_lo.data(), *ohi = o.m_hi.data();
+      std::size_t n = res.m_lo.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	lo[k] = (lo[k] == minus_inf() ? olo[k] : lo[k]);
+	hi[k] = (hi[k] == plus_inf() ? ohi[k] : hi[k]);
+      }
+      if (res.has_empty_slot()) return bottom();
+      res.set_wide_slots(wide);
+      return res;
+    }
+
+    void operator-=(variable_t v) {
+      if (m_is_bottom) return;
+      set_slot(v.index(), interval_t::top());
+    }
+
+    void operator+=(linear_constraint_system_t csts) {
+      if (m_is_bottom) return;
+      for (unsigned i = 0; i < max_reduction_cycles; ++i) {
+	bool change = false;
+	for (auto const &cst: csts) {
+	  add_constraint(cst, change);
+	  if (m_is_bottom) return;
+	}
+	if (!change) break;
+      }
+    }
+
+    void assign(variable_t x, linear_expression_t e) {
+      if (m_is_bottom) return;
+      set(x, eval(e));
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_bottom) return;
+      set(x, eval(op, get(y.index()), get(z.index())));
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_bottom) return;
+      set(x, eval(op, get(y.index()), interval_t(k)));
+    }
+
+    // sign/zero extension and truncation are assignments
+    void apply(crab::domains::int_conv_operation_t /*op*/, variable_t dst, variable_t src) {
+      if (m_is_bottom) return;
+      set(dst, get(src.index()));
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_bottom) return;
+      set(x, eval(op, get(y.index()), get(z.index())));
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_bottom) return;
+      set(x, eval(op, get(y.index()), interval_t(k)));
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_bottom) return;
+      set(x, eval(op, get(y.index()), get(z.index())));
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_bottom) return;
+      set(x, eval(op, get(y.index()), interval_t(k)));
+    }
+
+    // Backward operations: the value of x before the statement is
+    // unknown but e must be in the interval of x after it.
+    void backward_assign(variable_t x, linear_expression_t e,
+			 dense_interval_domain_t invariant) {
+      if (m_is_bottom) return;
+      interval_t xi = get(x.index());
+      bool x_in_e = false;
+      for (auto t: e) {
+	x_in_e |= (t.second == x);
+      }
+      *this -= x;
+      if (!x_in_e) {
+	linear_constraint_system_t csts;
+	if (boost::optional<Number> lb = xi.lb().number()) {
+	  csts += (e >= *lb);
+	}
+	if (boost::optional<Number> ub = xi.ub().number()) {
+	  csts += (e <= *ub);
+	}
+	*this += csts;
+      }
+      *this = *this & invariant;
+    }
+
+    void backward_apply(crab::domains::operation_t /*op*/,
+			variable_t x, variable_t /*y*/, Number /*z*/,
+			dense_interval_domain_t invariant) {
+      if (m_is_bottom) return;
+      *this -= x;
+      *this = *this & invariant;
+    }
+
+    void backward_apply(crab::domains::operation_t /*op*/,
+			variable_t x, variable_t /*y*/, variable_t /*z*/,
+			dense_interval_domain_t invariant) {
+      if (m_is_bottom) return;
+      *this -= x;
+      *this = *this & invariant;
+    }
+
+    /* booleans are not tracked */
+    void assign_bool_cst(variable_t /*lhs*/, linear_constraint_t /*rhs*/) {}
+    void assign_bool_var(variable_t /*lhs*/, variable_t /*rhs*/, bool /*is_not_rhs*/) {}
+    void apply_binary_bool(crab::domains::bool_operation_t /*op*/,
+			   variable_t /*x*/, variable_t /*y*/, variable_t /*z*/) {}
+    void assume_bool(variable_t /*v*/, bool /*is_negated*/) {}
+    void backward_assign_bool_cst(variable_t /*lhs*/, linear_constraint_t /*rhs*/,
+				  dense_interval_domain_t /*invariant*/) {}
+    void backward_assign_bool_var(variable_t /*lhs*/, variable_t /*rhs*/, bool /*is_not_rhs*/,
+				  dense_interval_domain_t /*invariant*/) {}
+    void backward_apply_binary_bool(crab::domains::bool_operation_t /*op*/,
+				    variable_t /*x*/, variable_t /*y*/, variable_t /*z*/,
+				    dense_interval_domain_t /*invariant*/) {}
+
+    /* arrays are handled by array_smashing */
+    void array_init(variable_t /*a*/, linear_expression_t /*elem_size*/,
+		    linear_expression_t /*lb_idx*/, linear_expression_t /*ub_idx*/,
+		    linear_expression_t /*val*/) {}
+    void array_load(variable_t lhs, variable_t /*a*/,
+		    linear_expression_t /*elem_size*/, linear_expression_t /*i*/) {
+      *this -= lhs;
+    }
+    void array_store(variable_t /*a*/, linear_expression_t /*elem_size*/,
+		     linear_expression_t /*i*/, linear_expression_t /*v*/,
+		     bool /*is_singleton*/) {}
+    void array_assign(variable_t /*lhs*/, variable_t /*rhs*/) {}
+
+    /* pointers are not tracked */
+    void pointer_load(variable_t /*lhs*/, variable_t /*rhs*/) {}
+    void pointer_store(variable_t /*lhs*/, variable_t /*rhs*/) {}
+    void pointer_assign(variable_t /*lhs*/, variable_t /*rhs*/, linear_expression_t /*offset*/) {}
+    void pointer_mk_obj(variable_t /*lhs*/, ikos::index_t /*address*/) {}
+    void pointer_function(variable_t /*lhs*/, VariableName /*func*/) {}
+    void pointer_mk_null(variable_t /*lhs*/) {}
+    void pointer_assume(pointer_constraint_t /*cst*/) {}
+    void pointer_assert(pointer_constraint_t /*cst*/) {}
+
+    void forget(const variable_vector_t& vars) {
+      if (m_is_bottom) return;
+      for (auto const &v: vars) {
+	*this -= v;
+      }
+    }
+
+    void project(const variable_vector_t& vars) {
+      if (m_is_bottom) return;
+      slot_values_t vals;
+      for (auto const &v: vars) {
+	vals.push_back(std::make_pair(v.index(), get(v.index())));
+      }
+      set_to_top();
+      for (auto &kv: vals) {
+	set_slot(kv.first, kv.second);
+      }
+    }
+
+    void expand(variable_t x, variable_t new_x) {
+      if (m_is_bottom) return;
+      set(new_x, get(x.index()));
+    }
+
+    void normalize() {}
+
+    linear_constraint_system_t to_linear_constraint_system() {
+      linear_constraint_system_t csts;
+      if (m_is_bottom) {
+	csts += linear_constraint_t::get_false();
+	return csts;
+      }
+      registry_t &vars = registry_t::get();
+      for (std::size_t i = m_base; i < end(); ++i) {
+	interval_t x = get(i);
+	if (x.is_top()) continue;
+	const variable_t *v = vars.find(i);
+	if (!v) continue;
+	linear_expression_t e(*v);
+	boost::optional<Number> lb = x.lb().number();
+	boost::optional<Number> ub = x.ub().number();
+	if (lb && ub && *lb == *ub) {
+	  csts += (e == *lb);
+	} else {
+	  if (lb) csts += (e >= *lb);
+	  if (ub) csts += (e <= *ub);
+	}
+      }
+      return csts;
+    }
+
+    void write(crab::crab_os& o) {
+      if (m_is_bottom) {
+	o << "_|_";
+	return;
+      }
+      registry_t &vars = registry_t::get();
+      o << "{";
+      bool first = true;
+      for (std::size_t i = m_base; i < end(); ++i) {
+	interval_t x = get(i);
+	if (x.is_top()) continue;
+	const variable_t *v = vars.find(i);
+	if (!v) continue;
+	if (!first) o << "; ";
+	first = false;
+	o << *v << " -> " << x;
+      }
+      o << "}";
+    }
+
+    static std::string getDomainName() {
+      return "Dense Intervals";
+    }
+  };
+
+} // end namespace crab_llvm
+#endif
@@ -0,0 +1,1068 @@
+#ifndef __DENSE_ZONES_DOMAIN_HH__
+#define __DENSE_ZONES_DOMAIN_HH__
+
+#include "crab/config.h"
+#include "crab/common/types.hpp"
+#include "crab/domains/intervals.hpp"
+#include "crab_llvm/fast_zones_domain.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Zones with a dense representation for small and dense states.
+ *
+ * SplitDBM is a sparse graph: it is the right choice when most
+ * variables are unrelated, but when a loop keeps a few dozens of
+ * variables all related to each other its closure walks adjacency
+ * maps. Here such a value is a difference-bound matrix stored as a
+ * row-major int64 matrix. The closure and the incremental closure
+ * after adding one edge are loops over rows that the compiler can
+ * vectorize, and the lattice operations are element-wise.
+ *
+ * A value is a zones-fast value (fast_zones_domain) until a widening
+ * produces a state with at most max_dense_vars variables and at least
+ * half of all the possible edges. It stays dense until it has too many
+ * variables, too few edges at a join, or weights that do not fit.
+ * The conversions go through linear constraints, which both
+ * representations keep exactly.
+ */
+
+namespace crab_llvm {
+
+  namespace zones_impl {
+
+    /*
+     * Closed difference-bound matrix with int64 weights over a small
+     * set of variables. Vertex 0 is the constant 0 and the vertex
+     * i > 0 is m_vars[i-1]. The weight of the edge (i, j) is an upper
+     * bound of v_j - v_i (inf if there is none). The value is kept
+     * closed except after a widening.
+     */
+    template<typename Number, typename VariableName>
+    class dense_dbm {
+    public:
+      typedef dense_dbm<Number, VariableName> dense_dbm_t;
+      typedef ikos::variable<Number, VariableName> variable_t;
+      typedef ikos::linear_expression<Number, VariableName> linear_expression_t;
+      typedef ikos::linear_constraint<Number, VariableName> linear_constraint_t;
+      typedef ikos::linear_constraint_system<Number, VariableName> linear_constraint_system_t;
+      typedef ikos::interval<Number> interval_t;
+      typedef ikos::bound<Number> bound_t;
+
+      static int64_t inf() { return INT64_MAX; }
+
+      // Finite weights are kept within +-2^53. The sum of two weights
+      // then cannot overflow and, with the check of the diagonal after
+      // each pivot of the closure, neither can the paths of up to
+      // max_dense_vars edges.
+      static bool fits(const Number &n) {
+	static const Number min("-9007199254740992");
+	static const Number max("9007199254740992");
+	return n >= min && n <= max;
+      }
+
+      static bool fits(const linear_expression_t &e) {
+	if (!fits(e.constant())) return false;
+	for (auto t: e) {
+	  if (!fits(t.first)) return false;
+	}
+	return true;
+      }
+
+      static bool fits(const linear_constraint_system_t &csts) {
+	for (auto const &cst: csts) {
+	  if (!fits(cst.expression())) return false;
+	}
+	return true;
+      }
+
+    private:
+
+      bool m_is_bottom;
+      bool m_is_closed;
+      // set if some weight does not fit anymore (see fits)
+      bool m_overflow;
+      std::vector<variable_t> m_vars;
+      std::vector<int64_t> m_w;
+
+      explicit dense_dbm(bool is_bottom)
+	: m_is_bottom(is_bottom), m_is_closed(true), m_overflow(false), m_w(1, 0) {}
+
+      std::size_t dim() const { return m_vars.size() + 1; }
+
+      int64_t &at(std::size_t i, std::size_t j) { return m_w[i * dim() + j]; }
+
+      int64_t at(std::size_t i, std::size_t j) const { return m_w[i * dim() + j]; }
+
+      static int64_t to_weight(const Number &n) { return (int64_t) (long) n; }
+
+      static bool to_weight(const bound_t &b, int64_t &w) {
+	if (b.is_infinite()) return false;
+	Number n = *(b.number());
+	if (!fits(n)) return false;
+	w = to_weight(n);
+	return true;
+      }
+
+      // vertex of v (0 if it has none)
+      std::size_t find(const variable_t &v) const {
+	for (std::size_t k = 0, n = m_vars.size(); k < n; ++k) {
+	  if (m_vars[k] == v) return k + 1;
+	}
+	return 0;
+      }
+
+      // vertex of v, added unconstrained if it has none
+      std::size_t ensure(const variable_t &v) {
+	std::size_t i = find(v);
+	if (i > 0) return i;
+	std::size_t d = dim();
+	std::vector<int64_t> w((d + 1) * (d + 1), inf());
+	for (std::size_t a = 0; a < d; ++a) {
+	  std::copy(&m_w[a * d], &m_w[a * d] + d, &w[a * (d + 1)]);
+	}
+	w[d * (d + 1) + d] = 0;
+	m_w.swap(w);
+	m_vars.push_back(v);
+	return d;
+      }
+
+      // The same value over vars (a superset of m_vars)
+      dense_dbm_t reindex(const std::vector<variable_t> &vars) const {
+	dense_dbm_t res(m_is_bottom);
+	res.m_is_closed = m_is_closed;
+	res.m_vars = vars;
+	std::size_t d = vars.size() + 1;
+	res.m_w.assign(d * d, inf());
+	std::vector<std::size_t> old(d, 0);
+	for (std::size_t k = 0; k < vars.size(); ++k) old[k + 1] = find(vars[k]);
+	for (std::size_t a = 0; a < d; ++a) {
+	  for (std::size_t b = 0; b < d; ++b) {
+	    if (a == b) res.m_w[a * d + b] = 0;
+	    else if ((a == 0 || old[a] > 0) && (b == 0 || old[b] > 0)) {
+	      res.m_w[a * d + b] = at(old[a], old[b]);
+	    }
+	  }
+	}
+	return res;
+      }
+
+      // Make both values range over the same vertices
+      static void align(dense_dbm_t &x, dense_dbm_t &y) {
+	if (x.m_vars == y.m_vars) return;
+	std::vector<variable_t> vars(x.m_vars);
+	for (auto const &v: y.m_vars) {
+	  if (x.find(v) == 0) vars.push_back(v);
+	}
+	if (vars != x.m_vars) x = x.reindex(vars);
+	y = y.reindex(vars);
+      }
+
+      void check_overflow() {
+	static const int64_t max = 9007199254740992LL;
+	const int64_t *w = m_w.data();
+	bool res = false;
+	for (std::size_t k = 0, n = m_w.size(); k < n; ++k) {
+	  res |= (w[k] != inf()) & ((w[k] > max) | (w[k] < -max));
+	}
+	m_overflow |= res;
+      }
+
+      // Floyd-Warshall. A negative cycle shows up on the diagonal
+      // after the pivot of its largest vertex.
+      void close() {
+	if (m_is_bottom || m_is_closed) return;
+	std::size_t d = dim();
+	for (std::size_t k = 0; k < d; ++k) {
+	  const int64_t *rk = &m_w[k * d];
+	  for (std::size_t i = 0; i < d; ++i) {
+	    int64_t wik = m_w[i * d + k];
+	    if (wik == inf()) continue;
+	    int64_t *ri = &m_w[i * d];
+	    for (std::size_t j = 0; j < d; ++j) {
+	      int64_t t = (rk[j] == inf() ? inf() : wik + rk[j]);
+	      ri[j] = std::min(ri[j], t);
+	    }
+	  }
+	  for (std::size_t i = 0; i < d; ++i) {
+	    if (m_w[i * d + i] < 0) {
+	      set_to_bottom();
+	      return;
+	    }
+	  }
+	}
+	m_is_closed = true;
+	check_overflow();
+      }
+
+      // Add v_j - v_i <= c. If the value is closed it stays closed
+      // with the paths through the new edge.
+      void add_edge(std::size_t i, std::size_t j, int64_t c) {
+	if (m_is_bottom || c >= at(i, j)) return;
+	if (!m_is_closed) {
+	  at(i, j) = c;
+	  close();
+	  return;
+	}
+	if (at(j, i) != inf() && at(j, i) + c < 0) {
+	  set_to_bottom();
+	  return;
+	}
+	std::size_t d = dim();
+	const int64_t *rj = &m_w[j * d];
+	for (std::size_t a = 0; a < d; ++a) {
+	  int64_t wai = m_w[a * d + i];
+	  if (wai == inf()) continue;
+	  int64_t t0 = wai + c;
+	  int64_t *ra = &m_w[a * d];
+	  for (std::size_t b = 0; b < d; ++b) {
+	    int64_t t = (rj[b] == inf() ? inf() : t0 + rj[b]);
+	    ra[b] = std::min(ra[b], t);
+	  }
+	}
+	check_overflow();
+      }
+
+      void set_bounds(std::size_t i, const interval_t &x) {
+	int64_t w;
+	if (to_weight(x.ub(), w)) add_edge(0, i, w);
+	if (!m_is_bottom && to_weight(x.lb(), w)) add_edge(i, 0, -w);
+      }
+
+      interval_t get(std::size_t i) const {
+	if (i == 0) return interval_t::top();
+	int64_t ub = at(0, i), lb = at(i, 0);
+	return interval_t(ub == inf() ? bound_t::plus_infinity() : bound_t(Number((long) ub)),
+			  lb == inf() ? bound_t::minus_infinity() : bound_t(Number((long) -lb)));
+      }
+
+      interval_t eval(const linear_expression_t &e) {
+	interval_t r(e.constant());
+	for (auto t: e) {
+	  r = r + interval_t(t.first) * (*this)[t.second];
+	}
+	return r;
+      }
+
+      // Refine the bounds of the variables of e <= 0 with the bounds
+      // of the others
+      void refine_leq(const linear_expression_t &e) {
+	for (auto t: e) {
+	  Number a = t.first;
+	  interval_t rest(e.constant());
+	  for (auto u: e) {
+	    if (u.second == t.second) continue;
+	    rest = rest + interval_t(u.first) * (*this)[u.second];
+	  }
+	  bound_t r = rest.lb();
+	  if (r.is_infinite()) continue;
+	  // -- a*x <= -rest.lb
+	  Number k = Number(0) - *(r.number());
+	  Number q = k / a;
+	  Number m = k % a;
+	  if (a > 0) {
+	    if (m != 0 && ((m < 0) != (a < 0))) q = q - 1;
+	    set_bounds(ensure(t.second), interval_t(bound_t::minus_infinity(), bound_t(q)));
+	  } else {
+	    if (m != 0 && ((m < 0) == (a < 0))) q = q + 1;
+	    set_bounds(ensure(t.second), interval_t(bound_t(q), bound_t::plus_infinity()));
+	  }
+	  if (m_is_bottom) return;
+	}
+      }
+
+      void add_leq(const linear_expression_t &e) {
+	// -- x - y + c <= 0, x + c <= 0 and -x + c <= 0 are edges
+	std::size_t n = std::distance(e.begin(), e.end());
+	Number c = e.constant();
+	if (n == 1) {
+	  auto t = *(e.begin());
+	  if (t.first == 1) {
+	    add_edge(0, ensure(t.second), to_weight(Number(0) - c));
+	    return;
+	  } else if (t.first == -1) {
+	    add_edge(ensure(t.second), 0, to_weight(Number(0) - c));
+	    return;
+	  }
+	} else if (n == 2) {
+	  auto it = e.begin();
+	  auto t1 = *it;
+	  auto t2 = *(++it);
+	  if (t1.first == -t2.first && (t1.first == 1 || t1.first == -1)) {
+	    const variable_t &x = (t1.first == 1 ? t1.second : t2.second);
+	    const variable_t &y = (t1.first == 1 ? t2.second : t1.second);
+	    std::size_t j = ensure(x);
+	    std::size_t i = ensure(y);
+	    add_edge(i, j, to_weight(Number(0) - c));
+	    return;
+	  }
+	}
+	refine_leq(e);
+      }
+
+      // a*x + c != 0 only refines a bound of x
+      void add_neq(const linear_expression_t &e) {
+	if (std::distance(e.begin(), e.end()) != 1) return;
+	auto t = *(e.begin());
+	Number a = t.first;
+	Number c = Number(0) - e.constant();
+	if (a == 0 || c % a != 0) return;
+	Number k = c / a;
+	interval_t old = (*this)[t.second];
+	boost::optional<Number> lb = old.lb().number();
+	boost::optional<Number> ub = old.ub().number();
+	if (lb && *lb == k) {
+	  set_bounds(ensure(t.second), interval_t(bound_t(k + 1), old.ub()));
+	} else if (ub && *ub == k) {
+	  set_bounds(ensure(t.second), interval_t(old.lb(), bound_t(k - 1)));
+	}
+      }
+
+    public:
+
+      dense_dbm(): m_is_bottom(false), m_is_closed(true), m_overflow(false), m_w(1, 0) {}
+
+      static dense_dbm_t top() { return dense_dbm_t(false); }
+
+      static dense_dbm_t bottom() { return dense_dbm_t(true); }
+
+      void set_to_top() { *this = top(); }
+
+      void set_to_bottom() { *this = bottom(); }
+
+      bool is_bottom() const { return m_is_bottom; }
+
+      bool is_top() {
+	if (m_is_bottom) return false;
+	close();
+	return !m_is_bottom && num_edges() == 0;
+      }
+
+      bool overflow() const { return m_overflow; }
+
+      std::size_t num_vars() const { return m_vars.size(); }
+
+      // number of finite weights out of the diagonal
+      std::size_t num_edges() const {
+	std::size_t res = 0;
+	for (std::size_t k = 0, n = m_w.size(); k < n; ++k) {
+	  res += (m_w[k] != inf());
+	}
+	return res - dim();
+      }
+
+      interval_t operator[](const variable_t &v) {
+	if (m_is_bottom) return interval_t::bottom();
+	close();
+	if (m_is_bottom) return interval_t::bottom();
+	return get(find(v));
+      }
+
+      bool operator<=(dense_dbm_t o) {
+	if (m_is_bottom) return true;
+	dense_dbm_t x(*this);
+	x.close();
+	if (x.m_is_bottom) return true;
+	if (o.m_is_bottom) return false;
+	align(x, o);
+	const int64_t *w = x.m_w.data(), *ow = o.m_w.data();
+	bool res = true;
+	for (std::size_t k = 0, n = x.m_w.size(); k < n; ++k) {
+	  res &= (w[k] <= ow[k]);
+	}
+	return res;
+      }
+
+      dense_dbm_t operator|(dense_dbm_t o) {
+	dense_dbm_t res(*this);
+	res.close();
+	o.close();
+	if (res.m_is_bottom) return o;
+	if (o.m_is_bottom) return res;
+	align(res, o);
+	int64_t *w = res.m_w.data();
+	const int64_t *ow = o.m_w.data();
+	for (std::size_t k = 0, n = res.m_w.size(); k < n; ++k) {
+	  w[k] = std::max(w[k], ow[k]);
+	}
+	res.m_overflow |= o.m_overflow;
+	return res;
+      }
+
+      dense_dbm_t operator&(dense_dbm_t o) {
+	if (m_is_bottom || o.m_is_bottom) return bottom();
+	dense_dbm_t res(*this);
+	align(res, o);
+	int64_t *w = res.m_w.data();
+	const int64_t *ow = o.m_w.data();
+	for (std::size_t k = 0, n = res.m_w.size(); k < n; ++k) {
+	  w[k] = std::min(w[k], ow[k]);
+	}
+	res.m_is_closed = false;
+	res.close();
+	return res;
+      }
+
+      // The result is not closed so that the widening terminates
+      dense_dbm_t operator||(dense_dbm_t o) {
+	if (m_is_bottom) return o;
+	o.close();
+	if (o.m_is_bottom) return *this;
+	dense_dbm_t res(*this);
+	align(res, o);
+	int64_t *w = res.m_w.data();
+	const int64_t *ow = o.m_w.data();
+	for (std::size_t k = 0, n = res.m_w.size(); k < n; ++k) {
+	  w[k] = (ow[k] <= w[k] ? w[k] : inf());
+	}
+	res.m_is_closed = false;
+	return res;
+      }
+
+      dense_dbm_t operator&&(dense_dbm_t o) {
+	if (m_is_bottom || o.m_is_bottom) return bottom();
+	dense_dbm_t res(*this);
+	align(res, o);
+	int64_t *w = res.m_w.data();
+	const int64_t *ow = o.m_w.data();
+	for (std::size_t k = 0, n = res.m_w.size(); k < n; ++k) {
+	  w[k] = (w[k] == inf() ? ow[k] : w[k]);
+	}
+	res.m_is_closed = false;
+	res.close();
+	return res;
+      }
+
+      void operator-=(const variable_t &v) {
+	if (m_is_bottom) return;
+	std::size_t i = find(v);
+	if (i == 0) return;
+	close();
+	if (m_is_bottom) return;
+	std::size_t d = dim();
+	for (std::size_t k = 0; k < d; ++k) {
+	  at(i, k) = inf();
+	  at(k, i) = inf();
+	}
+	at(i, i) = 0;
+      }
+
+      // Precondition: the constants of csts fit
+      void operator+=(const linear_constraint_system_t &csts) {
+	for (auto const &cst: csts) {
+	  if (m_is_bottom) return;
+	  if (cst.is_tautology()) continue;
+	  if (cst.is_contradiction()) {
+	    set_to_bottom();
+	    return;
+	  }
+	  close();
+	  if (m_is_bottom) return;
+	  if (cst.is_inequality()) {
+	    add_leq(cst.expression());
+	  } else if (cst.is_equality()) {
+	    add_leq(cst.expression());
+	    if (!m_is_bottom) add_leq(-cst.expression());
+	  } else if (cst.is_disequation()) {
+	    add_neq(cst.expression());
+	  }
+	  // other constraints are ignored (sound)
+	}
+      }
+
+      void set(const variable_t &x, const interval_t &i) {
+	if (m_is_bottom) return;
+	if (i.is_bottom()) {
+	  set_to_bottom();
+	  return;
+	}
+	*this -= x;
+	if (m_is_bottom || i.is_top()) return;
+	set_bounds(ensure(x), i);
+      }
+
+      // Precondition: the constants of e fit. Besides its bounds, x
+      // is related with each variable y of e with coefficient 1 by
+      // the bounds of e - y.
+      void assign(const variable_t &x, const linear_expression_t &e) {
+	if (m_is_bottom) return;
+	close();
+	if (m_is_bottom) return;
+	// -- x := x + k keeps the value closed
+	if (std::distance(e.begin(), e.end()) == 1 && (*e.begin()).first == 1 &&
+	    (*e.begin()).second == x) {
+	  std::size_t i = find(x);
+	  if (i == 0) return;
+	  int64_t k = to_weight(e.constant());
+	  for (std::size_t j = 0, d = dim(); j < d; ++j) {
+	    if (j == i) continue;
+	    if (at(i, j) != inf()) at(i, j) -= k;
+	    if (at(j, i) != inf()) at(j, i) += k;
+	  }
+	  check_overflow();
+	  return;
+	}
+	interval_t ei = eval(e);
+	std::vector<std::pair<variable_t, interval_t>> diffs;
+	for (auto t: e) {
+	  if (t.first != 1 || t.second == x) continue;
+	  diffs.push_back(std::make_pair(t.second, eval(e - t.second)));
+	}
+	set(x, ei);
+	if (m_is_bottom) return;
+	std::size_t i = ensure(x);
+	for (auto &kv: diffs) {
+	  // -- x - y in [lb, ub]
+	  std::size_t j = ensure(kv.first);
+	  int64_t w;
+	  if (to_weight(kv.second.ub(), w)) add_edge(j, i, w);
+	  if (!m_is_bottom && to_weight(kv.second.lb(), w)) add_edge(i, j, -w);
+	  if (m_is_bottom) return;
+	}
+      }
+
+      void project(const std::vector<variable_t> &vars) {
+	if (m_is_bottom) return;
+	close();
+	if (m_is_bottom) return;
+	std::vector<variable_t> keep;
+	for (auto const &v: vars) {
+	  if (find(v) > 0 && std::find(keep.begin(), keep.end(), v) == keep.end()) {
+	    keep.push_back(v);
+	  }
+	}
+	*this = reindex(keep);
+      }
+
+      // new_x gets the constraints of x without being related to it
+      void expand(const variable_t &x, const variable_t &new_x) {
+	if (m_is_bottom) return;
+	*this -= new_x;
+	std::size_t i = find(x);
+	if (m_is_bottom || i == 0) return;
+	std::size_t j = ensure(new_x);
+	for (std::size_t k = 0, d = dim(); k < d; ++k) {
+	  if (k == i || k == j) continue;
+	  at(j, k) = at(i, k);
+	  at(k, j) = at(k, i);
+	}
+	// -- new_x - x <= ub(x) - lb(x)
+	int64_t ub = at(0, i), lb = at(i, 0);
+	at(i, j) = at(j, i) = (ub == inf() || lb == inf() ? inf() : ub + lb);
+	check_overflow();
+      }
+
+      linear_constraint_system_t to_linear_constraint_system() {
+	linear_constraint_system_t csts;
+	close();
+	if (m_is_bottom) {
+	  csts += linear_constraint_t::get_false();
+	  return csts;
+	}
+	std::size_t d = dim();
+	for (std::size_t i = 0; i < d; ++i) {
+	  for (std::size_t j = 0; j < d; ++j) {
+	    int64_t w = at(i, j);
+	    if (i == j || w == inf()) continue;
+	    Number k((long) w);
+	    if (i == 0) {
+	      csts += linear_constraint_t(linear_expression_t(m_vars[j - 1]) <= k);
+	    } else if (j == 0) {
+	      csts += linear_constraint_t(linear_expression_t(m_vars[i - 1]) >= Number(0) - k);
+	    } else {
+	      csts += linear_constraint_t(linear_expression_t(m_vars[j - 1]) -
+					  linear_expression_t(m_vars[i - 1]) <= k);
+	    }
+	  }
+	}
+	return csts;
+      }
+    };
+  } // end namespace zones_impl
+
+  template<typename Number, typename VariableName>
+  class dense_zones_domain:
+    public crab::domains::abstract_domain<Number, VariableName,
+					  dense_zones_domain<Number,VariableName>> {
+  public:
+
+    typedef dense_zones_domain<Number, VariableName> dense_zones_domain_t;
+    typedef crab::domains::abstract_domain<Number, VariableName,
+					   dense_zones_domain_t> abstract_domain_t;
+    using typename abstract_domain_t::linear_expression_t;
+    using typename abstract_domain_t::linear_constraint_t;
+    using typename abstract_domain_t::linear_constraint_system_t;
+    using typename abstract_domain_t::variable_t;
+    using typename abstract_domain_t::variable_vector_t;
+    using typename abstract_domain_t::pointer_constraint_t;
+    typedef Number number_t;
+    typedef VariableName varname_t;
+    typedef ikos::interval<Number> interval_t;
+
+    typedef fast_zones_domain<Number, VariableName> sparse_dom_t;
+    typedef zones_impl::dense_dbm<Number, VariableName> dense_dom_t;
+
+    // a dense value has at most this number of variables
+    static const std::size_t max_dense_vars = 64;
+    // a widened value with fewer variables stays sparse
+    static const std::size_t min_dense_vars = 8;
+
+  private:
+
+    bool m_is_dense;
+    sparse_dom_t m_sparse;
+    dense_dom_t m_dense;
+
+    dense_zones_domain(sparse_dom_t sparse)
+      : m_is_dense(false), m_sparse(sparse), m_dense(dense_dom_t::top()) {}
+
+    dense_zones_domain(dense_dom_t dense)
+      : m_is_dense(true), m_sparse(sparse_dom_t::top()), m_dense(dense) {
+      check_dense();
+    }
+
+    void to_sparse() {
+      if (!m_is_dense) return;
+      if (m_dense.is_bottom()) {
+	m_sparse = sparse_dom_t::bottom();
+      } else {
+	m_sparse = sparse_dom_t::top();
+	m_sparse += m_dense.to_linear_constraint_system();
+      }
+      m_dense = dense_dom_t::top();
+      m_is_dense = false;
+    }
+
+    // Convert the value into a dense one if it has at most max_vars
+    // variables and at least min_density of all the possible edges.
+    // Return true if it is dense.
+    bool to_dense(std::size_t min_vars, double min_density) {
+      if (m_is_dense) return true;
+      if (m_sparse.is_bottom()) return false;
+      linear_constraint_system_t csts = m_sparse.to_linear_constraint_system();
+      std::vector<variable_t> vars;
+      std::size_t num_csts = 0;
+      for (auto const &cst: csts) {
+	for (auto t: cst.expression()) {
+	  if (std::find(vars.begin(), vars.end(), t.second) == vars.end()) {
+	    vars.push_back(t.second);
+	    if (vars.size() > max_dense_vars) return false;
+	  }
+	}
+	num_csts += (cst.is_equality() ? 2 : 1);
+      }
+      std::size_t n = vars.size();
+      if (n < min_vars || (double) num_csts < min_density * n * (n + 1)) return false;
+      if (!dense_dom_t::fits(csts)) return false;
+      m_dense = dense_dom_t::top();
+      m_dense += csts;
+      m_sparse = sparse_dom_t::top();
+      m_is_dense = true;
+      return true;
+    }
+
+    // A dense value whose weights or variables do not fit anymore
+    // goes back to sparse
+    void check_dense() {
+      if (m_is_dense && (m_dense.overflow() || m_dense.num_vars() > max_dense_vars)) {
+	to_sparse();
+      }
+    }
+
+    // After a join: too few edges go back to sparse. After a
+    // widening: a small and dense enough state becomes dense.
+    void rebalance(bool widened) {
+      if (m_is_dense) {
+	std::size_t n = m_dense.num_vars();
+	if (!m_dense.is_bottom() && (double) m_dense.num_edges() < 0.25 * n * (n + 1)) {
+	  to_sparse();
+	}
+      } else if (widened) {
+	to_dense(min_dense_vars, 0.5);
+      }
+    }
+
+    // Both values with the same representation: dense if the sparse
+    // one fits, otherwise sparse
+    static void unify(dense_zones_domain_t &a, dense_zones_domain_t &b) {
+      if (a.m_is_dense == b.m_is_dense) return;
+      dense_zones_domain_t &s = (a.m_is_dense ? b : a);
+      dense_zones_domain_t &d = (a.m_is_dense ? a : b);
+      if (!s.to_dense(0, 0.0)) {
+	d.to_sparse();
+      } else if (s.m_dense.num_vars() + d.m_dense.num_vars() > max_dense_vars) {
+	a.to_sparse();
+	b.to_sparse();
+      }
+    }
+
+    // The dense value can only take constants that fit
+    void ensure(bool fits) {
+      if (!fits) to_sparse();
+    }
+
+    static interval_t eval(crab::domains::operation_t op, interval_t y, interval_t z) {
+      switch (op) {
+      case crab::domains::OP_ADDITION:       return y + z;
+      case crab::domains::OP_SUBTRACTION:    return y - z;
+      case crab::domains::OP_MULTIPLICATION: return y * z;
+      case crab::domains::OP_DIVISION:       return y / z;
+      default:                               return interval_t::top();
+      }
+    }
+
+    static interval_t eval(crab::domains::bitwise_operation_t op, interval_t y, interval_t z) {
+      switch (op) {
+      case crab::domains::OP_AND:  return y.And(z);
+      case crab::domains::OP_OR:   return y.Or(z);
+      case crab::domains::OP_XOR:  return y.Xor(z);
+      case crab::domains::OP_SHL:  return y.Shl(z);
+      case crab::domains::OP_LSHR: return y.LShr(z);
+      case crab::domains::OP_ASHR: return y.AShr(z);
+      default:                     return interval_t::top();
+      }
+    }
+
+    static interval_t eval(crab::domains::div_operation_t op, interval_t y, interval_t z) {
+      switch (op) {
+      case crab::domains::OP_SDIV: return y.SDiv(z);
+      case crab::domains::OP_UDIV: return y.UDiv(z);
+      case crab::domains::OP_SREM: return y.SRem(z);
+      case crab::domains::OP_UREM: return y.URem(z);
+      default:                     return interval_t::top();
+      }
+    }
+
+    // x := y op k in the dense value
+    template<typename Op>
+    void dense_apply(Op op, variable_t x, variable_t y, interval_t k) {
+      m_dense.set(x, eval(op, m_dense[y], k));
+      check_dense();
+    }
+
+    void dense_apply(crab::domains::operation_t op, variable_t x, variable_t y, interval_t k) {
+      boost::optional<Number> n = k.singleton();
+      if (n && (op == crab::domains::OP_ADDITION || op == crab::domains::OP_SUBTRACTION)) {
+	linear_expression_t e(y);
+	m_dense.assign(x, op == crab::domains::OP_ADDITION ? e + *n : e - *n);
+      } else {
+	m_dense.set(x, eval(op, m_dense[y], k));
+      }
+      check_dense();
+    }
+
+    #define DENSE_ZONES_DISPATCH(CALL)		\
+      if (m_is_dense) { m_dense.CALL; check_dense(); }	\
+      else { m_sparse.CALL; }
+
+  public:
+
+    dense_zones_domain()
+      : m_is_dense(false), m_sparse(sparse_dom_t::top()), m_dense(dense_dom_t::top()) {}
+
+    static dense_zones_domain_t top() { return dense_zones_domain_t(sparse_dom_t::top()); }
+
+    static dense_zones_domain_t bottom() { return dense_zones_domain_t(sparse_dom_t::bottom()); }
+
+    // Return true if the value is a dense matrix
+    bool is_dense() const { return m_is_dense; }
+
+    void set_to_top() { *this = top(); }
+
+    void set_to_bottom() { *this = bottom(); }
+
+    bool is_bottom() { return m_is_dense ? m_dense.is_bottom() : m_sparse.is_bottom(); }
+
+    bool is_top() { return m_is_dense ? m_dense.is_top() : m_sparse.is_top(); }
+
+    interval_t operator[](variable_t v) {
+      return m_is_dense ? m_dense[v] : m_sparse[v];
+    }
+
+    bool operator<=(dense_zones_domain_t o) {
+      dense_zones_domain_t a(*this);
+      unify(a, o);
+      return a.m_is_dense ? a.m_dense <= o.m_dense : a.m_sparse <= o.m_sparse;
+    }
+
+    void operator|=(dense_zones_domain_t o) {
+      *this = *this | o;
+    }
+
+    dense_zones_domain_t operator|(dense_zones_domain_t o) {
+      dense_zones_domain_t a(*this);
+      unify(a, o);
+      dense_zones_domain_t res = (a.m_is_dense ? dense_zones_domain_t(a.m_dense | o.m_dense) :
+				  dense_zones_domain_t(a.m_sparse | o.m_sparse));
+      res.rebalance(false);
+      return res;
+    }
+
+    dense_zones_domain_t operator&(dense_zones_domain_t o) {
+      dense_zones_domain_t a(*this);
+      unify(a, o);
+      if (a.m_is_dense) return dense_zones_domain_t(a.m_dense & o.m_dense);
+      return dense_zones_domain_t(a.m_sparse & o.m_sparse);
+    }
+
+    dense_zones_domain_t operator||(dense_zones_domain_t o) {
+      dense_zones_domain_t a(*this);
+      unify(a, o);
+      dense_zones_domain_t res = (a.m_is_dense ? dense_zones_domain_t(a.m_dense || o.m_dense) :
+				  dense_zones_domain_t(a.m_sparse || o.m_sparse));
+      res.rebalance(true);
+      return res;
+    }
+
+    // The dense values ignore the thresholds
+    template<typename Thresholds>
+    dense_zones_domain_t widening_thresholds(dense_zones_domain_t o, const Thresholds &ts) {
+      dense_zones_domain_t a(*this);
+      unify(a, o);
+      dense_zones_domain_t res = (a.m_is_dense ? dense_zones_domain_t(a.m_dense || o.m_dense) :
+				  dense_zones_domain_t(a.m_sparse.widening_thresholds(o.m_sparse, ts)));
+      res.rebalance(true);
+      return res;
+    }
+
+    dense_zones_domain_t operator&&(dense_zones_domain_t o) {
+      dense_zones_domain_t a(*this);
+      unify(a, o);
+      if (a.m_is_dense) return dense_zones_domain_t(a.m_dense && o.m_dense);
+      return dense_zones_domain_t(a.m_sparse && o.m_sparse);
+    }
+
+    void operator+=(linear_constraint_system_t csts) {
+      ensure(dense_dom_t::fits(csts));
+      DENSE_ZONES_DISPATCH(operator+=(csts))
+    }
+
+    void operator-=(variable_t v) {
+      DENSE_ZONES_DISPATCH(operator-=(v))
+    }
+
+    void assign(variable_t x, linear_expression_t e) {
+      ensure(dense_dom_t::fits(e));
+      DENSE_ZONES_DISPATCH(assign(x, e))
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (!m_is_dense) {
+	m_sparse.apply(op, x, y, z);
+      } else if (op == crab::domains::OP_ADDITION || op == crab::domains::OP_SUBTRACTION) {
+	linear_expression_t e(y);
+	assign(x, op == crab::domains::OP_ADDITION ? e + z : e - z);
+      } else {
+	dense_apply(op, x, y, m_dense[z]);
+      }
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, Number k) {
+      ensure(dense_dom_t::fits(k));
+      if (m_is_dense) dense_apply(op, x, y, interval_t(k));
+      else m_sparse.apply(op, x, y, k);
+    }
+
+    // sign/zero extension and truncation are assignments
+    void apply(crab::domains::int_conv_operation_t op, variable_t dst, variable_t src) {
+      if (m_is_dense) assign(dst, linear_expression_t(src));
+      else m_sparse.apply(op, dst, src);
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_dense) dense_apply(op, x, y, m_dense[z]);
+      else m_sparse.apply(op, x, y, z);
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_dense) dense_apply(op, x, y, interval_t(k));
+      else m_sparse.apply(op, x, y, k);
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_dense) dense_apply(op, x, y, m_dense[z]);
+      else m_sparse.apply(op, x, y, z);
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_dense) dense_apply(op, x, y, interval_t(k));
+      else m_sparse.apply(op, x, y, k);
+    }
+
+    // Backward operations of the dense values: the value of x before
+    // the statement is unknown
+    void backward_assign(variable_t x, linear_expression_t e, dense_zones_domain_t invariant) {
+      unify(*this, invariant);
+      if (m_is_dense) {
+	*this -= x;
+	*this = *this & invariant;
+      } else {
+	m_sparse.backward_assign(x, e, invariant.m_sparse);
+      }
+    }
+
+    void backward_apply(crab::domains::operation_t op, variable_t x, variable_t y, Number z,
+			dense_zones_domain_t invariant) {
+      unify(*this, invariant);
+      if (m_is_dense) {
+	*this -= x;
+	*this = *this & invariant;
+      } else {
+	m_sparse.backward_apply(op, x, y, z, invariant.m_sparse);
+      }
+    }
+
+    void backward_apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z,
+			dense_zones_domain_t invariant) {
+      unify(*this, invariant);
+      if (m_is_dense) {
+	*this -= x;
+	*this = *this & invariant;
+      } else {
+	m_sparse.backward_apply(op, x, y, z, invariant.m_sparse);
+      }
+    }
+
+    /* booleans, arrays and pointers are only tracked by the sparse values */
+
+    void assign_bool_cst(variable_t lhs, linear_constraint_t rhs) {
+      if (!m_is_dense) m_sparse.assign_bool_cst(lhs, rhs);
+    }
+
+    void assign_bool_var(variable_t lhs, variable_t rhs, bool is_not_rhs) {
+      if (!m_is_dense) m_sparse.assign_bool_var(lhs, rhs, is_not_rhs);
+    }
+
+    void apply_binary_bool(crab::domains::bool_operation_t op,
+			   variable_t x, variable_t y, variable_t z) {
+      if (!m_is_dense) m_sparse.apply_binary_bool(op, x, y, z);
+    }
+
+    void assume_bool(variable_t v, bool is_negated) {
+      if (!m_is_dense) m_sparse.assume_bool(v, is_negated);
+    }
+
+    void backward_assign_bool_cst(variable_t lhs, linear_constraint_t rhs,
+				  dense_zones_domain_t invariant) {
+      if (!m_is_dense && !invariant.m_is_dense) {
+	m_sparse.backward_assign_bool_cst(lhs, rhs, invariant.m_sparse);
+      }
+    }
+
+    void backward_assign_bool_var(variable_t lhs, variable_t rhs, bool is_not_rhs,
+				  dense_zones_domain_t invariant) {
+      if (!m_is_dense && !invariant.m_is_dense) {
+	m_sparse.backward_assign_bool_var(lhs, rhs, is_not_rhs, invariant.m_sparse);
+      }
+    }
+
+    void backward_apply_binary_bool(crab::domains::bool_operation_t op,
+				    variable_t x, variable_t y, variable_t z,
+				    dense_zones_domain_t invariant) {
+      if (!m_is_dense && !invariant.m_is_dense) {
+	m_sparse.backward_apply_binary_bool(op, x, y, z, invariant.m_sparse);
+      }
+    }
+
+    void array_init(variable_t a, linear_expression_t elem_size,
+		    linear_expression_t lb_idx, linear_expression_t ub_idx,
+		    linear_expression_t val) {
+      if (!m_is_dense) m_sparse.array_init(a, elem_size, lb_idx, ub_idx, val);
+    }
+
+    void array_load(variable_t lhs, variable_t a,
+		    linear_expression_t elem_size, linear_expression_t i) {
+      if (m_is_dense) *this -= lhs;
+      else m_sparse.array_load(lhs, a, elem_size, i);
+    }
+
+    void array_store(variable_t a, linear_expression_t elem_size,
+		     linear_expression_t i, linear_expression_t v, bool is_singleton) {
+      if (!m_is_dense) m_sparse.array_store(a, elem_size, i, v, is_singleton);
+    }
+
+    void array_assign(variable_t lhs, variable_t rhs) {
+      if (!m_is_dense) m_sparse.array_assign(lhs, rhs);
+    }
+
+    void pointer_load(variable_t lhs, variable_t rhs) {
+      if (!m_is_dense) m_sparse.pointer_load(lhs, rhs);
+    }
+
+    void pointer_store(variable_t lhs, variable_t rhs) {
+      if (!m_is_dense) m_sparse.pointer_store(lhs, rhs);
+    }
+
+    void pointer_assign(variable_t lhs, variable_t rhs, linear_expression_t offset) {
+      if (!m_is_dense) m_sparse.pointer_assign(lhs, rhs, offset);
+    }
+
+    void pointer_mk_obj(variable_t lhs, ikos::index_t address) {
+      if (!m_is_dense) m_sparse.pointer_mk_obj(lhs, address);
+    }
+
+    void pointer_function(variable_t lhs, VariableName func) {
+      if (!m_is_dense) m_sparse.pointer_function(lhs, func);
+    }
+
+    void pointer_mk_null(variable_t lhs) {
+      if (!m_is_dense) m_sparse.pointer_mk_null(lhs);
+    }
+
+    void pointer_assume(pointer_constraint_t cst) {
+      if (!m_is_dense) m_sparse.pointer_assume(cst);
+    }
+
+    void pointer_assert(pointer_constraint_t cst) {
+      if (!m_is_dense) m_sparse.pointer_assert(cst);
+    }
+
+    void forget(const variable_vector_t& vars) {
+      if (m_is_dense) {
+	for (auto const &v: vars) m_dense -= v;
+      } else {
+	m_sparse.forget(vars);
+      }
+    }
+
+    void project(const variable_vector_t& vars) {
+      DENSE_ZONES_DISPATCH(project(vars))
+    }
+
+    void expand(variable_t x, variable_t new_x) {
+      DENSE_ZONES_DISPATCH(expand(x, new_x))
+    }
+
+    void normalize() {
+      if (!m_is_dense) m_sparse.normalize();
+    }
+
+    #undef DENSE_ZONES_DISPATCH
+
+    linear_constraint_system_t to_linear_constraint_system() {
+      return m_is_dense ? m_dense.to_linear_constraint_system() :
+	                  m_sparse.to_linear_constraint_system();
+    }
+
+    void write(crab::crab_os& o) {
+      if (m_is_dense) {
+	if (m_dense.is_bottom()) {
+	  o << "_|_";
+	} else {
+	  o << m_dense.to_linear_constraint_system();
+	}
+      } else {
+	m_sparse.write(o);
+      }
+    }
+
+    static std::string getDomainName() {
+      return "Zones (dense DBM for small dense states)";
+    }
+  };
+
+} // end namespace crab_llvm
+#endif
@@ -0,0 +1,420 @@
+#ifndef __FAST_ZONES_DOMAIN_HH__
+#define __FAST_ZONES_DOMAIN_HH__
+
+#include "crab/config.h"
+#include "crab/common/types.hpp"
+#include "crab/domains/intervals.hpp"
+#include "crab/domains/split_dbm.hpp"
+#include "crab/domains/graphs/adapt_sgraph.hpp"
+
+#include <string>
+
+/*
+ * Zones (SplitDBM) with machine-integer weights.
+ *
+ * A value is a SplitDBM with int64 weights as long as all the
+ * constants that reach it fit in 32 bits. Weights are then sums of
+ * such constants along paths of the graph so they cannot overflow
+ * int64. Before an operation with a larger constant (or whose result
+ * may not fit, like a multiplication) the value is converted (without
+ * loss of precision) into a SplitDBM with GMP weights and it stays so
+ * from then on. Operations between a fast and a GMP value are done on
+ * GMP values.
+ */
+
+namespace crab_llvm {
+
+  namespace zones_impl {
+    // SplitDBM parameters with int64 weights
+    template<class Number>
+    class int64_params {
+    public:
+      enum { chrome_dijkstra = 1 };
+      enum { widen_restabilize = 1 };
+      enum { special_assign = 1 };
+      typedef long Wt;
+      typedef crab::AdaptGraph<Wt> graph_t;
+    };
+  } // end namespace zones_impl
+
+  template<typename Number, typename VariableName>
+  class fast_zones_domain:
+    public crab::domains::abstract_domain<Number, VariableName,
+					  fast_zones_domain<Number,VariableName>> {
+  public:
+
+    typedef fast_zones_domain<Number, VariableName> fast_zones_domain_t;
+    typedef crab::domains::abstract_domain<Number, VariableName,
+					   fast_zones_domain_t> abstract_domain_t;
+    using typename abstract_domain_t::linear_expression_t;
+    using typename abstract_domain_t::linear_constraint_t;
+    using typename abstract_domain_t::linear_constraint_system_t;
+    using typename abstract_domain_t::variable_t;
+    using typename abstract_domain_t::variable_vector_t;
+    using typename abstract_domain_t::pointer_constraint_t;
+    typedef Number number_t;
+    typedef VariableName varname_t;
+    typedef ikos::interval<Number> interval_t;
+
+    typedef crab::domains::SplitDBM<Number, VariableName,
+				    zones_impl::int64_params<Number>> fast_dom_t;
+    typedef crab::domains::SplitDBM<Number, VariableName> gmp_dom_t;
+
+  private:
+
+    bool m_is_gmp;
+    fast_dom_t m_fast;
+    gmp_dom_t m_gmp;
+
+    fast_zones_domain(fast_dom_t fast)
+      : m_is_gmp(false), m_fast(fast), m_gmp(gmp_dom_t::top()) {}
+
+    fast_zones_domain(gmp_dom_t gmp)
+      : m_is_gmp(true), m_fast(fast_dom_t::top()), m_gmp(gmp) {}
+
+    /* The value stays with int64 weights only if the inputs fit */
+
+    static bool fits(const Number &n) {
+      static const Number min("-2147483648");
+      static const Number max("2147483647");
+      return n >= min && n <= max;
+    }
+
+    static bool fits(const interval_t &i) {
+      if (i.is_bottom()) return true;
+      if (boost::optional<Number> lb = i.lb().number()) {
+	if (!fits(*lb)) return false;
+      }
+      if (boost::optional<Number> ub = i.ub().number()) {
+	if (!fits(*ub)) return false;
+      }
+      return true;
+    }
+
+    static bool fits(const linear_expression_t &e) {
+      if (!fits(e.constant())) return false;
+      for (auto t: e) {
+	if (!fits(t.first)) return false;
+      }
+      return true;
+    }
+
+    static bool fits(const linear_constraint_t &cst) {
+      return fits(cst.expression());
+    }
+
+    static bool fits(const linear_constraint_system_t &csts) {
+      for (auto const &cst: csts) {
+	if (!fits(cst)) return false;
+      }
+      return true;
+    }
+
+    // Convert the value into GMP weights (no precision is lost)
+    void to_gmp() {
+      if (m_is_gmp) return;
+      if (m_fast.is_bottom()) {
+	m_gmp = gmp_dom_t::bottom();
+      } else {
+	m_gmp = gmp_dom_t::top();
+	m_gmp += m_fast.to_linear_constraint_system();
+      }
+      m_fast = fast_dom_t::top();
+      m_is_gmp = true;
+    }
+
+    void ensure(bool fits_int64) {
+      if (!fits_int64) to_gmp();
+    }
+
+    // Both values with the same kind of weights
+    static void unify(fast_zones_domain_t &a, fast_zones_domain_t &b) {
+      if (a.m_is_gmp != b.m_is_gmp) {
+	a.to_gmp();
+	b.to_gmp();
+      }
+    }
+
+    // The result of y*z or y<<z may not fit
+    bool fits_result(crab::domains::operation_t op, interval_t y, interval_t z) {
+      if (op != crab::domains::OP_MULTIPLICATION) return true;
+      return fits(y * z);
+    }
+
+    bool fits_result(crab::domains::bitwise_operation_t op, interval_t y, interval_t z) {
+      if (op != crab::domains::OP_SHL) return true;
+      return fits(y.Shl(z));
+    }
+
+    #define FAST_ZONES_DISPATCH(CALL)		\
+      if (m_is_gmp) { m_gmp.CALL; }		\
+      else { m_fast.CALL; }
+
+  public:
+
+    fast_zones_domain()
+      : m_is_gmp(false), m_fast(fast_dom_t::top()), m_gmp(gmp_dom_t::top()) {}
+
+    static fast_zones_domain_t top() { return fast_zones_domain_t(fast_dom_t::top()); }
+
+    static fast_zones_domain_t bottom() { return fast_zones_domain_t(fast_dom_t::bottom()); }
+
+    // Return true if the weights are GMP numbers
+    bool is_gmp() const { return m_is_gmp; }
+
+    void set_to_top() { *this = top(); }
+
+    void set_to_bottom() { *this = bottom(); }
+
+    bool is_bottom() { return m_is_gmp ? m_gmp.is_bottom() : m_fast.is_bottom(); }
+
+    bool is_top() { return m_is_gmp ? m_gmp.is_top() : m_fast.is_top(); }
+
+    interval_t operator[](variable_t v) {
+      return m_is_gmp ? m_gmp[v] : m_fast[v];
+    }
+
+    bool operator<=(fast_zones_domain_t o) {
+      unify(*this, o);
+      return m_is_gmp ? m_gmp <= o.m_gmp : m_fast <= o.m_fast;
+    }
+
+    void operator|=(fast_zones_domain_t o) {
+      *this = *this | o;
+    }
+
+    fast_zones_domain_t operator|(fast_zones_domain_t o) {
+      fast_zones_domain_t a(*this);
+      unify(a, o);
+      if (a.m_is_gmp) return fast_zones_domain_t(a.m_gmp | o.m_gmp);
+      return fast_zones_domain_t(a.m_fast | o.m_fast);
+    }
+
+    fast_zones_domain_t operator&(fast_zones_domain_t o) {
+      fast_zones_domain_t a(*this);
+      unify(a, o);
+      if (a.m_is_gmp) return fast_zones_domain_t(a.m_gmp & o.m_gmp);
+      return fast_zones_domain_t(a.m_fast & o.m_fast);
+    }
+
+    fast_zones_domain_t operator||(fast_zones_domain_t o) {
+      fast_zones_domain_t a(*this);
+      unify(a, o);
+      if (a.m_is_gmp) return fast_zones_domain_t(a.m_gmp || o.m_gmp);
+      return fast_zones_domain_t(a.m_fast || o.m_fast);
+    }
+
+    template<typename Thresholds>
+    fast_zones_domain_t widening_thresholds(fast_zones_domain_t o, const Thresholds &ts) {
+      fast_zones_domain_t a(*this);
+      unify(a, o);
+      if (a.m_is_gmp) return fast_zones_domain_t(a.m_gmp.widening_thresholds(o.m_gmp, ts));
+      return fast_zones_domain_t(a.m_fast.widening_thresholds(o.m_fast, ts));
+    }
+
+    fast_zones_domain_t operator&&(fast_zones_domain_t o) {
+      fast_zones_domain_t a(*this);
+      unify(a, o);
+      if (a.m_is_gmp) return fast_zones_domain_t(a.m_gmp && o.m_gmp);
+      return fast_zones_domain_t(a.m_fast && o.m_fast);
+    }
+
+    void operator+=(linear_constraint_system_t csts) {
+      ensure(fits(csts));
+      FAST_ZONES_DISPATCH(operator+=(csts))
+    }
+
+    void operator-=(variable_t v) {
+      FAST_ZONES_DISPATCH(operator-=(v))
+    }
+
+    void assign(variable_t x, linear_expression_t e) {
+      ensure(fits(e));
+      FAST_ZONES_DISPATCH(assign(x, e))
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (!m_is_gmp) ensure(fits_result(op, m_fast[y], m_fast[z]));
+      FAST_ZONES_DISPATCH(apply(op, x, y, z))
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, Number k) {
+      ensure(fits(k));
+      if (!m_is_gmp) ensure(fits_result(op, m_fast[y], interval_t(k)));
+      FAST_ZONES_DISPATCH(apply(op, x, y, k))
+    }
+
+    void apply(crab::domains::int_conv_operation_t op, variable_t dst, variable_t src) {
+      FAST_ZONES_DISPATCH(apply(op, dst, src))
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (!m_is_gmp) ensure(fits_result(op, m_fast[y], m_fast[z]));
+      FAST_ZONES_DISPATCH(apply(op, x, y, z))
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, Number k) {
+      ensure(fits(k));
+      if (!m_is_gmp) ensure(fits_result(op, m_fast[y], interval_t(k)));
+      FAST_ZONES_DISPATCH(apply(op, x, y, k))
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, variable_t z) {
+      FAST_ZONES_DISPATCH(apply(op, x, y, z))
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, Number k) {
+      ensure(fits(k));
+      FAST_ZONES_DISPATCH(apply(op, x, y, k))
+    }
+
+    void backward_assign(variable_t x, linear_expression_t e, fast_zones_domain_t invariant) {
+      ensure(fits(e));
+      unify(*this, invariant);
+      if (m_is_gmp) m_gmp.backward_assign(x, e, invariant.m_gmp);
+      else m_fast.backward_assign(x, e, invariant.m_fast);
+    }
+
+    void backward_apply(crab::domains::operation_t op, variable_t x, variable_t y, Number z,
+			fast_zones_domain_t invariant) {
+      ensure(fits(z));
+      unify(*this, invariant);
+      if (m_is_gmp) m_gmp.backward_apply(op, x, y, z, invariant.m_gmp);
+      else m_fast.backward_apply(op, x, y, z, invariant.m_fast);
+    }
+
+    void backward_apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z,
+			fast_zones_domain_t invariant) {
+      unify(*this, invariant);
+      if (m_is_gmp) m_gmp.backward_apply(op, x, y, z, invariant.m_gmp);
+      else m_fast.backward_apply(op, x, y, z, invariant.m_fast);
+    }
+
+    void assign_bool_cst(variable_t lhs, linear_constraint_t rhs) {
+      ensure(fits(rhs));
+      FAST_ZONES_DISPATCH(assign_bool_cst(lhs, rhs))
+    }
+
+    void assign_bool_var(variable_t lhs, variable_t rhs, bool is_not_rhs) {
+      FAST_ZONES_DISPATCH(assign_bool_var(lhs, rhs, is_not_rhs))
+    }
+
+    void apply_binary_bool(crab::domains::bool_operation_t op,
+			   variable_t x, variable_t y, variable_t z) {
+      FAST_ZONES_DISPATCH(apply_binary_bool(op, x, y, z))
+    }
+
+    void assume_bool(variable_t v, bool is_negated) {
+      FAST_ZONES_DISPATCH(assume_bool(v, is_negated))
+    }
+
+    void backward_assign_bool_cst(variable_t lhs, linear_constraint_t rhs,
+				  fast_zones_domain_t invariant) {
+      ensure(fits(rhs));
+      unify(*this, invariant);
+      if (m_is_gmp) m_gmp.backward_assign_bool_cst(lhs, rhs, invariant.m_gmp);
+      else m_fast.backward_assign_bool_cst(lhs, rhs, invariant.m_fast);
+    }
+
+    void backward_assign_bool_var(variable_t lhs, variable_t rhs, bool is_not_rhs,
+				  fast_zones_domain_t invariant) {
+      unify(*this, invariant);
+      if (m_is_gmp) m_gmp.backward_assign_bool_var(lhs, rhs, is_not_rhs, invariant.m_gmp);
+      else m_fast.backward_assign_bool_var(lhs, rhs, is_not_rhs, invariant.m_fast);
+    }
+
+    void backward_apply_binary_bool(crab::domains::bool_operation_t op,
+				    variable_t x, variable_t y, variable_t z,
+				    fast_zones_domain_t invariant) {
+      unify(*this, invariant);
+      if (m_is_gmp) m_gmp.backward_apply_binary_bool(op, x, y, z, invariant.m_gmp);
+      else m_fast.backward_apply_binary_bool(op, x, y, z, invariant.m_fast);
+    }
+
+    void array_init(variable_t a, linear_expression_t elem_size,
+		    linear_expression_t lb_idx, linear_expression_t ub_idx,
+		    linear_expression_t val) {
+      FAST_ZONES_DISPATCH(array_init(a, elem_size, lb_idx, ub_idx, val))
+    }
+
+    void array_load(variable_t lhs, variable_t a,
+		    linear_expression_t elem_size, linear_expression_t i) {
+      FAST_ZONES_DISPATCH(array_load(lhs, a, elem_size, i))
+    }
+
+    void array_store(variable_t a, linear_expression_t elem_size,
+		     linear_expression_t i, linear_expression_t v, bool is_singleton) {
+      FAST_ZONES_DISPATCH(array_store(a, elem_size, i, v, is_singleton))
+    }
+
+    void array_assign(variable_t lhs, variable_t rhs) {
+      FAST_ZONES_DISPATCH(array_assign(lhs, rhs))
+    }
+
+    void pointer_load(variable_t lhs, variable_t rhs) {
+      FAST_ZONES_DISPATCH(pointer_load(lhs, rhs))
+    }
+
+    void pointer_store(variable_t lhs, variable_t rhs) {
+      FAST_ZONES_DISPATCH(pointer_store(lhs, rhs))
+    }
+
+    void pointer_assign(variable_t lhs, variable_t rhs, linear_expression_t offset) {
+      FAST_ZONES_DISPATCH(pointer_assign(lhs, rhs, offset))
+    }
+
+    void pointer_mk_obj(variable_t lhs, ikos::index_t address) {
+      FAST_ZONES_DISPATCH(pointer_mk_obj(lhs, address))
+    }
+
+    void pointer_function(variable_t lhs, VariableName func) {
+      FAST_ZONES_DISPATCH(pointer_function(lhs, func))
+    }
+
+    void pointer_mk_null(variable_t lhs) {
+      FAST_ZONES_DISPATCH(pointer_mk_null(lhs))
+    }
+
+    void pointer_assume(pointer_constraint_t cst) {
+      FAST_ZONES_DISPATCH(pointer_assume(cst))
+    }
+
+    void pointer_assert(pointer_constraint_t cst) {
+      FAST_ZONES_DISPATCH(pointer_assert(cst))
+    }
+
+    void forget(const variable_vector_t& vars) {
+      FAST_ZONES_DISPATCH(forget(vars))
+    }
+
+    void project(const variable_vector_t& vars) {
+      FAST_ZONES_DISPATCH(project(vars))
+    }
+
+    void expand(variable_t x, variable_t new_x) {
+      FAST_ZONES_DISPATCH(expand(x, new_x))
+    }
+
+    void normalize() {
+      FAST_ZONES_DISPATCH(normalize())
+    }
+
+    #undef FAST_ZONES_DISPATCH
+
+    linear_constraint_system_t to_linear_constraint_system() {
+      return m_is_gmp ? m_gmp.to_linear_constraint_system() :
+	                m_fast.to_linear_constraint_system();
+    }
+
+    void write(crab::crab_os& o) {
+      if (m_is_gmp) m_gmp.write(o);
+      else m_fast.write(o);
+    }
+
+    static std::string getDomainName() {
+      return "SplitDBM (int64 weights)";
+    }
+  };
+
+} // end namespace crab_llvm
+#endif
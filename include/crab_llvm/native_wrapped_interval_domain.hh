@@ -0,0 +1,962 @@
+#ifndef __NATIVE_WRAPPED_INTERVAL_DOMAIN_HH__
+#define __NATIVE_WRAPPED_INTERVAL_DOMAIN_HH__
+
+#include "crab/config.h"
+#include "crab/common/types.hpp"
+#include "crab/domains/intervals.hpp"
+#include "crab_llvm/Support/VarRegistry.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+ * Wrapped intervals (APLAS'12) with native machine arithmetic.
+ *
+ * A wrapped interval of bitwidth w (1 to 64) is the set of values
+ * from start clockwise to stop modulo 2^w. The bounds are stored as
+ * the uint64_t of their unsigned representation together with the
+ * bitwidth of the variable (the one given by the CFG builder), so
+ * the transfer functions are a few machine operations and the
+ * overflow checks are done with the compiler intrinsics. Variables
+ * whose bitwidth is unknown or wider than 64 bits are top.
+ *
+ * The values of a contiguous range of variable factory indexes are
+ * stored in an array as dense_interval_domain does.
+ *
+ * Linear constraints are interpreted as signed unless the CFG
+ * builder marked them as unsigned (set_unsigned). Multiplication,
+ * division and the bitwise operations are precise when the operands
+ * do not cross the pole of the interpretation they need and are top
+ * otherwise.
+ */
+
+namespace crab_llvm {
+
+  namespace wrapped_impl {
+
+    class wint {
+      uint64_t m_start;
+      uint64_t m_stop;
+      // 0 if unknown (always top)
+      unsigned m_width;
+      bool m_top;
+      bool m_bottom;
+
+      wint(uint64_t start, uint64_t stop, unsigned width, bool top, bool bottom)
+	: m_start(start), m_stop(stop), m_width(width), m_top(top), m_bottom(bottom) {}
+
+    public:
+
+      static uint64_t mask(unsigned w) {
+	return (w >= 64 ? ~UINT64_C(0) : (UINT64_C(1) << w) - 1);
+      }
+
+      // signed value of the w bits of x
+      static int64_t to_signed(uint64_t x, unsigned w) {
+	if (w >= 64) return (int64_t) x;
+	uint64_t sign = UINT64_C(1) << (w - 1);
+	x &= mask(w);
+	return (int64_t) ((x ^ sign) - sign);
+      }
+
+      static int64_t signed_min(unsigned w) { return to_signed(UINT64_C(1) << (w - 1), w); }
+      static int64_t signed_max(unsigned w) { return (int64_t) (mask(w) >> 1); }
+
+      static wint top(unsigned w) { return wint(0, mask(w), w, true, false); }
+      static wint bottom(unsigned w) { return wint(0, 0, w, false, true); }
+
+      // [start, stop] modulo 2^w (top if it has all the values)
+      static wint mk(uint64_t start, uint64_t stop, unsigned w) {
+	if (w == 0) return top(0);
+	uint64_t m = mask(w);
+	start &= m;
+	stop &= m;
+	if (((stop - start) & m) == m) return top(w);
+	return wint(start, stop, w, false, false);
+      }
+
+      static wint singleton(uint64_t k, unsigned w) { return mk(k, k, w); }
+
+      wint(): wint(0, 0, 0, true, false) {}
+
+      unsigned width() const { return m_width; }
+      uint64_t start() const { return m_start; }
+      uint64_t stop() const { return m_stop; }
+      uint64_t mask() const { return mask(m_width); }
+      bool is_top() const { return m_top; }
+      bool is_bottom() const { return m_bottom; }
+      bool is_singleton() const { return !m_top && !m_bottom && m_start == m_stop; }
+
+      // number of values minus one
+      uint64_t size() const { return (m_top ? mask() : (m_stop - m_start) & mask()); }
+
+      bool contains(uint64_t x) const {
+	if (m_bottom) return false;
+	if (m_top) return true;
+	return ((x - m_start) & mask()) <= size();
+      }
+
+      // the unsigned values are not contiguous (from 2^w-1 to 0)
+      bool crosses_south_pole() const {
+	return m_top || (!m_bottom && m_start > m_stop);
+      }
+
+      // the signed values are not contiguous (from 2^(w-1)-1 to -2^(w-1))
+      bool crosses_north_pole() const {
+	if (m_top) return true;
+	uint64_t pole = UINT64_C(1) << (m_width - 1);
+	return contains(pole) && m_start != pole;
+      }
+
+      int64_t smin() const { return to_signed(m_start, m_width); }
+      int64_t smax() const { return to_signed(m_stop, m_width); }
+
+      bool operator<=(const wint &o) const {
+	if (m_bottom) return true;
+	if (o.m_bottom) return false;
+	if (o.m_top) return true;
+	if (m_top || m_width != o.m_width) return false;
+	uint64_t m = mask();
+	uint64_t first = (m_start - o.m_start) & m;
+	uint64_t last = (m_stop - o.m_start) & m;
+	return first <= last && last <= o.size();
+      }
+
+      bool operator==(const wint &o) const { return *this <= o && o <= *this; }
+
+      // join: the smallest wrapped interval that contains both
+      wint operator|(const wint &o) const {
+	if (*this <= o) return o;
+	if (o <= *this) return *this;
+	if (m_width != o.m_width) return top(0);
+	unsigned w = m_width;
+	bool o_has_ends = o.contains(m_start) && o.contains(m_stop);
+	bool has_o_ends = contains(o.m_start) && contains(o.m_stop);
+	if (o_has_ends && has_o_ends) return top(w);
+	if (o.contains(m_stop) && contains(o.m_start)) return mk(m_start, o.m_stop, w);
+	if (contains(o.m_stop) && o.contains(m_start)) return mk(o.m_start, m_stop, w);
+	// -- disjoint: fill the smaller gap
+	uint64_t m = mask();
+	uint64_t gap_after = (o.m_start - m_stop) & m;
+	uint64_t gap_before = (m_start - o.m_stop) & m;
+	return (gap_after <= gap_before ? mk(m_start, o.m_stop, w) : mk(o.m_start, m_stop, w));
+      }
+
+      // meet: over-approximated by one interval if the intersection
+      // has two pieces
+      wint operator&(const wint &o) const {
+	if (m_bottom || o.m_bottom) return bottom(m_width);
+	if (*this <= o) return *this;
+	if (o <= *this) return o;
+	if (m_width != o.m_width) return *this;
+	unsigned w = m_width;
+	bool o_has_ends = o.contains(m_start) && o.contains(m_stop);
+	bool has_o_ends = contains(o.m_start) && contains(o.m_stop);
+	if (o_has_ends && has_o_ends) return (size() <= o.size() ? *this : o);
+	if (contains(o.m_start)) return mk(o.m_start, m_stop, w);
+	if (o.contains(m_start)) return mk(m_start, o.m_stop, w);
+	return bottom(w);
+      }
+
+      // widening: the interval at least doubles at each step
+      wint operator||(const wint &o) const {
+	if (o <= *this) return *this;
+	if (m_bottom) return o;
+	if (m_top || o.m_top || m_width != o.m_width) return top(m_width);
+	unsigned w = m_width;
+	uint64_t s = size();
+	if (s >= (mask() >> 1)) return top(w);
+	wint j = *this | o;
+	if (j.is_top()) return j;
+	if (j.m_start == m_start) return j | mk(m_start, m_stop + s + 1, w);
+	if (j.m_stop == m_stop) return j | mk(m_start - s - 1, m_stop, w);
+	if (o.contains(m_start) && o.contains(m_stop)) return o | mk(o.m_start, o.m_start + 2 * s + 1, w);
+	return top(w);
+      }
+
+      wint operator&&(const wint &o) const {
+	return (m_top ? o : *this);
+      }
+
+      /* Arithmetic modulo 2^w. Both operands have bitwidth w. */
+
+      friend wint add(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (a.m_top || b.m_top) return top(w);
+	uint64_t s;
+	if (__builtin_add_overflow(a.size(), b.size(), &s) || s >= a.mask()) return top(w);
+	return mk(a.m_start + b.m_start, a.m_stop + b.m_stop, w);
+      }
+
+      friend wint sub(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (a.m_top || b.m_top) return top(w);
+	uint64_t s;
+	if (__builtin_add_overflow(a.size(), b.size(), &s) || s >= a.mask()) return top(w);
+	return mk(a.m_start - b.m_stop, a.m_stop - b.m_start, w);
+      }
+
+      // the exact product is kept if it fits in w bits either as
+      // unsigned or as signed
+      friend wint mul(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (a.is_singleton() && b.is_singleton()) return singleton(a.m_start * b.m_start, w);
+	if (a.m_top || b.m_top) return top(w);
+	wint res = top(w);
+	if (!a.crosses_south_pole() && !b.crosses_south_pole()) {
+	  uint64_t lo, hi;
+	  if (!__builtin_mul_overflow(a.m_start, b.m_start, &lo) &&
+	      !__builtin_mul_overflow(a.m_stop, b.m_stop, &hi) && hi <= a.mask()) {
+	    res = mk(lo, hi, w);
+	  }
+	}
+	if (!a.crosses_north_pole() && !b.crosses_north_pole()) {
+	  const int64_t xs[] = { a.smin(), a.smax() };
+	  const int64_t ys[] = { b.smin(), b.smax() };
+	  int64_t lo = INT64_MAX, hi = INT64_MIN;
+	  bool overflow = false;
+	  for (int64_t x: xs) {
+	    for (int64_t y: ys) {
+	      int64_t p;
+	      overflow |= __builtin_mul_overflow(x, y, &p);
+	      lo = std::min(lo, p);
+	      hi = std::max(hi, p);
+	    }
+	  }
+	  if (!overflow && lo >= signed_min(w) && hi <= signed_max(w)) {
+	    res = res & mk((uint64_t) lo, (uint64_t) hi, w);
+	  }
+	}
+	return res;
+      }
+
+      friend wint udiv(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (b.contains(0) || a.crosses_south_pole() || b.crosses_south_pole()) return top(w);
+	return mk(a.m_start / b.m_stop, a.m_stop / b.m_start, w);
+      }
+
+      friend wint sdiv(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (b.contains(0) || a.crosses_north_pole() || b.crosses_north_pole()) return top(w);
+	// -- the only quotient that does not fit: min / -1
+	if (a.contains(UINT64_C(1) << (w - 1)) && b.contains(a.mask())) return top(w);
+	const int64_t xs[] = { a.smin(), a.smax() };
+	const int64_t ys[] = { b.smin(), b.smax() };
+	int64_t lo = INT64_MAX, hi = INT64_MIN;
+	for (int64_t x: xs) {
+	  for (int64_t y: ys) {
+	    lo = std::min(lo, x / y);
+	    hi = std::max(hi, x / y);
+	  }
+	}
+	return mk((uint64_t) lo, (uint64_t) hi, w);
+      }
+
+      friend wint urem(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (b.contains(0) || b.crosses_south_pole()) return top(w);
+	if (a.is_singleton() && b.is_singleton()) return singleton(a.m_start % b.m_start, w);
+	if (!a.crosses_south_pole() && a.m_stop < b.m_start) return a;
+	return mk(0, b.m_stop - 1, w);
+      }
+
+      friend wint srem(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (b.contains(0) || !a.is_singleton() || !b.is_singleton()) return top(w);
+	int64_t y = b.smin();
+	return singleton((y == -1 ? 0 : (uint64_t) (a.smin() % y)), w);
+      }
+
+      // smallest 2^k-1 that is not smaller than x
+      static uint64_t fill(uint64_t x) {
+	for (unsigned k = 1; k < 64; k <<= 1) x |= (x >> k);
+	return x;
+      }
+
+      friend wint bit_and(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (a.is_singleton() && b.is_singleton()) return singleton(a.m_start & b.m_start, w);
+	if (!a.crosses_south_pole() && !b.crosses_south_pole()) return mk(0, std::min(a.m_stop, b.m_stop), w);
+	if (!a.crosses_south_pole()) return mk(0, a.m_stop, w);
+	if (!b.crosses_south_pole()) return mk(0, b.m_stop, w);
+	return top(w);
+      }
+
+      friend wint bit_or(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (a.is_singleton() && b.is_singleton()) return singleton(a.m_start | b.m_start, w);
+	if (a.crosses_south_pole() || b.crosses_south_pole()) return top(w);
+	return mk(std::max(a.m_start, b.m_start), fill(a.m_stop | b.m_stop), w);
+      }
+
+      friend wint bit_xor(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (a.is_singleton() && b.is_singleton()) return singleton(a.m_start ^ b.m_start, w);
+	if (a.crosses_south_pole() || b.crosses_south_pole()) return top(w);
+	return mk(0, fill(a.m_stop | b.m_stop), w);
+      }
+
+      friend wint shl(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (!b.is_singleton() || b.m_start >= w) return top(w);
+	return mul(a, singleton(UINT64_C(1) << b.m_start, w));
+      }
+
+      friend wint lshr(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (b.crosses_south_pole() || b.m_stop >= w) return top(w);
+	if (a.crosses_south_pole()) return mk(0, a.mask() >> b.m_start, w);
+	return mk(a.m_start >> b.m_stop, a.m_stop >> b.m_start, w);
+      }
+
+      friend wint ashr(const wint &a, const wint &b) {
+	unsigned w = a.m_width;
+	if (a.m_bottom || b.m_bottom) return bottom(w);
+	if (!b.is_singleton() || b.m_start >= w) return top(w);
+	unsigned k = (unsigned) b.m_start;
+	if (a.crosses_north_pole()) return mk((uint64_t) (signed_min(w) >> k),
+					      (uint64_t) (signed_max(w) >> k), w);
+	return mk((uint64_t) (a.smin() >> k), (uint64_t) (a.smax() >> k), w);
+      }
+
+      /* Conversions to bitwidth w */
+
+      friend wint trunc_to(const wint &a, unsigned w) {
+	if (a.m_bottom) return bottom(w);
+	if (a.m_top || a.size() > mask(w)) return top(w);
+	return mk(a.m_start, a.m_stop, w);
+      }
+
+      friend wint zext_to(const wint &a, unsigned w) {
+	if (a.m_bottom) return bottom(w);
+	if (a.m_width == 0) return top(w);
+	if (a.crosses_south_pole()) return mk(0, a.mask(), w);
+	return mk(a.m_start, a.m_stop, w);
+      }
+
+      friend wint sext_to(const wint &a, unsigned w) {
+	if (a.m_bottom) return bottom(w);
+	if (a.m_width == 0) return top(w);
+	if (a.crosses_north_pole()) return mk((uint64_t) signed_min(a.m_width),
+					      (uint64_t) signed_max(a.m_width), w);
+	return mk((uint64_t) a.smin(), (uint64_t) a.smax(), w);
+      }
+    };
+
+  } // end namespace wrapped_impl
+
+  template<typename Number, typename VariableName>
+  class native_wrapped_interval_domain:
+    public crab::domains::abstract_domain<Number, VariableName,
+					  native_wrapped_interval_domain<Number,VariableName>> {
+  public:
+
+    typedef native_wrapped_interval_domain<Number, VariableName> native_wrapped_interval_domain_t;
+    typedef crab::domains::abstract_domain<Number, VariableName,
+					   native_wrapped_interval_domain_t> abstract_domain_t;
+    using typename abstract_domain_t::linear_expression_t;
+    using typename abstract_domain_t::linear_constraint_t;
+    using typename abstract_domain_t::linear_constraint_system_t;
+    using typename abstract_domain_t::variable_t;
+    using typename abstract_domain_t::variable_vector_t;
+    using typename abstract_domain_t::pointer_constraint_t;
+    typedef Number number_t;
+    typedef VariableName varname_t;
+    typedef wrapped_impl::wint wint_t;
+    typedef ikos::interval<Number> interval_t;
+    typedef ikos::bound<Number> bound_t;
+
+  private:
+
+    typedef var_registry<variable_t> registry_t;
+
+    // max number of passes over a constraint system
+    static const unsigned max_reduction_cycles = 10;
+
+    bool m_is_bottom;
+    // index of the variable of the first slot
+    std::size_t m_base;
+    std::vector<wint_t> m_vals;
+
+    static unsigned width_of(const variable_t &v) {
+      unsigned w = v.get_bitwidth();
+      return (w >= 1 && w <= 64 ? w : 0);
+    }
+
+    /* Conversions between numbers and bounds */
+
+    static const Number& two_to_32() {
+      static const Number n("4294967296");
+      return n;
+    }
+
+    // k modulo 2^64
+    static uint64_t to_u64(Number k) {
+      static const Number two_to_64("18446744073709551616");
+      k = k % two_to_64;
+      if (k < 0) k = k + two_to_64;
+      uint64_t hi = (uint64_t) (long) (k / two_to_32());
+      uint64_t lo = (uint64_t) (long) (k % two_to_32());
+      return (hi << 32) | lo;
+    }
+
+    static Number to_number(int64_t n) { return Number((long) n); }
+
+    static Number to_number(uint64_t n) {
+      return Number((long) (n >> 32)) * two_to_32() + Number((long) (n & UINT64_C(0xffffffff)));
+    }
+
+    // the integers of x for the signed or unsigned reading
+    static interval_t to_interval(const wint_t &x, bool is_signed) {
+      if (x.is_bottom()) return interval_t::bottom();
+      unsigned w = x.width();
+      if (w == 0) return interval_t::top();
+      if (is_signed) {
+	if (x.crosses_north_pole()) {
+	  return interval_t(to_number(wint_t::signed_min(w)), to_number(wint_t::signed_max(w)));
+	}
+	return interval_t(to_number(x.smin()), to_number(x.smax()));
+      }
+      if (x.crosses_south_pole()) {
+	return interval_t(Number(0), to_number(wint_t::mask(w)));
+      }
+      return interval_t(to_number(x.start()), to_number(x.stop()));
+    }
+
+    // the values of bitwidth w whose signed or unsigned reading is
+    // in i
+    static wint_t from_interval(const interval_t &i, unsigned w, bool is_signed) {
+      if (i.is_bottom()) return wint_t::bottom(w);
+      if (w == 0) return wint_t::top(0);
+      Number min = (is_signed ? to_number(wint_t::signed_min(w)) : Number(0));
+      Number max = (is_signed ? to_number(wint_t::signed_max(w)) : to_number(wint_t::mask(w)));
+      Number lo = min, hi = max;
+      if (boost::optional<Number> lb = i.lb().number()) lo = std::max(lo, *lb);
+      if (boost::optional<Number> ub = i.ub().number()) hi = std::min(hi, *ub);
+      if (lo > hi) return wint_t::bottom(w);
+      return wint_t::mk(to_u64(lo), to_u64(hi), w);
+    }
+
+    // floor(k/a) and ceil(k/a) with a != 0
+    static Number floor_div(const Number &k, const Number &a) {
+      Number q = k / a;
+      Number r = k % a;
+      if (r != 0 && ((r < 0) != (a < 0))) q = q - 1;
+      return q;
+    }
+
+    static Number ceil_div(const Number &k, const Number &a) {
+      Number q = k / a;
+      Number r = k % a;
+      if (r != 0 && ((r < 0) == (a < 0))) q = q + 1;
+      return q;
+    }
+
+    explicit native_wrapped_interval_domain(bool is_bottom)
+      : m_is_bottom(is_bottom), m_base(0) {}
+
+    std::size_t end() const { return m_base + m_vals.size(); }
+
+    // Extend the slots so they cover the indexes [first, last). The
+    // new slots are top.
+    void extend(std::size_t first, std::size_t last) {
+      if (m_vals.empty()) {
+	m_base = first;
+	m_vals.assign(last - first, wint_t());
+	return;
+      }
+      if (first < m_base) {
+	m_vals.insert(m_vals.begin(), m_base - first, wint_t());
+	m_base = first;
+      }
+      if (last > end()) {
+	m_vals.resize(last - m_base, wint_t());
+      }
+    }
+
+    // Make both values cover the same slots
+    void align(native_wrapped_interval_domain_t &o) {
+      if (o.m_vals.empty() && m_vals.empty()) return;
+      std::size_t first, last;
+      if (m_vals.empty()) {
+	first = o.m_base; last = o.end();
+      } else if (o.m_vals.empty()) {
+	first = m_base; last = end();
+      } else {
+	first = std::min(m_base, o.m_base);
+	last = std::max(end(), o.end());
+      }
+      extend(first, last);
+      o.extend(first, last);
+    }
+
+    wint_t get(std::size_t i) const {
+      return (i < m_base || i >= end() ? wint_t() : m_vals[i - m_base]);
+    }
+
+    // the value of v with the bitwidth of v
+    wint_t value(const variable_t &v) const {
+      unsigned w = width_of(v);
+      wint_t x = get(v.index());
+      return (x.is_top() || x.width() != w ? wint_t::top(w) : x);
+    }
+
+    // the value of v as an operand of bitwidth w
+    wint_t operand(const variable_t &v, unsigned w) const {
+      wint_t x = value(v);
+      return (x.width() == w ? x : wint_t::top(w));
+    }
+
+    void set_slot(std::size_t i, const wint_t &x) {
+      if (x.is_top()) {
+	if (i >= m_base && i < end()) m_vals[i - m_base] = wint_t();
+	return;
+      }
+      extend(m_vals.empty() ? i : std::min(i, m_base),
+	     m_vals.empty() ? i + 1 : std::max(i + 1, end()));
+      m_vals[i - m_base] = x;
+    }
+
+    template<typename Op>
+    native_wrapped_interval_domain_t pointwise(native_wrapped_interval_domain_t o, Op op) const {
+      native_wrapped_interval_domain_t res(*this);
+      res.align(o);
+      std::size_t n = res.m_vals.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	wint_t x = op(res.m_vals[k], o.m_vals[k]);
+	if (x.is_bottom()) return bottom();
+	res.m_vals[k] = (x.is_top() ? wint_t() : x);
+      }
+      return res;
+    }
+
+    wint_t eval(const linear_expression_t &e, unsigned w) const {
+      if (w == 0) return wint_t::top(0);
+      wint_t r = wint_t::singleton(to_u64(e.constant()), w);
+      for (auto t: e) {
+	r = add(r, mul(wint_t::singleton(to_u64(t.first), w), operand(t.second, w)));
+	if (r.is_top()) break;
+      }
+      return r;
+    }
+
+    static wint_t eval(crab::domains::operation_t op, wint_t y, wint_t z) {
+      switch (op) {
+      case crab::domains::OP_ADDITION:       return add(y, z);
+      case crab::domains::OP_SUBTRACTION:    return sub(y, z);
+      case crab::domains::OP_MULTIPLICATION: return mul(y, z);
+      case crab::domains::OP_DIVISION:       return sdiv(y, z);
+      default:                               return wint_t::top(y.width());
+      }
+    }
+
+    static wint_t eval(crab::domains::bitwise_operation_t op, wint_t y, wint_t z) {
+      switch (op) {
+      case crab::domains::OP_AND:  return bit_and(y, z);
+      case crab::domains::OP_OR:   return bit_or(y, z);
+      case crab::domains::OP_XOR:  return bit_xor(y, z);
+      case crab::domains::OP_SHL:  return shl(y, z);
+      case crab::domains::OP_LSHR: return lshr(y, z);
+      case crab::domains::OP_ASHR: return ashr(y, z);
+      default:                     return wint_t::top(y.width());
+      }
+    }
+
+    static wint_t eval(crab::domains::div_operation_t op, wint_t y, wint_t z) {
+      switch (op) {
+      case crab::domains::OP_SDIV: return sdiv(y, z);
+      case crab::domains::OP_UDIV: return udiv(y, z);
+      case crab::domains::OP_SREM: return srem(y, z);
+      case crab::domains::OP_UREM: return urem(y, z);
+      default:                     return wint_t::top(y.width());
+      }
+    }
+
+    // Refine the variables of sign*e <= 0 for the signed or unsigned
+    // reading of the variables
+    void refine_leq(const linear_expression_t &e, int sign, bool is_signed, bool &change) {
+      Number s(sign);
+      for (auto t: e) {
+	Number a = s * t.first;
+	unsigned w = width_of(t.second);
+	if (a == 0 || w == 0) continue;
+	// -- rest := sign*c + sum sign*a_j*x_j with x_j != x
+	interval_t rest(s * e.constant());
+	for (auto u: e) {
+	  if (u.second == t.second) continue;
+	  rest = rest + interval_t(s * u.first) * to_interval(value(u.second), is_signed);
+	}
+	bound_t r = rest.lb();
+	if (r.is_infinite()) continue;
+	// -- a*x <= -rest.lb
+	Number k = Number(0) - *(r.number());
+	interval_t x = (a > 0 ?
+			interval_t(bound_t::minus_infinity(), bound_t(floor_div(k, a))) :
+			interval_t(bound_t(ceil_div(k, a)), bound_t::plus_infinity()));
+	wint_t old = value(t.second);
+	wint_t refined = old & from_interval(x, w, is_signed);
+	if (!(old <= refined)) {
+	  set(t.second, refined);
+	  change = true;
+	  if (m_is_bottom) return;
+	}
+      }
+    }
+
+    // a*x + c != 0 only refines an end of x
+    void refine_neq(const linear_expression_t &e, bool &change) {
+      if (std::distance(e.begin(), e.end()) != 1) return;
+      auto t = *(e.begin());
+      Number a = t.first;
+      Number c = Number(0) - e.constant();
+      unsigned w = width_of(t.second);
+      if (a == 0 || w == 0 || c % a != 0) return;
+      uint64_t k = to_u64(c / a) & wint_t::mask(w);
+      wint_t old = value(t.second);
+      if (old.is_top() || old.is_bottom()) return;
+      if (old.is_singleton() && old.start() == k) {
+	set_to_bottom();
+	change = true;
+      } else if (old.start() == k) {
+	set(t.second, wint_t::mk(k + 1, old.stop(), w));
+	change = true;
+      } else if (old.stop() == k) {
+	set(t.second, wint_t::mk(old.start(), k - 1, w));
+	change = true;
+      }
+    }
+
+    void add_constraint(const linear_constraint_t &cst, bool &change) {
+      if (cst.is_tautology()) return;
+      if (cst.is_contradiction()) {
+	set_to_bottom();
+	return;
+      }
+      bool is_signed = !cst.is_unsigned();
+      if (cst.is_inequality()) {
+	refine_leq(cst.expression(), 1, is_signed, change);
+      } else if (cst.is_equality()) {
+	refine_leq(cst.expression(), 1, is_signed, change);
+	if (!m_is_bottom) {
+	  refine_leq(cst.expression(), -1, is_signed, change);
+	}
+      } else if (cst.is_disequation()) {
+	refine_neq(cst.expression(), change);
+      }
+      // other constraints are ignored (sound)
+    }
+
+  public:
+
+    native_wrapped_interval_domain(): m_is_bottom(false), m_base(0) {}
+
+    static native_wrapped_interval_domain_t top() { return native_wrapped_interval_domain_t(false); }
+
+    static native_wrapped_interval_domain_t bottom() { return native_wrapped_interval_domain_t(true); }
+
+    void set_to_top() {
+      m_is_bottom = false;
+      m_base = 0;
+      m_vals.clear();
+    }
+
+    void set_to_bottom() {
+      set_to_top();
+      m_is_bottom = true;
+    }
+
+    bool is_bottom() { return m_is_bottom; }
+
+    bool is_top() {
+      if (m_is_bottom) return false;
+      for (auto const &x: m_vals) {
+	if (!x.is_top()) return false;
+      }
+      return true;
+    }
+
+    wint_t operator[](variable_t v) const {
+      return (m_is_bottom ? wint_t::bottom(width_of(v)) : value(v));
+    }
+
+    void set(variable_t v, wint_t x) {
+      if (m_is_bottom) return;
+      if (x.is_bottom()) {
+	set_to_bottom();
+	return;
+      }
+      if (!x.is_top()) {
+	registry_t::get().add(v);
+      }
+      set_slot(v.index(), x);
+    }
+
+    bool operator<=(native_wrapped_interval_domain_t o) {
+      if (m_is_bottom) return true;
+      if (o.m_is_bottom) return false;
+      align(o);
+      std::size_t n = m_vals.size();
+      for (std::size_t k = 0; k < n; ++k) {
+	if (!(m_vals[k] <= o.m_vals[k])) return false;
+      }
+      return true;
+    }
+
+    void operator|=(native_wrapped_interval_domain_t o) {
+      *this = *this | o;
+    }
+
+    native_wrapped_interval_domain_t operator|(native_wrapped_interval_domain_t o) {
+      if (m_is_bottom) return o;
+      if (o.m_is_bottom) return *this;
+      return pointwise(o, [](const wint_t &x, const wint_t &y) { return x | y; });
+    }
+
+    native_wrapped_interval_domain_t operator&(native_wrapped_interval_domain_t o) {
+      if (m_is_bottom || o.m_is_bottom) return bottom();
+      return pointwise(o, [](const wint_t &x, const wint_t &y) { return x & y; });
+    }
+
+    native_wrapped_interval_domain_t operator||(native_wrapped_interval_domain_t o) {
+      if (m_is_bottom) return o;
+      if (o.m_is_bottom) return *this;
+      return pointwise(o, [](const wint_t &x, const wint_t &y) { return x || y; });
+    }
+
+    // no thresholds: they are integers and the widening of wrapped
+    // intervals already stops at the poles
+    template<typename Thresholds>
+    native_wrapped_interval_domain_t widening_thresholds(native_wrapped_interval_domain_t o,
+							 const Thresholds &/*ts*/) {
+      return *this || o;
+    }
+
+    native_wrapped_interval_domain_t operator&&(native_wrapped_interval_domain_t o) {
+      if (m_is_bottom || o.m_is_bottom) return bottom();
+      return pointwise(o, [](const wint_t &x, const wint_t &y) { return x && y; });
+    }
+
+    void operator-=(variable_t v) {
+      if (m_is_bottom) return;
+      set_slot(v.index(), wint_t());
+    }
+
+    void operator+=(linear_constraint_system_t csts) {
+      if (m_is_bottom) return;
+      for (unsigned i = 0; i < max_reduction_cycles; ++i) {
+	bool change = false;
+	for (auto const &cst: csts) {
+	  add_constraint(cst, change);
+	  if (m_is_bottom) return;
+	}
+	if (!change) break;
+      }
+    }
+
+    void assign(variable_t x, linear_expression_t e) {
+      if (m_is_bottom) return;
+      set(x, eval(e, width_of(x)));
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_bottom) return;
+      unsigned w = width_of(x);
+      set(x, (w == 0 ? wint_t::top(0) : eval(op, operand(y, w), operand(z, w))));
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_bottom) return;
+      unsigned w = width_of(x);
+      set(x, (w == 0 ? wint_t::top(0) : eval(op, operand(y, w), wint_t::singleton(to_u64(k), w))));
+    }
+
+    void apply(crab::domains::int_conv_operation_t op, variable_t dst, variable_t src) {
+      if (m_is_bottom) return;
+      unsigned w = width_of(dst);
+      wint_t x = value(src);
+      switch (op) {
+      case crab::domains::OP_TRUNC: set(dst, trunc_to(x, w)); break;
+      case crab::domains::OP_ZEXT:  set(dst, zext_to(x, w)); break;
+      case crab::domains::OP_SEXT:  set(dst, sext_to(x, w)); break;
+      default:                      *this -= dst;
+      }
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_bottom) return;
+      unsigned w = width_of(x);
+      set(x, (w == 0 ? wint_t::top(0) : eval(op, operand(y, w), operand(z, w))));
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_bottom) return;
+      unsigned w = width_of(x);
+      set(x, (w == 0 ? wint_t::top(0) : eval(op, operand(y, w), wint_t::singleton(to_u64(k), w))));
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, variable_t z) {
+      if (m_is_bottom) return;
+      unsigned w = width_of(x);
+      set(x, (w == 0 ? wint_t::top(0) : eval(op, operand(y, w), operand(z, w))));
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, Number k) {
+      if (m_is_bottom) return;
+      unsigned w = width_of(x);
+      set(x, (w == 0 ? wint_t::top(0) : eval(op, operand(y, w), wint_t::singleton(to_u64(k), w))));
+    }
+
+    // Backward operations are as in dense_interval_domain: the value
+    // of x before the statement is forgotten.
+    void backward_assign(variable_t x, linear_expression_t /*e*/,
+			 native_wrapped_interval_domain_t invariant) {
+      if (m_is_bottom) return;
+      *this -= x;
+      *this = *this & invariant;
+    }
+
+    void backward_apply(crab::domains::operation_t /*op*/,
+			variable_t x, variable_t /*y*/, Number /*z*/,
+			native_wrapped_interval_domain_t invariant) {
+      if (m_is_bottom) return;
+      *this -= x;
+      *this = *this & invariant;
+    }
+
+    void backward_apply(crab::domains::operation_t /*op*/,
+			variable_t x, variable_t /*y*/, variable_t /*z*/,
+			native_wrapped_interval_domain_t invariant) {
+      if (m_is_bottom) return;
+      *this -= x;
+      *this = *this & invariant;
+    }
+
+    /* booleans are not tracked */
+    void assign_bool_cst(variable_t /*lhs*/, linear_constraint_t /*rhs*/) {}
+    void assign_bool_var(variable_t /*lhs*/, variable_t /*rhs*/, bool /*is_not_rhs*/) {}
+    void apply_binary_bool(crab::domains::bool_operation_t /*op*/,
+			   variable_t /*x*/, variable_t /*y*/, variable_t /*z*/) {}
+    void assume_bool(variable_t /*v*/, bool /*is_negated*/) {}
+    void backward_assign_bool_cst(variable_t /*lhs*/, linear_constraint_t /*rhs*/,
+				  native_wrapped_interval_domain_t /*invariant*/) {}
+    void backward_assign_bool_var(variable_t /*lhs*/, variable_t /*rhs*/, bool /*is_not_rhs*/,
+				  native_wrapped_interval_domain_t /*invariant*/) {}
+    void backward_apply_binary_bool(crab::domains::bool_operation_t /*op*/,
+				    variable_t /*x*/, variable_t /*y*/, variable_t /*z*/,
+				    native_wrapped_interval_domain_t /*invariant*/) {}
+
+    /* arrays are handled by array_smashing */
+    void array_init(variable_t /*a*/, linear_expression_t /*elem_size*/,
+		    linear_expression_t /*lb_idx*/, linear_expression_t /*ub_idx*/,
+		    linear_expression_t /*val*/) {}
+    void array_load(variable_t lhs, variable_t /*a*/,
+		    linear_expression_t /*elem_size*/, linear_expression_t /*i*/) {
+      *this -= lhs;
+    }
+    void array_store(variable_t /*a*/, linear_expression_t /*elem_size*/,
+		     linear_expression_t /*i*/, linear_expression_t /*v*/,
+		     bool /*is_singleton*/) {}
+    void array_assign(variable_t /*lhs*/, variable_t /*rhs*/) {}
+
+    /* pointers are not tracked */
+    void pointer_load(variable_t /*lhs*/, variable_t /*rhs*/) {}
+    void pointer_store(variable_t /*lhs*/, variable_t /*rhs*/) {}
+    void pointer_assign(variable_t /*lhs*/, variable_t /*rhs*/, linear_expression_t /*offset*/) {}
+    void pointer_mk_obj(variable_t /*lhs*/, ikos::index_t /*address*/) {}
+    void pointer_function(variable_t /*lhs*/, VariableName /*func*/) {}
+    void pointer_mk_null(variable_t /*lhs*/) {}
+    void pointer_assume(pointer_constraint_t /*cst*/) {}
+    void pointer_assert(pointer_constraint_t /*cst*/) {}
+
+    void forget(const variable_vector_t& vars) {
+      if (m_is_bottom) return;
+      for (auto const &v: vars) {
+	*this -= v;
+      }
+    }
+
+    void project(const variable_vector_t& vars) {
+      if (m_is_bottom) return;
+      std::vector<std::pair<std::size_t, wint_t>> vals;
+      for (auto const &v: vars) {
+	vals.push_back(std::make_pair(v.index(), get(v.index())));
+      }
+      set_to_top();
+      for (auto &kv: vals) {
+	set_slot(kv.first, kv.second);
+      }
+    }
+
+    void expand(variable_t x, variable_t new_x) {
+      if (m_is_bottom) return;
+      set(new_x, value(x));
+    }
+
+    void normalize() {}
+
+    // signed bounds of the values that do not cross the north pole
+    linear_constraint_system_t to_linear_constraint_system() {
+      linear_constraint_system_t csts;
+      if (m_is_bottom) {
+	csts += linear_constraint_t::get_false();
+	return csts;
+      }
+      registry_t &vars = registry_t::get();
+      for (std::size_t i = m_base; i < end(); ++i) {
+	wint_t x = get(i);
+	if (x.is_top() || x.crosses_north_pole()) continue;
+	const variable_t *v = vars.find(i);
+	if (!v) continue;
+	linear_expression_t e(*v);
+	if (x.is_singleton()) {
+	  csts += (e == to_number(x.smin()));
+	} else {
+	  csts += (e >= to_number(x.smin()));
+	  csts += (e <= to_number(x.smax()));
+	}
+      }
+      return csts;
+    }
+
+    void write(crab::crab_os& o) {
+      if (m_is_bottom) {
+	o << "_|_";
+	return;
+      }
+      registry_t &vars = registry_t::get();
+      o << "{";
+      bool first = true;
+      for (std::size_t i = m_base; i < end(); ++i) {
+	wint_t x = get(i);
+	if (x.is_top()) continue;
+	const variable_t *v = vars.find(i);
+	if (!v) continue;
+	if (!first) o << "; ";
+	first = false;
+	o << *v << " -> [" << x.smin() << ", " << x.smax() << "]_" << x.width();
+      }
+      o << "}";
+    }
+
+    static std::string getDomainName() {
+      return "Native Wrapped Intervals";
+    }
+  };
+
+} // end namespace crab_llvm
+#endif
@@ -0,0 +1,540 @@
+#ifndef __OFFSET_POINTER_DOMAIN_HH__
+#define __OFFSET_POINTER_DOMAIN_HH__
+
+#include "crab/config.h"
+#include "crab/common/types.hpp"
+#include "crab/domains/intervals.hpp"
+#include "crab_llvm/dense_interval_domain.hh"
+
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+/*
+ * Offset-only pointer domain.
+ *
+ * Each pointer variable is abstracted by its nullity (null,
+ * non-null or unknown) and, if it can be non-null, by the base
+ * region of the object it points to together with an interval of
+ * byte offsets from the start of that object. The base of an object
+ * is the address given by ptr_new_object, which CfgBuilder sets to
+ * the id of its region in the heap abstraction when it is known.
+ * Otherwise, the base is unknown.
+ * The integer variables are kept in a dense_interval_domain, which
+ * also evaluates the symbolic offsets of pointer arithmetic.
+ *
+ * Nothing relates two pointers (or a pointer and an integer) so the
+ * cost of each operation is about that of intervals. It answers the
+ * usual questions with --crab-track=ptr: whether a pointer can be
+ * null and where it points within its object.
+ */
+
+namespace crab_llvm {
+
+  namespace offset_pointer_impl {
+
+    // The nullity is a bitset: a pointer may be null if IS_NULL is
+    // set and may be non-null if NON_NULL is set.
+    enum : uint8_t { NULLITY_BOT = 0, IS_NULL = 1, NON_NULL = 2, NULLITY_TOP = 3 };
+
+    // base of an unknown object
+    static const int64_t unknown_base = -1;
+
+    template<typename Number>
+    struct ptr_value {
+      typedef ikos::interval<Number> interval_t;
+
+      uint8_t nullity;
+      // -- base and offsets of the pointer if it is not null. They
+      //    are irrelevant if NON_NULL is not set.
+      int64_t base;
+      interval_t offset;
+
+      ptr_value()
+	: nullity(NULLITY_TOP), base(unknown_base), offset(interval_t::top()) {}
+
+      ptr_value(uint8_t n, int64_t b, interval_t o)
+	: nullity(n), base(b), offset(o) {}
+
+      static ptr_value top() { return ptr_value(); }
+
+      static ptr_value null() {
+	return ptr_value(IS_NULL, unknown_base, interval_t::top());
+      }
+
+      static ptr_value object(int64_t b) {
+	return ptr_value(NON_NULL, b, interval_t(Number(0)));
+      }
+
+      bool may_be_non_null() const { return nullity & NON_NULL; }
+
+      bool is_top() const {
+	return nullity == NULLITY_TOP && base == unknown_base && offset.is_top();
+      }
+
+      bool operator<=(const ptr_value &o) const {
+	if ((nullity & o.nullity) != nullity) return false;
+	if (!may_be_non_null()) return true;
+	return ((o.base == unknown_base || o.base == base) && offset <= o.offset);
+      }
+
+      // Pointwise combination of the non-null parts with op. The
+      // base is unknown if they differ.
+      template<typename Op>
+      ptr_value combine(const ptr_value &o, Op op) const {
+	if (!may_be_non_null()) return ptr_value(nullity | o.nullity, o.base, o.offset);
+	if (!o.may_be_non_null()) return ptr_value(nullity | o.nullity, base, offset);
+	return ptr_value(nullity | o.nullity, (base == o.base ? base : unknown_base),
+			 op(offset, o.offset));
+      }
+
+      ptr_value operator|(const ptr_value &o) const {
+	return combine(o, [](interval_t x, interval_t y) { return x | y; });
+      }
+
+      ptr_value operator||(const ptr_value &o) const {
+	return combine(o, [](interval_t x, interval_t y) { return x || y; });
+      }
+
+      template<typename Thresholds>
+      ptr_value widening_thresholds(const ptr_value &o, const Thresholds &ts) const {
+	return combine(o, [&ts](interval_t x, interval_t y) {
+	    return x.widening_thresholds(y, ts);
+	  });
+      }
+
+      // Pointwise meet with op. The non-null part is empty if the
+      // bases are different or the offsets are disjoint.
+      template<typename Op>
+      ptr_value refine(const ptr_value &o, Op op) const {
+	ptr_value res(nullity & o.nullity, base, offset);
+	if (!res.may_be_non_null()) return res;
+	if (base == unknown_base) {
+	  res.base = o.base;
+	} else if (o.base != unknown_base && o.base != base) {
+	  res.nullity &= ~NON_NULL;
+	  return res;
+	}
+	res.offset = op(offset, o.offset);
+	if (res.offset.is_bottom()) res.nullity &= ~NON_NULL;
+	return res;
+      }
+
+      ptr_value operator&(const ptr_value &o) const {
+	return refine(o, [](interval_t x, interval_t y) { return x & y; });
+      }
+
+      ptr_value operator&&(const ptr_value &o) const {
+	return refine(o, [](interval_t x, interval_t y) { return x && y; });
+      }
+
+      void write(crab::crab_os &o) const {
+	if (nullity == IS_NULL) {
+	  o << "null";
+	  return;
+	}
+	if (nullity == NULLITY_TOP) o << "null or ";
+	o << "&";
+	if (base == unknown_base) o << "?";
+	else o << "R" << base;
+	o << "+" << offset;
+      }
+    };
+  } // end namespace offset_pointer_impl
+
+  template<typename Number, typename VariableName>
+  class offset_pointer_domain:
+    public crab::domains::abstract_domain<Number, VariableName,
+					  offset_pointer_domain<Number,VariableName>> {
+  public:
+
+    typedef offset_pointer_domain<Number, VariableName> offset_pointer_domain_t;
+    typedef crab::domains::abstract_domain<Number, VariableName,
+					   offset_pointer_domain_t> abstract_domain_t;
+    using typename abstract_domain_t::linear_expression_t;
+    using typename abstract_domain_t::linear_constraint_t;
+    using typename abstract_domain_t::linear_constraint_system_t;
+    using typename abstract_domain_t::variable_t;
+    using typename abstract_domain_t::variable_vector_t;
+    using typename abstract_domain_t::pointer_constraint_t;
+    typedef Number number_t;
+    typedef VariableName varname_t;
+    typedef ikos::interval<Number> interval_t;
+    typedef dense_interval_domain<Number, VariableName> num_domain_t;
+    typedef offset_pointer_impl::ptr_value<Number> ptr_value_t;
+
+  private:
+
+    // -- the pointers that are not in the map are top
+    typedef std::map<variable_t, ptr_value_t> ptr_map_t;
+
+    num_domain_t m_num;
+    ptr_map_t m_ptrs;
+
+    offset_pointer_domain(num_domain_t num, ptr_map_t ptrs)
+      : m_num(num), m_ptrs(std::move(ptrs)) {
+      if (m_num.is_bottom()) m_ptrs.clear();
+    }
+
+    ptr_value_t get(const variable_t &v) const {
+      auto it = m_ptrs.find(v);
+      return (it == m_ptrs.end() ? ptr_value_t::top() : it->second);
+    }
+
+    void set(const variable_t &v, const ptr_value_t &x) {
+      if (m_num.is_bottom()) return;
+      if (x.nullity == offset_pointer_impl::NULLITY_BOT) {
+	set_to_bottom();
+      } else if (x.is_top()) {
+	m_ptrs.erase(v);
+      } else {
+	m_ptrs[v] = x;
+      }
+    }
+
+    // -- the pointers of both (the others are top in one of them)
+    template<typename Op>
+    ptr_map_t join_ptrs(const offset_pointer_domain_t &o, Op op) const {
+      ptr_map_t res;
+      auto it = m_ptrs.begin(), et = m_ptrs.end();
+      auto oit = o.m_ptrs.begin(), oet = o.m_ptrs.end();
+      while (it != et && oit != oet) {
+	if (it->first < oit->first) {
+	  ++it;
+	} else if (oit->first < it->first) {
+	  ++oit;
+	} else {
+	  ptr_value_t x = op(it->second, oit->second);
+	  if (!x.is_top()) res.insert(res.end(), std::make_pair(it->first, x));
+	  ++it;
+	  ++oit;
+	}
+      }
+      return res;
+    }
+
+    // -- the pointers of any of them. Return false if bottom.
+    template<typename Op>
+    bool meet_ptrs(const offset_pointer_domain_t &o, Op op, ptr_map_t &res) const {
+      res = m_ptrs;
+      for (auto &kv: o.m_ptrs) {
+	auto it = res.find(kv.first);
+	ptr_value_t x = (it == res.end() ? kv.second : op(it->second, kv.second));
+	if (x.nullity == offset_pointer_impl::NULLITY_BOT) return false;
+	res[kv.first] = x;
+      }
+      return true;
+    }
+
+    interval_t eval(const linear_expression_t &e) {
+      interval_t r(e.constant());
+      for (auto t: e) {
+	r = r + interval_t(t.first) * m_num[t.second];
+      }
+      return r;
+    }
+
+    void assume(const pointer_constraint_t &cst) {
+      if (is_bottom() || cst.is_tautology()) return;
+      if (cst.is_contradiction()) {
+	set_to_bottom();
+      } else if (cst.is_unary()) {
+	ptr_value_t x = get(cst.lhs());
+	x.nullity &= (cst.is_equality() ? offset_pointer_impl::IS_NULL
+		                        : offset_pointer_impl::NON_NULL);
+	set(cst.lhs(), x);
+      } else if (cst.is_equality()) {
+	ptr_value_t x = get(cst.lhs()) & get(cst.rhs());
+	set(cst.lhs(), x);
+	set(cst.rhs(), x);
+      } else if (get(cst.lhs()).nullity == offset_pointer_impl::IS_NULL) {
+	ptr_value_t x = get(cst.rhs());
+	x.nullity &= offset_pointer_impl::NON_NULL;
+	set(cst.rhs(), x);
+      } else if (get(cst.rhs()).nullity == offset_pointer_impl::IS_NULL) {
+	ptr_value_t x = get(cst.lhs());
+	x.nullity &= offset_pointer_impl::NON_NULL;
+	set(cst.lhs(), x);
+      }
+    }
+
+  public:
+
+    offset_pointer_domain() {}
+
+    static offset_pointer_domain_t top() {
+      return offset_pointer_domain_t(num_domain_t::top(), ptr_map_t());
+    }
+
+    static offset_pointer_domain_t bottom() {
+      return offset_pointer_domain_t(num_domain_t::bottom(), ptr_map_t());
+    }
+
+    void set_to_top() {
+      m_num.set_to_top();
+      m_ptrs.clear();
+    }
+
+    void set_to_bottom() {
+      m_num.set_to_bottom();
+      m_ptrs.clear();
+    }
+
+    bool is_bottom() { return m_num.is_bottom(); }
+
+    bool is_top() { return m_ptrs.empty() && m_num.is_top(); }
+
+    interval_t operator[](variable_t v) const { return m_num[v]; }
+
+    // The abstraction of the pointer v
+    ptr_value_t get_pointer(variable_t v) const { return get(v); }
+
+    bool operator<=(offset_pointer_domain_t o) {
+      if (is_bottom()) return true;
+      if (o.is_bottom()) return false;
+      if (!(m_num <= o.m_num)) return false;
+      for (auto &kv: o.m_ptrs) {
+	if (!(get(kv.first) <= kv.second)) return false;
+      }
+      return true;
+    }
+
+    void operator|=(offset_pointer_domain_t o) {
+      *this = *this | o;
+    }
+
+    offset_pointer_domain_t operator|(offset_pointer_domain_t o) {
+      if (is_bottom()) return o;
+      if (o.is_bottom()) return *this;
+      return offset_pointer_domain_t(m_num | o.m_num,
+				     join_ptrs(o, [](const ptr_value_t &x, const ptr_value_t &y) {
+					 return x | y;
+				       }));
+    }
+
+    offset_pointer_domain_t operator&(offset_pointer_domain_t o) {
+      if (is_bottom() || o.is_bottom()) return bottom();
+      ptr_map_t ptrs;
+      if (!meet_ptrs(o, [](const ptr_value_t &x, const ptr_value_t &y) { return x & y; },
+		     ptrs)) {
+	return bottom();
+      }
+      return offset_pointer_domain_t(m_num & o.m_num, std::move(ptrs));
+    }
+
+    offset_pointer_domain_t operator||(offset_pointer_domain_t o) {
+      if (is_bottom()) return o;
+      if (o.is_bottom()) return *this;
+      return offset_pointer_domain_t(m_num || o.m_num,
+				     join_ptrs(o, [](const ptr_value_t &x, const ptr_value_t &y) {
+					 return x || y;
+				       }));
+    }
+
+    template<typename Thresholds>
+    offset_pointer_domain_t widening_thresholds(offset_pointer_domain_t o,
+						const Thresholds &ts) {
+      if (is_bottom()) return o;
+      if (o.is_bottom()) return *this;
+      return offset_pointer_domain_t(m_num.widening_thresholds(o.m_num, ts),
+				     join_ptrs(o, [&ts](const ptr_value_t &x, const ptr_value_t &y) {
+					 return x.widening_thresholds(y, ts);
+				       }));
+    }
+
+    offset_pointer_domain_t operator&&(offset_pointer_domain_t o) {
+      if (is_bottom() || o.is_bottom()) return bottom();
+      ptr_map_t ptrs;
+      if (!meet_ptrs(o, [](const ptr_value_t &x, const ptr_value_t &y) { return x && y; },
+		     ptrs)) {
+	return bottom();
+      }
+      return offset_pointer_domain_t(m_num && o.m_num, std::move(ptrs));
+    }
+
+    void operator-=(variable_t v) {
+      if (is_bottom()) return;
+      m_num -= v;
+      m_ptrs.erase(v);
+    }
+
+    void operator+=(linear_constraint_system_t csts) {
+      m_num += csts;
+      if (is_bottom()) m_ptrs.clear();
+    }
+
+    void assign(variable_t x, linear_expression_t e) { m_num.assign(x, e); }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, variable_t z) {
+      m_num.apply(op, x, y, z);
+    }
+
+    void apply(crab::domains::operation_t op, variable_t x, variable_t y, Number k) {
+      m_num.apply(op, x, y, k);
+    }
+
+    void apply(crab::domains::int_conv_operation_t op, variable_t dst, variable_t src) {
+      m_num.apply(op, dst, src);
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, variable_t z) {
+      m_num.apply(op, x, y, z);
+    }
+
+    void apply(crab::domains::bitwise_operation_t op, variable_t x, variable_t y, Number k) {
+      m_num.apply(op, x, y, k);
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, variable_t z) {
+      m_num.apply(op, x, y, z);
+    }
+
+    void apply(crab::domains::div_operation_t op, variable_t x, variable_t y, Number k) {
+      m_num.apply(op, x, y, k);
+    }
+
+    void backward_assign(variable_t x, linear_expression_t e,
+			 offset_pointer_domain_t invariant) {
+      m_num.backward_assign(x, e, invariant.m_num);
+      if (is_bottom()) m_ptrs.clear();
+    }
+
+    void backward_apply(crab::domains::operation_t op,
+			variable_t x, variable_t y, Number z,
+			offset_pointer_domain_t invariant) {
+      m_num.backward_apply(op, x, y, z, invariant.m_num);
+      if (is_bottom()) m_ptrs.clear();
+    }
+
+    void backward_apply(crab::domains::operation_t op,
+			variable_t x, variable_t y, variable_t z,
+			offset_pointer_domain_t invariant) {
+      m_num.backward_apply(op, x, y, z, invariant.m_num);
+      if (is_bottom()) m_ptrs.clear();
+    }
+
+    /* booleans are not tracked */
+    void assign_bool_cst(variable_t /*lhs*/, linear_constraint_t /*rhs*/) {}
+    void assign_bool_var(variable_t /*lhs*/, variable_t /*rhs*/, bool /*is_not_rhs*/) {}
+    void apply_binary_bool(crab::domains::bool_operation_t /*op*/,
+			   variable_t /*x*/, variable_t /*y*/, variable_t /*z*/) {}
+    void assume_bool(variable_t /*v*/, bool /*is_negated*/) {}
+    void backward_assign_bool_cst(variable_t /*lhs*/, linear_constraint_t /*rhs*/,
+				  offset_pointer_domain_t /*invariant*/) {}
+    void backward_assign_bool_var(variable_t /*lhs*/, variable_t /*rhs*/, bool /*is_not_rhs*/,
+				  offset_pointer_domain_t /*invariant*/) {}
+    void backward_apply_binary_bool(crab::domains::bool_operation_t /*op*/,
+				    variable_t /*x*/, variable_t /*y*/, variable_t /*z*/,
+				    offset_pointer_domain_t /*invariant*/) {}
+
+    /* arrays are handled by array_smashing */
+    void array_init(variable_t /*a*/, linear_expression_t /*elem_size*/,
+		    linear_expression_t /*lb_idx*/, linear_expression_t /*ub_idx*/,
+		    linear_expression_t /*val*/) {}
+    void array_load(variable_t lhs, variable_t /*a*/,
+		    linear_expression_t /*elem_size*/, linear_expression_t /*i*/) {
+      *this -= lhs;
+    }
+    void array_store(variable_t /*a*/, linear_expression_t /*elem_size*/,
+		     linear_expression_t /*i*/, linear_expression_t /*v*/,
+		     bool /*is_singleton*/) {}
+    void array_assign(variable_t /*lhs*/, variable_t /*rhs*/) {}
+
+    /* pointers: the contents of the memory are not tracked */
+    void pointer_load(variable_t lhs, variable_t /*rhs*/) {
+      *this -= lhs;
+    }
+
+    void pointer_store(variable_t /*lhs*/, variable_t /*rhs*/) {}
+
+    void pointer_assign(variable_t lhs, variable_t rhs, linear_expression_t offset) {
+      if (is_bottom()) return;
+      ptr_value_t x = get(rhs);
+      if (x.may_be_non_null()) {
+	x.offset = x.offset + eval(offset);
+	if (x.offset.is_bottom()) x.nullity &= ~offset_pointer_impl::NON_NULL;
+      }
+      set(lhs, x);
+    }
+
+    // The addresses of the objects whose region is unknown are
+    // greater than any region id (see CfgBuilder).
+    void pointer_mk_obj(variable_t lhs, ikos::index_t address) {
+      if (is_bottom()) return;
+      int64_t base = (address <= (ikos::index_t) INT_MAX ?
+		      (int64_t) address : offset_pointer_impl::unknown_base);
+      set(lhs, ptr_value_t::object(base));
+    }
+
+    void pointer_function(variable_t lhs, VariableName /*func*/) {
+      if (is_bottom()) return;
+      set(lhs, ptr_value_t::object(offset_pointer_impl::unknown_base));
+    }
+
+    void pointer_mk_null(variable_t lhs) {
+      if (is_bottom()) return;
+      set(lhs, ptr_value_t::null());
+    }
+
+    void pointer_assume(pointer_constraint_t cst) { assume(cst); }
+
+    void pointer_assert(pointer_constraint_t cst) { assume(cst); }
+
+    void forget(const variable_vector_t& vars) {
+      if (is_bottom()) return;
+      for (auto const &v: vars) {
+	*this -= v;
+      }
+    }
+
+    void project(const variable_vector_t& vars) {
+      if (is_bottom()) return;
+      m_num.project(vars);
+      ptr_map_t ptrs;
+      for (auto const &v: vars) {
+	auto it = m_ptrs.find(v);
+	if (it != m_ptrs.end()) ptrs.insert(*it);
+      }
+      std::swap(m_ptrs, ptrs);
+    }
+
+    void expand(variable_t x, variable_t new_x) {
+      if (is_bottom()) return;
+      m_num.expand(x, new_x);
+      set(new_x, get(x));
+    }
+
+    void normalize() {}
+
+    // Only the integer variables: the pointers have no linear
+    // constraints.
+    linear_constraint_system_t to_linear_constraint_system() {
+      return m_num.to_linear_constraint_system();
+    }
+
+    void write(crab::crab_os& o) {
+      if (is_bottom()) {
+	o << "_|_";
+	return;
+      }
+      m_num.write(o);
+      o << " {";
+      bool first = true;
+      for (auto &kv: m_ptrs) {
+	if (!first) o << "; ";
+	first = false;
+	o << kv.first << " -> ";
+	kv.second.write(o);
+      }
+      o << "}";
+    }
+
+    static std::string getDomainName() {
+      return "Offset Pointers";
+    }
+  };
+
+} // end namespace crab_llvm
+#endif
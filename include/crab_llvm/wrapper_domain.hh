@@ -5,6 +5,12 @@
 #include "crab/config.h"
 #include "crab_llvm/crab_domains.hh"
 
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
 /**
  *  Definition of a generic wrapper class (for crab-llvm clients) to
  *  contain an arbitrary abstract domain.
@@ -21,18 +27,22 @@ namespace llvm {
   #define DUMP_TO_LLVM_STREAM(T)  \
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o, \
                                        T& e) {               \
-    crab::crab_string_os s;                                  \
+    crab_llvm::raw_crab_os s(o);                             \
     s << e;                                                  \
-    o << s.str ();                                           \
     return o; }                                                        
 
   DUMP_TO_LLVM_STREAM(crab_llvm::lin_exp_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::lin_cst_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::lin_cst_sys_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::interval_domain_t)
+  DUMP_TO_LLVM_STREAM(crab_llvm::dense_interval_domain_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::wrapped_interval_domain_t)
+  DUMP_TO_LLVM_STREAM(crab_llvm::wrapped_interval_fast_domain_t)
+  DUMP_TO_LLVM_STREAM(crab_llvm::offset_pointer_domain_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::ric_domain_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::split_dbm_domain_t)
+  DUMP_TO_LLVM_STREAM(crab_llvm::split_dbm_fast_domain_t)
+  DUMP_TO_LLVM_STREAM(crab_llvm::dense_dbm_domain_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::boxes_domain_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::dis_interval_domain_t)
   DUMP_TO_LLVM_STREAM(crab_llvm::num_domain_t)
@@ -40,9 +50,8 @@ namespace llvm {
   template <typename DomInfo>
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o, 
                                        crab::domains::term_domain<DomInfo>& inv) {
-    crab::crab_string_os s;
+    crab_llvm::raw_crab_os s(o);
     s << inv;
-    o << s.str ();
     return o;
   }
 
@@ -51,9 +60,8 @@ namespace llvm {
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o, 
   				       crab::domains::apron_domain 
   				       <N,V,D> & inv) {
-    crab::crab_string_os s;
+    crab_llvm::raw_crab_os s(o);
     s << inv;
-    o << s.str ();
     return o;
   }
   #else 
@@ -61,9 +69,8 @@ namespace llvm {
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o, 
 				       crab::domains::elina_domain 
 				       <N,V,D> & inv) {
-    crab::crab_string_os s;
+    crab_llvm::raw_crab_os s(o);
     s << inv;
-    o << s.str ();
     return o;
   }
   #endif
@@ -71,9 +78,8 @@ namespace llvm {
   template <typename Base>
   inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o, 
 				       crab::domains::array_smashing <Base> & inv) {
-    crab::crab_string_os s;
+    crab_llvm::raw_crab_os s(o);
     s << inv;
-    o << s.str ();
     return o;
   }
 
@@ -86,42 +92,108 @@ namespace crab_llvm {
    /// Definition of macros
    //////
 
+   // The abstract value is shared by the copies of a wrapper
+   // (clone) and it is only copied when one of them is modified
+   // (copy-on-write).
    #define DEFINE_WRAPPER(WRAPPER,ABS_DOM,ID)                        \
    class WRAPPER: public GenericAbsDomWrapper {                      \
      id_t m_id;                                                      \
-     ABS_DOM m_abs;                                                  \
+     boost::shared_ptr<ABS_DOM> m_abs;                               \
+     mutable std::size_t m_fp;                                       \
+     mutable bool m_has_fp;                                          \
+                                                                     \
+     void detach() {                                                 \
+       if (!m_abs.unique()) {                                        \
+         m_abs = boost::make_shared<ABS_DOM>(*m_abs);                \
+       }                                                             \
+       m_has_fp = false;                                             \
+     }                                                               \
     public:                                                          \
     id_t getId() const { return m_id;}				     \
     								     \
     WRAPPER(ABS_DOM abs, id_t id):				     \
-      GenericAbsDomWrapper(), m_id(id), m_abs(abs) { }		     \
+      GenericAbsDomWrapper(), m_id(id),                              \
+      m_abs(boost::make_shared<ABS_DOM>(abs)),                       \
+      m_fp(0), m_has_fp(false) { }                                   \
     								     \
     WRAPPER(ABS_DOM abs):					     \
-      GenericAbsDomWrapper(), m_id (ID), m_abs (abs) { }	     \
+      GenericAbsDomWrapper(), m_id (ID),                             \
+      m_abs(boost::make_shared<ABS_DOM>(abs)),                       \
+      m_fp(0), m_has_fp(false) { }                                   \
+                                                                     \
+    WRAPPER(const WRAPPER &o):                                       \
+      GenericAbsDomWrapper(), m_id(o.m_id), m_abs(o.m_abs),          \
+      m_fp(o.m_fp), m_has_fp(o.m_has_fp) { }                         \
     								     \
     GenericAbsDomWrapperPtr clone() const {			     \
-      auto res = boost::make_shared<WRAPPER>(m_abs, m_id); 	     \
+      auto res = boost::make_shared<WRAPPER>(*this); 	             \
       return res;						     \
     }								     \
     								     \
-    ABS_DOM& get() { return m_abs; }				     \
+    const ABS_DOM& get() const { return *m_abs; }                    \
+    								     \
+    ABS_DOM& get() { detach(); return *m_abs; }                      \
     								     \
     lin_cst_sys_t to_linear_constraints() {			     \
-      return m_abs.to_linear_constraint_system();		     \
+      return m_abs->to_linear_constraint_system();		     \
     }								     \
     								     \
+    lin_cst_sys_t to_linear_constraints(const std::vector<var_t>& vars) const { \
+      ABS_DOM abs(*m_abs);                                           \
+      abs.project(vars);                                             \
+      return abs.to_linear_constraint_system();                      \
+    }								     \
+    								     \
+    void for_each_constraint(const constraint_fn_t &f) const {       \
+      crab_llvm::for_each_constraint(*m_abs, f);                     \
+    }								     \
+    								     \
+    void accept(GenericAbsDomVisitor &v) const { v.visit(*m_abs); }  \
+    								     \
     void write(crab::crab_os& o) {				     \
-      m_abs.write (o);						     \
+      m_abs->write (o);						     \
     }								     \
     								     \
     void forget(const std::vector<var_t>& vars) {		     \
-      m_abs.forget(vars);					     \
+      detach();                                                      \
+      m_abs->forget(vars);					     \
     }								     \
     								     \
     void project(const std::vector<var_t>& vars) {		     \
-      m_abs.project(vars);					     \
+      detach();                                                      \
+      m_abs->project(vars);					     \
     }								     \
-    								     \
+                                                                     \
+    unsigned num_finite_bounds(const std::vector<var_t>& vars) {     \
+      return crab_llvm::num_finite_bounds(*m_abs, vars);             \
+    }                                                                \
+                                                                     \
+    std::size_t fingerprint() const {                                \
+      if (!m_has_fp) {                                               \
+        crab::crab_string_os s;                                      \
+        s << m_abs->to_linear_constraint_system();                   \
+        m_fp = std::hash<std::string>()(s.str());                    \
+        m_has_fp = true;                                             \
+      }                                                              \
+      return m_fp;                                                   \
+    }                                                                \
+                                                                     \
+    bool shares_value(const GenericAbsDomWrapper &o) const {         \
+      auto other = dynamic_cast<const WRAPPER*>(&o);                 \
+      return other && other->m_abs == m_abs;                         \
+    }                                                                \
+                                                                     \
+    bool equals(const GenericAbsDomWrapper &o) const {               \
+      auto other = dynamic_cast<const WRAPPER*>(&o);                 \
+      if (!other) {                                                  \
+        /* o can be a wrapper that builds its value on demand */     \
+        return o.getId() == m_id && o.equals(*this);                 \
+      }                                                              \
+      if (other->m_abs == m_abs) return true;                        \
+      ABS_DOM &a = const_cast<ABS_DOM&>(*m_abs);                     \
+      ABS_DOM &b = const_cast<ABS_DOM&>(*other->m_abs);              \
+      return a <= b && b <= a;                                       \
+    }                                                                \
    };                                                                \
                                                                      \
    template <> inline GenericAbsDomWrapperPtr                        \
@@ -130,10 +202,16 @@ namespace crab_llvm {
      return res;                                                     \
    }                                                                 \
                                                                      \
+   template <> inline const ABS_DOM*                                 \
+   getAbsDomWrappeePtr (const GenericAbsDomWrapperPtr &wrapper) {    \
+     auto wrappee = dynamic_cast<const WRAPPER*>(wrapper.get());     \
+     return (wrappee ? &wrappee->get () : nullptr);                  \
+   }                                                                 \
+                                                                     \
    template <>                                                       \
    inline void getAbsDomWrappee (GenericAbsDomWrapperPtr wrapper,    \
                                  ABS_DOM &abs_dom) {                 \
-     auto wrappee = boost::dynamic_pointer_cast<WRAPPER> (wrapper);  \
+     auto wrappee = boost::dynamic_pointer_cast<const WRAPPER>(wrapper); \
      if (!wrappee) {                                                 \
        CRAB_ERROR("Could not cast wrapper to an instance of ",       \
                   ABS_DOM::getDomainName ());                        \
@@ -141,6 +219,83 @@ namespace crab_llvm {
      abs_dom = wrappee->get ();                                      \
    }                                                 
 
+  // Number of finite bounds of vars in abs. It is a cheap measure of
+  // the size of an abstract value since abs is not converted into
+  // linear constraints.
+  template<typename ABS_DOM>
+  inline unsigned num_finite_bounds(ABS_DOM &abs, const std::vector<var_t>& vars) {
+    if (abs.is_bottom()) return 0;
+    unsigned res = 0;
+    for (auto const &v: vars) {
+      auto i = abs[v];
+      if (i.lb().is_finite()) res++;
+      if (i.ub().is_finite()) res++;
+    }
+    return res;
+  }
+  
+  // Call f on each linear constraint of abs until f returns false.
+  // Crab domains can only be converted into linear constraints as a
+  // whole so the system is built here, but abs is not copied and
+  // clients do not keep the system alive.
+  template<typename ABS_DOM, typename F>
+  inline void for_each_constraint(const ABS_DOM &abs, const F &f) {
+    ABS_DOM &a = const_cast<ABS_DOM&>(abs);
+    for (auto const &cst: a.to_linear_constraint_system()) {
+      if (!f(cst)) return;
+    }
+  }
+
+  //////
+  // Read-only access to the abstract value of a wrapper without
+  // copying it (see GenericAbsDomWrapper::accept). Only the visit
+  // method of the domain of the wrapper is called.
+  //////
+  struct GenericAbsDomVisitor {
+    virtual ~GenericAbsDomVisitor() { }
+    virtual void visit(const interval_domain_t &inv) = 0;
+    virtual void visit(const dense_interval_domain_t &inv) = 0;
+    virtual void visit(const wrapped_interval_domain_t &inv) = 0;
+    virtual void visit(const wrapped_interval_fast_domain_t &inv) = 0;
+    virtual void visit(const offset_pointer_domain_t &inv) = 0;
+    virtual void visit(const ric_domain_t &inv) = 0;
+    virtual void visit(const split_dbm_domain_t &inv) = 0;
+    virtual void visit(const split_dbm_fast_domain_t &inv) = 0;
+    virtual void visit(const dense_dbm_domain_t &inv) = 0;
+    virtual void visit(const term_int_domain_t &inv) = 0;
+    virtual void visit(const term_dis_int_domain_t &inv) = 0;
+    virtual void visit(const boxes_domain_t &inv) = 0;
+    virtual void visit(const dis_interval_domain_t &inv) = 0;
+    virtual void visit(const oct_domain_t &inv) = 0;
+    virtual void visit(const pk_domain_t &inv) = 0;
+    virtual void visit(const num_domain_t &inv) = 0;
+  };
+
+  // A visitor that calls f with any domain: F is a function object
+  // with a template operator().
+  template<typename F>
+  class GenericAbsDomFunctionVisitor: public GenericAbsDomVisitor {
+    F &m_f;
+  public:
+    GenericAbsDomFunctionVisitor(F &f): m_f(f) { }
+    void visit(const interval_domain_t &inv) { m_f(inv); }
+    void visit(const dense_interval_domain_t &inv) { m_f(inv); }
+    void visit(const wrapped_interval_domain_t &inv) { m_f(inv); }
+    void visit(const wrapped_interval_fast_domain_t &inv) { m_f(inv); }
+    void visit(const offset_pointer_domain_t &inv) { m_f(inv); }
+    void visit(const ric_domain_t &inv) { m_f(inv); }
+    void visit(const split_dbm_domain_t &inv) { m_f(inv); }
+    void visit(const split_dbm_fast_domain_t &inv) { m_f(inv); }
+    void visit(const dense_dbm_domain_t &inv) { m_f(inv); }
+    void visit(const term_int_domain_t &inv) { m_f(inv); }
+    void visit(const term_dis_int_domain_t &inv) { m_f(inv); }
+    void visit(const boxes_domain_t &inv) { m_f(inv); }
+    void visit(const dis_interval_domain_t &inv) { m_f(inv); }
+    void visit(const oct_domain_t &inv) { m_f(inv); }
+    void visit(const pk_domain_t &inv) { m_f(inv); }
+    void visit(const num_domain_t &inv) { m_f(inv); }
+  };
+  
   //////
   // Generic wrapper to encapsulate an arbitrary abstract domain
   //////
@@ -155,7 +310,12 @@ namespace crab_llvm {
 		   boxes, dis_intv,
 		   oct, pk,
 		   num,
-		   w_intv} id_t;
+		   w_intv,
+		   dense_intv,
+		   split_dbm_fast,
+		   w_intv_fast,
+		   ptr_offsets,
+		   dense_dbm} id_t;
     
     GenericAbsDomWrapper() { }
     
@@ -168,10 +328,44 @@ namespace crab_llvm {
     virtual void write(crab::crab_os& o) = 0;
     
     virtual lin_cst_sys_t to_linear_constraints() = 0;
+
+    // Linear constraints only over vars. The abstract value is not
+    // modified.
+    virtual lin_cst_sys_t to_linear_constraints(const std::vector<var_t>& vars) const = 0;
+
+    typedef std::function<bool(const lin_cst_t&)> constraint_fn_t;
+    
+    // Call f on each linear constraint until f returns false (see
+    // crab_llvm::for_each_constraint).
+    virtual void for_each_constraint(const constraint_fn_t &f) const = 0;
+
+    // Call v with a const reference to the abstract value so it is
+    // not copied.
+    virtual void accept(GenericAbsDomVisitor &v) const = 0;
     
     virtual void forget(const std::vector<var_t>& vars) = 0;
     
     virtual void project(const std::vector<var_t>& vars) = 0;    
+
+    // See num_finite_bounds. The abstract value is not copied since
+    // it is not modified (at most normalized).
+    virtual unsigned num_finite_bounds(const std::vector<var_t>& vars) = 0;
+
+    // Hash of the linear constraints of the abstract value. Different
+    // fingerprints imply different constraints. It is computed once
+    // until the value is modified.
+    virtual std::size_t fingerprint() const = 0;
+
+    // Return true if both wrappers share the same abstract value
+    // (e.g., one is a clone of the other and none was modified).
+    // Then they are trivially equal.
+    virtual bool shares_value(const GenericAbsDomWrapper &o) const = 0;
+
+    // Return true if both wrappers have the same abstract value. It
+    // is constant time if they share it, otherwise the values are
+    // compared with the inclusion of their domain (false if o is of
+    // another domain).
+    virtual bool equals(const GenericAbsDomWrapper &o) const = 0;
    };
   
    typedef GenericAbsDomWrapper::GenericAbsDomWrapperPtr GenericAbsDomWrapperPtr;
@@ -184,9 +378,8 @@ namespace crab_llvm {
 
    inline llvm::raw_ostream& operator<<(llvm::raw_ostream& o , 
                                         const GenericAbsDomWrapperPtr& v) {
-     crab::crab_string_os s;
+     crab_llvm::raw_crab_os s(o);
      v->write (s);
-     o << s.str ();
      return o;
    }
 
@@ -198,10 +391,29 @@ namespace crab_llvm {
    template <typename T> 
    inline void getAbsDomWrappee (GenericAbsDomWrapperPtr wrapper, T& wrappee);
 
+   // For crab-llvm clients: the underlying crab domain without copying
+   // it, or null if the wrapper does not contain a T. It is valid
+   // while the wrapper is alive and not modified.
+   template <typename T> 
+   inline const T* getAbsDomWrappeePtr (const GenericAbsDomWrapperPtr &wrapper);
+
+   // For crab-llvm clients: call f with a const reference to the
+   // underlying crab domain, whatever it is.
+   template <typename F>
+   inline void visitAbsDomWrappee (const GenericAbsDomWrapperPtr &wrapper, F &f) {
+     GenericAbsDomFunctionVisitor<F> v(f);
+     wrapper->accept(v);
+   }
+
    DEFINE_WRAPPER(IntervalDomainWrapper,interval_domain_t,intv)
+   DEFINE_WRAPPER(DenseIntervalDomainWrapper,dense_interval_domain_t,dense_intv)
    DEFINE_WRAPPER(WrappedIntervalDomainWrapper,wrapped_interval_domain_t,w_intv)
+   DEFINE_WRAPPER(WrappedIntervalFastDomainWrapper,wrapped_interval_fast_domain_t,w_intv_fast)
+   DEFINE_WRAPPER(OffsetPointerDomainWrapper,offset_pointer_domain_t,ptr_offsets)
    DEFINE_WRAPPER(RicDomainWrapper,ric_domain_t,ric)
    DEFINE_WRAPPER(SDbmDomainWrapper,split_dbm_domain_t,split_dbm)
+   DEFINE_WRAPPER(SDbmFastDomainWrapper,split_dbm_fast_domain_t,split_dbm_fast)
+   DEFINE_WRAPPER(DenseDbmDomainWrapper,dense_dbm_domain_t,dense_dbm)
    DEFINE_WRAPPER(TermIntDomainWrapper,term_int_domain_t,term_intv)
    DEFINE_WRAPPER(TermDisIntDomainWrapper,term_dis_int_domain_t,term_dis_intv)
    DEFINE_WRAPPER(BoxesDomainWrapper,boxes_domain_t,boxes)
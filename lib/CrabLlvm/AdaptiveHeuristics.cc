@@ -0,0 +1,250 @@
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/AdaptiveHeuristics.hh"
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+
+using namespace llvm;
+
+extern cl::opt<enum crab::cfg::tracked_precision> CrabTrackLev;
+extern cl::opt<unsigned int> CrabWideningAutoJumpSet;
+
+namespace crab_llvm {
+
+  namespace adaptive_impl {
+
+    static bool isTrackedValue(const Value &v) {
+      if (!isa<Instruction>(v) && !isa<Argument>(v)) return false;
+      Type *ty = v.getType();
+      return (ty->isIntegerTy() ||
+	      (CrabTrackLev >= crab::cfg::PTR && ty->isPointerTy()));
+    }
+    
+    // Return the max number of tracked LLVM values that are live at
+    // the exit of a block of F (only blocks inside loops if
+    // only_loops). Values are numbered densely so the sets are
+    // bitsets and the fixpoint is a single backward pass for acyclic
+    // functions.
+    unsigned maxLiveOut(const Function &F, bool only_loops) {
+      // -- blocks inside loops
+      DenseSet<const BasicBlock*> loop_blocks;
+      if (only_loops) {
+	for (auto it = scc_begin(&F); !it.isAtEnd(); ++it) {
+	  if (it.hasLoop()) {
+	    loop_blocks.insert((*it).begin(), (*it).end());
+	  }
+	}
+	if (loop_blocks.empty()) return 0;
+      }
+      
+      // -- number the tracked values
+      DenseMap<const Value*, unsigned> ids;
+      for (auto &A: F.args()) {
+	if (isTrackedValue(A)) ids.insert(std::make_pair(&A, ids.size()));
+      }
+      for (auto &I: instructions(&F)) {
+	if (isTrackedValue(I)) ids.insert(std::make_pair(&I, ids.size()));
+      }
+      unsigned n = ids.size();
+      
+      // -- upward exposed uses and definitions of each block. Phi
+      //    operands are used at the end of the incoming block.
+      DenseMap<const BasicBlock*, BitVector> uses, defs, live_in, live_out;
+      for (auto &B: F) {
+	BitVector &u = uses[&B];
+	BitVector &d = defs[&B];
+	u.resize(n);
+	d.resize(n);
+	live_in[&B].resize(n);
+	for (auto &I: B) {
+	  auto it = ids.find(&I);
+	  if (it != ids.end()) d.set(it->second);
+	  if (isa<PHINode>(I)) continue;
+	  for (const Use &U: I.operands()) {
+	    auto vit = ids.find(U.get());
+	    if (vit == ids.end()) continue;
+	    const Instruction *def = dyn_cast<Instruction>(U.get());
+	    if (!def || def->getParent() != &B) u.set(vit->second);
+	  }
+	}
+      }
+      
+      // -- backward fixpoint
+      bool change = true;
+      while (change) {
+	change = false;
+	for (auto it = F.getBasicBlockList().rbegin(),
+	       et = F.getBasicBlockList().rend(); it != et; ++it) {
+	  const BasicBlock &B = *it;
+	  BitVector out(n);
+	  for (const BasicBlock *S: succs(B)) {
+	    out |= live_in[S];
+	    for (auto &I: *S) {
+	      const PHINode *PHI = dyn_cast<PHINode>(&I);
+	      if (!PHI) break;
+	      auto vit = ids.find(PHI->getIncomingValueForBlock(&B));
+	      if (vit != ids.end()) out.set(vit->second);
+	    }
+	  }
+	  BitVector in(out);
+	  in.reset(defs[&B]);
+	  in |= uses[&B];
+	  if (in != live_in[&B]) {
+	    live_in[&B] = std::move(in);
+	    change = true;
+	  }
+	  live_out[&B] = std::move(out);
+	}
+      }
+
+      unsigned res = 0;
+      for (auto &kv: live_out) {
+	if (only_loops && loop_blocks.count(kv.first) == 0) continue;
+	res = std::max(res, (unsigned) kv.second.count());
+      }
+      return res;
+    }
+
+    unsigned maxLiveInLoops(const Function &F) {
+      return maxLiveOut(F, true);
+    }
+
+    // Return the size of the largest pack of F. A pack is a set of
+    // tracked LLVM values that can be related by the
+    // translation. Values in different packs never appear in the same
+    // constraint so a sparse relational domain (e.g., split DBM) does
+    // not relate them either.
+    unsigned maxPackSize(const Function &F) {
+      EquivalenceClasses<const Value*> packs;
+      for (auto &I: instructions(&F)) {
+	// assumes are translated from comparisons so a comparison
+	// relates its operands
+	if (!isTrackedValue(I)) continue;
+	if (!isa<BinaryOperator>(I) && !isa<CastInst>(I) && !isa<CmpInst>(I) &&
+	    !isa<PHINode>(I) && !isa<SelectInst>(I) && !isa<GetElementPtrInst>(I)) {
+	  continue;
+	}
+	packs.insert(&I);
+	for (const Use &U: I.operands()) {
+	  const Value *v = U.get();
+	  if (isTrackedValue(*v)) packs.unionSets(&I, v);
+	}
+      }
+      
+      unsigned res = 0;
+      for (auto it = packs.begin(), et = packs.end(); it != et; ++it) {
+	if (!it->isLeader()) continue;
+	unsigned size = std::distance(packs.member_begin(it), packs.member_end());
+	res = std::max(res, size);
+      }
+      return res;
+    }
+
+    // Return an upper bound of the number of terms that a term
+    // domain creates for F. Each translated operation over tracked
+    // values adds a term for its result and the terms are never
+    // collected during the analysis of a function, so the table of
+    // a long straight-line function grows with its number of
+    // operations. Each phi of a loop adds a fresh term at each join
+    // of the fixpoint, which is bounded here by its loop depth.
+    unsigned numTerms(const Function &F) {
+      DominatorTree DT;
+      DT.recalculate(const_cast<Function&>(F));
+      LoopInfo LI;
+      LI.analyze(DT);
+      unsigned res = 0;
+      for (auto &A: F.args()) {
+	if (isTrackedValue(A)) res++;
+      }
+      for (auto &I: instructions(&F)) {
+	if (!isTrackedValue(I)) continue;
+	if (isa<PHINode>(I)) {
+	  res += 1 + LI.getLoopDepth(I.getParent());
+	} else if (isa<BinaryOperator>(I) || isa<CastInst>(I) || isa<SelectInst>(I) ||
+		   isa<GetElementPtrInst>(I) || isa<LoadInst>(I) || isa<CallInst>(I)) {
+	  // -- operands that are constants are terms too
+	  res++;
+	  for (const Use &U: I.operands()) {
+	    if (isa<ConstantInt>(U.get())) res++;
+	  }
+	}
+      }
+      return res;
+    }
+
+    // Return the number of distinct constants compared inside the
+    // loops of F. Crab takes the thresholds for widening from the
+    // assume statements so they are the constants of the loop
+    // guards.
+    static unsigned numLoopGuardConstants(const Function &F) {
+      std::set<std::pair<unsigned, uint64_t>> csts;
+      for (auto it = scc_begin(&F); !it.isAtEnd(); ++it) {
+	if (!it.hasLoop()) continue;
+	for (const BasicBlock *B: *it) {
+	  for (auto &I: *B) {
+	    if (!isa<ICmpInst>(I)) continue;
+	    for (const Use &U: I.operands()) {
+	      if (const ConstantInt *k = dyn_cast<ConstantInt>(U.get())) {
+		if (k->getBitWidth() <= 64) {
+		  csts.insert(std::make_pair(k->getBitWidth(), k->getZExtValue()));
+		}
+	      }
+	    }
+	  }
+	}
+      }
+      return csts.size();
+    }
+
+    // Return the jump set size of F if --crab-widening-auto-jump-set
+    // (0 otherwise)
+    unsigned autoJumpSet(const Function &F) {
+      if (CrabWideningAutoJumpSet == 0) return 0;
+      return std::min((unsigned) CrabWideningAutoJumpSet, numLoopGuardConstants(F));
+    }
+
+    // Return the max number of tracked parameters and return values
+    // of the functions of a SCC of the call graph of M. Summaries are
+    // relations between these values and all the functions of a SCC
+    // are summarized together.
+    unsigned maxSccBoundary(Module &M) {
+      CallGraph cg(M);
+      unsigned max_vars = 0;
+      for (auto it = scc_begin(&cg); !it.isAtEnd(); ++it) {
+	unsigned vars = 0;
+	for (CallGraphNode *n: *it) {
+	  const Function *F = n->getFunction();
+	  if (!F || !isTrackable(*F)) continue;
+	  for (auto &A: F->args()) {
+	    if (isTrackedValue(A)) vars++;
+	  }
+	  Type *ty = F->getReturnType();
+	  if (ty->isIntegerTy() || (CrabTrackLev >= crab::cfg::PTR && ty->isPointerTy())) {
+	    vars++;
+	  }
+	}
+	max_vars = std::max(max_vars, vars);
+      }
+      return max_vars;
+    }
+  } // end namespace adaptive_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,76 @@
+#include "llvm/IR/Function.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/AllocAccountant.hh"
+
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  namespace alloc_stats_impl {
+
+    static double mb(double bytes) { return bytes / (1024.0 * 1024.0); }
+
+    /** Begin accountant **/
+    void accountant::add(const std::string &fn, const std::string &phase,
+			 const alloc_sample &s) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_phases[phase] += s;
+      if (!fn.empty()) m_functions[fn] += s;
+    }
+
+    void accountant::print(raw_ostream &o, unsigned top) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      o << "\n=== Allocations ===\n";
+      o << format("%-20s %12s %12s %12s\n", "phase", "allocs", "MB", "live MB");
+      for (auto &kv: m_phases) {
+	o << format("%-20s %12llu %12.1f %12.1f\n", kv.first.c_str(),
+		    (unsigned long long) kv.second.allocs, mb(kv.second.bytes),
+		    mb(kv.second.net_bytes));
+      }
+      std::vector<std::pair<std::string, alloc_sample>> funcs(m_functions.begin(),
+								m_functions.end());
+      std::sort(funcs.begin(), funcs.end(),
+		[](const std::pair<std::string, alloc_sample> &f1,
+		   const std::pair<std::string, alloc_sample> &f2) {
+		  return f1.second.bytes > f2.second.bytes;
+		});
+      if (funcs.size() > top) funcs.resize(top);
+      o << format("%-20s %12s %12s %12s\n", "function", "allocs", "MB", "live MB");
+      for (auto &kv: funcs) {
+	o << format("%-20s %12llu %12.1f %12.1f\n", kv.first.c_str(),
+		    (unsigned long long) kv.second.allocs, mb(kv.second.bytes),
+		    mb(kv.second.net_bytes));
+      }
+      o << format("%-20s %38.1f\n", "peak live MB", mb(peak_alloc_bytes()));
+      for (auto &kv: m_phases) {
+	o << "BRUNCH_STAT Alloc." << kv.first << ".kb " << kv.second.bytes / 1024 << "\n";
+      }
+      o << "BRUNCH_STAT Alloc.peak.kb " << peak_alloc_bytes() / 1024 << "\n";
+    }
+    /** End accountant **/
+
+    /** Begin scoped_alloc **/
+    scoped_alloc::scoped_alloc(accountant *acc, StringRef phase, const Function *F)
+      : m_acc(acc), m_enabled((bool) acc) {
+      if (!m_enabled) return;
+      m_phase = phase.str();
+      if (F) m_fn = F->getName().str();
+      m_enabled = read_alloc_counters(m_start);
+    }
+
+    scoped_alloc::~scoped_alloc() {
+      alloc_sample end;
+      if (m_enabled && read_alloc_counters(end)) {
+	m_acc->add(m_fn, m_phase, end - m_start);
+      }
+    }
+    /** End scoped_alloc **/
+  } // end namespace alloc_stats_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,109 @@
+#include "llvm/IR/Module.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/AutoSeaDsa.hh"
+#include "crab_llvm/ChildProcess.hh"
+#include "crab_llvm/SeaDsaHeapAbstraction.hh"
+#include "crab_llvm/SnapshotHeapAbstraction.hh"
+#include "crab_llvm/MixedHeapAbstraction.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab_llvm/Support/Stats.hh"
+#include "crab/common/debug.hpp"
+
+#include <boost/make_shared.hpp>
+#include <memory>
+
+using namespace llvm;
+
+extern cl::opt<bool> CrabDsaDisambiguateUnknown;
+extern cl::opt<bool> CrabDsaDisambiguatePtrCast;
+extern cl::opt<bool> CrabDsaDisambiguateExternal;
+extern cl::opt<unsigned> CrabDsaAutoTimeout;
+extern cl::opt<unsigned> CrabDsaAutoMemory;
+extern cl::opt<unsigned> CrabDsaAutoFnRegions;
+extern cl::opt<bool> CrabInter;
+
+namespace crab_llvm {
+
+  namespace auto_dsa_impl {
+
+    static const char *snapshot_config = "auto-cs-sea-dsa";
+
+    static SeaDsaHeapAbstraction* mkSeaDsa(Module &M, CallGraph &cg,
+					   const TargetLibraryInfo &tli,
+					   bool is_context_sensitive) {
+      return new SeaDsaHeapAbstraction(M, cg, M.getDataLayout(), tli,
+				       is_context_sensitive,
+				       CrabDsaDisambiguateUnknown,
+				       CrabDsaDisambiguatePtrCast,
+				       CrabDsaDisambiguateExternal);
+    }
+
+    // Return the regions of context-sensitive sea-dsa or null if the
+    // child process did not finish. The reason is stored in error.
+    static std::unique_ptr<SnapshotHeapAbstraction>
+    runContextSensitive(Module &M, CallGraph &cg, const TargetLibraryInfo &tli,
+			std::string &error) {
+      SmallString<128> file;
+      if (sys::fs::createTemporaryFile("crab-dsa", "heap", file)) {
+	error = "cannot create a temporary file";
+	return nullptr;
+      }
+
+      child_impl::status_t status = child_impl::run([&]() {
+	  std::unique_ptr<SeaDsaHeapAbstraction> mem(mkSeaDsa(M, cg, tli, true));
+	  return SnapshotHeapAbstraction::write(*mem, M, file.str(), snapshot_config);
+	}, CrabDsaAutoTimeout, CrabDsaAutoMemory, error);
+
+      std::unique_ptr<SnapshotHeapAbstraction> res;
+      if (status == child_impl::FINISHED) {
+	res = SnapshotHeapAbstraction::load(M, file.str(), snapshot_config, error);
+      }
+      sys::fs::remove(file);
+      return res;
+    }
+
+    boost::shared_ptr<HeapAbstraction>
+    build(Module &M, CallGraph &cg, const TargetLibraryInfo &tli) {
+      std::string error;
+      boost::shared_ptr<HeapAbstraction> cs(runContextSensitive(M, cg, tli, error).release());
+      if (!cs) {
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Context-sensitive sea-dsa not used: "
+			                 << error << "\n";);
+	count_stat("CrabLlvm.heap.auto.ci_module");
+	return boost::shared_ptr<HeapAbstraction>(mkSeaDsa(M, cg, tli, false));
+      }
+
+      DenseSet<const Function*> fallback;
+      if (CrabDsaAutoFnRegions > 0) {
+	for (Function &F: M) {
+	  if (F.isDeclaration()) continue;
+	  if (cs->getAccessedRegions(F).size() > CrabDsaAutoFnRegions) {
+	    fallback.insert(&F);
+	  }
+	}
+      }
+      if (fallback.empty()) {
+	count_stat("CrabLlvm.heap.auto.cs_module");
+	return cs;
+      }
+      CRAB_VERBOSE_IF(1, get_crab_os() << fallback.size() << " functions access more than "
+		                       << CrabDsaAutoFnRegions << " context-sensitive regions\n";);
+      boost::shared_ptr<HeapAbstraction> ci(mkSeaDsa(M, cg, tli, false));
+      if (CrabInter) {
+	count_stat("CrabLlvm.heap.auto.ci_module");
+	return ci;
+      }
+      count_stat("CrabLlvm.heap.auto.cs_module");
+      count_stat("CrabLlvm.heap.auto.ci_functions", fallback.size());
+      return boost::make_shared<MixedHeapAbstraction>(M, cs, ci, fallback);
+    }
+  } // end namespace auto_dsa_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,44 @@
+#include "crab_llvm/config.h"
+#include "crab_llvm/BackwardCone.hh"
+
+namespace crab_llvm {
+
+  namespace cone_impl {
+
+    // blocks that can reach some block in targets (including targets)
+    block_set_t getCone(cfg_ref_t cfg, const block_set_t &targets) {
+      block_set_t cone(targets.begin(), targets.end());
+      std::vector<basic_block_label_t> worklist(targets.begin(), targets.end());
+      while (!worklist.empty()) {
+	basic_block_label_t bl = worklist.back();
+	worklist.pop_back();
+	for (auto p: boost::make_iterator_range(cfg.get_node(bl).prev_blocks())) {
+	  if (cone.insert(p).second) worklist.push_back(p);
+	}
+      }
+      return cone;
+    }
+
+    /* 
+     * Return a copy of cfg with only the blocks of cone (and the exit
+     * so the backward analysis has a start point). The other blocks
+     * cannot reach cone so the forward invariants of the blocks of
+     * cone do not change and their contribution to the necessary
+     * preconditions is bottom.
+     */
+    std::unique_ptr<cfg_t> restrict(const cfg_t &cfg, const block_set_t &cone) {
+      std::unique_ptr<cfg_t> res(new cfg_t(cfg.clone()));
+      std::vector<basic_block_label_t> removed;
+      for (auto bl: boost::make_iterator_range(res->label_begin(), res->label_end())) {
+	if (!cone.count(bl) && !(res->has_exit() && bl == res->exit())) {
+	  removed.push_back(bl);
+	}
+      }
+      for (auto bl: removed) {
+	res->remove(bl);
+      }
+      return res;
+    }
+  } // end namespace cone_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,238 @@
+#include "crab_llvm/config.h"
+
+/**
+ * Heap abstraction that bounds the number of regions per function.
+ */
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/BudgetHeapAbstraction.hh"
+#include "crab/common/debug.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace crab_llvm {
+
+using namespace llvm;
+
+namespace budget_heap_abs_impl {
+
+  template <typename Set>
+  void set_difference(Set &s1, const Set &s2) {
+    Set s3;
+    std::set_difference(s1.begin(), s1.end(), s2.begin(), s2.end(),
+			std::inserter(s3, s3.end()));
+    std::swap(s3, s1);
+  }
+
+  template <typename Set>
+  Set set_intersection(const Set &s1, const Set &s2) {
+    Set s3;
+    std::set_intersection(s1.begin(), s1.end(), s2.begin(), s2.end(),
+			  std::inserter(s3, s3.end()));
+    return s3;
+  }
+
+} // end namespace budget_heap_abs_impl
+
+  BudgetHeapAbstraction::region_t
+  BudgetHeapAbstraction::map(const region_t &r) {
+    if (r.isUnknown()) {
+      return region_t();
+    }
+    region_info r_info(r.get_type(), r.get_bitwidth());
+    auto it = m_rep.find(r.get_id());
+    int id = (it == m_rep.end() ? r.get_id() : it->second);
+    return region_t(static_cast<HeapAbstraction*>(this), id, r_info);
+  }
+
+  BudgetHeapAbstraction::region_set_t
+  BudgetHeapAbstraction::map(const region_set_t &s) {
+    region_set_t res;
+    for (const region_t &r: s) {
+      region_t mr = map(r);
+      if (!mr.isUnknown()) res.insert(mr);
+    }
+    return res;
+  }
+
+  void BudgetHeapAbstraction::mergeRegions(Function &F) {
+    region_set_t accessed = map(m_base->getAccessedRegions(F));
+    if (accessed.size() <= m_budget) return;
+
+    // -- number of loads and stores of each region in F
+    DenseMap<int, unsigned> count;
+    for (auto &I: instructions(&F)) {
+      Value *ptr = nullptr;
+      if (LoadInst *LI = dyn_cast<LoadInst>(&I)) {
+	ptr = LI->getPointerOperand();
+      } else if (StoreInst *SI = dyn_cast<StoreInst>(&I)) {
+	ptr = SI->getPointerOperand();
+      }
+      if (!ptr) continue;
+      region_t r = map(m_base->getRegion(F, ptr));
+      if (!r.isUnknown()) count[r.get_id()]++;
+    }
+
+    std::vector<region_t> candidates;
+    for (const region_t &r: accessed) {
+      if (!m_summaries.count(r.get_id())) candidates.push_back(r);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+		     [&count](const region_t &r1, const region_t &r2) {
+		       return count.lookup(r1.get_id()) < count.lookup(r2.get_id());
+		     });
+
+    for (const region_t &r: candidates) {
+      if (accessed.size() <= m_budget) break;
+      auto cls = std::make_pair((int) r.get_type(), r.get_bitwidth());
+      auto it = m_class_summary.find(cls);
+      if (it == m_class_summary.end()) {
+	// -- r becomes the summary region of its class
+	m_class_summary[cls] = r.get_id();
+	m_summaries.insert(r.get_id());
+	continue;
+      }
+      m_rep[r.get_id()] = it->second;
+      accessed.erase(r);
+      accessed.insert(map(r));
+    }
+
+    CRAB_LOG("heap-abs",
+	     llvm::errs() << F.getName() << ": " << accessed.size()
+	                  << " regions after merging\n";);
+  }
+
+  void BudgetHeapAbstraction::mapSets(region_set_t sets[NUM_SET_KINDS]) {
+    region_set_t reads = map(sets[ACCESSED]);
+    region_set_t mods = map(sets[MODIFIED]);
+    region_set_t news = map(sets[NEW]);
+    // -- a new region merged with a read region is read and modified
+    region_set_t read_news = budget_heap_abs_impl::set_intersection(news, reads);
+    mods.insert(read_news.begin(), read_news.end());
+    budget_heap_abs_impl::set_difference(news, reads);
+    reads.insert(mods.begin(), mods.end());
+    budget_heap_abs_impl::set_difference(news, mods);
+    region_set_t onlyreads(reads);
+    budget_heap_abs_impl::set_difference(onlyreads, mods);
+    sets[ACCESSED] = reads;
+    sets[ONLY_READ] = onlyreads;
+    sets[MODIFIED] = mods;
+    sets[NEW] = news;
+  }
+
+  BudgetHeapAbstraction::BudgetHeapAbstraction(Module &M,
+					       boost::shared_ptr<HeapAbstraction> base,
+					       unsigned budget)
+    : m_base(base), m_budget(budget) {
+
+    for (Function &F: M) {
+      if (F.isDeclaration()) continue;
+      mergeRegions(F);
+    }
+
+    CRAB_VERBOSE_IF(1, llvm::errs() << "Merged " << m_rep.size()
+		                    << " regions into " << m_summaries.size()
+		                    << " summary regions (budget=" << m_budget << ")\n";);
+
+    for (Function &F: M) {
+      if (F.isDeclaration()) continue;
+      region_set_t sets[NUM_SET_KINDS];
+      sets[ACCESSED] = m_base->getAccessedRegions(F);
+      sets[MODIFIED] = m_base->getModifiedRegions(F);
+      sets[NEW] = m_base->getNewRegions(F);
+      mapSets(sets);
+      for (unsigned k = 0; k < NUM_SET_KINDS; ++k) {
+	m_func_sets[k][&F] = sets[k];
+      }
+      for (auto &I: instructions(&F)) {
+	CallInst *CI = dyn_cast<CallInst>(&I);
+	if (!CI) continue;
+	region_set_t cs_sets[NUM_SET_KINDS];
+	cs_sets[ACCESSED] = m_base->getAccessedRegions(*CI);
+	cs_sets[MODIFIED] = m_base->getModifiedRegions(*CI);
+	cs_sets[NEW] = m_base->getNewRegions(*CI);
+	mapSets(cs_sets);
+	for (unsigned k = 0; k < NUM_SET_KINDS; ++k) {
+	  m_callsite_sets[k][CI] = cs_sets[k];
+	}
+      }
+    }
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::lookup(const Function &F, set_kind_t k) const {
+    auto it = m_func_sets[k].find(&F);
+    return (it == m_func_sets[k].end() ? m_empty_set : it->second);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::lookup(const CallInst &I, set_kind_t k) const {
+    auto it = m_callsite_sets[k].find(&I);
+    return (it == m_callsite_sets[k].end() ? m_empty_set : it->second);
+  }
+
+  BudgetHeapAbstraction::region_t
+  BudgetHeapAbstraction::getRegion(const Function &F, Value *V) {
+    return map(m_base->getRegion(F, V));
+  }
+
+  const Value* BudgetHeapAbstraction::getSingleton(int region) const {
+    if (m_summaries.count(region)) return nullptr;
+    return m_base->getSingleton(region);
+  }
+
+  const Value* BudgetHeapAbstraction::getLocalSingleton(const Function &F,
+							int region) const {
+    if (m_summaries.count(region)) return nullptr;
+    return m_base->getLocalSingleton(F, region);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getAccessedRegions(const Function &F) {
+    return lookup(F, ACCESSED);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getOnlyReadRegions(const Function &F) {
+    return lookup(F, ONLY_READ);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getModifiedRegions(const Function &F) {
+    return lookup(F, MODIFIED);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getNewRegions(const Function &F) {
+    return lookup(F, NEW);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getAccessedRegions(CallInst &I) {
+    return lookup(I, ACCESSED);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getOnlyReadRegions(CallInst &I) {
+    return lookup(I, ONLY_READ);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getModifiedRegions(CallInst &I) {
+    return lookup(I, MODIFIED);
+  }
+
+  const BudgetHeapAbstraction::region_set_t&
+  BudgetHeapAbstraction::getNewRegions(CallInst &I) {
+    return lookup(I, NEW);
+  }
+
+} // end namespace crab_llvm
@@ -0,0 +1,238 @@
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/CrabLlvmC.h"
+#include "crab_llvm/CrabLlvm.hh"
+#include "crab_llvm/Transforms/PreProcessing.hh"
+#include "crab_llvm/wrapper_domain.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+/*
+ * C interface of the crab-llvm library (see CrabLlvmC.h)
+ */
+
+using namespace llvm;
+using namespace crab_llvm;
+
+struct crabllvm_module {
+  // destroyed in reverse order: the pass manager owns the analysis
+  // and the analysis refers to the module
+  LLVMContext context;
+  std::unique_ptr<Module> module;
+  std::unique_ptr<legacy::PassManager> pass_manager;
+  CrabLlvmPass *crab;
+
+  crabllvm_module(): crab(nullptr) {}
+};
+
+namespace capi_impl {
+
+  static std::string& last_error() {
+    static thread_local std::string e;
+    return e;
+  }
+
+  static char* fail(const std::string &msg) {
+    last_error() = msg;
+    return nullptr;
+  }
+
+  static char* to_c_str(const std::string &s) {
+    char *res = static_cast<char*>(std::malloc(s.size() + 1));
+    std::memcpy(res, s.c_str(), s.size() + 1);
+    return res;
+  }
+
+  static std::string escape(const std::string &str) {
+    std::string res;
+    for (char c : str) {
+      switch (c) {
+      case '"':  res += "\\\""; break;
+      case '\\': res += "\\\\"; break;
+      case '\n': res += "\\n"; break;
+      case '\t': res += "\\t"; break;
+      default:   res += c;
+      }
+    }
+    return res;
+  }
+
+  // the names of --crab-dom
+  static bool getDomain(const std::string &name, CrabDomain &dom) {
+    static const std::map<std::string, CrabDomain> doms = {
+      {"int", INTERVALS}, {"term-int", TERMS_INTERVALS},
+      {"ric", INTERVALS_CONGRUENCES}, {"dis-int", DIS_INTERVALS},
+      {"term-dis-int", TERMS_DIS_INTERVALS}, {"boxes", BOXES},
+      {"zones", ZONES_SPLIT_DBM}, {"oct", OCT}, {"pk", PK},
+      {"rtz", TERMS_ZONES}, {"w-int", WRAPPED_INTERVALS},
+      {"dense-int", DENSE_INTERVALS}, {"zones-fast", ZONES_SPLIT_DBM_FAST},
+      {"w-int-fast", WRAPPED_INTERVALS_FAST}, {"ptr-offsets", PTR_OFFSETS},
+      {"zones-dense", ZONES_DENSE_DBM}};
+    auto it = doms.find(name);
+    if (it == doms.end()) return false;
+    dom = it->second;
+    return true;
+  }
+
+  static Function* getFunction(crabllvm_module_ref m, const char *name) {
+    Function *F = (name ? m->module->getFunction(name) : nullptr);
+    if (!F || F->isDeclaration()) {
+      fail(std::string("unknown function ") + (name ? name : ""));
+      return nullptr;
+    }
+    return F;
+  }
+
+  static std::string checks(unsigned safe, unsigned err, unsigned warn) {
+    std::ostringstream o;
+    o << "{\"safe\":" << safe << ",\"error\":" << err << ",\"warning\":" << warn << "}";
+    return o.str();
+  }
+
+  static void initialize() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+	PassRegistry &Registry = *PassRegistry::getPassRegistry();
+	initializeAnalysis(Registry);
+	initializeCallGraphWrapperPassPass(Registry);
+	initializeGlobalsAAWrapperPassPass(Registry);
+      });
+  }
+} // end namespace capi_impl
+
+using namespace capi_impl;
+
+extern "C" {
+
+int crabllvm_init(int argc, const char **argv) {
+  static std::once_flag once;
+  bool ok = true;
+  std::call_once(once, [&]() {
+      ok = cl::ParseCommandLineOptions(argc, argv, "crab-llvm library\n", true);
+    });
+  if (!ok) last_error() = "invalid options";
+  return ok;
+}
+
+crabllvm_module_ref crabllvm_load(const char *filename) {
+  initialize();
+  std::unique_ptr<crabllvm_module> m(new crabllvm_module());
+  SMDiagnostic err;
+  m->module = parseIRFile(filename, err, m->context);
+  if (!m->module) {
+    fail("bitcode was not properly read; " + err.getMessage().str());
+    return nullptr;
+  }
+
+  m->pass_manager.reset(new legacy::PassManager());
+  if (getNormalizations(*m->module) != NORM_ALL) {
+    // -- the default pipeline of crabllvm-pp
+    PreProcessingOptions opts;
+    opts.export_list.push_back("main");
+    addPreProcessingPasses(*m->pass_manager, opts);
+  }
+  m->crab = new CrabLlvmPass();
+  // -- the results are queried after the pass manager is done
+  m->crab->set_keep_results(true);
+  m->pass_manager->add(m->crab);
+  m->pass_manager->run(*m->module);
+  return m.release();
+}
+
+void crabllvm_dispose(crabllvm_module_ref m) {
+  delete m;
+}
+
+char *crabllvm_functions(crabllvm_module_ref m) {
+  std::ostringstream o;
+  o << "[";
+  bool first = true;
+  for (auto &F : *m->module) {
+    if (F.isDeclaration()) continue;
+    o << (first ? "" : ",") << "{\"name\":\"" << escape(F.getName()) << "\",\"blocks\":[";
+    first = false;
+    bool first_block = true;
+    for (auto &B : F) {
+      o << (first_block ? "" : ",") << "\"" << escape(B.getName()) << "\"";
+      first_block = false;
+    }
+    o << "]}";
+  }
+  o << "]";
+  return to_c_str(o.str());
+}
+
+char *crabllvm_invariant(crabllvm_module_ref m, const char *function,
+                         const char *block, int post) {
+  Function *F = getFunction(m, function);
+  if (!F) return nullptr;
+  const BasicBlock *B = nullptr;
+  for (auto &BB : *F) {
+    if (block && BB.getName() == block) {
+      B = &BB;
+      break;
+    }
+  }
+  if (!B) return fail(std::string("unknown block ") + (block ? block : ""));
+  auto dom = (post ? m->crab->get_post(B) : m->crab->get_pre(B));
+  if (!dom) return fail(std::string("no invariants for ") + block);
+
+  lin_cst_sys_t csts = dom->to_linear_constraints();
+  bool bottom = false;
+  std::ostringstream o;
+  o << "[";
+  bool first = true;
+  for (auto &cst : csts) {
+    if (cst.is_contradiction()) bottom = true;
+    crab::crab_string_os s;
+    s << cst;
+    o << (first ? "" : ",") << "\"" << escape(s.str()) << "\"";
+    first = false;
+  }
+  o << "]";
+  return to_c_str(std::string("{\"bottom\":") + (bottom ? "true" : "false") +
+		  ",\"constraints\":" + o.str() + "}");
+}
+
+char *crabllvm_checks(crabllvm_module_ref m) {
+  return to_c_str(checks(m->crab->get_total_safe_checks(),
+			 m->crab->get_total_error_checks(),
+			 m->crab->get_total_warning_checks()));
+}
+
+char *crabllvm_analyze(crabllvm_module_ref m, const char *function,
+                       const char *domain) {
+  Function *F = getFunction(m, function);
+  if (!F) return nullptr;
+  AnalysisParams params(m->crab->get_analysis_params());
+  if (domain && !getDomain(domain, params.dom)) {
+    return fail(std::string("unknown domain ") + domain);
+  }
+  auto db = m->crab->analyze_function(*F, params);
+  return to_c_str(checks(db.get_total_safe(), db.get_total_error(),
+			 db.get_total_warning()));
+}
+
+const char *crabllvm_last_error(void) {
+  return last_error().c_str();
+}
+
+void crabllvm_free(char *s) {
+  std::free(s);
+}
+
+} // end extern "C"
@@ -31,35 +31,57 @@
  * 
  * - Ignore floating point instructions.
  * - Ignore inttoptr/ptrtoint instructions.
- * - Almost ignore memset/memmove/memcpy
+ * - memset is only translated precisely if the stored byte is zero.
  */
 
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/DebugLoc.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/Analysis/LoopInfo.h"
 
 #include "boost/unordered_map.hpp"
+#include "boost/unordered_set.hpp"
 #include "boost/range/iterator_range.hpp"
 #include "boost/range/algorithm/set_algorithm.hpp"
 #include "boost/optional.hpp"
 
 #include "crab/common/debug.hpp"
-#include "crab/common/stats.hpp"
 #include "crab/transforms/dce.hpp"
 #include "crab_llvm/CfgBuilder.hh"
 #include "crab_llvm/HeapAbstraction.hh"
 #include "crab_llvm/Support/CFG.hh"
+#include "crab_llvm/Support/NameValues.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab_llvm/Support/Numbers.hh"
+#include "crab_llvm/Support/Parallel.hh"
+#include "crab_llvm/Support/Stats.hh"
 
 #include <algorithm>
+#include <chrono>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace llvm;
 using namespace boost;
@@ -73,6 +95,16 @@ CrabCFGSimplify("crab-cfg-simplify",
 	 cl::init(false),
 	 cl::Hidden);
 
+/**
+ * Remove statements that define variables which are never used
+ * (e.g., havoc's and assignments of PHI nodes that are not read)
+ * without merging blocks. It is implied by --crab-cfg-simplify.
+ */
+cl::opt<bool>
+CrabCFGDce("crab-cfg-dce",
+	 cl::desc("Remove dead statements from the Crab CFG"), 
+	 cl::init(false));
+
 cl::opt<bool>
 CrabPrintCFG("crab-print-cfg",
 	 cl::desc("Print Crab CFG"), 
@@ -80,7 +112,7 @@ CrabPrintCFG("crab-print-cfg",
 
 cl::opt<bool>
 CrabEnableUniqueScalars("crab-singleton-aliases",
-	 cl::desc("Treat singleton alias sets as scalar values"), 
+	 cl::desc("Treat singleton alias sets (globals and non-escaping stack objects) as scalar values"), 
 	 cl::init(false));
 
 /** 
@@ -133,21 +165,31 @@ CrabDisableWarnings("crab-disable-warnings",
 	      cl::init(false),
 	      cl::Hidden);
 
+cl::opt<bool>
+CrabDeadRegions("crab-dead-regions",
+	cl::desc("Forget array variables of regions that are not read anymore (only with --crab-track=arr)"),
+	cl::init(false));
+
+/**
+ * Translate the blocks of large functions with several threads. The
+ * blocks are translated in parallel (each thread with its own cache
+ * of literals) and then the edges, the PHI nodes and the branch
+ * conditions are added sequentially. Fresh variables created by the
+ * translation may be numbered in a different order than in a
+ * sequential run.
+ */
+cl::opt<unsigned>
+CrabCfgThreads("crab-cfg-threads",
+	cl::desc("Number of threads to translate the blocks of a large function"),
+	cl::init(1), cl::value_desc("N"));
+
+cl::opt<unsigned>
+CrabCfgParallelBlocks("crab-cfg-parallel-blocks",
+	cl::desc("Minimum number of blocks of a function to use --crab-cfg-threads"),
+	cl::init(2000), cl::value_desc("N"));
+
 namespace crab_llvm {
 
-  static crab::crab_os& get_crab_os(bool show_time = true) {
-    crab::crab_os* result = &crab::outs();
-    if (show_time) {
-      time_t now = time(0);
-      struct tm tstruct;
-      char buf[80];
-      tstruct = *localtime(&now);
-      strftime(buf, sizeof(buf), "[%Y-%m-%d.%X] ", &tstruct);
-      *result << buf;
-    }
-    return *result;
-  }
-  
   static void CRABLLVM_ERROR(std::string msg, const char *file, unsigned line) {
     llvm::errs() << "CRABLLVM ERROR: " << msg << "\n";
     llvm::errs() << "File: " << file << "\n";
@@ -162,6 +204,9 @@ namespace crab_llvm {
   
   typedef typename HeapAbstraction::region_t mem_region_t;
   typedef typename HeapAbstraction::region_set_t mem_region_set_t;  
+
+  // CFGs can be built by several threads but crab::outs() is shared.
+  static std::mutex crab_shared_mutex;
   
   static bool isBool(const llvm::Type *t){
     return (t->isIntegerTy(1));
@@ -184,25 +229,12 @@ namespace crab_llvm {
     return (v.getType()->isPointerTy() && tracklev >= PTR && !CrabDisablePointers);
   }
 
-  /** Converts v to mpz_class. Assumes that v is signed */
-  static mpz_class toMpz(const llvm::APInt &v) {
-    // Based on:
-    // https://llvm.org/svn/llvm-project/polly/trunk/lib/Support/GICHelper.cpp
-    llvm::APInt abs;
-    abs = v.isNegative() ? v.abs() : v;
-    const uint64_t *rawdata = abs.getRawData();
-    unsigned numWords = abs.getNumWords();
-    mpz_class res;
-    mpz_import(res.get_mpz_t(), numWords, 1,  sizeof(uint64_t), 0, 0, rawdata);
-    return v.isNegative() ? mpz_class(-res) : res;
-  }
-
   // The return value should be ikos::z_number and not number_t
   static ikos::z_number getIntConstant(const ConstantInt* CI){
     if (CI->getType()->isIntegerTy(1)) {
       return ikos::z_number((int64_t) CI->getZExtValue());
     } else {
-      return ikos::z_number(toMpz(CI->getValue()));
+      return toZNumber(CI->getValue());
     }
   }
     
@@ -429,12 +461,17 @@ namespace crab_llvm {
         
   private:
 
-    typedef boost::unordered_map<const Value*, crab_lit_ref_t> lit_cache_t;
+    typedef llvm::DenseMap<const Value*, crab_lit_ref_t> lit_cache_t;
     typedef typename lit_cache_t::value_type binding_t;
     
     llvm_variable_factory &m_vfac;
     crab::cfg::tracked_precision m_tracklev;
     lit_cache_t m_lit_cache;
+    // Literals are allocated in these arenas and released (together
+    // with their numbers) when the factory is destroyed.
+    llvm::SpecificBumpPtrAllocator<crabBoolLit> m_bool_lits;
+    llvm::SpecificBumpPtrAllocator<crabIntLit> m_int_lits;
+    llvm::SpecificBumpPtrAllocator<crabPtrLit> m_ptr_lits;
 
     boost::optional<crabBoolLit> getBoolLit(const llvm::Value &v);
     boost::optional<crabIntLit> getIntLit(const llvm::Value &v);
@@ -456,22 +493,19 @@ namespace crab_llvm {
     // and not the track level.
     if (isBool(&t)) {
       if (boost::optional<crabBoolLit> lit = getBoolLit(v)) {
-	crab_lit_ref_t ref =
-	  boost::static_pointer_cast<crabLit>(boost::make_shared<crabBoolLit>(*lit));
+	crab_lit_ref_t ref = new (m_bool_lits.Allocate()) crabBoolLit(*lit);
 	m_lit_cache.insert(binding_t(&v, ref));
 	return ref;	  
       }
     } else if (isInteger(&t)) {
       if (boost::optional<crabIntLit> lit = getIntLit(v)) {
-	crab_lit_ref_t ref =
-	  boost::static_pointer_cast<crabLit>(boost::make_shared<crabIntLit>(*lit));
+	crab_lit_ref_t ref = new (m_int_lits.Allocate()) crabIntLit(*lit);
 	m_lit_cache.insert(binding_t(&v, ref));
 	return ref;
       }
     } else if (t.isPointerTy()) {
       if (boost::optional<crabPtrLit> lit = getPtrLit(v)) {
-	crab_lit_ref_t ref =
-	  boost::static_pointer_cast<crabLit>(boost::make_shared<crabPtrLit>(*lit));
+	crab_lit_ref_t ref = new (m_ptr_lits.Allocate()) crabPtrLit(*lit);
 	m_lit_cache.insert(binding_t(&v, ref));
 	return ref;
       }
@@ -505,16 +539,17 @@ namespace crab_llvm {
     if (const Value* v= mem_region.getSingleton()) {
       Type* ty = cast<PointerType>(v->getType())->getElementType();      
       bitwidth = ty->getIntegerBitWidth();
-      if (mem_region.get_type() == INT_REGION && bitwidth <= 1) {
-	CRABLLVM_ERROR("Integer region must have bitwidth > 1",
-		       __FILE__,__LINE__);
-      }
       // If the singleton contains a pointer then getIntegerBitWidth()
       // returns zero which means for us "unknown" bitwidth so we are
       // good.
     } else {
-      CRABLLVM_ERROR("Memory region does not belong to a global singleton",
-		     __FILE__, __LINE__);
+      // a local singleton: the region has the bitwidth of the stack
+      // object since it is only accessed with the allocated type.
+      bitwidth = mem_region.get_bitwidth();
+    }
+    if (mem_region.get_type() == INT_REGION && bitwidth <= 1) {
+      CRABLLVM_ERROR("Integer region must have bitwidth > 1",
+		     __FILE__,__LINE__);
     }
     switch  (mem_region.get_type()) {
     case INT_REGION : type = INT_TYPE; break;
@@ -546,35 +581,35 @@ namespace crab_llvm {
   bool crabLitFactoryImpl::isBoolTrue(const crab_lit_ref_t ref) const {
     if (!ref || !ref->isBool())
       CRABLLVM_ERROR("Literal is not a Boolean", __FILE__, __LINE__);
-    auto lit = boost::static_pointer_cast<const crabBoolLit>(ref);
+    auto lit = static_cast<const crabBoolLit*>(ref);
     return lit->isTrue();
   }
     
   bool crabLitFactoryImpl::isBoolFalse(const crab_lit_ref_t ref) const {
     if (!ref || !ref->isBool())
       CRABLLVM_ERROR("Literal is not a Boolean", __FILE__, __LINE__);    
-    auto lit = boost::static_pointer_cast<const crabBoolLit>(ref);
+    auto lit = static_cast<const crabBoolLit*>(ref);
     return lit->isFalse();
   }
   
   bool crabLitFactoryImpl::isPtrNull(const crab_lit_ref_t ref) const {
     if (!ref || !ref->isPtr())
       CRABLLVM_ERROR("Literal is not a pointer", __FILE__, __LINE__);        
-    auto lit = boost::static_pointer_cast<const crabPtrLit>(ref);
+    auto lit = static_cast<const crabPtrLit*>(ref);
     return lit->isNull();
   }
   
   lin_exp_t crabLitFactoryImpl::getExp(const crab_lit_ref_t ref) const {
     if (!ref || !ref->isInt())
       CRABLLVM_ERROR("Literal is not an integer", __FILE__, __LINE__);            
-    auto lit = boost::static_pointer_cast<const crabIntLit>(ref);
+    auto lit = static_cast<const crabIntLit*>(ref);
     return lit->getExp();
   }
 
   number_t crabLitFactoryImpl::getIntCst(const crab_lit_ref_t ref) const {
     if (!ref || !ref->isInt())
       CRABLLVM_ERROR("Literal is not an integer", __FILE__, __LINE__);                
-    auto lit = boost::static_pointer_cast<const crabIntLit>(ref);
+    auto lit = static_cast<const crabIntLit*>(ref);
     return lit->getInt();
   }
   
@@ -618,6 +653,28 @@ namespace crab_llvm {
     return boost::optional<crabIntLit>();
   }
 
+  void llvm_variable_factory::add_names(const Function &f) {
+    auto add = [this](const Value &v) {
+      Type *t = v.getType();
+      if (t->isIntegerTy() || t->isPointerTy()) {
+	(*this)[&v];
+      }
+    };
+    
+    for (auto &arg: f.args()) {
+      add(arg);
+    }
+    for (auto &B: f) {
+      for (auto &I: B) {
+	// globals are named the first time they are used
+	for (auto &op: I.operands()) {
+	  if (isa<GlobalVariable>(op)) add(*op);
+	}
+	add(I);
+      }
+    }
+  }
+  
   crabLitFactory::crabLitFactory(llvm_variable_factory &vfac,
 				crab::cfg::tracked_precision tracklev)
     : m_impl(new crabLitFactoryImpl(vfac, tracklev)) { }
@@ -706,8 +763,8 @@ namespace crab_llvm {
   template<typename V>
   static inline mem_region_set_t get_read_only_regions(HeapAbstraction &mem, V& v) {
     mem_region_set_t res;
-    auto regions = mem.getOnlyReadRegions(v);
-    std::copy_if(regions.begin(), regions.end(), std::inserter(res, res.begin()),
+    const mem_region_set_t &regions = mem.getOnlyReadRegions(v);
+    std::copy_if(regions.begin(), regions.end(), std::inserter(res, res.end()),
 		 [](mem_region_t r){
 		   return r.get_type() == INT_REGION || r.get_type() == BOOL_REGION;
 		 });
@@ -717,8 +774,8 @@ namespace crab_llvm {
   template<typename V>
   static inline mem_region_set_t get_modified_regions(HeapAbstraction &mem, V& v) {
     mem_region_set_t res;
-    auto regions = mem.getModifiedRegions(v);
-    std::copy_if(regions.begin(), regions.end(), std::inserter(res, res.begin()),
+    const mem_region_set_t &regions = mem.getModifiedRegions(v);
+    std::copy_if(regions.begin(), regions.end(), std::inserter(res, res.end()),
 		 [](mem_region_t r){
 		   return r.get_type() == INT_REGION || r.get_type() == BOOL_REGION;
 		 });
@@ -728,8 +785,8 @@ namespace crab_llvm {
   template<typename V>
   static inline mem_region_set_t get_new_regions(HeapAbstraction &mem, V& v) {
     mem_region_set_t res;
-    auto regions = mem.getNewRegions(v);
-    std::copy_if(regions.begin(), regions.end(), std::inserter(res, res.begin()),
+    const mem_region_set_t &regions = mem.getNewRegions(v);
+    std::copy_if(regions.begin(), regions.end(), std::inserter(res, res.end()),
 		 [](mem_region_t r){
 		   return r.get_type() == INT_REGION || r.get_type() == BOOL_REGION;
 		 });
@@ -743,16 +800,28 @@ namespace crab_llvm {
     return dloc;
   }
 
+  // File names of the debug locations of the module. Each name is
+  // converted to std::string once rather than once per assertion and
+  // copies of an interned name share its buffer if std::string is
+  // reference-counted. CFGs can be built by several threads.
+  static const std::string& internFileName(StringRef name) {
+    static StringMap<std::string> table;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = table.find(name);
+    if (it == table.end()) {
+      it = table.insert(std::make_pair(name, name.empty() ? "unknown file" : name.str())).first;
+    }
+    return it->second;
+  }
+
   static crab::cfg::debug_info getDebugLoc(const Instruction *inst) {
     if (!hasDebugLoc(inst))
       return crab::cfg::debug_info();
     const DebugLoc &dloc = inst->getDebugLoc();
     unsigned Line = dloc.getLine();
     unsigned Col = dloc.getCol();
-    std::string File = (*dloc).getFilename();
-    if (File == "")
-      File = "unknown file";
-    return crab::cfg::debug_info(File, Line, Col);
+    return crab::cfg::debug_info(internFileName((*dloc).getFilename()), Line, Col);
   }
 
   static uint64_t storageSize(const Type *t, const DataLayout &dl) {
@@ -829,12 +898,6 @@ namespace crab_llvm {
 	    F->getName().equals("__CRAB_assume_not"));
   }
 
-  static bool isVerifierCall(const Function *F) {
-    return (isAssertFn(F) || isErrorFn(F) ||
-	    isAssumeFn(F) || isNotAssumeFn(F) ||
-	    isSeaHornFail(F));
-  }
-
   static bool isZeroInitializer(const Function *F) {
     return F->getName().startswith("verifier.zero_initializer");
   }
@@ -842,6 +905,44 @@ namespace crab_llvm {
   static bool isIntInitializer(const Function *F) {
     return F->getName().startswith("verifier.int_initializer");
   }
+
+  // Functions whose calls are translated in a special way
+  enum special_fn_kind_t {
+    NOT_SPECIAL_FN,
+    ASSERT_FN, ASSUME_FN, NOT_ASSUME_FN, ERROR_FN, SEAHORN_FAIL_FN,
+    ZERO_INITIALIZER_FN, INT_INITIALIZER_FN,
+    SHADOW_MEM_FN, FN_ENTER_FN, DBG_FN
+  };
+
+  static special_fn_kind_t classifySpecialFn(const Function *F) {
+    if (isAssertFn(F))        return ASSERT_FN;
+    if (isAssumeFn(F))        return ASSUME_FN;
+    if (isNotAssumeFn(F))     return NOT_ASSUME_FN;
+    if (isErrorFn(F))         return ERROR_FN;
+    if (isSeaHornFail(F))     return SEAHORN_FAIL_FN;
+    if (isZeroInitializer(F)) return ZERO_INITIALIZER_FN;
+    if (isIntInitializer(F))  return INT_INITIALIZER_FN;
+    if (F->getName().startswith("shadow.mem"))   return SHADOW_MEM_FN;
+    if (F->getName().equals("seahorn.fn.enter")) return FN_ENTER_FN;
+    if (F->getName().startswith("llvm.dbg"))     return DBG_FN;
+    return NOT_SPECIAL_FN;
+  }
+
+  // Kind of each callee of a function. The names of a callee are
+  // only compared the first time it is seen, not at each callsite.
+  class special_fn_map {
+    DenseMap<const Function*, special_fn_kind_t> m_kinds;
+  public:
+    special_fn_kind_t operator[](const Function *F) {
+      auto it = m_kinds.find(F);
+      if (it != m_kinds.end()) {
+	return it->second;
+      }
+      special_fn_kind_t k = classifySpecialFn(F);
+      m_kinds.insert(std::make_pair(F, k));
+      return k;
+    }
+  };
   
   // Return true if all uses are BranchInst's
   static bool AllUsesAreBrInst(Value* V) {
@@ -922,6 +1023,22 @@ namespace crab_llvm {
     return nullptr;
   }
 
+  // helper to handle option CrabEnableUniqueScalars for the regions
+  // accessed by the instructions of F. Unlike isGlobalSingleton, it
+  // also returns the stack objects of F which do not escape.
+  template<typename HeapAbstraction>
+  static const Value* isSingleton(Region<HeapAbstraction> r, const Function& F) {
+    if (CrabEnableUniqueScalars) {
+      if (r.isUnknown()) return nullptr;
+      if (r.get_type() == INT_REGION || r.get_type() == BOOL_REGION) {
+	if (const Value* v = r.getSingleton(F)) {
+	  return v;
+	}
+      }
+    }
+    return nullptr;
+  }
+
   // helper to handle option CrabIncludeHavoc
   static void havoc(var_t v, basic_block_t &bb) {
     if (CrabIncludeHavoc) {
@@ -1156,99 +1273,134 @@ namespace crab_llvm {
                     const BasicBlock& inc_BB): 
       m_lfac(lfac), m_mem(mem), m_bb(bb), m_inc_BB(inc_BB) {}
     
+    typedef DenseMap<const Value*, var_t> old_val_map_t;
+    
+    // -- save the old version of the variable that maps to the phi
+    //    node v
+    void save_old_value(const PHINode &v, old_val_map_t &old_val_map) {
+      if (crab_lit_ref_t phi_val_ref = m_lfac.getLit(v)) {
+	if (phi_val_ref->isBool()) {
+	  var_t lhs = m_lfac.mkBoolVar();
+	  if (phi_val_ref->isVar()) {
+	    m_bb.bool_assign(lhs, phi_val_ref->getVar());
+	  } else {
+	    m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_ref) ?
+			     lin_cst_t::get_true() : lin_cst_t::get_false());		
+	  }		
+	  old_val_map.insert(std::make_pair(&v, lhs));
+	} else if (phi_val_ref->isInt()) {
+	  var_t lhs = m_lfac.mkIntVar(v.getType()->getIntegerBitWidth());
+	  m_bb.assign(lhs, m_lfac.getExp(phi_val_ref));
+	  old_val_map.insert(std::make_pair(&v, lhs));		
+	} else if (phi_val_ref->isPtr()) {
+	  var_t lhs = m_lfac.mkPtrVar();
+	  if (phi_val_ref->isVar()) {
+	    m_bb.ptr_assign(lhs, phi_val_ref->getVar(), number_t(0));		  	
+	  } else {
+	    m_bb.ptr_null(lhs);
+	  }
+	  old_val_map.insert(std::make_pair(&v, lhs));		
+	}
+      } else {
+	CRABLLVM_ERROR("unexpected PHI node", __FILE__, __LINE__);
+      }
+    }
+
+    // -- phi := v
+    void assign(const PHINode &phi, const Value &v, const old_val_map_t &old_val_map) {
+      crab_lit_ref_t lhs_ref = m_lfac.getLit(phi);
+      if (!lhs_ref || !lhs_ref->isVar()) {
+	CRABLLVM_ERROR("unexpected PHI instruction", __FILE__, __LINE__);
+      } 
+      var_t lhs = lhs_ref->getVar();
+      auto it = old_val_map.find(&v);
+      if (it != old_val_map.end()) {
+	// -- use old version if exists
+	if (isBool(phi)) {
+	  m_bb.bool_assign(lhs, it->second);
+	} else if (phi.getType()->isIntegerTy()) {
+	  m_bb.assign(lhs, it->second);
+	} else if (isPointer(phi, m_lfac.get_track())){
+	  m_bb.ptr_assign(lhs, it->second, number_t(0));
+	}
+      } else {
+	if (crab_lit_ref_t phi_val_ref = m_lfac.getLit(v)) {
+	  if (phi_val_ref->isBool()) {
+	    if (phi_val_ref->isVar()) {
+	      m_bb.bool_assign(lhs, phi_val_ref->getVar());
+	    } else {
+	      m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_ref) ?
+			       lin_cst_t::get_true() : lin_cst_t::get_false());		
+	    }
+	  } else if (phi_val_ref->isInt()) {
+	    m_bb.assign(lhs, m_lfac.getExp(phi_val_ref));
+	  } else if (phi_val_ref->isPtr()) {
+	    if (phi_val_ref->isVar()) {
+	      m_bb.ptr_assign(lhs, phi_val_ref->getVar(), number_t(0));		  	
+	    } else {
+	      m_bb.ptr_null(lhs);
+	    }
+	  } else { /* unreachable*/ }
+	} else {
+	  CRABLLVM_ERROR("unexpected PHI node", __FILE__, __LINE__);
+	}
+      }
+    }
+    
     void visitBasicBlock(BasicBlock &BB) {
       auto curr = BB.begin();
       if (!isa<PHINode>(curr)) return;
 
-      DenseMap<const Value*, var_t> old_val_map;
-
       // --- All the phi-nodes must be evaluated atomically. This
       //     means that if one phi node v1 has as incoming value
       //     another phi node v2 in the same block then it should take
       //     the v2's old value (i.e., before v2's evaluation).
-
+      //
+      //     Instead of saving the old value of all such v2's, the
+      //     assignments are ordered so that v1 := v2 goes before the
+      //     assignment of v2. The old value is only saved if the phi
+      //     nodes read each other in a cycle.
+
+      std::vector<std::pair<const PHINode*, const Value*>> pending;
+      // number of pending assignments that read each phi node of BB
+      DenseMap<const Value*, unsigned> num_readers;
       for (; PHINode *phi = dyn_cast<PHINode>(curr); ++curr) {        
-        const Value &v = *phi->getIncomingValueForBlock(&m_inc_BB);
-        if (!isTracked(v, m_lfac.get_track())) continue;
-        const PHINode* phi_v = dyn_cast<PHINode>(&v);
-        if (phi_v && (phi_v->getParent() == &BB)) {
-	  // -- save the old version of the variable that maps to the
-	  //    phi node v
-	  auto it = old_val_map.find(&v);
-	  if (it == old_val_map.end()) {
-	    if (crab_lit_ref_t phi_val_ref = m_lfac.getLit(v)) {
-	      if (phi_val_ref->isBool()) {
-		var_t lhs = m_lfac.mkBoolVar();
-		if (phi_val_ref->isVar()) {
-		  m_bb.bool_assign(lhs, phi_val_ref->getVar());
-		} else {
-		  m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_ref) ?
-				   lin_cst_t::get_true() : lin_cst_t::get_false());		
-		}		
-	    	old_val_map.insert(std::make_pair(&v, lhs));
-	      } else if (phi_val_ref->isInt()) {
-		var_t lhs = m_lfac.mkIntVar(phi_v->getType()->getIntegerBitWidth());
-		m_bb.assign(lhs, m_lfac.getExp(phi_val_ref));
-	    	old_val_map.insert(std::make_pair(&v, lhs));		
-	      } else if (phi_val_ref->isPtr()) {
-		var_t lhs = m_lfac.mkPtrVar();
-		if (phi_val_ref->isVar()) {
-		  m_bb.ptr_assign(lhs, phi_val_ref->getVar(), number_t(0));		  	
-		} else {
-		  m_bb.ptr_null(lhs);
-		}
-	    	old_val_map.insert(std::make_pair(&v, lhs));		
-	      }
-	    } else {
-	      CRABLLVM_ERROR("unexpected PHI node", __FILE__, __LINE__);
-	    }
-	  }
+        if (!isTracked(*phi, m_lfac.get_track())) continue;
+        const Value *v = phi->getIncomingValueForBlock(&m_inc_BB);
+	// -- phi := phi is a no-op
+	if (v == phi) continue;
+	pending.push_back(std::make_pair(phi, v));
+        const PHINode* phi_v = dyn_cast<PHINode>(v);
+        if (phi_v && (phi_v->getParent() == &BB) && isTracked(*v, m_lfac.get_track())) {
+	  num_readers[v]++;
 	}
       }
-      
-      curr = BB.begin();
-      for (; isa<PHINode>(curr); ++curr) {
-        PHINode &phi = *cast<PHINode>(curr);
-        if (!isTracked(phi, m_lfac.get_track())) continue;	
-        const Value &v = *phi.getIncomingValueForBlock(&m_inc_BB);
-
-	crab_lit_ref_t lhs_ref = m_lfac.getLit(phi);
-	if (!lhs_ref || !lhs_ref->isVar()) {
-	  CRABLLVM_ERROR("unexpected PHI instruction", __FILE__, __LINE__);
-	} 
-	var_t lhs = lhs_ref->getVar();
-        auto it = old_val_map.find(&v);
-        if (it != old_val_map.end()) {
-	  // -- use old version if exists
-	  if (isBool(phi)) {
-	    m_bb.bool_assign(lhs, it->second);
-	  } else if (phi.getType()->isIntegerTy()) {
-	    m_bb.assign(lhs, it->second);
-	  } else if (isPointer(phi, m_lfac.get_track())){
-	    m_bb.ptr_assign(lhs, it->second, number_t(0));
+
+      old_val_map_t old_val_map;
+      while (!pending.empty()) {
+	// -- emit all the assignments whose lhs is not read anymore
+	bool progress = false;
+	std::vector<std::pair<const PHINode*, const Value*>> next;
+	for (auto &kv: pending) {
+	  if (num_readers.lookup(kv.first) > 0) {
+	    next.push_back(kv);
+	    continue;
 	  }
-        } else {
-	  if (crab_lit_ref_t phi_val_ref = m_lfac.getLit(v)) {
-	    if (phi_val_ref->isBool()) {
-	      if (phi_val_ref->isVar()) {
-		m_bb.bool_assign(lhs, phi_val_ref->getVar());
-	      } else {
-		m_bb.bool_assign(lhs, m_lfac.isBoolTrue(phi_val_ref) ?
-				 lin_cst_t::get_true() : lin_cst_t::get_false());		
-	      }
-	    } else if (phi_val_ref->isInt()) {
-	      m_bb.assign(lhs, m_lfac.getExp(phi_val_ref));
-	    } else if (phi_val_ref->isPtr()) {
-	      if (phi_val_ref->isVar()) {
-		m_bb.ptr_assign(lhs, phi_val_ref->getVar(), number_t(0));		  	
-	      } else {
-		m_bb.ptr_null(lhs);
-	      }
-	    } else { /* unreachable*/ }
-	  } else {
-	    CRABLLVM_ERROR("unexpected PHI node", __FILE__, __LINE__);
+	  assign(*kv.first, *kv.second, old_val_map);
+	  auto it = num_readers.find(kv.second);
+	  if (it != num_readers.end() && it->second > 0 && !old_val_map.count(kv.second)) {
+	    it->second--;
 	  }
+	  progress = true;
 	}
+	if (!progress) {
+	  // -- all pending phi nodes are read by others: break the
+	  //    cycle by saving the old value of one of them
+	  const PHINode *v = next.front().first;
+	  save_old_value(*v, old_val_map);
+	  num_readers[v] = 0;
+	}
+	std::swap(pending, next);
       }
     }
   };
@@ -1265,6 +1417,8 @@ namespace crab_llvm {
     unsigned int m_object_id;
     bool m_has_seahorn_fail;
     mem_region_set_t& m_init_regions;
+    special_fn_map& m_special_fns;
+    const DenseSet<const Function*> *m_pruned;
 
     
     unsigned fieldOffset(const StructType *t, unsigned field) {
@@ -1279,7 +1433,7 @@ namespace crab_llvm {
     // Return true if all uses of V are non-trackable memory accesses.
     // Useful to avoid translating bitcode that won't have any effect
     // anyway.
-    bool AllUsesAreNonTrackMem(Value* V) const {
+    bool AllUsesAreNonTrackMem(Value* V) {
       // XXX: not sure if we should strip pointers here
       V = V->stripPointerCasts();
       for (auto &U: V->uses()) {
@@ -1306,8 +1460,8 @@ namespace crab_llvm {
         else if (CallInst *CI = dyn_cast<CallInst>(U.getUser())) { 
           CallSite CS(CI);
           Function* callee = CS.getCalledFunction();
-          if (callee && (callee->getName().startswith("llvm.dbg") || 
-                         callee->getName().startswith("shadow.mem")))
+          if (callee && (m_special_fns[callee] == DBG_FN ||
+                         m_special_fns[callee] == SHADOW_MEM_FN))
             continue;
           else // conservatively return false
             return false; 
@@ -1590,13 +1744,24 @@ namespace crab_llvm {
       }
     }
 
+    // The address of the object allocated by I: the id of its region
+    // in the heap abstraction if known so that the pointer domains
+    // (e.g., --crab-dom=ptr-offsets) can relate pointers with
+    // regions. Otherwise, a fresh id greater than any region id.
+    ikos::index_t getObjectAddress(Instruction &I) {
+      Function &parent = *(I.getParent()->getParent());
+      mem_region_t r = m_mem.getRegion(parent, &I);
+      if (!r.isUnknown()) return r.get_id();
+      return (ikos::index_t) INT_MAX + 1 + m_object_id++;
+    }
+
     void doAllocFn(Instruction &I) {
 
       if (!I.getType()->isVoidTy()) {
 	crab_lit_ref_t ref = m_lfac.getLit(I);
 	assert(ref->isVar());
 	if (isPointer(I, m_lfac.get_track())) {
-	  m_bb.ptr_new_object(ref->getVar(), m_object_id++);
+	  m_bb.ptr_new_object(ref->getVar(), getObjectAddress(I));
 	} else if (isTracked(I, m_lfac.get_track())) {
 	  // -- havoc return value	  
 	  havoc(ref->getVar(), m_bb);
@@ -1628,15 +1793,26 @@ namespace crab_llvm {
       }
 
       Function& parent = *(I.getParent()->getParent());      
-      if (MemCpyInst *MCI = dyn_cast<MemCpyInst>(&I)) {
-	Value* src = MCI->getSource();
-	Value* dst = MCI->getDest();
+      if (MemTransferInst *MTI = dyn_cast<MemTransferInst>(&I)) {
+	// memcpy and memmove are translated in the same way: the
+	// whole source array is assigned to the destination array
+	// which is sound even if the two blocks overlap.
+	Value* src = MTI->getSource();
+	Value* dst = MTI->getDest();
 	mem_region_t src_reg = get_region(m_mem, parent, src);
 	mem_region_t dst_reg = get_region(m_mem, parent, dst); 
 	if (dst_reg.isUnknown() || src_reg.isUnknown()) return;
-	m_bb.havoc(m_lfac.mkArrayVar(dst_reg));
-	if (dst_reg.get_type() == src_reg.get_type()) {
+	if (isSingleton(dst_reg, parent) || isSingleton(src_reg, parent)) {
+	  CRABLLVM_WARNING("Skipped memory transfer between singleton regions " << I);
+	  return;
+	}
+	// copying a smashed region into itself does not change it
+	if (dst_reg == src_reg) return;
+	if (dst_reg.get_type() == src_reg.get_type() &&
+	    dst_reg.get_bitwidth() == src_reg.get_bitwidth()) {
 	  m_bb.array_assign(m_lfac.mkArrayVar(dst_reg), m_lfac.mkArrayVar(src_reg));
+	} else {
+	  m_bb.havoc(m_lfac.mkArrayVar(dst_reg));
 	}
       } else if (MemSetInst *MSI = dyn_cast<MemSetInst>(&I)) {
 	if (CrabUnsoundArrayInit && isInteger(*(MSI->getValue()))) {
@@ -1676,19 +1852,38 @@ namespace crab_llvm {
 	      m_bb.havoc(arr_var);	      
 	    }
 	  }
+	} else if (isInteger(*(MSI->getValue()))) {
+	  doSoundMemSet(*MSI, parent);
 	} else {
-	  if (!isInteger(*(MSI->getValue()))) {
-	    CRABLLVM_WARNING("Skipped memset instruction of non-integer type.");
-	  } else {
-	    CRABLLVM_WARNING("Skipped memset instruction of integer type." <<
-			     "You can enable --crab-unsound-array-init on your own risk.");
-	  }
+	  CRABLLVM_WARNING("Skipped memset instruction of non-integer type.");
 	}
-      } else if (isa<MemMoveInst>(&I)) {
-	CRABLLVM_WARNING("Skipped memmove instruction");
       }
     }
 
+    // Translate memset as a weak update of the destination array
+    // without assuming that the whole region is initialized. A zero
+    // byte sets each cell of the region to zero regardless of its
+    // width. Otherwise, the content of the region is lost.
+    void doSoundMemSet(MemSetInst& I, Function& parent) {
+      mem_region_t r = get_region(m_mem, parent, I.getDest());
+      if (r.isUnknown()) return;
+      if (isSingleton(r, parent)) {
+	CRABLLVM_WARNING("Skipped memset instruction on a singleton region " << I);
+	return;
+      }
+      var_t arr_var = m_lfac.mkArrayVar(r);
+      ConstantInt* val = dyn_cast<ConstantInt>(I.getValue());
+      if (!val || !val->isZero() || r.get_bitwidth() == 0) {
+	m_bb.havoc(arr_var);
+	return;
+      }
+      // fresh index: the store may write any cell of the region
+      var_t idx = m_lfac.mkIntVar(m_dl->getPointerTypeSizeInBits(I.getDest()->getType()));
+      m_bb.havoc(idx);
+      uint64_t elem_size = std::max(1U, r.get_bitwidth() / 8);
+      m_bb.array_store(arr_var, idx, number_t(0), elem_size, false);
+    }
+
     /* verifier.zero_initializer(v) or verifier.int_initializer(v,k) */    
     void doInitializer(CallInst &I) {
       CallSite CS(&I);
@@ -1764,19 +1959,15 @@ namespace crab_llvm {
       }
     }
     
-    void doVerifierCall(CallInst &I) {
+    void doVerifierCall(CallInst &I, special_fn_kind_t kind) {
       CallSite CS(&I);
 
-      const Value *calleeV = CS.getCalledValue();
-      const Function *callee = dyn_cast<Function>(calleeV->stripPointerCasts());
-      if (!callee) return;
-            
-      if (isErrorFn(callee)) {
+      if (kind == ERROR_FN) {
         m_bb.assertion(lin_cst_t::get_false(), getDebugLoc(&I));
         return;
       }
 
-      if (isSeaHornFail(callee)) {
+      if (kind == SEAHORN_FAIL_FN) {
 	// when seahorn inserts a call to "seahorn.fail" means that
 	// the program is safe iff the function cannot return.  Note
 	// that we cannot add "assert(false)" in the current
@@ -1786,7 +1977,7 @@ namespace crab_llvm {
 	return;
       }
 
-      if (!isAssertFn(callee) && !isAssumeFn(callee) && !isNotAssumeFn(callee))
+      if (kind != ASSERT_FN && kind != ASSUME_FN && kind != NOT_ASSUME_FN)
 	return; 
 
       Value *cond = CS.getArgument(0);
@@ -1797,19 +1988,19 @@ namespace crab_llvm {
         // -- cond is a constant
 	ikos::z_number cond_val = getIntConstant(CI);
 	if (cond_val > 0) {
-	  if (isAssertFn(callee) || isAssumeFn(callee)) {
+	  if (kind == ASSERT_FN || kind == ASSUME_FN) {
 	    // do nothing
 	  } else {
-	    assert(isNotAssumeFn(callee));
+	    assert(kind == NOT_ASSUME_FN);
 	    m_bb.assume(lin_cst_t::get_false()); 	      
 	  }
 	} else {
-	  if (isNotAssumeFn(callee)) {
+	  if (kind == NOT_ASSUME_FN) {
 	    // do nothing
-	  } else if (isAssumeFn(callee)) {
+	  } else if (kind == ASSUME_FN) {
 	      m_bb.assume(lin_cst_t::get_false());
 	  } else {
-	    assert(isAssertFn(callee));
+	    assert(kind == ASSERT_FN);
 	    m_bb.assertion(lin_cst_t::get_false(), getDebugLoc(&I));
 	  }
 	}
@@ -1819,12 +2010,12 @@ namespace crab_llvm {
 	var_t v = cond_ref->getVar();
 	// -- cond is variable
 	if (cond_ref->isBool()) {
-	  if (isNotAssumeFn(callee))
+	  if (kind == NOT_ASSUME_FN)
 	    m_bb.bool_not_assume(v);
-	  else if (isAssumeFn(callee))
+	  else if (kind == ASSUME_FN)
 	    m_bb.bool_assume(v);
 	  else  {
-	    assert(isAssertFn(callee));
+	    assert(kind == ASSERT_FN);
 	    m_bb.bool_assert(v, getDebugLoc(&I));
 	  }
 	} else if (cond_ref->isInt()){
@@ -1841,21 +2032,21 @@ namespace crab_llvm {
 	    cond_ref = m_lfac.getLit(*(ZEI->getOperand(0)));
 	    assert(cond_ref->isVar()); // boolean variable
 	    v = cond_ref->getVar();
-	    if (isNotAssumeFn(callee)) {	   
+	    if (kind == NOT_ASSUME_FN) {	   
 	      m_bb.bool_not_assume(v);	   
-	    } else if (isAssumeFn(callee)) {
+	    } else if (kind == ASSUME_FN) {
 	      m_bb.bool_assume(v);
 	    } else  {
-	      assert(isAssertFn(callee));
+	      assert(kind == ASSERT_FN);
 	      m_bb.bool_assert(v, getDebugLoc(&I));
 	    }
 	  } else {
-	    if (isNotAssumeFn(callee)) {	   
+	    if (kind == NOT_ASSUME_FN) {	   
 	      m_bb.assume(v <= number_t(0));	   
-	    } else if (isAssumeFn(callee)) {
+	    } else if (kind == ASSUME_FN) {
 	      m_bb.assume(v >= number_t(1));
 	    } else  {
-	      assert(isAssertFn(callee));
+	      assert(kind == ASSERT_FN);
 	      m_bb.assertion(v >= number_t(1), getDebugLoc(&I));
 	    }
 	  }
@@ -1867,7 +2058,8 @@ namespace crab_llvm {
 
     CrabInstVisitor(crabLitFactory &lfac, HeapAbstraction &mem,
 		    const DataLayout* dl, const TargetLibraryInfo* tli,
-		    basic_block_t &bb, bool isInterProc, mem_region_set_t& init_regions)
+		    basic_block_t &bb, bool isInterProc, mem_region_set_t& init_regions,
+		    special_fn_map& special_fns, const DenseSet<const Function*> *pruned)
       : m_lfac(lfac)
       , m_mem(mem)
       , m_dl(dl)
@@ -1876,7 +2068,9 @@ namespace crab_llvm {
       , m_is_inter_proc(isInterProc)
       , m_object_id(0)
       , m_has_seahorn_fail(false)
-      , m_init_regions(init_regions) {}
+      , m_init_regions(init_regions)
+      , m_special_fns(special_fns)
+      , m_pruned(pruned) {}
 
     bool has_seahorn_fail() const { return m_has_seahorn_fail;}
 
@@ -2220,7 +2414,7 @@ namespace crab_llvm {
 
       Function& parent = *(I.getParent()->getParent());
       mem_region_t r = get_region(m_mem, parent, &I); 
-      if (isGlobalSingleton(r)) {
+      if (isSingleton(r, parent)) {
 	CRAB_LOG("cfg-gep", llvm::errs() << "Skipped singleton region\n");
 	return;
       }
@@ -2245,7 +2439,7 @@ namespace crab_llvm {
       unsigned BitWidth = m_dl->getPointerTypeSizeInBits(I.getType());
       APInt Offset(BitWidth, 0);
       if (I.accumulateConstantOffset(*m_dl, Offset)) {
-        lin_exp_t offset(toMpz(Offset).get_str());
+        lin_exp_t offset(toZNumber(Offset));
 	m_bb.ptr_assign(lhs->getVar(), ptr->getVar(), offset);
 	CRAB_LOG("cfg-gep",
 		 crab::outs() << "-- " << *lhs << ":=" << *ptr  << "+" << offset << "\n");
@@ -2357,8 +2551,8 @@ namespace crab_llvm {
 	}
 	mem_region_t r = get_region(m_mem, parent, I.getPointerOperand()); 
 	if (!r.isUnknown()) {
-	  if (isGlobalSingleton(r)) {
-	    // Promote the global to an integer/boolean scalar
+	  if (isSingleton(r, parent)) {
+	    // Promote the singleton to an integer/boolean scalar
 	    var_t s = m_lfac.mkArraySingletonVar(r);
 	    if (isInteger(*I.getValueOperand())) {
 	      assert(val->isInt());
@@ -2468,8 +2662,8 @@ namespace crab_llvm {
 	} 	
 	mem_region_t r = get_region(m_mem, parent, I.getPointerOperand()); 
 	if (!(r.isUnknown())) {
-	  if (isGlobalSingleton(r)) {
-	    // Promote the global to an integer/boolean scalar
+	  if (isSingleton(r, parent)) {
+	    // Promote the singleton to an integer/boolean scalar
 	    var_t s = m_lfac.mkArraySingletonVar(r); 
 	    if (isInteger(I)) {
 	      m_bb.assign(lhs->getVar(), s);
@@ -2521,7 +2715,7 @@ namespace crab_llvm {
       if (isPointer(I, m_lfac.get_track())) {
 	crab_lit_ref_t lhs = m_lfac.getLit(I);
 	assert(lhs && lhs->isVar());
-	m_bb.ptr_new_object(lhs->getVar(), m_object_id++);
+	m_bb.ptr_new_object(lhs->getVar(), getObjectAddress(I));
       }
 
       Function& parent = *(I.getParent()->getParent());
@@ -2592,14 +2786,19 @@ namespace crab_llvm {
 	return;
       }
 
-      // -- ignore any shadow functions created by seahorn
-      if (callee->getName().startswith("shadow.mem")) return;
-
-      if (callee->getName().equals("seahorn.fn.enter")) return;
-
-      if (isVerifierCall(callee)) {
-        doVerifierCall(I);
+      special_fn_kind_t kind = m_special_fns[callee];
+      switch (kind) {
+      case SHADOW_MEM_FN: // -- ignore any shadow functions created by seahorn
+      case FN_ENTER_FN:
+	return;
+      case ASSERT_FN:
+      case ASSUME_FN:
+      case NOT_ASSUME_FN:
+      case ERROR_FN:
+      case SEAHORN_FAIL_FN:
+        doVerifierCall(I, kind);
         return;
+      default: ;
       }
       
       if (isAllocationFn(&I, m_tli)){
@@ -2607,7 +2806,7 @@ namespace crab_llvm {
         return;
       }
 
-      if (CrabArrayInit && (isZeroInitializer(callee) || isIntInitializer(callee))) {
+      if (CrabArrayInit && (kind == ZERO_INITIALIZER_FN || kind == INT_INITIALIZER_FN)) {
 	doInitializer(I);
 	return;
       }
@@ -2627,6 +2826,11 @@ namespace crab_llvm {
       }
       
 
+      if (m_pruned && m_pruned->count(callee) > 0) {
+	// -- the callee has no effect on the caller
+	return;
+      }
+      
       if (callee->isDeclaration() || callee->isVarArg() || !m_is_inter_proc) {
 	/**
 	 * If external or we don't perform inter-procedural reasoning
@@ -2771,7 +2975,7 @@ namespace crab_llvm {
 		      tracklev)),
       m_is_inter_proc(isInterProc),
       m_dl(&(func.getParent()->getDataLayout())),
-      m_tli(tli) { }
+      m_tli(tli), m_profile(nullptr), m_pruned(nullptr), m_loop_order(nullptr) { }
 
   CfgBuilder::~CfgBuilder() {}
 
@@ -2814,13 +3018,6 @@ namespace crab_llvm {
     *SS >> *DD;
   }  
 
-  std::string create_bb_name(unsigned &id, std::string prefix = "") {
-    if (prefix == "") prefix = std::string("__@bb_");
-    ++id;
-    std::string id_str = std::to_string(id);
-    return prefix + id_str;
-  }
-  
   //! return the new block inserted between src and dest if any
   CfgBuilder::opt_basic_block_t
   CfgBuilder::exec_br(BasicBlock &src, const BasicBlock &dst) {
@@ -2832,7 +3029,7 @@ namespace crab_llvm {
         opt_basic_block_t Dst = lookup(dst);
         assert(Src && Dst);
 
-	llvm_basic_block_wrapper bb_wrapper(&src, &dst, create_bb_name(m_id));
+	llvm_basic_block_wrapper bb_wrapper(&src, &dst, ++m_id);
 	m_edge_bb_map.insert(std::make_pair(std::make_pair(&src, &dst), bb_wrapper));
   	basic_block_t &bb = m_cfg->insert(bb_wrapper);
         add_block_in_between(*Src, *Dst, bb);
@@ -2900,12 +3097,150 @@ namespace crab_llvm {
     return true;
   }
 
+  /* 
+   * Region-granular liveness: a region is live at a program point if
+   * its array (or singleton) variable may be read afterwards. Stores
+   * are weak updates so they never kill a region. The array variable
+   * of a region is havoc'ed as soon as the region becomes dead so
+   * that the abstract domain can forget it.
+   */
+  void CfgBuilder::forget_dead_regions() {
+    typedef DenseMap<const BasicBlock*, mem_region_set_t> region_map_t;
+    region_map_t gen, live_in, live_out;
+    // regions mentioned (read or written) in each block
+    region_map_t used;
+
+    const BasicBlock *ret_bb = nullptr;
+    for (auto &B: m_func) {
+      mem_region_set_t &g = gen[&B];
+      mem_region_set_t &u = used[&B];
+      for (auto &I: B) {
+	if (LoadInst *LI = dyn_cast<LoadInst>(&I)) {
+	  if (isInteger(*LI) || isBool(*LI)) {
+	    mem_region_t r = get_region(m_mem, m_func, LI->getPointerOperand());
+	    if (!r.isUnknown()) g.insert(r);
+	  }
+	} else if (StoreInst *SI = dyn_cast<StoreInst>(&I)) {
+	  mem_region_t r = get_region(m_mem, m_func, SI->getPointerOperand());
+	  if (!r.isUnknown()) u.insert(r);
+	} else if (MemTransferInst *MTI = dyn_cast<MemTransferInst>(&I)) {
+	  mem_region_t src = get_region(m_mem, m_func, MTI->getSource());
+	  mem_region_t dst = get_region(m_mem, m_func, MTI->getDest());
+	  if (!src.isUnknown()) g.insert(src);
+	  if (!dst.isUnknown()) u.insert(dst);
+	} else if (MemSetInst *MSI = dyn_cast<MemSetInst>(&I)) {
+	  mem_region_t r = get_region(m_mem, m_func, MSI->getDest());
+	  if (!r.isUnknown()) u.insert(r);
+	} else if (CallInst *CI = dyn_cast<CallInst>(&I)) {
+	  CallSite CS(CI);
+	  const Function *callee = CS.getCalledFunction();
+	  if (!callee || isa<IntrinsicInst>(CI)) continue;
+	  mem_region_set_t mods = get_modified_regions(m_mem, *CI);
+	  u.insert(mods.begin(), mods.end());
+	  if (m_is_inter_proc && !callee->isDeclaration() && !callee->isVarArg()) {
+	    // the callsite passes only-read and modified arrays as inputs
+	    mem_region_set_t onlyreads = get_read_only_regions(m_mem, *CI);
+	    mem_region_set_t news = get_new_regions(m_mem, *CI);
+	    g.insert(onlyreads.begin(), onlyreads.end());
+	    for (auto r: mods) {
+	      if (news.find(r) == news.end()) g.insert(r);
+	    }
+	  }
+	}
+      }
+      u.insert(g.begin(), g.end());
+      if (isa<ReturnInst>(B.getTerminator())) {
+	ret_bb = &B;
+      }
+    }
+
+    // -- the output array parameters of the function are read by its callers
+    if (ret_bb && m_is_inter_proc && !m_func.isVarArg() &&
+	!m_func.getName().equals("main")) {
+      mem_region_set_t mods = get_modified_regions(m_mem, m_func);
+      mem_region_set_t news = get_new_regions(m_mem, m_func);
+      live_out[ret_bb].insert(mods.begin(), mods.end());
+      live_out[ret_bb].insert(news.begin(), news.end());
+    }
+
+    // -- backward fixpoint: live_in = gen U live_out
+    bool change = true;
+    while (change) {
+      change = false;
+      for (auto &B: m_func) {
+	mem_region_set_t &out = live_out[&B];
+	for (const BasicBlock *succ: succs(B)) {
+	  const mem_region_set_t &succ_in = live_in[succ];
+	  out.insert(succ_in.begin(), succ_in.end());
+	}
+	mem_region_set_t &in = live_in[&B];
+	size_t old_size = in.size();
+	in.insert(gen[&B].begin(), gen[&B].end());
+	in.insert(out.begin(), out.end());
+	change |= (in.size() != old_size);
+      }
+    }
+
+    auto forget = [this](basic_block_t &bb, mem_region_t r) {
+      if (isSingleton(r, m_func)) {
+	bb.havoc(m_lfac.mkArraySingletonVar(r));
+      } else {
+	bb.havoc(m_lfac.mkArrayVar(r));
+      }
+    };
+    
+    for (auto &B: m_func) {
+      opt_basic_block_t BB = lookup(B);
+      if (!BB) continue;
+      const mem_region_set_t &in = live_in[&B];
+      const mem_region_set_t &out = live_out[&B];
+      // -- regions that die inside B
+      if (&B != ret_bb) {
+	// (live_in \ live_out is included in the used regions)
+	for (auto r: used[&B]) {
+	  if (out.find(r) == out.end()) forget(*BB, r);
+	}
+      }
+      // -- regions that are live along another successor of a
+      //    predecessor of B but not in B
+      mem_region_set_t dead;
+      for (const BasicBlock *pred: preds(B)) {
+	for (auto r: live_out[pred]) {
+	  if (in.find(r) == in.end()) dead.insert(r);
+	}
+      }
+      if (!dead.empty()) {
+	BB->set_insert_point_front();
+	for (auto r: dead) forget(*BB, r);
+	BB->set_insert_point_back();
+      }
+    }
+  }
+  
+  // Return true if the translation of B depends on the blocks
+  // translated before it: the regions initialized by allocas,
+  // memset, allocation functions and verifier initializers are shared
+  // by all the blocks of the function.
+  static bool mayInitRegions(const BasicBlock &B, const TargetLibraryInfo *tli) {
+    for (auto &I: B) {
+      if (isa<AllocaInst>(I) || isa<MemSetInst>(I)) return true;
+      if (const CallInst *CI = dyn_cast<CallInst>(&I)) {
+	if (isAllocationFn(CI, tli)) return true;
+	if (const Function *F = CI->getCalledFunction()) {
+	  if (isZeroInitializer(F) || isIntInitializer(F)) return true;
+	}
+      }
+    }
+    return false;
+  }
+
   void CfgBuilder::build_cfg() {
 
-    crab::ScopedCrabStats __st__("CFG Construction");
+    scoped_stats_timer __st__("CFG Construction");
 
     // Sanity check: pass NameValues must have been executed before
-    bool res = checkAllDefinitionsHaveNames(m_func);
+    // (unless names are computed lazily)
+    bool res = NameValues::lazy() || checkAllDefinitionsHaveNames(m_func);
     if (!res) {
       CRABLLVM_ERROR("All blocks and definitions must have a name",__FILE__,__LINE__);
     }
@@ -2919,16 +3254,78 @@ namespace crab_llvm {
     bool has_seahorn_fail = false;
     // keep track of initialized regions
     mem_region_set_t init_regions;
-    
-    for (auto &B : m_func) {     
+    special_fn_map special_fns;
+    
+    std::vector<BasicBlock*> blocks;
+    blocks.reserve(m_func.size());
+    for (auto &B : m_func) {
+      blocks.push_back(&B);
+    }
+    // blocks already translated in parallel and whether they call
+    // seahorn.fail
+    std::vector<char> translated(blocks.size(), false);
+    std::vector<char> seahorn_fail(blocks.size(), false);
+    
+    if (CrabCfgThreads > 1 && !m_profile && blocks.size() >= CrabCfgParallelBlocks) {
+      // -- names of the values in program order, independent of the
+      //    scheduling of the threads
+      m_lfac.get_vfac().add_names(m_func);
+      // -- the workers only read the struct layouts of the DataLayout
+      compute_struct_layouts(m_func);
+      unsigned num_threads = CrabCfgThreads;
+      std::vector<std::unique_ptr<crabLitFactory>> lfacs;
+      for (unsigned i = 0; i < num_threads; ++i) {
+	lfacs.emplace_back(new crabLitFactory(m_lfac.get_vfac(), m_lfac.get_track()));
+      }
+      std::vector<special_fn_map> fns(num_threads);
+      std::vector<mem_region_set_t> no_init_regions(num_threads);
+      parallel_for(blocks.size(), num_threads, [&](unsigned id, unsigned i) {
+	  BasicBlock &B = *blocks[i];
+	  // -- blocks that initialize regions are translated
+	  //    sequentially below, in program order
+	  if (mayInitRegions(B, m_tli)) return;
+	  opt_basic_block_t BB = lookup(B);
+	  if (!BB) return;
+	  CrabInstVisitor v(*lfacs[id], m_mem, m_dl, m_tli, *BB, m_is_inter_proc,
+			    no_init_regions[id], fns[id], m_pruned);
+	  v.visit(B);
+	  seahorn_fail[i] = v.has_seahorn_fail();
+	  translated[i] = true;
+	});
+    }
+    
+    for (unsigned i = 0, e = blocks.size(); i < e; ++i) {
+      BasicBlock &B = *blocks[i];
       opt_basic_block_t BB = lookup(B);
       if (!BB) continue;
 
       // -- build a CFG block ignoring branches, phi-nodes, and return
-      CrabInstVisitor v(m_lfac, m_mem, m_dl, m_tli, *BB, m_is_inter_proc, init_regions);
-      v.visit(B);
+      CrabInstVisitor v(m_lfac, m_mem, m_dl, m_tli, *BB, m_is_inter_proc, init_regions,
+			special_fns, m_pruned);
+      if (translated[i]) {
+	// done in parallel
+      } else if (!m_profile) {
+	v.visit(B);
+      } else {
+	for (auto &I: B) {
+	  size_t allocs = m_profile->num_allocs ? m_profile->num_allocs() : 0;
+	  auto start = std::chrono::steady_clock::now();
+	  v.visit(I);
+	  std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+	  if (m_profile->costs.size() <= I.getOpcode()) {
+	    m_profile->costs.resize(I.getOpcode() + 1);
+	  }
+	  CfgBuilderProfile::cost &c = m_profile->costs[I.getOpcode()];
+	  c.count++;
+	  c.secs += d.count();
+	  if (m_profile->num_allocs) {
+	    c.allocs += m_profile->num_allocs() - allocs;
+	  }
+	}
+      }
       // hook for seahorn
-      has_seahorn_fail |= (v.has_seahorn_fail() && m_func.getName().equals("main"));
+      has_seahorn_fail |= ((translated[i] ? seahorn_fail[i] : v.has_seahorn_fail()) &&
+			   m_func.getName().equals("main"));
       
       // -- process the exit block of the function and its returned value.
       if (ReturnInst *RI = dyn_cast<ReturnInst>(B.getTerminator())) {
@@ -2967,6 +3364,10 @@ namespace crab_llvm {
     }
 
 
+    if (CrabDeadRegions && m_lfac.get_track() == ARR) {
+      forget_dead_regions();
+    }
+
     /// TODO: add an array init statement
     /// Allocate arrays with initial values 
     // if (m_lfac.get_track() == ARR && CrabArrayInit && CrabUnsoundArrayInit) {
@@ -3192,22 +3593,183 @@ namespace crab_llvm {
       }
     }
     
-    if (CrabCFGSimplify) {
+    if (CrabCFGSimplify || CrabCFGDce) {
       // -- Remove dead statements generated by our translation
       CRAB_VERBOSE_IF(1,get_crab_os() << "Started CFG dead code elimination\n";); 
       cfg_ref_t cfg_ref(*m_cfg);
       crab::transforms::dead_code_elimination<cfg_ref_t> dce;      
       dce.run(cfg_ref);
       CRAB_VERBOSE_IF(1,get_crab_os() << "Finished CFG dead code elimination\n";);
-		      
+    }
+    
+    if (CrabCFGSimplify) {
       // -- Remove empty blocks after dce
       CRAB_VERBOSE_IF(1, get_crab_os() << "Started CFG simplification\n";);
       m_cfg->simplify();      
       CRAB_VERBOSE_IF(1, get_crab_os() << "Finished CFG simplification\n";);
     }
     
-    if (CrabPrintCFG) crab::outs() << *m_cfg << "\n";
+    if (m_loop_order) {
+      compute_loop_order(*m_loop_order);
+    }
+    
+    if (CrabPrintCFG) {
+      std::lock_guard<std::mutex> lock(crab_shared_mutex);
+      crab::outs() << *m_cfg << "\n";
+    }
     return ;
   }
 
+  void CfgBuilder::compute_loop_order(cfg_loop_order &order) {
+    order.blocks.clear();
+    order.heads.clear();
+    DominatorTree dt(m_func);
+    LoopInfo li(dt);
+    DenseMap<const BasicBlock*, unsigned> rpo;
+    ReversePostOrderTraversal<Function*> rpot(&m_func);
+    for (BasicBlock *B: rpot) {
+      unsigned id = rpo.size();
+      rpo[B] = id;
+    }
+    // -- the edges that go backwards must be back edges of natural
+    //    loops. Otherwise, the CFG is irreducible.
+    for (BasicBlock *B: rpot) {
+      for (const BasicBlock *S: succs(*B)) {
+	if (rpo[S] > rpo[B]) continue;
+	const Loop *L = li.getLoopFor(S);
+	if (!L || L->getHeader() != S || !L->contains(B)) return;
+      }
+    }
+    // -- sort by the heads of the enclosing loops and by the position
+    //    in reverse postorder so the blocks of a loop are contiguous
+    typedef std::pair<std::vector<unsigned>, BasicBlock*> key_t;
+    std::vector<key_t> keys;
+    for (BasicBlock *B: rpot) {
+      std::vector<unsigned> key;
+      for (const Loop *L = li.getLoopFor(B); L; L = L->getParentLoop()) {
+	key.push_back(rpo[L->getHeader()]);
+      }
+      std::reverse(key.begin(), key.end());
+      key.push_back(rpo[B]);
+      keys.push_back(key_t(std::move(key), B));
+    }
+    std::sort(keys.begin(), keys.end(), [](const key_t &k1, const key_t &k2) {
+	return k1.first < k2.first;
+      });
+    // -- blocks removed by the simplification of m_cfg are skipped
+    //    and the exit block goes last since the sinks are connected
+    //    to it
+    boost::unordered_set<basic_block_label_t> labels(m_cfg->label_begin(),
+						      m_cfg->label_end());
+    auto add = [&](const basic_block_label_t &bl) {
+      if (m_cfg->has_exit() && bl == m_cfg->exit()) return;
+      if (labels.erase(bl)) order.blocks.push_back(bl);
+    };
+    for (auto &k: keys) {
+      BasicBlock *B = k.second;
+      llvm_basic_block_wrapper bl(B);
+      if (li.isLoopHeader(B) && labels.count(bl)) {
+	order.heads.push_back(bl);
+      }
+      add(bl);
+      for (const BasicBlock *S: succs(*B)) {
+	auto it = m_edge_bb_map.find(std::make_pair(B, S));
+	if (it != m_edge_bb_map.end()) add(it->second);
+      }
+    }
+    if (m_cfg->has_exit() && labels.count(m_cfg->exit())) {
+      order.blocks.push_back(m_cfg->exit());
+    }
+  }
+
+  std::string CfgBuilder::fingerprint(const Function& func, HeapAbstraction &mem,
+				      tracked_precision tracklev, bool isInterProc) {
+    std::string buf;
+    raw_string_ostream o(buf);
+    // -- translation options
+    o << "track=" << (int) tracklev << ";inter=" << isInterProc
+      << ";simplify=" << CrabCFGSimplify
+      << ";dce=" << CrabCFGDce
+      << ";singletons=" << CrabEnableUniqueScalars
+      << ";noptr=" << CrabDisablePointers
+      << ";havoc=" << CrabIncludeHavoc
+      << ";arrinit=" << CrabArrayInit
+      << ";unsound-arrinit=" << CrabUnsoundArrayInit
+      << ";dead-regions=" << CrabDeadRegions << "\n";
+    // -- heap abstraction
+    if (tracklev >= ARR) {
+      o << mem.getName() << "\n"
+	<< mem.getAccessedRegions(func) << mem.getOnlyReadRegions(func)
+	<< mem.getModifiedRegions(func) << mem.getNewRegions(func) << "\n";
+    }
+    // -- function body
+    func.print(o);
+    o.flush();
+    
+    MD5 hash;
+    hash.update(buf);
+    MD5::MD5Result res;
+    hash.final(res);
+    SmallString<32> str;
+    MD5::stringifyResult(res, str);
+    return str.str().str();
+  }
+
+  unsigned CfgBuilder::num_checks(const Function& func) {
+    unsigned res = 0;
+    for (auto &B: func) {
+      for (auto &I: B) {
+	if (const CallInst *CI = dyn_cast<CallInst>(&I)) {
+	  const Function *callee = dyn_cast<Function>
+	    (CI->getCalledValue()->stripPointerCasts());
+	  if (callee && (isAssertFn(callee) || isErrorFn(callee))) {
+	    res++;
+	  }
+	}
+      }
+    }
+    return res;
+  }
+
+  namespace struct_layout_impl {
+    static void addType(Type *T, const DataLayout &dl, DenseSet<Type*> &seen) {
+      if (!seen.insert(T).second) return;
+      for (auto it = T->subtype_begin(), et = T->subtype_end(); it != et; ++it) {
+	addType(*it, dl, seen);
+      }
+      if (StructType *ST = dyn_cast<StructType>(T)) {
+	// isSized also caches its result in ST
+	if (!ST->isOpaque() && ST->isSized()) {
+	  dl.getStructLayout(ST);
+	}
+      }
+    }
+
+    static void addValue(const Value *V, const DataLayout &dl, DenseSet<Type*> &seen,
+			 DenseSet<const ConstantExpr*> &seen_exprs) {
+      addType(V->getType(), dl, seen);
+      if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(V)) {
+	if (!seen_exprs.insert(CE).second) return;
+	for (const Use &op: CE->operands()) {
+	  addValue(op.get(), dl, seen, seen_exprs);
+	}
+      }
+    }
+  } // end namespace struct_layout_impl
+  
+  void CfgBuilder::compute_struct_layouts(const Function& func) {
+    const DataLayout &dl = func.getParent()->getDataLayout();
+    DenseSet<Type*> seen;
+    DenseSet<const ConstantExpr*> seen_exprs;
+    struct_layout_impl::addType(func.getType(), dl, seen);
+    for (auto &B: func) {
+      for (auto &I: B) {
+	struct_layout_impl::addValue(&I, dl, seen, seen_exprs);
+	for (const Use &op: I.operands()) {
+	  struct_layout_impl::addValue(op.get(), dl, seen, seen_exprs);
+	}
+      }
+    }
+  }
+
 } // end namespace crab_llvm
@@ -0,0 +1,100 @@
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CheckOnly.hh"
+
+#include <boost/unordered_map.hpp>
+
+using namespace llvm;
+
+extern cl::opt<std::string> CrabCheckOnly;
+
+namespace crab_llvm {
+
+  namespace check_only_impl {
+
+    bool enabled() { return CrabCheckOnly != ""; }
+
+    static bool isAssertFn(const Function *F) {
+      return (F->getName().equals("verifier.assert") ||
+	      F->getName().equals("crab.assert") ||
+	      F->getName().equals("__CRAB_assert"));
+    }
+
+    /** Begin target_set **/
+    bool target_set::isRelevant(const Function &F) const {
+      return !enabled() || m_relevant.count(&F) > 0;
+    }
+
+    bool target_set::init(Module &M, CallGraph &cg, bool inter) {
+      m_targets.clear();
+      m_relevant.clear();
+      StringRef spec(CrabCheckOnly);
+      size_t colon = spec.rfind(':');
+      unsigned line = 0;
+      if (colon == StringRef::npos || spec.substr(colon + 1).getAsInteger(10, line)) {
+	errs() << "Warning: --crab-check-only expects file:line\n";
+	return false;
+      }
+      StringRef file = spec.substr(0, colon);
+      
+      std::vector<const Function*> worklist;
+      for (auto &F: M) {
+	for (auto &I: instructions(&F)) {
+	  const CallInst *CI = dyn_cast<CallInst>(&I);
+	  if (!CI) continue;
+	  const Function *callee = dyn_cast<Function>(CI->getCalledValue()->stripPointerCasts());
+	  if (!callee || !isAssertFn(callee)) continue;
+	  const DebugLoc &dloc = CI->getDebugLoc();
+	  if (!dloc || dloc.getLine() != line) continue;
+	  std::string dfile = (*dloc).getFilename();
+	  if (!StringRef(dfile).endswith(file)) continue;
+	  // -- same location as CfgBuilder
+	  m_targets.insert(crab::cfg::debug_info(dfile == "" ? "unknown file" : dfile,
+						 dloc.getLine(), dloc.getCol()));
+	  if (m_relevant.insert(&F).second) worklist.push_back(&F);
+	}
+      }
+      if (m_targets.empty()) return false;
+      if (!inter) return true;
+
+      // -- callers of the functions with the assertions
+      boost::unordered_map<const Function*, std::vector<const Function*>> callers;
+      for (auto &kv: cg) {
+	const Function *caller = kv.second->getFunction();
+	if (!caller) continue;
+	for (auto &rec: *kv.second) {
+	  if (const Function *callee = rec.second->getFunction()) {
+	    callers[callee].push_back(caller);
+	  }
+	}
+      }
+      while (!worklist.empty()) {
+	const Function *F = worklist.back();
+	worklist.pop_back();
+	for (const Function *caller: callers[F]) {
+	  if (m_relevant.insert(caller).second) worklist.push_back(caller);
+	}
+      }
+      // -- and everything they call, for the summaries
+      worklist.assign(m_relevant.begin(), m_relevant.end());
+      while (!worklist.empty()) {
+	const Function *F = worklist.back();
+	worklist.pop_back();
+	CallGraphNode *N = cg[F];
+	for (auto &rec: *N) {
+	  const Function *callee = rec.second->getFunction();
+	  if (callee && m_relevant.insert(callee).second) worklist.push_back(callee);
+	}
+      }
+      return true;
+    }
+    /** End target_set **/
+  } // end namespace check_only_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,66 @@
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/ChecksCache.hh"
+#include "crab_llvm/IncrementalAnalysis.hh"
+
+#include <fstream>
+
+using namespace llvm;
+
+extern cl::opt<bool> CrabCheckLayered;
+extern cl::opt<unsigned> CrabInterSumThreshold;
+extern cl::opt<bool> CrabInterPrune;
+
+namespace crab_llvm {
+
+  namespace checks_cache_impl {
+
+    static const std::string header = "CRAB-CHECKS 1";
+
+    std::string getFileName(const std::string &dir, const Function &F,
+			    const AnalysisParams &params, HeapAbstraction &mem) {
+      std::string key = incremental_impl::getKey(F, params, mem);
+      key += ";layered=" + std::to_string(CrabCheckLayered ? 1 : 0);
+      return incremental_impl::getHashedFileName(dir, key, ".checks");
+    }
+
+    std::string getFileName(const std::string &dir, Module &M,
+			    const AnalysisParams &params, HeapAbstraction &mem) {
+      std::string key = "inter;" + std::to_string((int) params.sum_dom) + ";" +
+	std::to_string((unsigned) CrabInterSumThreshold) + ";" +
+	std::to_string(CrabInterPrune ? 1 : 0);
+      for (auto &F: M) {
+	if (!isTrackable(F)) continue;
+	key += "|" + F.getName().str() + "=" + incremental_impl::getKey(F, params, mem);
+      }
+      return incremental_impl::getHashedFileName(dir, key, ".checks");
+    }
+    
+    bool load(const std::string &file, checks_db_t &checks) {
+      std::ifstream i(file);
+      if (!i) return false;
+      std::string line;
+      unsigned safe, err, warn;
+      if (!std::getline(i, line) || line != header) return false;
+      if (!(i >> safe >> err >> warn)) return false;
+      for (; safe > 0; --safe) checks.add(crab::checker::_SAFE);
+      for (; err > 0; --err)   checks.add(crab::checker::_ERR);
+      for (; warn > 0; --warn) checks.add(crab::checker::_WARN);
+      return true;
+    }
+
+    void store(const std::string &file, const checks_db_t &checks) {
+      std::ofstream o(file);
+      if (!o) {
+	errs() << "Warning: cannot write checks in " << file << "\n";
+	return;
+      }
+      o << header << "\n" << checks.get_total_safe() << " "
+	<< checks.get_total_error() << " " << checks.get_total_warning() << "\n";
+    }
+  } // end namespace checks_cache_impl
+
+} // end namespace crab_llvm
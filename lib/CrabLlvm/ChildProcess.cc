@@ -0,0 +1,140 @@
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/ChildProcess.hh"
+
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  namespace child_impl {
+
+    // exit status of a child that could not write its results
+    static const int write_error = 2;
+    // exit status of a child that ran out of its memory limit
+    static const int out_of_memory = 3;
+
+    // Wait until the child exits or timeout_ms (0: no limit)
+    // elapses. SIGCHLD is blocked by the caller so that it is
+    // received by sigtimedwait. Return pid if the child exited, 0 if
+    // it did not exit in time and -1 on error.
+    static pid_t waitChild(pid_t pid, unsigned timeout_ms, int &status) {
+      if (timeout_ms == 0) {
+	pid_t res;
+	while ((res = waitpid(pid, &status, 0)) < 0 && errno == EINTR) {}
+	return res;
+      }
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+      sigset_t chld;
+      sigemptyset(&chld);
+      sigaddset(&chld, SIGCHLD);
+      while (true) {
+	pid_t res = waitpid(pid, &status, WNOHANG);
+	if (res == pid || (res < 0 && errno != EINTR)) return res;
+	auto left = std::chrono::duration_cast<std::chrono::nanoseconds>
+	  (deadline - std::chrono::steady_clock::now()).count();
+	if (left <= 0) return 0;
+	struct timespec ts;
+	ts.tv_sec = left / 1000000000;
+	ts.tv_nsec = left % 1000000000;
+	// -- returns when some child changes state or on timeout
+	sigtimedwait(&chld, nullptr, &ts);
+      }
+    }
+    
+    status_t run(const std::function<bool()> &body,
+		 unsigned timeout_ms, unsigned mem_mb, std::string &error) {
+      llvm::outs().flush();
+      llvm::errs().flush();
+      std::cout.flush();
+      sigset_t chld, old_mask;
+      sigemptyset(&chld);
+      sigaddset(&chld, SIGCHLD);
+      pthread_sigmask(SIG_BLOCK, &chld, &old_mask);
+      pid_t pid = fork();
+      if (pid < 0) {
+	pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+	error = "cannot fork";
+	return FAILED;
+      }
+      
+      if (pid == 0) {
+	// -- child process
+	pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+	if (mem_mb > 0) {
+	  rlim_t limit = (rlim_t) mem_mb * 1024 * 1024;
+	  std::ifstream statm("/proc/self/statm");
+	  unsigned long pages;
+	  if (statm >> pages) {
+	    limit += (rlim_t) pages * sysconf(_SC_PAGESIZE);
+	  }
+	  struct rlimit rl;
+	  rl.rlim_cur = rl.rlim_max = limit;
+	  setrlimit(RLIMIT_AS, &rl);
+	}
+	int code = write_error;
+	try {
+	  code = (body() ? 0 : write_error);
+	} catch (std::bad_alloc &) {
+	  code = out_of_memory;
+	}
+	llvm::outs().flush();
+	llvm::errs().flush();
+	std::cout.flush();
+	_exit(code);
+      }
+      
+      // -- parent process
+      int status = 0;
+      pid_t res = waitChild(pid, timeout_ms, status);
+      if (res == 0) {
+	kill(pid, SIGKILL);
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+      }
+      pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+      
+      if (res < 0) {
+	error = "cannot wait for the child process";
+	return FAILED;
+      } else if (res == 0) {
+	error = "timeout";
+	return EXCEEDED;
+      } else if (WIFEXITED(status)) {
+	switch (WEXITSTATUS(status)) {
+	case 0:
+	  return FINISHED;
+	case out_of_memory:
+	  error = "out of memory";
+	  return EXCEEDED;
+	case write_error:
+	  error = "cannot write the results of the child process";
+	  return FAILED;
+	default:
+	  error = "exit status " + std::to_string(WEXITSTATUS(status));
+	  return FAILED;
+	}
+      } else if (WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL) {
+	// -- killed by someone else, e.g., the kernel out of memory
+	error = "killed by signal " + std::to_string(SIGKILL);
+	return EXCEEDED;
+      } else if (WIFSIGNALED(status)) {
+	error = "killed by signal " + std::to_string(WTERMSIG(status));
+	return FAILED;
+      }
+      error = "unexpected status of the child process";
+      return FAILED;
+    }
+  } // end namespace child_impl
+
+} // end namespace crab_llvm
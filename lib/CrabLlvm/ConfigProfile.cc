@@ -0,0 +1,125 @@
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/ADT/SmallString.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CfgBuilder.hh"
+#include "crab_llvm/ConfigProfile.hh"
+#include "crab_llvm/IncrementalAnalysis.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab/common/debug.hpp"
+
+#include <fstream>
+
+using namespace llvm;
+using namespace crab::cfg;
+
+extern cl::opt<enum tracked_precision> CrabTrackLev;
+
+namespace crab_llvm {
+
+  namespace config_profile_impl {
+
+    static const std::string header = "CRAB-CONFIG-PROFILE 1";
+
+    static std::string hash(const std::string &s) {
+      MD5 md5;
+      md5.update(s);
+      MD5::MD5Result res;
+      md5.final(res);
+      SmallString<32> hash_str;
+      MD5::stringifyResult(res, hash_str);
+      return hash_str.str().str();
+    }
+
+    /** Begin profile **/
+    profile::profile(Module &M, HeapAbstraction &mem) {
+      for (auto &F: M) {
+	if (isTrackable(F)) {
+	  m_keys[&F] = hash(CfgBuilder::fingerprint(F, mem, CrabTrackLev, cfg_has_callsites));
+	}
+      }
+    }
+
+    // A missing file is not an error: it is the first run
+    bool profile::load(const std::string &file) {
+      std::ifstream i(file);
+      if (!i) return true;
+      std::string line;
+      if (!std::getline(i, line) || line != header) return false;
+      std::string key;
+      while (i >> key) {
+	entry e;
+	int dom;
+	if (!(i >> dom >> e.widening_delay >> e.narrowing_iters >> e.widening_jumpset
+	      >> e.ms >> e.unproven) || !i.ignore(1) ||
+	    !incremental_impl::readName(i, e.name)) {
+	  return false;
+	}
+	e.dom = (CrabDomain) dom;
+	m_loaded[key] = e;
+      }
+      return true;
+    }
+
+    // the entries of this run replace the loaded ones
+    bool profile::store(const std::string &file) {
+      std::map<std::string, entry> all(m_loaded);
+      for (auto &kv: m_recorded) {
+	all[kv.first] = kv.second;
+      }
+      std::ofstream o(file);
+      if (!o) return false;
+      o << header << "\n";
+      for (auto &kv: all) {
+	const entry &e = kv.second;
+	o << kv.first << " " << (int) e.dom << " " << e.widening_delay << " "
+	  << e.narrowing_iters << " " << e.widening_jumpset << " "
+	  << e.ms << " " << e.unproven << " ";
+	incremental_impl::writeName(o, e.name);
+	o << "\n";
+      }
+      return (bool) o;
+    }
+
+    const entry* profile::find(const Function &F) const {
+      auto k = m_keys.find(&F);
+      if (k == m_keys.end()) return nullptr;
+      auto it = m_loaded.find(k->second);
+      return (it == m_loaded.end() ? nullptr : &it->second);
+    }
+
+    // Use the options recorded for F, if any
+    void profile::apply(const Function &F, AnalysisParams &params) const {
+      const entry *e = find(F);
+      if (!e) return;
+      params.dom = e->dom;
+      params.widening_delay = e->widening_delay;
+      params.narrowing_iters = e->narrowing_iters;
+      params.widening_jumpset = e->widening_jumpset;
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Using the options of the previous run for "
+				       << F.getName() << "\n");
+    }
+
+    // params are the options after the analysis of F (e.g., the
+    // domain of the last layer)
+    void profile::record(const Function &F, const AnalysisParams &params,
+			 const checks_db_t &checks, unsigned ms) {
+      auto k = m_keys.find(&F);
+      if (k == m_keys.end()) return;
+      entry e = { params.dom, params.widening_delay, params.narrowing_iters,
+		  params.widening_jumpset, ms, checks.get_total_warning(),
+		  F.getName().str() };
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_recorded[k->second] = e;
+    }
+    /** End profile **/
+
+    unsigned elapsed_ms(std::chrono::steady_clock::time_point start) {
+      return std::chrono::duration_cast<std::chrono::milliseconds>
+	(std::chrono::steady_clock::now() - start).count();
+    }
+  } // end namespace config_profile_impl
+
+} // end namespace crab_llvm
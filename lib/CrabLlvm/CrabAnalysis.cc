@@ -0,0 +1,50 @@
+#include "llvm/IR/Function.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CrabAnalysis.hh"
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  char CrabAnalysis::PassID;
+
+  CrabAnalysis::Result::Result() {}
+
+  CrabAnalysis::Result::Result(Result &&o)
+    : m_cfg_man(std::move(o.m_cfg_man)), m_crab(std::move(o.m_crab)) {}
+
+  CrabAnalysis::Result::~Result() {
+    // the analysis refers to the cfg
+    m_crab.reset();
+  }
+
+  CrabAnalysis::wrapper_dom_ptr
+  CrabAnalysis::Result::get_pre(const BasicBlock *b, bool keep_shadows) const {
+    return m_crab->get_pre(b, keep_shadows);
+  }
+
+  CrabAnalysis::wrapper_dom_ptr
+  CrabAnalysis::Result::get_post(const BasicBlock *b, bool keep_shadows) const {
+    return m_crab->get_post(b, keep_shadows);
+  }
+
+  const CrabAnalysis::checks_db_t& CrabAnalysis::Result::get_checks_db() const {
+    return m_crab->get_checks_db();
+  }
+
+  CrabAnalysis::Result CrabAnalysis::run(Function &F, FunctionAnalysisManager *AM) {
+    const TargetLibraryInfo &tli = AM->getResult<TargetLibraryAnalysis>(F);
+    Result res;
+    res.m_cfg_man.reset(new CfgManager());
+    res.m_crab.reset(new IntraCrabLlvm(F, tli, *res.m_cfg_man, m_cfg_precision, m_heap_abs));
+    if (!F.isDeclaration()) {
+      // analyze can change the parameters (e.g., the domain)
+      AnalysisParams params(m_params);
+      res.m_crab->analyze(params, IntraCrabLlvm::assumption_map_t());
+    }
+    return res;
+  }
+
+} // end namespace crab_llvm
@@ -4,18 +4,36 @@
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/CallSite.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/Transforms/Utils/UnifyFunctionExitNodes.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SCCIterator.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include "llvm/ADT/SmallString.h"
 
 #include "crab_llvm/config.h"
 #include "crab_llvm/crab_domains.hh"
@@ -23,10 +41,51 @@
 #include "crab_llvm/CrabLlvm.hh"
 #include "crab_llvm/CfgBuilder.hh"
 #include "crab_llvm/Support/NameValues.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab_llvm/Support/CFG.hh"
+#include "crab_llvm/Support/Parallel.hh"
+#include "crab_llvm/Support/Arena.hh"
+#include "crab_llvm/Support/Trace.hh"
+#include "crab_llvm/Support/PerfCounters.hh"
+#include "crab_llvm/Support/AllocStats.hh"
+#include "crab_llvm/Support/Stats.hh"
+#include "crab_llvm/Support/ReduceConstraints.hh"
 /** Wrappers for pointer analyses **/
 #include "crab_llvm/DummyHeapAbstraction.hh"
 #include "crab_llvm/LlvmDsaHeapAbstraction.hh"
 #include "crab_llvm/SeaDsaHeapAbstraction.hh"
+#include "crab_llvm/TypeHeapAbstraction.hh"
+#include "crab_llvm/BudgetHeapAbstraction.hh"
+#include "crab_llvm/SnapshotHeapAbstraction.hh"
+#include "crab_llvm/MixedHeapAbstraction.hh"
+#include "crab_llvm/InvariantDb.hh"
+#include "crab_llvm/CrabLlvmUtils.hh"
+#include "crab_llvm/LazyInvariants.hh"
+#include "crab_llvm/IncrementalAnalysis.hh"
+#include "crab_llvm/ChecksCache.hh"
+#include "crab_llvm/PruneFunctions.hh"
+#include "crab_llvm/Summaries.hh"
+#include "crab_llvm/ExportInvariants.hh"
+#include "crab_llvm/CheckOnly.hh"
+#include "crab_llvm/Roots.hh"
+#include "crab_llvm/ModuleState.hh"
+#include "crab_llvm/ScheduleChecks.hh"
+#include "crab_llvm/ConfigProfile.hh"
+#include "crab_llvm/ChildProcess.hh"
+#include "crab_llvm/ModuleBudget.hh"
+#include "crab_llvm/DedupFunctions.hh"
+#include "crab_llvm/AllocAccountant.hh"
+#include "crab_llvm/PhaseProfile.hh"
+#include "crab_llvm/Reproducers.hh"
+#include "crab_llvm/Slicing.hh"
+#include "crab_llvm/BackwardCone.hh"
+#include "crab_llvm/NullityDataflow.hh"
+#include "crab_llvm/TrivialChecks.hh"
+#include "crab_llvm/AdaptiveHeuristics.hh"
+#include "crab_llvm/SizeStats.hh"
+#include "crab_llvm/LoopStats.hh"
+#include "crab_llvm/AutoSeaDsa.hh"
+#include "crab_llvm/RangeQueries.hh"
 #ifdef HAVE_DSA
 #include "dsa/Steensgaard.hh"
 #endif
@@ -36,14 +95,13 @@
 #include "crab/analysis/fwd_analyzer.hpp"
 #include "crab/analysis/bwd_analyzer.hpp"
 #include "crab/analysis/inter_fwd_analyzer.hpp"
+#include "crab/analysis/abs_transformer.hpp"
 #include "crab/analysis/dataflow/liveness.hpp"
 #include "crab/analysis/dataflow/assumptions.hpp"
-#include "crab/checkers/assertion.hpp"
-#include "crab/checkers/null.hpp"
-#include "crab/checkers/checker.hpp"
 #include "crab/cg/cg.hpp"
 #include "crab/cg/cg_bgl.hpp"
 #include "./crab/path_analyzer.hpp"
+#include "./crab/analyzers.hpp"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
@@ -52,6 +110,20 @@
 #include <memory>
 #include <functional>
 #include <map>
+#include <unordered_map>
+#include <set>
+#include <list>
+#include <cstdio>
+#include <climits>
+#include <algorithm>
+#include <iterator>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+#include <sstream>
 
 
 using namespace llvm;
@@ -78,11 +150,65 @@ CrabStoreInvariants("crab-store-invariants",
                cl::desc("Store invariants"),
                cl::init(true));
 
+cl::opt<invariants_storage_t>
+CrabInvariantsStorage("crab-invariants-storage",
+   cl::desc("How invariants are stored (only intra-procedural analysis)"),
+   cl::values(
+       clEnumValN(EAGER_STORAGE   , "eager", "Copy pre and post of each block"),
+       clEnumValN(LAZY_STORAGE    , "lazy" , "Build pre and post of each block on demand"),
+       clEnumValN(PRE_ONLY_STORAGE, "pre"  , "Copy pre and recompute post of each block on demand"),
+       clEnumValN(SPILL_STORAGE   , "spill", "Write pre and post of each block to a temporary file "
+		  "and keep in memory only the most recently used ones"),
+       clEnumValN(DELTA_STORAGE   , "delta", "Copy pre of each block as a difference with the pre "
+		  "of its immediate dominator and recompute post of each block on demand"),
+       clEnumValEnd),
+   cl::init(EAGER_STORAGE));
+
+cl::opt<unsigned>
+CrabMaxCfgs("crab-max-cfgs",
+   cl::desc("Max number of CFGs kept in memory after the analysis (0: no limit). "
+	    "The others are rebuilt on demand (only intra-procedural analysis)"),
+   cl::init(0));
+
+cl::opt<unsigned>
+CrabInvariantsInMemory("crab-invariants-in-memory",
+   cl::desc("Max number of invariants kept in memory (only with --crab-invariants-storage=spill)"),
+   cl::init(10000));
+
+cl::opt<bool>
+CrabShareInvariants("crab-share-invariants",
+   cl::desc("Stored invariants that are equal share the same abstract value "
+	    "(only with --crab-invariants-storage=eager and --crab-invariants-storage=pre)"),
+   cl::init(false));
+
+cl::opt<bool>
+CrabBoxesScoped("crab-boxes-scoped",
+   cl::desc("Store the invariants of the boxes domain as linear constraints so that "
+	    "the decision diagrams of a function are released after its analysis"),
+   cl::init(false));
+
 cl::opt<bool>
 CrabStats("crab-stats", 
            cl::desc("Show Crab statistics and analysis results"),
            cl::init(false));
 
+cl::opt<unsigned>
+CrabVerboseRate("crab-verbose-rate", 
+           cl::desc("Max number of lines per second of the verbose log (0: no limit)"),
+           cl::init(0));
+
+cl::opt<bool>
+CrabAllocStats("crab-alloc-stats", 
+	       cl::desc("Count the allocations of each analysis phase and function "
+			"in --crab-stats (only if operator new is hooked)"),
+	       cl::init(false));
+
+cl::opt<bool>
+CrabStatsConstraints("crab-stats-constraints", 
+           cl::desc("Measure the size of invariants in --crab-stats by their number "
+		    "of linear constraints (instead of finite bounds, more expensive)"),
+           cl::init(false));
+
 cl::opt<bool>
 CrabBuildOnlyCFG("crab-only-cfg", 
            cl::desc("Build Crab CFG without running the analysis"),
@@ -108,6 +234,12 @@ CrabWideningJumpSet("crab-widening-jump-set",
                     cl::desc("Size of the jump set used for widening"),
                     cl::init(0));
 
+cl::opt<unsigned int>
+CrabWideningAutoJumpSet("crab-widening-auto-jump-set", 
+     cl::desc("Size of the jump set of each function is the number of constants "
+	      "compared in its loops, up to this value (0: disabled)"),
+     cl::init(0));
+
 cl::opt<CrabDomain>
 CrabLlvmDomain("crab-dom",
       cl::desc("Crab numerical abstract domain used to infer invariants"),
@@ -126,20 +258,75 @@ CrabLlvmDomain("crab-dom",
 		   "Disjunctive intervals based on ldds"),
        clEnumValN(ZONES_SPLIT_DBM, "zones",
 		   "Zones domain with Sparse DBMs in Split Normal Form"),
+       clEnumValN(ZONES_SPLIT_DBM_FAST, "zones-fast",
+		   "Zones domain with int64 weights (GMP weights on overflow)"),
        clEnumValN(OCT, "oct", "Octagons domain"),
        clEnumValN(PK, "pk", "Polyhedra domain"),
        clEnumValN(TERMS_ZONES, "rtz",
 		   "Reduced product of term-dis-int and zones."),
        clEnumValN(WRAPPED_INTERVALS, "w-int", "Wrapped interval domain"),       
+       clEnumValN(DENSE_INTERVALS, "dense-int",
+		   "Classical interval domain with dense int64 bounds"),
+       clEnumValN(WRAPPED_INTERVALS_FAST, "w-int-fast",
+		   "Wrapped interval domain with native uint64_t bounds"),
+       clEnumValN(PTR_OFFSETS, "ptr-offsets",
+		   "dense-int with the base region and the offsets of each pointer"),
+       clEnumValN(ZONES_DENSE_DBM, "zones-dense",
+		   "zones-fast with dense DBMs for small dense states"),
+       clEnumValN(ADAPT_TERMS_ZONES, "adapt-rtz",
+		   "rtz while its fixpoint is cheap. Otherwise, term-int and then intervals"),
        clEnumValEnd),
        cl::init(INTERVALS));
 
+cl::list<CrabDomain>
+CrabPortfolio("crab-portfolio",
+      cl::desc("Analyze each function with all the given domains "
+	       "and keep the most precise result"),
+      cl::CommaSeparated,
+      cl::values 
+      (clEnumValN(INTERVALS, "int", "Classical interval domain"),
+       clEnumValN(TERMS_INTERVALS, "term-int",
+		   "Intervals with uninterpreted functions."),       
+       clEnumValN(INTERVALS_CONGRUENCES, "ric",
+		   "Reduced product of intervals with congruences"),
+       clEnumValN(DIS_INTERVALS, "dis-int",
+		   "Disjunctive intervals based on Clousot's DisInt domain"),
+       clEnumValN(TERMS_DIS_INTERVALS, "term-dis-int",
+		   "Disjunctive Intervals with uninterpreted functions."),
+       clEnumValN(BOXES, "boxes",
+		   "Disjunctive intervals based on ldds"),
+       clEnumValN(ZONES_SPLIT_DBM, "zones",
+		   "Zones domain with Sparse DBMs in Split Normal Form"),
+       clEnumValN(ZONES_SPLIT_DBM_FAST, "zones-fast",
+		   "Zones domain with int64 weights (GMP weights on overflow)"),
+       clEnumValN(OCT, "oct", "Octagons domain"),
+       clEnumValN(PK, "pk", "Polyhedra domain"),
+       clEnumValN(TERMS_ZONES, "rtz",
+		   "Reduced product of term-dis-int and zones."),
+       clEnumValN(WRAPPED_INTERVALS, "w-int", "Wrapped interval domain"),       
+       clEnumValN(DENSE_INTERVALS, "dense-int",
+		   "Classical interval domain with dense int64 bounds"),
+       clEnumValN(WRAPPED_INTERVALS_FAST, "w-int-fast",
+		   "Wrapped interval domain with native uint64_t bounds"),
+       clEnumValN(PTR_OFFSETS, "ptr-offsets",
+		   "dense-int with the base region and the offsets of each pointer"),
+       clEnumValN(ZONES_DENSE_DBM, "zones-dense",
+		   "zones-fast with dense DBMs for small dense states"),
+       clEnumValEnd));
+
 cl::opt<bool>
 CrabBackward("crab-backward", 
            cl::desc("Perform an iterative forward/backward analysis (very experimental)\n"
 		     "(Only intra-procedural version implemented)"),
            cl::init(false));
 
+cl::opt<bool>
+CrabBackwardCone("crab-backward-cone", 
+           cl::desc("Run the backward analysis only on the blocks that can reach "
+		    "assertions not proven by the forward analysis (only with --crab-backward "
+		    "and --crab-check=assert)"),
+           cl::init(false));
+
 // If domain is num
 cl::opt<unsigned>
 CrabRelationalThreshold("crab-relational-threshold", 
@@ -148,17 +335,237 @@ CrabRelationalThreshold("crab-relational-threshold",
    cl::init(10000),
    cl::Hidden);
 
+cl::opt<unsigned>
+CrabTermsMax("crab-terms-max",
+   cl::desc("Max number of terms created by the term domains in a function before "
+	    "switching to their base domain (0: no limit)"),
+   cl::init(0),
+   cl::value_desc("NUM"));
+
+cl::opt<bool>
+CrabRelationalThresholdLoops("crab-relational-threshold-loops", 
+   cl::desc("Apply --crab-relational-threshold only to the blocks inside loops"),
+   cl::init(false));
+
+cl::opt<bool>
+CrabRelationalThresholdEstimate("crab-relational-threshold-estimate",
+   cl::desc("Apply --crab-relational-threshold to the live LLVM values instead of "
+	    "running the liveness analysis of the Crab CFG (only intra-procedural analysis)"),
+   cl::init(false));
+
+cl::opt<bool>
+CrabRelationalThresholdPacks("crab-relational-threshold-packs", 
+   cl::desc("Compare --crab-relational-threshold with the size of the largest "
+	    "pack of related variables (only zones)"),
+   cl::init(false));
+
 cl::opt<bool>
 CrabLive("crab-live", 
 	 cl::desc("Run Crab with live ranges. "
 		  "It can lose precision if relational domains"),
 	 cl::init(false));
 
+cl::opt<bool>
+CrabReuseLiveness("crab-reuse-live",
+	 cl::desc("Run Crab with the live ranges computed for --crab-relational-threshold "
+		  "(as --crab-live but only with relational domains)"),
+	 cl::init(false));
+
+cl::opt<bool>
+CrabLiveCompact("crab-live-compact",
+	 cl::desc("Run oct and pk with live ranges so that the dimensions of the dead "
+		  "variables are removed from their states at the end of each block"),
+	 cl::init(true));
+
 cl::opt<bool>
 CrabInter("crab-inter",
            cl::desc("Crab Inter-procedural analysis"), 
            cl::init(false));
 
+cl::opt<std::string>
+CrabIncremental("crab-incremental",
+		cl::desc("Directory where the analysis results of each function are "
+			 "stored and reused if the function did not change\n"
+			 "(Only intra-procedural analysis)"),
+		cl::init(""),
+		cl::value_desc("dir"));
+
+cl::opt<std::string>
+CrabChecksCache("crab-checks-cache",
+		cl::desc("Directory where the checks of each function are stored and "
+			 "replayed if the function did not change"),
+		cl::init(""),
+		cl::value_desc("dir"));
+
+cl::opt<std::string>
+CrabExportSummaries("crab-export-summaries",
+		    cl::desc("Write the function summaries computed by --crab-inter in file"),
+		    cl::init(""),
+		    cl::value_desc("file"));
+
+cl::opt<std::string>
+CrabImportSummaries("crab-import-summaries",
+		    cl::desc("Compare the function summaries computed by --crab-inter "
+			     "with the ones written in file by --crab-export-summaries"),
+		    cl::init(""),
+		    cl::value_desc("file"));
+
+cl::opt<bool>
+CrabCompactSummaries("crab-compact-summaries",
+		     cl::desc("Project the printed and exported summaries onto the inputs "
+			      "and outputs and remove their redundant constraints"),
+		     cl::init(false));
+
+cl::opt<unsigned>
+CrabSummaryMaxRelational("crab-summary-max-relational",
+			 cl::desc("Keep at most N relational constraints of each compacted "
+				  "summary (0: no limit)"),
+			 cl::init(0),
+			 cl::value_desc("N"));
+
+cl::opt<std::string>
+CrabExportInvariants("crab-export-invariants",
+		     cl::desc("Write the invariants of each block in file"),
+		     cl::init(""),
+		     cl::value_desc("file"));
+
+cl::opt<std::string>
+CrabExportInvariantsDb("crab-export-invariants-db",
+		       cl::desc("Write the invariants of all blocks in file as a "
+				"memory-mappable database"),
+		       cl::init(""),
+		       cl::value_desc("file"));
+
+cl::opt<std::string>
+CrabChecksStream("crab-checks-stream",
+		 cl::desc("Write the checks of each function in file as soon as it is analyzed"),
+		 cl::init(""),
+		 cl::value_desc("file"));
+
+cl::opt<std::string>
+CrabProfile("crab-profile",
+	    cl::desc("Write the time of each analysis phase per function in file"),
+	    cl::init(""),
+	    cl::value_desc("file"));
+
+cl::opt<bool>
+CrabProfileCounters("crab-profile-counters",
+		    cl::desc("Add hardware performance counters of each phase to "
+			     "--crab-profile (Linux only)"),
+		    cl::init(false));
+
+cl::opt<std::string>
+CrabConfigProfile("crab-config-profile",
+		  cl::desc("Analyze each function with the domain and widening options "
+			   "recorded in file by a previous run, and record them again"),
+		  cl::init(""),
+		  cl::value_desc("file"));
+
+cl::opt<std::string>
+CrabTrace("crab-trace",
+	  cl::desc("Write a timeline of the analysis phases per function and thread "
+		   "in Chrome trace-event format in file"),
+	  cl::init(""),
+	  cl::value_desc("file"));
+
+cl::opt<unsigned>
+CrabExtractSlow("crab-extract-slow",
+		cl::desc("Write a reproducer of each function whose analysis takes at "
+			 "least the given milliseconds (0: never)"),
+		cl::init(0),
+		cl::value_desc("ms"));
+
+cl::opt<std::string>
+CrabExtractDir("crab-extract-dir",
+	       cl::desc("Directory of the reproducers written by --crab-extract-slow"),
+	       cl::init("crab-repro"),
+	       cl::value_desc("dir"));
+
+cl::opt<bool>
+CrabExportJson("crab-export-json",
+	       cl::desc("Use JSON lines instead of binary format with --crab-export-invariants"),
+	       cl::init(false));
+
+// also used by InsertInvariants
+cl::opt<bool>
+CrabReduceConstraints("crab-reduce-constraints",
+		      cl::desc("Remove redundant constraints from the invariants exported by "
+			       "--crab-export-invariants(-db) or inserted by --crab-add-invariants"),
+		      cl::init(false));
+
+// Budget for the analysis of each function (only intra-procedural)
+cl::opt<unsigned>
+CrabAdaptCost("crab-adapt-cost-ms",
+	      cl::desc("Max time in milliseconds of each domain tried by "
+		       "--crab-dom=adapt-rtz before switching to a cheaper one"),
+	      cl::init(2000),
+	      cl::value_desc("MS"));
+
+cl::opt<unsigned>
+CrabFnTimeout("crab-fn-timeout-ms",
+	      cl::desc("Max time in milliseconds to analyze a function before "
+		       "switching to intervals (0 means no limit)"),
+	      cl::init(0));
+
+cl::opt<unsigned>
+CrabFnMemory("crab-fn-mem-mb",
+	     cl::desc("Max memory in MB to analyze a function before "
+		      "switching to intervals (0 means no limit)"),
+	     cl::init(0));
+
+cl::opt<unsigned>
+CrabFnBudgetMinSize("crab-fn-budget-min-size",
+		    cl::desc("Functions with fewer instructions are analyzed without the budget "
+			     "of --crab-fn-timeout-ms, --crab-fn-mem-mb and --crab-dom=adapt-rtz"),
+		    cl::init(50));
+
+cl::opt<unsigned>
+CrabModuleBudget("crab-module-budget",
+		 cl::desc("Time in seconds to analyze the whole module. Expensive functions "
+			  "are analyzed with cheaper options if it would be exceeded (0: no limit)"),
+		 cl::init(0),
+		 cl::value_desc("sec"));
+
+cl::opt<unsigned>
+CrabThreads("crab-threads",
+	    cl::desc("Number of threads used to build CFGs and analyze functions in parallel\n"
+		     "(Only CFG construction with inter-procedural analysis)"),
+	    cl::init(1));
+
+cl::opt<unsigned>
+CrabFixpointThreads("crab-fixpoint-threads",
+	    cl::desc("Experimental: number of threads of the forward fixpoint over the "
+		     "independent components of a function (ignored with backward analysis, "
+		     "assumptions or --crab-inter)"),
+	    cl::init(1), cl::value_desc("N"));
+
+cl::opt<bool>
+CrabSparse("crab-sparse",
+	   cl::desc("Experimental: propagate the values of the variables along def-use "
+		    "chains instead of computing the invariants of each block (only for "
+		    "non-relational domains, ignored with backward analysis, assumptions "
+		    "or --crab-inter)"),
+	   cl::init(false));
+
+cl::opt<bool>
+CrabAdaptiveFixpoint("crab-adaptive-fixpoint",
+	   cl::desc("Experimental: decide the widening delay and the narrowing iterations "
+		    "per loop head (the same conditions as --crab-fixpoint-threads apply)"),
+	   cl::init(false));
+
+cl::opt<unsigned>
+CrabWideningMaxDelay("crab-widening-max-delay",
+	   cl::desc("Max number of fixpoint iterations until widening is applied to a loop "
+		    "head whose join is still more precise than widening "
+		    "(only with --crab-adaptive-fixpoint)"),
+	   cl::init(4), cl::value_desc("N"));
+
+cl::opt<bool>
+CrabAccelerateLoops("crab-accelerate-loops",
+	   cl::desc("Experimental: widen the simple counting loops with the bounds implied "
+		    "by their guards (the same conditions as --crab-fixpoint-threads apply)"),
+	   cl::init(false));
+
 // It does not make much sense to have non-relational domains here.
 cl::opt<CrabDomain>
 CrabSummDomain("crab-inter-sum-dom",
@@ -166,12 +573,26 @@ CrabSummDomain("crab-inter-sum-dom",
     cl::values 
     (clEnumValN(ZONES_SPLIT_DBM, "zones",
 		 "Zones domain with sparse DBMs in Split Normal Form"),
+     clEnumValN(ZONES_SPLIT_DBM_FAST, "zones-fast",
+		 "Zones domain with int64 weights (GMP weights on overflow)"),
      clEnumValN(OCT, "oct", "Octagons domain"),
      clEnumValN(TERMS_ZONES, "rtz",
 		 "Reduced product of term-dis-int and zones."),
      clEnumValEnd),
     cl::init(ZONES_SPLIT_DBM));
 
+cl::opt<bool>
+CrabInterPrune("crab-inter-prune",
+    cl::desc("Remove from the call graph of --crab-inter the functions without "
+	     "checks nor effects on their callers (they have no invariants)"),
+    cl::init(false));
+
+cl::opt<unsigned>
+CrabInterSumThreshold("crab-inter-sum-threshold",
+    cl::desc("Max number of parameters and return values of the functions of a "
+	     "call graph SCC before using cheaper domains for --crab-inter (0: disabled)"),
+    cl::init(0));
+
 cl::opt<enum tracked_precision>
 CrabTrackLev("crab-track",
    cl::desc("Track abstraction level of the Crab Cfg"),
@@ -189,9 +610,30 @@ CrabHeapAnalysis("crab-heap-analysis",
     (clEnumValN(LLVM_DSA  , "llvm-dsa"  , "context-insensitive llvm dsa"),
      clEnumValN(CI_SEA_DSA, "ci-sea-dsa", "context-insensitive sea dsa"),
      clEnumValN(CS_SEA_DSA, "cs-sea-dsa", "context-sensitive sea dsa"),
+     clEnumValN(TYPE_BASED, "type"      , "regions by struct field and integer type (no pointer analysis)"),
+     clEnumValN(AUTO_SEA_DSA, "auto-sea-dsa",
+		"cs-sea-dsa within --crab-dsa-auto-ms and --crab-dsa-auto-mb, otherwise ci-sea-dsa"),
      clEnumValEnd),
    cl::init(heap_analysis_t::LLVM_DSA));
 
+cl::opt<unsigned>
+CrabDsaAutoTimeout("crab-dsa-auto-ms",
+    cl::desc("Max time in milliseconds of context-sensitive sea-dsa with "
+	     "--crab-heap-analysis=auto-sea-dsa (0 means no limit)"),
+    cl::init(30000));
+
+cl::opt<unsigned>
+CrabDsaAutoMemory("crab-dsa-auto-mb",
+    cl::desc("Max memory in MB of context-sensitive sea-dsa with "
+	     "--crab-heap-analysis=auto-sea-dsa (0 means no limit)"),
+    cl::init(0));
+
+cl::opt<unsigned>
+CrabDsaAutoFnRegions("crab-dsa-auto-fn-regions",
+    cl::desc("With --crab-heap-analysis=auto-sea-dsa, a function that accesses more "
+	     "regions uses context-insensitive sea-dsa (0 means no limit)"),
+    cl::init(1000));
+
 // Specific llvm-dsa/sea-dsa options
 cl::opt<bool>
 CrabDsaDisambiguateUnknown("crab-dsa-disambiguate-unknown",
@@ -211,6 +653,20 @@ CrabDsaDisambiguateExternal("crab-dsa-disambiguate-external",
     cl::init(false),
     cl::Hidden);
 
+cl::opt<std::string>
+CrabHeapSnapshot("crab-heap-snapshot",
+    cl::desc("Load the heap abstraction from file if it was computed for the same "
+	     "module and heap options. Otherwise, compute it and store it in file"),
+    cl::init(""),
+    cl::value_desc("file"));
+
+cl::opt<unsigned>
+CrabRegionBudget("crab-region-budget",
+    cl::desc("Maximum number of regions accessed by a function. Beyond it, the "
+	     "least accessed regions are merged by type (0: unlimited)"),
+    cl::init(0),
+    cl::value_desc("N"));
+
 // Prove assertions
 cl::opt<assert_check_kind_t>
 CrabCheck("crab-check", 
@@ -222,11 +678,85 @@ CrabCheck("crab-check",
 	       clEnumValEnd),
 	   cl::init(assert_check_kind_t::NOCHECKS));
 
+cl::opt<bool>
+CrabCheckNullFast("crab-check-null-fast",
+		  cl::desc("Check --crab-check=null with a dedicated nullity dataflow "
+			   "instead of the abstract domain (no invariants are computed)"),
+		  cl::init(false));
+
+cl::opt<bool>
+CrabDischargeTrivialChecks("crab-discharge-trivial-checks",
+		  cl::desc("Decide the assertions that only depend on constants before the "
+			   "analysis. Functions without other assertions are not analyzed "
+			   "(no invariants are computed for them)"),
+		  cl::init(false));
+
 cl::opt<unsigned int>
 CrabCheckVerbose("crab-check-verbose", 
                  cl::desc("Print verbose information about checks"),
                  cl::init(0));
 
+cl::opt<bool>
+CrabScheduleChecks("crab-schedule-checks", 
+		   cl::desc("Analyze first the functions that are more likely to fail"),
+		   cl::init(false));
+
+cl::opt<bool>
+CrabStopOnError("crab-stop-on-error", 
+                cl::desc("Stop the analysis after the first function with an error check"),
+                cl::init(false));
+
+cl::opt<bool>
+CrabDedupFunctions("crab-dedup-functions",
+		   cl::desc("Analyze only once the functions that are identical up to the "
+			    "names of their values (only intra-procedural analysis)"),
+		   cl::init(false));
+
+cl::list<std::string>
+CrabRoots("crab-roots",
+          cl::desc("Analyze only the functions reachable from these functions in the call graph"),
+          cl::CommaSeparated,
+          cl::value_desc("function names"));
+
+cl::opt<std::string>
+CrabCheckOnly("crab-check-only", 
+              cl::desc("Check only the assertion at file:line. Only the functions needed "
+		       "to prove it are analyzed"),
+              cl::init(""),
+              cl::value_desc("file:line"));
+
+cl::opt<bool>
+CrabSliceChecks("crab-slice-checks", 
+                cl::desc("Remove statements that cannot affect the checks before the analysis "
+			 "(only intra-procedural analysis and if invariants are not printed)"),
+                cl::init(false));
+
+cl::opt<bool>
+CrabCheckAssertingBlocks("crab-check-asserting-blocks", 
+			 cl::desc("Check assertions by revisiting only the blocks with "
+				  "assertions (only intra-procedural, integer assertions)"),
+			 cl::init(false));
+
+cl::opt<bool>
+CrabCheckLayered("crab-check-layered", 
+                cl::desc("Prove assertions with intervals first and try more precise domains "
+			 "only on functions with unproven assertions"),
+                cl::init(false));
+
+cl::opt<bool>
+CrabArena("crab-arena", 
+          cl::desc("Recycle the big numbers of the abstract domains in thread-local pools "
+		   "released after the analysis of each function"),
+          cl::init(true));
+
+// IntraCrabLlvm::reanalyze is only used by crab-llvm clients
+cl::opt<bool>
+CrabWarmReanalysis("crab-warm-reanalysis",
+    cl::desc("Analyze each function again from its invariants as "
+	     "IntraCrabLlvm::reanalyze does (only for testing)"),
+    cl::init(false),
+    cl::Hidden);
+
 // Important to crab-llvm clients (e.g., SeaHorn):
 // Shadow variables are variables that cannot be mapped back to a
 // const Value*. These are created for instance for memory heaps.
@@ -236,73 +766,26 @@ CrabKeepShadows("crab-keep-shadows",
     cl::init(false),
     cl::Hidden);
 
-// In C++11 we need to pass to std::bind "this" (if class member
-// functions are called) as well as all placeholders for each
-// argument. This is wrapper to avoid that and improve readability.
-template <class C, typename Ret, typename ... Ts>
-static std::function<Ret(Ts...)> bind_this(C* c, Ret (C::*m)(Ts...)) {
-  return [=](Ts&&... args) { return (c->*m)(std::forward<decltype(args)>(args)...); };
-}
-
 namespace crab_llvm {
 
-  static crab::crab_os& get_crab_os(bool show_time = true) {
-    crab::crab_os* result = &crab::outs();
-    if (show_time) {
-      time_t now = time(0);
-      struct tm tstruct;
-      char buf[80];
-      tstruct = *localtime(&now);
-      strftime(buf, sizeof(buf), "[%Y-%m-%d.%X] ", &tstruct);
-      *result << buf;
-    }
-    return *result;
-  }
-  
   using namespace crab::analyzer;
   using namespace crab::checker;
   using namespace crab::cg;
 
-  /** Begin typedefs **/
-  typedef crab::analyzer::liveness<cfg_ref_t> liveness_t;
-  typedef crab::cg::call_graph<cfg_ref_t> call_graph_t; 
-  typedef crab::cg::call_graph_ref<call_graph_t> call_graph_ref_t;
-  typedef boost::unordered_map<cfg_ref_t, const liveness_t*> liveness_map_t;
-  typedef DenseMap<const BasicBlock*, lin_cst_sys_t> assumption_map_t;
-  typedef typename IntraCrabLlvm::wrapper_dom_ptr wrapper_dom_ptr;    
-  typedef typename IntraCrabLlvm::checks_db_t checks_db_t;
-  typedef typename IntraCrabLlvm::invariant_map_t invariant_map_t;
-  typedef typename IntraCrabLlvm::heap_abs_ptr heap_abs_ptr;
-  /** End typedefs **/
-  
-  /** Begin global counters **/
-  static unsigned num_invars; // some measure for the size of invariants
-  static unsigned num_nontrivial_blocks;
-  /** End global counters **/
-  
-  static bool isRelationalDomain(CrabDomain dom) {
-    return (dom == ZONES_SPLIT_DBM || dom == OCT ||
-	    dom == PK || dom == TERMS_ZONES);
-  }
-
-  static bool isTrackable(const Function &fun) {
-    return !fun.isDeclaration () && !fun.empty () && !fun.isVarArg ();
+  /** return a copy of inv without shadow_varnames **/
+  static wrapper_dom_ptr forgetShadows(const wrapper_dom_ptr &inv,
+				       const std::vector<varname_t> &shadow_varnames) {
+    std::vector<var_t> shadow_vars;
+    shadow_vars.reserve(shadow_varnames.size());
+    for(unsigned i=0; i<shadow_varnames.size(); ++i) {
+      // we need to create a typed variable
+      shadow_vars.push_back(var_t(shadow_varnames[i], crab::UNK_TYPE, 0));
+    }
+    auto invs = inv->clone();
+    invs->forget(shadow_vars);
+    return invs;
   }
-
-  /** convenient wrapper for the invariance analysis datastructures **/
-  struct InvarianceAnalysisResults {
-    // invariants that hold at the entry of a block
-    invariant_map_t &premap;
-    // invariants that hold at the exit of a block
-    invariant_map_t &postmap;
-    // database with all the checks
-    checks_db_t &checksdb;
-
-    InvarianceAnalysisResults(invariant_map_t &pre, invariant_map_t &post,
-			      checks_db_t &db)
-      : premap(pre), postmap(post), checksdb(db) {}
-  };
-
+  
   /** return invariant for block in table but filtering out shadow_varnames **/
   static wrapper_dom_ptr lookup(const invariant_map_t &table,
 				const llvm::BasicBlock &block,
@@ -311,36 +794,49 @@ namespace crab_llvm {
     if (it == table.end()) {
       return nullptr;
     }
+    if (shadow_varnames.empty()) {
+      return lazy_impl::materialize(it->second);
+    } else {
+      return forgetShadows(it->second, shadow_varnames);
+    }
+  }
+  
+  /** 
+   * Same as above but the filtered invariant is computed only once
+   * and stored in cache. The caller gets its own copy of the cached
+   * invariant so it cannot modify the cache. If cache_mutex is not
+   * null then accesses to cache are protected by it so lookup can be
+   * called concurrently.
+   **/
+  static wrapper_dom_ptr lookup(const invariant_map_t &table,
+				invariant_map_t &cache,
+				const llvm::BasicBlock &block,
+				const std::vector<varname_t> &shadow_varnames,
+				std::mutex *cache_mutex = nullptr) {
+    auto it = table.find (&block);
+    if (it == table.end()) {
+      return nullptr;
+    }
     
     if (shadow_varnames.empty()) {
-      return it->second;
+      return lazy_impl::materialize(it->second);
     } else {
-      std::vector<var_t> shadow_vars;
-      shadow_vars.reserve(shadow_varnames.size());
-      for(unsigned i=0; i<shadow_vars.size(); ++i) {
-	// we need to create a typed variable
-	shadow_vars.push_back(var_t(shadow_varnames[i], crab::UNK_TYPE, 0));
+      {
+	std::unique_lock<std::mutex> lock;
+	if (cache_mutex) lock = std::unique_lock<std::mutex>(*cache_mutex);
+	auto cit = cache.find(&block);
+	if (cit != cache.end()) {
+	  return cit->second->clone();
+	}
       }
-      auto invs = it->second->clone();
-      invs->forget(shadow_vars); 
-      return invs;
+      auto invs = forgetShadows(it->second, shadow_varnames);
+      std::unique_lock<std::mutex> lock;
+      if (cache_mutex) lock = std::unique_lock<std::mutex>(*cache_mutex);
+      // another thread might have inserted it in the meantime
+      return cache.insert(std::make_pair(&block, invs)).first->second->clone();
     }
   }   
 
-  /** update table with pre or post invariants **/
-  static bool update(invariant_map_t &table, 
-		     const llvm::BasicBlock &block, wrapper_dom_ptr absval) {
-    bool already = false;
-    auto it = table.find(&block);
-    if (it == table.end()) {
-      table.insert(std::make_pair(&block, absval));
-    } else {
-      it->second = absval;
-      already = true;
-    }
-    return already;
-  }
-      
   /** Pretty-printer utilities **/
   namespace pretty_printer_impl {
 
@@ -573,11 +1069,16 @@ namespace crab_llvm {
     case BOXES:                 return boxes_domain_t::getDomainName();
     case DIS_INTERVALS:         return dis_interval_domain_t::getDomainName();
     case ZONES_SPLIT_DBM:       return split_dbm_domain_t::getDomainName();
+    case ZONES_SPLIT_DBM_FAST:  return split_dbm_fast_domain_t::getDomainName();
+    case ZONES_DENSE_DBM:       return dense_dbm_domain_t::getDomainName();
     case TERMS_DIS_INTERVALS:   return term_dis_int_domain_t::getDomainName();
     case TERMS_ZONES:           return num_domain_t::getDomainName();
     case OCT:                   return oct_domain_t::getDomainName();
     case PK:                    return pk_domain_t::getDomainName();
     case WRAPPED_INTERVALS:     return wrapped_interval_domain_t::getDomainName();
+    case DENSE_INTERVALS:       return dense_interval_domain_t::getDomainName();
+    case WRAPPED_INTERVALS_FAST: return wrapped_interval_fast_domain_t::getDomainName();
+    case PTR_OFFSETS:           return offset_pointer_domain_t::getDomainName();
     default:                    return "none";
     }
   }
@@ -591,53 +1092,245 @@ namespace crab_llvm {
   }
   
   /* CFG Manager class */
-  CfgManager::CfgManager(){}
-  CfgManager::~CfgManager(){
-    for (auto &kv: m_cfg_map) {
-      delete kv.second;
+  CfgManager::CfgManager(): m_capacity(0) {}
+  CfgManager::~CfgManager(){}
+
+  // all the private methods are called with m_mutex locked
+  void CfgManager::touch(const Function &f) const {
+    auto it = m_lru_pos.find(&f);
+    if (it != m_lru_pos.end()) {
+      m_lru.splice(m_lru.end(), m_lru, it->second);
+    } else {
+      m_lru_pos[&f] = m_lru.insert(m_lru.end(), &f);
+    }
+  }
+
+  void CfgManager::insert(const Function &f, cfg_ptr_t cfg) const {
+    auto it = m_cfg_map.find(&f);
+    if (it != m_cfg_map.end()) {
+      // f has been translated again (e.g., analyze_function)
+      m_func_map.erase(it->second.get());
+      it->second = cfg;
+    } else {
+      m_cfg_map.insert(std::make_pair(&f, cfg));
+    }
+    m_func_map[cfg.get()] = &f;
+    m_evicted.erase(&f);
+    touch(f);
+  }
+
+  void CfgManager::erase(const Function &f) const {
+    auto it = m_cfg_map.find(&f);
+    if (it != m_cfg_map.end()) {
+      m_func_map.erase(it->second.get());
+      m_cfg_map.erase(it);
+    }
+    auto pit = m_lru_pos.find(&f);
+    if (pit != m_lru_pos.end()) {
+      m_lru.erase(pit->second);
+      m_lru_pos.erase(pit);
     }
   }
   
   bool CfgManager::has_cfg(const Function &f) const {
-    return m_cfg_map.find(&f) != m_cfg_map.end();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cfg_map.find(&f) != m_cfg_map.end() || m_evicted.count(&f) > 0;
   }
   
-  cfg_ref_t CfgManager::operator[](const Function &f) const {
-    assert(has_cfg(f));
-    
+  cfg_ptr_t CfgManager::get_ptr(const Function &f) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
     auto it = m_cfg_map.find(&f);
-    cfg_t *cfg = it->second;
-    return cfg_ref_t(*cfg);
+    if (it == m_cfg_map.end()) {
+      assert(m_evicted.count(&f) > 0 && m_builder);
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Rebuilding Crab CFG for "
+		                       << f.getName() << "\n");
+      cfg_ptr_t cfg(m_builder(f));
+      insert(f, cfg);
+      return cfg;
+    }
+    touch(f);
+    return it->second;
   }
   
-  void CfgManager::add(const Function &f, cfg_t *cfg) {
-    if (!has_cfg(f)) {
-      m_cfg_map.insert(std::make_pair(&f, cfg));
+  cfg_ref_t CfgManager::operator[](const Function &f) const {
+    return cfg_ref_t(*get_ptr(f));
+  }
+  
+  const Function* CfgManager::get_function(const cfg_t &cfg) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_func_map.find(&cfg);
+    return (it != m_func_map.end() ? it->second : nullptr);
+  }
+  
+  void CfgManager::release(const Function &f) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    erase(f);
+    m_evicted.erase(&f);
+  }
+
+  void CfgManager::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cfg_map.clear();
+    m_func_map.clear();
+    m_lru.clear();
+    m_lru_pos.clear();
+    m_evicted.clear();
+  }
+
+  void CfgManager::evict() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_capacity == 0 || !m_builder) return;
+    while (m_cfg_map.size() > m_capacity && !m_lru.empty()) {
+      const Function *f = m_lru.front();
+      erase(*f);
+      m_evicted.insert(f);
+    }
+  }
+
+  void CfgManager::defer(const Function &f) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(m_builder);
+    if (m_cfg_map.find(&f) == m_cfg_map.end()) {
+      m_evicted.insert(&f);
     }
   }
+
+  void CfgManager::add(const Function &f, cfg_t *cfg) {
+    add(f, cfg_ptr_t(cfg));
+  }
+  
+  void CfgManager::add(const Function &f, cfg_ptr_t cfg) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    insert(f, cfg);
+  }
+  
+  /**
+   * Assumptions already converted to an abstract domain. They are
+   * stored in the format expected by the crab analyzer so they are
+   * passed to it without copies.
+   **/
+  struct IntraCrabLlvm::domain_assumptions {
+    virtual ~domain_assumptions() {}
+    // Conjoin csts to the assumption of b
+    virtual void add(const llvm::BasicBlock &b, const lin_cst_sys_t &csts) = 0;
+    // Return the assumptions as linear constraints (used if the
+    // analysis runs with another domain)
+    virtual assumption_map_t to_constraints() const = 0;
+  };
+
+  template<typename Dom>
+  struct typed_domain_assumptions: public IntraCrabLlvm::domain_assumptions {
+    typename intra_analyzer<Dom>::assumption_map_t m_map;
+
+    virtual void add(const llvm::BasicBlock &b, const lin_cst_sys_t &csts) override {
+      basic_block_label_t bl(&b);
+      auto it = m_map.find(bl);
+      if (it == m_map.end()) {
+	Dom absval = Dom::top();
+	absval += csts;
+	m_map.insert(std::make_pair(bl, std::move(absval)));
+      } else {
+	it->second += csts;
+      }
+    }
+
+    virtual assumption_map_t to_constraints() const override {
+      assumption_map_t res;
+      for (auto &kv: m_map) {
+	if (const BasicBlock *B = kv.first.get_basic_block()) {
+	  Dom absval(kv.second);
+	  res.insert(std::make_pair(B, absval.to_linear_constraint_system()));
+	}
+      }
+      return res;
+    }
+  };
   
   /**
    * Internal implementation of the intra-procedural analysis
    **/
+  // Build the CFG of F for the intra-procedural analysis. The CFGs
+  // evicted by CfgManager (--crab-max-cfgs) are rebuilt with it, so
+  // they are the same as the ones built before the analysis.
+  static cfg_t* buildIntraCfg(Function &F, llvm_variable_factory &vfac, HeapAbstraction &mem,
+			      crab::cfg::tracked_precision cfg_precision,
+			      const TargetLibraryInfo &tli,
+			      cfg_loop_order *loop_order = nullptr,
+			      CfgBuilder::edge_to_bb_map_t *edge_bb_map = nullptr) {
+    CfgBuilder builder(F, vfac, mem, cfg_precision, cfg_has_callsites, &tli);
+    if (loop_order) {
+      builder.set_loop_order(loop_order);
+    }
+    cfg_t *cfg = builder.get_cfg();
+    if (edge_bb_map) {
+      *edge_bb_map = builder.releaseEdgeToBBMap();
+    }
+    return cfg;
+  }
+  
   class IntraCrabLlvm_Impl {
     
-    cfg_t *m_cfg;
+    // shared with CfgManager and with the stored invariants that use it
+    cfg_ptr_t m_cfg;
     Function &m_fun;
     llvm_variable_factory &m_vfac;
+    // to build m_cfg
+    crab::cfg::tracked_precision m_cfg_precision;
+    heap_abs_ptr m_mem;
+    CfgManager &m_cfg_man;
+    const TargetLibraryInfo &m_tli;
+    // null if not run by CrabLlvmPass
+    const ModuleState *m_state;
     typename CfgBuilder::edge_to_bb_map_t m_edge_bb_map;
+    // iteration order of m_cfg for --crab-fixpoint-threads and
+    // --crab-sparse (empty if m_cfg is irreducible)
+    cfg_loop_order m_loop_order;
+    // whether m_cfg is a copy of the cfg of CfgManager
+    bool m_is_private;
+    // whether m_cfg has been sliced (--crab-slice-checks)
+    bool m_is_sliced;
+    // whether the trivial assertions have been removed from m_cfg
+    // (--crab-discharge-trivial-checks), their outcome and whether
+    // there is no other assertion
+    bool m_is_discharged;
+    checks_db_t m_discharged;
+    bool m_all_discharged;
+    // edges of m_cfg shared by all the path analyses (built lazily)
+    typedef cfg_successor_index<cfg_ref_t> successor_index_t;
+    mutable std::unique_ptr<successor_index_t> m_succ_index;
+    mutable std::once_flag m_succ_index_once;
+
+    // Non-null if --crab-profile
+    profile_impl::profiler *getProfiler() const {
+      return (m_state ? m_state->profile.get() : nullptr);
+    }
+
+    // All the invariants of the module share the store of the pass
+    // and its budget
+    boost::shared_ptr<lazy_impl::spill_store> getSpillStore(const AnalysisParams &params) const {
+      if (m_state && m_state->spill_store) {
+	return m_state->spill_store;
+      }
+      return boost::make_shared<lazy_impl::spill_store>(params.invariants_in_memory);
+    }
+
+    const successor_index_t* getSuccessorIndex() const {
+      std::call_once(m_succ_index_once, [this]() {
+	  m_succ_index.reset(new successor_index_t(*m_cfg));
+	});
+      return m_succ_index.get();
+    }
     
     template<typename Dom>
     void analyzeCfg(const AnalysisParams &params,
 		    const BasicBlock *entry,
-		    const assumption_map_t &assumptions, liveness_t *live,
+		    const assumption_map_t &assumptions,
+		    const IntraCrabLlvm::domain_assumptions *dom_assumptions,
+		    liveness_t *live,
 		    InvarianceAnalysisResults &results) {
       
       // -- we use the combined forward/backward analyzer
-      typedef intra_forward_backward_analyzer<cfg_ref_t,Dom> intra_analyzer_t;
-      // -- checkers for assertions and nullity
-      typedef intra_checker<intra_analyzer_t> intra_checker_t;
-      typedef assert_property_checker<intra_analyzer_t> assert_prop_t;
-      typedef null_property_checker<intra_analyzer_t> null_prop_t;
+      typedef intra_analyzer<Dom> intra_analyzer_t;
       
       CRAB_VERBOSE_IF(1,
 		      auto fdecl = m_cfg->get_func_decl ();            
@@ -648,15 +1341,35 @@ namespace crab_llvm {
 		                    << "  ... \n";);
       
       // -- run intra-procedural analysis
-      intra_analyzer_t analyzer (*m_cfg);
-      typename intra_analyzer_t::assumption_map_t crab_assumptions;
-      typedef typename intra_analyzer_t::assumption_map_t::value_type binding_t;
-      // reconstruct a crab assumption map from our assumption DenseMap
-      for (auto &kv: assumptions) {
-	Dom absval = Dom::top();
-	absval += kv.second;
-	crab_assumptions.insert(binding_t(kv.first, absval));
+      // The analyzer is kept alive after this function returns if
+      // invariants are built lazily. Only its invariant tables are
+      // used afterwards.
+      auto analyzer_ptr = boost::make_shared<intra_analyzer_t>(*m_cfg);
+      intra_analyzer_t &analyzer = *analyzer_ptr;
+      typedef typename intra_analyzer_t::assumption_map_t crab_assumption_map_t;
+      typedef typename crab_assumption_map_t::value_type binding_t;
+      crab_assumption_map_t built_assumptions;
+      const crab_assumption_map_t *crab_assumptions_ptr = &built_assumptions;
+      auto typed = dynamic_cast<const typed_domain_assumptions<Dom>*>(dom_assumptions);
+      if (typed) {
+	// -- the assumptions are already in Dom: no copies
+	crab_assumptions_ptr = &typed->m_map;
+      } else if (dom_assumptions) {
+	// -- the assumptions were built for another domain
+	for (auto &kv: dom_assumptions->to_constraints()) {
+	  Dom absval = Dom::top();
+	  absval += kv.second;
+	  built_assumptions.insert(binding_t(kv.first, std::move(absval)));
+	}
+      } else {
+	// reconstruct a crab assumption map from our assumption DenseMap
+	for (auto &kv: assumptions) {
+	  Dom absval = Dom::top();
+	  absval += kv.second;
+	  built_assumptions.insert(binding_t(kv.first, std::move(absval)));
+	}
       }
+      const crab_assumption_map_t &crab_assumptions = *crab_assumptions_ptr;
       
       Dom post_cond = Dom::top();
       if (params.check && params.run_backward) {
@@ -673,35 +1386,180 @@ namespace crab_llvm {
 	entry_dom = it->second;
       }
       
-      analyzer.run(basic_block_label_t(entry), entry_dom, post_cond,
-		   !params.run_backward, crab_assumptions, live,
-		   params.widening_delay, params.narrowing_iters, params.widening_jumpset);
+      // -- with --crab-backward-cone the forward analysis runs first
+      //    on the whole cfg and the backward one only on the blocks
+      //    that can reach unproven assertions. Those are the blocks
+      //    of cone_cfg and they are analyzed by cone_analyzer_ptr.
+      bool use_cone = (CrabBackwardCone && params.run_backward &&
+		       params.check == ASSERTION && entry == &m_fun.getEntryBlock());
+      std::unique_ptr<cfg_t> cone_cfg;
+      std::unique_ptr<intra_analyzer_t> cone_analyzer_ptr;
+      cone_impl::block_set_t cone;
+      boost::unordered_map<basic_block_label_t, cone_impl::block_checks_t> cone_proven;
+      if (use_cone) {
+	{ profile_impl::scoped_phase phase(m_state, m_fun, "forward");
+	  arena_scope arena(CrabArena);
+	  analyzer.run(basic_block_label_t(entry), entry_dom, Dom::top(), true,
+		       crab_assumptions, live,
+		       params.widening_delay, params.narrowing_iters, params.widening_jumpset);
+	}
+	cone_impl::block_set_t unproven;
+	cone_proven = cone_impl::getProvenChecks<Dom>(*m_cfg, analyzer, unproven);
+	if (unproven.empty()) {
+	  count_stat("CrabLlvm.count.backward_skipped");
+	} else {
+	  cone = cone_impl::getCone(*m_cfg, unproven);
+	  cone_cfg = cone_impl::restrict(*m_cfg, cone);
+	  count_stat("CrabLlvm.count.cone_blocks", cone.size());
+	  CRAB_VERBOSE_IF(1, get_crab_os() << "Backward analysis restricted to "
+			                   << cone.size() << " blocks with "
+			                   << unproven.size() << " unproven checks\n");
+	  profile_impl::scoped_phase phase(m_state, m_fun, "forward_backward");
+	  arena_scope arena(CrabArena);
+	  cone_analyzer_ptr.reset(new intra_analyzer_t(*cone_cfg));
+	  cone_analyzer_ptr->run(basic_block_label_t(entry), entry_dom, post_cond, false,
+				 crab_assumptions, nullptr, params.widening_delay,
+				 params.narrowing_iters, params.widening_jumpset);
+	}
+      } else { // the backward analysis is interleaved with the forward one
+	profile_impl::scoped_phase phase(m_state, m_fun, params.run_backward ?
+					 "forward_backward" : "forward");
+	arena_scope arena(CrabArena);
+	if (CrabSparse && isNonRelationalDomain(params.dom) && !params.run_backward &&
+	    crab_assumptions.empty() && canRunInParallel(params)) {
+	  analyzer.run_sparse(basic_block_label_t(entry), entry_dom,
+			      params.widening_delay, params.narrowing_iters, &m_loop_order);
+	} else if ((CrabFixpointThreads > 1 || CrabAdaptiveFixpoint || CrabAccelerateLoops) &&
+		   !params.run_backward &&
+		   crab_assumptions.empty() && canRunInParallel(params)) {
+	  analyzer.run_parallel(basic_block_label_t(entry), entry_dom,
+				params.widening_delay, params.narrowing_iters,
+				std::max(1U, (unsigned) CrabFixpointThreads), &m_loop_order,
+				CrabAdaptiveFixpoint, CrabWideningMaxDelay, CrabAccelerateLoops);
+	} else {
+	  analyzer.run(basic_block_label_t(entry), entry_dom, post_cond,
+		       !params.run_backward, crab_assumptions, live,
+		       params.widening_delay, params.narrowing_iters, params.widening_jumpset);
+	}
+      }
       CRAB_VERBOSE_IF(1, get_crab_os() << "Finished intra-procedural analysis.\n"); 
+      if (profile_impl::profiler *prof = getProfiler()) {
+	prof->setDomain(m_fun, params.abs_dom_to_str());
+      }
+      // the analyzer of the blocks refined by the backward analysis
+      auto analyzerOf = [&](basic_block_label_t bl) -> intra_analyzer_t& {
+	return (cone_analyzer_ptr && cone.count(bl) ? *cone_analyzer_ptr : analyzer);
+      };
 
       // -- store invariants
       if (params.store_invariants || params.print_invars) {
 	CRAB_VERBOSE_IF(1, get_crab_os() << "Storing invariants.\n");       
-	for (basic_block_label_t bl: boost::make_iterator_range(m_cfg->label_begin(),
-								m_cfg->label_end())) {
+	profile_impl::scoped_phase phase(m_state, m_fun, "storage");
+	typedef lazy_impl::analyzer_wrapper<intra_analyzer_t> lazy_wrapper_t;
+	typedef lazy_impl::post_wrapper<Dom> post_wrapper_t;
+	typedef lazy_impl::spilled_wrapper<Dom> spilled_wrapper_t;
+	auto id = mkGenericAbsDomWrapper(Dom::top())->getId();
+	lazy_impl::hash_cons_table<Dom> table;
+	const bool scoped = CrabBoxesScoped && lazy_impl::is_ldd_domain<Dom>::value;
+	auto mkWrapper = [&table, id, scoped](const Dom &absval) -> wrapper_dom_ptr {
+	  if (scoped) return boost::make_shared<lazy_impl::csts_wrapper<Dom>>(id, absval);
+	  return (CrabShareInvariants ? table.get(absval) : mkGenericAbsDomWrapper(absval));
+	};
+	loop_stats_impl::block_size_map_t block_sizes;
+	std::vector<var_t> stat_vars;
+	if (params.stats && !CrabStatsConstraints) {
+	  stat_vars = size_stats_impl::getVariables(cfg_ref_t(*m_cfg));
+	}
+	std::vector<basic_block_label_t> labels(m_cfg->label_begin(), m_cfg->label_end());
+	// -- with delta storage, the blocks are visited in preorder of
+	//    the dominator tree so the parent of each block is stored first
+	typedef lazy_impl::delta_wrapper<Dom> delta_wrapper_t;
+	boost::shared_ptr<lazy_impl::delta_store> delta_store;
+	boost::shared_ptr<lazy_impl::spill_store> spill_store;
+	DominatorTree DT;
+	DenseMap<const BasicBlock*, unsigned> delta_records;
+	if (params.invariants_storage == DELTA_STORAGE) {
+	  delta_store = boost::make_shared<lazy_impl::delta_store>();
+	  DT.recalculate(m_fun);
+	  DenseMap<const BasicBlock*, unsigned> preorder;
+	  for (auto N: depth_first(DT.getRootNode())) {
+	    unsigned i = preorder.size();
+	    preorder[N->getBlock()] = i;
+	  }
+	  auto key = [&preorder](const basic_block_label_t &bl) {
+	    auto it = preorder.find(bl.get_basic_block());
+	    return (it == preorder.end() ? UINT_MAX : it->second);
+	  };
+	  std::stable_sort(labels.begin(), labels.end(),
+			   [&key](const basic_block_label_t &bl1, const basic_block_label_t &bl2) {
+			     return key(bl1) < key(bl2);
+			   });
+	}
+	for (basic_block_label_t bl: labels) {
 	  const BasicBlock *B = bl.get_basic_block();
 	  if (!B) continue; // we only store those which correspond to llvm basic blocks
+
+	  // the cone analyzer does not outlive this function
+	  if (params.invariants_storage == LAZY_STORAGE && !cone_analyzer_ptr) {
+	    update(results.premap, *B,
+		   boost::make_shared<lazy_wrapper_t>(id, m_cfg, analyzer_ptr, bl, true));
+	    update(results.postmap, *B,
+		   boost::make_shared<lazy_wrapper_t>(id, m_cfg, analyzer_ptr, bl, false));
+	    if (!params.stats && !getProfiler()) continue;
+	  }
 	  
 	  // --- invariants that hold at the entry of the blocks
-	  auto pre = analyzer.get_pre (bl);
-	  update(results.premap, *B,  mkGenericAbsDomWrapper(pre));
-	  // --- invariants that hold at the exit of the blocks
-	  auto post = analyzer.get_post (bl);
-	  update(results.postmap, *B,  mkGenericAbsDomWrapper(post));	
+	  auto pre = analyzerOf(bl).get_pre (bl);
+	  if (params.invariants_storage == DELTA_STORAGE) {
+	    // -- the closest dominator already stored
+	    int parent = -1;
+	    if (DomTreeNode *N = DT.getNode(const_cast<BasicBlock*>(B))) {
+	      for (N = N->getIDom(); N; N = N->getIDom()) {
+		auto it = delta_records.find(N->getBlock());
+		if (it != delta_records.end()) {
+		  parent = it->second;
+		  break;
+		}
+	      }
+	    }
+	    unsigned record = delta_store->add(parent, pre.to_linear_constraint_system());
+	    delta_records[B] = record;
+	    wrapper_dom_ptr pre_ptr = boost::make_shared<delta_wrapper_t>(id, delta_store, record);
+	    update(results.premap, *B, pre_ptr);
+	    update(results.postmap, *B, boost::make_shared<post_wrapper_t>(pre_ptr, m_cfg, bl));
+	  } else if (params.invariants_storage == SPILL_STORAGE) {
+	    if (!spill_store) {
+	      spill_store = getSpillStore(params);
+	    }
+	    update(results.premap, *B, boost::make_shared<spilled_wrapper_t>(id, spill_store, pre));
+	    update(results.postmap, *B,
+		   boost::make_shared<spilled_wrapper_t>(id, spill_store,
+							     analyzerOf(bl).get_post (bl)));
+	  } else if (params.invariants_storage != LAZY_STORAGE || cone_analyzer_ptr) {
+	    wrapper_dom_ptr pre_ptr = mkWrapper(pre);
+	    update(results.premap, *B, pre_ptr);
+	    // --- invariants that hold at the exit of the blocks
+	    if (params.invariants_storage == PRE_ONLY_STORAGE) {
+	      update(results.postmap, *B,
+		     boost::make_shared<post_wrapper_t>(pre_ptr, m_cfg, bl));
+	    } else {
+	      auto post = analyzerOf(bl).get_post (bl);
+	      update(results.postmap, *B, mkWrapper(post));
+	    }
+	  }
+	  if (profile_impl::profiler *prof = getProfiler()) {
+	    prof->addSize(m_fun, pre.to_linear_constraint_system().size());
+	  }
 	  if (params.stats) {
-	    unsigned num_block_invars = 0;
-	    // XXX: for boxes it would be more useful to get a measure
-	    // from to_disjunctive_linear_constraint_system() but it
-	    // can be really slow. 
-	    num_block_invars += pre.to_linear_constraint_system().size();
-	    num_invars += num_block_invars;
-	    if (num_block_invars > 0) num_nontrivial_blocks++;
+	    unsigned num_block_invars = size_stats_impl::getSize(pre, stat_vars);
+	    count_stat("CrabLlvm.count.invariants_size", num_block_invars);
+	    if (num_block_invars > 0) count_stat("CrabLlvm.count.nontrivial_blocks");
+	    block_sizes[B] = num_block_invars;
 	  }
 	}
+	if (params.stats) {
+	  loop_stats_impl::print(m_fun, block_sizes);
+	}
 	CRAB_VERBOSE_IF(1, get_crab_os() << "All invariants stored.\n");
       }
       
@@ -710,6 +1568,7 @@ namespace crab_llvm {
 	  (params.print_preconds && params.run_backward) ||
 	  params.print_unjustified_assumptions) {
 
+	profile_impl::scoped_phase phase(m_state, m_fun, "printing");
 	typedef pretty_printer_impl::block_annotation block_annotation_t;
 	typedef pretty_printer_impl::invariant_annotation inv_annotation_t;
 	typedef pretty_printer_impl::nec_precondition_annotation<intra_analyzer_t> pre_annotation_t;
@@ -727,8 +1586,11 @@ namespace crab_llvm {
 					     params.keep_shadow_vars));
 	}
 
-	if (params.print_preconds && params.run_backward) {
-	  pool_annotations.emplace_back(make_unique<pre_annotation_t>(analyzer));
+	// -- with --crab-backward-cone the preconditions are computed
+	//    only if some check is not proven and only for the cone
+	if (params.print_preconds && params.run_backward && (!use_cone || cone_analyzer_ptr)) {
+	  pool_annotations.emplace_back(make_unique<pre_annotation_t>
+					(cone_analyzer_ptr ? *cone_analyzer_ptr : analyzer));
 	}
 
 	// XXX: it must be alive when print_annotations is called.
@@ -751,33 +1613,205 @@ namespace crab_llvm {
       if (params.check) {
 	// --- checking assertions and collecting data
 	CRAB_VERBOSE_IF(1, get_crab_os() << "Checking assertions ... \n"); 
-	typename intra_checker_t::prop_checker_ptr
-	  prop (new assert_prop_t (params.check_verbose));
-	if (params.check == NULLITY)
-	  prop.reset (new null_prop_t(params.check_verbose));
-	intra_checker_t checker (analyzer, {prop});
-	checker.run ();
-	CRAB_VERBOSE_IF(1,
-			llvm::outs() << "Function " << m_fun.getName() << "\n";
-			checker.show (crab::outs()));
-	results.checksdb += checker.get_all_checks();
-	CRAB_VERBOSE_IF(1, get_crab_os() << "Finished assert checking.\n");      
+	profile_impl::scoped_phase phase(m_state, m_fun, "checker");
+	arena_scope arena(CrabArena);
+	CRAB_VERBOSE_IF(1, llvm::outs() << "Function " << m_fun.getName() << "\n");
+	if (cone_analyzer_ptr) {
+	  // -- the checks outside of the cone were already proven
+	  for (auto &kv: cone_proven) {
+	    if (cone.count(kv.first)) continue;
+	    for (auto &c: kv.second) {
+	      results.checksdb.add(c.first, c.second);
+	    }
+	  }
+	  mergeChecks(results.checksdb, cone_analyzer_ptr->check(false, params.check_verbose,
+								 CrabCheckAssertingBlocks));
+	} else {
+	  mergeChecks(results.checksdb, analyzer.check(params.check == NULLITY,
+						       params.check_verbose,
+						       CrabCheckAssertingBlocks));
+	}
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Finished assert checking.\n");      
       }
 
       
       return;
     }
 
+    /*
+     * Re-analysis seeded with the invariants of a previous run
+     * computed under weaker assumptions. The previous invariants are
+     * a post-fixpoint of the new equations so they are refined by a
+     * bounded number of descending iterations (no widening is
+     * needed). Only blocks reachable from the changed ones can
+     * shrink; the others keep their invariants.
+     *
+     * Return false if the previous invariants cannot be reused.
+     */
+    template<typename Dom>
+    bool warmAnalyzeCfg(const AnalysisParams &params,
+			const assumption_map_t &assumptions,
+			const std::vector<const BasicBlock*> &changed,
+			InvarianceAnalysisResults &results) {
+      typedef crab::analyzer::intra_abs_transformer<Dom> abs_tr_t;
+      typedef boost::unordered_map<basic_block_label_t, Dom> dom_map_t;
+
+      auto id = mkGenericAbsDomWrapper(Dom::top())->getId();
+      auto lookup = [&](const invariant_map_t &map, const BasicBlock *B, Dom &absval) {
+	auto it = map.find(B);
+	if (it == map.end() || it->second->getId() != id) return false;
+	// the stored invariant can be lazy (--crab-invariants-storage)
+	getAbsDomWrappee(lazy_impl::materialize(it->second), absval);
+	return true;
+      };
+
+      // -- reverse post-order of the blocks reachable from the entry
+      std::vector<basic_block_label_t> rpo;
+      { typedef std::vector<basic_block_label_t> succs_t;
+	auto succs_of = [this](basic_block_label_t bl) {
+	  succs_t res;
+	  for (auto n: boost::make_iterator_range(m_cfg->get_node(bl).next_blocks())) {
+	    res.push_back(n);
+	  }
+	  return res;
+	};
+	boost::unordered_set<basic_block_label_t> visited;
+	std::vector<std::pair<basic_block_label_t, succs_t>> stack;
+	visited.insert(m_cfg->entry());
+	stack.push_back(std::make_pair(m_cfg->entry(), succs_of(m_cfg->entry())));
+	while (!stack.empty()) {
+	  if (stack.back().second.empty()) {
+	    rpo.push_back(stack.back().first);
+	    stack.pop_back();
+	    continue;
+	  }
+	  basic_block_label_t n = stack.back().second.back();
+	  stack.back().second.pop_back();
+	  if (visited.insert(n).second) {
+	    stack.push_back(std::make_pair(n, succs_of(n)));
+	  }
+	}
+	std::reverse(rpo.begin(), rpo.end());
+      }
+
+      // -- blocks whose invariants can change
+      boost::unordered_set<basic_block_label_t> dirty;
+      { std::vector<basic_block_label_t> worklist;
+	for (const BasicBlock *B: changed) {
+	  basic_block_label_t bl(B);
+	  if (dirty.insert(bl).second) worklist.push_back(bl);
+	}
+	while (!worklist.empty()) {
+	  basic_block_label_t bl = worklist.back();
+	  worklist.pop_back();
+	  for (auto n: boost::make_iterator_range(m_cfg->get_node(bl).next_blocks())) {
+	    if (dirty.insert(n).second) worklist.push_back(n);
+	  }
+	}
+      }
+
+      // -- assumptions at the entry of the dirty blocks
+      dom_map_t crab_assumptions;
+      for (auto &kv: assumptions) {
+	basic_block_label_t bl(kv.first);
+	if (!dirty.count(bl)) continue;
+	Dom absval = Dom::top();
+	absval += kv.second;
+	crab_assumptions.insert(std::make_pair(bl, std::move(absval)));
+      }
+
+      auto transfer = [this](basic_block_label_t bl, Dom absval) {
+	abs_tr_t vis(&absval);
+	for (auto &s: m_cfg->get_node(bl)) {
+	  s.accept(&vis);
+	}
+	return absval;
+      };
+      auto join_preds = [&](basic_block_label_t bl, dom_map_t &post) {
+	Dom res = (bl == m_cfg->entry() ? Dom::top() : Dom::bottom());
+	for (auto p: boost::make_iterator_range(m_cfg->get_node(bl).prev_blocks())) {
+	  auto it = post.find(p);
+	  if (it != post.end()) res |= it->second;
+	}
+	return res;
+      };
+
+      // -- initial values: the previous invariants. Blocks added by
+      //    CfgBuilder between llvm blocks have no stored invariants
+      //    so they are recomputed from their predecessors.
+      dom_map_t pre, post;
+      for (auto bl: rpo) {
+	if (const BasicBlock *B = bl.get_basic_block()) {
+	  Dom pre_val, post_val;
+	  if (!lookup(results.premap, B, pre_val) || !lookup(results.postmap, B, post_val)) {
+	    return false;
+	  }
+	  pre.insert(std::make_pair(bl, std::move(pre_val)));
+	  post.insert(std::make_pair(bl, std::move(post_val)));
+	} else {
+	  Dom pre_val = join_preds(bl, post);
+	  post.insert(std::make_pair(bl, transfer(bl, pre_val)));
+	  pre.insert(std::make_pair(bl, std::move(pre_val)));
+	}
+      }
+
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Running warm-started analysis with "
+		                       << "\"" << Dom::getDomainName () << "\" for "
+		                       << m_fun.getName() << " (" << dirty.size() << "/"
+		                       << rpo.size() << " blocks to refine) ...\n";);
+      
+      // -- descending iterations over the dirty blocks. All iterates
+      //    are sound so we can stop at any point.
+      { profile_impl::scoped_phase phase(m_state, m_fun, "forward");
+	unsigned num_iters = std::max(1U, params.narrowing_iters);
+	for (unsigned i = 0; i < num_iters; ++i) {
+	  bool change = false;
+	  for (auto bl: rpo) {
+	    if (!dirty.count(bl)) continue;
+	    Dom new_pre = join_preds(bl, post);
+	    auto it = crab_assumptions.find(bl);
+	    if (it != crab_assumptions.end()) {
+	      new_pre = new_pre & it->second;
+	    }
+	    Dom &old_pre = pre[bl];
+	    if (bl.get_basic_block()) {
+	      // the meet ensures the sequence is decreasing
+	      new_pre = new_pre & old_pre;
+	    }
+	    if (!(old_pre <= new_pre)) {
+	      change = true;
+	    }
+	    post[bl] = transfer(bl, new_pre);
+	    old_pre = std::move(new_pre);
+	  }
+	  if (!change) break;
+	}
+      }
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Finished warm-started analysis.\n");
+      
+      // -- store invariants
+      { profile_impl::scoped_phase phase(m_state, m_fun, "storage");
+	for (auto bl: rpo) {
+	  const BasicBlock *B = bl.get_basic_block();
+	  if (!B || !dirty.count(bl)) continue;
+	  update(results.premap, *B, mkGenericAbsDomWrapper(pre[bl]));
+	  update(results.postmap, *B, mkGenericAbsDomWrapper(post[bl]));
+	}
+      }
+      return true;
+    }
+
     template<typename AbsDom>
     void wrapperPathAnalyze(const std::vector<llvm_basic_block_wrapper>& path,
 			    std::vector<crab::cfg::statement_wrapper>& core,
 			    bool layered_solving, bool populate_maps,
-			    invariant_map_t& post, invariant_map_t& pre, bool &res) {
+			    invariant_map_t& post, invariant_map_t& pre, bool &res) const {
       
       typedef path_analyzer<cfg_ref_t, AbsDom> path_analyzer_t;
       AbsDom init;
-      path_analyzer_t path_analyzer(*m_cfg, init);
+      path_analyzer_t path_analyzer(*m_cfg, init, true, getSuccessorIndex());
       bool compute_preconditions = populate_maps;
+      arena_scope arena(CrabArena);
       res = path_analyzer.solve(path, layered_solving, compute_preconditions);
       if (populate_maps) {
 	for(auto n: path) {
@@ -814,154 +1848,772 @@ namespace crab_llvm {
         
     
     struct intra_analysis {
-      std::function<void(const AnalysisParams&,
-			 const BasicBlock*,
-			 const assumption_map_t&,
-			 liveness_t*,
-			 InvarianceAnalysisResults&)> analyze;
-      std::string name;
+      void (IntraCrabLlvm_Impl::*analyze)(const AnalysisParams&,
+					  const BasicBlock*,
+					  const assumption_map_t&,
+					  const IntraCrabLlvm::domain_assumptions*,
+					  liveness_t*,
+					  InvarianceAnalysisResults&);
+      const char *name;
     };
 
     struct path_analysis {
-      std::function<void(const std::vector<llvm_basic_block_wrapper>&,
-			 std::vector<crab::cfg::statement_wrapper>&,
-			 bool, bool, invariant_map_t&, invariant_map_t&,bool&)> analyze;
-      std::string name;
+      void (IntraCrabLlvm_Impl::*analyze)(const std::vector<llvm_basic_block_wrapper>&,
+					  std::vector<crab::cfg::statement_wrapper>&,
+					  bool, bool, invariant_map_t&, invariant_map_t&,
+					  bool&) const;
+      const char *name;
     };
     
-    // Domains used for intra-procedural analysis
-    const std::map<CrabDomain, intra_analysis> intra_analyses {
-      { INTERVALS               , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<interval_domain_t>), "classical intervals" } } 
-      #ifdef HAVE_ALL_DOMAINS	
-      , { INTERVALS_CONGRUENCES , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<ric_domain_t>), "reduced product of intervals and congruences" }}
-      , { DIS_INTERVALS         , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<dis_interval_domain_t>), "disjunctive intervals" }}
-      , { TERMS_INTERVALS       , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<term_int_domain_t>), "terms with intervals" }}
-      #endif 	
-      , { WRAPPED_INTERVALS     , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<wrapped_interval_domain_t>), "wrapped intervals" }}
-      , { ZONES_SPLIT_DBM       , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<split_dbm_domain_t>), "zones" }}
-      , { BOXES                 , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<boxes_domain_t>), "boxes" }}
-      , { OCT                   , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<oct_domain_t>), "octagons" }}
-      , { PK                    , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<pk_domain_t>), "polyhedra" }}
-      , { TERMS_ZONES           , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<num_domain_t>), "terms with zones" }}
-      , { TERMS_DIS_INTERVALS   , { bind_this(this, &IntraCrabLlvm_Impl::analyzeCfg<term_dis_int_domain_t>), "terms with disjunctive intervals" }}
-    };
-
+    // Domains used for intra-procedural analysis. The entries are
+    // constants shared by all functions. Return null if the domain
+    // is not enabled.
+    static const intra_analysis* getIntraAnalysis(CrabDomain dom) {
+      typedef IntraCrabLlvm_Impl T;
+      static const intra_analysis intervals =
+	{ &T::analyzeCfg<interval_domain_t>, "classical intervals" };
+      static const intra_analysis dense_intervals =
+	{ &T::analyzeCfg<dense_interval_domain_t>, "dense intervals" };
+      static const intra_analysis wrapped_intervals_fast =
+	{ &T::analyzeCfg<wrapped_interval_fast_domain_t>, "native wrapped intervals" };
+      static const intra_analysis ptr_offsets =
+	{ &T::analyzeCfg<offset_pointer_domain_t>, "offset pointers" };
+      #ifdef HAVE_ALL_DOMAINS
+      static const intra_analysis ric =
+	{ &T::analyzeCfg<ric_domain_t>, "reduced product of intervals and congruences" };
+      static const intra_analysis dis_intervals =
+	{ &T::analyzeCfg<dis_interval_domain_t>, "disjunctive intervals" };
+      static const intra_analysis term_intervals =
+	{ &T::analyzeCfg<term_int_domain_t>, "terms with intervals" };
+      #endif
+      static const intra_analysis wrapped_intervals =
+	{ &T::analyzeCfg<wrapped_interval_domain_t>, "wrapped intervals" };
+      static const intra_analysis zones =
+	{ &T::analyzeCfg<split_dbm_domain_t>, "zones" };
+      static const intra_analysis zones_fast =
+	{ &T::analyzeCfg<split_dbm_fast_domain_t>, "zones with int64 weights" };
+      static const intra_analysis zones_dense =
+	{ &T::analyzeCfg<dense_dbm_domain_t>, "zones with dense DBMs" };
+      static const intra_analysis boxes =
+	{ &T::analyzeCfg<boxes_domain_t>, "boxes" };
+      static const intra_analysis oct =
+	{ &T::analyzeCfg<oct_domain_t>, "octagons" };
+      static const intra_analysis pk =
+	{ &T::analyzeCfg<pk_domain_t>, "polyhedra" };
+      static const intra_analysis term_zones =
+	{ &T::analyzeCfg<num_domain_t>, "terms with zones" };
+      static const intra_analysis term_dis_intervals =
+	{ &T::analyzeCfg<term_dis_int_domain_t>, "terms with disjunctive intervals" };
+      
+      switch (dom) {
+      case INTERVALS:             return &intervals;
+      case DENSE_INTERVALS:       return &dense_intervals;
+      case WRAPPED_INTERVALS_FAST: return &wrapped_intervals_fast;
+      case PTR_OFFSETS:           return &ptr_offsets;
+      #ifdef HAVE_ALL_DOMAINS
+      case INTERVALS_CONGRUENCES: return &ric;
+      case DIS_INTERVALS:         return &dis_intervals;
+      case TERMS_INTERVALS:       return &term_intervals;
+      #endif
+      case WRAPPED_INTERVALS:     return &wrapped_intervals;
+      case ZONES_SPLIT_DBM:       return &zones;
+      case ZONES_SPLIT_DBM_FAST:  return &zones_fast;
+      case ZONES_DENSE_DBM:       return &zones_dense;
+      case BOXES:                 return &boxes;
+      case OCT:                   return &oct;
+      case PK:                    return &pk;
+      case TERMS_ZONES:           return &term_zones;
+      case TERMS_DIS_INTERVALS:   return &term_dis_intervals;
+      default:                    return nullptr;
+      }
+    }
 
-    // Domains used for path-based analysis
-    const std::map<CrabDomain, path_analysis> path_analyses {
-      { INTERVALS               , { bind_this(this, &IntraCrabLlvm_Impl::wrapperPathAnalyze<interval_domain_t>), "classical intervals" } } 
-      #ifdef HAVE_ALL_DOMAINS	
-      , { TERMS_INTERVALS       , { bind_this(this, &IntraCrabLlvm_Impl::wrapperPathAnalyze<term_int_domain_t>), "terms with intervals" }}
-      #endif 	
-      , { WRAPPED_INTERVALS     , { bind_this(this, &IntraCrabLlvm_Impl::wrapperPathAnalyze<wrapped_interval_domain_t>), "wrapped intervals" }}
-      , { ZONES_SPLIT_DBM       , { bind_this(this, &IntraCrabLlvm_Impl::wrapperPathAnalyze<split_dbm_domain_t>), "zones" }}
-      , { BOXES                  , { bind_this(this, &IntraCrabLlvm_Impl::wrapperPathAnalyze<boxes_domain_t>), "boxes" }}      
-      , { TERMS_ZONES           , { bind_this(this, &IntraCrabLlvm_Impl::wrapperPathAnalyze<num_domain_t>), "terms with zones" }}
+    // Domains used for path-based analysis. Return null if the
+    // domain is not enabled.
+    static const path_analysis* getPathAnalysisOrNull(CrabDomain dom) {
+      typedef IntraCrabLlvm_Impl T;
+      static const path_analysis intervals =
+	{ &T::wrapperPathAnalyze<interval_domain_t>, "classical intervals" };
+      static const path_analysis dense_intervals =
+	{ &T::wrapperPathAnalyze<dense_interval_domain_t>, "dense intervals" };
+      static const path_analysis wrapped_intervals_fast =
+	{ &T::wrapperPathAnalyze<wrapped_interval_fast_domain_t>, "native wrapped intervals" };
+      static const path_analysis ptr_offsets =
+	{ &T::wrapperPathAnalyze<offset_pointer_domain_t>, "offset pointers" };
+      #ifdef HAVE_ALL_DOMAINS
+      static const path_analysis term_intervals =
+	{ &T::wrapperPathAnalyze<term_int_domain_t>, "terms with intervals" };
+      #endif
+      static const path_analysis wrapped_intervals =
+	{ &T::wrapperPathAnalyze<wrapped_interval_domain_t>, "wrapped intervals" };
+      static const path_analysis zones =
+	{ &T::wrapperPathAnalyze<split_dbm_domain_t>, "zones" };
+      static const path_analysis boxes =
+	{ &T::wrapperPathAnalyze<boxes_domain_t>, "boxes" };
+      static const path_analysis term_zones =
+	{ &T::wrapperPathAnalyze<num_domain_t>, "terms with zones" };
       /* 
 	 To add new domains here make sure you add an explicit
 	 instantiation in crab/path_analyzer.cc 
       */
-      //, { TERMS_DIS_INTERVALS , { bind_this(this, &IntraCrabLlvm_Impl::wrapperPathAnalyze<term_dis_int_domain_t>), "terms with disjunctive intervals" }}
-    };
+      
+      switch (dom) {
+      case INTERVALS:         return &intervals;
+      case DENSE_INTERVALS:   return &dense_intervals;
+      case WRAPPED_INTERVALS_FAST: return &wrapped_intervals_fast;
+      case PTR_OFFSETS:           return &ptr_offsets;
+      #ifdef HAVE_ALL_DOMAINS
+      case TERMS_INTERVALS:   return &term_intervals;
+      #endif
+      case WRAPPED_INTERVALS: return &wrapped_intervals;
+      case ZONES_SPLIT_DBM:   return &zones;
+      case BOXES:             return &boxes;
+      case TERMS_ZONES:       return &term_zones;
+      default:                return nullptr;
+      }
+    }
 
-  public:
-    
-    IntraCrabLlvm_Impl(Function &fun,
-		       crab::cfg::tracked_precision cfg_precision,
-		       heap_abs_ptr mem, llvm_variable_factory &vfac,
-		       CfgManager &cfg_man, const TargetLibraryInfo &tli)
-		       
-      : m_cfg(nullptr), m_fun(fun), m_vfac(vfac) {
+    // build m_cfg and add it to m_cfg_man
+    void buildCfg() {
       CRAB_VERBOSE_IF(1, get_crab_os() << "Started Crab CFG construction for "
-		                       << fun.getName() << "\n");
+		                       << m_fun.getName() << "\n");
       if (isTrackable(m_fun)) {
 	// -- build a crab cfg for func
-	CfgBuilder builder(m_fun, m_vfac, *mem, cfg_precision, true, &tli);
-	m_cfg = builder.get_cfg();
-	m_edge_bb_map = builder.getEdgeToBBMap();
-	cfg_man.add(fun, m_cfg);
+	profile_impl::scoped_phase phase(m_state, m_fun, "cfg");
+	bool loop_order = (CrabFixpointThreads > 1 || CrabSparse || CrabAdaptiveFixpoint ||
+			   CrabAccelerateLoops);
+	m_cfg.reset(buildIntraCfg(m_fun, m_vfac, *m_mem, m_cfg_precision, m_tli,
+				  loop_order ? &m_loop_order : nullptr, &m_edge_bb_map));
+	m_cfg_man.add(m_fun, m_cfg);
+	if (profile_impl::profiler *prof = getProfiler()) {
+	  size_t blocks = 0, stmts = 0;
+	  for (auto &b: *m_cfg) {
+	    blocks++;
+	    stmts += b.size();
+	  }
+	  prof->addCfgSize(m_fun, blocks, stmts);
+	}
 	CRAB_VERBOSE_IF(1, get_crab_os() << "Finished Crab CFG construction for "
-			                 << fun.getName() << "\n");	
+			                 << m_fun.getName() << "\n");	
 	  
       } else {
 	CRAB_VERBOSE_IF(1, llvm::outs() << "Cannot build CFG for "
-			                << fun.getName() << "\n");
+			                << m_fun.getName() << "\n");
+      }
+    }
+
+  public:
+    
+    // If defer_cfg then the cfg is built by IncrementalAnalyze or
+    // CachedAnalyze only if their results cannot be reused.
+    IntraCrabLlvm_Impl(Function &fun,
+		       crab::cfg::tracked_precision cfg_precision,
+		       heap_abs_ptr mem, llvm_variable_factory &vfac,
+		       CfgManager &cfg_man, const TargetLibraryInfo &tli,
+		       const ModuleState *state = nullptr, bool defer_cfg = false)
+      : m_fun(fun), m_vfac(vfac), m_cfg_precision(cfg_precision), m_mem(mem),
+	m_cfg_man(cfg_man), m_tli(tli), m_state(state), m_is_private(false),
+	m_is_sliced(false), m_is_discharged(false), m_all_discharged(false) {
+      if (!defer_cfg) {
+	buildCfg();
       }
     }
 
+    // Replace m_cfg with a copy the first time it is modified. The
+    // cfg of CfgManager is used after the analysis (e.g., by
+    // InsertInvariants, to print it or to rebuild it once evicted)
+    // so it must keep all its statements.
+    void makeCfgPrivate() {
+      if (m_is_private) return;
+      m_is_private = true;
+      m_cfg = boost::make_shared<cfg_t>(m_cfg->clone());
+    }
+    
+    // Remove from m_cfg the checks and statements that the analysis
+    // does not need. It is the only modification of m_cfg done by
+    // Analyze and it is done on a private copy.
+    void prepareCfg(const AnalysisParams &params) {
+      // -- only the assertion of --crab-check-only is checked
+      if (check_only_impl::enabled() && m_state &&
+	  params.check != NOCHECKS && !m_is_sliced) {
+	makeCfgPrivate();
+	m_state->check_only.removeOtherChecks(*m_cfg);
+      }
+      // -- the assertions decided by constant propagation are not
+      //    checked by the analysis
+      if (CrabDischargeTrivialChecks && params.check == ASSERTION && !m_is_discharged) {
+	profile_impl::scoped_phase phase(m_state, m_fun, "discharge");
+	m_is_discharged = true;
+	makeCfgPrivate();
+	m_all_discharged = trivial_impl::discharge(*m_cfg, m_discharged, params.check_verbose);
+      }
+      // -- remove statements that cannot affect the checks. The
+      //    invariants are still sound but they say nothing about
+      //    the removed statements.
+      if ((CrabSliceChecks || check_only_impl::enabled()) &&
+	  params.check != NOCHECKS && !params.print_invars && !m_is_sliced) {
+	profile_impl::scoped_phase phase(m_state, m_fun, "slicing");
+	m_is_sliced = true;
+	makeCfgPrivate();
+	unsigned num_removed = slicing_impl::slice(*m_cfg);
+	count_stat("CrabLlvm.count.sliced_stmts", num_removed);
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Removed " << num_removed
+			                 << " statements irrelevant for the checks of "
+			                 << m_fun.getName() << "\n";);
+      }
+    }
+    
+    // Print the crab CFG of the function (if any)
+    std::string cfgToStr() const {
+      crab::crab_string_os o;
+      if (m_cfg) o << *m_cfg;
+      return o.str();
+    }
+
+    // Record a reproducer if the analysis of the function took at
+    // least --crab-extract-slow milliseconds since start.
+    void recordIfSlow(const AnalysisParams &params,
+		      std::chrono::steady_clock::time_point start) const {
+      if (!m_state || !m_state->reproducers || !m_cfg) return;
+      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>
+	(std::chrono::steady_clock::now() - start).count();
+      if (ms < CrabExtractSlow) return;
+      m_state->reproducers->add(m_fun, ms, params, cfgToStr());
+    }
+
     void Analyze(AnalysisParams &params,
 		 const llvm::BasicBlock *entry,
 		 const assumption_map_t &assumptions,
-		 InvarianceAnalysisResults &results) {
+		 InvarianceAnalysisResults &results,
+		 const IntraCrabLlvm::domain_assumptions *dom_assumptions = nullptr) {
 
       if (!m_cfg) {
 	CRAB_VERBOSE_IF(1, llvm::outs() << "Skipped analysis for "
 			                << m_fun.getName() << "\n");
 	return;
       }
+
+      if (params.is_cancelled()) return;
+      
+      prepareCfg(params);
+
+      if (m_is_discharged && params.check == ASSERTION) {
+	checks_db_t discharged(m_discharged);
+	mergeChecks(results.checksdb, std::move(discharged));
+	// -- nothing else to check
+	if (m_all_discharged && !params.print_invars) {
+	  count_stat("CrabLlvm.count.discharged_functions");
+	  return;
+	}
+      }
+
+      // -- only the nullity of the pointers is needed
+      if (params.check == NULLITY && CrabCheckNullFast && !CrabBuildOnlyCFG) {
+	profile_impl::scoped_phase phase(m_state, m_fun, "checker");
+	nullity_impl::null_dataflow<cfg_ref_t> null_df(*m_cfg);
+	mergeChecks(results.checksdb, null_df.check(params.check_verbose));
+	count_stat("CrabLlvm.count.null_dataflow_functions");
+	return;
+      }
       
-      // -- run liveness
+      // -- run liveness. It is also used to choose the domain if
+      //    relational unless it is estimated on the LLVM function
+      //    (--crab-relational-threshold-estimate).
+      bool is_relational = isRelationalDomain(params.dom);
+      // -- the cost of closure and join of oct and pk grows with the
+      //    number of dimensions of their states, which only shrinks
+      //    when variables are forgotten (--crab-live-compact)
+      bool compact = CrabLiveCompact && (params.dom == OCT || params.dom == PK);
+      bool use_live = (params.run_liveness || (is_relational && CrabReuseLiveness) ||
+		       compact);
       liveness_t live(*m_cfg);
-      if (params.run_liveness || isRelationalDomain(params.dom)) {
+      unsigned max_live_per_blk = 0;
+      if (use_live || (is_relational && !CrabRelationalThresholdEstimate)) {
 	CRAB_VERBOSE_IF(1,
 			auto fdecl = m_cfg->get_func_decl ();            
 			assert (fdecl);
 			get_crab_os() << "Running liveness analysis for " 
 			              << (*fdecl).get_func_name ()
 		                      << "  ...\n";);
-	live.exec ();
+	{ profile_impl::scoped_phase phase(m_state, m_fun, "liveness");
+	  live.exec ();
+	}
 	CRAB_VERBOSE_IF(1, get_crab_os() << "Finished liveness analysis.\n");
 	// some stats
-	unsigned total_live, avg_live_per_blk, max_live_per_blk;
+	unsigned total_live, avg_live_per_blk;
 	live.get_stats (total_live, max_live_per_blk, avg_live_per_blk);
 	CRAB_VERBOSE_IF(1, 
 		  crab::outs() << "-- Max number of out live vars per block=" 
                                << max_live_per_blk << "\n"
                                << "-- Avg number of out live vars per block=" 
                                << avg_live_per_blk << "\n";);
-	crab::CrabStats::count_max ("Liveness.count.maxOutVars",
-				    max_live_per_blk);
+	count_max_stat("Liveness.count.maxOutVars", max_live_per_blk);
+      } else if (is_relational && !params.relational_threshold_loops) {
+	max_live_per_blk = adaptive_impl::maxLiveOut(m_fun, false);
+      }
+      
+      if (is_relational) {
+	if (params.relational_threshold_loops) {
+	  max_live_per_blk = adaptive_impl::maxLiveInLoops(m_fun);
+	}
+	if (params.relational_threshold_packs && isSparseRelationalDomain(params.dom)) {
+	  unsigned max_pack = adaptive_impl::maxPackSize(m_fun);
+	  CRAB_VERBOSE_IF(1, crab::outs() << "Max pack size: " << max_pack << "\n");
+	  max_live_per_blk = std::min(max_live_per_blk, max_pack);
+	}
+	CRAB_VERBOSE_IF(1, 
+		  crab::outs() << "Max live per block"
+		               << (params.relational_threshold_loops ? " in loops: " : ": ")
+		               << max_live_per_blk << "\n"
+		               << "Threshold: "
+		               << params.relational_threshold << "\n");
+	if (max_live_per_blk > params.relational_threshold) {
+	  // default domain
+	  params.dom = INTERVALS;
+	}
+      }
 
-	if (isRelationalDomain(params.dom)) {
-	  CRAB_VERBOSE_IF(1, 
-		    crab::outs() << "Max live per block: "
-		                 << max_live_per_blk << "\n"
-		                 << "Threshold: "
-		                 << params.relational_threshold << "\n");
-	  if (max_live_per_blk > params.relational_threshold) {
-	    // default domain
-	    params.dom = INTERVALS;
-	  }
+      CrabDomain base_dom;
+      if (CrabTermsMax > 0 && isTermDomain(params.dom, base_dom)) {
+	unsigned num_terms = adaptive_impl::numTerms(m_fun);
+	CRAB_VERBOSE_IF(1, crab::outs() << "Estimated number of terms: " << num_terms << "\n");
+	if (num_terms > CrabTermsMax) {
+	  count_stat("CrabLlvm.count.terms_max_exceeded");
+	  params.dom = base_dom;
 	}
       }
 
-      if (CrabBuildOnlyCFG) {
+      if (CrabBuildOnlyCFG || params.is_cancelled()) {
 	return;
       }
+
+      if (CrabWideningAutoJumpSet > 0) {
+	// params can be shared by all functions so the automatic jump
+	// set does not accumulate
+	params.widening_jumpset = std::max((unsigned) CrabWideningJumpSet,
+					   adaptive_impl::autoJumpSet(m_fun));
+      }
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Jump set size for widening: "
+		                       << params.widening_jumpset << "\n");
       
-      if (intra_analyses.count(params.dom)) {
-      	intra_analyses.at(params.dom).analyze(params, entry, assumptions,
-					     (params.run_liveness)? &live : nullptr,
-					     results);
-      } else {
+      const intra_analysis *analysis = getIntraAnalysis(params.dom);
+      if (!analysis) {
+      	analysis = getIntraAnalysis(INTERVALS);
       	crab::outs() << "Warning: abstract domain not found or enabled.\n"
-      		     << "Running " << intra_analyses.at(INTERVALS).name << " ...\n"; 
-      	intra_analyses.at(INTERVALS).analyze(params, entry, assumptions,
-					    (params.run_liveness)? &live : nullptr,
-					    results);
+      		     << "Running " << analysis->name << " ...\n"; 
       }
+      trace_domain trace_dom(is_tracing() ? analysis->name : "");
+      (this->*(analysis->analyze))(params, entry, assumptions, dom_assumptions,
+				   use_live ? &live : nullptr,
+				   results);
     }
     
-    bool pathAnalyze(const AnalysisParams& params,
-		     const std::vector<const llvm::BasicBlock*>& blocks,
-		     bool layered_solving, 
-		     std::vector<crab::cfg::statement_wrapper>& core,
-		     bool populate_maps, 
-		     invariant_map_t& post, invariant_map_t& pre) const {
-      assert(m_cfg);
+    // Refine the invariants in results after the assumptions of
+    // changed have been strengthened. Fall back to Analyze if they
+    // cannot be reused.
+    void WarmAnalyze(AnalysisParams &params,
+		     const assumption_map_t &assumptions,
+		     const std::vector<const BasicBlock*> &changed,
+		     InvarianceAnalysisResults &results) {
+      if (!m_cfg) {
+	CRAB_VERBOSE_IF(1, llvm::outs() << "Skipped analysis for "
+			                << m_fun.getName() << "\n");
+	return;
+      }
+      
+      bool done = false;
+      // the checks need the analyzer of a full run and the
+      // invariants must be stored eagerly to be updated.
+      if (params.check == NOCHECKS && !params.run_backward &&
+	  params.invariants_storage == EAGER_STORAGE && !CrabBuildOnlyCFG) {
+	switch (params.dom) {
+	case INTERVALS:             done = warmAnalyzeCfg<interval_domain_t>(params, assumptions, changed, results); break;
+	case DENSE_INTERVALS:       done = warmAnalyzeCfg<dense_interval_domain_t>(params, assumptions, changed, results); break;
+	case WRAPPED_INTERVALS_FAST: done = warmAnalyzeCfg<wrapped_interval_fast_domain_t>(params, assumptions, changed, results); break;
+	case PTR_OFFSETS:           done = warmAnalyzeCfg<offset_pointer_domain_t>(params, assumptions, changed, results); break;
+	#ifdef HAVE_ALL_DOMAINS
+	case INTERVALS_CONGRUENCES: done = warmAnalyzeCfg<ric_domain_t>(params, assumptions, changed, results); break;
+	case DIS_INTERVALS:         done = warmAnalyzeCfg<dis_interval_domain_t>(params, assumptions, changed, results); break;
+	case TERMS_INTERVALS:       done = warmAnalyzeCfg<term_int_domain_t>(params, assumptions, changed, results); break;
+	#endif
+	case WRAPPED_INTERVALS:     done = warmAnalyzeCfg<wrapped_interval_domain_t>(params, assumptions, changed, results); break;
+	case ZONES_SPLIT_DBM:       done = warmAnalyzeCfg<split_dbm_domain_t>(params, assumptions, changed, results); break;
+	case ZONES_SPLIT_DBM_FAST:  done = warmAnalyzeCfg<split_dbm_fast_domain_t>(params, assumptions, changed, results); break;
+	case ZONES_DENSE_DBM:       done = warmAnalyzeCfg<dense_dbm_domain_t>(params, assumptions, changed, results); break;
+	case BOXES:                 done = warmAnalyzeCfg<boxes_domain_t>(params, assumptions, changed, results); break;
+	case OCT:                   done = warmAnalyzeCfg<oct_domain_t>(params, assumptions, changed, results); break;
+	case PK:                    done = warmAnalyzeCfg<pk_domain_t>(params, assumptions, changed, results); break;
+	case TERMS_ZONES:           done = warmAnalyzeCfg<num_domain_t>(params, assumptions, changed, results); break;
+	case TERMS_DIS_INTERVALS:   done = warmAnalyzeCfg<term_dis_int_domain_t>(params, assumptions, changed, results); break;
+	default: break;
+	}
+      }
+      
+      if (!done) {
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Cannot reuse previous invariants of "
+			                 << m_fun.getName() << ": running full analysis.\n");
+	Analyze(params, &m_fun.getEntryBlock(), assumptions, results);
+      } else {
+	count_stat("CrabLlvm.count.warm_analyses");
+	if (params.print_invars) {
+	  printInvariants(params, results);
+	}
+      }
+    }
+    
+    // Print the invariants stored in results for the function
+    void printInvariants(const AnalysisParams &params,
+			 InvarianceAnalysisResults &results) {
+      typedef pretty_printer_impl::block_annotation block_annotation_t;
+      typedef pretty_printer_impl::invariant_annotation inv_annotation_t;
+      std::vector<std::unique_ptr<block_annotation_t>> pool_annotations;
+      if (auto f_decl = m_cfg->get_func_decl()) {
+	crab::outs() << "\n" << *f_decl << "\n";
+      } else {
+	llvm::outs() << "\n" << "function " << m_fun.getName() << "\n";
+      }
+      pool_annotations.emplace_back(
+	   make_unique<inv_annotation_t>(m_vfac, results.premap, results.postmap, 
+					 params.keep_shadow_vars));
+      pretty_printer_impl::print_annotations(*m_cfg, pool_annotations);
+    }
+
+    // Run Analyze in a child process limited by timeout_ms (0: no
+    // limit) and --crab-fn-mem-mb. The child sends back its results
+    // using the format of --crab-incremental. If the child does not
+    // finish, error is set to the reason.
+    child_impl::status_t runInChildProcess(const AnalysisParams &params,
+					   InvarianceAnalysisResults &results,
+					   unsigned timeout_ms, std::string &error) {
+      SmallString<128> file;
+      if (sys::fs::createTemporaryFile("crab-fn", "crab", file)) {
+	error = "cannot create a temporary file";
+	return child_impl::FAILED;
+      }
+      // Analyze can replace m_cfg by a sliced copy
+      cfg_ptr_t cfg = m_cfg;
+      
+      child_impl::status_t status = child_impl::run([&]() {
+	  // invariants are printed by the parent
+	  AnalysisParams child_params(params);
+	  child_params.print_invars = false;
+	  invariant_map_t pre, post;
+	  checks_db_t checks;
+	  InvarianceAnalysisResults child_results = {pre, post, checks};
+	  Analyze(child_params, &m_fun.getEntryBlock(), assumption_map_t(), child_results);
+	  return incremental_impl::store(file.str(), m_fun, *cfg, pre, post, checks);
+	}, timeout_ms, CrabFnMemory, error);
+      count_stat("CrabLlvm.count.child_analyses");
+
+      if (status == child_impl::FINISHED &&
+	  !incremental_impl::load(file.str(), m_fun, params.dom, m_vfac, results)) {
+	error = "cannot read the results of the child process";
+	status = child_impl::FAILED;
+      }
+      sys::fs::remove(file);
+      return status;
+    }
+
+    // Functions smaller than --crab-fn-budget-min-size are not worth
+    // a child process
+    bool isSmall() const {
+      unsigned size = 0;
+      for (auto &B: m_fun) {
+	size += B.size();
+	if (size >= CrabFnBudgetMinSize) return false;
+      }
+      return true;
+    }
+
+    // Analyze the function with --crab-dom=adapt-rtz. The choice of
+    // --crab-relational-threshold is made before the analysis from
+    // the size of the function; this one is made from the cost of the
+    // fixpoint while it runs. Each domain is given
+    // --crab-adapt-cost-ms in a child process and, if it does not
+    // finish, the function is analyzed again with a cheaper domain:
+    // rtz, then term-int (the terms without the zones) and then
+    // intervals.
+    void AdaptiveAnalyze(AnalysisParams &params, InvarianceAnalysisResults &results) {
+      static const CrabDomain cascade[] = { TERMS_ZONES, TERMS_INTERVALS, INTERVALS };
+      const unsigned num_doms = sizeof(cascade) / sizeof(cascade[0]);
+      
+      unsigned timeout_ms = CrabAdaptCost;
+      if (CrabFnTimeout > 0) {
+	timeout_ms = std::min(timeout_ms, (unsigned) CrabFnTimeout);
+      }
+      AnalysisParams adapt_params(params);
+      for (unsigned i = 0; i < num_doms; ++i) {
+	adapt_params.dom = cascade[i];
+	if (!m_cfg || CrabBuildOnlyCFG || isSmall() || i == num_doms - 1) {
+	  Analyze(adapt_params, &m_fun.getEntryBlock(), assumption_map_t(), results);
+	  break;
+	}
+	std::string error;
+	child_impl::status_t status = runInChildProcess(adapt_params, results,
+							timeout_ms, error);
+	if (status == child_impl::FINISHED) {
+	  if (adapt_params.print_invars) {
+	    printInvariants(adapt_params, results);
+	  }
+	  break;
+	} else if (status == child_impl::FAILED) {
+	  // -- the analysis is not run in this process: whatever made
+	  //    the child fail could bring it down
+	  errs() << "Warning: cannot analyze " << m_fun.getName()
+		 << " in a child process (" << error << "). No invariants inferred.\n";
+	  break;
+	}
+	count_stat("CrabLlvm.count.adapt_switches");
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Analysis of " << m_fun.getName()
+			                 << " with " << getIntraAnalysis(cascade[i])->name
+			                 << " exceeded " << timeout_ms << " ms ("
+			                 << error << "). Running "
+			                 << getIntraAnalysis(cascade[i + 1])->name << " ...\n";);
+      }
+    }
+    
+    // Analyze the function within the budget given by
+    // --crab-fn-timeout-ms and --crab-fn-mem-mb. If the budget is
+    // exceeded then the function is analyzed again with intervals.
+    void BoundedAnalyze(AnalysisParams &params, InvarianceAnalysisResults &results) {
+      if (params.dom == ADAPT_TERMS_ZONES) {
+	AdaptiveAnalyze(params, results);
+	return;
+      }
+      
+      if (!m_cfg || !hasFunctionBudget() || CrabBuildOnlyCFG || isSmall()) {
+	Analyze(params, &m_fun.getEntryBlock(), assumption_map_t(), results);
+	return;
+      }
 
-      // build the full path (included internal basic blocks added
-      // during the translation to Crab)
+      std::string error;
+      child_impl::status_t status = runInChildProcess(params, results, CrabFnTimeout, error);
+      if (status == child_impl::FINISHED) {
+	if (params.print_invars) {
+	  printInvariants(params, results);
+	}
+	return;
+      } else if (status == child_impl::FAILED) {
+	// -- not a budget overrun but the analysis is not run in this
+	//    process: whatever made the child fail could bring it down
+	errs() << "Warning: cannot analyze " << m_fun.getName()
+	       << " in a child process (" << error << "). No invariants inferred.\n";
+	return;
+      }
+
+      if (params.dom != INTERVALS) {
+	errs() << "Warning: analysis of " << m_fun.getName()
+	       << " exceeded its budget (" << error << "). Running "
+	       << getIntraAnalysis(INTERVALS)->name << " ...\n";
+	params.dom = INTERVALS;
+	Analyze(params, &m_fun.getEntryBlock(), assumption_map_t(), results);
+      } else {
+	errs() << "Warning: analysis of " << m_fun.getName()
+	       << " exceeded its budget (" << error << "). No invariants inferred.\n";
+      }
+    }
+    
+    // Analyze with cheap domains first (--crab-check-layered). The
+    // function is analyzed again with a more precise domain only if
+    // some assertion could not be proved. The results of the last
+    // run are kept.
+    void LayeredAnalyze(AnalysisParams &params, InvarianceAnalysisResults &results) {
+      const CrabDomain *layers = layered_domains;
+      const unsigned num_layers = sizeof(layered_domains) / sizeof(layered_domains[0]);
+      
+      if (!m_cfg || CrabBuildOnlyCFG || CfgBuilder::num_checks(m_fun) == 0) {
+	Analyze(params, &m_fun.getEntryBlock(), assumption_map_t(), results);
+	return;
+      }
+
+      // -- the layers that were not enough in the previous run are
+      //    skipped (--crab-config-profile)
+      unsigned first = 0;
+      if (m_state && m_state->config_profile) {
+	if (const config_profile_impl::entry *e = m_state->config_profile->find(m_fun)) {
+	  for (unsigned i = 0; i < num_layers; ++i) {
+	    if (layers[i] == e->dom) first = i;
+	  }
+	}
+      }
+      
+      // invariants are printed only once at the end
+      bool print_invars = params.print_invars;
+      for (unsigned i = first; i < num_layers; ++i) {
+	AnalysisParams layer_params(params);
+	layer_params.dom = layers[i];
+	layer_params.print_invars = false;
+	checks_db_t checks;
+	InvarianceAnalysisResults layer_results = {results.premap, results.postmap, checks};
+	Analyze(layer_params, &m_fun.getEntryBlock(), assumption_map_t(), layer_results);
+	// stop if all the assertions are proved, no more precise
+	// domain is left, or the relational domain was discarded
+	// because of --crab-relational-threshold.
+	if (checks.get_total_warning() == 0 || i == num_layers - 1 ||
+	    layer_params.dom != layers[i]) {
+	  mergeChecks(results.checksdb, std::move(checks));
+	  params.dom = layer_params.dom;
+	  break;
+	}
+	CRAB_VERBOSE_IF(1, get_crab_os() << checks.get_total_warning()
+			                 << " assertions not proved in " << m_fun.getName()
+			                 << " with " << getIntraAnalysis(layers[i])->name << "\n";);
+      }
+      if (print_invars) {
+	printInvariants(params, results);
+      }
+    }
+    
+    // Analyze the function with all the domains of --crab-portfolio,
+    // given from the least to the most precise, and keep the most
+    // precise result: the run with fewer unproven assertions (the
+    // most precise domain if no checks). The runs are done at the
+    // same time if they can run in parallel. All of them run to
+    // completion: a crab fixpoint cannot be interrupted so no run is
+    // stopped when another one proves all the assertions.
+    void PortfolioAnalyze(AnalysisParams &params, InvarianceAnalysisResults &results) {
+      std::vector<CrabDomain> doms(CrabPortfolio.begin(), CrabPortfolio.end());
+      if (!m_cfg || CrabBuildOnlyCFG || doms.size() < 2) {
+	if (!doms.empty()) {
+	  params.dom = doms.front();
+	}
+	Analyze(params, &m_fun.getEntryBlock(), assumption_map_t(), results);
+	return;
+      }
+      if (params.is_cancelled()) return;
+      
+      // -- the cfg is shared by all the runs
+      prepareCfg(params);
+      
+      struct portfolio_run {
+	AnalysisParams params;
+	invariant_map_t pre_map;
+	invariant_map_t post_map;
+	checks_db_t checks_db;
+      };
+      std::vector<portfolio_run> runs(doms.size());
+      bool parallel = canRunInParallel(params) && !anyUsesLibraryManager(doms);
+      unsigned num_threads = parallel ? doms.size() : 1U;
+      parallel_for(doms.size(), num_threads, [&](unsigned /*worker*/, unsigned i) {
+	  portfolio_run &run = runs[i];
+	  run.params = params;
+	  run.params.dom = doms[i];
+	  run.params.print_invars = false;
+	  InvarianceAnalysisResults run_results = {run.pre_map, run.post_map, run.checks_db};
+	  Analyze(run.params, &m_fun.getEntryBlock(), assumption_map_t(), run_results);
+	});
+      // -- the runs can be incomplete
+      if (params.is_cancelled()) return;
+
+      unsigned best = 0;
+      for (unsigned i = 1; i < runs.size(); ++i) {
+	if (params.check == NOCHECKS ||
+	    runs[i].checks_db.get_total_warning() <= runs[best].checks_db.get_total_warning()) {
+	  best = i;
+	}
+      }
+
+      portfolio_run &run = runs[best];
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Kept the results of "
+		                       << run.params.abs_dom_to_str()
+		                       << " for " << m_fun.getName() << "\n";);
+      results.premap.insert(run.pre_map.begin(), run.pre_map.end());
+      results.postmap.insert(run.post_map.begin(), run.post_map.end());
+      mergeChecks(results.checksdb, std::move(run.checks_db));
+      params.dom = run.params.dom;
+      if (params.print_invars) {
+	printInvariants(params, results);
+      }
+    }
+    
+    // Same as Analyze but the results are loaded from dir if the
+    // function did not change since the last run. Otherwise, the
+    // function is analyzed and its results are stored in dir.
+    void IncrementalAnalyze(AnalysisParams &params,
+			    const std::string &dir, HeapAbstraction &mem,
+			    InvarianceAnalysisResults &results) {
+      if (!isTrackable(m_fun)) {
+	Analyze(params, &m_fun.getEntryBlock(), assumption_map_t(), results);
+	return;
+      }
+      
+      std::string file = incremental_impl::getFileName(dir, m_fun, params, mem);
+      if (incremental_impl::load(file, m_fun, params.dom, m_vfac, results)) {
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Reused analysis results for "
+			                 << m_fun.getName() << " from "
+			                 << file << "\n");
+	if (params.print_invars) {
+	  if (!m_cfg) buildCfg();
+	  printInvariants(params, results);
+	} else if (!m_cfg) {
+	  // -- the cfg is built only if a client requests it
+	  m_cfg_man.defer(m_fun);
+	  count_stat("CrabLlvm.count.deferred_cfgs");
+	}
+	return;
+      }
+
+      if (!m_cfg) buildCfg();
+
+      // only the checks of this function are stored
+      checks_db_t checks;
+      InvarianceAnalysisResults fun_results = {results.premap, results.postmap, checks};
+      // Analyze can change params and replace m_cfg by a sliced copy
+      AnalysisParams fun_params(params);
+      cfg_ptr_t cfg = m_cfg;
+      BoundedAnalyze(fun_params, fun_results);
+      if (!CrabBuildOnlyCFG) {
+	incremental_impl::store(file, m_fun, *cfg, results.premap, results.postmap, checks);
+      }
+      mergeChecks(results.checksdb, std::move(checks));
+    }
+    
+    // Same as BoundedAnalyze (or LayeredAnalyze if layered) but the
+    // checks are replayed from dir if the function did not change
+    // since the last run. The invariants are not computed in that
+    // case.
+    void CachedAnalyze(AnalysisParams &params,
+		       const std::string &dir, HeapAbstraction &mem,
+		       InvarianceAnalysisResults &results, bool layered) {
+      if (!isTrackable(m_fun) || CrabBuildOnlyCFG) {
+	if (!m_cfg) buildCfg();
+	Analyze(params, &m_fun.getEntryBlock(), assumption_map_t(), results);
+	return;
+      }
+
+      std::string file = checks_cache_impl::getFileName(dir, m_fun, params, mem);
+      checks_db_t checks;
+      if (checks_cache_impl::load(file, checks)) {
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Reused checks of "
+			                 << m_fun.getName() << " from "
+			                 << file << "\n");
+	if (!m_cfg) {
+	  // -- the cfg is built only if a client requests it
+	  m_cfg_man.defer(m_fun);
+	  count_stat("CrabLlvm.count.deferred_cfgs");
+	}
+	mergeChecks(results.checksdb, std::move(checks));
+	return;
+      }
+
+      if (!m_cfg) buildCfg();
+      
+      InvarianceAnalysisResults fun_results = {results.premap, results.postmap, checks};
+      // the analysis can change params
+      AnalysisParams fun_params(params);
+      if (layered) {
+	LayeredAnalyze(fun_params, fun_results);
+      } else {
+	BoundedAnalyze(fun_params, fun_results);
+      }
+      checks_cache_impl::store(file, checks);
+      mergeChecks(results.checksdb, std::move(checks));
+    }
+    
+    // build the full path (included internal basic blocks added
+    // during the translation to Crab)
+    std::vector<llvm_basic_block_wrapper>
+    buildPath(const std::vector<const llvm::BasicBlock*>& blocks) const {
       std::vector<llvm_basic_block_wrapper> path;
       path.reserve(blocks.size());
       for(unsigned i=0; i < blocks.size(); ++i) {
@@ -973,21 +2625,212 @@ namespace crab_llvm {
 	  }
 	}
       }
+      return path;
+    }
 
-      bool res;
-      if (path_analyses.count(params.dom)) {
-      	path_analyses.at(params.dom).analyze(path, core, layered_solving , populate_maps,
-					     post, pre, res);
+    const path_analysis* getPathAnalysis(CrabDomain dom) const {
+      if (const path_analysis *res = getPathAnalysisOrNull(dom)) {
+	return res;
       } else {
       	crab::outs() << "Warning: abstract domain not found or enabled.\n"
-      		     << "Running " << path_analyses.at(INTERVALS).name << " ...\n";
-      	path_analyses.at(INTERVALS).analyze(path, core, layered_solving, populate_maps,
-					    post, pre, res);
-	
+      		     << "Running " << getPathAnalysisOrNull(INTERVALS)->name << " ...\n";
+	return getPathAnalysisOrNull(INTERVALS);
+      }
+    }
+
+    // Return the domains used to analyze a path: params.path_layers
+    // if layered solving, otherwise params.dom.
+    std::vector<const path_analysis*>
+    getPathAnalyses(const AnalysisParams& params, bool layered_solving) const {
+      std::vector<const path_analysis*> res;
+      if (layered_solving && !params.path_layers.empty()) {
+	for (CrabDomain dom: params.path_layers) {
+	  res.push_back(getPathAnalysis(dom));
+	}
+      } else {
+	res.push_back(getPathAnalysis(params.dom));
+      }
+      return res;
+    }
+
+    // Analyze path with each domain in analyses until it is proven
+    // infeasible. Only the first domain tries boolean reasoning
+    // first. The maps and the core are the ones of the last domain.
+    // If cancelled then the path is considered feasible.
+    bool runPathAnalyses(const std::vector<const path_analysis*>& analyses,
+			 const std::vector<llvm_basic_block_wrapper>& path,
+			 bool layered_solving, 
+			 std::vector<crab::cfg::statement_wrapper>& core,
+			 bool populate_maps, 
+			 invariant_map_t& post, invariant_map_t& pre,
+			 const AnalysisParams& params) const {
+      bool res = true;
+      for (unsigned i = 0; i < analyses.size() && !params.is_cancelled(); ++i) {
+	if (i > 0) {
+	  post.clear();
+	  pre.clear();
+	}
+	(this->*(analyses[i]->analyze))(path, core, layered_solving && i == 0, populate_maps,
+					post, pre, res);
+	if (!res) break;
+      }
+      return res;
+    }
+    
+    bool pathAnalyze(const AnalysisParams& params,
+		     const std::vector<const llvm::BasicBlock*>& blocks,
+		     bool layered_solving, 
+		     std::vector<crab::cfg::statement_wrapper>& core,
+		     bool populate_maps, 
+		     invariant_map_t& post, invariant_map_t& pre) const {
+      assert(m_cfg);
+      std::vector<llvm_basic_block_wrapper> path = buildPath(blocks);
+      return runPathAnalyses(getPathAnalyses(params, layered_solving), path,
+			     layered_solving, core, populate_maps, post, pre, params);
+    }
+
+    // The paths only read the crab CFG so they are analyzed in
+    // parallel. The domains are looked up only once.
+    void pathAnalyzeBatch(const AnalysisParams& params,
+			  const std::vector<std::vector<const llvm::BasicBlock*>>& paths,
+			  bool layered_solving, unsigned num_threads,
+			  std::vector<bool>& res,
+			  std::vector<std::vector<crab::cfg::statement_wrapper>>& cores) const {
+      assert(m_cfg);
+      std::vector<const path_analysis*> analyses = getPathAnalyses(params, layered_solving);
+      // std::vector<bool> cannot be written by several threads
+      std::vector<char> sat(paths.size(), true);
+      cores.assign(paths.size(), std::vector<crab::cfg::statement_wrapper>());
+      parallel_for(paths.size(), canRunInParallel(params) ? num_threads : 1U,
+		   [&](unsigned /*worker*/, unsigned i) {
+	std::vector<llvm_basic_block_wrapper> path = buildPath(paths[i]);
+	invariant_map_t post, pre;
+	sat[i] = runPathAnalyses(analyses, path, layered_solving, cores[i], false, post, pre,
+				 params);
+      });
+      res.assign(sat.begin(), sat.end());
+    }
+    
+    typedef std::shared_ptr<IntraCrabLlvm::domain_assumptions> domain_assumptions_ptr;
+    
+    template<typename Dom>
+    domain_assumptions_ptr mkDomainAssumptions(const assumption_map_t &assumptions) const {
+      auto res = std::make_shared<typed_domain_assumptions<Dom>>();
+      for (auto &kv: assumptions) {
+	res->add(*kv.first, kv.second);
       }
       return res;
     }
     
+    domain_assumptions_ptr makeDomainAssumptions(const AnalysisParams &params,
+						 const assumption_map_t &assumptions) const {
+      // same domains as getIntraAnalysis
+      switch (params.dom) {
+      case INTERVALS:             return mkDomainAssumptions<interval_domain_t>(assumptions);
+      case DENSE_INTERVALS:       return mkDomainAssumptions<dense_interval_domain_t>(assumptions);
+      case WRAPPED_INTERVALS_FAST: return mkDomainAssumptions<wrapped_interval_fast_domain_t>(assumptions);
+      case PTR_OFFSETS:           return mkDomainAssumptions<offset_pointer_domain_t>(assumptions);
+      #ifdef HAVE_ALL_DOMAINS
+      case INTERVALS_CONGRUENCES: return mkDomainAssumptions<ric_domain_t>(assumptions);
+      case DIS_INTERVALS:         return mkDomainAssumptions<dis_interval_domain_t>(assumptions);
+      case TERMS_INTERVALS:       return mkDomainAssumptions<term_int_domain_t>(assumptions);
+      #endif
+      case WRAPPED_INTERVALS:     return mkDomainAssumptions<wrapped_interval_domain_t>(assumptions);
+      case ZONES_SPLIT_DBM:       return mkDomainAssumptions<split_dbm_domain_t>(assumptions);
+      case ZONES_SPLIT_DBM_FAST:  return mkDomainAssumptions<split_dbm_fast_domain_t>(assumptions);
+      case ZONES_DENSE_DBM:       return mkDomainAssumptions<dense_dbm_domain_t>(assumptions);
+      case BOXES:                 return mkDomainAssumptions<boxes_domain_t>(assumptions);
+      case OCT:                   return mkDomainAssumptions<oct_domain_t>(assumptions);
+      case PK:                    return mkDomainAssumptions<pk_domain_t>(assumptions);
+      case TERMS_ZONES:           return mkDomainAssumptions<num_domain_t>(assumptions);
+      case TERMS_DIS_INTERVALS:   return mkDomainAssumptions<term_dis_int_domain_t>(assumptions);
+      default:                    return mkDomainAssumptions<interval_domain_t>(assumptions);
+      }
+    }
+    
+    typedef std::unique_ptr<IntraCrabLlvm::path_checker> path_checker_ptr;
+    
+    template<typename AbsDom>
+    class path_checker_impl: public IntraCrabLlvm::path_checker {
+      typedef path_analyzer<cfg_ref_t, AbsDom> path_analyzer_t;
+      
+      path_analyzer_t m_analyzer;
+      const typename CfgBuilder::edge_to_bb_map_t &m_edge_bb_map;
+      std::vector<const BasicBlock*> m_blocks;
+      // number of crab blocks pushed for each llvm block: the crab
+      // block added between two llvm blocks (if any) is pushed
+      // together with the second one.
+      std::vector<unsigned> m_num_pushed;
+      
+    public:
+      
+      path_checker_impl(cfg_ref_t cfg,
+			const typename CfgBuilder::edge_to_bb_map_t &edge_bb_map,
+			const cfg_successor_index<cfg_ref_t> *index)
+	: m_analyzer(cfg, AbsDom(), true, index), m_edge_bb_map(edge_bb_map) {}
+      
+      virtual bool push(const BasicBlock *b) override {
+	unsigned n = 0;
+	if (!m_blocks.empty()) {
+	  auto it = m_edge_bb_map.find(std::make_pair(m_blocks.back(), b));
+	  if (it != m_edge_bb_map.end()) {
+	    m_analyzer.push(it->second);
+	    n++;
+	  }
+	}
+	bool res = m_analyzer.push(b);
+	n++;
+	m_blocks.push_back(b);
+	m_num_pushed.push_back(n);
+	return res;
+      }
+      
+      virtual void pop() override {
+	if (m_blocks.empty()) return;
+	for (unsigned i = 0; i < m_num_pushed.back(); ++i) {
+	  m_analyzer.pop();
+	}
+	m_blocks.pop_back();
+	m_num_pushed.pop_back();
+      }
+      
+      virtual bool is_feasible() const override {
+	return m_analyzer.is_feasible();
+      }
+      
+      virtual unsigned size() const override {
+	return m_blocks.size();
+      }
+    };
+
+    template<typename AbsDom>
+    path_checker_ptr mkPathChecker() const {
+      return path_checker_ptr(new path_checker_impl<AbsDom>(*m_cfg, m_edge_bb_map,
+							    getSuccessorIndex()));
+    }
+    
+    path_checker_ptr makePathChecker(const AnalysisParams& params) const {
+      assert(m_cfg);
+      // same domains as getPathAnalysisOrNull
+      switch (params.dom) {
+      case INTERVALS:         return mkPathChecker<interval_domain_t>();
+      case DENSE_INTERVALS:   return mkPathChecker<dense_interval_domain_t>();
+      case WRAPPED_INTERVALS_FAST: return mkPathChecker<wrapped_interval_fast_domain_t>();
+      case PTR_OFFSETS:           return mkPathChecker<offset_pointer_domain_t>();
+      #ifdef HAVE_ALL_DOMAINS
+      case TERMS_INTERVALS:   return mkPathChecker<term_int_domain_t>();
+      #endif
+      case WRAPPED_INTERVALS: return mkPathChecker<wrapped_interval_domain_t>();
+      case ZONES_SPLIT_DBM:   return mkPathChecker<split_dbm_domain_t>();
+      case BOXES:             return mkPathChecker<boxes_domain_t>();
+      case TERMS_ZONES:       return mkPathChecker<num_domain_t>();
+      default:
+	crab::outs() << "Warning: abstract domain not found or enabled.\n"
+		     << "Running " << getPathAnalysisOrNull(INTERVALS)->name << " ...\n";
+	return mkPathChecker<interval_domain_t>();
+      }
+    }
+    
   }; // end class
 
   /**
@@ -1010,21 +2853,60 @@ namespace crab_llvm {
   void IntraCrabLlvm::clear() {
     m_pre_map.clear();
     m_post_map.clear();
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
     m_checks_db.clear();
   }
   
   void IntraCrabLlvm::analyze(AnalysisParams &params,
 			      const assumption_map_t &assumptions) {    
+    // invariants can change so the cache is not valid anymore
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
     InvarianceAnalysisResults results = { m_pre_map, m_post_map, m_checks_db};
     
     m_impl->Analyze(params, &(m_fun->getEntryBlock()), assumptions, results);
   }
 
-  void IntraCrabLlvm::analyze(AnalysisParams &params,
-			      const llvm::BasicBlock *entry,
-			      const assumption_map_t &assumptions) {
+  void IntraCrabLlvm::analyze(AnalysisParams &params,
+			      const llvm::BasicBlock *entry,
+			      const assumption_map_t &assumptions) {
+    // invariants can change so the cache is not valid anymore
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
+    InvarianceAnalysisResults results = { m_pre_map, m_post_map, m_checks_db};
+    m_impl->Analyze(params, entry, assumptions, results);
+  }
+  
+  void IntraCrabLlvm::reanalyze(AnalysisParams &params,
+				const assumption_map_t &assumptions,
+				const std::vector<const llvm::BasicBlock*> &changed) {
+    // invariants can change so the cache is not valid anymore
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
+    InvarianceAnalysisResults results = { m_pre_map, m_post_map, m_checks_db};
+    m_impl->WarmAnalyze(params, assumptions, changed, results);
+  }
+  
+  IntraCrabLlvm::domain_assumptions_ptr
+  IntraCrabLlvm::make_domain_assumptions(const AnalysisParams &params,
+					 const assumption_map_t &assumptions) const {
+    return m_impl->makeDomainAssumptions(params, assumptions);
+  }
+
+  void IntraCrabLlvm::add_domain_assumption(domain_assumptions &assumptions,
+					    const llvm::BasicBlock &b,
+					    const lin_cst_sys_t &csts) const {
+    assumptions.add(b, csts);
+  }
+  
+  void IntraCrabLlvm::analyze(AnalysisParams &params, const llvm::BasicBlock *entry,
+			      const domain_assumptions &assumptions) {
+    // invariants can change so the cache is not valid anymore
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
     InvarianceAnalysisResults results = { m_pre_map, m_post_map, m_checks_db};
-    m_impl->Analyze(params, entry, assumptions, results);
+    m_impl->Analyze(params, entry, assumption_map_t(), results, &assumptions);
   }
   
   template<>
@@ -1048,13 +2930,27 @@ namespace crab_llvm {
 			       post_conditions, pre_conditions);
   }
 
+  template<>
+  void IntraCrabLlvm::path_analyze_batch(const AnalysisParams& params,
+				   const std::vector<std::vector<const llvm::BasicBlock*>>& paths,
+				   bool layered_solving, unsigned num_threads,
+				   std::vector<bool>& res,
+				   std::vector<std::vector<crab::cfg::statement_wrapper>>& cores) const {
+    m_impl->pathAnalyzeBatch(params, paths, layered_solving, num_threads, res, cores);
+  }
+  
+  std::unique_ptr<IntraCrabLlvm::path_checker>
+  IntraCrabLlvm::make_path_checker(const AnalysisParams& params) const {
+    return m_impl->makePathChecker(params);
+  }
+  
   wrapper_dom_ptr IntraCrabLlvm::get_pre(const llvm::BasicBlock *block,
 					 bool keep_shadows) const {
     std::vector<varname_t> shadows;
     if (!keep_shadows)
       shadows = std::vector<varname_t>(m_vfac.get_shadow_vars().begin(),
 				       m_vfac.get_shadow_vars().end());    
-    return lookup(m_pre_map, *block, shadows);
+    return lookup(m_pre_map, m_pre_map_no_shadows, *block, shadows);
   }   
 
   wrapper_dom_ptr IntraCrabLlvm::get_post(const llvm::BasicBlock *block,
@@ -1063,7 +2959,7 @@ namespace crab_llvm {
     if (!keep_shadows)
       shadows = std::vector<varname_t>(m_vfac.get_shadow_vars().begin(),
 				       m_vfac.get_shadow_vars().end());    
-    return lookup(m_post_map, *block, shadows);
+    return lookup(m_post_map, m_post_map_no_shadows, *block, shadows);
   }
 
   const checks_db_t& IntraCrabLlvm::get_checks_db() const { return m_checks_db;}
@@ -1079,17 +2975,22 @@ namespace crab_llvm {
     std::unique_ptr<call_graph_t> m_cg;
     Module& m_M;
     llvm_variable_factory &m_vfac;
+    CfgManager &m_cfg_man;
+    heap_abs_ptr m_mem;
+    // functions removed from the call graph (--crab-inter-prune)
+    CfgBuilder::function_set_t m_pruned;
     liveness_map_t m_live_map;
+    // threads to build the CFGs and to check the assertions
+    unsigned m_num_threads;
+    // null if not run by CrabLlvmPass
+    const ModuleState *m_state;
       
     /** Run inter-procedural analysis on the whole call graph **/
     template<typename BUDom, typename TDDom>
     void analyzeCg(const AnalysisParams &params,
 		   InvarianceAnalysisResults &results) {
       
-      typedef inter_fwd_analyzer<call_graph_ref_t, BUDom, TDDom> inter_analyzer_t;
-      typedef inter_checker<inter_analyzer_t> inter_checker_t;
-      typedef assert_property_checker<inter_analyzer_t> assert_prop_t;
-      typedef null_property_checker<inter_analyzer_t> null_prop_t;
+      typedef inter_analyzer<BUDom, TDDom> inter_analyzer_t;
       
       CRAB_VERBOSE_IF(1, 
  		      get_crab_os() << "Running inter-procedural analysis with " 
@@ -1099,11 +3000,14 @@ namespace crab_llvm {
 		                    << "\"" << BUDom::getDomainName () << "\"" 
 		                    << "  ...\n";);
       
-      inter_analyzer_t analyzer(*m_cg, (params.run_liveness ? &m_live_map : nullptr),
+      inter_analyzer_t analyzer(*m_cg, (m_live_map.empty() ? nullptr : &m_live_map),
 				params.widening_delay, 
 				params.narrowing_iters, 
 				params.widening_jumpset);
-      analyzer.Run (TDDom::top ());
+      {
+	arena_scope arena(CrabArena);
+	analyzer.run (TDDom::top ());
+      }
     
       CRAB_VERBOSE_IF(1, get_crab_os() << "Finished inter-procedural analysis.\n");
       
@@ -1112,12 +3016,19 @@ namespace crab_llvm {
 	CRAB_VERBOSE_IF(1, get_crab_os() << "Storing invariants.\n");
       }
       
+      bool keep_summaries = (CrabExportSummaries != "" || CrabImportSummaries != "");
+      summaries_impl::summary_db_t summaries;
+      
       for (auto &n: boost::make_iterator_range(vertices(*m_cg))) {
 	cfg_ref_t cfg = n.get_cfg ();
-	if (const Function *F = m_M.getFunction(n.name())) {
-	  
+	// -- only trackable functions have a cfg in the call graph
+	if (const Function *F = m_cfg_man.get_function(cfg.get())) {
 
 	  if (params.store_invariants || params.print_invars) {
+	    std::vector<var_t> stat_vars;
+	    if (params.stats && !CrabStatsConstraints) {
+	      stat_vars = size_stats_impl::getVariables(cfg);
+	    }
 	    for (auto &B : *F) {
 	      // --- invariants that hold at the entry of the blocks
 	      auto pre = analyzer.get_pre (cfg, &B);
@@ -1127,18 +3038,14 @@ namespace crab_llvm {
 	      update(results.postmap, B, mkGenericAbsDomWrapper(post));
 	      
 	      if (params.stats) {
-		unsigned num_block_invars = 0;
-		// TODO CRAB: for boxes we would like to use
-		// to_disjunctive_linear_constraint_system() but it needs to
-		// be exposed to all domains
-		num_block_invars += pre.to_linear_constraint_system().size();
-		num_invars += num_block_invars;
-	      if (num_block_invars > 0) num_nontrivial_blocks++;
+		unsigned num_block_invars = size_stats_impl::getSize(pre, stat_vars);
+		count_stat("CrabLlvm.count.invariants_size", num_block_invars);
+		if (num_block_invars > 0) count_stat("CrabLlvm.count.nontrivial_blocks");
 	      }
 	    }
 	    
 	    // --- print invariants and summaries
-	    if (params.print_invars && isTrackable(*F)) {
+	    if (params.print_invars) {
 	      if (auto f_decl = cfg.get_func_decl()) {
 		crab::outs() << "\n" << *f_decl << "\n";
 	      } else {
@@ -1154,11 +3061,32 @@ namespace crab_llvm {
 	  
 	  // Summaries are not currently stored but it would be easy to do so.	    
 	  if (params.print_summaries && analyzer.has_summary (cfg)) {
-	    auto summ = analyzer.get_summary (cfg);
-	    crab::outs() << "SUMMARY " << *summ << "\n";
+	    crab::outs() << "SUMMARY ";
+	    analyzer.write_summary (cfg, crab::outs(), CrabCompactSummaries,
+				    CrabSummaryMaxRelational);
+	    crab::outs() << "\n";
+	  }
+
+	  if (keep_summaries && analyzer.has_summary (cfg)) {
+	    crab::crab_string_os o;
+	    analyzer.write_summary (cfg, o, CrabCompactSummaries, CrabSummaryMaxRelational);
+	    summaries[F->getName().str()] =
+	      std::make_pair(summaries_impl::getKey(*F, params, *m_mem), o.str());
 	  }
 	}
       }
+
+      if (CrabImportSummaries != "") {
+	summaries_impl::summary_db_t imported;
+	if (summaries_impl::load(CrabImportSummaries, imported)) {
+	  summaries_impl::compare(imported, summaries);
+	} else {
+	  errs() << "Warning: cannot read summaries from " << CrabImportSummaries << "\n";
+	}
+      }
+      if (CrabExportSummaries != "") {
+	summaries_impl::store(CrabExportSummaries, summaries);
+      }
       
       if (params.store_invariants || params.print_invars) {	
 	CRAB_VERBOSE_IF(1, get_crab_os() << "All invariants stored.\n");
@@ -1167,85 +3095,136 @@ namespace crab_llvm {
       // --- checking assertions and collecting data
       if (params.check) {
 	CRAB_VERBOSE_IF(1, get_crab_os() << "Checking assertions ... \n"); 
-	typename inter_checker_t::prop_checker_ptr
-	  prop(new assert_prop_t(params.check_verbose));
-	if (params.check == NULLITY)
-	  prop.reset (new null_prop_t(params.check_verbose));      
-	inter_checker_t checker (analyzer, {prop});
-	checker.run ();
-	//CRAB_VERBOSE_IF(1, checker.show (crab::outs()));
-	results.checksdb += checker.get_all_checks();
+	arena_scope arena(CrabArena);
+	mergeChecks(results.checksdb, analyzer.check(params.check == NULLITY, params.check_verbose,
+						     m_num_threads));
 	CRAB_VERBOSE_IF(1, get_crab_os() << "Finished assert checking.\n"); 
       }
       return;
     }
     // Domains used for inter-procedural analysis
     struct inter_analysis {
-      std::function<void(const AnalysisParams&, InvarianceAnalysisResults&)> analyze;
-      std::string name;
+      void (InterCrabLlvm_Impl::*analyze)(const AnalysisParams&, InvarianceAnalysisResults&);
+      const char *name;
     };
 
-    // Domains used for intra-procedural analysis
-    const std::map<std::pair<CrabDomain,CrabDomain>, inter_analysis> inter_analyses {
-        {{ZONES_SPLIT_DBM, INTERVALS},
-	 { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, interval_domain_t>), "bottom-up:zones, top-down:intervals" }}
-      , {{ZONES_SPLIT_DBM, WRAPPED_INTERVALS},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, wrapped_interval_domain_t>), "bottom-up:zones, top-down:wrapped intervals" }}
-      , {{ZONES_SPLIT_DBM, ZONES_SPLIT_DBM},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, split_dbm_domain_t>), "bottom-up:zones, top-down:zones" }}
-      , {{ZONES_SPLIT_DBM, BOXES},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, boxes_domain_t>), "bottom-up:zones, top-down:boxes" }}
-      , {{ZONES_SPLIT_DBM, OCT},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, oct_domain_t>), "bottom-up:zones, top-down:oct" }}
-      , {{ZONES_SPLIT_DBM, PK},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, pk_domain_t>), "bottom-up:zones, top-down:pk" }}
-      , {{ZONES_SPLIT_DBM, TERMS_ZONES},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, num_domain_t>), "bottom-up:zones, top-down:terms+zones" }}
-      , {{ZONES_SPLIT_DBM, TERMS_DIS_INTERVALS},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<split_dbm_domain_t, term_dis_int_domain_t>), "bottom-up:zones, top-down:terms+dis_intervals" }}
-      //////////////////////////////////////////////////////
-      , {{OCT, INTERVALS},
-	 { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, interval_domain_t>), "bottom-up:oct, top-down:intervals" }}
-      , {{OCT, WRAPPED_INTERVALS},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, wrapped_interval_domain_t>), "bottom-up:oct, top-down:wrapped intervals" }}
-      , {{OCT, ZONES_SPLIT_DBM},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, split_dbm_domain_t>), "bottom-up:oct, top-down:zones" }}
-      , {{OCT, BOXES},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, boxes_domain_t>), "bottom-up:oct, top-down:boxes" }}
-      , {{OCT, OCT},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, oct_domain_t>), "bottom-up:oct, top-down:oct" }}
-      , {{OCT, PK},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, pk_domain_t>), "bottom-up:oct, top-down:pk" }}
-      , {{OCT, TERMS_ZONES},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, num_domain_t>), "bottom-up:oct, top-down:terms+zones" }}
-      , {{OCT, TERMS_DIS_INTERVALS},
-	  { bind_this(this, &InterCrabLlvm_Impl::analyzeCg<oct_domain_t, term_dis_int_domain_t>), "bottom-up:oct, top-down:terms+dis_intervals" }}
-    };
+    // Pairs of bottom-up and top-down domains. The entries are
+    // constants shared by all modules. Return null if the pair is
+    // not enabled.
+    template<typename BUDom>
+    static const inter_analysis* getInterAnalysis(CrabDomain td_dom, const char *bu_name) {
+      typedef InterCrabLlvm_Impl T;
+      // one copy of each entry per BUDom
+      static const std::string prefix = std::string("bottom-up:") + bu_name + ", top-down:";
+      static const std::string names[] = {
+	prefix + "intervals", prefix + "wrapped intervals", prefix + "zones",
+	prefix + "boxes", prefix + "oct", prefix + "pk", prefix + "terms+zones",
+	prefix + "terms+dis_intervals", prefix + "zones (int64)" };
+      static const inter_analysis intervals =
+	{ &T::analyzeCg<BUDom, interval_domain_t>, names[0].c_str() };
+      static const inter_analysis wrapped_intervals =
+	{ &T::analyzeCg<BUDom, wrapped_interval_domain_t>, names[1].c_str() };
+      static const inter_analysis zones =
+	{ &T::analyzeCg<BUDom, split_dbm_domain_t>, names[2].c_str() };
+      static const inter_analysis boxes =
+	{ &T::analyzeCg<BUDom, boxes_domain_t>, names[3].c_str() };
+      static const inter_analysis oct =
+	{ &T::analyzeCg<BUDom, oct_domain_t>, names[4].c_str() };
+      static const inter_analysis pk =
+	{ &T::analyzeCg<BUDom, pk_domain_t>, names[5].c_str() };
+      static const inter_analysis term_zones =
+	{ &T::analyzeCg<BUDom, num_domain_t>, names[6].c_str() };
+      static const inter_analysis term_dis_intervals =
+	{ &T::analyzeCg<BUDom, term_dis_int_domain_t>, names[7].c_str() };
+      static const inter_analysis zones_fast =
+	{ &T::analyzeCg<BUDom, split_dbm_fast_domain_t>, names[8].c_str() };
+      
+      switch (td_dom) {
+      case INTERVALS:           return &intervals;
+      case WRAPPED_INTERVALS:   return &wrapped_intervals;
+      case ZONES_SPLIT_DBM:     return &zones;
+      case ZONES_SPLIT_DBM_FAST: return &zones_fast;
+      case BOXES:               return &boxes;
+      case OCT:                 return &oct;
+      case PK:                  return &pk;
+      case TERMS_ZONES:         return &term_zones;
+      case TERMS_DIS_INTERVALS: return &term_dis_intervals;
+      default:                  return nullptr;
+      }
+    }
+    
+    static const inter_analysis* getInterAnalysis(CrabDomain bu_dom, CrabDomain td_dom) {
+      switch (bu_dom) {
+      case ZONES_SPLIT_DBM: return getInterAnalysis<split_dbm_domain_t>(td_dom, "zones");
+      case ZONES_SPLIT_DBM_FAST:
+	return getInterAnalysis<split_dbm_fast_domain_t>(td_dom, "zones (int64)");
+      case OCT:             return getInterAnalysis<oct_domain_t>(td_dom, "oct");
+      default:              return nullptr;
+      }
+    }
     
   public:
     
     InterCrabLlvm_Impl(Module& M,
 		       crab::cfg::tracked_precision cfg_precision,
 		       heap_abs_ptr mem, llvm_variable_factory &vfac,
-		       CfgManager &cfg_man, const TargetLibraryInfo &tli)
-      : m_cg(nullptr), m_M(M), m_vfac(vfac) {
+		       CfgManager &cfg_man, const TargetLibraryInfo &tli,
+		       const ModuleState *state, unsigned num_threads = 1)
+      : m_cg(nullptr), m_M(M), m_vfac(vfac), m_cfg_man(cfg_man), m_mem(mem),
+	m_num_threads(num_threads), m_state(state) {
 
-      std::vector<cfg_ref_t> cfg_ref_vector;
+      std::vector<Function*> funcs;
       for (auto &F : m_M) {
-        if (isTrackable(F)) {
-	  // -- build cfg's 
+        if (state && !state->is_analyzed(F)) {
+	  // -- not reachable from the roots or it neither calls nor is
+	  //    called by the functions with the assertion of
+	  //    --crab-check-only
+	  continue;
+	} else if (isTrackable(F)) {
+	  funcs.push_back(&F);
+	} else {
+	  CRAB_VERBOSE_IF(1, llvm::outs() << "Cannot build CFG for "
+			                  << F.getName() << "\n");
+	}
+      }
+
+      // -- remove functions without effects on their callers
+      if (CrabInterPrune) {
+	m_pruned = prune_impl::getPrunable(funcs, *mem, cfg_precision);
+	funcs.erase(std::remove_if(funcs.begin(), funcs.end(),
+				   [this](Function *F) { return m_pruned.count(F) > 0; }),
+		    funcs.end());
+	count_max_stat("Inter.count.pruned", m_pruned.size());
+	CRAB_VERBOSE_IF(1, llvm::outs() << "Pruned " << m_pruned.size()
+			<< " functions from the call graph\n");
+      }
+      
+      // -- build cfg's (in parallel if num_threads > 1)
+      std::vector<cfg_t*> cfgs(funcs.size(), nullptr);
+      if (num_threads > 1) {
+	for (Function *F : funcs) {
+	  m_vfac.add_names(*F);
+	  CfgBuilder::compute_struct_layouts(*F);
+	}
+      }
+      parallel_for(funcs.size(), num_threads, [&](unsigned /*id*/, unsigned i) {
+	  Function &F = *funcs[i];
 	  CfgBuilder B(F, m_vfac, *mem, cfg_precision,
 		       /*include function decls and callsites*/
 		       true,  &tli);
-	  cfg_t *cfg = B.get_cfg();
-	  cfg_man.add(F, cfg);
-	  cfg_ref_vector.push_back (*cfg);
+	  B.set_pruned_functions(&m_pruned);
+	  cfgs[i] = B.get_cfg();
+	  if (state && check_only_impl::enabled()) {
+	    state->check_only.removeOtherChecks(*cfgs[i]);
+	  }
+	  cfg_man.add(F, cfgs[i]);
 	  CRAB_VERBOSE_IF(1, llvm::outs() << "Built Crab CFG for "
 			  << F.getName() << "\n");
-	} else {
-	  CRAB_VERBOSE_IF(1, llvm::outs() << "Cannot build CFG for "
-			                  << F.getName() << "\n");
-	}
+	});
+      // keep the order of the module to build the call graph
+      std::vector<cfg_ref_t> cfg_ref_vector;
+      for (cfg_t *cfg : cfgs) {
+	cfg_ref_vector.push_back (*cfg);
       }
       // build call graph
       m_cg = make_unique<call_graph_t>(cfg_ref_vector.begin(), cfg_ref_vector.end());
@@ -1262,9 +3241,17 @@ namespace crab_llvm {
       /* Compute liveness information and choose statically the
 	 abstract domain */
       if (params.run_liveness || isRelationalDomain(absdom)) {
-	unsigned max_live_per_blk = 0;
+	// The liveness analysis of each function is independent so it
+	// can run in parallel if --crab-threads.
+	std::vector<cfg_ref_t> cfgs;
 	for (auto cg_node: boost::make_iterator_range(vertices(*m_cg))) {
-	  auto cfg_ref = cg_node.get_cfg();
+	  cfgs.push_back(cg_node.get_cfg());
+	}
+	std::vector<liveness_t*> lives(cfgs.size(), nullptr);
+	std::vector<unsigned> max_lives(cfgs.size(), 0);
+	parallel_for(cfgs.size(), canRunInParallel(params) ? (unsigned) CrabThreads : 1U,
+		     [&](unsigned /*worker*/, unsigned i) {
+	  auto cfg_ref = cfgs[i];
           CRAB_VERBOSE_IF(1,
 			  auto fdecl = cfg_ref.get_func_decl ();            
 			  assert (fdecl);
@@ -1276,58 +3263,119 @@ namespace crab_llvm {
           // some stats
           unsigned total_live, max_live_per_blk_, avg_live_per_blk;
           live->get_stats (total_live, max_live_per_blk_, avg_live_per_blk);
-          max_live_per_blk = std::max (max_live_per_blk, max_live_per_blk_);
           CRAB_VERBOSE_IF(1,
 		    crab::outs() << "-- Max number of out live vars per block=" 
                                  << max_live_per_blk_ << "\n";
 		    crab::outs() << "-- Avg number of out live vars per block=" 
                                  << avg_live_per_blk << "\n";);
-          crab::CrabStats::count_max ("Liveness.count.maxOutVars",
-				      max_live_per_blk);
-
-	  if (isRelationalDomain(absdom)) {
-	    // FIXME: the selection of the final domain is fixed for the
-	    //        whole program. That is, if there is one function that
-	    //        exceeds the threshold then the cheaper domain will be
-	    //        used for all functions. We should be able to change
-	    //        from one function to another.
-	    CRAB_VERBOSE_IF(1,
-		      crab::outs() << "Max live per block: "
-		                   << max_live_per_blk << "\n"
-		                   << "Threshold: "
-		                   << params.relational_threshold << "\n");
-	    if (max_live_per_blk > params.relational_threshold) {
-	      // default domain
-	      absdom = INTERVALS;
+	  lives[i] = live;
+	  max_lives[i] = max_live_per_blk_;
+	});
+
+	unsigned max_live_per_blk = 0;
+	for (unsigned i = 0; i < cfgs.size(); ++i) {
+          max_live_per_blk = std::max (max_live_per_blk, max_lives[i]);
+          count_max_stat("Liveness.count.maxOutVars", max_live_per_blk);
+	  if (params.run_liveness || (CrabReuseLiveness && isRelationalDomain(absdom))) {
+	    m_live_map.insert(std::make_pair(cfgs[i], lives[i]));
+	  } else {
+	    delete lives[i];
+	  }
+	}
+	
+	if (isRelationalDomain(absdom)) {
+	  if (params.relational_threshold_loops) {
+	    max_live_per_blk = 0;
+	    for (auto cfg_ref: cfgs) {
+	      const BasicBlock *entry = cfg_ref.entry().get_basic_block();
+	      if (!entry) continue;
+	      max_live_per_blk = std::max(max_live_per_blk,
+					  adaptive_impl::maxLiveInLoops(*entry->getParent()));
 	    }
 	  }
-	  
-	  if (params.run_liveness) {
-	    m_live_map.insert(std::make_pair(cfg_ref, live));	    
-	  } else {
-	    delete live;
+	  if (params.relational_threshold_packs && isSparseRelationalDomain(absdom)) {
+	    unsigned max_pack = 0;
+	    for (auto cfg_ref: cfgs) {
+	      const BasicBlock *entry = cfg_ref.entry().get_basic_block();
+	      if (!entry) continue;
+	      max_pack = std::max(max_pack, adaptive_impl::maxPackSize(*entry->getParent()));
+	    }
+	    CRAB_VERBOSE_IF(1, crab::outs() << "Max pack size: " << max_pack << "\n");
+	    max_live_per_blk = std::min(max_live_per_blk, max_pack);
+	  }
+	  // FIXME: the selection of the final domain is fixed for the
+	  //        whole program. That is, if there is one function that
+	  //        exceeds the threshold then the cheaper domain will be
+	  //        used for all functions. We should be able to change
+	  //        from one function to another.
+	  CRAB_VERBOSE_IF(1,
+		    crab::outs() << "Max live per block"
+		                 << (params.relational_threshold_loops ? " in loops: " : ": ")
+		                 << max_live_per_blk << "\n"
+		                 << "Threshold: "
+		                 << params.relational_threshold << "\n");
+	  if (max_live_per_blk > params.relational_threshold) {
+	    // default domain
+	    absdom = INTERVALS;
+	  }
+	}
+      }
+      
+      // -- the jump set is the same for all functions
+      for (auto cg_node: boost::make_iterator_range(vertices(*m_cg))) {
+	const BasicBlock *entry = cg_node.get_cfg().entry().get_basic_block();
+	if (entry) {
+	  params.widening_jumpset = std::max(params.widening_jumpset,
+					     adaptive_impl::autoJumpSet(*entry->getParent()));
+	}
+      }
+      
+      // -- the summary domain is cheaper if the boundary of some SCC
+      //    is too large. As with liveness, the choice is made for the
+      //    whole program.
+      CrabDomain sumdom = params.sum_dom;
+      if (CrabInterSumThreshold > 0) {
+	unsigned max_boundary = adaptive_impl::maxSccBoundary(m_M);
+	CRAB_VERBOSE_IF(1, crab::outs() << "Max SCC boundary: " << max_boundary << "\n"
+			<< "Threshold: " << CrabInterSumThreshold << "\n");
+	if (max_boundary > CrabInterSumThreshold) {
+	  if (sumdom != ZONES_SPLIT_DBM && sumdom != ZONES_SPLIT_DBM_FAST) {
+	    sumdom = ZONES_SPLIT_DBM;
+	  } else if (isRelationalDomain(absdom)) {
+	    absdom = INTERVALS;
 	  }
-	} // end for
+	}
       }
       
       // -- run the interprocedural analysis
-      if (!CrabBuildOnlyCFG) {
-	if (inter_analyses.count({params.sum_dom, params.dom})) {
-	  inter_analyses.at({params.sum_dom, params.dom}).analyze(params, results);
-	} else {
+      if (!CrabBuildOnlyCFG && !params.is_cancelled()) {
+	AnalysisParams inter_params(params);
+	inter_params.dom = absdom;
+	inter_params.sum_dom = sumdom;
+	const inter_analysis *analysis = getInterAnalysis(sumdom, absdom);
+	if (!analysis) {
+	  analysis = getInterAnalysis(ZONES_SPLIT_DBM, INTERVALS);
 	  crab::outs() << "Warning: abstract domains not found or enabled.\n"
-		       << "Running " << inter_analyses.at({ZONES_SPLIT_DBM, INTERVALS}).name
-		       << "\n";
-	  inter_analyses.at({ZONES_SPLIT_DBM, INTERVALS}).analyze(params, results);	
+		       << "Running " << analysis->name << "\n";
+	}
+	trace_domain trace_dom(is_tracing() ? analysis->name : "");
+	trace_scope trace("inter");
+	alloc_stats_impl::scoped_alloc alloc(m_state ? m_state->alloc_stats.get() : nullptr,
+					     "inter");
+	(this->*(analysis->analyze))(inter_params, results);
+	if (params.progress) {
+	  // -- all functions are analyzed together
+	  unsigned num_functions = num_vertices(*m_cg);
+	  AnalysisProgress progress = { num_functions, num_functions, "" };
+	  params.progress(progress);
 	}
       }
       
       // free liveness map
-      if (params.run_liveness) {
-        for (auto &p : m_live_map) {
-          delete p.second;
-	}
+      for (auto &p : m_live_map) {
+	delete p.second;
       }
+      m_live_map.clear();
     }
   };
 
@@ -1344,7 +3392,7 @@ namespace crab_llvm {
       heap_abs = boost::make_shared<DummyHeapAbstraction>();
 
     m_impl = make_unique<InterCrabLlvm_Impl>(module, cfg_precision,
-					     heap_abs, m_vfac, cfg_man, tli);
+					     heap_abs, m_vfac, cfg_man, tli, nullptr);
   }
 
   InterCrabLlvm::~InterCrabLlvm() {}
@@ -1352,11 +3400,16 @@ namespace crab_llvm {
   void InterCrabLlvm::clear() {
     m_pre_map.clear();
     m_post_map.clear();
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
     m_checks_db.clear();
   }
   
   void InterCrabLlvm::analyze(AnalysisParams &params,
 			      const assumption_map_t &assumptions) {
+    // invariants can change so the cache is not valid anymore
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
     InvarianceAnalysisResults results = { m_pre_map, m_post_map, m_checks_db};
     m_impl->Analyze(params, assumptions, results);
   }
@@ -1367,7 +3420,7 @@ namespace crab_llvm {
     if (!keep_shadows)
       shadows = std::vector<varname_t>(m_vfac.get_shadow_vars().begin(),
 				       m_vfac.get_shadow_vars().end());    
-    return lookup(m_pre_map, *block, shadows);
+    return lookup(m_pre_map, m_pre_map_no_shadows, *block, shadows);
   }   
 
   wrapper_dom_ptr InterCrabLlvm::get_post(const llvm::BasicBlock *block,
@@ -1376,7 +3429,7 @@ namespace crab_llvm {
     if (!keep_shadows)
       shadows = std::vector<varname_t>(m_vfac.get_shadow_vars().begin(),
 				       m_vfac.get_shadow_vars().end());    
-    return lookup(m_post_map, *block, shadows);
+    return lookup(m_post_map, m_post_map_no_shadows, *block, shadows);
   }
 
   const checks_db_t& InterCrabLlvm::get_checks_db() const { return m_checks_db;}
@@ -1391,25 +3444,305 @@ namespace crab_llvm {
   CrabLlvmPass::CrabLlvmPass ()
     : llvm::ModulePass (ID), 
       m_mem(boost::make_shared<DummyHeapAbstraction>()),
-      m_tli(nullptr) { }
+      m_tli(nullptr), m_keep_results(false), m_cancel(nullptr),
+      m_state(make_unique<ModuleState>()) { }
+
+  CrabLlvmPass::~CrabLlvmPass() {}
+
+  void CrabLlvmPass::report_progress(const std::string &F, unsigned done, unsigned total) {
+    if (!m_params.progress) return;
+    AnalysisProgress progress = { done, total, F };
+    std::lock_guard<std::mutex> lock(m_progress_mutex);
+    m_params.progress(progress);
+  }
 
   void CrabLlvmPass::releaseMemory () {
+    if (m_keep_results) return;
     m_pre_map.clear(); 
     m_post_map.clear();
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
+    m_block_ranges.clear();
+    m_inst_ranges.clear();
     m_checks_db.clear();
+    m_cfg_man.clear();
+    m_state = make_unique<ModuleState>();
+  }
+
+  // The results of the functions that did not change since the last
+  // run are reused (--crab-incremental or --crab-checks-cache) so
+  // their CFGs are built only if the results cannot be reused.
+  static bool reusesResults() {
+    return CrabIncremental != "" || CrabChecksCache != "";
   }
 
   bool CrabLlvmPass::runOnFunction (Function &F) {
     if (!CrabInter && isTrackable(F)) {
-      IntraCrabLlvm_Impl crab(F, CrabTrackLev, m_mem, m_vfac, m_cfg_man, *m_tli);
-      InvarianceAnalysisResults results = { m_pre_map, m_post_map, m_checks_db};
-      crab.Analyze(m_params, &F.getEntryBlock(), assumption_map_t(), results);
+      m_pre_map_no_shadows.clear();
+      m_post_map_no_shadows.clear();
+      m_block_ranges.clear();
+      m_inst_ranges.clear();
+      checks_db_t checks;
+      InvarianceAnalysisResults results = { m_pre_map, m_post_map, checks};
+      const Function *rep = (m_state->dedup ? m_state->dedup->getRepresentative(F) : nullptr);
+      if (!rep || !m_state->dedup->copyResults(*rep, m_cfg_man[*rep], F, m_vfac, results)) {
+	IntraCrabLlvm_Impl crab(F, CrabTrackLev, m_mem, m_vfac, m_cfg_man, *m_tli,
+				m_state.get(), reusesResults());
+	auto start = std::chrono::steady_clock::now();
+	// -- the options tuned for F are only used for F
+	AnalysisParams fun_params(m_params);
+	bool tuned = (m_state->config_profile || m_state->budget);
+	AnalysisParams &params = (tuned ? fun_params : m_params);
+	if (m_state->config_profile) {
+	  m_state->config_profile->apply(F, params);
+	}
+	if (m_state->budget) {
+	  m_state->budget->apply(F, params);
+	}
+	if (CrabIncremental != "") {
+	  crab.IncrementalAnalyze(params, CrabIncremental, *m_mem, results);
+	} else if (CrabChecksCache != "") {
+	  crab.CachedAnalyze(params, CrabChecksCache, *m_mem, results, false);
+	} else if (!CrabPortfolio.empty()) {
+	  AnalysisParams portfolio_params(params);
+	  crab.PortfolioAnalyze(portfolio_params, results);
+	} else {
+	  crab.BoundedAnalyze(params, results);
+	  if (CrabWarmReanalysis) {
+	    // -- all blocks changed but without new assumptions
+	    std::vector<const BasicBlock*> changed;
+	    for (auto &B: F) changed.push_back(&B);
+	    crab.WarmAnalyze(params, assumption_map_t(), changed, results);
+	  }
+	}
+	unsigned ms = config_profile_impl::elapsed_ms(start);
+	if (m_state->config_profile) {
+	  m_state->config_profile->record(F, params, checks, ms);
+	}
+	if (m_state->budget) {
+	  m_state->budget->done(F, ms);
+	}
+	crab.recordIfSlow(m_params, start);
+	if (m_state->dedup && !params.is_cancelled()) {
+	  m_state->dedup->setResults(F, params.dom, checks);
+	}
+      }
+      if (m_state->invariant_exporter) {
+	m_state->invariant_exporter->write(F, m_pre_map, m_post_map);
+      }
+      if (m_state->checks_streamer) {
+	m_state->checks_streamer->write(F.getName(), checks);
+      }
+      schedule_impl::record(F, checks);
+      mergeChecks(m_checks_db, std::move(checks));
     }
     return false;
   }
+
+  void CrabLlvmPass::release_function(Function &F) {
+    for (auto &B: F) {
+      m_pre_map.erase(&B);
+      m_post_map.erase(&B);
+      m_pre_map_no_shadows.erase(&B);
+      m_post_map_no_shadows.erase(&B);
+      m_block_ranges.erase(&B);
+      for (auto &I: B) {
+	m_inst_ranges.erase(&I);
+      }
+    }
+    m_cfg_man.release(F);
+  }
+
+  CrabLlvmPass::checks_db_t
+  CrabLlvmPass::analyze_function(Function &F, const AnalysisParams &params) {
+    checks_db_t checks;
+    if (!isTrackable(F)) return checks;
+    m_pre_map_no_shadows.clear();
+    m_post_map_no_shadows.clear();
+    m_block_ranges.clear();
+    m_inst_ranges.clear();
+    IntraCrabLlvm_Impl crab(F, CrabTrackLev, m_mem, m_vfac, m_cfg_man, *m_tli,
+			    m_state.get());
+    InvarianceAnalysisResults results = { m_pre_map, m_post_map, checks};
+    // Analyze can change params
+    AnalysisParams fun_params(params);
+    crab.Analyze(fun_params, &F.getEntryBlock(), assumption_map_t(), results);
+    return checks;
+  }
+  
+  void CrabLlvmPass::runOnModuleParallel(Module &M, unsigned NumThreads) {
+    std::vector<std::pair<Function*, std::unique_ptr<IntraCrabLlvm_Impl>>> work;
+    // -- functions identical to some function of work
+    std::vector<std::pair<Function*, const Function*>> dups;
+    for (Function *F : schedule_impl::getSchedule(M, *m_state)) {
+      if (!isTrackable(*F)) continue;
+      if (m_state->dedup) {
+	if (const Function *rep = m_state->dedup->getRepresentative(*F)) {
+	  dups.push_back(std::make_pair(F, rep));
+	  continue;
+	}
+      }
+      work.emplace_back(F, nullptr);
+    }
+    
+    // -- build all the CFGs in parallel before starting the
+    //    analysis. The names and the struct layouts are computed
+    //    first since their caches are not thread-safe.
+    for (auto &kv : work) {
+      m_vfac.add_names(*kv.first);
+      CfgBuilder::compute_struct_layouts(*kv.first);
+    }
+    parallel_for(work.size(), NumThreads, [&](unsigned /*id*/, unsigned i) {
+	work[i].second = make_unique<IntraCrabLlvm_Impl>(*work[i].first, CrabTrackLev,
+							 m_mem, m_vfac, m_cfg_man, *m_tli,
+							 m_state.get(), reusesResults());
+      });
+    
+    NumThreads = std::min(NumThreads, (unsigned) work.size());
+    CRAB_VERBOSE_IF(1, get_crab_os() << "Analyzing " << work.size()
+		                     << " functions with " << NumThreads
+		                     << " threads\n";);
+    
+    // -- each worker writes its results in its own shard
+    struct results_shard {
+      invariant_map_t pre_map;
+      invariant_map_t post_map;
+      checks_db_t checks_db;
+    };
+    std::vector<results_shard> shards(NumThreads);
+    // set if --crab-stop-on-error and some function has an error
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned> num_done(0);
+    parallel_for(work.size(), NumThreads, [&](unsigned id, unsigned i) {
+	if (stop || m_params.is_cancelled()) return;
+	results_shard &shard = shards[id];
+	checks_db_t checks;
+	InvarianceAnalysisResults results = {shard.pre_map, shard.post_map, checks};
+	// Analyze can modify the parameters (e.g., the domain) so each
+	// function gets its own copy.
+	AnalysisParams params(m_params);
+	Function *F = work[i].first;
+	if (m_state->config_profile) {
+	  m_state->config_profile->apply(*F, params);
+	}
+	if (m_state->budget) {
+	  m_state->budget->apply(*F, params);
+	}
+	auto start = std::chrono::steady_clock::now();
+	if (CrabIncremental != "") {
+	  work[i].second->IncrementalAnalyze(params, CrabIncremental, *m_mem, results);
+	} else if (CrabChecksCache != "") {
+	  work[i].second->CachedAnalyze(params, CrabChecksCache, *m_mem, results,
+					CrabCheckLayered && params.check == ASSERTION);
+	} else if (CrabCheckLayered && params.check == ASSERTION) {
+	  work[i].second->LayeredAnalyze(params, results);
+	} else if (!CrabPortfolio.empty()) {
+	  work[i].second->PortfolioAnalyze(params, results);
+	} else {
+	  work[i].second->Analyze(params, &F->getEntryBlock(), assumption_map_t(),
+				  results);
+	}
+	work[i].second->recordIfSlow(params, start);
+	unsigned ms = config_profile_impl::elapsed_ms(start);
+	if (m_state->config_profile) {
+	  m_state->config_profile->record(*F, params, checks, ms);
+	}
+	if (m_state->budget) {
+	  m_state->budget->done(*F, ms);
+	}
+	if (m_state->invariant_exporter) {
+	  m_state->invariant_exporter->write(*F, shard.pre_map, shard.post_map);
+	}
+	if (m_state->checks_streamer) {
+	  m_state->checks_streamer->write(F->getName(), checks);
+	}
+	schedule_impl::record(*F, checks);
+	if (m_state->dedup && !params.is_cancelled()) {
+	  m_state->dedup->setResults(*F, params.dom, checks);
+	}
+	if (CrabStopOnError && checks.get_total_error() > 0) {
+	  // functions that are being analyzed by other workers finish
+	  // but no new function is started.
+	  stop = true;
+	}
+	mergeChecks(shard.checks_db, std::move(checks));
+	report_progress(F->getName().str(), ++num_done, work.size());
+      });
+    
+    // -- merge all the shards
+    for (auto &shard : shards) {
+      m_pre_map.insert(shard.pre_map.begin(), shard.pre_map.end());
+      m_post_map.insert(shard.post_map.begin(), shard.post_map.end());
+      mergeChecks(m_checks_db, std::move(shard.checks_db));
+    }
+
+    // -- the results of the representatives are merged
+    for (auto &kv : dups) {
+      checks_db_t checks;
+      InvarianceAnalysisResults results = {m_pre_map, m_post_map, checks};
+      if (!m_state->dedup->copyResults(*kv.second, m_cfg_man[*kv.second], *kv.first,
+				       m_vfac, results)) {
+	continue;
+      }
+      if (m_state->invariant_exporter) {
+	m_state->invariant_exporter->write(*kv.first, m_pre_map, m_post_map);
+      }
+      if (m_state->checks_streamer) {
+	m_state->checks_streamer->write(kv.first->getName(), checks);
+      }
+      schedule_impl::record(*kv.first, checks);
+      mergeChecks(m_checks_db, std::move(checks));
+    }
+  }
+  
+  // the options used to compute the heap abstraction: a heap
+  // snapshot is only reused if they do not change.
+  static std::string heapSnapshotConfig() {
+    std::ostringstream o;
+    o << "heap=" << (int) CrabHeapAnalysis
+      << ";unknown=" << CrabDsaDisambiguateUnknown
+      << ";ptrcast=" << CrabDsaDisambiguatePtrCast
+      << ";external=" << CrabDsaDisambiguateExternal;
+    if (CrabHeapAnalysis == AUTO_SEA_DSA) {
+      o << ";auto=" << CrabDsaAutoTimeout << "," << CrabDsaAutoMemory
+	<< "," << CrabDsaAutoFnRegions << "," << CrabInter;
+    }
+    return o.str();
+  }
+  
+  bool CrabLlvmPass::loadHeapSnapshot(Module &M) {
+    std::string error;
+    std::unique_ptr<SnapshotHeapAbstraction> snapshot =
+      SnapshotHeapAbstraction::load(M, CrabHeapSnapshot, heapSnapshotConfig(), error);
+    if (!snapshot) {
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Heap snapshot not used: " << error << "\n";);
+      return false;
+    }
+    m_mem.reset(snapshot.release());
+    return true;
+  }
   
   bool CrabLlvmPass::runOnModule (Module &M) {
 
+    if (CrabVerboseRate > 0) {
+      set_log_rate_limit(CrabVerboseRate);
+    }
+
+    schedule_impl::reset();
+    m_state = make_unique<ModuleState>();
+
+    // -- before the heap analysis so that it is accounted too
+    if (CrabAllocStats) {
+      if (!CrabStats) {
+	errs() << "Warning: --crab-alloc-stats requires --crab-stats\n";
+      } else if (!enable_alloc_counters()) {
+	errs() << "Warning: --crab-alloc-stats ignored because operator new "
+	       << "is not hooked by this executable\n";
+      } else {
+	m_state->alloc_stats = make_unique<alloc_stats_impl::accountant>();
+      }
+    }
+    
     CRAB_VERBOSE_IF(1,
 	     get_crab_os() << "Started crab-llvm\n"; 
              unsigned num_analyzed_funcs = 0;
@@ -1421,36 +3754,78 @@ namespace crab_llvm {
                            << num_analyzed_funcs << "\n";);
 
     m_tli = &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI();
-    switch (CrabHeapAnalysis) {
-    case LLVM_DSA:
-      #ifdef HAVE_DSA
-      CRAB_VERBOSE_IF(1, get_crab_os() << "Started llvm-dsa analysis\n";);                  
-      m_mem.reset
-	(new LlvmDsaHeapAbstraction(M,&getAnalysis<SteensgaardDataStructures>(),
-				    CrabDsaDisambiguateUnknown,
-				    CrabDsaDisambiguatePtrCast,
-				    CrabDsaDisambiguateExternal));
-      CRAB_VERBOSE_IF(1, get_crab_os() << "Finished llvm-dsa analysis\n";);      
-      break;
-      #else
-      // execute CI_SEA_DSA
-      #endif      
-    case CI_SEA_DSA:
-    case CS_SEA_DSA: {
-      CRAB_VERBOSE_IF(1, get_crab_os() << "Started sea-dsa analysis\n";);
-      CallGraph& cg = getAnalysis<CallGraphWrapperPass>().getCallGraph();      
-      const DataLayout& dl = M.getDataLayout();
-      m_mem.reset
-	(new SeaDsaHeapAbstraction(M, cg, dl, *m_tli,
-				   (CrabHeapAnalysis == CS_SEA_DSA),
-				   CrabDsaDisambiguateUnknown,
-				   CrabDsaDisambiguatePtrCast,
-				   CrabDsaDisambiguateExternal));
-      CRAB_VERBOSE_IF(1, get_crab_os() << "Finished sea-dsa analysis\n";);      
-      break;
-    }
-    default:
-      errs() << "Warning: running crab-llvm without memory analysis\n";
+    if (CrabTrackLev == NUM) {
+      // -- the translation to Crab CFGs only queries the heap
+      //    abstraction if pointers or memory contents are tracked so
+      //    the memory analysis is not needed.
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Skipped memory analysis with --crab-track=num\n";);
+    } else if (CrabHeapSnapshot != "" && loadHeapSnapshot(M)) {
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Loaded heap abstraction from "
+		                       << CrabHeapSnapshot << "\n";);
+    } else {
+      trace_scope trace("heap");
+      alloc_stats_impl::scoped_alloc alloc(m_state->alloc_stats.get(), "heap");
+      scoped_stats_timer __st__("CrabLlvm.startup.heap");
+      switch (CrabHeapAnalysis) {
+      case LLVM_DSA:
+        #ifdef HAVE_DSA
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Started llvm-dsa analysis\n";);                  
+        m_mem.reset
+	  (new LlvmDsaHeapAbstraction(M,&getAnalysis<SteensgaardDataStructures>(),
+				      CrabDsaDisambiguateUnknown,
+				      CrabDsaDisambiguatePtrCast,
+				      CrabDsaDisambiguateExternal));
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Finished llvm-dsa analysis\n";);      
+        break;
+        #else
+        // execute CI_SEA_DSA
+        #endif      
+      case CI_SEA_DSA:
+      case CS_SEA_DSA: {
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Started sea-dsa analysis\n";);
+        CallGraph& cg = getAnalysis<CallGraphWrapperPass>().getCallGraph();      
+        const DataLayout& dl = M.getDataLayout();
+        m_mem.reset
+	  (new SeaDsaHeapAbstraction(M, cg, dl, *m_tli,
+				     (CrabHeapAnalysis == CS_SEA_DSA),
+				     CrabDsaDisambiguateUnknown,
+				     CrabDsaDisambiguatePtrCast,
+				     CrabDsaDisambiguateExternal));
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Finished sea-dsa analysis\n";);      
+        break;
+      }
+      case AUTO_SEA_DSA: {
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Started sea-dsa analysis (auto)\n";);
+        CallGraph& cg = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+        m_mem = auto_dsa_impl::build(M, cg, *m_tli);
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Finished sea-dsa analysis (auto)\n";);
+        break;
+      }
+      case TYPE_BASED:
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Started type-based heap abstraction\n";);
+        m_mem.reset(new TypeHeapAbstraction(M, M.getDataLayout()));
+        CRAB_VERBOSE_IF(1, get_crab_os() << "Finished type-based heap abstraction\n";);
+        break;
+      default:
+        errs() << "Warning: running crab-llvm without memory analysis\n";
+      }
+      if (CrabHeapSnapshot != "" &&
+	  !SnapshotHeapAbstraction::write(*m_mem, M, CrabHeapSnapshot, heapSnapshotConfig())) {
+	errs() << "Warning: cannot write heap snapshot " << CrabHeapSnapshot << "\n";
+      }
+    }
+
+    // -- the snapshot stores the regions before merging so the budget
+    //    can change between runs.
+    if (CrabTrackLev != NUM && CrabRegionBudget > 0) {
+      if (CrabInter) {
+	// the regions of a callsite are those of the caller: they are
+	// not merged as the regions of the callee so the actual and
+	// formal regions would not match.
+	errs() << "Warning: --crab-region-budget ignored with --crab-inter\n";
+      } else {
+	m_mem.reset(new BudgetHeapAbstraction(M, m_mem, CrabRegionBudget));
+      }
     }
 
     m_params.dom = CrabLlvmDomain;
@@ -1458,6 +3833,8 @@ namespace crab_llvm {
     m_params.run_backward = CrabBackward;
     m_params.run_liveness = CrabLive;
     m_params.relational_threshold = CrabRelationalThreshold;
+    m_params.relational_threshold_loops = CrabRelationalThresholdLoops;
+    m_params.relational_threshold_packs = CrabRelationalThresholdPacks;
     m_params.widening_delay = CrabWideningDelay;
     m_params.narrowing_iters = CrabNarrowingIters;
     m_params.widening_jumpset = CrabWideningJumpSet;
@@ -1467,27 +3844,333 @@ namespace crab_llvm {
     m_params.print_unjustified_assumptions = CrabPrintUnjustifiedAssumptions;
     m_params.print_summaries = CrabPrintSumm;
     m_params.store_invariants = CrabStoreInvariants;
+    m_params.invariants_storage = CrabInvariantsStorage;
+    m_params.invariants_in_memory = CrabInvariantsInMemory;
     m_params.keep_shadow_vars = CrabKeepShadows;
     m_params.check = CrabCheck;
     m_params.check_verbose = CrabCheckVerbose;
+    m_params.cancel = m_cancel;
+    m_params.progress = m_progress;
+
+    if (m_params.invariants_storage == SPILL_STORAGE) {
+      m_state->spill_store =
+	boost::make_shared<lazy_impl::spill_store>(m_params.invariants_in_memory);
+    }
         
+    if (CrabIncremental != "") {
+      if (CrabInter) {
+	errs() << "Warning: --crab-incremental ignored with --crab-inter\n";
+      } else if (std::error_code ec = sys::fs::create_directories(CrabIncremental)) {
+	errs() << "Warning: cannot create directory " << CrabIncremental
+	       << ": " << ec.message() << "\n";
+      }
+    }
+
+    if (CrabChecksCache != "") {
+      if (CrabIncremental != "" && !CrabInter) {
+	errs() << "Warning: --crab-checks-cache ignored with --crab-incremental\n";
+      } else if (!m_params.check) {
+	errs() << "Warning: --crab-checks-cache requires --crab-check\n";
+      } else if (std::error_code ec = sys::fs::create_directories(CrabChecksCache)) {
+	errs() << "Warning: cannot create directory " << CrabChecksCache
+	       << ": " << ec.message() << "\n";
+      }
+    }
+
+    if (CrabExportInvariants != "") {
+      if (!m_params.store_invariants) {
+	errs() << "Warning: --crab-export-invariants requires --crab-store-invariants\n";
+      } else {
+	m_state->invariant_exporter = make_unique<export_impl::invariant_writer>
+	  (CrabExportInvariants, CrabExportJson, m_params.keep_shadow_vars);
+	if (!m_state->invariant_exporter->good()) {
+	  errs() << "Warning: cannot open " << CrabExportInvariants << "\n";
+	  m_state->invariant_exporter.reset();
+	}
+      }
+    }
+    
+    if (CrabTrace != "" && !is_tracing() && !start_trace(CrabTrace)) {
+      errs() << "Warning: cannot open " << CrabTrace << "\n";
+    }
+
+    if (CrabProfile != "") {
+      if (CrabInter) {
+	errs() << "Warning: --crab-profile ignored with --crab-inter\n";
+      } else {
+	bool counters = false;
+	if (CrabProfileCounters) {
+	  perf_sample s;
+	  counters = read_perf_counters(s);
+	  if (!counters) {
+	    errs() << "Warning: hardware performance counters are not available "
+		   << "(see /proc/sys/kernel/perf_event_paranoid)\n";
+	  }
+	}
+	m_state->profile = make_unique<profile_impl::profiler>(counters);
+      }
+    } else if (CrabProfileCounters) {
+      errs() << "Warning: --crab-profile-counters requires --crab-profile\n";
+    }
+    
+    if (CrabExtractSlow > 0) {
+      if (CrabInter) {
+	errs() << "Warning: --crab-extract-slow ignored with --crab-inter\n";
+      } else if (m_stream) {
+	// the functions could be modified before the reproducers are written
+	errs() << "Warning: --crab-extract-slow ignored with streaming\n";
+      } else {
+	m_state->reproducers = make_unique<repro_impl::recorder>();
+      }
+    }
+    
+    if (CrabChecksStream != "") {
+      if (!m_params.check) {
+	errs() << "Warning: --crab-checks-stream requires --crab-check\n";
+      } else {
+	m_state->checks_streamer = make_unique<export_impl::checks_writer>(CrabChecksStream);
+	if (!m_state->checks_streamer->good()) {
+	  errs() << "Warning: cannot open " << CrabChecksStream << "\n";
+	  m_state->checks_streamer.reset();
+	}
+      }
+    }
+    
+    if (roots_impl::enabled()) {
+      unsigned num_roots = m_state->roots.init(M, getAnalysis<CallGraphWrapperPass>().getCallGraph());
+      CRAB_VERBOSE_IF(1, get_crab_os() << m_state->roots.size() << " functions reachable from "
+		                       << num_roots << " roots\n");
+    }
+    
+    if (check_only_impl::enabled()) {
+      if (!m_params.check) {
+	errs() << "Warning: --crab-check-only requires --crab-check\n";
+      }
+      if (!m_state->check_only.init(M, getAnalysis<CallGraphWrapperPass>().getCallGraph(),
+				    CrabInter)) {
+	errs() << "Warning: no assertion found at " << CrabCheckOnly << "\n";
+      }
+    }
+    
+    if (CrabStopOnError && !m_params.check) {
+      errs() << "Warning: --crab-stop-on-error requires --crab-check\n";
+    }
+
+    if (CrabInter && CrabStopOnError) {
+      errs() << "Warning: --crab-stop-on-error ignored with --crab-inter\n";
+    }
+    
+    if (CrabInter && (CrabFnTimeout > 0 || CrabFnMemory > 0)) {
+      errs() << "Warning: --crab-fn-timeout-ms and --crab-fn-mem-mb ignored "
+	     << "with --crab-inter\n";
+    }
+    if (!CrabPortfolio.empty() && (CrabFnTimeout > 0 || CrabFnMemory > 0)) {
+      errs() << "Warning: --crab-fn-timeout-ms and --crab-fn-mem-mb ignored "
+	     << "with --crab-portfolio\n";
+    }
+    if (CrabInter && m_params.dom == ADAPT_TERMS_ZONES) {
+      errs() << "Warning: --crab-dom=adapt-rtz is rtz with --crab-inter\n";
+      m_params.dom = TERMS_ZONES;
+    }
+    
+    if ((CrabMaxCfgs > 0 || reusesResults()) && !CrabInter) {
+      // -- the CFGs of the inter-procedural analysis depend on the
+      //    whole call graph so they are never evicted
+      m_cfg_man.set_capacity(CrabMaxCfgs);
+      m_cfg_man.set_builder([this](const Function &F) {
+	  return buildIntraCfg(const_cast<Function&>(F), m_vfac, *m_mem, CrabTrackLev, *m_tli);
+	});
+    }
+    
+    if (m_stream && CrabExportInvariantsDb != "") {
+      errs() << "Warning: --crab-export-invariants-db ignored with streaming\n";
+    }
+    
+    if (CrabConfigProfile != "") {
+      if (CrabInter) {
+	errs() << "Warning: --crab-config-profile ignored with --crab-inter\n";
+      } else {
+	m_state->config_profile =
+	  make_unique<config_profile_impl::profile>(M, *m_mem);
+	if (!m_state->config_profile->load(CrabConfigProfile)) {
+	  errs() << "Warning: cannot read " << CrabConfigProfile
+		 << ". The options of the previous run are not used.\n";
+	  m_state->config_profile = make_unique<config_profile_impl::profile>(M, *m_mem);
+	}
+      }
+    }
+    
+    if (CrabModuleBudget > 0) {
+      if (CrabInter) {
+	errs() << "Warning: --crab-module-budget ignored with --crab-inter\n";
+      } else {
+	// -- the threads share the budget
+	unsigned num_threads = (CrabThreads > 1 && canRunInParallel(m_params) &&
+				!hasFunctionBudget() && !m_stream) ? (unsigned) CrabThreads : 1U;
+	m_state->budget =
+	  make_unique<budget_impl::scheduler>(M, *m_state, CrabModuleBudget, num_threads);
+      }
+    }
+    
+    if (CrabDedupFunctions) {
+      if (CrabInter || m_stream || m_state->config_profile || m_state->budget ||
+	  check_only_impl::enabled()) {
+	errs() << "Warning: --crab-dedup-functions ignored with --crab-inter, streaming, "
+	       << "--crab-config-profile, --crab-module-budget or --crab-check-only\n";
+      } else if (CrabTrackLev != NUM) {
+	// -- the shadow variables of the heap abstraction are not renamed
+	errs() << "Warning: --crab-dedup-functions ignored with --crab-track=ptr or arr\n";
+      } else {
+	m_state->dedup = make_unique<dedup_impl::table>();
+      }
+    }
+    
+    // set if some function is modified while streaming
+    bool changed = false;
     if (CrabInter){
-      InterCrabLlvm_Impl inter_crab(M, CrabTrackLev, m_mem, m_vfac, m_cfg_man, *m_tli);
+      // CFGs are built sequentially if their names can be printed
+      unsigned num_threads = canRunInParallel(m_params) ? (unsigned) CrabThreads : 1U;
+      InterCrabLlvm_Impl inter_crab(M, CrabTrackLev, m_mem, m_vfac, m_cfg_man, *m_tli,
+				    m_state.get(), num_threads);
       InvarianceAnalysisResults results = { m_pre_map, m_post_map, m_checks_db};
-      inter_crab.Analyze(m_params, assumption_map_t(), results);
+      std::string cache_file;
+      if (CrabChecksCache != "" && !CrabBuildOnlyCFG) {
+	cache_file = checks_cache_impl::getFileName(CrabChecksCache, M, m_params, *m_mem);
+      }
+      if (cache_file != "" && checks_cache_impl::load(cache_file, m_checks_db)) {
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Reused checks of the module from "
+			                 << cache_file << "\n");
+      } else {
+	inter_crab.Analyze(m_params, assumption_map_t(), results);
+	if (cache_file != "") {
+	  checks_cache_impl::store(cache_file, m_checks_db);
+	}
+      }
+      if (m_state->invariant_exporter) {
+	for (auto &F : M) {
+	  if (isTrackable(F)) {
+	    m_state->invariant_exporter->write(F, m_pre_map, m_post_map);
+	  }
+	}
+      }
+      if (m_state->checks_streamer) {
+	// the inter-procedural checker does not separate functions
+	m_state->checks_streamer->write(M.getModuleIdentifier(), m_checks_db);
+      }
+      if (m_stream) {
+	// functions are only released once the whole module is analyzed
+	CallGraph &cg = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+	for (auto &F : M) {
+	  if (!isTrackable(F)) continue;
+	  changed |= m_stream(F, &cg);
+	  release_function(F);
+	}
+      }
+    } else if (CrabThreads > 1 && canRunInParallel(m_params) && !hasFunctionBudget() &&
+	       !m_stream) {
+      runOnModuleParallel(M, CrabThreads);
+      m_cfg_man.evict();
     } else {
-      for (auto &f : M) {
-        runOnFunction (f); 
+      if (CrabThreads > 1) {
+	errs() << "Warning: --crab-threads ignored because of --crab-stats, "
+	       << "printing options, OCT/PK/BOXES domains, function budgets or streaming\n";
+	if (usesLibraryManager(m_params)) {
+	  errs() << "Warning: use --jobs of crabllvm.py to analyze functions "
+		 << "with OCT/PK/BOXES in parallel processes\n";
+	}
+      }
+      std::vector<Function*> schedule = schedule_impl::getSchedule(M, *m_state);
+      unsigned num_functions = std::count_if(schedule.begin(), schedule.end(),
+					     [](Function *f) { return isTrackable(*f); });
+      unsigned num_done = 0;
+      for (Function *f : schedule) {
+	if (m_params.is_cancelled()) {
+	  CRAB_VERBOSE_IF(1, get_crab_os() << "Analysis cancelled before "
+			                   << f->getName().str() << "\n");
+	  break;
+	}
+        runOnFunction (*f); 
+	if (isTrackable(*f)) {
+	  report_progress(f->getName().str(), ++num_done, num_functions);
+	  if (m_stream) {
+	    changed |= m_stream(*f, &getAnalysis<CallGraphWrapperPass>().getCallGraph());
+	    release_function(*f);
+	  }
+	  m_cfg_man.evict();
+	}
+	if (CrabStopOnError && m_checks_db.get_total_error() > 0) {
+	  CRAB_VERBOSE_IF(1, get_crab_os() << "Stopped after the first error in "
+			                   << f->getName().str() << "\n");
+	  break;
+	}
+      }
+    }
+    if (m_state->reproducers) {
+      m_state->reproducers->write(CrabExtractDir, m_command_line);
+      m_state->reproducers.reset();
+    }
+    if (!CrabInter && CrabScheduleChecks && !m_params.is_cancelled() &&
+	!(CrabStopOnError && m_checks_db.get_total_error() > 0)) {
+      // the history is only complete if all functions were analyzed
+      schedule_impl::storeHistory();
+    }
+    if (m_state->budget) {
+      if (unsigned n = m_state->budget->num_downgraded()) {
+	errs() << "Warning: " << n << " functions were analyzed with cheaper options "
+	       << "to meet --crab-module-budget\n";
+      }
+      if (m_state->budget->exceeded()) {
+	errs() << "Warning: --crab-module-budget exceeded\n";
+      }
+      m_state->budget.reset();
+    }
+    if (m_state->config_profile) {
+      if (!m_state->config_profile->store(CrabConfigProfile)) {
+	errs() << "Warning: cannot write " << CrabConfigProfile << "\n";
       }
+      m_state->config_profile.reset();
+    }
+    if (m_state->dedup) {
+      count_max_stat("CrabLlvm.count.dedup_functions", m_state->dedup->num_merged());
+      m_state->dedup.reset();
+    }
+    if (CrabExportInvariantsDb != "" && !m_stream) {
+      if (!m_params.store_invariants) {
+	errs() << "Warning: --crab-export-invariants-db requires --crab-store-invariants\n";
+      } else if (!export_impl::writeInvariantDb(CrabExportInvariantsDb, M, m_pre_map,
+						 m_post_map, m_params.keep_shadow_vars)) {
+	errs() << "Warning: cannot write " << CrabExportInvariantsDb << "\n";
+      }
+    }
+    // close the export files so they are complete when runOnModule
+    // returns
+    m_state->invariant_exporter.reset();
+    m_state->checks_streamer.reset();
+    if (m_state->profile) {
+      m_state->profile->write(CrabProfile);
+      m_state->profile.reset();
     }
 
     if (CrabStats) {
       crab::CrabStats::PrintBrunch (crab::outs());
+      print_stats(llvm::outs());
+      if (m_state->alloc_stats) {
+	m_state->alloc_stats->print(llvm::outs(), 10);
+	m_state->alloc_stats.reset();
+      }
     }
     
     if (CrabCheck) {
       llvm::outs() << "\n************** ANALYSIS RESULTS ****************\n";
       print_checks(llvm::outs());
+      if (check_only_impl::enabled()) {
+	// -- all copies of the assertion must be proven
+	const char *status = (m_state->check_only.empty() ? "not found" :
+			      get_total_error_checks() > 0 ? "error" :
+			      get_total_warning_checks() > 0 ? "warning" :
+			      get_total_safe_checks() > 0 ? "safe" : "not analyzed");
+	llvm::outs() << "Check at " << CrabCheckOnly << ": " << status << "\n";
+      }
       llvm::outs() << "************** ANALYSIS RESULTS END*************\n";
 		      
       if (CrabStats) {		     
@@ -1502,20 +4185,25 @@ namespace crab_llvm {
   	  llvm::outs() << "BRUNCH_STAT Result INCONCLUSIVE\n";
         }
         llvm::outs() << "BRUNCH_STAT NumOfBlocksWithInvariants "
- 	 	     << num_nontrivial_blocks << "\n";
+ 	 	     << stat_value("CrabLlvm.count.nontrivial_blocks") << "\n";
         llvm::outs() << "BRUNCH_STAT SizeOfInvariants "       
-		     << num_invars << "\n";
+		     << stat_value("CrabLlvm.count.invariants_size") << "\n";
         llvm::outs() << "************** BRUNCH STATS END *****************\n\n";
       }
     }
     
-   return false;
+   return changed;
   }
 
   void CrabLlvmPass::getAnalysisUsage (AnalysisUsage &AU) const {
     AU.setPreservesAll ();
     #ifdef HAVE_DSA
-    AU.addRequiredTransitive<SteensgaardDataStructures> ();
+    // -- llvm-dsa is only run if it is the selected heap analysis and
+    //    the translation queries it (a heap snapshot may be missing
+    //    or stale so the analysis must be available then too)
+    if (CrabHeapAnalysis == LLVM_DSA && CrabTrackLev != NUM) {
+      AU.addRequiredTransitive<SteensgaardDataStructures> ();
+    }
     #endif 
     AU.addRequired<TargetLibraryInfoWrapperPass>();
     AU.addRequired<UnifyFunctionExitNodes>();
@@ -1531,6 +4219,10 @@ namespace crab_llvm {
   bool CrabLlvmPass::has_cfg(llvm::Function &F) {
     return m_cfg_man.has_cfg(F);
   }
+
+  bool CrabLlvmPass::can_run_in_parallel() const {
+    return canRunInParallel(m_params);
+  }
   
   cfg_ref_t CrabLlvmPass::get_cfg(llvm::Function &F) {
     assert(m_cfg_man.has_cfg(F));
@@ -1544,7 +4236,8 @@ namespace crab_llvm {
     if (!keep_shadows)
       shadows = std::vector<varname_t>(m_vfac.get_shadow_vars().begin(),
 				       m_vfac.get_shadow_vars().end());    
-    return lookup(m_pre_map, *block, shadows);
+    return lookup(m_pre_map, m_pre_map_no_shadows, *block, shadows,
+		  &m_cache_mutex);
   }   
 
   // return invariants that hold at the exit of block
@@ -1554,7 +4247,74 @@ namespace crab_llvm {
     if (!keep_shadows)
       shadows = std::vector<varname_t>(m_vfac.get_shadow_vars().begin(),
 				       m_vfac.get_shadow_vars().end());    
-    return lookup(m_post_map, *block, shadows);
+    return lookup(m_post_map, m_post_map_no_shadows, *block, shadows,
+		  &m_cache_mutex);
+  }
+
+  // return the interval of v at the entry of block
+  CrabLlvmPass::interval_t
+  CrabLlvmPass::get_range(const llvm::Value *v, const llvm::BasicBlock *block) {
+    {
+      std::lock_guard<std::mutex> lock(m_cache_mutex);
+      auto it = m_block_ranges.find(block);
+      if (it != m_block_ranges.end()) {
+	auto rit = it->second.find(v);
+	if (rit != it->second.end()) return rit->second;
+      }
+    }
+    // -- the shadow variables are not forgotten: it would not refine
+    //    the interval of v
+    std::vector<const Value*> vals(1, v);
+    std::vector<interval_t> res;
+    if (wrapper_dom_ptr pre = get_pre(block, true)) {
+      range_impl::projector p(vals, m_vfac, m_cache_mutex, res);
+      visitAbsDomWrappee(pre, p);
+    } else {
+      res.push_back(interval_t::top());
+    }
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    // another thread might have inserted it in the meantime
+    return m_block_ranges[block].insert(std::make_pair(v, res[0])).first->second;
+  }
+
+  // return the interval of v right after inst
+  CrabLlvmPass::interval_t
+  CrabLlvmPass::get_range(const llvm::Value *v, const llvm::Instruction *inst) {
+    {
+      std::lock_guard<std::mutex> lock(m_cache_mutex);
+      auto it = m_inst_ranges.find(inst);
+      if (it != m_inst_ranges.end()) {
+	auto rit = it->second.find(v);
+	if (rit != it->second.end()) return rit->second;
+      }
+    }
+    const BasicBlock *block = inst->getParent();
+    const Function &F = *block->getParent();
+    wrapper_dom_ptr pre = get_pre(block, true);
+    if (!pre || !m_cfg_man.has_cfg(F)) {
+      return interval_t::top();
+    }
+    // -- inst, its operands and v are projected together
+    std::vector<const Value*> vals(1, inst);
+    for (auto &op: inst->operands()) {
+      if (!isa<Constant>(op.get()) && !isa<BasicBlock>(op.get()) &&
+	  std::find(vals.begin(), vals.end(), op.get()) == vals.end()) {
+	vals.push_back(op.get());
+      }
+    }
+    if (std::find(vals.begin(), vals.end(), v) == vals.end()) {
+      vals.push_back(v);
+    }
+    std::vector<interval_t> res;
+    range_impl::propagator p(m_cfg_man[F].get_node(block), *inst,
+			     range_impl::projector(vals, m_vfac, m_cache_mutex, res));
+    visitAbsDomWrappee(pre, p);
+    std::lock_guard<std::mutex> lock(m_cache_mutex);
+    range_map_t &ranges = m_inst_ranges[inst];
+    for (unsigned i=0, e=vals.size(); i < e; ++i) {
+      ranges.insert(std::make_pair(vals[i], res[i]));
+    }
+    return ranges.find(v)->second;
   }
 
   /**
@@ -0,0 +1,50 @@
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CrabLlvmUtils.hh"
+
+using namespace llvm;
+
+extern cl::opt<unsigned> CrabFnTimeout;
+extern cl::opt<unsigned> CrabFnMemory;
+extern cl::opt<crab_llvm::CrabDomain> CrabLlvmDomain;
+extern cl::opt<bool> CrabCheckLayered;
+extern cl::list<crab_llvm::CrabDomain> CrabPortfolio;
+
+namespace crab_llvm {
+
+  bool hasFunctionBudget() {
+    return CrabFnTimeout > 0 || CrabFnMemory > 0 || CrabLlvmDomain == ADAPT_TERMS_ZONES;
+  }
+
+  bool usesLibraryManager(const AnalysisParams &params) {
+    if (usesLibraryManager(params.dom) ||
+	(params.run_inter && usesLibraryManager(params.sum_dom))) {
+      return true;
+    }
+    if (CrabCheckLayered && params.check == ASSERTION &&
+	anyUsesLibraryManager(layered_domains)) {
+      return true;
+    }
+    return (anyUsesLibraryManager(CrabPortfolio) ||
+	    anyUsesLibraryManager(params.path_layers));
+  }
+
+  bool canRunInParallel(const AnalysisParams &params) {
+    return !(params.stats || params.print_invars ||
+	     (params.print_preconds && params.run_backward) ||
+	     params.print_unjustified_assumptions ||
+	     usesLibraryManager(params));
+  }
+
+  crab::cfg::debug_info getDebugInfo(const Instruction &I) {
+    const DebugLoc &dloc = I.getDebugLoc();
+    if (!dloc) return crab::cfg::debug_info();
+    std::string file = (*dloc).getFilename();
+    return crab::cfg::debug_info(file == "" ? "unknown file" : file,
+				 dloc.getLine(), dloc.getCol());
+  }
+
+} // end namespace crab_llvm
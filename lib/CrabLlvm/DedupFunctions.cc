@@ -0,0 +1,216 @@
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/DedupFunctions.hh"
+#include "crab_llvm/IncrementalAnalysis.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab/common/debug.hpp"
+
+#include <map>
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  namespace dedup_impl {
+
+    // arguments, blocks and instructions of F in order
+    static values_t getLocals(const Function &F) {
+      values_t res;
+      for (auto &A: F.args()) res.push_back(&A);
+      for (auto &B: F) {
+	res.push_back(&B);
+	for (auto &I: B) res.push_back(&I);
+      }
+      return res;
+    }
+
+    static std::string getKey(const Function &F) {
+      boost::unordered_map<const Value*, unsigned> ids;
+      values_t locals = getLocals(F);
+      for (unsigned i = 0; i < locals.size(); ++i) ids[locals[i]] = i;
+      
+      std::string buf;
+      raw_string_ostream o(buf);
+      F.getFunctionType()->print(o);
+      o << "\n";
+      for (auto &B: F) {
+	o << "bb " << B.size() << "\n";
+	for (auto &I: B) {
+	  // -- their operands refer to the debug information of F
+	  if (isa<DbgInfoIntrinsic>(I)) {
+	    o << "dbg\n";
+	    continue;
+	  }
+	  o << I.getOpcodeName() << " ";
+	  I.getType()->print(o);
+	  if (auto *OBO = dyn_cast<OverflowingBinaryOperator>(&I)) {
+	    o << " nuw=" << OBO->hasNoUnsignedWrap() << " nsw=" << OBO->hasNoSignedWrap();
+	  }
+	  if (auto *PEO = dyn_cast<PossiblyExactOperator>(&I)) {
+	    o << " exact=" << PEO->isExact();
+	  }
+	  if (auto *CI = dyn_cast<CmpInst>(&I)) {
+	    o << " pred=" << (unsigned) CI->getPredicate();
+	  }
+	  if (auto *GEP = dyn_cast<GetElementPtrInst>(&I)) {
+	    o << " inbounds=" << GEP->isInBounds() << " ";
+	    GEP->getSourceElementType()->print(o);
+	  }
+	  if (auto *AI = dyn_cast<AllocaInst>(&I)) {
+	    o << " ";
+	    AI->getAllocatedType()->print(o);
+	  }
+	  if (auto *EVI = dyn_cast<ExtractValueInst>(&I)) {
+	    for (unsigned idx: EVI->getIndices()) o << " #" << idx;
+	  }
+	  if (auto *IVI = dyn_cast<InsertValueInst>(&I)) {
+	    for (unsigned idx: IVI->getIndices()) o << " #" << idx;
+	  }
+	  for (auto &U: I.operands()) {
+	    auto it = ids.find(U.get());
+	    if (it != ids.end()) {
+	      o << " %" << it->second;
+	    } else {
+	      o << " ";
+	      U->printAsOperand(o, true);
+	    }
+	  }
+	  if (auto *PN = dyn_cast<PHINode>(&I)) {
+	    for (unsigned i = 0; i < PN->getNumIncomingValues(); ++i) {
+	      o << " %" << ids[PN->getIncomingBlock(i)];
+	    }
+	  }
+	  o << "\n";
+	}
+      }
+      o.flush();
+      return buf;
+    }
+
+    // Add total checks of kind: the located ones at the corresponding
+    // location of locs and the rest without location.
+    static void addChecks(checks_db_t &checks, crab::checker::check_kind_t kind, unsigned total,
+			  const std::vector<std::pair<crab::checker::check_kind_t,
+			                              crab::cfg::debug_info>> &located,
+			  const std::map<crab::cfg::debug_info, crab::cfg::debug_info> &locs) {
+      for (auto &c: located) {
+	if (c.first != kind) continue;
+	// -- replaying the invariants can decide more checks than the
+	//    analysis
+	if (total == 0) break;
+	auto it = locs.find(c.second);
+	checks.add(kind, it != locs.end() ? it->second : crab::cfg::debug_info());
+	--total;
+      }
+      for (; total > 0; --total) checks.add(kind);
+    }
+
+    /** Begin table **/
+    lin_cst_sys_t table::rename(const lin_cst_sys_t &csts,
+				const boost::unordered_map<const Value*, const Value*> &corr,
+				llvm_variable_factory &vfac) const {
+      lin_cst_sys_t res;
+      for (auto cst: csts) {
+	lin_exp_t e(cst.expression().constant());
+	bool all_named = true;
+	for (auto t: cst.expression()) {
+	  boost::optional<const Value*> v = t.second.name().get();
+	  if (!v) {
+	    all_named = false;
+	    break;
+	  }
+	  // -- the values that are not local (globals) are shared
+	  auto it = corr.find(*v);
+	  boost::optional<var_t> x =
+	    incremental_impl::mkVar(*(it == corr.end() ? *v : it->second), vfac);
+	  if (!x) {
+	    all_named = false;
+	    break;
+	  }
+	  e = e + (t.first * (*x));
+	}
+	if (!all_named) continue;
+	if (cst.is_equality()) {
+	  res += lin_cst_t(e, lin_cst_t::EQUALITY);
+	} else if (cst.is_inequality()) {
+	  res += lin_cst_t(e, lin_cst_t::INEQUALITY);
+	} else {
+	  res += lin_cst_t(e, lin_cst_t::DISEQUALITY);
+	}
+      }
+      return res;
+    }
+
+    table::table(): m_merged(0) {}
+
+    // Return the function identical to F seen before, if any.
+    // Otherwise, F becomes the representative of its group.
+    const Function* table::getRepresentative(const Function &F) {
+      std::string key = getKey(F);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto res = m_reps.insert(std::make_pair(key, &F));
+      return (res.second ? nullptr : res.first->second);
+    }
+
+    // the representative rep was analyzed with dom
+    void table::setResults(const Function &rep, CrabDomain dom, const checks_db_t &checks) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      result r = { dom, checks.get_total_safe(), checks.get_total_error(),
+		   checks.get_total_warning() };
+      m_results[&rep] = r;
+    }
+
+    // Add the results of F from those of its representative rep
+    // whose CFG is rep_cfg. Return false if rep was not analyzed
+    // (e.g., the analysis was cancelled).
+    bool table::copyResults(const Function &rep, cfg_ref_t rep_cfg, const Function &F,
+			    llvm_variable_factory &vfac, InvarianceAnalysisResults &results) {
+      auto it = m_results.find(&rep);
+      if (it == m_results.end()) return false;
+      const result &r = it->second;
+      values_t from = getLocals(rep), to = getLocals(F);
+      boost::unordered_map<const Value*, const Value*> corr;
+      // -- debug locations of the instructions of rep and F
+      std::map<crab::cfg::debug_info, crab::cfg::debug_info> locs;
+      for (unsigned i = 0; i < from.size(); ++i) {
+	corr[from[i]] = to[i];
+	if (auto *I = dyn_cast<Instruction>(from[i])) {
+	  locs.insert(std::make_pair(getDebugInfo(*I),
+				     getDebugInfo(*cast<Instruction>(to[i]))));
+	}
+      }
+      // -- the checks of rep are located before the invariants of F
+      //    are added
+      auto located = incremental_impl::locateChecks(rep_cfg, results.premap);
+      for (auto &B: rep) {
+	const BasicBlock &FB = *cast<BasicBlock>(corr[&B]);
+	auto pre_it = results.premap.find(&B);
+	if (pre_it != results.premap.end()) {
+	  lin_cst_sys_t csts = rename(pre_it->second->to_linear_constraints(), corr, vfac);
+	  update(results.premap, FB, incremental_impl::mkWrapper(r.dom, csts));
+	}
+	auto post_it = results.postmap.find(&B);
+	if (post_it != results.postmap.end()) {
+	  lin_cst_sys_t csts = rename(post_it->second->to_linear_constraints(), corr, vfac);
+	  update(results.postmap, FB, incremental_impl::mkWrapper(r.dom, csts));
+	}
+      }
+      checks_db_t checks;
+      addChecks(checks, crab::checker::_SAFE, r.safe, located, locs);
+      addChecks(checks, crab::checker::_ERR, r.err, located, locs);
+      addChecks(checks, crab::checker::_WARN, r.warn, located, locs);
+      mergeChecks(results.checksdb, std::move(checks));
+      m_merged++;
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Reused the analysis of " << rep.getName()
+				       << " for " << F.getName() << "\n");
+      return true;
+    }
+    /** End table **/
+  } // end namespace dedup_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,221 @@
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/ExportInvariants.hh"
+#include "crab_llvm/LazyInvariants.hh"
+#include "crab_llvm/InvariantDb.hh"
+#include "crab_llvm/Support/ReduceConstraints.hh"
+
+#include <cstdio>
+#include <iterator>
+
+using namespace llvm;
+
+// also used by InsertInvariants
+extern cl::opt<bool> CrabReduceConstraints;
+
+namespace crab_llvm {
+
+  namespace export_impl {
+
+    void writeJsonString(std::ostream &o, StringRef str) {
+      o << '"';
+      for (char c: str) {
+	switch (c) {
+	case '"':  o << "\\\""; break;
+	case '\\': o << "\\\\"; break;
+	case '\n': o << "\\n"; break;
+	case '\t': o << "\\t"; break;
+	default:
+	  if ((unsigned char) c < 0x20) {
+	    char buf[8];
+	    snprintf(buf, sizeof(buf), "\\u%04x", (unsigned) c);
+	    o << buf;
+	  } else {
+	    o << c;
+	  }
+	}
+      }
+      o << '"';
+    }
+
+    // Return the constraints that can be exported. The redundant ones
+    // are removed after the shadow variables so they are not implied
+    // by constraints that are not exported.
+    static std::vector<lin_cst_t> getExportedConstraints(wrapper_dom_ptr absval,
+							 bool keep_shadows) {
+      lin_cst_sys_t csts;
+      for (auto cst: absval->to_linear_constraints()) {
+	bool has_shadows = false;
+	for (auto t: cst.expression()) {
+	  if (!t.second.name().get()) {
+	    has_shadows = true;
+	    break;
+	  }
+	}
+	if (!has_shadows || keep_shadows) {
+	  csts += cst;
+	}
+      }
+      if (CrabReduceConstraints) {
+	csts = reduceConstraints(csts);
+      }
+      return std::vector<lin_cst_t>(csts.begin(), csts.end());
+    }
+
+    static unsigned getKind(const lin_cst_t &cst) {
+      return (cst.is_equality() ? 0 : (cst.is_inequality() ? 1 : 2));
+    }
+
+    /** Begin invariant_writer **/
+    void invariant_writer::writeU32(uint32_t n) {
+      char buf[4];
+      for (unsigned i = 0; i < 4; ++i) {
+	buf[i] = (char) ((n >> (8*i)) & 0xff);
+      }
+      m_out.write(buf, 4);
+    }
+
+    void invariant_writer::writeString(StringRef str) {
+      writeU32(str.size());
+      m_out.write(str.data(), str.size());
+    }
+
+    std::vector<lin_cst_t> invariant_writer::getConstraints(wrapper_dom_ptr absval) {
+      return getExportedConstraints(absval, m_keep_shadows);
+    }
+
+    void invariant_writer::writeBinary(wrapper_dom_ptr absval) {
+      std::vector<lin_cst_t> csts = getConstraints(absval);
+      writeU32(csts.size());
+      for (auto &cst: csts) {
+	m_out.put((char) getKind(cst));
+	writeString(cst.expression().constant().get_str());
+	writeU32(std::distance(cst.expression().begin(), cst.expression().end()));
+	for (auto t: cst.expression()) {
+	  writeString(t.first.get_str());
+	  writeString(t.second.name().str());
+	}
+      }
+    }
+
+    void invariant_writer::writeJson(wrapper_dom_ptr absval) {
+      static const char *kinds[] = {"eq", "le", "ne"};
+      m_out << "[";
+      bool first = true;
+      for (auto &cst: getConstraints(absval)) {
+	if (!first) m_out << ",";
+	first = false;
+	m_out << "{\"kind\":\"" << kinds[getKind(cst)] << "\",\"constant\":\""
+	      << cst.expression().constant().get_str() << "\",\"terms\":[";
+	bool first_term = true;
+	for (auto t: cst.expression()) {
+	  if (!first_term) m_out << ",";
+	  first_term = false;
+	  m_out << "[\"" << t.first.get_str() << "\",";
+	  writeJsonString(m_out, t.second.name().str());
+	  m_out << "]";
+	}
+	m_out << "]}";
+      }
+      m_out << "]";
+    }
+
+    invariant_writer::invariant_writer(const std::string &file, bool json, bool keep_shadows)
+      : m_out(file, json ? std::ios::out : std::ios::out | std::ios::binary),
+	m_json(json), m_keep_shadows(keep_shadows) {
+      if (m_out && !m_json) {
+	m_out.write("CRABINV", 7);
+	m_out.put((char) 1);
+      }
+    }
+
+    void invariant_writer::write(const Function &F, const invariant_map_t &premap,
+				 const invariant_map_t &postmap) {
+      std::vector<const BasicBlock*> blocks;
+      for (auto &B: F) {
+	if (premap.find(&B) != premap.end() && postmap.find(&B) != postmap.end()) {
+	  blocks.push_back(&B);
+	}
+      }
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_json) {
+	m_out << "{\"function\":";
+	writeJsonString(m_out, F.getName());
+	m_out << ",\"blocks\":[";
+	for (unsigned i = 0; i < blocks.size(); ++i) {
+	  const BasicBlock *B = blocks[i];
+	  if (i > 0) m_out << ",";
+	  m_out << "{\"block\":";
+	  writeJsonString(m_out, B->getName());
+	  m_out << ",\"pre\":";
+	  writeJson(lazy_impl::materialize(premap.find(B)->second));
+	  m_out << ",\"post\":";
+	  writeJson(lazy_impl::materialize(postmap.find(B)->second));
+	  m_out << "}";
+	}
+	m_out << "]}\n";
+      } else {
+	writeString(F.getName());
+	writeU32(blocks.size());
+	for (const BasicBlock *B: blocks) {
+	  writeString(B->getName());
+	  writeBinary(lazy_impl::materialize(premap.find(B)->second));
+	  writeBinary(lazy_impl::materialize(postmap.find(B)->second));
+	}
+      }
+      // make the function available to readers
+      m_out.flush();
+    }
+    /** End invariant_writer **/
+
+    void checks_writer::write(StringRef function, const checks_db_t &checks) {
+      const char *status = (checks.get_total_error() > 0 ? "error" :
+			    (checks.get_total_warning() > 0 ? "warning" : "safe"));
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_out << "{\"function\":";
+      writeJsonString(m_out, function);
+      m_out << ",\"status\":\"" << status << "\""
+	    << ",\"safe\":" << checks.get_total_safe()
+	    << ",\"error\":" << checks.get_total_error()
+	    << ",\"warning\":" << checks.get_total_warning() << "}\n";
+      // job watchers can read the function right away
+      m_out.flush();
+    }
+
+    bool writeInvariantDb(const std::string &file, Module &M,
+			  const invariant_map_t &premap,
+			  const invariant_map_t &postmap, bool keep_shadows) {
+      auto convert = [keep_shadows](wrapper_dom_ptr absval) {
+	InvariantDbWriter::constraints_t res;
+	for (auto &cst: getExportedConstraints(lazy_impl::materialize(absval),
+					       keep_shadows)) {
+	  InvariantDbWriter::constraint c;
+	  c.kind = getKind(cst);
+	  c.constant = cst.expression().constant().get_str();
+	  for (auto t: cst.expression()) {
+	    c.terms.push_back(std::make_pair(t.first.get_str(), t.second.name().str()));
+	  }
+	  res.push_back(c);
+	}
+	return res;
+      };
+
+      InvariantDbWriter db;
+      for (auto &F: M) {
+	for (auto &B: F) {
+	  auto pre_it = premap.find(&B);
+	  auto post_it = postmap.find(&B);
+	  if (pre_it == premap.end() || post_it == postmap.end()) continue;
+	  db.add(F.getName().str(), B.getName().str(),
+		 convert(pre_it->second), convert(post_it->second));
+	}
+      }
+      return db.write(file);
+    }
+  } // end namespace export_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,455 @@
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/ADT/SmallString.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/crab_domains.hh"
+#include "crab_llvm/wrapper_domain.hh"
+#include "crab_llvm/CfgBuilder.hh"
+#include "crab_llvm/IncrementalAnalysis.hh"
+#include "crab/analysis/abs_transformer.hpp"
+
+#include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+using namespace llvm;
+using namespace crab::cfg;
+
+extern cl::opt<enum tracked_precision> CrabTrackLev;
+extern cl::opt<bool> CrabReuseLiveness;
+extern cl::opt<bool> CrabRelationalThresholdEstimate;
+extern cl::opt<unsigned int> CrabWideningAutoJumpSet;
+extern cl::opt<bool> CrabAdaptiveFixpoint;
+extern cl::opt<unsigned> CrabWideningMaxDelay;
+extern cl::opt<bool> CrabAccelerateLoops;
+extern cl::opt<bool> CrabDischargeTrivialChecks;
+
+namespace crab_llvm {
+
+  namespace incremental_impl {
+
+    static const std::string header = "CRAB-INCREMENTAL 3";
+
+    typedef boost::unordered_map<std::string, const Value*> value_map_t;
+    typedef boost::unordered_map<std::string, const BasicBlock*> block_map_t;
+    typedef std::vector<std::pair<unsigned, crab::checker::check_kind_t>> located_checks_t;
+    
+    std::string getKey(const Function &F, const AnalysisParams &params,
+		       HeapAbstraction &mem) {
+      std::string buf;
+      raw_string_ostream o(buf);
+      o << CfgBuilder::fingerprint(F, mem, CrabTrackLev, cfg_has_callsites) << ";"
+	<< params.dom << ";" << params.run_backward << ";"
+	<< params.run_liveness << ";" << CrabReuseLiveness << ";"
+	<< CrabRelationalThresholdEstimate << ";" << params.relational_threshold << ";"
+	<< params.relational_threshold_loops << ";"
+	<< params.relational_threshold_packs << ";"
+	<< params.widening_delay << ";" << params.narrowing_iters << ";"
+	<< params.widening_jumpset << ";" << CrabWideningAutoJumpSet << ";"
+	<< (CrabAdaptiveFixpoint ? CrabWideningMaxDelay : 0) << ";"
+	<< CrabAccelerateLoops << ";"
+	<< CrabDischargeTrivialChecks << ";"
+	<< params.check;
+      o.flush();
+      return buf;
+    }
+
+    std::string getHashedFileName(const std::string &dir, const std::string &key,
+				  const std::string &ext) {
+      MD5 hash;
+      hash.update(key);
+      MD5::MD5Result res;
+      hash.final(res);
+      SmallString<32> hash_str;
+      MD5::stringifyResult(res, hash_str);
+      SmallString<128> path(dir);
+      sys::path::append(path, hash_str.str() + ext);
+      return path.str().str();
+    }
+    
+    std::string getFileName(const std::string &dir, const Function &F,
+			    const AnalysisParams &params, HeapAbstraction &mem) {
+      return getHashedFileName(dir, getKey(F, params, mem), ".crab");
+    }
+
+    void writeName(std::ostream &o, StringRef name) {
+      o << name.size() << ":" << name.str();
+    }
+
+    // a global and a local value can have the same name so values are
+    // keyed by their kind and their name as in the llvm IR
+    static std::string getValueKey(const Value &v) {
+      return (isa<GlobalValue>(v) ? "@" : "%") + v.getName().str();
+    }
+
+    bool readName(std::istream &i, std::string &name) {
+      std::size_t n;
+      char sep;
+      if (!(i >> n) || !i.get(sep) || sep != ':') return false;
+      name.resize(n);
+      return n == 0 || static_cast<bool>(i.read(&name[0], n));
+    }
+
+    static void writeConstraints(std::ostream &o, const std::string &tag,
+				 const lin_cst_sys_t &csts) {
+      typedef std::vector<std::pair<number_t, const Value*>> terms_t;
+      std::vector<std::pair<lin_cst_t, terms_t>> named_csts;
+      for (auto cst: csts) {
+	terms_t terms;
+	bool all_named = true;
+	for (auto t: cst.expression()) {
+	  if (boost::optional<const Value*> v = t.second.name().get()) {
+	    terms.push_back(std::make_pair(t.first, *v));
+	  } else {
+	    all_named = false;
+	    break;
+	  }
+	}
+	if (all_named) {
+	  named_csts.push_back(std::make_pair(cst, terms));
+	}
+      }
+      
+      o << tag << " " << named_csts.size() << "\n";
+      for (auto &kv: named_csts) {
+	const lin_cst_t &cst = kv.first;
+	o << (cst.is_equality() ? "eq" : (cst.is_inequality() ? "le" : "ne")) << " "
+	  << cst.expression().constant().get_str() << " " << kv.second.size();
+	for (auto &t: kv.second) {
+	  o << " " << t.first.get_str() << " ";
+	  writeName(o, getValueKey(*t.second));
+	}
+	o << "\n";
+      }
+    }
+
+    boost::optional<var_t> mkVar(const Value &v, llvm_variable_factory &vfac) {
+      Type *ty = v.getType();
+      if (ty->isIntegerTy(1)) {
+	return var_t(vfac[&v], crab::BOOL_TYPE, 1);
+      } else if (ty->isIntegerTy()) {
+	return var_t(vfac[&v], crab::INT_TYPE, ty->getIntegerBitWidth());
+      } else if (ty->isPointerTy()) {
+	return var_t(vfac[&v], crab::PTR_TYPE);
+      } else {
+	return boost::optional<var_t>();
+      }
+    }
+    
+    static bool readConstraints(std::istream &i, const std::string &tag,
+				const value_map_t &values, llvm_variable_factory &vfac,
+				lin_cst_sys_t &csts) {
+      std::string cur_tag;
+      unsigned num_csts;
+      if (!(i >> cur_tag >> num_csts) || cur_tag != tag) return false;
+      for (; num_csts > 0; --num_csts) {
+	std::string kind, cst_str;
+	unsigned num_terms;
+	if (!(i >> kind >> cst_str >> num_terms)) return false;
+	lin_exp_t e(number_t(cst_str.c_str()));
+	for (; num_terms > 0; --num_terms) {
+	  std::string coeff_str, name;
+	  if (!(i >> coeff_str) || !readName(i, name)) return false;
+	  auto it = values.find(name);
+	  if (it == values.end()) return false;
+	  boost::optional<var_t> v = mkVar(*(it->second), vfac);
+	  if (!v) return false;
+	  e = e + (number_t(coeff_str.c_str()) * (*v));
+	}
+	if (kind == "eq") {
+	  csts += lin_cst_t(e, lin_cst_t::EQUALITY);
+	} else if (kind == "le") {
+	  csts += lin_cst_t(e, lin_cst_t::INEQUALITY);
+	} else if (kind == "ne") {
+	  csts += lin_cst_t(e, lin_cst_t::DISEQUALITY);
+	} else {
+	  return false;
+	}
+      }
+      return true;
+    }
+
+    template<typename Dom>
+    wrapper_dom_ptr mkWrapper(const lin_cst_sys_t &csts) {
+      Dom absval = Dom::top();
+      absval += csts;
+      return mkGenericAbsDomWrapper(absval);
+    }
+    
+    wrapper_dom_ptr mkWrapper(CrabDomain dom, const lin_cst_sys_t &csts) {
+      switch (dom) {
+      #ifdef HAVE_ALL_DOMAINS
+      case INTERVALS_CONGRUENCES: return mkWrapper<ric_domain_t>(csts);
+      case DIS_INTERVALS:         return mkWrapper<dis_interval_domain_t>(csts);
+      case TERMS_INTERVALS:       return mkWrapper<term_int_domain_t>(csts);
+      #endif 
+      case WRAPPED_INTERVALS:     return mkWrapper<wrapped_interval_domain_t>(csts);
+      case DENSE_INTERVALS:       return mkWrapper<dense_interval_domain_t>(csts);
+      case WRAPPED_INTERVALS_FAST: return mkWrapper<wrapped_interval_fast_domain_t>(csts);
+      case PTR_OFFSETS:           return mkWrapper<offset_pointer_domain_t>(csts);
+      case ZONES_SPLIT_DBM:       return mkWrapper<split_dbm_domain_t>(csts);
+      case ZONES_SPLIT_DBM_FAST:  return mkWrapper<split_dbm_fast_domain_t>(csts);
+      case ZONES_DENSE_DBM:       return mkWrapper<dense_dbm_domain_t>(csts);
+      case BOXES:                 return mkWrapper<boxes_domain_t>(csts);
+      case OCT:                   return mkWrapper<oct_domain_t>(csts);
+      case PK:                    return mkWrapper<pk_domain_t>(csts);
+      case TERMS_ZONES:           return mkWrapper<num_domain_t>(csts);
+      case TERMS_DIS_INTERVALS:   return mkWrapper<term_dis_int_domain_t>(csts);
+      default:                    return mkWrapper<interval_domain_t>(csts);
+      }
+    }
+
+    template<typename Stmt>
+    static bool isCheck(const Stmt &s) {
+      return s.is_assert() || s.is_ptr_assert() || s.is_bool_assert();
+    }
+
+    // the blocks of cfg in a deterministic order: the checks of cfg
+    // are numbered in this order.
+    static std::vector<basic_block_label_t> getSortedBlocks(cfg_ref_t cfg) {
+      std::vector<basic_block_label_t> res(cfg.label_begin(), cfg.label_end());
+      std::sort(res.begin(), res.end());
+      return res;
+    }
+
+    // the debug locations of the checks of cfg (none for pointer and
+    // boolean assertions)
+    static std::vector<crab::cfg::debug_info> getChecksDebugInfo(cfg_ref_t cfg) {
+      typedef basic_block_t::assert_t assert_t;
+      std::vector<crab::cfg::debug_info> res;
+      for (auto bl: getSortedBlocks(cfg)) {
+	for (auto &s: cfg.get_node(bl)) {
+	  if (s.is_assert()) {
+	    res.push_back(static_cast<const assert_t*>(&s)->get_debug_info());
+	  } else if (isCheck(s)) {
+	    res.push_back(crab::cfg::debug_info());
+	  }
+	}
+      }
+      return res;
+    }
+
+    // Replay the statements of a block from its pre-condition and
+    // record the status of its numerical assertions. The other
+    // checks are only numbered.
+    struct check_replayer {
+      basic_block_t &m_bb;
+      unsigned &m_id;
+      located_checks_t &m_checks;
+
+      check_replayer(basic_block_t &bb, unsigned &id, located_checks_t &checks)
+	: m_bb(bb), m_id(id), m_checks(checks) {}
+
+      template<typename Dom>
+      void operator()(const Dom &pre) {
+	typedef typename basic_block_t::assert_t assert_t;
+	Dom inv(pre);
+	crab::analyzer::intra_abs_transformer<Dom> vis(&inv);
+	for (auto &s: m_bb) {
+	  if (s.is_assert()) {
+	    const assert_t *a = static_cast<const assert_t*>(&s);
+	    m_checks.push_back(std::make_pair(m_id, checkAssertion(inv, *a)));
+	  }
+	  if (isCheck(s)) {
+	    ++m_id;
+	  }
+	  s.accept(&vis);
+	}
+      }
+    };
+
+    // Add total checks of kind: the located ones with their debug
+    // location and the rest without it. Return false if located does
+    // not match dbg.
+    static bool addChecks(checks_db_t &checks, crab::checker::check_kind_t kind,
+			  unsigned total, const located_checks_t &located,
+			  const std::vector<crab::cfg::debug_info> &dbg) {
+      for (auto &c: located) {
+	if (c.second != kind) continue;
+	if (c.first >= dbg.size()) return false;
+	// replaying the invariants can decide more checks than the
+	// analysis (e.g., with --crab-check-layered)
+	if (total == 0) break;
+	checks.add(kind, dbg[c.first]);
+	--total;
+      }
+      for (; total > 0; --total) checks.add(kind);
+      return true;
+    }
+
+    // the status of the numerical assertions of cfg in the blocks
+    // with an invariant in premap
+    static located_checks_t replayChecks(cfg_ref_t cfg, const invariant_map_t &premap) {
+      located_checks_t located;
+      unsigned id = 0;
+      for (auto bl: getSortedBlocks(cfg)) {
+	basic_block_t &bb = cfg.get_node(bl);
+	const BasicBlock *B = bl.get_basic_block();
+	auto it = B ? premap.find(B) : premap.end();
+	if (it != premap.end()) {
+	  check_replayer r(bb, id, located);
+	  visitAbsDomWrappee(it->second, r);
+	} else {
+	  for (auto &s: bb) {
+	    if (isCheck(s)) ++id;
+	  }
+	}
+      }
+      return located;
+    }
+
+    std::vector<std::pair<crab::checker::check_kind_t, crab::cfg::debug_info>>
+    locateChecks(cfg_ref_t cfg, const invariant_map_t &premap) {
+      std::vector<crab::cfg::debug_info> dbg = getChecksDebugInfo(cfg);
+      std::vector<std::pair<crab::checker::check_kind_t, crab::cfg::debug_info>> res;
+      for (auto &c: replayChecks(cfg, premap)) {
+	res.push_back(std::make_pair(c.second, dbg[c.first]));
+      }
+      return res;
+    }
+
+    // the debug locations of the instructions of F in order
+    static std::vector<crab::cfg::debug_info> getInstsDebugInfo(const Function &F) {
+      std::vector<crab::cfg::debug_info> res;
+      for (auto &B: F) {
+	for (auto &I: B) res.push_back(getDebugInfo(I));
+      }
+      return res;
+    }
+
+    /** 
+     * Store the invariants of F and its checks in file. cfg is the
+     * CFG of F before it is sliced or its checks are discharged.
+     * Return false if file cannot be written.
+     **/
+    bool store(const std::string &file, const Function &F, cfg_ref_t cfg,
+	       const invariant_map_t &premap, const invariant_map_t &postmap,
+	       const checks_db_t &checks) {
+      std::ofstream o(file);
+      if (!o) {
+	errs() << "Warning: cannot write analysis results in " << file << "\n";
+	return false;
+      }
+      // -- each located check is stored as the position of the first
+      //    instruction of F with its debug location
+      std::vector<crab::cfg::debug_info> insts = getInstsDebugInfo(F);
+      std::map<crab::cfg::debug_info, unsigned> inst_ids;
+      for (unsigned i = 0; i < insts.size(); ++i) {
+	inst_ids.insert(std::make_pair(insts[i], i));
+      }
+      located_checks_t located;
+      for (auto &c: locateChecks(cfg, premap)) {
+	auto it = inst_ids.find(c.second);
+	if (it != inst_ids.end()) {
+	  located.push_back(std::make_pair(it->second, c.first));
+	}
+      }
+      o << header << "\n";
+      o << "checks " << checks.get_total_safe() << " "
+	<< checks.get_total_error() << " "
+	<< checks.get_total_warning() << "\n";
+      o << "located " << located.size() << "\n";
+      for (auto &c: located) {
+	o << c.first << " " << (int) c.second << "\n";
+      }
+      for (auto &B: F) {
+	auto pre_it = premap.find(&B);
+	auto post_it = postmap.find(&B);
+	if (pre_it == premap.end() || post_it == postmap.end()) continue;
+	o << "block ";
+	writeName(o, B.getName());
+	o << "\n";
+	writeConstraints(o, "pre", pre_it->second->to_linear_constraints());
+	writeConstraints(o, "post", post_it->second->to_linear_constraints());
+      }
+      o << "end\n";
+      return static_cast<bool>(o);
+    }
+
+    /** 
+     * Load the invariants of F and its checks from file. Return
+     * false (and leave results untouched) if file does not exist or
+     * it cannot be read.
+     **/
+    bool load(const std::string &file, const Function &F,
+	      CrabDomain dom, llvm_variable_factory &vfac,
+	      InvarianceAnalysisResults &results) {
+      std::ifstream i(file);
+      if (!i) return false;
+      
+      std::string line, tag;
+      unsigned safe, err, warn, num_located;
+      if (!std::getline(i, line) || line != header) return false;
+      if (!(i >> tag >> safe >> err >> warn) || tag != "checks") return false;
+      if (!(i >> tag >> num_located) || tag != "located") return false;
+      located_checks_t located;
+      for (; num_located > 0; --num_located) {
+	unsigned id;
+	int kind;
+	if (!(i >> id >> kind)) return false;
+	if (kind != crab::checker::_SAFE && kind != crab::checker::_ERR &&
+	    kind != crab::checker::_WARN) {
+	  return false;
+	}
+	located.push_back(std::make_pair(id, (crab::checker::check_kind_t) kind));
+      }
+      
+      value_map_t values;
+      block_map_t blocks;
+      for (auto &A: F.args()) {
+	values[getValueKey(A)] = &A;
+      }
+      for (auto &B: F) {
+	blocks[B.getName().str()] = &B;
+	for (auto &I: B) {
+	  if (!I.getType()->isVoidTy()) {
+	    values[getValueKey(I)] = &I;
+	  }
+	}
+      }
+      for (auto &GV: F.getParent()->globals()) {
+	values[getValueKey(GV)] = &GV;
+      }
+
+      invariant_map_t pre, post;
+      while (i >> tag && tag == "block") {
+	std::string name;
+	if (!readName(i, name)) return false;
+	auto it = blocks.find(name);
+	if (it == blocks.end()) return false;
+	lin_cst_sys_t pre_csts, post_csts;
+	if (!readConstraints(i, "pre", values, vfac, pre_csts) ||
+	    !readConstraints(i, "post", values, vfac, post_csts)) {
+	  return false;
+	}
+	pre.insert(std::make_pair(it->second, mkWrapper(dom, pre_csts)));
+	post.insert(std::make_pair(it->second, mkWrapper(dom, post_csts)));
+      }
+      if (tag != "end") return false;
+
+      std::vector<crab::cfg::debug_info> dbg = getInstsDebugInfo(F);
+      checks_db_t checks;
+      if (!addChecks(checks, crab::checker::_SAFE, safe, located, dbg) ||
+	  !addChecks(checks, crab::checker::_ERR, err, located, dbg) ||
+	  !addChecks(checks, crab::checker::_WARN, warn, located, dbg)) {
+	return false;
+      }
+      
+      for (auto &kv: pre) {
+	update(results.premap, *(kv.first), kv.second);
+      }
+      for (auto &kv: post) {
+	update(results.postmap, *(kv.first), kv.second);
+      }
+      mergeChecks(results.checksdb, std::move(checks));
+      return true;
+    }
+  } // end namespace incremental_impl
+
+} // end namespace crab_llvm
@@ -5,6 +5,7 @@
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Support/raw_ostream.h"
@@ -13,25 +14,37 @@
 #include "llvm/Transforms/Utils/UnifyFunctionExitNodes.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/DenseSet.h"
 
 #include "crab_llvm/config.h"
 #include "crab_llvm/wrapper_domain.hh"
 #include "crab_llvm/Transforms/InsertInvariants.hh"
 #include "crab_llvm/CfgBuilder.hh"
 #include "crab_llvm/CrabLlvm.hh"
+#include "crab_llvm/Support/Parallel.hh"
+#include "crab_llvm/Support/Numbers.hh"
+#include "crab_llvm/Support/ReduceConstraints.hh"
+#include "crab_llvm/Support/InvariantMetadata.hh"
+#include "crab_llvm/Support/Trace.hh"
 #include "crab/analysis/abs_transformer.hpp"
 
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
 /* 
  * Instrument LLVM bitecode by inserting invariants computed by
  * crab. The invariants are inserted as special verifier.assume
- * instructions.
+ * instructions or attached as metadata to crab.inv calls.
  */
 
 using namespace llvm;
 using namespace crab_llvm;
 using namespace crab::cfg;
 
-enum InsertInvsLoc { NONE, BLOCK_ENTRY, AFTER_LOAD, ALL};
+enum InsertInvsLoc { NONE, BLOCK_ENTRY, AFTER_LOAD, LOOP_HEADER, ALL};
 static cl::opt<InsertInvsLoc>
 InsertInvs("crab-add-invariants", 
      cl::desc("Instrument code with invariants"),
@@ -41,10 +54,32 @@ InsertInvs("crab-add-invariants",
                      "Add invariants that hold at each block entry"),
          clEnumValN (AFTER_LOAD, "after-load",
                      "Add invariants that hold after each load instruction"),
+         clEnumValN (LOOP_HEADER, "loop-header",
+                     "Add invariants that hold at each loop header"),
          clEnumValN (ALL, "all",
-                    "Add invariants at all above locations"),
+                    "Add invariants at block entries and after loads"),
          clEnumValEnd),
      cl::init (NONE));
+
+static cl::opt<bool>
+InsertInvsRelevantVars("crab-add-invariants-relevant-vars", 
+     cl::desc("Only add constraints over variables that appear in "
+	      "assertions or branch conditions"),
+     cl::init (false));
+
+static cl::opt<unsigned>
+InsertInvsThreads("crab-add-invariants-threads", 
+     cl::desc("Number of threads used to compute the invariants to be inserted"),
+     cl::init (1));
+
+static cl::opt<bool>
+InsertInvsAsMetadata("crab-add-invariants-metadata", 
+     cl::desc("Attach the invariants as !crab.inv metadata instead of "
+	      "inserting verifier.assume instructions"),
+     cl::init (false));
+
+// defined in CrabLlvm.cc
+extern cl::opt<bool> CrabReduceConstraints;
             
 #define DEBUG_TYPE "crab-insert-invars"
 
@@ -63,6 +98,70 @@ namespace crab_llvm {
     return false;
   }
 
+  inline bool has_unreachable (const llvm::BasicBlock& B) {
+    for (auto &I: B)
+      if (isa<UnreachableInst>(I))
+        return true;
+    return false;
+  }
+
+  // Compute the targets of the back edges of F
+  inline void loop_headers (const llvm::Function& F,
+			    DenseSet<const BasicBlock*>& headers) {
+    SmallVector<std::pair<const BasicBlock*, const BasicBlock*>, 8> backedges;
+    FindFunctionBackedges (F, backedges);
+    for (auto &e: backedges)
+      headers.insert (e.second);
+  }
+
+  // Compute the integer values on which the conditions of branches
+  // and verifier.assert calls of F depend.
+  inline void relevant_values (const llvm::Function& F,
+			       DenseSet<const Value*>& values) {
+    std::vector<const Value*> worklist;
+    for (auto &B: F) {
+      for (auto &I: B) {
+	if (const BranchInst *BI = dyn_cast<BranchInst>(&I)) {
+	  if (BI->isConditional ())
+	    worklist.push_back (BI->getCondition ());
+	} else if (const CallInst *CI = dyn_cast<CallInst>(&I)) {
+	  const Function *callee = CI->getCalledFunction ();
+	  if (callee && (callee->getName ().equals ("verifier.assert") ||
+			 callee->getName ().equals ("__CRAB_assert"))) {
+	    for (unsigned i=0; i < CI->getNumArgOperands (); ++i)
+	      worklist.push_back (CI->getArgOperand (i));
+	  }
+	}
+      }
+    }
+
+    while (!worklist.empty ()) {
+      const Value *v = worklist.back ();
+      worklist.pop_back ();
+      if (!(isa<Instruction>(v) || isa<Argument>(v)))
+	continue;
+      if (!values.insert (v).second)
+	continue;
+      // -- follow the operands of arithmetic, comparisons, casts,
+      //    selects and phi nodes. Loaded values are kept but not
+      //    the pointers they are loaded from.
+      const Instruction *I = dyn_cast<Instruction>(v);
+      if (I && (isa<BinaryOperator>(I) || isa<CmpInst>(I) || isa<CastInst>(I) ||
+		isa<SelectInst>(I) || isa<PHINode>(I))) {
+	for (auto &op: I->operands ())
+	  worklist.push_back (op.get ());
+      }
+    }
+  }
+  
+  // Constraints to be inserted in a function
+  struct InstrumentationPlan {
+    // at each block entry
+    DenseMap<BasicBlock*, lin_cst_sys_t> entries;
+    // after each load instruction
+    std::vector<std::pair<const LoadInst*, lin_cst_sys_t>> loads;
+  };
+  
   struct CodeExpander {
     enum bin_op_t { ADD, SUB, MUL };
     
@@ -87,9 +186,9 @@ namespace crab_llvm {
       }
     }
        
-    Value* mk_num (number_t n, LLVMContext &ctx) {
+    Value* mk_num (const number_t &n, LLVMContext &ctx) {
       Type * ty = Type::getInt64Ty (ctx); 
-      return ConstantInt::get (ty, APInt (64, n.get_str(), 10));
+      return ConstantInt::get (ty, toAPInt (n, 64));
     }
     
     Value* mk_var (varname_t v) {
@@ -101,85 +200,287 @@ namespace crab_llvm {
       return ConstantInt::get (Type::getInt1Ty (ctx), (val) ? 1U : 0U);
     }
 
-    //! Generate llvm bitecode from a set of linear constraints    
+    // Bounds of a linear expression already assumed
+    struct bounds_t {
+      bool has_lb, has_ub;
+      number_t lb, ub;
+      std::vector<number_t> diseqs;
+      bounds_t (): has_lb (false), has_ub (false) {}
+    };
+    // keyed by the canonical form of the expression
+    typedef std::map<std::string, bounds_t> bounds_map_t;
+
+  private:
+    
+    // Constraints assumed in the current scope and the enclosing
+    // ones. A scope is open while the blocks dominated by a block
+    // are instrumented.
+    bounds_map_t m_known;
+    std::vector<std::vector<std::pair<std::string, boost::optional<bounds_t>>>> m_undo;
+
+    void set_known (const std::string &key, const bounds_t &b) {
+      if (!m_undo.empty ()) {
+        auto it = m_known.find (key);
+        m_undo.back ().push_back
+          (std::make_pair (key, (it == m_known.end () ?
+                                 boost::optional<bounds_t> () :
+                                 boost::optional<bounds_t> (it->second))));
+      }
+      m_known[key] = b;
+    }
+    
+    // The canonical form of e is sign*e where sign makes positive
+    // the coefficient of its first variable. Return false if e
+    // cannot be translated to llvm.
+    bool get_key (const lin_exp_t &e, int &sign, std::string &key) {
+      sign = 0;
+      crab::crab_string_os o;
+      for (auto t : e) {
+        number_t n = t.first;
+        if (n == 0) continue;
+        Value *vv = mk_var (t.second.name ());
+        // cst can contain pointer variables representing their offsets.
+        // We ignore them for now.
+        if (!vv || !vv->getType ()->isIntegerTy ())
+          return false;
+        if (sign == 0) sign = (n > 0 ? 1 : -1);
+        o << (sign > 0 ? n : number_t (0) - n).get_str () << "*" << t.second << " ";
+      }
+      key = o.str ();
+      return sign != 0;
+    }
+
+    // post: return a value of Int64Ty with the computation of sign*e
+    Value* gen_expr (const lin_exp_t &e, int sign, IRBuilder<> B, LLVMContext &ctx,
+                     const Twine &Name) {
+      Value * ee = mk_num (number_t(0), ctx);
+      for (auto t : e) {
+        number_t n  = t.first;
+        if (n == 0) continue; 
+        if (sign < 0) n = number_t (0) - n;
+        Value * vv = mk_var (t.second.name());
+        if (n == 1) {
+          ee = mk_bin_op(ADD, B, ctx, ee, vv, Name);
+        } else if (n == -1) {
+          ee = mk_bin_op(SUB, B, ctx, ee, vv, Name);
+        } else {
+          ee = mk_bin_op(ADD, B, ctx, ee, 
+                         mk_bin_op(MUL, B, ctx, mk_num (n, ctx), vv, Name), 
+                         Name);
+        }
+      }
+      return ee;
+    }
+
+    bool emit_assume (Value *cond, IRBuilder<> &B, Function* assumeFn, CallGraph* cg,
+                      const Function* insertFun) {
+      CallInst *ci =  B.CreateCall (assumeFn, cond);
+      if (cg) {
+        (*cg)[insertFun]->addCalledFunction
+          (CallSite (ci), (*cg)[ci->getCalledFunction ()]);
+      }
+      return true;
+    }
+    
+  public:
+
+    void push_scope () { m_undo.emplace_back (); }
+
+    void pop_scope () {
+      assert (!m_undo.empty ());
+      auto &undo = m_undo.back ();
+      for (auto it = undo.rbegin (), et = undo.rend (); it != et; ++it) {
+        if (it->second) {
+          m_known[it->first] = *(it->second);
+        } else {
+          m_known.erase (it->first);
+        }
+      }
+      m_undo.pop_back ();
+    }
+    
+    //! Generate llvm bitecode from a set of linear constraints.
+    //
+    // The constraints over the same linear expression are grouped:
+    // the expression is computed once, a lower and upper bound are
+    // checked with a single unsigned comparison and the constraints
+    // implied by others (or by the ones already assumed in the
+    // current scope) are not generated.
+    //
     //  TODO: generate bitecode from disjunctive linear constraints.
     bool gen_code (lin_cst_sys_t csts, IRBuilder<> B, LLVMContext &ctx,
                    Function* assumeFn, CallGraph* cg,
 		   const Function* insertFun, const Twine &Name = "") {
+      struct group_t {
+        lin_exp_t e;
+        int sign;
+        bounds_t bounds;
+      };
+      std::map<std::string, group_t> groups;
+      // to generate the groups in the order of the constraints
+      std::vector<std::string> order;
       bool change = false;
+      
       for (auto cst: csts) {
-        Value* cst_code = gen_code (cst, B, ctx, Name);
-        if (cst_code) {
-          CallInst *ci =  B.CreateCall (assumeFn, cst_code);
-          // errs () << "Added " << *ci << " with " << *cst_code << "\n";
-          change = true;
-          if (cg) {
-            (*cg)[insertFun]->addCalledFunction
-	      (CallSite (ci), (*cg)[ci->getCalledFunction ()]);
-	  }
-	       
+        if (cst.is_tautology ()) continue;
+        
+        if (cst.is_contradiction ()) {
+          change |= emit_assume (mk_bool (B, ctx, false), B, assumeFn, cg, insertFun);
+          continue;
+        }
+        
+        // cst is e <= c, e == c or e != c
+        lin_exp_t e = cst.expression() - cst.expression().constant();
+        number_t c = number_t (0) - cst.expression().constant();
+        int sign;
+        std::string key;
+        if (!get_key (e, sign, key)) continue;
+        
+        auto it = groups.find (key);
+        if (it == groups.end ()) {
+          group_t g;
+          g.e = e;
+          g.sign = sign;
+          it = groups.insert (std::make_pair (key, g)).first;
+          order.push_back (key);
+        }
+        bounds_t &b = it->second.bounds;
+        // in terms of the canonical expression sign*e
+        if (sign < 0) c = number_t (0) - c;
+        if (cst.is_inequality ()) {
+          if (sign > 0) {
+            if (!b.has_ub || c < b.ub) { b.ub = c; b.has_ub = true; }
+          } else {
+            if (!b.has_lb || c > b.lb) { b.lb = c; b.has_lb = true; }
+          }
+        } else if (cst.is_equality ()) {
+          if (!b.has_ub || c < b.ub) { b.ub = c; b.has_ub = true; }
+          if (!b.has_lb || c > b.lb) { b.lb = c; b.has_lb = true; }
+        } else {
+          b.diseqs.push_back (c);
+        }
+      }
+      
+      for (auto &key: order) {
+        group_t &g = groups[key];
+        bounds_t &b = g.bounds;
+        bounds_t known;
+        auto kit = m_known.find (key);
+        if (kit != m_known.end ()) known = kit->second;
+        
+        // -- remove what is already assumed
+        bool gen_lb = b.has_lb && !(known.has_lb && known.lb >= b.lb);
+        bool gen_ub = b.has_ub && !(known.has_ub && known.ub <= b.ub);
+        std::vector<number_t> diseqs;
+        for (auto &d: b.diseqs) {
+          bool implied = (b.has_lb && d < b.lb) || (b.has_ub && d > b.ub) ||
+                         (known.has_lb && d < known.lb) || (known.has_ub && d > known.ub) ||
+                         std::find (known.diseqs.begin (), known.diseqs.end (), d) != known.diseqs.end () ||
+                         std::find (diseqs.begin (), diseqs.end (), d) != diseqs.end ();
+          if (!implied) diseqs.push_back (d);
+        }
+        if (!gen_lb && !gen_ub && diseqs.empty ()) continue;
+        
+        Value *ee = gen_expr (g.e, g.sign, B, ctx, Name);
+        if (gen_lb && gen_ub && b.lb == b.ub) {
+          Value *cond = B.CreateICmpEQ (ee, mk_num (b.lb, ctx), Name);
+          change |= emit_assume (cond, B, assumeFn, cg, insertFun);
+        } else if (gen_lb && gen_ub && b.lb < b.ub &&
+                   fitsInt64 (b.lb) && fitsInt64 (b.ub)) {
+          // lb <= ee <= ub iff (ee - lb) <=u (ub - lb)
+          Value *diff = mk_bin_op (SUB, B, ctx, ee, mk_num (b.lb, ctx), Name);
+          Value *cond = B.CreateICmpULE (diff, mk_num (b.ub - b.lb, ctx), Name);
+          change |= emit_assume (cond, B, assumeFn, cg, insertFun);
+        } else {
+          if (gen_lb) {
+            Value *cond = B.CreateICmpSGE (ee, mk_num (b.lb, ctx), Name);
+            change |= emit_assume (cond, B, assumeFn, cg, insertFun);
+          }
+          if (gen_ub) {
+            Value *cond = B.CreateICmpSLE (ee, mk_num (b.ub, ctx), Name);
+            change |= emit_assume (cond, B, assumeFn, cg, insertFun);
+          }
         }
+        for (auto &d: diseqs) {
+          Value *cond = B.CreateICmpNE (ee, mk_num (d, ctx), Name);
+          change |= emit_assume (cond, B, assumeFn, cg, insertFun);
+        }
+        
+        // -- record what is assumed now
+        if (gen_lb) { known.lb = b.lb; known.has_lb = true; }
+        if (gen_ub) { known.ub = b.ub; known.has_ub = true; }
+        known.diseqs.insert (known.diseqs.end (), diseqs.begin (), diseqs.end ());
+        set_known (key, known);
       }
       return change;
     }
-    
-    // post: return a value of bool type (Int1Ty) that contains the
-    // computation of cst
-    Value* gen_code (lin_cst_t cst, IRBuilder<> B, LLVMContext &ctx, 
-                     const Twine &Name) {
-      if (cst.is_tautology ())     
-        return mk_bool (B, ctx, true);
-      
-      if (cst.is_contradiction ()) 
-        return mk_bool (B, ctx, false);
-      
-      auto e = cst.expression() - cst.expression().constant();
-      Value * ee = mk_num (number_t("0"), ctx);
+  };
 
-      for (auto t : e) {
-        number_t n  = t.first;
-        if (n == 0) continue; 
 
-        varname_t v = t.second.name();
-
-        if (Value * vv = mk_var (v)) {
-          // cst can contain pointer variables representing their offsets.
-          // We ignore them for now.
-          if (!vv->getType()->isIntegerTy ())
-            return nullptr;
-
-          if (n == 1) {
-            ee = mk_bin_op(ADD, B, ctx, ee, vv, Name);
-	  } else if (n == -1) {
-            ee = mk_bin_op(SUB, B, ctx, ee, vv, Name);
-	  } else {
-            ee = mk_bin_op(ADD, B, ctx, ee, 
-			   mk_bin_op(MUL, B, ctx, mk_num (n, ctx), vv, Name), 
-			   Name);
+  //! Attach a set of linear constraints as metadata of a call to
+  //! crab.inv whose arguments are the values of the constraints (see
+  //! Support/InvariantMetadata.hh). The constraints that are not over
+  //! integer values or whose numbers do not fit in 64 bits are
+  //! skipped.
+  struct MetadataExpander {
+    static bool gen_metadata (lin_cst_sys_t csts, IRBuilder<> B, LLVMContext &ctx,
+			      Function* invFn, CallGraph* cg, const Function* insertFun) {
+      Type *i32 = Type::getInt32Ty (ctx);
+      Type *i64 = Type::getInt64Ty (ctx);
+      std::vector<Value*> args;
+      DenseMap<Value*, unsigned> arg_ids;
+      std::vector<Metadata*> mds;
+      for (auto cst: csts) {
+	if (cst.is_tautology ()) continue;
+	// cst is e <= c, e == c or e != c
+	const lin_exp_t &e = cst.expression ();
+	number_t c = number_t (0) - e.constant ();
+	if (!fitsInt64 (c)) continue;
+	StringRef kind = (cst.is_inequality () ? inv_metadata::le () :
+			  cst.is_equality () ? inv_metadata::eq () : inv_metadata::ne ());
+	std::vector<Metadata*> ops;
+	ops.push_back (MDString::get (ctx, kind));
+	ops.push_back (ConstantAsMetadata::get (ConstantInt::get (i64, toAPInt (c, 64))));
+	bool ok = true;
+	for (auto t: e) {
+	  if (t.first == 0) continue;
+	  boost::optional<const Value*> v = t.second.name ().get ();
+	  // -- pointer variables representing their offsets are ignored
+	  if (!v || !(*v)->getType ()->isIntegerTy () || !fitsInt64 (t.first)) {
+	    ok = false;
+	    break;
 	  }
-        }
-        else
-          return nullptr;
+	  Value *vv = const_cast<Value*> (*v);
+	  auto it = arg_ids.find (vv);
+	  if (it == arg_ids.end ()) {
+	    it = arg_ids.insert (std::make_pair (vv, (unsigned) args.size ())).first;
+	    args.push_back (vv);
+	  }
+	  ops.push_back (ConstantAsMetadata::get (ConstantInt::get (i32, it->second)));
+	  ops.push_back (ConstantAsMetadata::get (ConstantInt::get (i64, toAPInt (t.first, 64))));
+	}
+	if (ok) mds.push_back (MDNode::get (ctx, ops));
       }
-      
-      number_t c = -cst.expression().constant();
-      Value* cc = mk_num (c, ctx);
-
-      if (cst.is_inequality ()) {
-        return B.CreateICmpSLE (ee, cc, Name);
-      } else if (cst.is_equality ()) {
-        return B.CreateICmpEQ (ee, cc, Name);        
-      } else {
-        return B.CreateICmpNE (ee, cc, Name);
+      if (mds.empty ()) return false;
+
+      CallInst *ci = B.CreateCall (invFn, args);
+      ci->setMetadata (inv_metadata::kindName (), MDNode::get (ctx, mds));
+      if (cg) {
+	(*cg)[insertFun]->addCalledFunction
+	  (CallSite (ci), (*cg)[ci->getCalledFunction ()]);
       }
+      return true;
     }
   };
 
+  bool InsertInvariants::usesMetadata () {
+    return InsertInvsAsMetadata;
+  }
 
   //! Instrument basic block entries.
   bool InsertInvariants::
   instrument_entries (lin_cst_sys_t csts, llvm::BasicBlock* bb, 
-		      LLVMContext &ctx, CallGraph* cg) {
+		      LLVMContext &ctx, CallGraph* cg, CodeExpander &g) {
 
     // If the block is an exit we do not instrument it.
     const ReturnInst *ret = dyn_cast<const ReturnInst> (bb->getTerminator ());
@@ -187,13 +488,17 @@ namespace crab_llvm {
 
     IRBuilder<> Builder (ctx);
     Builder.SetInsertPoint (bb->getFirstNonPHI ());
-    CodeExpander g;
     NumInstrBlocks++;
+    if (InsertInvsAsMetadata) {
+      return MetadataExpander::gen_metadata (csts, Builder, ctx, m_invFn, cg,
+					     bb->getParent ());
+    }
     return g.gen_code (csts, Builder, ctx, m_assumeFn, cg, 
                        bb->getParent (), "crab_");
   }
 
-  //! Instrument all load instructions in a basic block.
+  //! Collect the constraints that hold after each load instruction
+  //! in a basic block.
   //
   // The instrumentation is a bit involved because Crab gives us
   // invariants that hold either at the entry or at the exit of a
@@ -203,65 +508,72 @@ namespace crab_llvm {
   // redo some work but it's more efficient than storing all
   // invariants at each program point.
   template<typename AbsDomain>
-  bool InsertInvariants::
-  instrument_loads(AbsDomain inv, basic_block_t& bb, LLVMContext &ctx, CallGraph* cg) {
+  void InsertInvariants::
+  collect_loads(const AbsDomain &pre, basic_block_t& bb, InstrumentationPlan &plan) {
     // -- it will propagate forward inv through the basic block
     //    but ignoring callsites    
+    AbsDomain inv (pre);
     typedef crab::analyzer::intra_abs_transformer<AbsDomain> abs_tr_t; 
     typedef array_load_stmt<number_t,varname_t> array_load_stmt_t;
     typedef ptr_load_stmt<number_t,varname_t> ptr_load_stmt_t;    
     
-    IRBuilder<> Builder (ctx);
-    bool change=false;
     abs_tr_t vis (&inv);
     
     for (auto &s: bb) {
       s.accept (&vis); //propagate the invariant one statement forward
       const LoadInst* I = nullptr;
-      lin_cst_t::variable_set_t load_vs;
+      std::vector<var_t> load_vars;
       if (s.is_arr_read()) { 
         const array_load_stmt_t* load_stmt = static_cast<const array_load_stmt_t*>(&s);
         if (boost::optional<const Value *> v = load_stmt->lhs().name().get()) {
           I = dyn_cast<const LoadInst>(*v);
-          load_vs += load_stmt->lhs();
+          load_vars.push_back (load_stmt->lhs());
         }
       }
       else if (s.is_ptr_read()) { 
         const ptr_load_stmt_t* load_stmt = static_cast<const ptr_load_stmt_t*>(&s); 
         if (boost::optional<const Value *> v = load_stmt->lhs().name().get()) {
-          load_vs += load_stmt->lhs();
+          load_vars.push_back (load_stmt->lhs());
           I = dyn_cast<const LoadInst>(*v);
         }
       }
       
       if (!I) continue;
 
-      CrabLlvmPass* crab = &getAnalysis<CrabLlvmPass>();
-
       if (inv.is_top ()) continue;
-      // -- Filter out all constraints that do not use x.
-      lin_cst_sys_t rel_csts;
-      for (auto cst: inv.to_linear_constraint_system ()) {
-        auto vs = cst.variables();
-        if (!(vs & load_vs).empty ())
-          rel_csts += cst;
-      }
+      // -- Project onto the loaded variable before extracting the
+      //    constraints rather than extracting all of them and
+      //    filtering. Relational constraints between the loaded
+      //    variable and others are dropped.
+      AbsDomain load_inv (inv);
+      load_inv.project (load_vars);
+      plan.loads.push_back
+	(std::make_pair (I, load_inv.to_linear_constraint_system ()));
+    }
+  }
 
-      // -- Insert assume's the next after I
-      Builder.SetInsertPoint (const_cast<LoadInst*> (I));
-      llvm::BasicBlock* InsertBlk = Builder.GetInsertBlock ();
-      llvm::BasicBlock::iterator InsertPt = Builder.GetInsertPoint ();
-      InsertPt++; // this is ok because LoadInstr cannot be terminators.
-      Builder.SetInsertPoint (InsertBlk, InsertPt);
-      CodeExpander g;
-      NumInstrLoads++;
-      change |= g.gen_code (rel_csts, Builder, ctx, m_assumeFn, cg, 
-                            I->getParent()->getParent (), "crab_");
+  //! Instrument a load instruction
+  bool InsertInvariants::
+  instrument_load (lin_cst_sys_t csts, const llvm::LoadInst* I,
+		   LLVMContext &ctx, CallGraph* cg) {
+    // -- Insert assume's the next after I
+    IRBuilder<> Builder (ctx);
+    Builder.SetInsertPoint (const_cast<LoadInst*> (I));
+    llvm::BasicBlock* InsertBlk = Builder.GetInsertBlock ();
+    llvm::BasicBlock::iterator InsertPt = Builder.GetInsertPoint ();
+    InsertPt++; // this is ok because LoadInstr cannot be terminators.
+    Builder.SetInsertPoint (InsertBlk, InsertPt);
+    NumInstrLoads++;
+    if (InsertInvsAsMetadata) {
+      return MetadataExpander::gen_metadata (csts, Builder, ctx, m_invFn, cg,
+					     I->getParent()->getParent ());
     }
-    return change;
+    CodeExpander g;
+    return g.gen_code (csts, Builder, ctx, m_assumeFn, cg, 
+		       I->getParent()->getParent (), "crab_");
   }
 
-  bool InsertInvariants::runOnModule (Module &M) {
+  bool InsertInvariants::initialize (Module &M, CallGraph *cg) {
     if (InsertInvs == NONE) return false;
 
     LLVMContext& ctx = M.getContext ();
@@ -275,128 +587,196 @@ namespace crab_llvm {
                                                Type::getVoidTy (ctx),
                                                Type::getInt1Ty (ctx),
                                                NULL));
-    
-    CallGraphWrapperPass *cgwp =getAnalysisIfAvailable<CallGraphWrapperPass>();
-    if (CallGraph *cg = cgwp ? &cgwp->getCallGraph () : nullptr)
+    if (cg)
       cg->getOrInsertFunction (m_assumeFn);
+    if (InsertInvsAsMetadata) {
+      m_invFn = dyn_cast<Function>
+	(M.getOrInsertFunction (inv_metadata::markerName (),
+				FunctionType::get (Type::getVoidTy (ctx), true)));
+      if (cg)
+	cg->getOrInsertFunction (m_invFn);
+    }
+    return true;
+  }
+
+  bool InsertInvariants::instrument (CrabLlvmPass &crab, Function &F, CallGraph *cg) {
+    if (InsertInvs == NONE) return false;
+    if (!m_assumeFn && !initialize (*F.getParent (), cg)) return false;
+    InstrumentationPlan plan;
+    collect (crab, F, plan);
+    return apply (F, plan, cg);
+  }
+  
+  bool InsertInvariants::runOnModule (Module &M) {
+    CallGraphWrapperPass *cgwp =getAnalysisIfAvailable<CallGraphWrapperPass>();
+    if (!initialize (M, cgwp ? &cgwp->getCallGraph () : nullptr))
+      return false;
 
     bool change=false;
+    CrabLlvmPass &crab = getAnalysis<CrabLlvmPass> ();
+    // the invariants are replayed through their domains (e.g., OCT
+    // or BOXES) whose library managers and statistics are not
+    // thread-safe
+    if (InsertInvsThreads <= 1 || !crab.can_run_in_parallel ()) {
+      for (auto &f : M) {
+        change |= runOnFunction (f); 
+      }
+      return change;
+    }
+
+    // -- compute the constraints of all functions in parallel from
+    //    the stored invariants and then modify the IR sequentially.
+    std::vector<Function*> funcs;
     for (auto &f : M) {
-      change |= runOnFunction (f); 
+      funcs.push_back (&f);
+    }
+    std::vector<InstrumentationPlan> plans (funcs.size ());
+    parallel_for (funcs.size (), InsertInvsThreads, [&](unsigned /*id*/, unsigned i) {
+	collect (crab, *funcs[i], plans[i]);
+      });
+    CallGraph* cg = cgwp ? &cgwp->getCallGraph () : nullptr;
+    for (unsigned i=0; i < funcs.size (); ++i) {
+      change |= apply (*funcs[i], plans[i], cg);
     }
-    
     return change;
   }
 
-  #define INSTR_LOAD(DOM,PRE,BB,CTX,CG,RES)  \
-  DOM inv;                                   \
-  getAbsDomWrappee (PRE, inv);               \
-  RES |= instrument_loads (inv, BB, CTX, CG);
-   
-  bool InsertInvariants::runOnFunction (Function &F)
-  {
+  //! Call collect_loads with the abstract value of a wrapper,
+  //! whatever its domain is. The value is only copied by
+  //! collect_loads to propagate it.
+  struct InsertInvariants::load_collector {
+    InsertInvariants &m_ii;
+    basic_block_t &m_bb;
+    InstrumentationPlan &m_plan;
+
+    load_collector (InsertInvariants &ii, basic_block_t &bb, InstrumentationPlan &plan)
+      : m_ii (ii), m_bb (bb), m_plan (plan) {}
+
+    template<typename AbsDomain>
+    void operator() (const AbsDomain &pre) {
+      m_ii.collect_loads (pre, m_bb, m_plan);
+    }
+  };
+
+  //! Compute the constraints to be inserted in F. It does not
+  //! modify the IR so it can be called in parallel for different
+  //! functions.
+  void InsertInvariants::
+  collect (CrabLlvmPass &crab, Function &F, InstrumentationPlan &plan) {
     if (F.isDeclaration () || F.empty () || F.isVarArg ()) 
-      return false;
+      return;
 
-    CrabLlvmPass* crab = &getAnalysis<CrabLlvmPass> ();
+    trace_scope trace ("instrumentation", F.getName ());
 
-    if (!crab->has_cfg(F))
-      return false;
+    if (!crab.has_cfg(F))
+      return;
       
-    cfg_ref_t cfg = crab->get_cfg(F);
-
-    CallGraphWrapperPass *cgwp =getAnalysisIfAvailable<CallGraphWrapperPass>();
-    CallGraph* cg = cgwp ? &cgwp->getCallGraph () : nullptr;
+    cfg_ref_t cfg = crab.get_cfg(F);
+
+    DenseSet<const BasicBlock*> headers;
+    if (InsertInvs == LOOP_HEADER)
+      loop_headers (F, headers);
+
+    DenseSet<const Value*> relevant;
+    std::vector<var_t> relevant_vars;
+    if (InsertInvsRelevantVars) {
+      relevant_values (F, relevant);
+      for (const Value *v: relevant) {
+	if (v->getType ()->isIntegerTy ()) {
+	  relevant_vars.push_back (var_t (crab.get_var_factory ()[v], crab::UNK_TYPE, 0));
+	}
+      }
+    }
 
-    bool change = false;
     for (auto &B : F) {
 
       // -- if the block has an unreachable instruction we skip it.
-      bool skip_block = false;
-      for (auto &I: B) {
-	if (isa<UnreachableInst>(I)) {
-	  skip_block=true;
-	  break;
-	}
-      }
-      if (skip_block) continue;
+      if (has_unreachable (B)) continue;
       
-      if (InsertInvs == BLOCK_ENTRY || InsertInvs == ALL) {
+      if (InsertInvs == BLOCK_ENTRY || InsertInvs == ALL ||
+	  (InsertInvs == LOOP_HEADER && headers.count (&B))) {
         // --- Instrument basic block entry
-        auto pre = crab->get_pre(&B, false /*remove shadows*/);
+        auto pre = crab.get_pre(&B, false /*remove shadows*/);
 	if (!pre) {
 	  continue;
 	}
-        auto csts = pre->to_linear_constraints ();
-        change |= instrument_entries (csts, &B, F.getContext(), cg);
+        plan.entries[&B] = (InsertInvsRelevantVars ?
+			    pre->to_linear_constraints (relevant_vars) :
+			    pre->to_linear_constraints ());
+	if (CrabReduceConstraints) {
+	  plan.entries[&B] = reduceConstraints (plan.entries[&B]);
+	}
       }
 
       if (InsertInvs == AFTER_LOAD || InsertInvs == ALL) {
         // --- We only instrument Load instructions
         if (reads_memory (B)) {
 
-          auto pre = crab->get_pre(&B, true /*keep shadows*/);
+          auto pre = crab.get_pre(&B, true /*keep shadows*/);
 	  if (!pre) {
 	    continue;
 	  }
-          // --- Figure out the type of the wrappee
-          switch (pre->getId ()) {
-	    #ifdef HAVE_ALL_DOMAINS  
-            case GenericAbsDomWrapper::ric: {
-              INSTR_LOAD(ric_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }
-            case GenericAbsDomWrapper::term_intv: {
-              INSTR_LOAD(term_int_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }	      
-            #endif 	    
-            case GenericAbsDomWrapper::intv:{
-              INSTR_LOAD(interval_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg,change);
-              break;
-            }
-            case GenericAbsDomWrapper::split_dbm: {
-              INSTR_LOAD(split_dbm_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }
-            case GenericAbsDomWrapper::term_dis_intv: {
-              INSTR_LOAD(term_dis_int_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }
-            case GenericAbsDomWrapper::boxes: {
-              INSTR_LOAD(boxes_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }
-            case GenericAbsDomWrapper::oct: {
-              INSTR_LOAD(oct_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }
-            case GenericAbsDomWrapper::pk: {
-              INSTR_LOAD(pk_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }
-            case GenericAbsDomWrapper::num: {
-              INSTR_LOAD(num_domain_t, pre,
-			 cfg.get_node(&B), F.getContext(), cg, change);
-              break;
-            }
-	      
-            default :
-              report_fatal_error("abstract domain not supported by --crab-add-invariants");
-          }
+          load_collector collector (*this, cfg.get_node(&B), plan);
+          visitAbsDomWrappee (pre, collector);
         }
       }
     }
+
+    if (InsertInvsRelevantVars) {
+      // -- the constraints after a load are only over the loaded value
+      plan.loads.erase
+	(std::remove_if (plan.loads.begin (), plan.loads.end (),
+			 [&](const std::pair<const LoadInst*, lin_cst_sys_t> &kv) {
+			   return !relevant.count (kv.first);
+			 }), plan.loads.end ());
+    }
+  }
+
+  //! Insert in F the constraints computed by collect
+  bool InsertInvariants::apply (Function &F, InstrumentationPlan &plan, CallGraph* cg) {
+    trace_scope trace ("apply_instrumentation", F.getName ());
+    bool change = false;
+    if (!plan.entries.empty ()) {
+      // --- Instrument basic block entries. The blocks are visited
+      //     in the dominator tree so the constraints assumed by a
+      //     dominator are not assumed again.
+      DominatorTree DT;
+      DT.recalculate (F);
+      CodeExpander g;
+      std::vector<std::pair<DomTreeNode*, DomTreeNode::iterator>> stack;
+      auto visit = [&](DomTreeNode *N) {
+	g.push_scope ();
+	auto it = plan.entries.find (N->getBlock ());
+	if (it != plan.entries.end ()) {
+	  change |= instrument_entries (it->second, N->getBlock (), F.getContext(), cg, g);
+	}
+	stack.push_back (std::make_pair (N, N->begin ()));
+      };
+      visit (DT.getRootNode ());
+      while (!stack.empty ()) {
+	if (stack.back ().second == stack.back ().first->end ()) {
+	  g.pop_scope ();
+	  stack.pop_back ();
+	  continue;
+	}
+	DomTreeNode *child = *(stack.back ().second++);
+	visit (child);
+      }
+    }
+    
+    for (auto &kv: plan.loads) {
+      change |= instrument_load (kv.second, kv.first, F.getContext(), cg);
+    }
     return change;
   }
+  
+  bool InsertInvariants::runOnFunction (Function &F) {
+    CallGraphWrapperPass *cgwp =getAnalysisIfAvailable<CallGraphWrapperPass>();
+    CallGraph* cg = cgwp ? &cgwp->getCallGraph () : nullptr;
+    InstrumentationPlan plan;
+    collect (getAnalysis<CrabLlvmPass> (), F, plan);
+    return apply (F, plan, cg);
+  }
 
   void InsertInvariants::getAnalysisUsage (AnalysisUsage &AU) const {
     AU.setPreservesAll ();
@@ -0,0 +1,338 @@
+#include "crab_llvm/InvariantDb.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * File format. All integers are little-endian u32 and all sections
+ * are 4-byte aligned so they can be accessed in place:
+ *
+ *   file      := "CRABIDB\0" header functions blocks
+ *                cst_kind cst_constant cst_first_term cst_num_terms
+ *                term_coeff term_var string_offsets string_pool
+ *   header    := version num_functions num_blocks num_csts num_terms
+ *                num_strings offset(section)* string_pool_size
+ *   functions := (name first_block num_blocks)*      sorted by name
+ *   blocks    := (name pre_first pre_num post_first post_num)*
+ *                                                    sorted by name per function
+ *   cst_*     := one column per field of the constraints
+ *   term_*    := one column per field of the terms
+ *   string_offsets := num_strings + 1 offsets in string_pool
+ *
+ * Names, constants and coefficients are ids in the string table.
+ * Numbers are written in decimal since they can be arbitrarily
+ * large.
+ */
+namespace crab_llvm {
+
+  namespace idb_impl {
+
+    static const char magic[8] = {'C','R','A','B','I','D','B','\0'};
+    static const uint32_t version = 1;
+
+    enum header_field_t {
+      VERSION = 0, NUM_FUNCTIONS, NUM_BLOCKS, NUM_CSTS, NUM_TERMS, NUM_STRINGS,
+      OFF_FUNCTIONS, OFF_BLOCKS, OFF_CST_KIND, OFF_CST_CONSTANT, OFF_CST_FIRST_TERM,
+      OFF_CST_NUM_TERMS, OFF_TERM_COEFF, OFF_TERM_VAR, OFF_STRING_OFFSETS,
+      OFF_STRING_POOL, STRING_POOL_SIZE, NUM_HEADER_FIELDS
+    };
+
+    static const uint32_t function_size = 3;
+    static const uint32_t block_size = 5;
+    static const uint32_t header_size = sizeof(magic) + NUM_HEADER_FIELDS * 4;
+
+    static void writeU32(std::ostream &o, uint32_t n) {
+      char buf[4];
+      for (unsigned i = 0; i < 4; ++i) {
+	buf[i] = (char) ((n >> (8*i)) & 0xff);
+      }
+      o.write(buf, 4);
+    }
+
+    static void writeColumn(std::ostream &o, const std::vector<uint32_t> &col) {
+      for (uint32_t n: col) writeU32(o, n);
+    }
+
+    static bool isLittleEndian() {
+      uint32_t one = 1;
+      char c;
+      std::memcpy(&c, &one, 1);
+      return c == 1;
+    }
+  } // end namespace idb_impl
+
+  using namespace idb_impl;
+
+  void InvariantDbWriter::add(const std::string &function, const std::string &block,
+			      const constraints_t &pre, const constraints_t &post) {
+    m_functions[function][block] = std::make_pair(pre, post);
+  }
+
+  bool InvariantDbWriter::write(const std::string &file) const {
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<const std::string*> strings;
+    auto intern = [&](const std::string &s) {
+      auto it = ids.find(s);
+      if (it != ids.end()) return it->second;
+      uint32_t id = strings.size();
+      strings.push_back(&(ids.insert(std::make_pair(s, id)).first->first));
+      return id;
+    };
+
+    std::vector<uint32_t> functions, blocks;
+    std::vector<uint32_t> cst_kind, cst_constant, cst_first_term, cst_num_terms;
+    std::vector<uint32_t> term_coeff, term_var;
+    auto addConstraints = [&](const constraints_t &csts) {
+      blocks.push_back(cst_kind.size());
+      blocks.push_back(csts.size());
+      for (auto &cst: csts) {
+	cst_kind.push_back(cst.kind);
+	cst_constant.push_back(intern(cst.constant));
+	cst_first_term.push_back(term_coeff.size());
+	cst_num_terms.push_back(cst.terms.size());
+	for (auto &t: cst.terms) {
+	  term_coeff.push_back(intern(t.first));
+	  term_var.push_back(intern(t.second));
+	}
+      }
+    };
+
+    for (auto &f: m_functions) {
+      functions.push_back(intern(f.first));
+      functions.push_back(blocks.size() / block_size);
+      functions.push_back(f.second.size());
+      for (auto &b: f.second) {
+	blocks.push_back(intern(b.first));
+	addConstraints(b.second.first);
+	addConstraints(b.second.second);
+      }
+    }
+
+    std::vector<uint32_t> string_offsets;
+    uint32_t pool_size = 0;
+    for (const std::string *s: strings) {
+      string_offsets.push_back(pool_size);
+      pool_size += s->size();
+    }
+    string_offsets.push_back(pool_size);
+
+    uint32_t header[NUM_HEADER_FIELDS];
+    header[VERSION] = version;
+    header[NUM_FUNCTIONS] = functions.size() / function_size;
+    header[NUM_BLOCKS] = blocks.size() / block_size;
+    header[NUM_CSTS] = cst_kind.size();
+    header[NUM_TERMS] = term_coeff.size();
+    header[NUM_STRINGS] = strings.size();
+    header[STRING_POOL_SIZE] = pool_size;
+    const std::vector<uint32_t> *columns[] = {
+      &functions, &blocks, &cst_kind, &cst_constant, &cst_first_term, &cst_num_terms,
+      &term_coeff, &term_var, &string_offsets};
+    uint32_t off = header_size;
+    for (unsigned i = 0; i < sizeof(columns) / sizeof(columns[0]); ++i) {
+      header[OFF_FUNCTIONS + i] = off;
+      off += columns[i]->size() * 4;
+    }
+    header[OFF_STRING_POOL] = off;
+
+    std::ofstream o(file, std::ios::out | std::ios::binary);
+    if (!o) return false;
+    o.write(magic, sizeof(magic));
+    for (unsigned i = 0; i < NUM_HEADER_FIELDS; ++i) {
+      writeU32(o, header[i]);
+    }
+    for (auto col: columns) {
+      writeColumn(o, *col);
+    }
+    for (const std::string *s: strings) {
+      o.write(s->data(), s->size());
+    }
+    return static_cast<bool>(o);
+  }
+
+  InvariantDb::~InvariantDb() {
+    if (m_data) {
+      munmap(const_cast<char*>(m_data), m_size);
+    }
+  }
+
+  std::unique_ptr<InvariantDb> InvariantDb::open(const std::string &file,
+						 std::string &error) {
+    std::unique_ptr<InvariantDb> db;
+    if (!isLittleEndian()) {
+      error = "invariant databases can only be read in little-endian hosts";
+      return db;
+    }
+
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+      error = "cannot open " + file + ": " + std::strerror(errno);
+      return db;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (std::size_t) st.st_size < header_size) {
+      error = file + " is not an invariant database";
+      ::close(fd);
+      return db;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping is kept after closing the file
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      error = "cannot map " + file + ": " + std::strerror(errno);
+      return db;
+    }
+
+    db.reset(new InvariantDb());
+    db->m_data = static_cast<const char*>(data);
+    db->m_size = st.st_size;
+    const uint32_t *header = reinterpret_cast<const uint32_t*>(db->m_data + sizeof(magic));
+    if (std::memcmp(db->m_data, magic, sizeof(magic)) != 0 ||
+	header[VERSION] != version) {
+      error = file + " is not an invariant database or its version is not supported";
+      db.reset();
+      return db;
+    }
+
+    // -- check that all sections are inside the file so queries do
+    // -- not need to check anything
+    uint64_t num_functions = header[NUM_FUNCTIONS], num_blocks = header[NUM_BLOCKS];
+    uint64_t num_csts = header[NUM_CSTS], num_terms = header[NUM_TERMS];
+    uint64_t num_strings = header[NUM_STRINGS];
+    const uint64_t section_words[] = {
+      num_functions * function_size, num_blocks * block_size, num_csts, num_csts,
+      num_csts, num_csts, num_terms, num_terms, num_strings + 1};
+    const uint32_t **sections[] = {
+      &db->m_functions, &db->m_blocks, &db->m_cst_kind, &db->m_cst_constant,
+      &db->m_cst_first_term, &db->m_cst_num_terms, &db->m_term_coeff, &db->m_term_var,
+      &db->m_string_offsets};
+    bool valid = true;
+    for (unsigned i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i) {
+      uint64_t off = header[OFF_FUNCTIONS + i];
+      valid &= (off % 4 == 0 && off + section_words[i] * 4 <= db->m_size);
+      if (valid) *(sections[i]) = reinterpret_cast<const uint32_t*>(db->m_data + off);
+    }
+    valid &= ((uint64_t) header[OFF_STRING_POOL] + header[STRING_POOL_SIZE] <= db->m_size);
+    if (valid) {
+      db->m_string_pool = db->m_data + header[OFF_STRING_POOL];
+      for (uint64_t i = 0; valid && i < num_strings; ++i) {
+	valid &= (db->m_string_offsets[i] <= db->m_string_offsets[i+1]);
+      }
+      valid &= (db->m_string_offsets[num_strings] <= header[STRING_POOL_SIZE]);
+    }
+    for (uint64_t i = 0; valid && i < num_functions; ++i) {
+      const uint32_t *f = db->m_functions + i * function_size;
+      valid &= (f[0] < num_strings && (uint64_t) f[1] + f[2] <= num_blocks);
+    }
+    for (uint64_t i = 0; valid && i < num_blocks; ++i) {
+      const uint32_t *b = db->m_blocks + i * block_size;
+      valid &= (b[0] < num_strings && (uint64_t) b[1] + b[2] <= num_csts &&
+		(uint64_t) b[3] + b[4] <= num_csts);
+    }
+    for (uint64_t i = 0; valid && i < num_csts; ++i) {
+      valid &= (db->m_cst_constant[i] < num_strings &&
+		(uint64_t) db->m_cst_first_term[i] + db->m_cst_num_terms[i] <= num_terms);
+    }
+    for (uint64_t i = 0; valid && i < num_terms; ++i) {
+      valid &= (db->m_term_coeff[i] < num_strings && db->m_term_var[i] < num_strings);
+    }
+    if (!valid) {
+      error = file + " is a corrupted invariant database";
+      db.reset();
+      return db;
+    }
+    db->m_num_functions = num_functions;
+    db->m_num_strings = num_strings;
+    return db;
+  }
+
+  idb_string_ref InvariantDb::get_string(uint32_t id) const {
+    idb_string_ref res;
+    res.data = m_string_pool + m_string_offsets[id];
+    res.size = m_string_offsets[id+1] - m_string_offsets[id];
+    return res;
+  }
+
+  // same order as std::string
+  int InvariantDb::compare(uint32_t id, const std::string &str) const {
+    idb_string_ref s = get_string(id);
+    int res = std::memcmp(s.data, str.data(), std::min<std::size_t>(s.size, str.size()));
+    if (res != 0) return res;
+    return (s.size < str.size() ? -1 : (s.size > str.size() ? 1 : 0));
+  }
+
+  int64_t InvariantDb::find_block(const std::string &function,
+				  const std::string &block) const {
+    // -- binary search of the function
+    uint32_t lo = 0, hi = m_num_functions;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (compare(m_functions[mid * function_size], function) < 0) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo == m_num_functions || compare(m_functions[lo * function_size], function) != 0)
+      return -1;
+
+    // -- binary search of the block among the blocks of the function
+    const uint32_t *f = m_functions + lo * function_size;
+    lo = f[1];
+    hi = f[1] + f[2];
+    uint32_t end = hi;
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (compare(m_blocks[mid * block_size], block) < 0) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo == end || compare(m_blocks[lo * block_size], block) != 0)
+      return -1;
+    return lo;
+  }
+
+  bool InvariantDb::get_pre(const std::string &function, const std::string &block,
+			    constraints &csts) const {
+    int64_t b = find_block(function, block);
+    if (b < 0) return false;
+    csts.m_db = this;
+    csts.m_first = m_blocks[b * block_size + 1];
+    csts.m_size = m_blocks[b * block_size + 2];
+    return true;
+  }
+
+  bool InvariantDb::get_post(const std::string &function, const std::string &block,
+			     constraints &csts) const {
+    int64_t b = find_block(function, block);
+    if (b < 0) return false;
+    csts.m_db = this;
+    csts.m_first = m_blocks[b * block_size + 3];
+    csts.m_size = m_blocks[b * block_size + 4];
+    return true;
+  }
+
+  unsigned InvariantDb::constraint::kind() const {
+    return m_db->m_cst_kind[m_id];
+  }
+
+  idb_string_ref InvariantDb::constraint::constant() const {
+    return m_db->get_string(m_db->m_cst_constant[m_id]);
+  }
+
+  unsigned InvariantDb::constraint::num_terms() const {
+    return m_db->m_cst_num_terms[m_id];
+  }
+
+  idb_string_ref InvariantDb::constraint::coefficient(unsigned i) const {
+    return m_db->get_string(m_db->m_term_coeff[m_db->m_cst_first_term[m_id] + i]);
+  }
+
+  idb_string_ref InvariantDb::constraint::variable(unsigned i) const {
+    return m_db->get_string(m_db->m_term_var[m_db->m_cst_first_term[m_id] + i]);
+  }
+
+} // end namespace crab_llvm
@@ -0,0 +1,301 @@
+#include "llvm/Support/ErrorHandling.h"
+
+#include "crab_llvm/LazyInvariants.hh"
+#include "crab_llvm/Support/Stats.hh"
+
+#include <algorithm>
+#include <iterator>
+#include <unistd.h>
+
+using namespace llvm;
+
+namespace crab_llvm {
+namespace lazy_impl {
+
+  /** Begin lazy_wrapper **/
+  wrapper_dom_ptr lazy_wrapper::getValueForWrite() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_val) {
+      m_val = (m_cache ? m_cache : build())->clone();
+      m_cache.reset();
+    }
+    return m_val;
+  }
+
+  wrapper_dom_ptr lazy_wrapper::materialize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_val) return m_val;
+    if (!m_cache_enabled) return build();
+    if (!m_cache) m_cache = build();
+    return m_cache;
+  }
+
+  wrapper_dom_ptr lazy_wrapper::clone() const {
+    return materialize()->clone();
+  }
+
+  lin_cst_sys_t lazy_wrapper::to_linear_constraints() {
+    return materialize()->to_linear_constraints();
+  }
+
+  lin_cst_sys_t lazy_wrapper::to_linear_constraints(const std::vector<var_t>& vars) const {
+    return materialize()->to_linear_constraints(vars);
+  }
+
+  void lazy_wrapper::for_each_constraint(const constraint_fn_t &f) const {
+    materialize()->for_each_constraint(f);
+  }
+
+  void lazy_wrapper::accept(GenericAbsDomVisitor &v) const {
+    // the value built on demand is alive until v returns
+    materialize()->accept(v);
+  }
+
+  unsigned lazy_wrapper::num_finite_bounds(const std::vector<var_t>& vars) {
+    return materialize()->num_finite_bounds(vars);
+  }
+
+  void lazy_wrapper::write(crab::crab_os& o) {
+    materialize()->write(o);
+  }
+
+  void lazy_wrapper::forget(const std::vector<var_t>& vars) {
+    getValueForWrite()->forget(vars);
+  }
+
+  void lazy_wrapper::project(const std::vector<var_t>& vars) {
+    getValueForWrite()->project(vars);
+  }
+
+  std::size_t lazy_wrapper::fingerprint() const {
+    return materialize()->fingerprint();
+  }
+
+  bool lazy_wrapper::shares_value(const GenericAbsDomWrapper &o) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_val && m_val->shares_value(o);
+  }
+
+  bool lazy_wrapper::equals(const GenericAbsDomWrapper &o) const {
+    return materialize()->equals(o);
+  }
+  /** End lazy_wrapper **/
+
+  wrapper_dom_ptr materialize(wrapper_dom_ptr absval) {
+    if (auto lazy = boost::dynamic_pointer_cast<lazy_wrapper>(absval)) {
+      return lazy->materialize();
+    }
+    return absval;
+  }
+
+  /** Begin spill_store **/
+  static void putU32(std::string &buf, uint32_t x) {
+    for (unsigned i = 0; i < 4; ++i) buf.push_back((char) ((x >> (8 * i)) & 0xff));
+  }
+
+  static uint32_t getU32(const std::string &buf, std::size_t &pos) {
+    uint32_t x = 0;
+    for (unsigned i = 0; i < 4; ++i) x |= ((uint32_t) (unsigned char) buf[pos++]) << (8 * i);
+    return x;
+  }
+
+  static void putString(std::string &buf, const std::string &s) {
+    putU32(buf, s.size());
+    buf.append(s);
+  }
+
+  static std::string getString(const std::string &buf, std::size_t &pos) {
+    uint32_t n = getU32(buf, pos);
+    std::string s = buf.substr(pos, n);
+    pos += n;
+    return s;
+  }
+
+  unsigned spill_store::getVarId(const var_t &v) {
+    auto it = m_var_ids.find(v);
+    if (it != m_var_ids.end()) return it->second;
+    m_vars.push_back(v);
+    m_var_ids.insert(std::make_pair(v, m_vars.size() - 1));
+    return m_vars.size() - 1;
+  }
+
+  lin_cst_sys_t spill_store::read(unsigned id) {
+    std::string buf(m_records[id].size, '\0');
+    std::fseek(m_file, m_records[id].offset, SEEK_SET);
+    if (std::fread(&buf[0], 1, buf.size(), m_file) != buf.size()) {
+      report_fatal_error("cannot read spilled invariants");
+    }
+    count_stat("CrabLlvm.count.reloaded_invariants");
+    lin_cst_sys_t csts;
+    std::size_t pos = 0;
+    for (uint32_t i = 0, num_csts = getU32(buf, pos); i < num_csts; ++i) {
+      unsigned kind = (unsigned char) buf[pos++];
+      lin_exp_t e(number_t(mpz_class(getString(buf, pos))));
+      for (uint32_t j = 0, num_terms = getU32(buf, pos); j < num_terms; ++j) {
+	number_t coeff(mpz_class(getString(buf, pos)));
+	e = e + coeff * m_vars[getU32(buf, pos)];
+      }
+      csts += (kind == 0 ? lin_cst_t(e == number_t(0)) :
+	       (kind == 1 ? lin_cst_t(e <= number_t(0)) : lin_cst_t(e != number_t(0))));
+    }
+    return csts;
+  }
+
+  void spill_store::evictLeastRecentlyUsed() {
+    while (m_lru.size() > m_capacity) {
+      m_cached.erase(m_lru.back().first);
+      m_lru.pop_back();
+    }
+  }
+
+  void spill_store::clear() {
+    m_records.clear();
+    m_free.clear();
+    m_vars.clear();
+    m_var_ids.clear();
+    std::fflush(m_file);
+    if (::ftruncate(::fileno(m_file), 0) != 0) {
+      report_fatal_error("cannot truncate the file of spilled invariants");
+    }
+  }
+
+  spill_store::spill_store(unsigned capacity)
+    : m_file(std::tmpfile()), m_capacity(capacity), m_num_live(0) {
+    if (!m_file) {
+      report_fatal_error("cannot create a temporary file to spill invariants");
+    }
+  }
+
+  spill_store::~spill_store() { std::fclose(m_file); }
+
+  unsigned spill_store::spill(const lin_cst_sys_t &csts) {
+    std::string buf;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    putU32(buf, std::distance(csts.begin(), csts.end()));
+    for (auto &cst: csts) {
+      buf.push_back((char) (cst.is_equality() ? 0 : (cst.is_inequality() ? 1 : 2)));
+      putString(buf, cst.expression().constant().get_str());
+      putU32(buf, std::distance(cst.expression().begin(), cst.expression().end()));
+      for (auto t: cst.expression()) {
+	putString(buf, t.first.get_str());
+	putU32(buf, getVarId(t.second));
+      }
+    }
+    // -- the first released record with enough space, if any
+    auto it = std::find_if(m_free.begin(), m_free.end(), [&](unsigned id) {
+	return m_records[id].reserved >= buf.size();
+      });
+    unsigned id;
+    if (it != m_free.end()) {
+      id = *it;
+      m_free.erase(it);
+      std::fseek(m_file, m_records[id].offset, SEEK_SET);
+    } else {
+      std::fseek(m_file, 0, SEEK_END);
+      record r = { std::ftell(m_file), 0, buf.size() };
+      m_records.push_back(r);
+      id = m_records.size() - 1;
+    }
+    if (std::fwrite(buf.data(), 1, buf.size(), m_file) != buf.size()) {
+      report_fatal_error("cannot spill invariants");
+    }
+    m_records[id].size = buf.size();
+    m_num_live++;
+    count_stat("CrabLlvm.count.spilled_invariants");
+    return id;
+  }
+
+  void spill_store::release(unsigned id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_cached.find(id);
+    if (it != m_cached.end()) {
+      m_lru.erase(it->second);
+      m_cached.erase(it);
+    }
+    if (--m_num_live == 0) {
+      clear();
+    } else {
+      m_free.push_back(id);
+    }
+  }
+  /** End spill_store **/
+
+  /** Begin delta_store **/
+  unsigned delta_store::getCstId(const lin_cst_t &cst) {
+    std::string key(1, (char) (cst.is_equality() ? 0 : (cst.is_inequality() ? 1 : 2)));
+    key += cst.expression().constant().get_str();
+    for (auto t: cst.expression()) {
+      unsigned v = m_var_ids.insert(std::make_pair(t.second, m_var_ids.size())).first->second;
+      key += ";" + t.first.get_str() + "*" + std::to_string(v);
+    }
+    auto res = m_cst_ids.insert(std::make_pair(key, m_csts.size()));
+    if (res.second) m_csts.push_back(cst);
+    return res.first->second;
+  }
+
+  void delta_store::cache(unsigned id, const std::vector<unsigned> &csts) {
+    m_lru.push_front(cached_record());
+    m_lru.front().id = id;
+    m_lru.front().csts = csts;
+    m_cached[id] = m_lru.begin();
+    while (m_lru.size() > cache_size) {
+      m_cached.erase(m_lru.back().id);
+      m_lru.pop_back();
+    }
+  }
+
+  std::vector<unsigned> delta_store::getCsts(unsigned id) {
+    auto it = m_cached.find(id);
+    if (it != m_cached.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+      return it->second->csts;
+    }
+    std::vector<unsigned> chain;
+    std::vector<unsigned> csts;
+    for (int cur = id; cur >= 0; cur = m_records[cur].parent) {
+      auto jt = m_cached.find(cur);
+      if (jt != m_cached.end()) {
+	csts = jt->second->csts;
+	break;
+      }
+      chain.push_back(cur);
+    }
+    for (auto i = chain.rbegin(), e = chain.rend(); i != e; ++i) {
+      const record &r = m_records[*i];
+      std::vector<unsigned> tmp;
+      std::set_difference(csts.begin(), csts.end(), r.removed.begin(), r.removed.end(),
+			  std::back_inserter(tmp));
+      csts.clear();
+      std::set_union(tmp.begin(), tmp.end(), r.added.begin(), r.added.end(),
+		     std::back_inserter(csts));
+    }
+    cache(id, csts);
+    return csts;
+  }
+
+  unsigned delta_store::add(int parent, const lin_cst_sys_t &csts) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<unsigned> ids;
+    for (auto &cst: csts) ids.push_back(getCstId(cst));
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    record r;
+    r.parent = parent;
+    if (parent >= 0) {
+      std::vector<unsigned> p = getCsts(parent);
+      std::set_difference(ids.begin(), ids.end(), p.begin(), p.end(),
+			  std::back_inserter(r.added));
+      std::set_difference(p.begin(), p.end(), ids.begin(), ids.end(),
+			  std::back_inserter(r.removed));
+    } else {
+      r.added = ids;
+    }
+    m_records.push_back(std::move(r));
+    cache(m_records.size() - 1, ids);
+    count_stat("CrabLlvm.count.delta_invariants");
+    return m_records.size() - 1;
+  }
+  /** End delta_store **/
+
+} // end namespace lazy_impl
+} // end namespace crab_llvm
@@ -32,6 +32,7 @@
 #include "crab/common/debug.hpp"
 
 #include <set>
+#include <mutex>
 #include <boost/unordered_map.hpp>
 #include <boost/range/iterator_range.hpp>
 #include "boost/range/algorithm/set_algorithm.hpp"
@@ -52,6 +53,15 @@ namespace crab_llvm {
     std::swap(s3, s1);
   }
   
+  // Return the region set of key in map, or empty if none. The maps
+  // are only modified by the constructor so the returned reference is
+  // stable and no lock is needed.
+  template <typename Map, typename Key, typename Set>
+  inline const Set& lookup(const Map &map, Key key, const Set &empty) {
+    auto it = map.find(key);
+    return (it == map.end() ? empty : it->second);
+  }
+  
   struct isInteger: std::unary_function<const llvm::Type*, bool> {
     unsigned m_bitwidth;
     isInteger(): m_bitwidth(0) {}
@@ -90,6 +100,32 @@ namespace crab_llvm {
     return nullptr;
   }
 
+  // return the alloca if v is a single-cell integer or boolean stack
+  // object of F whose address is only used by loads and stores of the
+  // allocated type, or nullptr otherwise.
+  static const llvm::Value* getLocalScalar(const llvm::Function& F,
+					   const llvm::Value* v) {
+    const llvm::AllocaInst* AI = llvm::dyn_cast_or_null<const llvm::AllocaInst>(v);
+    if (!AI || AI->getParent()->getParent() != &F || AI->isArrayAllocation())
+      return nullptr;
+    llvm::Type* ty = AI->getAllocatedType();
+    if (!ty->isIntegerTy())
+      return nullptr;
+    for (const llvm::User* U: AI->users()) {
+      if (const llvm::LoadInst* LI = llvm::dyn_cast<const llvm::LoadInst>(U)) {
+	if (LI->isVolatile() || LI->getType() != ty)
+	  return nullptr;
+      } else if (const llvm::StoreInst* SI = llvm::dyn_cast<const llvm::StoreInst>(U)) {
+	if (SI->isVolatile() || SI->getValueOperand() == AI ||
+	    SI->getValueOperand()->getType() != ty)
+	  return nullptr;
+      } else {
+	return nullptr;
+      }
+    }
+    return AI;
+  }
+
   // return true if the cell (n,o) contains a value of a specified
   // type by is_typed
   template<typename Pred>
@@ -337,9 +373,12 @@ namespace crab_llvm {
 			       
       }
     }
+    region_set_t onlyreads(reads);
+    set_difference(onlyreads, mods);
     m_func_accessed [&f] = reads;
     m_func_mods [&f] = mods;
     m_func_news [&f] = news;
+    m_func_onlyreads [&f] = onlyreads;
   }
 
   // Compute and cache the set of read, mod and new nodes of a
@@ -421,9 +460,12 @@ namespace crab_llvm {
     region_t ret = getRegion(*(I.getParent()->getParent()), &I);
     if (!ret.isUnknown()) mods.insert(ret); 
     
+    region_set_t onlyreads(reads);
+    set_difference(onlyreads, mods);
     m_callsite_accessed [&I] = reads; 
     m_callsite_mods [&I] = mods; 
     m_callsite_news [&I] = news; 
+    m_callsite_onlyreads [&I] = onlyreads;
   }
 
   LlvmDsaHeapAbstraction::LlvmDsaHeapAbstraction(llvm::Module& M,
@@ -458,6 +500,7 @@ namespace crab_llvm {
   // f is used to know in which DSGraph we should search for V
   LlvmDsaHeapAbstraction::region_t
   LlvmDsaHeapAbstraction::getRegion(const llvm::Function& F, llvm::Value* V)  {
+    std::lock_guard<std::mutex> lock(m_mutex);
     // Note each function has its own graph and a copy of the global
     // graph. Nodes in both graphs are merged.  However, m_dsa has
     // its own global graph which seems not to be merged with
@@ -494,6 +537,7 @@ namespace crab_llvm {
   }
   
   const llvm::Value* LlvmDsaHeapAbstraction::getSingleton(int region) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
     auto const it = m_rev_node_ids.find(region);
     if (it == m_rev_node_ids.end()) 
       return nullptr;
@@ -501,51 +545,57 @@ namespace crab_llvm {
     isIntegerOrBool pred;
     return getTypedSingleton(it->second, pred);
   }
+
+  const llvm::Value* LlvmDsaHeapAbstraction::getLocalSingleton(const llvm::Function& F,
+							       int region) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto const it = m_rev_node_ids.find(region);
+    if (it == m_rev_node_ids.end()) 
+      return nullptr;
+    const llvm::DSNode* n = it->second;
+    if (!n || n->isArrayNode())
+      return nullptr;
+    return getLocalScalar(F, n->getUniqueScalar());
+  }
   
-  LlvmDsaHeapAbstraction::region_set_t
-  LlvmDsaHeapAbstraction::getAccessedRegions(const llvm::Function& F)  {
-    return m_func_accessed [&F];
+  const LlvmDsaHeapAbstraction::region_set_t&
+  LlvmDsaHeapAbstraction::getAccessedRegions(const llvm::Function& F) {
+    return lookup(m_func_accessed, &F, m_empty_set);
   }
-
-  LlvmDsaHeapAbstraction::region_set_t
-  LlvmDsaHeapAbstraction::getOnlyReadRegions(const llvm::Function& F)  {
-    region_set_t s1 = m_func_accessed [&F];
-    region_set_t s2 = m_func_mods [&F];
-    set_difference(s1,s2);
-    return s1;
+  
+  const LlvmDsaHeapAbstraction::region_set_t&
+  LlvmDsaHeapAbstraction::getOnlyReadRegions(const llvm::Function& F) {
+    return lookup(m_func_onlyreads, &F, m_empty_set);
   }
   
-  LlvmDsaHeapAbstraction::region_set_t
+  const LlvmDsaHeapAbstraction::region_set_t&
   LlvmDsaHeapAbstraction::getModifiedRegions(const llvm::Function& F) {
-    return m_func_mods [&F];
+    return lookup(m_func_mods, &F, m_empty_set);
   }
   
-  LlvmDsaHeapAbstraction::region_set_t
+  const LlvmDsaHeapAbstraction::region_set_t&
   LlvmDsaHeapAbstraction::getNewRegions(const llvm::Function& F) {
-    return m_func_news [&F];
+    return lookup(m_func_news, &F, m_empty_set);
   }
   
-  LlvmDsaHeapAbstraction::region_set_t
+  const LlvmDsaHeapAbstraction::region_set_t&
   LlvmDsaHeapAbstraction::getAccessedRegions(llvm::CallInst& I) {
-    return m_callsite_accessed [&I];
+    return lookup(m_callsite_accessed, &I, m_empty_set);
   }
   
-  LlvmDsaHeapAbstraction::region_set_t
-  LlvmDsaHeapAbstraction::getOnlyReadRegions(llvm::CallInst& I)  {
-    region_set_t s1 = m_callsite_accessed [&I];
-    region_set_t s2 = m_callsite_mods [&I];
-    set_difference(s1,s2);
-    return s1;
+  const LlvmDsaHeapAbstraction::region_set_t&
+  LlvmDsaHeapAbstraction::getOnlyReadRegions(llvm::CallInst& I) {
+    return lookup(m_callsite_onlyreads, &I, m_empty_set);
   }
   
-  LlvmDsaHeapAbstraction::region_set_t
+  const LlvmDsaHeapAbstraction::region_set_t&
   LlvmDsaHeapAbstraction::getModifiedRegions(llvm::CallInst& I) {
-    return m_callsite_mods [&I];
+    return lookup(m_callsite_mods, &I, m_empty_set);
   }
   
-  LlvmDsaHeapAbstraction::region_set_t
-  LlvmDsaHeapAbstraction::getNewRegions(llvm::CallInst& I)  {
-    return m_callsite_news [&I];
+  const LlvmDsaHeapAbstraction::region_set_t&
+  LlvmDsaHeapAbstraction::getNewRegions(llvm::CallInst& I) {
+    return lookup(m_callsite_news, &I, m_empty_set);
   }
 } // end namespace
 #endif 
@@ -0,0 +1,69 @@
+#include "llvm/IR/Function.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/LoopStats.hh"
+#include "crab_llvm/Support/Stats.hh"
+#include "crab/common/debug.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  namespace loop_stats_impl {
+
+    static std::string getLocation(const BasicBlock &B) {
+      for (auto &I: B) {
+	if (DILocation *loc = I.getDebugLoc().get()) {
+	  return loc->getFilename().str() + ":" + std::to_string(loc->getLine());
+	}
+      }
+      return "unknown";
+    }
+
+    // Print one line per loop of F with the number of constraints of
+    // the invariants at its header and the maximum over its blocks
+    // (sizes). The lines of F are written at once since functions can
+    // be analyzed in parallel.
+    void print(const Function &F, const block_size_map_t &sizes) {
+      static std::mutex print_mutex;
+      std::string lines;
+      raw_string_ostream o(lines);
+      DominatorTree DT;
+      DT.recalculate(const_cast<Function&>(F));
+      LoopInfo LI;
+      LI.analyze(DT);
+      std::vector<const Loop*> worklist(LI.begin(), LI.end());
+      while (!worklist.empty()) {
+	const Loop *L = worklist.back();
+	worklist.pop_back();
+	worklist.insert(worklist.end(), L->begin(), L->end());
+	const BasicBlock *header = L->getHeader();
+	unsigned header_size = sizes.lookup(header);
+	unsigned max_size = 0;
+	for (const BasicBlock *B: L->blocks()) {
+	  max_size = std::max(max_size, sizes.lookup(B));
+	}
+	o << "LOOP_STAT " << F.getName()
+	  << " header=" << header->getName()
+	  << " depth=" << L->getLoopDepth()
+	  << " blocks=" << L->getNumBlocks()
+	  << " loc=" << getLocation(*header)
+	  << " header_csts=" << header_size
+	  << " max_csts=" << max_size << "\n";
+	count_max_stat("Loops.count.maxCsts", max_size);
+      }
+      if (o.str().empty()) return;
+      std::lock_guard<std::mutex> lock(print_mutex);
+      crab::outs() << lines;
+    }
+  } // end namespace loop_stats_impl
+
+} // end namespace crab_llvm
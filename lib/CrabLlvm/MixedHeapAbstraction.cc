@@ -0,0 +1,133 @@
+#include "crab_llvm/config.h"
+
+/**
+ * Heap abstraction that uses one of two heap abstractions per function.
+ */
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/InstIterator.h"
+
+#include "crab_llvm/MixedHeapAbstraction.hh"
+
+namespace crab_llvm {
+
+using namespace llvm;
+
+  MixedHeapAbstraction::region_t
+  MixedHeapAbstraction::map(const region_t &r, bool fallback) {
+    if (r.isUnknown()) {
+      return region_t();
+    }
+    region_info r_info(r.get_type(), r.get_bitwidth());
+    int id = 2 * r.get_id() + (fallback ? 1 : 0);
+    return region_t(static_cast<HeapAbstraction*>(this), id, r_info);
+  }
+
+  MixedHeapAbstraction::region_set_t
+  MixedHeapAbstraction::map(const region_set_t &s, bool fallback) {
+    region_set_t res;
+    for (const region_t &r: s) {
+      region_t mr = map(r, fallback);
+      if (!mr.isUnknown()) res.insert(mr);
+    }
+    return res;
+  }
+
+  MixedHeapAbstraction::MixedHeapAbstraction(Module &M,
+					     boost::shared_ptr<HeapAbstraction> main,
+					     boost::shared_ptr<HeapAbstraction> fallback,
+					     const DenseSet<const Function*> &fallback_funcs)
+    : m_main(main), m_fallback(fallback), m_fallback_funcs(fallback_funcs) {
+
+    for (Function &F: M) {
+      if (F.isDeclaration()) continue;
+      bool fb = m_fallback_funcs.count(&F);
+      HeapAbstraction &mem = (fb ? *m_fallback : *m_main);
+      m_func_sets[ACCESSED][&F] = map(mem.getAccessedRegions(F), fb);
+      m_func_sets[ONLY_READ][&F] = map(mem.getOnlyReadRegions(F), fb);
+      m_func_sets[MODIFIED][&F] = map(mem.getModifiedRegions(F), fb);
+      m_func_sets[NEW][&F] = map(mem.getNewRegions(F), fb);
+      for (auto &I: instructions(&F)) {
+	CallInst *CI = dyn_cast<CallInst>(&I);
+	if (!CI) continue;
+	m_callsite_sets[ACCESSED][CI] = map(mem.getAccessedRegions(*CI), fb);
+	m_callsite_sets[ONLY_READ][CI] = map(mem.getOnlyReadRegions(*CI), fb);
+	m_callsite_sets[MODIFIED][CI] = map(mem.getModifiedRegions(*CI), fb);
+	m_callsite_sets[NEW][CI] = map(mem.getNewRegions(*CI), fb);
+      }
+    }
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::lookup(const Function &F, set_kind_t k) const {
+    auto it = m_func_sets[k].find(&F);
+    return (it == m_func_sets[k].end() ? m_empty_set : it->second);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::lookup(const CallInst &I, set_kind_t k) const {
+    auto it = m_callsite_sets[k].find(&I);
+    return (it == m_callsite_sets[k].end() ? m_empty_set : it->second);
+  }
+
+  MixedHeapAbstraction::region_t
+  MixedHeapAbstraction::getRegion(const Function &F, Value *V) {
+    bool fb = m_fallback_funcs.count(&F);
+    return map((fb ? m_fallback : m_main)->getRegion(F, V), fb);
+  }
+
+  const Value* MixedHeapAbstraction::getSingleton(int region) const {
+    if (region < 0) return nullptr;
+    return (region % 2 ? m_fallback : m_main)->getSingleton(region / 2);
+  }
+
+  const Value* MixedHeapAbstraction::getLocalSingleton(const Function &F,
+						       int region) const {
+    if (region < 0) return nullptr;
+    return (region % 2 ? m_fallback : m_main)->getLocalSingleton(F, region / 2);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getAccessedRegions(const Function &F) {
+    return lookup(F, ACCESSED);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getOnlyReadRegions(const Function &F) {
+    return lookup(F, ONLY_READ);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getModifiedRegions(const Function &F) {
+    return lookup(F, MODIFIED);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getNewRegions(const Function &F) {
+    return lookup(F, NEW);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getAccessedRegions(CallInst &I) {
+    return lookup(I, ACCESSED);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getOnlyReadRegions(CallInst &I) {
+    return lookup(I, ONLY_READ);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getModifiedRegions(CallInst &I) {
+    return lookup(I, MODIFIED);
+  }
+
+  const MixedHeapAbstraction::region_set_t&
+  MixedHeapAbstraction::getNewRegions(CallInst &I) {
+    return lookup(I, NEW);
+  }
+
+} // end namespace crab_llvm
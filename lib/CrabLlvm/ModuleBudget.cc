@@ -0,0 +1,100 @@
+#include "llvm/IR/Module.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/ConfigProfile.hh"
+#include "crab_llvm/ModuleBudget.hh"
+#include "crab_llvm/ModuleState.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab/common/debug.hpp"
+
+#include <algorithm>
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  namespace budget_impl {
+
+    /** Begin scheduler **/
+    double scheduler::ms_per_inst() const {
+      // -- the default is used until some function is analyzed
+      return (m_analyzed_size > 0 ? m_analyzed_ms / m_analyzed_size : 0.05);
+    }
+
+    double scheduler::estimate(const Function &F) const {
+      auto it = m_history_ms.find(&F);
+      if (it != m_history_ms.end()) return it->second;
+      auto s = m_sizes.find(&F);
+      return (s == m_sizes.end() ? 0.0 : s->second * ms_per_inst());
+    }
+
+    scheduler::scheduler(Module &M, const ModuleState &state, unsigned seconds,
+			 unsigned threads)
+      : m_deadline(clock_t::now() + std::chrono::seconds(seconds)),
+	m_threads(std::max(1U, threads)), m_pending(0),
+	m_pending_history_ms(0), m_pending_size(0),
+	m_analyzed_ms(0), m_analyzed_size(0), m_downgraded(0) {
+      for (auto &F: M) {
+	if (!state.is_analyzed(F) || !isTrackable(F)) continue;
+	m_pending++;
+	const config_profile_impl::entry *e =
+	  (state.config_profile ? state.config_profile->find(F) : nullptr);
+	if (e) {
+	  m_history_ms[&F] = e->ms;
+	  m_pending_history_ms += e->ms;
+	} else {
+	  unsigned size = 0;
+	  for (auto &B: F) size += B.size();
+	  m_sizes[&F] = size;
+	  m_pending_size += size;
+	}
+      }
+    }
+
+    // Make params cheaper if F is not expected to fit in its share
+    void scheduler::apply(const Function &F, AnalysisParams &params) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      double remaining = std::chrono::duration_cast<std::chrono::milliseconds>
+	(m_deadline - clock_t::now()).count() * (double) m_threads;
+      double pending = m_pending_history_ms + m_pending_size * ms_per_inst();
+      if (pending <= remaining) return;
+      double share = remaining / std::max(1U, m_pending);
+      double cost = estimate(F);
+      if (cost <= share && remaining > 0) return;
+      bool downgraded = false;
+      if (params.run_backward) {
+	params.run_backward = false;
+	cost /= 2;
+	downgraded = true;
+      }
+      if ((cost > share || remaining <= 0) && params.dom != INTERVALS) {
+	params.dom = INTERVALS;
+	downgraded = true;
+      }
+      if (downgraded) {
+	m_downgraded++;
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Analyzing " << F.getName()
+					 << " with cheaper options to meet the module budget\n");
+      }
+    }
+
+    void scheduler::done(const Function &F, unsigned ms) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_pending > 0) m_pending--;
+      auto it = m_history_ms.find(&F);
+      if (it != m_history_ms.end()) {
+	m_pending_history_ms -= it->second;
+	m_history_ms.erase(it);
+	return;
+      }
+      auto s = m_sizes.find(&F);
+      if (s == m_sizes.end()) return;
+      m_pending_size -= s->second;
+      m_analyzed_size += s->second;
+      m_analyzed_ms += ms;
+      m_sizes.erase(s);
+    }
+    /** End scheduler **/
+  } // end namespace budget_impl
+
+} // end namespace crab_llvm
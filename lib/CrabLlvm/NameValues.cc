@@ -4,74 +4,117 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/CommandLine.h"
 
-#include <boost/tokenizer.hpp>
-#include <boost/algorithm/string/predicate.hpp>
+#include "crab_llvm/crab_cfg.hh"
+
+#include <mutex>
+#include <string>
 
 using namespace llvm;
 
+static cl::opt<bool>
+LazyNames("crab-lazy-names",
+	  cl::desc("Do not name unnamed values: names are only computed when "
+		   "printing (values are not found by name, e.g., by --crab-incremental)"),
+	  cl::init(false));
+
 namespace crab_llvm {
 
+  /* 
+   * Call f(V, slot) for each unnamed value V of F with the slot
+   * number used by the LLVM printer. The function is walked in the
+   * same order as the printer: unnamed arguments, then each block
+   * followed by its non-void instructions.
+   */
+  template<typename Fn>
+  static void forEachUnnamedValue (Function &F, Fn f)
+  {
+    unsigned slot = 0;
+    for (Function::arg_iterator AI = F.arg_begin (), AE = F.arg_end (); AI != AE; ++AI)
+    {
+      if (!AI->hasName ()) f (*AI, slot++);
+    }
+    for (Function::iterator BI = F.begin (), BE = F.end (); BI != BE; ++BI)
+    {
+      BasicBlock &BB = *BI;
+      if (!BB.hasName ()) f (BB, slot++);
+      for (BasicBlock::iterator II = BB.begin (), IE = BB.end (); II != IE; ++II)
+      {
+        Instruction &I = *II;
+        if (!I.hasName () && !(I.getType ()->isVoidTy ())) f (I, slot++);
+      }
+    }
+  }
+
+  namespace lazy_names_impl {
+    typedef DenseMap<const Value*, unsigned> slot_map_t;
+    // slots of the functions whose names were requested. Names can
+    // be printed by several threads.
+    static DenseMap<const Function*, slot_map_t> slots;
+    static std::mutex slots_mutex;
+
+    static const Function* getParent (const Value &v)
+    {
+      if (const Argument *A = dyn_cast<Argument> (&v)) return A->getParent ();
+      if (const BasicBlock *B = dyn_cast<BasicBlock> (&v)) return B->getParent ();
+      if (const Instruction *I = dyn_cast<Instruction> (&v))
+        return I->getParent () ? I->getParent ()->getParent () : nullptr;
+      return nullptr;
+    }
+  }
+
+  std::string get_slot_name (const Value *v)
+  {
+    using namespace lazy_names_impl;
+    const Function *F = getParent (*v);
+    if (!F) return "_unnamed";
+    
+    std::lock_guard<std::mutex> lock (slots_mutex);
+    slot_map_t &m = slots[F];
+    auto it = m.find (v);
+    if (it == m.end ())
+    {
+      // -- the function changed since its slots were computed
+      m.clear ();
+      forEachUnnamedValue (const_cast<Function&> (*F),
+			   [&m](Value &V, unsigned slot) { m[&V] = slot; });
+      it = m.find (v);
+      if (it == m.end ()) return "_unnamed";
+    }
+    return "_" + std::to_string (it->second);
+  }
+  
   char NameValues::ID = 0;
 
+  bool NameValues::lazy ()
+  {
+    return LazyNames;
+  }
+  
   bool NameValues::runOnModule (Module &M)
   {
+    if (lazy ()) return false;
+    
     for (Module::iterator FI = M.begin (), E = M.end (); FI != E; ++FI)
       runOnFunction (*FI);
     return false;
   }
 
+  // Unnamed blocks and instructions are named after the slot numbers
+  // used by the LLVM printer (e.g., %5 becomes %_5) without printing
+  // the function.
   bool NameValues::runOnFunction (Function &F)
   {
-    // -- print to string 
-    std::string funcAsm;
-    raw_string_ostream out (funcAsm);
-    out << F;
-    out.flush ();
-    
-    typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
-    boost::char_separator<char> nl_sep ("\n");
-    boost::char_separator<char> sp_sep (" :\t%@");
-    
-    tokenizer lines (funcAsm, nl_sep);
-    tokenizer::iterator line_iter = lines.begin ();
-    
-    // -- skip function attributes
-    if (boost::starts_with(*line_iter, "; Function Attrs:"))
-      ++line_iter;
-    
-    // -- skip function definition line
-    ++line_iter;
-    
-    for (Function::iterator BI = F.begin (), BE = F.end (); 
-         BI != BE && line_iter != lines.end (); ++BI)
-    {
-      BasicBlock &BB = *BI;
-      
-      if (!BB.hasName ())
-      {
-        std::string bb_line = *line_iter;
-        tokenizer names (bb_line, sp_sep);
-        std::string bb_name = *names.begin ();
-        if (bb_name == ";") bb_name = "un";
-        BB.setName ("_" + bb_name);
-      }
-      ++line_iter;
-      
-      for (BasicBlock::iterator II = BB.begin (), IE = BB.end ();
-           II != IE && line_iter != lines.end (); ++II)
-      {
-        Instruction &I = *II;
-        if (!I.hasName () && !(I.getType ()->isVoidTy ())) 
-        {
-          std::string inst_line = *line_iter;
-          tokenizer names (inst_line, sp_sep);
-          std::string inst_name = *names.begin ();
-          I.setName ("_" + inst_name);
-          }
-        ++line_iter;
-      }
-    }
+    std::string name;
+    forEachUnnamedValue (F, [&name](Value &V, unsigned slot) {
+        // arguments keep their slots but they are not named
+        if (isa<Argument> (V)) return;
+        name = "_";
+        name += std::to_string (slot);
+        V.setName (name);
+      });
     return false;
   }      
 } // end namespace
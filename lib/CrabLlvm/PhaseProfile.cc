@@ -0,0 +1,119 @@
+#include "llvm/IR/Function.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/ExportInvariants.hh"
+#include "crab_llvm/PhaseProfile.hh"
+#include "crab_llvm/ModuleState.hh"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  namespace profile_impl {
+
+    /** Begin profiler **/
+    void profiler::addTime(const Function &F, const std::string &phase, double secs) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_profiles[F.getName().str()].phases[phase] += secs;
+    }
+
+    void profiler::addCounters(const Function &F, const std::string &phase,
+			       const perf_sample &s) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_profiles[F.getName().str()].counters[phase] += s;
+    }
+
+    void profiler::addSize(const Function &F, size_t csts) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      function_profile &p = m_profiles[F.getName().str()];
+      p.max_csts = std::max(p.max_csts, csts);
+    }
+
+    void profiler::addCfgSize(const Function &F, size_t blocks, size_t stmts) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      function_profile &p = m_profiles[F.getName().str()];
+      p.blocks = blocks;
+      p.stmts = stmts;
+    }
+
+    // the domain of the last analysis of F
+    void profiler::setDomain(const Function &F, const std::string &dom) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_profiles[F.getName().str()].domain = dom;
+    }
+
+    void profiler::write(const std::string &file) {
+      std::ofstream o(file);
+      if (!o) {
+	errs() << "Warning: cannot write profile in " << file << "\n";
+	return;
+      }
+      std::lock_guard<std::mutex> lock(m_mutex);
+      o << "{\"functions\":[";
+      bool first = true;
+      for (auto &kv: m_profiles) {
+	o << (first ? "\n" : ",\n") << " {\"function\":";
+	first = false;
+	export_impl::writeJsonString(o, kv.first);
+	for (auto &phase: kv.second.phases) {
+	  o << ",\"" << phase.first << "\":" << phase.second;
+	}
+	o << ",\"max_csts\":" << kv.second.max_csts
+	  << ",\"blocks\":" << kv.second.blocks
+	  << ",\"stmts\":" << kv.second.stmts;
+	if (!kv.second.domain.empty()) {
+	  o << ",\"domain\":";
+	  export_impl::writeJsonString(o, kv.second.domain);
+	}
+	if (!kv.second.counters.empty()) {
+	  o << ",\"counters\":{";
+	  bool first_phase = true;
+	  for (auto &phase: kv.second.counters) {
+	    const perf_sample &c = phase.second;
+	    o << (first_phase ? "" : ",") << "\"" << phase.first << "\":{";
+	    first_phase = false;
+	    for (unsigned i = 0; i < perf_sample::NUM_COUNTERS; ++i) {
+	      o << "\"" << perf_sample::name(i) << "\":" << c.values[i] << ",";
+	    }
+	    o << "\"ipc\":" << c.ipc()
+	      << ",\"llc_miss_rate\":" << c.llc_miss_rate()
+	      << ",\"branch_miss_rate\":" << c.branch_miss_rate() << "}";
+	  }
+	  o << "}";
+	}
+	o << "}";
+      }
+      o << "\n]}\n";
+    }
+    /** End profiler **/
+
+    /** Begin scoped_phase **/
+    scoped_phase::scoped_phase(const ModuleState *state, const Function &F, std::string phase)
+      : m_prof(state ? state->profile.get() : nullptr),
+	m_fun(F), m_phase(std::move(phase)), m_counters(false),
+	m_trace(m_phase, F.getName()),
+	m_alloc(state ? state->alloc_stats.get() : nullptr, m_phase, &F) {
+      if (m_prof) {
+	m_counters = m_prof->hasCounters() && read_perf_counters(m_start_counters);
+	m_start = std::chrono::steady_clock::now();
+      }
+    }
+
+    scoped_phase::~scoped_phase() {
+      if (m_prof) {
+	std::chrono::duration<double> d = std::chrono::steady_clock::now() - m_start;
+	m_prof->addTime(m_fun, m_phase, d.count());
+	perf_sample end;
+	if (m_counters && read_perf_counters(end)) {
+	  m_prof->addCounters(m_fun, m_phase, end - m_start_counters);
+	}
+      }
+    }
+    /** End scoped_phase **/
+  } // end namespace profile_impl
+
+} // end namespace crab_llvm
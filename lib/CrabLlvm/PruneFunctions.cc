@@ -0,0 +1,62 @@
+#include "llvm/IR/Function.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/InstIterator.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/HeapAbstraction.hh"
+#include "crab_llvm/PruneFunctions.hh"
+
+using namespace llvm;
+using namespace crab::cfg;
+
+namespace crab_llvm {
+
+  namespace prune_impl {
+
+    // F has no checks and its callers cannot observe its execution:
+    // it does not return a tracked value and it does not modify nor
+    // create regions.
+    static bool hasNoLocalEffects(const Function &F, HeapAbstraction &mem,
+				  tracked_precision tracklev) {
+      if (F.getName() == "main") return false;
+      if (CfgBuilder::num_checks(F) > 0) return false;
+      Type *ty = F.getReturnType();
+      if (ty->isIntegerTy() || (tracklev >= crab::cfg::PTR && ty->isPointerTy())) {
+	return false;
+      }
+      if (tracklev == crab::cfg::ARR &&
+	  (!mem.getModifiedRegions(F).empty() || !mem.getNewRegions(F).empty())) {
+	return false;
+      }
+      return true;
+    }
+
+    function_set_t getPrunable(const std::vector<Function*> &funcs,
+			       HeapAbstraction &mem, tracked_precision tracklev) {
+      function_set_t trackable(funcs.begin(), funcs.end());
+      function_set_t res;
+      for (Function *F: funcs) {
+	if (hasNoLocalEffects(*F, mem, tracklev)) res.insert(F);
+      }
+      bool change = true;
+      while (change) {
+	change = false;
+	for (Function *F: funcs) {
+	  if (res.count(F) == 0) continue;
+	  for (auto &I: instructions(F)) {
+	    ImmutableCallSite CS(&I);
+	    if (!CS) continue;
+	    const Function *callee = CS.getCalledFunction();
+	    if (callee && trackable.count(callee) > 0 && res.count(callee) == 0) {
+	      res.erase(F);
+	      change = true;
+	      break;
+	    }
+	  }
+	}
+      }
+      return res;
+    }
+  } // end namespace prune_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,122 @@
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include "llvm/ADT/SmallString.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/Reproducers.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab/common/debug.hpp"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+using namespace llvm;
+
+namespace crab_llvm {
+
+  namespace repro_impl {
+
+    static std::string fileName(const Function &F) {
+      std::string name = F.getName().str();
+      for (char &c: name) {
+	if (!std::isalnum((unsigned char) c) && c != '_' && c != '.') c = '_';
+      }
+      return name;
+    }
+
+    // options of the command line that do not depend on the files
+    // of the original run
+    static bool isReplayOption(const std::string &arg) {
+      StringRef a(arg);
+      a = a.ltrim('-');
+      if (!a.startswith("crab-")) return false;
+      static const char *excluded[] =
+	{"crab-extract-", "crab-only-functions", "crab-roots", "crab-export-",
+	 "crab-import-", "crab-checks-stream", "crab-checks-cache", "crab-incremental",
+	 "crab-profile", "crab-trace", "crab-heap-snapshot", "crab-threads"};
+      for (const char *e: excluded) {
+	if (a.startswith(e)) return false;
+      }
+      return true;
+    }
+
+    static bool writeModule(Function &F, const std::string &file) {
+      ValueToValueMapTy vmap;
+      std::unique_ptr<Module> M = CloneModule(F.getParent(), vmap);
+      const Value *clone = vmap[&F];
+      for (Function &G: *M) {
+	if (&G == clone || G.isDeclaration()) continue;
+	G.deleteBody();
+	G.setComdat(nullptr);
+      }
+      std::error_code ec;
+      raw_fd_ostream os(file, ec, sys::fs::F_None);
+      if (ec) return false;
+      WriteBitcodeToFile(M.get(), os);
+      return true;
+    }
+
+    static bool writeText(const std::string &file, const std::string &text) {
+      std::ofstream o(file);
+      if (!o) return false;
+      o << text;
+      return (bool) o;
+    }
+
+    /** Begin recorder **/
+    void recorder::add(Function &F, unsigned ms, const AnalysisParams &params,
+		       const std::string &cfg) {
+      std::ostringstream o;
+      o << "function: " << F.getName().str() << "\n"
+	<< "time_ms: " << ms << "\n"
+	<< "domain: " << params.abs_dom_to_str() << "\n"
+	<< "backward: " << params.run_backward << "\n"
+	<< "liveness: " << params.run_liveness << "\n"
+	<< "relational_threshold: " << params.relational_threshold << "\n"
+	<< "widening_delay: " << params.widening_delay << "\n"
+	<< "narrowing_iterations: " << params.narrowing_iters << "\n"
+	<< "widening_jumpset: " << params.widening_jumpset << "\n"
+	<< "check: " << (int) params.check << "\n";
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_funcs.push_back({&F, ms, o.str(), cfg});
+    }
+
+    void recorder::write(const std::string &dir, const std::vector<std::string> &args) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_funcs.empty()) return;
+      if (sys::fs::create_directories(dir)) {
+	errs() << "Warning: cannot create " << dir << "\n";
+	return;
+      }
+      std::string opts;
+      for (auto &a: args) {
+	if (isReplayOption(a)) opts += a + "\n";
+      }
+      for (slow_function &sf: m_funcs) {
+	SmallString<256> prefix(dir);
+	sys::path::append(prefix, fileName(*sf.fun));
+	std::string p = prefix.str().str();
+	if (!writeModule(*sf.fun, p + ".bc") ||
+	    !writeText(p + ".args", opts) ||
+	    !writeText(p + ".params", sf.params) ||
+	    !writeText(p + ".crab", sf.cfg)) {
+	  errs() << "Warning: cannot write the reproducer " << p << "\n";
+	  continue;
+	}
+	CRAB_VERBOSE_IF(1, get_crab_os() << "Analysis of " << sf.fun->getName()
+					 << " took " << sf.ms << " ms: reproducer in "
+					 << p << ".bc\n";);
+      }
+      m_funcs.clear();
+    }
+    /** End recorder **/
+  } // end namespace repro_impl
+
+} // end namespace crab_llvm
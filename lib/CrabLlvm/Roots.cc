@@ -0,0 +1,61 @@
+#include "llvm/IR/Module.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/Roots.hh"
+
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+extern cl::list<std::string> CrabRoots;
+
+namespace crab_llvm {
+
+  namespace roots_impl {
+
+    bool enabled() { return !CrabRoots.empty(); }
+
+    /** Begin reachable_set **/
+    bool reachable_set::isReachable(const Function &F) const {
+      return !enabled() || m_reachable.count(&F) > 0;
+    }
+
+    unsigned reachable_set::init(Module &M, CallGraph &cg) {
+      m_reachable.clear();
+      std::vector<const Function*> worklist;
+      unsigned num_roots = 0;
+      for (auto &name: CrabRoots) {
+	if (const Function *F = M.getFunction(name)) {
+	  num_roots++;
+	  if (m_reachable.insert(F).second) worklist.push_back(F);
+	} else {
+	  errs() << "Warning: root " << name << " not found\n";
+	}
+      }
+      bool address_taken = false;
+      while (!worklist.empty()) {
+	const Function *F = worklist.back();
+	worklist.pop_back();
+	for (auto &rec: *cg[F]) {
+	  if (const Function *callee = rec.second->getFunction()) {
+	    if (m_reachable.insert(callee).second) worklist.push_back(callee);
+	  } else if (!address_taken) {
+	    address_taken = true;
+	    for (auto &G: M) {
+	      if (G.hasAddressTaken() && m_reachable.insert(&G).second) {
+		worklist.push_back(&G);
+	      }
+	    }
+	  }
+	}
+      }
+      return num_roots;
+    }
+    /** End reachable_set **/
+  } // end namespace roots_impl
+
+} // end namespace crab_llvm
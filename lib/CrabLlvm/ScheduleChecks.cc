@@ -0,0 +1,110 @@
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CfgBuilder.hh"
+#include "crab_llvm/ModuleState.hh"
+#include "crab_llvm/ScheduleChecks.hh"
+
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
+using namespace llvm;
+
+extern cl::opt<std::string> CrabIncremental;
+extern cl::opt<bool> CrabScheduleChecks;
+
+namespace crab_llvm {
+
+  namespace schedule_impl {
+
+    typedef boost::unordered_set<std::string> name_set_t;
+    
+    // functions with some error check in this run
+    static name_set_t failed;
+    static std::mutex failed_mutex;
+    
+    static std::string getHistoryFile() {
+      return CrabIncremental + "/failed-functions";
+    }
+
+    static name_set_t loadHistory() {
+      name_set_t res;
+      if (CrabIncremental == "") return res;
+      std::ifstream i(getHistoryFile());
+      std::string name;
+      while (std::getline(i, name)) {
+	res.insert(name);
+      }
+      return res;
+    }
+
+    void storeHistory() {
+      if (CrabIncremental == "") return;
+      std::ofstream o(getHistoryFile());
+      if (!o) {
+	errs() << "Warning: cannot write " << getHistoryFile() << "\n";
+	return;
+      }
+      for (auto &name: failed) {
+	o << name << "\n";
+      }
+    }
+
+    // Forget the functions of the previous module: a process can
+    // analyze several modules (batch mode or the C API)
+    void reset() {
+      std::lock_guard<std::mutex> lock(failed_mutex);
+      failed.clear();
+    }
+    
+    void record(const Function &F, const checks_db_t &checks) {
+      if (checks.get_total_error() > 0) {
+	std::lock_guard<std::mutex> lock(failed_mutex);
+	failed.insert(F.getName().str());
+      }
+    }
+
+    // Return all the functions of M analyzed by the pass in the order
+    // they should be analyzed
+    std::vector<Function*> getSchedule(Module &M, const ModuleState &state) {
+      std::vector<Function*> res;
+      for (auto &F: M) {
+	if (state.is_analyzed(F)) {
+	  res.push_back(&F);
+	}
+      }
+      if (!CrabScheduleChecks) return res;
+
+      name_set_t history = loadHistory();
+      struct score_t {
+	bool failed;
+	unsigned checks;
+	size_t size;
+      };
+      boost::unordered_map<const Function*, score_t> scores;
+      for (Function *F: res) {
+	score_t score = {history.count(F->getName().str()) > 0,
+			 CfgBuilder::num_checks(*F), 0};
+	for (auto &B: *F) {
+	  score.size += B.size();
+	}
+	scores[F] = score;
+      }
+      std::stable_sort(res.begin(), res.end(),
+		       [&scores](const Function *F1, const Function *F2) {
+			 const score_t &s1 = scores[F1];
+			 const score_t &s2 = scores[F2];
+			 if (s1.failed != s2.failed) return s1.failed;
+			 if (s1.checks != s2.checks) return s1.checks > s2.checks;
+			 return s1.size < s2.size;
+		       });
+      return res;
+    }
+  } // end namespace schedule_impl
+
+} // end namespace crab_llvm
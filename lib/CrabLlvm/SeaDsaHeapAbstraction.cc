@@ -18,6 +18,7 @@
 #include "crab/common/debug.hpp"
 
 #include <set>
+#include <mutex>
 #include <boost/unordered_map.hpp>
 #include <boost/range/iterator_range.hpp>
 #include <boost/range/algorithm/set_algorithm.hpp>
@@ -44,6 +45,15 @@ namespace seadsa_heap_abs_impl {
     std::swap(s3, s1);
   }
   
+  // Return the region set of key in map, or empty if none. The maps
+  // are only modified by the constructor so the returned reference is
+  // stable and no lock is needed.
+  template <typename Map, typename Key, typename Set>
+  inline const Set& lookup(const Map &map, Key key, const Set &empty) {
+    auto it = map.find(key);
+    return (it == map.end() ? empty : it->second);
+  }
+  
   struct isInteger: std::unary_function<const llvm::Type*, bool> {
     unsigned m_bitwidth;
     isInteger(): m_bitwidth(0) {}
@@ -135,6 +145,32 @@ namespace seadsa_heap_abs_impl {
     return nullptr;
   }
 
+  // return the alloca if v is a single-cell integer or boolean stack
+  // object of F whose address is only used by loads and stores of the
+  // allocated type, or nullptr otherwise.
+  static const llvm::Value* getLocalScalar(const llvm::Function& F,
+					   const llvm::Value* v) {
+    const llvm::AllocaInst* AI = llvm::dyn_cast_or_null<const llvm::AllocaInst>(v);
+    if (!AI || AI->getParent()->getParent() != &F || AI->isArrayAllocation())
+      return nullptr;
+    llvm::Type* ty = AI->getAllocatedType();
+    if (!ty->isIntegerTy())
+      return nullptr;
+    for (const llvm::User* U: AI->users()) {
+      if (const llvm::LoadInst* LI = llvm::dyn_cast<const llvm::LoadInst>(U)) {
+	if (LI->isVolatile() || LI->getType() != ty)
+	  return nullptr;
+      } else if (const llvm::StoreInst* SI = llvm::dyn_cast<const llvm::StoreInst>(U)) {
+	if (SI->isVolatile() || SI->getValueOperand() == AI ||
+	    SI->getValueOperand()->getType() != ty)
+	  return nullptr;
+      } else {
+	return nullptr;
+      }
+    }
+    return AI;
+  }
+
   // return true if the cell (n,o) contains a value of a specified
   // type by is_typed
   template<typename Pred>
@@ -311,32 +347,26 @@ namespace seadsa_heap_abs_impl {
   // class methods
   ///////
 
-  // Return -1 if it cannot assign an id to the cell.
-  int SeaDsaHeapAbstraction::getId(const Cell& c) {
-    const Node* n = c.getNode();
-    unsigned offset = c.getOffset();
-    
-    /** 
-     * Begin extra conditions for array smashing-like abstractions 
-     * TODO: we can move these extra conditions to canBeDisambiguated.
-     **/
-    if (!n->isModified() && !n->isRead()) {
-      CRAB_LOG("heap-abs",
-	       llvm::errs() << "\tBut discarding it because it is never accessed.\n";);
-      return -1;      
+  // Return true if the cell (n,offset) does not overlap with other
+  // cells and, if n is an array, it is its only accessed cell. The
+  // verdict only depends on the node so it is cached.
+  bool SeaDsaHeapAbstraction::isValidCell(const Node* n, unsigned offset) {
+    auto key = std::make_pair(n, offset);
+    auto it = m_valid_cells.find(key);
+    if (it != m_valid_cells.end()) {
+      return it->second;
     }
-
-    // TODO: caching
+    
+    bool valid = true;
+    Cell c(const_cast<Node*>(n), offset);
     if (is_overlapping_cell(c, m_dl)) {
       // TOIMPROVE: we can assign same id to all overlapping cells but it
       // wouldn't be sound for array domains that ignore pointer
       // arithmetic. Maybe have a flag?
       CRAB_LOG("heap-abs",
 	       llvm::errs() << "\tBut discarding it because overlaps with other cells.\n";);
-      return -1;
-    }
-    
-    if (n->isArray()) {
+      valid = false;
+    } else if (n->isArray()) {
       // TOIMPROVE: we can assign the same id to all node's cells but it
       // would be unsound for array domains that ignore pointer
       // arithmetic. Maybe have a flag?
@@ -349,9 +379,31 @@ namespace seadsa_heap_abs_impl {
 	CRAB_LOG("heap-abs",
 		 llvm::errs() << "\tBut discarding it because cell's node is marked as array "
 		              << "and it can be accessed with different offsets.\n";);
-	return -1;
+	valid = false;
       }
     }
+    m_valid_cells[key] = valid;
+    return valid;
+  }
+  
+  // Return -1 if it cannot assign an id to the cell.
+  int SeaDsaHeapAbstraction::getId(const Cell& c) {
+    const Node* n = c.getNode();
+    unsigned offset = c.getOffset();
+    
+    /** 
+     * Begin extra conditions for array smashing-like abstractions 
+     * TODO: we can move these extra conditions to canBeDisambiguated.
+     **/
+    if (!n->isModified() && !n->isRead()) {
+      CRAB_LOG("heap-abs",
+	       llvm::errs() << "\tBut discarding it because it is never accessed.\n";);
+      return -1;      
+    }
+
+    if (!isValidCell(n, offset)) {
+      return -1;
+    }
 
     // FIXME: do we need to ignore recursive nodes?
     
@@ -360,30 +412,23 @@ namespace seadsa_heap_abs_impl {
      **/
 
     
-    auto it = m_node_ids.find(n);
-    if (it != m_node_ids.end()) {
-      return it->second + offset;
+    // -- ids are only allocated for the cells that are accessed so
+    //    large objects do not reserve one id per byte.
+    auto key = std::make_pair(n, offset);
+    auto it = m_cell_ids.find(key);
+    if (it != m_cell_ids.end()) {
+      return it->second;
     }
     
-    unsigned id = m_max_id;
-    m_node_ids[n] = id;
+    unsigned id = m_max_id++;
+    m_cell_ids[key] = id;
 
     // XXX: we only have the reverse map for the offset 0.  That's
     // fine because we use this map only in getSingleton which can
     // only succeed if offset 0.
-    m_rev_node_ids[id] = n;
-    
-    if (n->size() == 0) {
-      // XXX: nodes can have zero size
-      assert (offset == 0);
-      m_max_id++;
-      return id;
-    }
-    
-    // -- allocate enough ids for every byte of the object
-    assert (n->size() > 0);
-    m_max_id += n->size();
-    return id + offset;
+    m_rev_node_ids.push_back(offset == 0 ? n : nullptr);
+    assert(m_rev_node_ids.size() == m_max_id);
+    return id;
   }
 
   // compute and cache the set of read, mod and new nodes of a whole
@@ -435,9 +480,12 @@ namespace seadsa_heap_abs_impl {
 	}
       }
     }
+    region_set_t onlyreads(reads);
+    seadsa_heap_abs_impl::set_difference(onlyreads, mods);
     m_func_accessed[&f] = reads;
     m_func_mods[&f] = mods;
     m_func_news[&f] = news;
+    m_func_onlyreads[&f] = onlyreads;
   }
 
   // Compute and cache the set of read, mod and new nodes of a
@@ -521,9 +569,12 @@ namespace seadsa_heap_abs_impl {
     region_t ret = getRegion(*(I.getParent()->getParent()), &I);
     if (!ret.isUnknown()) mods.insert(ret); 
     
+    region_set_t onlyreads(reads);
+    seadsa_heap_abs_impl::set_difference(onlyreads, mods);
     m_callsite_accessed[&I] = reads; 
     m_callsite_mods[&I] = mods; 
     m_callsite_news[&I] = news; 
+    m_callsite_onlyreads[&I] = onlyreads;
   }
 
   SeaDsaHeapAbstraction::SeaDsaHeapAbstraction(llvm::Module& M, llvm::CallGraph& cg,
@@ -586,6 +637,19 @@ namespace seadsa_heap_abs_impl {
   // f is used to know in which Graph we should search for V
   SeaDsaHeapAbstraction::region_t
   SeaDsaHeapAbstraction::getRegion(const llvm::Function& fn, llvm::Value* V)  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto key = std::make_pair(&fn, const_cast<const llvm::Value*>(V));
+    auto it = m_region_cache.find(key);
+    if (it != m_region_cache.end()) {
+      return it->second;
+    }
+    region_t r = computeRegion(fn, V);
+    m_region_cache[key] = r;
+    return r;
+  }
+
+  SeaDsaHeapAbstraction::region_t
+  SeaDsaHeapAbstraction::computeRegion(const llvm::Function& fn, llvm::Value* V)  {
     if (!m_dsa || !m_dsa->hasGraph(fn)) {
       return region_t();
     }
@@ -620,58 +684,63 @@ namespace seadsa_heap_abs_impl {
   }
   
   const llvm::Value* SeaDsaHeapAbstraction::getSingleton(int region) const {
-    auto const it = m_rev_node_ids.find(region);
-    if (it == m_rev_node_ids.end()) 
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (region < 0 || (unsigned) region >= m_rev_node_ids.size()) 
       return nullptr;
     //  TODO: consider also singleton containing pointers.
     seadsa_heap_abs_impl::isIntegerOrBool pred;
-    return getTypedSingleton(it->second, pred);
+    return getTypedSingleton(m_rev_node_ids[region], pred);
+  }
+
+  const llvm::Value* SeaDsaHeapAbstraction::getLocalSingleton(const llvm::Function& F,
+							      int region) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (region < 0 || (unsigned) region >= m_rev_node_ids.size()) 
+      return nullptr;
+    const Node* n = m_rev_node_ids[region];
+    if (!n || n->isArray())
+      return nullptr;
+    return getLocalScalar(F, n->getUniqueScalar());
   }
   
-  SeaDsaHeapAbstraction::region_set_t
-  SeaDsaHeapAbstraction::getAccessedRegions(const llvm::Function& fn)  {
-    return m_func_accessed[&fn];
+  const SeaDsaHeapAbstraction::region_set_t&
+  SeaDsaHeapAbstraction::getAccessedRegions(const llvm::Function& fn) {
+    return seadsa_heap_abs_impl::lookup(m_func_accessed, &fn, m_empty_set);
   }
-
-  SeaDsaHeapAbstraction::region_set_t
-  SeaDsaHeapAbstraction::getOnlyReadRegions(const llvm::Function& fn)  {
-    region_set_t s1 = m_func_accessed[&fn];
-    region_set_t s2 = m_func_mods[&fn];
-    seadsa_heap_abs_impl::set_difference(s1,s2);
-    return s1;
+  
+  const SeaDsaHeapAbstraction::region_set_t&
+  SeaDsaHeapAbstraction::getOnlyReadRegions(const llvm::Function& fn) {
+    return seadsa_heap_abs_impl::lookup(m_func_onlyreads, &fn, m_empty_set);
   }
   
-  SeaDsaHeapAbstraction::region_set_t
+  const SeaDsaHeapAbstraction::region_set_t&
   SeaDsaHeapAbstraction::getModifiedRegions(const llvm::Function& fn) {
-    return m_func_mods[&fn];
+    return seadsa_heap_abs_impl::lookup(m_func_mods, &fn, m_empty_set);
   }
   
-  SeaDsaHeapAbstraction::region_set_t
+  const SeaDsaHeapAbstraction::region_set_t&
   SeaDsaHeapAbstraction::getNewRegions(const llvm::Function& fn) {
-    return m_func_news[&fn];
+    return seadsa_heap_abs_impl::lookup(m_func_news, &fn, m_empty_set);
   }
   
-  SeaDsaHeapAbstraction::region_set_t
+  const SeaDsaHeapAbstraction::region_set_t&
   SeaDsaHeapAbstraction::getAccessedRegions(llvm::CallInst& I) {
-    return m_callsite_accessed[&I];
+    return seadsa_heap_abs_impl::lookup(m_callsite_accessed, &I, m_empty_set);
   }
   
-  SeaDsaHeapAbstraction::region_set_t
-  SeaDsaHeapAbstraction::getOnlyReadRegions(llvm::CallInst& I)  {
-    region_set_t s1 = m_callsite_accessed[&I];
-    region_set_t s2 = m_callsite_mods[&I];
-    seadsa_heap_abs_impl::set_difference(s1,s2);
-    return s1;
+  const SeaDsaHeapAbstraction::region_set_t&
+  SeaDsaHeapAbstraction::getOnlyReadRegions(llvm::CallInst& I) {
+    return seadsa_heap_abs_impl::lookup(m_callsite_onlyreads, &I, m_empty_set);
   }
   
-  SeaDsaHeapAbstraction::region_set_t
+  const SeaDsaHeapAbstraction::region_set_t&
   SeaDsaHeapAbstraction::getModifiedRegions(llvm::CallInst& I) {
-    return m_callsite_mods[&I];
+    return seadsa_heap_abs_impl::lookup(m_callsite_mods, &I, m_empty_set);
   }
   
-  SeaDsaHeapAbstraction::region_set_t
-  SeaDsaHeapAbstraction::getNewRegions(llvm::CallInst& I)  {
-    return m_callsite_news[&I];
-  }  
+  const SeaDsaHeapAbstraction::region_set_t&
+  SeaDsaHeapAbstraction::getNewRegions(llvm::CallInst& I) {
+    return seadsa_heap_abs_impl::lookup(m_callsite_news, &I, m_empty_set);
+  }
   
 } // end namespace
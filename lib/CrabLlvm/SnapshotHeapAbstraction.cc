@@ -0,0 +1,398 @@
+#include "crab_llvm/config.h"
+
+/**
+ * Heap abstraction loaded from a snapshot written by a previous run.
+ *
+ * Format (text, one record per line):
+ *
+ *   crab-heap-snapshot VERSION
+ *   hash MD5                        of the module and the heap options
+ *   region ID TYPE BITWIDTH GLOBAL  GLOBAL is the index of the
+ *                                   singleton global or -1
+ *   value FUNC VALUE ID             region of a function value
+ *   global FUNC GLOBAL ID           region of a global used in FUNC
+ *   func FUNC KIND N ID_1 ... ID_N  regions of a function
+ *   local FUNC VALUE ID             VALUE is the local singleton of
+ *                                   region ID in FUNC
+ *   call FUNC VALUE KIND N ID_1 ... ID_N   regions of a callsite
+ *
+ * FUNC and GLOBAL are positions in the module. The values of a
+ * function are numbered from 0: first the arguments, then the
+ * instructions in order and then the constant expressions used by
+ * the instructions (e.g., a getelementptr of a global) in the order
+ * they are found. KIND is one of accessed, onlyread, mod and new.
+ **/
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/SnapshotHeapAbstraction.hh"
+
+#include <boost/range/iterator_range.hpp>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace crab_llvm {
+
+using namespace llvm;
+
+namespace snapshot_impl {
+
+  static const unsigned version = 3;
+  static const char* set_names[] = {"accessed", "onlyread", "mod", "new"};
+
+  static std::string moduleHash(Module &M, const std::string &config) {
+    std::string str;
+    raw_string_ostream os(str);
+    M.print(os, nullptr);
+    os.flush();
+    MD5 h;
+    h.update(config);
+    h.update(str);
+    MD5::MD5Result res;
+    h.final(res);
+    SmallString<32> hex;
+    MD5::stringifyResult(res, hex);
+    return hex.str();
+  }
+
+  // the constant expressions used by U (and by them) that are not
+  // in seen yet, in depth-first order
+  static void addConstantExprs(User &U, SmallPtrSet<const Value*, 16> &seen,
+			       std::vector<Value*> &values) {
+    for (auto &op : U.operands()) {
+      if (ConstantExpr *CE = dyn_cast<ConstantExpr>(op.get())) {
+	if (seen.insert(CE).second) {
+	  values.push_back(CE);
+	  addConstantExprs(*CE, seen, values);
+	}
+      }
+    }
+  }
+  
+  // arguments, instructions and then the constant expressions used
+  // by the instructions
+  static void numberValues(Function &F, std::vector<Value*> &values) {
+    for (auto &A : boost::make_iterator_range(F.arg_begin(), F.arg_end())) {
+      values.push_back(&A);
+    }
+    for (auto &I : boost::make_iterator_range(inst_begin(F), inst_end(F))) {
+      values.push_back(&I);
+    }
+    SmallPtrSet<const Value*, 16> seen;
+    for (auto &I : boost::make_iterator_range(inst_begin(F), inst_end(F))) {
+      addConstantExprs(I, seen, values);
+    }
+  }
+
+  template<typename Set>
+  static void writeSet(std::ostream &o, const Set &s) {
+    o << " " << s.size();
+    for (auto const &r : s) {
+      o << " " << r.get_id();
+    }
+    o << "\n";
+  }
+
+  template<typename Set>
+  static bool readSet(std::istream &in, const std::map<int, typename Set::value_type> &regions,
+		      Set &s) {
+    unsigned n;
+    if (!(in >> n)) return false;
+    for (unsigned i = 0; i < n; ++i) {
+      int id;
+      if (!(in >> id)) return false;
+      auto it = regions.find(id);
+      if (it == regions.end()) return false;
+      s.insert(it->second);
+    }
+    return true;
+  }
+
+  static int setKind(const std::string &name) {
+    for (unsigned k = 0; k < 4; ++k) {
+      if (name == set_names[k]) return k;
+    }
+    return -1;
+  }
+} // end namespace snapshot_impl
+
+  bool SnapshotHeapAbstraction::write(HeapAbstraction &mem, Module &M,
+				      const std::string &file, const std::string &config) {
+    using namespace snapshot_impl;
+    std::ofstream out(file.c_str());
+    if (!out) return false;
+
+    DenseMap<const Value*, int> gv_ids;
+    int num_gvs = 0;
+    for (auto &GV : boost::make_iterator_range(M.global_begin(), M.global_end())) {
+      gv_ids[&GV] = num_gvs++;
+    }
+
+    std::map<int, region_t> regions;
+    std::ostringstream body;
+    unsigned fid = 0;
+    for (auto &F : M) {
+      unsigned cur = fid++;
+      if (F.isDeclaration()) continue;
+
+      std::vector<Value*> values;
+      numberValues(F, values);
+      DenseMap<const Value*, unsigned> value_ids;
+      for (unsigned vid = 0; vid < values.size(); ++vid) {
+	value_ids[values[vid]] = vid;
+      }
+      // regions used by F: they can have a local singleton in F
+      std::set<int> fun_regions;
+      SmallPtrSet<const Value*, 16> seen_gvs;
+      for (unsigned vid = 0; vid < values.size(); ++vid) {
+	Value *v = values[vid];
+	region_t r = mem.getRegion(F, v);
+	if (!r.isUnknown()) {
+	  regions.insert(std::make_pair(r.get_id(), r));
+	  fun_regions.insert(r.get_id());
+	  body << "value " << cur << " " << vid << " " << r.get_id() << "\n";
+	}
+	if (isa<Instruction>(v) || isa<ConstantExpr>(v)) {
+	  // -- globals used by the function (directly or through a
+	  //    constant expression) have their own cells
+	  for (auto &op : cast<User>(v)->operands()) {
+	    auto it = gv_ids.find(op.get());
+	    if (it == gv_ids.end() || !seen_gvs.insert(op.get()).second) continue;
+	    region_t gr = mem.getRegion(F, op.get());
+	    if (!gr.isUnknown()) {
+	      regions.insert(std::make_pair(gr.get_id(), gr));
+	      fun_regions.insert(gr.get_id());
+	      body << "global " << cur << " " << it->second << " " << gr.get_id() << "\n";
+	    }
+	  }
+	}
+	if (CallInst *CI = dyn_cast<CallInst>(v)) {
+	  const region_set_t* sets[] = {&mem.getAccessedRegions(*CI), &mem.getOnlyReadRegions(*CI),
+					&mem.getModifiedRegions(*CI), &mem.getNewRegions(*CI)};
+	  for (unsigned k = 0; k < NUM_SET_KINDS; ++k) {
+	    if (sets[k]->empty()) continue;
+	    for (auto const &r : *sets[k]) {
+	      regions.insert(std::make_pair(r.get_id(), r));
+	      fun_regions.insert(r.get_id());
+	    }
+	    body << "call " << cur << " " << vid << " " << set_names[k];
+	    writeSet(body, *sets[k]);
+	  }
+	}
+      }
+      const region_set_t* sets[] = {&mem.getAccessedRegions(F), &mem.getOnlyReadRegions(F),
+				    &mem.getModifiedRegions(F), &mem.getNewRegions(F)};
+      for (unsigned k = 0; k < NUM_SET_KINDS; ++k) {
+	if (sets[k]->empty()) continue;
+	for (auto const &r : *sets[k]) {
+	  regions.insert(std::make_pair(r.get_id(), r));
+	  fun_regions.insert(r.get_id());
+	}
+	body << "func " << cur << " " << set_names[k];
+	writeSet(body, *sets[k]);
+      }
+      for (int id : fun_regions) {
+	if (const Value *v = mem.getLocalSingleton(F, id)) {
+	  auto it = value_ids.find(v);
+	  if (it != value_ids.end()) {
+	    body << "local " << cur << " " << it->second << " " << id << "\n";
+	  }
+	}
+      }
+    }
+
+    out << "crab-heap-snapshot " << version << "\n";
+    out << "hash " << moduleHash(M, config) << "\n";
+    for (auto &kv : regions) {
+      const region_t &r = kv.second;
+      int singleton = -1;
+      if (const Value *gv = r.getSingleton()) {
+	auto it = gv_ids.find(gv);
+	if (it != gv_ids.end()) singleton = it->second;
+      }
+      out << "region " << r.get_id() << " " << (int) r.get_type() << " "
+	  << r.get_bitwidth() << " " << singleton << "\n";
+    }
+    out << body.str();
+    return (bool) out;
+  }
+
+  std::unique_ptr<SnapshotHeapAbstraction>
+  SnapshotHeapAbstraction::load(Module &M, const std::string &file,
+				const std::string &config, std::string &error) {
+    using namespace snapshot_impl;
+    std::ifstream in(file.c_str());
+    if (!in) {
+      error = "cannot open " + file;
+      return nullptr;
+    }
+
+    std::string tag, hash;
+    unsigned ver = 0;
+    if (!(in >> tag >> ver) || tag != "crab-heap-snapshot" || ver != version) {
+      error = file + " is not a heap snapshot";
+      return nullptr;
+    }
+    if (!(in >> tag >> hash) || tag != "hash" || hash != moduleHash(M, config)) {
+      error = file + " was computed for a different module or heap options";
+      return nullptr;
+    }
+
+    std::vector<Function*> funcs;
+    for (auto &F : M) funcs.push_back(&F);
+    std::vector<Value*> gvs;
+    for (auto &GV : boost::make_iterator_range(M.global_begin(), M.global_end())) {
+      gvs.push_back(&GV);
+    }
+    // values of each function are numbered on demand
+    std::vector<std::vector<Value*> > values(funcs.size());
+    auto getValue = [&](unsigned f, unsigned v) -> Value* {
+      if (values[f].empty()) numberValues(*funcs[f], values[f]);
+      return (v < values[f].size() ? values[f][v] : nullptr);
+    };
+
+    std::unique_ptr<SnapshotHeapAbstraction> snap(new SnapshotHeapAbstraction());
+    std::map<int, region_t> regions;
+    while (in >> tag) {
+      bool ok = false;
+      if (tag == "region") {
+	int id, type, singleton;
+	unsigned bitwidth;
+	if (in >> id >> type >> bitwidth >> singleton &&
+	    singleton < (int) gvs.size()) {
+	  regions[id] = region_t(static_cast<HeapAbstraction*>(snap.get()), id,
+				 region_info((region_type_t) type, bitwidth));
+	  if (singleton >= 0) snap->m_singletons[id] = gvs[singleton];
+	  ok = true;
+	}
+      } else if (tag == "value" || tag == "global") {
+	unsigned f, v;
+	int id;
+	if (in >> f >> v >> id && f < funcs.size() && regions.count(id)) {
+	  Value *val = nullptr;
+	  if (tag == "value") {
+	    val = getValue(f, v);
+	  } else if (v < gvs.size()) {
+	    val = gvs[v];
+	  }
+	  if (val) {
+	    snap->m_regions[std::make_pair(funcs[f], val)] = regions[id];
+	    ok = true;
+	  }
+	}
+      } else if (tag == "local") {
+	unsigned f, v;
+	int id;
+	if (in >> f >> v >> id && f < funcs.size() && regions.count(id)) {
+	  if (Value *val = getValue(f, v)) {
+	    snap->m_local_singletons[std::make_pair(funcs[f], id)] = val;
+	    ok = true;
+	  }
+	}
+      } else if (tag == "func") {
+	unsigned f;
+	std::string kind;
+	if (in >> f >> kind && f < funcs.size()) {
+	  int k = setKind(kind);
+	  ok = (k >= 0 && readSet(in, regions, snap->m_func_sets[k][funcs[f]]));
+	}
+      } else if (tag == "call") {
+	unsigned f, v;
+	std::string kind;
+	if (in >> f >> v >> kind && f < funcs.size()) {
+	  int k = setKind(kind);
+	  if (CallInst *CI = dyn_cast_or_null<CallInst>(getValue(f, v))) {
+	    ok = (k >= 0 && readSet(in, regions, snap->m_callsite_sets[k][CI]));
+	  }
+	}
+      }
+      if (!ok) {
+	error = file + " is corrupted near " + tag;
+	return nullptr;
+      }
+    }
+    return snap;
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::lookup(const Function &F, set_kind_t k) const {
+    auto it = m_func_sets[k].find(&F);
+    return (it == m_func_sets[k].end() ? m_empty_set : it->second);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::lookup(const CallInst &I, set_kind_t k) const {
+    auto it = m_callsite_sets[k].find(&I);
+    return (it == m_callsite_sets[k].end() ? m_empty_set : it->second);
+  }
+
+  SnapshotHeapAbstraction::region_t
+  SnapshotHeapAbstraction::getRegion(const Function &F, Value *V) {
+    auto it = m_regions.find(std::make_pair(&F, const_cast<const Value*>(V)));
+    return (it == m_regions.end() ? region_t() : it->second);
+  }
+
+  const Value* SnapshotHeapAbstraction::getSingleton(int region) const {
+    auto it = m_singletons.find(region);
+    return (it == m_singletons.end() ? nullptr : it->second);
+  }
+
+  const Value* SnapshotHeapAbstraction::getLocalSingleton(const Function &F,
+							 int region) const {
+    auto it = m_local_singletons.find(std::make_pair(&F, region));
+    return (it == m_local_singletons.end() ? nullptr : it->second);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getAccessedRegions(const Function &F) {
+    return lookup(F, ACCESSED);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getOnlyReadRegions(const Function &F) {
+    return lookup(F, ONLY_READ);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getModifiedRegions(const Function &F) {
+    return lookup(F, MODIFIED);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getNewRegions(const Function &F) {
+    return lookup(F, NEW);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getAccessedRegions(CallInst &I) {
+    return lookup(I, ACCESSED);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getOnlyReadRegions(CallInst &I) {
+    return lookup(I, ONLY_READ);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getModifiedRegions(CallInst &I) {
+    return lookup(I, MODIFIED);
+  }
+
+  const SnapshotHeapAbstraction::region_set_t&
+  SnapshotHeapAbstraction::getNewRegions(CallInst &I) {
+    return lookup(I, NEW);
+  }
+
+} // end namespace crab_llvm
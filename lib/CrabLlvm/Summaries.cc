@@ -0,0 +1,117 @@
+#include "llvm/IR/Function.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/ADT/SmallString.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CrabLlvmUtils.hh"
+#include "crab_llvm/IncrementalAnalysis.hh"
+#include "crab_llvm/Summaries.hh"
+#include "crab_llvm/Support/Log.hh"
+#include "crab_llvm/Support/Stats.hh"
+#include "crab/common/debug.hpp"
+
+#include <fstream>
+#include <vector>
+
+using namespace llvm;
+
+extern cl::opt<bool> CrabCompactSummaries;
+extern cl::opt<unsigned> CrabSummaryMaxRelational;
+
+namespace crab_llvm {
+
+  namespace summaries_impl {
+
+    static const std::string header = "CRAB-SUMMARIES 1";
+
+    std::string getKey(const Function &F, const AnalysisParams &params,
+		       HeapAbstraction &mem) {
+      std::map<std::string, const Function*> reach;
+      std::vector<const Function*> worklist(1, &F);
+      while (!worklist.empty()) {
+	const Function *G = worklist.back();
+	worklist.pop_back();
+	if (!reach.insert(std::make_pair(G->getName().str(), G)).second) continue;
+	for (auto &I: instructions(G)) {
+	  ImmutableCallSite CS(&I);
+	  if (!CS) continue;
+	  const Function *callee = CS.getCalledFunction();
+	  if (callee && isTrackable(*callee)) worklist.push_back(callee);
+	}
+      }
+      std::string key = "summary;" + std::to_string((int) params.sum_dom);
+      if (CrabCompactSummaries) {
+	key += ";compact=" + std::to_string(CrabSummaryMaxRelational);
+      }
+      for (auto &kv: reach) {
+	key += "|" + kv.first + "=" + incremental_impl::getKey(*kv.second, params, mem);
+      }
+      MD5 hash;
+      hash.update(key);
+      MD5::MD5Result res;
+      hash.final(res);
+      SmallString<32> hash_str;
+      MD5::stringifyResult(res, hash_str);
+      return hash_str.str().str();
+    }
+
+    // <name> <key> <summary> per line where name and summary are
+    // written as <length>:<string>
+    bool load(const std::string &file, summary_db_t &db) {
+      std::ifstream i(file);
+      if (!i) return false;
+      std::string line;
+      if (!std::getline(i, line) || line != header) return false;
+      std::string name, key, summary;
+      while (incremental_impl::readName(i, name)) {
+	if (!(i >> key) || !i.ignore(1) || !incremental_impl::readName(i, summary)) {
+	  return false;
+	}
+	db[name] = std::make_pair(key, summary);
+      }
+      return i.eof();
+    }
+
+    void store(const std::string &file, const summary_db_t &db) {
+      std::ofstream o(file);
+      if (!o) {
+	errs() << "Warning: cannot write summaries in " << file << "\n";
+	return;
+      }
+      o << header << "\n";
+      for (auto &kv: db) {
+	incremental_impl::writeName(o, kv.first);
+	o << " " << kv.second.first << " ";
+	incremental_impl::writeName(o, kv.second.second);
+	o << "\n";
+      }
+    }
+
+    void compare(const summary_db_t &imported, const summary_db_t &computed) {
+      unsigned same = 0, changed = 0, differ = 0;
+      for (auto &kv: computed) {
+	auto it = imported.find(kv.first);
+	if (it == imported.end()) continue;
+	if (it->second.first != kv.second.first) {
+	  changed++;
+	} else if (it->second.second != kv.second.second) {
+	  differ++;
+	  errs() << "Warning: summary of " << kv.first
+		 << " differs from the imported one\n";
+	} else {
+	  same++;
+	}
+      }
+      count_max_stat("Summaries.imported.valid", same);
+      count_max_stat("Summaries.imported.stale", changed);
+      count_max_stat("Summaries.imported.different", differ);
+      CRAB_VERBOSE_IF(1, get_crab_os() << "Imported summaries: " << same << " valid, "
+		      << changed << " stale, " << differ << " different.\n");
+    }
+  } // end namespace summaries_impl
+
+} // end namespace crab_llvm
@@ -0,0 +1,355 @@
+#include "crab_llvm/config.h"
+
+/**
+ * Type-based heap abstraction: no pointer analysis is run.
+ */
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/TypeHeapAbstraction.hh"
+#include "crab/common/debug.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace crab_llvm {
+
+using namespace llvm;
+
+namespace type_heap_abs_impl {
+
+  template <typename Set>
+  void set_difference(Set &s1, const Set &s2) {
+    Set s3;
+    std::set_difference(s1.begin(), s1.end(), s2.begin(), s2.end(),
+			std::inserter(s3, s3.end()));
+    std::swap(s3, s1);
+  }
+
+  // return true if s1 changed
+  template <typename Set>
+  bool set_union(Set &s1, const Set &s2) {
+    size_t old_size = s1.size();
+    s1.insert(s2.begin(), s2.end());
+    return s1.size() != old_size;
+  }
+
+  template <typename Map, typename Key, typename Set>
+  inline const Set& lookup(const Map &map, Key key, const Set &empty) {
+    auto it = map.find(key);
+    return (it == map.end() ? empty : it->second);
+  }
+
+  // strip arrays from t
+  static Type* elementType(Type *t) {
+    while (ArrayType *at = dyn_cast<ArrayType>(t)) {
+      t = at->getElementType();
+    }
+    return t;
+  }
+
+  // return the struct type pointed by t after stripping arrays, if
+  // any.
+  static StructType* pointedStruct(Type *t) {
+    if (PointerType *pt = dyn_cast<PointerType>(t)) {
+      return dyn_cast<StructType>(elementType(pt->getElementType()));
+    }
+    return nullptr;
+  }
+
+  // return true if the address V flows to something else than the
+  // pointer operand of a load or a store.
+  static bool addressEscapes(const Value *V) {
+    for (const User *U: V->users()) {
+      if (isa<LoadInst>(U)) {
+	continue;
+      } else if (const StoreInst *SI = dyn_cast<StoreInst>(U)) {
+	if (SI->getValueOperand() == V) return true;
+      } else if (isa<GEPOperator>(U)) {
+	if (addressEscapes(U)) return true;
+      } else {
+	return true;
+      }
+    }
+    return false;
+  }
+
+  // return the last struct indexed by gep and the offset of its
+  // field, or null if gep does not index a struct.
+  static StructType* lastStructField(const GEPOperator *gep,
+				     const DataLayout &dl, uint64_t &offset) {
+    StructType *last = nullptr;
+    for (gep_type_iterator it = gep_type_begin(gep), et = gep_type_end(gep);
+	 it != et; ++it) {
+      if (StructType *st = dyn_cast<StructType>(*it)) {
+	unsigned idx = cast<ConstantInt>(it.getOperand())->getZExtValue();
+	last = st;
+	offset = dl.getStructLayout(st)->getElementOffset(idx);
+      }
+    }
+    return last;
+  }
+
+} // end namespace type_heap_abs_impl
+
+  bool TypeHeapAbstraction::computeKey(const Value *V, cell_key_t &key) const {
+    PointerType *pt = dyn_cast<PointerType>(V->getType());
+    if (!pt) return false;
+    Type *elem = type_heap_abs_impl::elementType(pt->getElementType());
+    if (!elem->isIntegerTy()) return false;
+    unsigned bitwidth = elem->getIntegerBitWidth();
+
+    const Value *base = V;
+    while (const GEPOperator *gep = dyn_cast<GEPOperator>(base)) {
+      uint64_t offset = 0;
+      if (StructType *st = type_heap_abs_impl::lastStructField(gep, m_dl, offset)) {
+	key = std::make_tuple(st, offset, bitwidth);
+	if (m_collapsed_structs.count(st) || m_collapsed_fields.count(key)) {
+	  break;
+	}
+	return true;
+      }
+      // pointer arithmetic inside a field keeps the field
+      base = gep->getPointerOperand();
+    }
+    key = std::make_tuple(nullptr, 0, bitwidth);
+    return true;
+  }
+
+  void TypeHeapAbstraction::collapse(Module &M) {
+    std::vector<StructType*> worklist;
+    auto collapseType = [&worklist](Type *t) {
+      if (StructType *st = type_heap_abs_impl::pointedStruct(t)) {
+	worklist.push_back(st);
+      }
+    };
+    auto visitOperator = [&](const Value *V) {
+      if (const Operator *op = dyn_cast<Operator>(V)) {
+	if (op->getOpcode() == Instruction::BitCast ||
+	    op->getOpcode() == Instruction::AddrSpaceCast ||
+	    op->getOpcode() == Instruction::PtrToInt ||
+	    op->getOpcode() == Instruction::IntToPtr) {
+	  collapseType(op->getOperand(0)->getType());
+	  collapseType(op->getType());
+	} else if (const GEPOperator *gep = dyn_cast<GEPOperator>(op)) {
+	  uint64_t offset = 0;
+	  if (StructType *st = type_heap_abs_impl::lastStructField(gep, m_dl, offset)) {
+	    PointerType *pt = cast<PointerType>(gep->getType());
+	    Type *elem = type_heap_abs_impl::elementType(pt->getElementType());
+	    if (elem->isIntegerTy() && type_heap_abs_impl::addressEscapes(gep)) {
+	      m_collapsed_fields.insert(std::make_tuple(st, offset, elem->getIntegerBitWidth()));
+	    }
+	  }
+	}
+      }
+    };
+
+    for (Function &F: M) {
+      for (auto &I: instructions(&F)) {
+	visitOperator(&I);
+	for (const Use &U: I.operands()) {
+	  if (isa<ConstantExpr>(U.get())) {
+	    visitOperator(U.get());
+	  }
+	}
+      }
+    }
+
+    // -- the structs nested in a collapsed struct are collapsed too
+    while (!worklist.empty()) {
+      StructType *st = worklist.back();
+      worklist.pop_back();
+      if (!m_collapsed_structs.insert(st).second) continue;
+      for (Type *t: st->elements()) {
+	if (StructType *inner = dyn_cast<StructType>(type_heap_abs_impl::elementType(t))) {
+	  worklist.push_back(inner);
+	}
+      }
+    }
+  }
+
+  void TypeHeapAbstraction::cacheReadModRegions(Module &M) {
+    // -- regions directly accessed by each function and its callees
+    DenseMap<const Function*, std::vector<const Function*>> callees;
+    std::vector<const Function*> address_taken;
+    for (Function &F: M) {
+      if (!F.isDeclaration() && F.hasAddressTaken()) {
+	address_taken.push_back(&F);
+      }
+    }
+
+    auto addRegion = [this](const Function &F, Value *V, region_set_t &s) {
+      region_t r = getRegion(F, V);
+      if (!r.isUnknown()) s.insert(r);
+    };
+
+    for (Function &F: M) {
+      if (F.isDeclaration()) continue;
+      region_set_t &reads = m_func_accessed[&F];
+      region_set_t &mods = m_func_mods[&F];
+      for (auto &I: instructions(&F)) {
+	if (LoadInst *LI = dyn_cast<LoadInst>(&I)) {
+	  addRegion(F, LI->getPointerOperand(), reads);
+	} else if (StoreInst *SI = dyn_cast<StoreInst>(&I)) {
+	  addRegion(F, SI->getPointerOperand(), reads);
+	  addRegion(F, SI->getPointerOperand(), mods);
+	} else if (MemTransferInst *MTI = dyn_cast<MemTransferInst>(&I)) {
+	  addRegion(F, MTI->getSource(), reads);
+	  addRegion(F, MTI->getDest(), reads);
+	  addRegion(F, MTI->getDest(), mods);
+	} else if (MemSetInst *MSI = dyn_cast<MemSetInst>(&I)) {
+	  addRegion(F, MSI->getDest(), reads);
+	  addRegion(F, MSI->getDest(), mods);
+	} else if (CallInst *CI = dyn_cast<CallInst>(&I)) {
+	  if (CI->isInlineAsm()) continue;
+	  CallSite CS(CI);
+	  if (const Function *callee = CS.getCalledFunction()) {
+	    if (!callee->isDeclaration()) callees[&F].push_back(callee);
+	  } else {
+	    callees[&F].insert(callees[&F].end(),
+			       address_taken.begin(), address_taken.end());
+	  }
+	}
+      }
+    }
+
+    // -- propagate the regions of the callees until fixpoint
+    bool change = true;
+    while (change) {
+      change = false;
+      for (auto &kv: callees) {
+	const Function *F = kv.first;
+	for (const Function *callee: kv.second) {
+	  if (callee == F) continue;
+	  change |= type_heap_abs_impl::set_union(m_func_accessed[F], m_func_accessed[callee]);
+	  change |= type_heap_abs_impl::set_union(m_func_mods[F], m_func_mods[callee]);
+	}
+      }
+    }
+
+    for (auto &kv: m_func_accessed) {
+      region_set_t onlyreads(kv.second);
+      type_heap_abs_impl::set_difference(onlyreads, m_func_mods[kv.first]);
+      m_func_onlyreads[kv.first] = onlyreads;
+    }
+
+    // -- regions of the callsites
+    for (Function &F: M) {
+      for (auto &I: instructions(&F)) {
+	CallInst *CI = dyn_cast<CallInst>(&I);
+	if (!CI || CI->isInlineAsm()) continue;
+	CallSite CS(CI);
+	region_set_t reads, mods;
+	auto addCallee = [&](const Function *callee) {
+	  type_heap_abs_impl::set_union(reads, getAccessedRegions(*callee));
+	  type_heap_abs_impl::set_union(mods, getModifiedRegions(*callee));
+	};
+	if (const Function *callee = CS.getCalledFunction()) {
+	  if (callee->isDeclaration()) continue;
+	  addCallee(callee);
+	} else {
+	  for (const Function *callee: address_taken) addCallee(callee);
+	}
+	// -- add the region of the lhs of the call site
+	addRegion(F, CI, mods);
+
+	region_set_t onlyreads(reads);
+	type_heap_abs_impl::set_difference(onlyreads, mods);
+	m_callsite_accessed[CI] = reads;
+	m_callsite_mods[CI] = mods;
+	m_callsite_onlyreads[CI] = onlyreads;
+      }
+    }
+  }
+
+  TypeHeapAbstraction::TypeHeapAbstraction(Module &M, const DataLayout &dl)
+    : m_dl(dl) {
+    CRAB_LOG("heap-abs",
+	     llvm::errs() << "========= HeapAbstraction using types =========\n");
+    collapse(M);
+    CRAB_LOG("heap-abs",
+	     llvm::errs() << "Collapsed " << m_collapsed_structs.size() << " structs and "
+	                  << m_collapsed_fields.size() << " fields\n";);
+    cacheReadModRegions(M);
+  }
+
+  TypeHeapAbstraction::region_t
+  TypeHeapAbstraction::getRegion(const Function &, Value *V) {
+    cell_key_t key;
+    if (!V || !computeKey(V, key)) {
+      return region_t();
+    }
+    unsigned bitwidth = std::get<2>(key);
+    region_info r_info(bitwidth == 1 ? BOOL_REGION : INT_REGION, bitwidth);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_ids.find(key);
+    int id;
+    if (it != m_ids.end()) {
+      id = it->second;
+    } else {
+      id = m_ids.size();
+      m_ids[key] = id;
+    }
+    return region_t(static_cast<HeapAbstraction*>(this), id, r_info);
+  }
+
+  // Regions are not tied to objects so none is a singleton.
+  const Value* TypeHeapAbstraction::getSingleton(int) const {
+    return nullptr;
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getAccessedRegions(const Function &F) {
+    return type_heap_abs_impl::lookup(m_func_accessed, &F, m_empty_set);
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getOnlyReadRegions(const Function &F) {
+    return type_heap_abs_impl::lookup(m_func_onlyreads, &F, m_empty_set);
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getModifiedRegions(const Function &F) {
+    return type_heap_abs_impl::lookup(m_func_mods, &F, m_empty_set);
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getNewRegions(const Function &) {
+    return m_empty_set;
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getAccessedRegions(CallInst &I) {
+    return type_heap_abs_impl::lookup(m_callsite_accessed, &I, m_empty_set);
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getOnlyReadRegions(CallInst &I) {
+    return type_heap_abs_impl::lookup(m_callsite_onlyreads, &I, m_empty_set);
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getModifiedRegions(CallInst &I) {
+    return type_heap_abs_impl::lookup(m_callsite_mods, &I, m_empty_set);
+  }
+
+  const TypeHeapAbstraction::region_set_t&
+  TypeHeapAbstraction::getNewRegions(CallInst &) {
+    return m_empty_set;
+  }
+
+} // end namespace crab_llvm
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <crab_llvm/crab_cfg.hh>
+#include <crab/analysis/fwd_analyzer.hpp>
+#include <crab/analysis/bwd_analyzer.hpp>
+#include <crab/analysis/inter_fwd_analyzer.hpp>
+#include <crab/analysis/dataflow/liveness.hpp>
+#include <crab/checkers/base_property.hpp>
+#include <crab/cg/cg.hpp>
+#include <boost/unordered_map.hpp>
+#include <memory>
+
+namespace crab_llvm {
+
+  /**
+   ** Thin wrappers around the crab analyzers and checkers. Only the
+   ** class definitions are visible here: the member functions are
+   ** defined in analyzers_impl.hpp and explicitly instantiated in
+   ** one translation unit per abstract domain (or per pair of
+   ** domains for the inter-procedural analysis) generated by
+   ** CMake. Thus, the crab fixpoint iterators are not instantiated
+   ** by CrabLlvm.cc and the domains are compiled in parallel.
+   **/
+
+  typedef crab::analyzer::liveness<cfg_ref_t> liveness_t;
+  typedef crab::cg::call_graph<cfg_ref_t> call_graph_t; 
+  typedef crab::cg::call_graph_ref<call_graph_t> call_graph_ref_t;
+  typedef boost::unordered_map<cfg_ref_t, const liveness_t*> liveness_map_t;
+
+  namespace fixpoint_impl {
+    template<typename Dom> class engine;
+  }
+  
+  template<typename Dom>
+  class intra_analyzer {
+    typedef crab::analyzer::intra_forward_backward_analyzer<cfg_ref_t,Dom> analyzer_t;
+    cfg_ref_t m_cfg;
+    std::unique_ptr<analyzer_t> m_analyzer;
+    // set by run_parallel or run_sparse until some query needs
+    // m_analyzer
+    std::unique_ptr<fixpoint_impl::engine<Dom>> m_engine;
+
+    // Run m_analyzer with the options of run_parallel or run_sparse if
+    // the results of m_engine are not enough to answer a query.
+    void run_sequential();
+
+    // Check the assertions by propagating the invariants only through
+    // the blocks with assertions. Return false if some assertion is
+    // not over integers.
+    bool check_asserting_blocks(crab::checker::checks_db &checks);
+    
+  public:
+    typedef typename analyzer_t::assumption_map_t assumption_map_t;
+    
+    intra_analyzer(cfg_ref_t cfg);
+    
+    ~intra_analyzer();
+    
+    void run(basic_block_label_t entry, Dom init, Dom post_cond, bool only_forward,
+	     const assumption_map_t &assumptions, liveness_t *live,
+	     unsigned widening_delay, unsigned narrowing_iters, unsigned jumpset);
+
+    // Experimental: the same as run with only_forward, without
+    // assumptions, liveness and widening thresholds, but the
+    // components of the CFG that do not depend on each other are
+    // analyzed by num_threads threads. The blocks are iterated in
+    // order if it is valid for the CFG. If adaptive, the widening
+    // delay (up to max_delay) and the narrowing iterations are
+    // decided per loop head. If accelerate, the first widening of
+    // the simple counting loops is refined with the bounds of their
+    // induction variables implied by the guards.
+    void run_parallel(basic_block_label_t entry, Dom init,
+		      unsigned widening_delay, unsigned narrowing_iters,
+		      unsigned num_threads, const cfg_loop_order *order = nullptr,
+		      bool adaptive = false, unsigned max_delay = 0,
+		      bool accelerate = false);
+
+    // Experimental: the same as run with only_forward, without
+    // assumptions, liveness and widening thresholds, for
+    // non-relational domains. The values of the variables are
+    // propagated along the def-use chains of the statements instead
+    // of computing the state of each block, without narrowing. The
+    // blocks are iterated in order if it is valid for the CFG.
+    void run_sparse(basic_block_label_t entry, Dom init,
+		    unsigned widening_delay, unsigned narrowing_iters,
+		    const cfg_loop_order *order = nullptr);
+
+    Dom get_pre(basic_block_label_t bl);
+
+    Dom get_post(basic_block_label_t bl);
+
+    // only if run with only_forward disabled
+    Dom get_preconditions(basic_block_label_t bl);
+    
+    // Check the assertions (or nullity if nullity is true) with the
+    // forward invariants. If only_asserting_blocks then the blocks
+    // without assertions are not visited again, unless nullity or
+    // verbose are set.
+    crab::checker::checks_db check(bool nullity, unsigned verbose,
+				   bool only_asserting_blocks = false);
+  };
+
+  template<typename BUDom, typename TDDom>
+  class inter_analyzer {
+    typedef crab::analyzer::inter_fwd_analyzer<call_graph_ref_t, BUDom, TDDom> analyzer_t;
+    call_graph_ref_t m_cg;
+    std::unique_ptr<analyzer_t> m_analyzer;
+
+    // Check the assertions of the call graph with num_threads
+    // threads. Return false if some assertion is not over integers.
+    bool check_parallel(unsigned num_threads, crab::checker::checks_db &checks);
+    
+  public:
+    inter_analyzer(call_graph_ref_t cg, liveness_map_t *live,
+		   unsigned widening_delay, unsigned narrowing_iters, unsigned jumpset);
+    
+    ~inter_analyzer();
+
+    void run(TDDom init);
+    
+    TDDom get_pre(cfg_ref_t cfg, basic_block_label_t bl);
+    
+    TDDom get_post(cfg_ref_t cfg, basic_block_label_t bl);
+    
+    bool has_summary(cfg_ref_t cfg);
+
+    // If compact then only the constraints over the inputs and
+    // outputs that are not redundant are written, with at most
+    // max_relational relational constraints (0: no limit).
+    void write_summary(cfg_ref_t cfg, crab::crab_os &o,
+		       bool compact = false, unsigned max_relational = 0);
+    
+    // Check the assertions (or nullity if nullity is true) with the
+    // forward invariants. The blocks are checked by num_threads
+    // threads, unless nullity or verbose are set.
+    crab::checker::checks_db check(bool nullity, unsigned verbose,
+				   unsigned num_threads = 1);
+  };
+  
+} // end namespace crab_llvm
@@ -0,0 +1,1359 @@
+#pragma once
+
+/**
+ * Definitions of the members of analyzers.hpp. It should be only
+ * included by the translation units that instantiate them.
+ **/
+
+#include "analyzers.hpp"
+#include <crab/checkers/assertion.hpp>
+#include <crab/checkers/null.hpp>
+#include <crab/checkers/checker.hpp>
+#include <crab_llvm/Support/Parallel.hh>
+#include <crab_llvm/Support/Arena.hh>
+#include <crab_llvm/Support/Stats.hh>
+#include <boost/range/iterator_range.hpp>
+#include <boost/unordered_set.hpp>
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace crab_llvm {
+
+  namespace checker_impl {
+    typedef cfg_ref_t::basic_block_t basic_block_t;
+    typedef basic_block_t::assert_t assert_t;
+
+    // Add the outcome of a given the invariant inv that holds before
+    // it. The outcomes are the same as crab's assert_property_checker.
+    template<typename Dom>
+    void check_assertion(Dom &inv, const assert_t &a, crab::checker::checks_db &checks) {
+      const auto &cst = a.constraint();
+      if (inv.is_bottom()) {
+	checks.add(crab::checker::_SAFE, a.get_debug_info());
+      } else if (cst.is_contradiction()) {
+	checks.add(crab::checker::_WARN, a.get_debug_info());
+      } else {
+	Dom cst_inv = Dom::top();
+	cst_inv += cst;
+	if (inv <= cst_inv) {
+	  checks.add(crab::checker::_SAFE, a.get_debug_info());
+	} else {
+	  Dom tmp(inv);
+	  tmp += cst;
+	  checks.add(tmp.is_bottom() ? crab::checker::_ERR : crab::checker::_WARN,
+		     a.get_debug_info());
+	}
+      }
+    }
+
+    // Return false if b has pointer or boolean assertions. Otherwise,
+    // has_asserts is set if b has assertions and call_before_assert
+    // if some of them follows a callsite.
+    inline bool scan_block(const basic_block_t &b, bool &has_asserts,
+			   bool &call_before_assert) {
+      has_asserts = false;
+      call_before_assert = false;
+      bool has_calls = false;
+      for (auto &s: b) {
+	if (s.is_ptr_assert() || s.is_bool_assert()) return false;
+	if (s.is_assert()) {
+	  has_asserts = true;
+	  call_before_assert |= has_calls;
+	}
+	has_calls |= s.is_callsite();
+      }
+      return true;
+    }
+
+    // Check the assertions of b by propagating inv (the invariant at
+    // the entry of b) with the transformer vis.
+    template<typename Dom, typename AbsTr>
+    void check_block(Dom &inv, AbsTr &vis, const basic_block_t &b,
+		     crab::checker::checks_db &checks) {
+      for (auto &s: b) {
+	if (s.is_assert()) {
+	  check_assertion(inv, static_cast<const assert_t&>(s), checks);
+	}
+	s.accept(&vis);
+      }
+    }
+  } // end namespace checker_impl
+
+  namespace summary_impl {
+    // Project sum onto vars, remove the constraints entailed by the
+    // other ones and keep at most max_relational constraints with more
+    // than one variable (0: no limit). The result is weaker or equal
+    // than sum so it is still a sound summary.
+    template<typename Dom>
+    lin_cst_sys_t compact(Dom sum, const std::vector<var_t> &vars,
+			  unsigned max_relational) {
+      sum.project(vars);
+      lin_cst_sys_t csts = sum.to_linear_constraint_system();
+      std::vector<lin_cst_t> kept(csts.begin(), csts.end());
+      for (unsigned i = 0; i < kept.size(); ) {
+	Dom others = Dom::top();
+	for (unsigned j = 0; j < kept.size(); ++j) {
+	  if (j != i) others += kept[j];
+	}
+	Dom c = Dom::top();
+	c += kept[i];
+	if (others <= c) {
+	  kept.erase(kept.begin() + i);
+	} else {
+	  ++i;
+	}
+      }
+      lin_cst_sys_t res;
+      unsigned num_relational = 0;
+      for (auto &c: kept) {
+	if (c.size() > 1) {
+	  if (max_relational > 0 && num_relational == max_relational) continue;
+	  num_relational++;
+	}
+	res += c;
+      }
+      return res;
+    }
+  } // end namespace summary_impl
+
+  namespace fixpoint_impl {
+    /*
+     * Base of the fixpoint engines that replace the crab forward
+     * iterator in intra_analyzer. The blocks reachable from the entry
+     * are numbered in the iteration order computed by CfgBuilder from
+     * the loops of LLVM, if any, or in reverse postorder otherwise
+     * (the entry is 0). The loop heads are the targets of the edges
+     * that go backwards.
+     */
+    template<typename Dom>
+    class engine {
+    protected:
+      typedef crab::analyzer::intra_abs_transformer<Dom> abs_tr_t;
+
+      cfg_ref_t m_cfg;
+      basic_block_label_t m_entry;
+      Dom m_init;
+      unsigned m_widening_delay;
+      unsigned m_narrowing_iters;
+      const cfg_loop_order *m_order;
+      std::vector<basic_block_label_t> m_blocks;
+      boost::unordered_map<basic_block_label_t, unsigned> m_ids;
+      std::vector<std::vector<unsigned>> m_preds;
+      std::vector<char> m_is_head;
+
+      // Number the blocks with order if it starts with the entry, it
+      // contains the successors of its blocks and only the edges to
+      // its heads go backwards.
+      bool number_blocks(const cfg_loop_order &order) {
+	if (order.blocks.empty() || !(order.blocks[0] == m_entry)) return false;
+	boost::unordered_set<basic_block_label_t> heads(order.heads.begin(), order.heads.end());
+	boost::unordered_map<basic_block_label_t, unsigned> ids;
+	for (unsigned i = 0; i < order.blocks.size(); ++i) {
+	  ids[order.blocks[i]] = i;
+	}
+	std::vector<std::vector<unsigned>> preds(order.blocks.size());
+	for (unsigned i = 0; i < order.blocks.size(); ++i) {
+	  for (auto s: m_cfg.next_nodes(order.blocks[i])) {
+	    auto it = ids.find(s);
+	    if (it == ids.end() || (it->second <= i && !heads.count(s))) return false;
+	    preds[it->second].push_back(i);
+	  }
+	}
+	// -- a block without a predecessor before it is not reachable
+	for (unsigned i = 1; i < order.blocks.size(); ++i) {
+	  if (std::none_of(preds[i].begin(), preds[i].end(),
+			   [i](unsigned p) { return p < i; })) {
+	    return false;
+	  }
+	}
+	m_blocks = order.blocks;
+	m_ids = std::move(ids);
+	m_preds = std::move(preds);
+	m_is_head.resize(m_blocks.size(), false);
+	for (unsigned i = 0; i < m_blocks.size(); ++i) {
+	  m_is_head[i] = heads.count(m_blocks[i]) > 0;
+	}
+	return true;
+      }
+
+      void number_blocks() {
+	if (m_order && number_blocks(*m_order)) return;
+	// -- iterative DFS: the target of an edge to a block in the
+	//    stack is a loop head
+	enum { NEW = 0, ACTIVE, DONE };
+	boost::unordered_map<basic_block_label_t, char> state;
+	std::vector<basic_block_label_t> postorder;
+	std::vector<std::pair<basic_block_label_t, std::vector<basic_block_label_t>>> stack;
+	boost::unordered_set<basic_block_label_t> heads;
+	auto push = [&](const basic_block_label_t &bl) {
+	  state[bl] = ACTIVE;
+	  std::vector<basic_block_label_t> succs;
+	  for (auto s: m_cfg.next_nodes(bl)) succs.push_back(s);
+	  stack.push_back(std::make_pair(bl, std::move(succs)));
+	};
+	push(m_entry);
+	while (!stack.empty()) {
+	  std::vector<basic_block_label_t> &succs = stack.back().second;
+	  if (succs.empty()) {
+	    state[stack.back().first] = DONE;
+	    postorder.push_back(stack.back().first);
+	    stack.pop_back();
+	    continue;
+	  }
+	  basic_block_label_t s = succs.back();
+	  succs.pop_back();
+	  char st = state[s];
+	  if (st == NEW) {
+	    push(s);
+	  } else if (st == ACTIVE) {
+	    heads.insert(s);
+	  }
+	}
+	m_blocks.assign(postorder.rbegin(), postorder.rend());
+	for (unsigned i = 0; i < m_blocks.size(); ++i) {
+	  m_ids[m_blocks[i]] = i;
+	}
+	m_preds.resize(m_blocks.size());
+	m_is_head.resize(m_blocks.size(), false);
+	for (unsigned i = 0; i < m_blocks.size(); ++i) {
+	  m_is_head[i] = heads.count(m_blocks[i]) > 0;
+	  for (auto p: m_cfg.prev_nodes(m_blocks[i])) {
+	    auto it = m_ids.find(p);
+	    if (it != m_ids.end()) m_preds[i].push_back(it->second);
+	  }
+	}
+      }
+
+      // Strongly connected components in topological order, each one
+      // with its blocks in reverse postorder (Kosaraju: the reversed
+      // CFG is visited in reverse postorder).
+      std::vector<std::vector<unsigned>> components(std::vector<unsigned> &comp_of) const {
+	std::vector<std::vector<unsigned>> comps;
+	comp_of.assign(m_blocks.size(), UINT_MAX);
+	std::vector<unsigned> stack;
+	for (unsigned i = 0; i < m_blocks.size(); ++i) {
+	  if (comp_of[i] != UINT_MAX) continue;
+	  unsigned c = comps.size();
+	  comps.push_back(std::vector<unsigned>());
+	  comp_of[i] = c;
+	  stack.push_back(i);
+	  while (!stack.empty()) {
+	    unsigned b = stack.back();
+	    stack.pop_back();
+	    comps[c].push_back(b);
+	    for (unsigned p: m_preds[b]) {
+	      if (comp_of[p] == UINT_MAX) {
+		comp_of[p] = c;
+		stack.push_back(p);
+	      }
+	    }
+	  }
+	  std::sort(comps[c].begin(), comps[c].end());
+	}
+	return comps;
+      }
+
+    public:
+
+      engine(cfg_ref_t cfg, basic_block_label_t entry, Dom init,
+	     unsigned widening_delay, unsigned narrowing_iters,
+	     const cfg_loop_order *order)
+	: m_cfg(cfg), m_entry(entry), m_init(init),
+	  m_widening_delay(widening_delay), m_narrowing_iters(narrowing_iters),
+	  m_order(order) {}
+
+      virtual ~engine() {}
+
+      basic_block_label_t entry() const { return m_entry; }
+      const Dom& init() const { return m_init; }
+      unsigned widening_delay() const { return m_widening_delay; }
+      unsigned narrowing_iters() const { return m_narrowing_iters; }
+
+      // bottom if bl is not reachable from the entry
+      virtual Dom get_pre(basic_block_label_t bl) const = 0;
+      virtual Dom get_post(basic_block_label_t bl) const = 0;
+    };
+
+    /*
+     * Forward fixpoint over the strongly connected components of the
+     * CFG. A component only depends on the components that contain a
+     * predecessor of its blocks, so the components at the same depth
+     * of the condensation (e.g., the loop nests in the two branches of
+     * a diamond) are analyzed in parallel from the invariants of their
+     * predecessors and joined at the merge points. The blocks of a
+     * component are iterated in reverse postorder with widening at the
+     * loop heads, followed by the narrowing iterations.
+     *
+     * If adaptive, the delay and the narrowing are decided per loop
+     * head: a head is joined instead of widened beyond widening_delay
+     * (up to max_delay iterations) while the join is still strictly
+     * more precise than the widening, and the descending iterations
+     * only recompute the blocks whose predecessors changed, each head
+     * with its own budget of narrowing_iters, so the loops that are
+     * already stable stop narrowing.
+     *
+     * If accelerate, the loops that are a component with a single
+     * head and only count (an induction variable incremented by a
+     * constant stride once per iteration and compared with loop
+     * invariant values by the assumes of the branches) are widened
+     * once with the bounds implied by their guards, so the first
+     * widening is usually already the fixpoint of the loop and the
+     * descending iterations have nothing left to recover. The
+     * following widenings of the head are the usual ones.
+     */
+    template<typename Dom>
+    class parallel_fixpoint: public engine<Dom> {
+      typedef engine<Dom> base_t;
+      typedef typename base_t::abs_tr_t abs_tr_t;
+      typedef cfg_ref_t::statement_t stmt_t;
+      typedef cfg_ref_t::basic_block_t::bin_op_t bin_op_t;
+      typedef cfg_ref_t::basic_block_t::assign_t assign_t;
+      typedef cfg_ref_t::basic_block_t::assume_t assume_t;
+      using base_t::m_cfg;
+      using base_t::m_init;
+      using base_t::m_blocks;
+      using base_t::m_ids;
+      using base_t::m_preds;
+      using base_t::m_is_head;
+
+      bool m_adaptive;
+      unsigned m_max_delay;
+      bool m_accelerate;
+      std::vector<Dom> m_pre;
+      std::vector<Dom> m_post;
+      // bounds of the induction variables at the head of each
+      // counting loop when it is reached from its latches
+      boost::unordered_map<unsigned, lin_cst_sys_t> m_bounds;
+
+      Dom join_preds(unsigned b) const {
+	Dom inv = (b == 0 ? m_init : Dom::bottom());
+	for (unsigned p: m_preds[b]) {
+	  inv |= m_post[p];
+	}
+	return inv;
+      }
+
+      // Whether pre is equal to the pre of b in a descending
+      // iteration. The narrowing at a head is already included in its
+      // pre so only one inclusion is needed.
+      bool same(unsigned b, Dom &pre) {
+	if (m_is_head[b]) return m_pre[b] <= pre;
+	return pre <= m_pre[b] && m_pre[b] <= pre;
+      }
+
+      void transform(unsigned b) {
+	Dom inv(m_pre[b]);
+	abs_tr_t vis(&inv);
+	for (auto &s: m_cfg.get_node(m_blocks[b])) {
+	  s.accept(&vis);
+	}
+	m_post[b] = inv;
+      }
+
+      // block (in the component) and position of a statement
+      typedef std::pair<unsigned, unsigned> point_t;
+
+      // x := y + k
+      struct step {
+	var_t lhs;
+	var_t src;
+	number_t k;
+	point_t at;
+	step(var_t x, var_t y, number_t n, unsigned b, unsigned i)
+	  : lhs(x), src(y), k(n), at(b, i) {}
+      };
+
+      static bool get_step(const stmt_t &s, unsigned b, unsigned i,
+			   std::vector<step> &steps) {
+	if (s.is_assign()) {
+	  auto &a = static_cast<const assign_t&>(s);
+	  const lin_exp_t &e = a.rhs();
+	  if (e.size() != 1) return false;
+	  auto kv = *e.begin();
+	  if (kv.first != number_t(1)) return false;
+	  steps.push_back(step(a.lhs(), kv.second, e.constant(), b, i));
+	  return true;
+	}
+	if (s.is_bin_op()) {
+	  auto &o = static_cast<const bin_op_t&>(s);
+	  const lin_exp_t &l = o.left();
+	  const lin_exp_t &r = o.right();
+	  if (o.op() == crab::BINOP_ADD) {
+	    if (l.get_variable() && r.is_constant()) {
+	      steps.push_back(step(o.lhs(), *l.get_variable(), r.constant(), b, i));
+	      return true;
+	    }
+	    if (r.get_variable() && l.is_constant()) {
+	      steps.push_back(step(o.lhs(), *r.get_variable(), l.constant(), b, i));
+	      return true;
+	    }
+	  } else if (o.op() == crab::BINOP_SUB && l.get_variable() && r.is_constant()) {
+	    steps.push_back(step(o.lhs(), *l.get_variable(), -r.constant(), b, i));
+	    return true;
+	  }
+	}
+	return false;
+      }
+
+      // Compute the bounds of the counting loop comp (comp[0] is its
+      // only head), if it is one. The blocks that dominate all the
+      // latches are executed once per iteration so their induction
+      // steps and guards are the ones of the loop.
+      void classify(const std::vector<unsigned> &comp) {
+	unsigned n = comp.size();
+	boost::unordered_map<unsigned, unsigned> pos;
+	for (unsigned i = 0; i < n; ++i) pos[comp[i]] = i;
+	// -- dominators within the component
+	std::vector<std::vector<char>> dom(n, std::vector<char>(n, 1));
+	dom[0].assign(n, 0);
+	dom[0][0] = 1;
+	bool changed = true;
+	while (changed) {
+	  changed = false;
+	  for (unsigned i = 1; i < n; ++i) {
+	    std::vector<char> d(n, 1);
+	    for (unsigned p: m_preds[comp[i]]) {
+	      auto it = pos.find(p);
+	      if (it == pos.end()) continue;
+	      for (unsigned j = 0; j < n; ++j) d[j] &= dom[it->second][j];
+	    }
+	    d[i] = 1;
+	    if (d != dom[i]) {
+	      dom[i] = d;
+	      changed = true;
+	    }
+	  }
+	}
+	// -- blocks that dominate all the latches
+	std::vector<char> always(n, 1);
+	for (unsigned p: m_preds[comp[0]]) {
+	  auto it = pos.find(p);
+	  if (it == pos.end()) continue;
+	  for (unsigned j = 0; j < n; ++j) always[j] &= dom[it->second][j];
+	}
+	// -- definitions in the loop and candidate steps and guards
+	std::map<var_t, unsigned> num_defs;
+	std::map<var_t, step> steps;
+	std::vector<std::pair<const assume_t*, point_t>> guards;
+	for (unsigned i = 0; i < n; ++i) {
+	  unsigned k = 0;
+	  for (auto &s: m_cfg.get_node(m_blocks[comp[i]])) {
+	    const typename stmt_t::live_t &ls = s.get_live();
+	    for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	      num_defs[v]++;
+	    }
+	    std::vector<step> st;
+	    if (always[i] && get_step(s, i, k, st)) {
+	      steps.insert(std::make_pair(st[0].lhs, st[0]));
+	    } else if (always[i] && s.is_assume()) {
+	      guards.push_back(std::make_pair(static_cast<const assume_t*>(&s), point_t(i, k)));
+	    }
+	    ++k;
+	  }
+	}
+	auto executes_before = [&](const point_t &a, const point_t &b) {
+	  return (a.first == b.first ? a.second < b.second : dom[b.first][a.first] != 0);
+	};
+	lin_cst_sys_t bounds;
+	std::set<var_t> done;
+	for (auto &kv: steps) {
+	  if (done.count(kv.first) || num_defs[kv.first] != 1) continue;
+	  // -- follow the sources up to a cycle of single steps
+	  std::vector<step> chain;
+	  std::set<var_t> seen;
+	  var_t x = kv.first;
+	  bool cycle = false;
+	  for (;;) {
+	    auto it = steps.find(x);
+	    if (it == steps.end() || num_defs[x] != 1 || !seen.insert(x).second) {
+	      cycle = (it != steps.end() && x == kv.first);
+	      break;
+	    }
+	    chain.push_back(it->second);
+	    x = it->second.src;
+	  }
+	  if (!cycle) continue;
+	  for (auto &c: chain) done.insert(c.lhs);
+	  // -- chain[j] defines chain[j].lhs from chain[j+1].lhs. The
+	  //    stride is the sum of the constants. If the steps are
+	  //    executed backwards along the chain from some of them, the
+	  //    value of each variable at the head is the one of the last
+	  //    variable defined plus a constant offset.
+	  number_t stride(0);
+	  for (auto &c: chain) stride += c.k;
+	  if (stride == number_t(0)) continue;
+	  unsigned m = chain.size();
+	  unsigned first = 0;
+	  for (unsigned j = 1; j < m; ++j) {
+	    if (executes_before(chain[j].at, chain[first].at)) first = j;
+	  }
+	  bool ordered = true;
+	  for (unsigned j = 0; j + 1 < m; ++j) {
+	    const step &a = chain[(first + m - j) % m];
+	    const step &b = chain[(first + m - j - 1) % m];
+	    if (!executes_before(a.at, b.at)) ordered = false;
+	  }
+	  if (!ordered) continue;
+	  // -- offset of each variable with respect to the last one
+	  //    defined in an iteration
+	  std::map<var_t, number_t> offset;
+	  number_t o(0);
+	  for (unsigned j = 0; j < m; ++j) {
+	    const step &c = chain[(first + 1 + j) % m];
+	    offset[c.lhs] = o;
+	    o -= c.k;
+	  }
+	  for (auto &g: guards) {
+	    const lin_cst_t &cst = g.first->constraint();
+	    if (!cst.is_inequality()) continue;
+	    const lin_exp_t &e = cst.expression();
+	    const step *gs = nullptr;
+	    number_t a(0);
+	    bool invariant = true;
+	    for (auto t: e) {
+	      auto it = offset.find(t.second);
+	      if (it != offset.end() && !gs) {
+		for (auto &c: chain) if (c.lhs == t.second) gs = &c;
+		a = t.first;
+	      } else if (num_defs.count(t.second)) {
+		invariant = false;
+	      }
+	    }
+	    if (!gs || !invariant || (a > number_t(0)) != (stride > number_t(0))) continue;
+	    // -- the guard holds for the value of its variable at the
+	    //    head of the next iteration, minus the stride if it is
+	    //    defined after the guard
+	    number_t shift = (executes_before(gs->at, g.second) ? number_t(0) : stride);
+	    for (unsigned j = 0; j < m; ++j) {
+	      const var_t &z = chain[j].lhs;
+	      // -- g = z + offset(g) - offset(z) at the head
+	      number_t d = offset[gs->lhs] - offset[z] - shift;
+	      lin_exp_t b(e.constant() + a * d);
+	      for (auto t: e) {
+		b = b + (t.second == gs->lhs ? t.first * z : t.first * t.second);
+	      }
+	      bounds += lin_cst_t(b, lin_cst_t::INEQUALITY);
+	    }
+	  }
+	}
+	if (bounds.size() > 0) m_bounds[comp[0]] = bounds;
+      }
+
+      // Widen the pre of the head b with pre. The first widening of a
+      // counting loop is refined with its bounds.
+      Dom widen(unsigned b, const Dom &pre, boost::unordered_set<unsigned> &accelerated) {
+	Dom widened = m_pre[b] || pre;
+	auto it = m_bounds.find(b);
+	if (it == m_bounds.end() || !accelerated.insert(b).second) return widened;
+	count_stat("CrabLlvm.count.accelerated_loops");
+	widened += it->second;
+	return widened | (m_pre[b] | pre);
+      }
+
+      void analyze(const std::vector<unsigned> &comp) {
+	if (comp.size() == 1 && !m_is_head[comp[0]]) {
+	  m_pre[comp[0]] = join_preds(comp[0]);
+	  transform(comp[0]);
+	  return;
+	}
+	boost::unordered_map<unsigned, unsigned> iters;
+	boost::unordered_set<unsigned> visited;
+	boost::unordered_set<unsigned> accelerated;
+	// -- time of the last evaluation of each block of comp and of
+	//    the last change of its post. A block is not evaluated again
+	//    (joined and compared with its previous pre) until the post
+	//    of some predecessor changes. The predecessors in other
+	//    components do not change anymore.
+	boost::unordered_map<unsigned, unsigned> evaluated_at, changed_at;
+	unsigned clock = 0;
+	auto same_preds = [&](unsigned b) {
+	  unsigned last = evaluated_at[b];
+	  return std::none_of(m_preds[b].begin(), m_preds[b].end(), [&](unsigned p) {
+	      auto it = changed_at.find(p);
+	      return it != changed_at.end() && it->second > last;
+	    });
+	};
+	bool changed = true;
+	while (changed) {
+	  changed = false;
+	  for (unsigned b: comp) {
+	    if (visited.count(b) && same_preds(b)) continue;
+	    evaluated_at[b] = ++clock;
+	    Dom pre = join_preds(b);
+	    if (m_is_head[b] && visited.count(b)) {
+	      unsigned it = iters[b]++;
+	      if (it < this->m_widening_delay) {
+		pre = m_pre[b] | pre;
+	      } else if (m_adaptive && it < m_max_delay) {
+		// -- delay the widening of this loop while it loses
+		//    precision with respect to the join
+		Dom joined = m_pre[b] | pre;
+		Dom widened = widen(b, pre, accelerated);
+		if (widened <= joined) {
+		  pre = widened;
+		  iters[b] = m_max_delay;
+		} else {
+		  pre = joined;
+		}
+	      } else {
+		pre = widen(b, pre, accelerated);
+	      }
+	    }
+	    if (visited.count(b) && pre <= m_pre[b]) continue;
+	    visited.insert(b);
+	    m_pre[b] = pre;
+	    transform(b);
+	    changed_at[b] = ++clock;
+	    changed = true;
+	  }
+	}
+	if (m_adaptive) {
+	  narrow(comp);
+	  return;
+	}
+	for (unsigned i = 0; i < this->m_narrowing_iters; ++i) {
+	  changed = false;
+	  for (unsigned b: comp) {
+	    Dom pre = join_preds(b);
+	    if (m_is_head[b]) {
+	      pre = m_pre[b] && pre;
+	    }
+	    if (same(b, pre)) continue;
+	    m_pre[b] = pre;
+	    transform(b);
+	    changed = true;
+	  }
+	  if (!changed) break;
+	}
+      }
+
+      // Descending iterations of the adaptive policy. A block is only
+      // recomputed if the post of some predecessor changed since its
+      // last evaluation and a head stops narrowing after
+      // narrowing_iters changes.
+      void narrow(const std::vector<unsigned> &comp) {
+	// -- round of the last change of the post of each block (the
+	//    ascending iterations are round 0) and of the last
+	//    evaluation of each block of comp
+	boost::unordered_map<unsigned, unsigned> changed_at, evaluated_at, narrowed;
+	auto changed_since = [&](unsigned p, unsigned round) {
+	  auto it = changed_at.find(p);
+	  return (it == changed_at.end() ? round == 0 : it->second >= round);
+	};
+	bool changed = true;
+	for (unsigned round = 1; changed; ++round) {
+	  changed = false;
+	  for (unsigned b: comp) {
+	    unsigned last = evaluated_at[b];
+	    if (std::none_of(m_preds[b].begin(), m_preds[b].end(),
+			     [&](unsigned p) { return changed_since(p, last); })) {
+	      continue;
+	    }
+	    evaluated_at[b] = round;
+	    if (m_is_head[b] && narrowed[b] >= this->m_narrowing_iters) continue;
+	    Dom pre = join_preds(b);
+	    if (m_is_head[b]) {
+	      pre = m_pre[b] && pre;
+	    }
+	    if (same(b, pre)) continue;
+	    if (m_is_head[b]) narrowed[b]++;
+	    m_pre[b] = pre;
+	    transform(b);
+	    changed_at[b] = round;
+	    changed = true;
+	  }
+	}
+      }
+
+    public:
+
+      parallel_fixpoint(cfg_ref_t cfg, basic_block_label_t entry, Dom init,
+			unsigned widening_delay, unsigned narrowing_iters,
+			const cfg_loop_order *order,
+			bool adaptive = false, unsigned max_delay = 0,
+			bool accelerate = false)
+	: base_t(cfg, entry, init, widening_delay, narrowing_iters, order),
+	  m_adaptive(adaptive), m_max_delay(max_delay), m_accelerate(accelerate) {}
+
+      void run(unsigned num_threads) {
+	this->number_blocks();
+	m_pre.assign(m_blocks.size(), Dom::bottom());
+	m_post.assign(m_blocks.size(), Dom::bottom());
+	std::vector<unsigned> comp_of;
+	std::vector<std::vector<unsigned>> comps = this->components(comp_of);
+	// -- depth of each component in the condensation
+	std::vector<unsigned> depth(comps.size(), 0);
+	std::vector<std::vector<unsigned>> levels;
+	for (unsigned c = 0; c < comps.size(); ++c) {
+	  for (unsigned b: comps[c]) {
+	    for (unsigned p: m_preds[b]) {
+	      if (comp_of[p] != c) depth[c] = std::max(depth[c], depth[comp_of[p]] + 1);
+	    }
+	  }
+	  if (levels.size() <= depth[c]) levels.resize(depth[c] + 1);
+	  levels[depth[c]].push_back(c);
+	  if (m_accelerate && m_is_head[comps[c][0]] &&
+	      std::none_of(comps[c].begin() + 1, comps[c].end(),
+			   [this](unsigned b) { return m_is_head[b]; })) {
+	    classify(comps[c]);
+	  }
+	}
+	bool arena = in_arena_scope();
+	for (auto &level: levels) {
+	  parallel_for(level.size(), num_threads, [&](unsigned id, unsigned i) {
+	      arena_scope worker_arena(arena);
+	      analyze(comps[level[i]]);
+	    });
+	}
+      }
+
+      virtual Dom get_pre(basic_block_label_t bl) const override {
+	auto it = m_ids.find(bl);
+	return (it == m_ids.end() ? Dom::bottom() : m_pre[it->second]);
+      }
+
+      virtual Dom get_post(basic_block_label_t bl) const override {
+	auto it = m_ids.find(bl);
+	return (it == m_ids.end() ? Dom::bottom() : m_post[it->second]);
+      }
+    };
+
+    /*
+     * Sparse forward analysis for non-relational domains. Instead of
+     * an abstract state per block, there is one value per variable
+     * (the join of the values of its definitions) which is propagated
+     * along the def-use chains of the statements. A statement without
+     * definitions (assume, assert) refines the variables it uses at
+     * the points that it dominates until one of them is defined
+     * again, so the values at the branches are computed on demand
+     * from the dominating refinements. A variable whose definitions
+     * do not dominate some use is joined with its initial value.
+     * Blocks are only visited once all the statements of some
+     * predecessor produced a non-bottom state. The values are widened
+     * after widening_delay updates if some definition is in a cycle.
+     * There is no narrowing. The state at the entry of a block is
+     * built from the values of the variables available there.
+     */
+    template<typename Dom>
+    class sparse_fixpoint: public engine<Dom> {
+      typedef engine<Dom> base_t;
+      typedef typename base_t::abs_tr_t abs_tr_t;
+      typedef cfg_ref_t::statement_t stmt_t;
+      // block and position of a statement
+      typedef std::pair<unsigned, unsigned> point_t;
+      using base_t::m_cfg;
+      using base_t::m_init;
+      using base_t::m_blocks;
+      using base_t::m_ids;
+      using base_t::m_preds;
+      using base_t::m_is_head;
+
+      struct stmt_info {
+	const stmt_t *stmt;
+	std::vector<unsigned> uses;
+	std::vector<unsigned> defs;
+	// the statement produced a non-bottom state
+	bool reached;
+	stmt_info(const stmt_t *s): stmt(s), reached(false) {}
+      };
+
+      struct var_info {
+	std::vector<point_t> defs;
+	std::vector<point_t> uses;
+	// statements without definitions that use the variable
+	std::vector<point_t> refinements;
+	// blocks reached by a definition after each refinement (sorted)
+	std::vector<std::vector<unsigned>> killed;
+	// the definitions dominate all the uses: the variable is
+	// available in the blocks dominated by anchor (strictly if
+	// strict)
+	bool closed;
+	unsigned anchor;
+	bool strict;
+	bool widen;
+	unsigned updates;
+	Dom value;
+	std::set<point_t> users;
+	var_info(): closed(false), anchor(0), strict(true), widen(false),
+		    updates(0), value(Dom::bottom()) {}
+      };
+
+      std::vector<var_t> m_vars;
+      std::map<var_t, unsigned> m_var_ids;
+      std::vector<var_info> m_info;
+      std::vector<std::vector<stmt_info>> m_stmts;
+      std::vector<std::vector<unsigned>> m_succs;
+      // dominator tree
+      std::vector<unsigned> m_idom;
+      std::vector<unsigned> m_dom_pre;
+      std::vector<unsigned> m_dom_post;
+      // closed variables by anchor and the other ones with definitions
+      // or refinements
+      std::vector<std::vector<unsigned>> m_anchored;
+      std::vector<unsigned> m_others;
+      std::vector<char> m_exec;
+      std::vector<unsigned> m_num_bot;
+      std::set<point_t> m_worklist;
+
+      unsigned var_id(const var_t &v) {
+	auto res = m_var_ids.insert(std::make_pair(v, m_vars.size()));
+	if (res.second) {
+	  m_vars.push_back(v);
+	  m_info.push_back(var_info());
+	}
+	return res.first->second;
+      }
+
+      bool dominates(unsigned a, unsigned b) const {
+	return m_dom_pre[a] <= m_dom_pre[b] && m_dom_post[b] <= m_dom_post[a];
+      }
+
+      bool strictly_dominates(unsigned a, unsigned b) const {
+	return a != b && dominates(a, b);
+      }
+
+      unsigned intersect(unsigned a, unsigned b) const {
+	while (a != b) {
+	  while (a > b) a = m_idom[a];
+	  while (b > a) b = m_idom[b];
+	}
+	return a;
+      }
+
+      // Cooper, Harvey and Kennedy over the reverse postorder
+      void compute_dominators() {
+	unsigned n = m_blocks.size();
+	m_idom.assign(n, UINT_MAX);
+	m_idom[0] = 0;
+	bool changed = true;
+	while (changed) {
+	  changed = false;
+	  for (unsigned b = 1; b < n; ++b) {
+	    unsigned d = UINT_MAX;
+	    for (unsigned p: m_preds[b]) {
+	      if (m_idom[p] == UINT_MAX) continue;
+	      d = (d == UINT_MAX ? p : intersect(p, d));
+	    }
+	    if (d != m_idom[b]) {
+	      m_idom[b] = d;
+	      changed = true;
+	    }
+	  }
+	}
+	// -- preorder and postorder numbers of the dominator tree
+	std::vector<std::vector<unsigned>> children(n);
+	for (unsigned b = 1; b < n; ++b) children[m_idom[b]].push_back(b);
+	m_dom_pre.assign(n, 0);
+	m_dom_post.assign(n, 0);
+	unsigned counter = 0;
+	std::vector<std::pair<unsigned, unsigned>> stack;
+	m_dom_pre[0] = counter++;
+	stack.push_back(std::make_pair(0, 0));
+	while (!stack.empty()) {
+	  unsigned b = stack.back().first;
+	  unsigned next = stack.back().second;
+	  if (next < children[b].size()) {
+	    stack.back().second++;
+	    unsigned c = children[b][next];
+	    m_dom_pre[c] = counter++;
+	    stack.push_back(std::make_pair(c, 0));
+	  } else {
+	    m_dom_post[b] = counter++;
+	    stack.pop_back();
+	  }
+	}
+      }
+
+      void collect() {
+	unsigned n = m_blocks.size();
+	m_stmts.resize(n);
+	m_succs.resize(n);
+	for (unsigned b = 0; b < n; ++b) {
+	  for (unsigned p: m_preds[b]) m_succs[p].push_back(b);
+	  for (auto &s: m_cfg.get_node(m_blocks[b])) {
+	    point_t pt(b, m_stmts[b].size());
+	    stmt_info si(&s);
+	    const typename stmt_t::live_t &ls = s.get_live();
+	    for (auto v: boost::make_iterator_range(ls.uses_begin(), ls.uses_end())) {
+	      si.uses.push_back(var_id(v));
+	    }
+	    for (auto v: boost::make_iterator_range(ls.defs_begin(), ls.defs_end())) {
+	      si.defs.push_back(var_id(v));
+	    }
+	    std::sort(si.uses.begin(), si.uses.end());
+	    si.uses.erase(std::unique(si.uses.begin(), si.uses.end()), si.uses.end());
+	    for (unsigned x: si.uses) {
+	      m_info[x].uses.push_back(pt);
+	      if (si.defs.empty()) m_info[x].refinements.push_back(pt);
+	    }
+	    for (unsigned x: si.defs) m_info[x].defs.push_back(pt);
+	    m_stmts[b].push_back(si);
+	  }
+	}
+      }
+
+      void classify(unsigned x, const std::vector<char> &cyclic) {
+	var_info &vi = m_info[x];
+	if (vi.defs.size() == 1) {
+	  const point_t &d = vi.defs[0];
+	  vi.closed = std::all_of(vi.uses.begin(), vi.uses.end(), [&](const point_t &u) {
+	      return strictly_dominates(d.first, u.first) ||
+		(d.first == u.first && d.second < u.second);
+	    });
+	  vi.anchor = d.first;
+	  vi.strict = true;
+	} else if (vi.defs.size() > 1 && !vi.uses.empty()) {
+	  // -- the first dominator of the uses whose predecessors
+	  //    define the variable (e.g., the phi nodes of a loop head)
+	  boost::unordered_set<unsigned> def_blocks;
+	  for (auto &d: vi.defs) def_blocks.insert(d.first);
+	  unsigned m = vi.uses[0].first;
+	  for (auto &u: vi.uses) m = intersect(m, u.first);
+	  for (;;) {
+	    if (m != 0 && std::all_of(m_preds[m].begin(), m_preds[m].end(),
+				      [&](unsigned p) { return def_blocks.count(p) > 0; })) {
+	      vi.closed = true;
+	      vi.anchor = m;
+	      vi.strict = false;
+	      break;
+	    }
+	    if (m == 0) break;
+	    m = m_idom[m];
+	  }
+	}
+	vi.widen = !vi.closed ||
+	  std::any_of(vi.defs.begin(), vi.defs.end(),
+		      [&](const point_t &d) { return cyclic[d.first]; });
+	if (vi.closed) {
+	  m_anchored[vi.anchor].push_back(x);
+	} else if (!vi.defs.empty() || !vi.refinements.empty()) {
+	  m_others.push_back(x);
+	}
+	// -- the blocks where the definitions that follow each
+	//    refinement can flow without going through it again
+	for (auto &r: vi.refinements) {
+	  std::vector<unsigned> stack;
+	  boost::unordered_set<unsigned> killed;
+	  for (auto &d: vi.defs) {
+	    if (strictly_dominates(r.first, d.first) ||
+		(d.first == r.first && d.second > r.second)) {
+	      stack.push_back(d.first);
+	    }
+	  }
+	  while (!stack.empty()) {
+	    unsigned b = stack.back();
+	    stack.pop_back();
+	    for (unsigned s: m_succs[b]) {
+	      if (s != r.first && dominates(r.first, s) && killed.insert(s).second) {
+		stack.push_back(s);
+	      }
+	    }
+	  }
+	  vi.killed.push_back(std::vector<unsigned>(killed.begin(), killed.end()));
+	  std::sort(vi.killed.back().begin(), vi.killed.back().end());
+	}
+	if (!vi.closed) {
+	  vi.value = m_init;
+	  vi.value.project(std::vector<var_t>(1, m_vars[x]));
+	}
+      }
+
+      // Whether the k-th refinement of x holds before the i-th
+      // statement of block b
+      bool applies(unsigned x, unsigned k, unsigned b, unsigned i) const {
+	const var_info &vi = m_info[x];
+	const point_t &r = vi.refinements[k];
+	if (r.first == b) {
+	  if (r.second >= i) return false;
+	  return std::none_of(vi.defs.begin(), vi.defs.end(), [&](const point_t &d) {
+	      return d.first == b && r.second < d.second && d.second < i;
+	    });
+	}
+	if (!strictly_dominates(r.first, b) ||
+	    std::binary_search(vi.killed[k].begin(), vi.killed[k].end(), b)) {
+	  return false;
+	}
+	return std::none_of(vi.defs.begin(), vi.defs.end(), [&](const point_t &d) {
+	    return d.first == b && d.second < i;
+	  });
+      }
+
+      // The value of x before the i-th statement of block b. The
+      // variables read are added to deps.
+      Dom value_at(unsigned x, unsigned b, unsigned i, std::vector<unsigned> *deps) const {
+	const var_info &vi = m_info[x];
+	Dom v(vi.value);
+	if (deps) deps->push_back(x);
+	if (v.is_bottom()) return v;
+	std::vector<unsigned> ks;
+	for (unsigned k = 0; k < vi.refinements.size(); ++k) {
+	  if (applies(x, k, b, i)) ks.push_back(k);
+	}
+	// -- in dominance order
+	std::sort(ks.begin(), ks.end(), [&](unsigned k1, unsigned k2) {
+	    const point_t &r1 = vi.refinements[k1];
+	    const point_t &r2 = vi.refinements[k2];
+	    return std::make_pair(m_dom_pre[r1.first], r1.second) <
+	      std::make_pair(m_dom_pre[r2.first], r2.second);
+	  });
+	for (unsigned k: ks) {
+	  const point_t &r = vi.refinements[k];
+	  const stmt_info &si = m_stmts[r.first][r.second];
+	  Dom ctx(v);
+	  for (unsigned y: si.uses) {
+	    if (y == x) continue;
+	    ctx = ctx & m_info[y].value;
+	    if (deps) deps->push_back(y);
+	  }
+	  abs_tr_t vis(&ctx);
+	  si.stmt->accept(&vis);
+	  if (ctx.is_bottom()) return ctx;
+	  ctx.project(std::vector<var_t>(1, m_vars[x]));
+	  v = ctx;
+	}
+	return v;
+      }
+
+      void enable(unsigned b) {
+	if (m_exec[b]) return;
+	m_exec[b] = true;
+	if (m_stmts[b].empty()) {
+	  for (unsigned s: m_succs[b]) enable(s);
+	  return;
+	}
+	for (unsigned i = 0; i < m_stmts[b].size(); ++i) {
+	  m_worklist.insert(point_t(b, i));
+	}
+      }
+
+      void update(unsigned x, const Dom &v) {
+	var_info &vi = m_info[x];
+	if (v <= vi.value) return;
+	if (vi.widen && vi.updates >= this->m_widening_delay) {
+	  vi.value = vi.value || (vi.value | v);
+	} else {
+	  vi.value = vi.value | v;
+	}
+	vi.updates++;
+	for (auto &p: vi.users) {
+	  if (m_exec[p.first]) m_worklist.insert(p);
+	}
+      }
+
+      void eval(const point_t &p) {
+	stmt_info &si = m_stmts[p.first][p.second];
+	std::vector<unsigned> deps;
+	Dom ctx = Dom::top();
+	for (unsigned y: si.uses) {
+	  ctx = ctx & value_at(y, p.first, p.second, &deps);
+	  if (ctx.is_bottom()) break;
+	}
+	for (unsigned y: deps) m_info[y].users.insert(p);
+	if (ctx.is_bottom()) return;
+	abs_tr_t vis(&ctx);
+	si.stmt->accept(&vis);
+	if (ctx.is_bottom()) return;
+	if (!si.reached) {
+	  si.reached = true;
+	  if (--m_num_bot[p.first] == 0) {
+	    for (unsigned s: m_succs[p.first]) enable(s);
+	  }
+	}
+	for (unsigned x: si.defs) {
+	  Dom v(ctx);
+	  v.project(std::vector<var_t>(1, m_vars[x]));
+	  update(x, v);
+	}
+      }
+
+    public:
+
+      sparse_fixpoint(cfg_ref_t cfg, basic_block_label_t entry, Dom init,
+		      unsigned widening_delay, unsigned narrowing_iters,
+		      const cfg_loop_order *order)
+	: base_t(cfg, entry, init, widening_delay, narrowing_iters, order) {}
+
+      void run() {
+	this->number_blocks();
+	unsigned n = m_blocks.size();
+	m_exec.assign(n, false);
+	if (m_init.is_bottom()) return;
+	compute_dominators();
+	collect();
+	std::vector<unsigned> comp_of;
+	std::vector<std::vector<unsigned>> comps = this->components(comp_of);
+	std::vector<char> cyclic(n, false);
+	for (unsigned b = 0; b < n; ++b) {
+	  cyclic[b] = m_is_head[b] || comps[comp_of[b]].size() > 1;
+	}
+	m_anchored.resize(n);
+	for (unsigned x = 0; x < m_vars.size(); ++x) classify(x, cyclic);
+	m_num_bot.resize(n);
+	for (unsigned b = 0; b < n; ++b) m_num_bot[b] = m_stmts[b].size();
+	enable(0);
+	while (!m_worklist.empty()) {
+	  point_t p = *m_worklist.begin();
+	  m_worklist.erase(m_worklist.begin());
+	  eval(p);
+	}
+      }
+
+      virtual Dom get_pre(basic_block_label_t bl) const override {
+	auto it = m_ids.find(bl);
+	if (it == m_ids.end() || !m_exec[it->second]) return Dom::bottom();
+	unsigned b = it->second;
+	Dom inv(m_init);
+	auto add = [&](unsigned x) {
+	  Dom v = value_at(x, b, 0, nullptr);
+	  if (v.is_bottom()) return false;
+	  inv -= m_vars[x];
+	  inv = inv & v;
+	  return true;
+	};
+	for (unsigned c = b;; c = m_idom[c]) {
+	  for (unsigned x: m_anchored[c]) {
+	    if (c == b && m_info[x].strict) continue;
+	    if (!add(x)) return Dom::bottom();
+	  }
+	  if (c == 0) break;
+	}
+	for (unsigned x: m_others) {
+	  if (!add(x)) return Dom::bottom();
+	}
+	return inv;
+      }
+
+      virtual Dom get_post(basic_block_label_t bl) const override {
+	Dom inv = get_pre(bl);
+	if (inv.is_bottom()) return inv;
+	abs_tr_t vis(&inv);
+	for (auto &s: m_cfg.get_node(bl)) {
+	  s.accept(&vis);
+	}
+	return inv;
+      }
+    };
+  } // end namespace fixpoint_impl
+
+  template<typename Dom>
+  intra_analyzer<Dom>::intra_analyzer(cfg_ref_t cfg)
+    : m_cfg(cfg), m_analyzer(new analyzer_t(cfg)) {}
+
+  template<typename Dom>
+  intra_analyzer<Dom>::~intra_analyzer() {}
+  
+  template<typename Dom>
+  void intra_analyzer<Dom>::run(basic_block_label_t entry, Dom init, Dom post_cond,
+				bool only_forward, const assumption_map_t &assumptions,
+				liveness_t *live, unsigned widening_delay,
+				unsigned narrowing_iters, unsigned jumpset) {
+    m_analyzer->run(entry, init, post_cond, only_forward, assumptions, live,
+		    widening_delay, narrowing_iters, jumpset);
+  }
+
+  template<typename Dom>
+  void intra_analyzer<Dom>::run_parallel(basic_block_label_t entry, Dom init,
+					 unsigned widening_delay, unsigned narrowing_iters,
+					 unsigned num_threads, const cfg_loop_order *order,
+					 bool adaptive, unsigned max_delay,
+					 bool accelerate) {
+    std::unique_ptr<fixpoint_impl::parallel_fixpoint<Dom>> engine
+      (new fixpoint_impl::parallel_fixpoint<Dom>
+       (m_cfg, entry, init, widening_delay, narrowing_iters, order,
+	adaptive, max_delay, accelerate));
+    engine->run(num_threads);
+    m_engine = std::move(engine);
+  }
+
+  template<typename Dom>
+  void intra_analyzer<Dom>::run_sparse(basic_block_label_t entry, Dom init,
+				       unsigned widening_delay, unsigned narrowing_iters,
+				       const cfg_loop_order *order) {
+    std::unique_ptr<fixpoint_impl::sparse_fixpoint<Dom>> engine
+      (new fixpoint_impl::sparse_fixpoint<Dom>
+       (m_cfg, entry, init, widening_delay, narrowing_iters, order));
+    engine->run();
+    m_engine = std::move(engine);
+  }
+
+  template<typename Dom>
+  void intra_analyzer<Dom>::run_sequential() {
+    if (!m_engine) return;
+    m_analyzer->run(m_engine->entry(), m_engine->init(), Dom::top(), true,
+		    assumption_map_t(), nullptr, m_engine->widening_delay(),
+		    m_engine->narrowing_iters(), 0);
+    m_engine.reset();
+  }
+  
+  template<typename Dom>
+  Dom intra_analyzer<Dom>::get_pre(basic_block_label_t bl) {
+    if (m_engine) return m_engine->get_pre(bl);
+    return m_analyzer->get_pre(bl);
+  }
+
+  template<typename Dom>
+  Dom intra_analyzer<Dom>::get_post(basic_block_label_t bl) {
+    if (m_engine) return m_engine->get_post(bl);
+    return m_analyzer->get_post(bl);
+  }
+
+  template<typename Dom>
+  Dom intra_analyzer<Dom>::get_preconditions(basic_block_label_t bl) {
+    run_sequential();
+    return m_analyzer->get_preconditions(bl);
+  }
+  
+  template<typename Dom>
+  bool intra_analyzer<Dom>::check_asserting_blocks(crab::checker::checks_db &checks) {
+    typedef crab::analyzer::intra_abs_transformer<Dom> abs_tr_t;
+    std::vector<basic_block_label_t> blocks;
+    for (auto bl: boost::make_iterator_range(m_cfg.label_begin(), m_cfg.label_end())) {
+      bool has_asserts, call_before_assert;
+      if (!checker_impl::scan_block(m_cfg.get_node(bl), has_asserts, call_before_assert)) {
+	return false;
+      }
+      if (has_asserts) blocks.push_back(bl);
+    }
+    for (auto bl: blocks) {
+      Dom inv = get_pre(bl);
+      abs_tr_t vis(&inv);
+      checker_impl::check_block(inv, vis, m_cfg.get_node(bl), checks);
+    }
+    return true;
+  }
+  
+  template<typename Dom>
+  crab::checker::checks_db intra_analyzer<Dom>::check(bool nullity, unsigned verbose,
+						      bool only_asserting_blocks) {
+    if ((only_asserting_blocks || m_engine) && !nullity && verbose == 0) {
+      crab::checker::checks_db checks;
+      if (check_asserting_blocks(checks)) return checks;
+    }
+    // -- the checkers of crab need its analyzer
+    run_sequential();
+    typedef crab::checker::intra_checker<analyzer_t> intra_checker_t;
+    typedef crab::checker::assert_property_checker<analyzer_t> assert_prop_t;
+    typedef crab::checker::null_property_checker<analyzer_t> null_prop_t;
+    
+    typename intra_checker_t::prop_checker_ptr prop(new assert_prop_t(verbose));
+    if (nullity)
+      prop.reset(new null_prop_t(verbose));
+    intra_checker_t checker(*m_analyzer, {prop});
+    checker.run();
+    CRAB_VERBOSE_IF(1, checker.show(crab::outs()));
+    return checker.get_all_checks();
+  }
+
+  template<typename BUDom, typename TDDom>
+  inter_analyzer<BUDom,TDDom>::inter_analyzer(call_graph_ref_t cg, liveness_map_t *live,
+					      unsigned widening_delay,
+					      unsigned narrowing_iters, unsigned jumpset)
+    : m_cg(cg),
+      m_analyzer(new analyzer_t(cg, live, widening_delay, narrowing_iters, jumpset)) {}
+
+  template<typename BUDom, typename TDDom>
+  inter_analyzer<BUDom,TDDom>::~inter_analyzer() {}
+  
+  template<typename BUDom, typename TDDom>
+  void inter_analyzer<BUDom,TDDom>::run(TDDom init) {
+    m_analyzer->Run(init);
+  }
+
+  template<typename BUDom, typename TDDom>
+  TDDom inter_analyzer<BUDom,TDDom>::get_pre(cfg_ref_t cfg, basic_block_label_t bl) {
+    return m_analyzer->get_pre(cfg, bl);
+  }
+
+  template<typename BUDom, typename TDDom>
+  TDDom inter_analyzer<BUDom,TDDom>::get_post(cfg_ref_t cfg, basic_block_label_t bl) {
+    return m_analyzer->get_post(cfg, bl);
+  }
+
+  template<typename BUDom, typename TDDom>
+  bool inter_analyzer<BUDom,TDDom>::has_summary(cfg_ref_t cfg) {
+    return m_analyzer->has_summary(cfg);
+  }
+
+  template<typename BUDom, typename TDDom>
+  void inter_analyzer<BUDom,TDDom>::write_summary(cfg_ref_t cfg, crab::crab_os &o,
+						  bool compact, unsigned max_relational) {
+    auto summ = m_analyzer->get_summary(cfg);
+    auto f_decl = cfg.get_func_decl();
+    if (!compact || !f_decl) {
+      o << *summ;
+      return;
+    }
+    std::vector<var_t> vars(summ->get_inputs().begin(), summ->get_inputs().end());
+    vars.insert(vars.end(), summ->get_outputs().begin(), summ->get_outputs().end());
+    o << *f_decl << " ==> "
+      << summary_impl::compact(summ->get_sum(), vars, max_relational);
+  }
+  
+  template<typename BUDom, typename TDDom>
+  bool inter_analyzer<BUDom,TDDom>::check_parallel(unsigned num_threads,
+						   crab::checker::checks_db &checks) {
+    typedef crab::analyzer::intra_abs_transformer<TDDom> intra_abs_tr_t;
+    typedef std::pair<cfg_ref_t, basic_block_label_t> block_t;
+    // -- blocks whose assertions follow a callsite need the summaries
+    //    and the call table of the analyzer so they are checked by
+    //    the calling thread.
+    std::vector<block_t> par_blocks, seq_blocks;
+    for (auto v: boost::make_iterator_range(vertices(m_cg))) {
+      cfg_ref_t cfg = v.get_cfg();
+      for (auto bl: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+	bool has_asserts, call_before_assert;
+	if (!checker_impl::scan_block(cfg.get_node(bl), has_asserts, call_before_assert)) {
+	  return false;
+	}
+	if (!has_asserts) continue;
+	(call_before_assert ? seq_blocks : par_blocks).push_back(block_t(cfg, bl));
+      }
+    }
+    
+    std::vector<crab::checker::checks_db> worker_checks(std::max(1U, num_threads));
+    bool arena = in_arena_scope();
+    parallel_for(par_blocks.size(), num_threads, [&](unsigned id, unsigned i) {
+	arena_scope worker_arena(arena);
+	cfg_ref_t cfg = par_blocks[i].first;
+	TDDom inv = m_analyzer->get_pre(cfg, par_blocks[i].second);
+	// -- no callsite before the assertions: the intra-procedural
+	//    transformer has the same effect
+	intra_abs_tr_t vis(&inv);
+	checker_impl::check_block(inv, vis, cfg.get_node(par_blocks[i].second),
+				  worker_checks[id]);
+      });
+    for (auto &db: worker_checks) {
+      checks += db;
+    }
+    for (auto &b: seq_blocks) {
+      TDDom inv = m_analyzer->get_pre(b.first, b.second);
+      auto abs_tr = m_analyzer->get_abs_transformer(&inv);
+      checker_impl::check_block(inv, *abs_tr, b.first.get_node(b.second), checks);
+    }
+    return true;
+  }
+  
+  template<typename BUDom, typename TDDom>
+  crab::checker::checks_db inter_analyzer<BUDom,TDDom>::check(bool nullity, unsigned verbose,
+							      unsigned num_threads) {
+    if (num_threads > 1 && !nullity && verbose == 0) {
+      crab::checker::checks_db checks;
+      if (check_parallel(num_threads, checks)) return checks;
+    }
+    typedef crab::checker::inter_checker<analyzer_t> inter_checker_t;
+    typedef crab::checker::assert_property_checker<analyzer_t> assert_prop_t;
+    typedef crab::checker::null_property_checker<analyzer_t> null_prop_t;
+    
+    typename inter_checker_t::prop_checker_ptr prop(new assert_prop_t(verbose));
+    if (nullity)
+      prop.reset(new null_prop_t(verbose));
+    inter_checker_t checker(*m_analyzer, {prop});
+    checker.run();
+    //CRAB_VERBOSE_IF(1, checker.show (crab::outs()));
+    return checker.get_all_checks();
+  }
+  
+} // end namespace crab_llvm
@@ -4,14 +4,63 @@
 #include <crab/iterators/killgen_fixpoint_iterator.hpp>
 
 #include <boost/unordered_set.hpp>
+#include <algorithm>
+#include <iterator>
 #include <boost/range/iterator_range.hpp>
 
 namespace crab {
 namespace analyzer {
 
 template<typename CFG, typename AbsDom>
-path_analyzer<CFG,AbsDom>::path_analyzer(CFG cfg, AbsDom init, bool ignore_assertions)
-  : m_cfg(cfg), m_init(init), m_ignore_assertions(ignore_assertions) { }
+path_analyzer<CFG,AbsDom>::path_analyzer(CFG cfg, AbsDom init, bool ignore_assertions,
+					 const successor_index_t *index)
+  : m_cfg(cfg), m_init(init), m_ignore_assertions(ignore_assertions), m_index(index) { }
+
+// Return false if the path is not connected. Raise an error if it is
+// not acyclic.
+template<typename CFG, typename AbsDom>  
+bool path_analyzer<CFG,AbsDom>::
+is_well_formed(const std::vector<basic_block_label_t>& path) {
+  if (path.size() <= 1) return true;
+
+  if (m_index) {
+    std::vector<unsigned> ids(path.size());
+    for (unsigned i=0; i < path.size(); ++i) {
+      if (!m_index->get_id(path[i], ids[i])) {
+	CRAB_WARN("Block ", cfg_impl::get_label_str(path[i]), " is not in the cfg");
+	return false;
+      }
+      if (i > 0 && !m_index->has_edge(ids[i-1], ids[i])) {
+	CRAB_WARN("There is no an edge from ",
+		  cfg_impl::get_label_str(path[i-1]), " to ",
+		  cfg_impl::get_label_str(path[i]));
+	return false;
+      }
+    }
+    std::sort(ids.begin(), ids.end());
+    if (std::adjacent_find(ids.begin(), ids.end()) != ids.end()) {
+      CRAB_ERROR("The path is not acyclic");
+    }
+    return true;
+  }
+  
+  boost::unordered_set<basic_block_label_t> visited;
+  visited.reserve(path.size());
+  for (unsigned i=0;i < path.size(); ++i) {
+    if (!visited.insert(path[i]).second) {
+      CRAB_ERROR("The path is not acyclic");
+    }
+    if (i < path.size() - 1)  {
+      if (!has_kid(path[i], path[i+1])) {
+	CRAB_WARN("There is no an edge from ",
+		  cfg_impl::get_label_str(path[i]), " to ",
+		  cfg_impl::get_label_str(path[i+1]));
+	return false;
+      }
+    }
+  }
+  return true;
+}
 
 template<typename CFG, typename AbsDom>  
 bool path_analyzer<CFG,AbsDom>::
@@ -87,21 +136,8 @@ bool path_analyzer<CFG,AbsDom>::solve(const std::vector<basic_block_label_t>& pa
     CRAB_ERROR("Last block of the path must be the exit block of the cfg");
   #endif
   
-  if (path.size() > 1) {
-    boost::unordered_set<basic_block_label_t> visited;
-    for (unsigned i=0;i < path.size(); ++i) {
-      if (!visited.insert(path[i]).second) {
-	CRAB_ERROR("The path is not acyclic");
-      }
-      if (i < path.size() - 1)  {
-	if (!has_kid(path[i], path[i+1])) {
-	  CRAB_WARN("There is no an edge from ",
-		    cfg_impl::get_label_str(path[i]), " to ",
-		    cfg_impl::get_label_str(path[i+1]));
-	  return true;
-	}
-      }
-    }
+  if (!is_well_formed(path)) {
+    return true;
   }
 
   // contain all statements along the path until the end of the path
@@ -164,8 +200,45 @@ bool path_analyzer<CFG,AbsDom>::solve(const std::vector<basic_block_label_t>& pa
 }
   
 
+template<typename CFG, typename AbsDom>  
+bool path_analyzer<CFG,AbsDom>::push(basic_block_label_t b) {
+  if (!m_path.empty() && !has_kid(m_path.back(), b)) {
+    CRAB_WARN("There is no an edge from ",
+	      cfg_impl::get_label_str(m_path.back()), " to ",
+	      cfg_impl::get_label_str(b));
+  }
+  
+  AbsDom post(m_path_post.empty() ? m_init : m_path_post.back());
+  if (!post.is_bottom()) {
+    // everything after bottom is bottom so we do not apply the
+    // transformer
+    fwd_abs_tr_t abs_tr(&post);
+    auto &bb = m_cfg.get_node(b);
+    for (auto &s: bb) {
+      s.accept(&abs_tr);
+    }
+  }
+  m_path.push_back(b);
+  m_path_post.push_back(post);
+  return !post.is_bottom();
+}
+
+template<typename CFG, typename AbsDom>  
+void path_analyzer<CFG,AbsDom>::pop() {
+  if (m_path.empty()) {
+    CRAB_WARN("Empty path: do nothing\n");
+    return;
+  }
+  m_path.pop_back();
+  m_path_post.pop_back();
+}
+  
 template<typename CFG, typename AbsDom>  
 bool path_analyzer<CFG,AbsDom>::has_kid(basic_block_label_t b1, basic_block_label_t b2) {
+  unsigned id1, id2;
+  if (m_index && m_index->get_id(b1, id1) && m_index->get_id(b2, id2)) {
+    return m_index->has_edge(id1, id2);
+  }
   for (basic_block_label_t child: m_cfg.next_nodes (b1)) {
     if (child == b2)
       return true;
@@ -173,6 +246,67 @@ bool path_analyzer<CFG,AbsDom>::has_kid(basic_block_label_t b1, basic_block_labe
   return false;
 }
 
+// Return true if the statements of core at the positions in indexes
+// (sorted) imply false.
+template<typename CFG, typename AbsDom>
+bool path_analyzer<CFG,AbsDom>::
+is_unsat(const std::vector<crab::cfg::statement_wrapper>& core,
+	 const std::vector<unsigned>& indexes) const {
+  AbsDom inv;
+  fwd_abs_tr_t abs_tr(&inv);
+  for (unsigned i: indexes) {
+    core[i].m_s->accept (&abs_tr);
+    if (inv.is_bottom()) {
+      return true;
+    }
+  }
+  return inv.is_bottom();
+}
+
+static std::vector<unsigned> merge_indexes(const std::vector<unsigned>& x,
+					   const std::vector<unsigned>& y) {
+  std::vector<unsigned> res;
+  res.reserve(x.size() + y.size());
+  std::merge(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(res));
+  return res;
+}
+
+// QuickXplain: add to res a minimal subset of candidates that
+// together with background implies false. Statements are always
+// replayed in path order.
+//
+// Pre: background U candidates implies false.
+template<typename CFG, typename AbsDom>
+void path_analyzer<CFG,AbsDom>::
+quick_xplain(const std::vector<crab::cfg::statement_wrapper>& core,
+	     const std::vector<unsigned>& background,
+	     bool background_changed,
+	     const std::vector<unsigned>& candidates,
+	     std::vector<unsigned>& res) const {
+  if (background_changed && is_unsat(core, background)) {
+    return;
+  }
+  if (candidates.empty()) {
+    return;
+  }
+  if (candidates.size() == 1) {
+    res.push_back(candidates[0]);
+    return;
+  }
+  unsigned half = candidates.size() / 2;
+  std::vector<unsigned> c1(candidates.begin(), candidates.begin() + half);
+  std::vector<unsigned> c2(candidates.begin() + half, candidates.end());
+  // -- minimal subset of c2 assuming all c1
+  std::vector<unsigned> d2;
+  quick_xplain(core, merge_indexes(background, c1), !c1.empty(), c2, d2);
+  std::sort(d2.begin(), d2.end());
+  // -- minimal subset of c1 assuming d2
+  std::vector<unsigned> d1;
+  quick_xplain(core, merge_indexes(background, d2), !d2.empty(), c1, d1);
+  res.insert(res.end(), d1.begin(), d1.end());
+  res.insert(res.end(), d2.begin(), d2.end());
+}
+  
 // Compute a minimal subset of statements based on syntactic
 // dependencies.
 // Return true if the core is just the statement "assume(false)"
@@ -303,28 +437,20 @@ minimize_path(const std::vector<crab::cfg::statement_wrapper>& path) {
   }
 
   
-  std::vector<bool> enabled(core.size(), true);
-  for (unsigned i=0; i < core.size (); ++i) {
-    AbsDom inv;
-    fwd_abs_tr_t abs_tr(&inv);    
-    for(unsigned j=0; j < core.size(); ++j) {
-      if (i != j && enabled[j]) {
-	core[j].m_s->accept (&abs_tr);
-	if (inv.is_bottom()) {
-	  break;
-	}
-      }
-    }
-    if (inv.is_bottom()) {
-      enabled[i] = false;
-    }
+  // Divide-and-conquer deletion (QuickXplain). It needs O(k log(n/k))
+  // replays where k is the size of the core instead of one replay
+  // per statement.
+  std::vector<unsigned> all(core.size());
+  for (unsigned i=0; i < core.size(); ++i) {
+    all[i] = i;
   }
-
-  m_core.reserve(core.size());
-  for (unsigned i=0; i < core.size();++i) {
-    if (enabled[i]) {
-      m_core.push_back(core[i]);
-    }
+  std::vector<unsigned> min_core;
+  quick_xplain(core, std::vector<unsigned>(), false, all, min_core);
+  std::sort(min_core.begin(), min_core.end());
+  
+  m_core.reserve(min_core.size());
+  for (unsigned i: min_core) {
+    m_core.push_back(core[i]);
   }
 
   // sanity checks  
@@ -361,7 +487,10 @@ template class path_analyzer<crab_llvm::cfg_ref_t, crab_llvm::boxes_domain_t>;
 template class path_analyzer<crab_llvm::cfg_ref_t, crab_llvm::term_int_domain_t>;
 #endif   
 template class path_analyzer<crab_llvm::cfg_ref_t, crab_llvm::interval_domain_t>;
+template class path_analyzer<crab_llvm::cfg_ref_t, crab_llvm::dense_interval_domain_t>;
 template class path_analyzer<crab_llvm::cfg_ref_t, crab_llvm::wrapped_interval_domain_t>;      
+template class path_analyzer<crab_llvm::cfg_ref_t, crab_llvm::wrapped_interval_fast_domain_t>;
+template class path_analyzer<crab_llvm::cfg_ref_t, crab_llvm::offset_pointer_domain_t>;
 } 
 } 
 
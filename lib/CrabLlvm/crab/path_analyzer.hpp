@@ -2,11 +2,61 @@
 
 #include <crab_llvm/crab_cfg.hh>
 #include <crab/analysis/abs_transformer.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/range/iterator_range.hpp>
+#include <cstdint>
 
 namespace crab {
 namespace analyzer {
 
   
+  /**
+   ** Dense ids for the blocks of a CFG and a hashed set of its
+   ** edges. It is built once for a CFG and shared by all the
+   ** analyzers of its paths so checking that a path is well-formed
+   ** is linear in the size of the path.
+   **/
+  template<typename CFG>
+  class cfg_successor_index: public boost::noncopyable {
+    typedef typename CFG::basic_block_label_t basic_block_label_t;
+    
+    boost::unordered_map<basic_block_label_t, unsigned> m_ids;
+    boost::unordered_set<uint64_t> m_edges;
+
+    static uint64_t edge(unsigned src, unsigned dst) {
+      return (((uint64_t) src) << 32) | dst;
+    }
+    
+  public:
+    
+    cfg_successor_index(CFG cfg) {
+      for (auto b: boost::make_iterator_range(cfg.label_begin(), cfg.label_end())) {
+	m_ids.insert(std::make_pair(b, m_ids.size()));
+      }
+      for (auto &kv: m_ids) {
+	for (auto child: cfg.next_nodes(kv.first)) {
+	  auto it = m_ids.find(child);
+	  if (it != m_ids.end()) {
+	    m_edges.insert(edge(kv.second, it->second));
+	  }
+	}
+      }
+    }
+
+    // Return false if b is not a block of the CFG
+    bool get_id(basic_block_label_t b, unsigned &id) const {
+      auto it = m_ids.find(b);
+      if (it == m_ids.end()) return false;
+      id = it->second;
+      return true;
+    }
+    
+    bool has_edge(unsigned src, unsigned dst) const {
+      return m_edges.count(edge(src, dst)) > 0;
+    }
+  };
+  
   /**
    ** Compute the strongest post-condition over a single path given as
    ** an ordered sequence of connected basic blocks.
@@ -23,8 +73,12 @@ namespace analyzer {
     typedef intra_necessary_preconditions_abs_transformer<AbsDom,stmt_to_dom_map_t> bwd_abs_tr_t;
     
   public:
-    // precondition: cfg is well typed.      
-    path_analyzer (CFG cfg, AbsDom init, bool ignore_assertions = true);
+    typedef cfg_successor_index<CFG> successor_index_t;
+    
+    // precondition: cfg is well typed.
+    // If index is not null then it must have been built from cfg.
+    path_analyzer (CFG cfg, AbsDom init, bool ignore_assertions = true,
+		   const successor_index_t *index = nullptr);
     
     /* Return true iff the forward analysis of path is not bottom. 
      * 
@@ -70,11 +124,42 @@ namespace analyzer {
       core.clear();
       core.assign(m_core.begin(), m_core.end());
     }
+
+    /* 
+     * Incremental API for paths that share prefixes. The current path
+     * is extended and shrunk as a stack. The forward state at the
+     * exit of each block of the path is kept so only the new blocks
+     * are analyzed. It is independent of solve.
+     */
+    
+    // Extend the current path with b. Return false iff the path
+    // implies false.
+    bool push(basic_block_label_t b);
+
+    // Remove the last block of the current path.
+    void pop();
+
+    // Return false iff the current path implies false.
+    bool is_feasible() const {
+      return m_path_post.empty() || !m_path_post.back().is_bottom();
+    }
+
+    unsigned path_size() const {
+      return m_path.size();
+    }
     
   private:
     
     bool has_kid(basic_block_label_t b1, basic_block_label_t b2);
+    bool is_well_formed(const std::vector<basic_block_label_t>& path);
     void minimize_path(const std::vector<crab::cfg::statement_wrapper>& path);
+    bool is_unsat(const std::vector<crab::cfg::statement_wrapper>& core,
+		  const std::vector<unsigned>& indexes) const;
+    void quick_xplain(const std::vector<crab::cfg::statement_wrapper>& core,
+		      const std::vector<unsigned>& background,
+		      bool background_changed,
+		      const std::vector<unsigned>& candidates,
+		      std::vector<unsigned>& res) const;
     bool remove_irrelevant_statements(std::vector<crab::cfg::statement_wrapper>& path);
     bool solve_path(const std::vector<basic_block_label_t>& path,
 		    const bool only_bool_reasoning,
@@ -87,6 +172,8 @@ namespace analyzer {
     abs_dom_t m_init;
     // tell the forward abstract transformer to ignore assertions
     bool m_ignore_assertions;
+    // edges of m_cfg (optional)
+    const successor_index_t *m_index;
     // map from basic blocks to postconditions
     bb_to_dom_map_t m_fwd_dom_map;
     // map from basic blocks to preconditions.
@@ -95,6 +182,10 @@ namespace analyzer {
     // minimal subset of statements that explains path unsatisfiability
     // (only if solver return false (i.e., bottom)
     std::vector<crab::cfg::statement_wrapper> m_core;
+    // current path of the incremental API
+    std::vector<basic_block_label_t> m_path;
+    // forward state at the exit of each block of m_path
+    std::vector<abs_dom_t> m_path_post;
   }; 
   
 } // end namespace
@@ -2,10 +2,13 @@
 #include "crab_llvm/Transforms/DevirtFunctions.hh"
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/Format.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/CallGraph.h"
 
 #include <set>
 #include <algorithm>
+#include <string>
 
 using namespace llvm;
 
@@ -92,17 +95,75 @@ namespace crab_llvm {
 
   struct FunctionCompare {
 
-    // TODO: we should compare two functions in a deterministic way
-    // across multiple executions.
+    // Named functions are sorted by name so the order is the same
+    // across multiple executions. Names are unique in a module.
     bool operator()(const Function *F1, const Function *F2) {
-      // if (F1->hasName() && F2->hasName()) {
-      // 	if (F1->getName () != F2->getName()) {
-      // 	  return F1->getName() < F2->getName();
-      // 	}
-      // } 
+      if (F1->hasName() != F2->hasName()) {
+	return F1->hasName();
+      }
+      if (F1->hasName()) {
+	return F1->getName() < F2->getName();
+      }
       return F1 < F2;
     }
   };
+
+  /// Return a name for the bounce function of Targets with type Ty
+  /// that does not depend on the execution so running twice the
+  /// transformation produces the same bounce functions.
+  static std::string getBounceName(FunctionType *Ty,
+				   const CallSiteResolver::AliasSet &Targets) {
+    // -- 64-bit FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    auto hash = [&h](StringRef str) {
+      for (unsigned char c : str) {
+	h ^= c;
+	h *= 1099511628211ULL;
+      }
+      h ^= 0xff; h *= 1099511628211ULL; // separator
+    };
+    std::string ty_str;
+    raw_string_ostream o(ty_str);
+    o << *Ty;
+    hash(o.str());
+    for (const Function *F : Targets) {
+      hash(F->getName());
+    }
+    std::string name;
+    raw_string_ostream n(name);
+    n << "seahorn.bounce." << format_hex_no_prefix(h, 16);
+    return n.str();
+  }
+
+  // Return true if bounce calls exactly Targets and its default
+  // block is as requested by allowIndirectCalls. The names of the
+  // bounce functions are hashes (and unnamed targets hash the same)
+  // so a bounce function with the expected name can still be for
+  // other targets.
+  static bool isBounceFor(const Function &bounce,
+			  const CallSiteResolver::AliasSet &Targets,
+			  bool allowIndirectCalls) {
+    SmallPtrSet<const Function*, 16> callees;
+    bool has_fail = false;
+    for (auto &B : bounce) {
+      for (auto &I : B) {
+	if (const CallInst *CI = dyn_cast<CallInst>(&I)) {
+	  if (const Function *F = CI->getCalledFunction()) {
+	    callees.insert(F);
+	  }
+	} else if (isa<UnreachableInst>(I)) {
+	  has_fail = true;
+	}
+      }
+    }
+    if (has_fail == allowIndirectCalls) return false;
+    SmallPtrSet<const Function*, 16> targets(Targets.begin(), Targets.end());
+    if (callees.size() != targets.size()) return false;
+    for (const Function *F : targets) {
+      if (!callees.count(F)) return false;
+    }
+    return true;
+  }
     
   /***
    * Begin specific callsites resolvers
@@ -311,15 +372,19 @@ namespace crab_llvm {
   template<typename Dsa>
   Function* CallSiteResolverByDsa<Dsa>::getBounceFunction(CallSite&CS) {
     AliasSetId id = devirt_impl::typeAliasId(CS, false);
-    auto it = m_bounce_map.find(id);
-    if (it != m_bounce_map.end()) {
+    const AliasSet* Targets = getTargets(CS);
+    if (!Targets) {
+      return nullptr;
+    }
+    // -- several bounce functions can have the same type so we look
+    // -- for one with the same targets
+    auto range = m_bounce_map.equal_range(id);
+    for (auto it = range.first; it != range.second; ++it) {
       const AliasSet* cachedTargets = it->second.first;
-      const AliasSet* Targets = getTargets(CS);
-      if (cachedTargets && Targets) {
-	if (std::equal(cachedTargets->begin(), cachedTargets->end(),
-		       Targets->begin())) {
-	  return it->second.second;
-	}
+      if (cachedTargets && cachedTargets->size() == Targets->size() &&
+	  std::equal(cachedTargets->begin(), cachedTargets->end(),
+		     Targets->begin())) {
+	return it->second.second;
       }
     }
     return nullptr;
@@ -340,16 +405,50 @@ namespace crab_llvm {
   
 
   DevirtualizeFunctions::DevirtualizeFunctions(llvm::CallGraph* /*cg*/,
-					       bool allowIndirectCalls)
+					       bool allowIndirectCalls,
+					       unsigned maxBounceTargets)
     : //m_cg(nullptr) 
       m_allowIndirectCalls(allowIndirectCalls)
+      , m_maxBounceTargets(maxBounceTargets)
       , m_num_indirect_calls(0)
-      , m_num_resolved_calls(0) { }
+      , m_num_resolved_calls(0)
+      , m_num_havoc_calls(0) { }
 
   DevirtualizeFunctions::~DevirtualizeFunctions() {
     errs() << "=== Devirtualization stats===\n";
     errs() << "BRUNCH_STAT INDIRECT CALLS " << m_num_indirect_calls << "\n";
     errs() << "BRUNCH_STAT RESOLVED CALLS " << m_num_resolved_calls << "\n";
+    if (m_maxBounceTargets > 0) {
+      errs() << "BRUNCH_STAT HAVOC CALLS " << m_num_havoc_calls << "\n";
+    }
+  }
+
+  /// Return the type of the bounce function for CS: same as the
+  /// called function but with the function pointer as first argument.
+  static FunctionType* getBounceType(CallSite &CS) {
+    Value* ptr = CS.getCalledValue();
+    SmallVector<Type*, 8> TP;
+    TP.push_back (ptr->getType ());
+    for (auto i = CS.arg_begin(), e = CS.arg_end (); i != e; ++i) 
+      TP.push_back ((*i)->getType());
+    return FunctionType::get (CS.getType(), TP, false);
+  }
+  
+  Function* DevirtualizeFunctions::mkHavocFn(CallSite &CS) {
+    FunctionType* NewTy = getBounceType(CS);
+    auto it = m_havoc_map.find(NewTy);
+    if (it != m_havoc_map.end()) {
+      return it->second;
+    }
+    // -- a declaration: the analysis treats calls to it as calls to
+    // -- an external function
+    Module * M = CS.getInstruction()->getParent()->getParent()->getParent();
+    Function* F = Function::Create (NewTy,
+                                    GlobalValue::ExternalLinkage,
+                                    "seahorn.bounce.havoc",
+                                    M);
+    m_havoc_map.insert({NewTy, F});
+    return F;
   }
   
   Function* DevirtualizeFunctions::mkBounceFn(CallSite &CS, CallSiteResolver* CSR) {
@@ -366,6 +465,14 @@ namespace crab_llvm {
       return nullptr;
     }
 
+    if (m_maxBounceTargets > 0 && Targets->size() > m_maxBounceTargets) {
+      DEVIRT_WARNING(errs() << "WARNING Devirt: " << *(CS.getInstruction())
+		            << " has " << Targets->size() << " targets. "
+		            << "Replaced with a call to an external function\n";);
+      m_num_havoc_calls++;
+      return mkHavocFn(CS);
+    }
+
     DEVIRT_LOG(errs() << *CS.getInstruction() << "\n";
 	       errs() << "Possible targets:\n";
 	       for(const Function* F: *Targets) {
@@ -377,18 +484,22 @@ namespace crab_llvm {
     // that it will have an additional pointer argument at the
     // beginning of its argument list that will be the function to
     // call.
-    Value* ptr = CS.getCalledValue();
-    SmallVector<Type*, 8> TP;
-    TP.push_back (ptr->getType ());
-    for (auto i = CS.arg_begin(), e = CS.arg_end (); i != e; ++i) 
-      TP.push_back ((*i)->getType());
-    
-    FunctionType* NewTy = FunctionType::get (CS.getType(), TP, false);
+    FunctionType* NewTy = getBounceType(CS);
     Module * M = CS.getInstruction()->getParent()->getParent()->getParent();
     assert (M);
+    // -- callsites that are not cached by the resolver (e.g., with
+    // -- the same dsa targets) can still share the bounce function
+    std::string name = getBounceName(NewTy, *Targets);
+    if (Function* bounce = M->getFunction(name)) {
+      if (bounce->getFunctionType() == NewTy && !bounce->isDeclaration() &&
+	  isBounceFor(*bounce, *Targets, m_allowIndirectCalls)) {
+	CSR->cacheBounceFunction(CS, bounce);
+	return bounce;
+      }
+    }
     Function* F = Function::Create (NewTy,
                                     GlobalValue::InternalLinkage,
-                                    "seahorn.bounce",
+                                    name,
                                     M);
     
     // Set the names of the arguments.  Also, record the arguments in a vector
@@ -18,7 +18,12 @@ DevirtResolver("devirt-resolver",
       cl::values 
       (clEnumValN(crab_llvm::RESOLVER_TYPES, "types", "Callees with same type"),
        clEnumValN(crab_llvm::RESOLVER_DSA  , "dsa"  , "DSA selects the potential callees"),
-       clEnumValEnd), cl::init(crab_llvm::RESOLVER_TYPES));
+       clEnumValEnd),
+#ifdef HAVE_DSA
+      cl::init(crab_llvm::RESOLVER_DSA));
+#else
+      cl::init(crab_llvm::RESOLVER_TYPES));
+#endif
 		   
 static llvm::cl::opt<bool>
 AllowIndirectCalls("devirt-allow-indirect-calls",
@@ -40,6 +45,12 @@ MaxNumTargets("devirt-max-num-targets",
 	      llvm::cl::desc("Do not resolve if number of targets is greater than this number."),
 	      llvm::cl::init(9999));
 
+static llvm::cl::opt<unsigned>
+MaxBounceTargets("devirt-max-bounce-targets",
+	      llvm::cl::desc("Replace with a call to an external function the indirect calls "
+			     "with more targets than this number (0 means unlimited)"),
+	      llvm::cl::init(0));
+
 using namespace llvm;
 
 namespace crab_llvm {
@@ -55,7 +66,7 @@ namespace crab_llvm {
       // -- Get the call graph: unused for now
       // CallGraph* CG = &(getAnalysis<CallGraphWrapperPass> ().getCallGraph ());
       
-      DevirtualizeFunctions DF(/*CG*/ nullptr, AllowIndirectCalls);
+      DevirtualizeFunctions DF(/*CG*/ nullptr, AllowIndirectCalls, MaxBounceTargets);
       std::unique_ptr<CallSiteResolver> CSR;
       switch(DevirtResolver) {
 #ifdef HAVE_DSA
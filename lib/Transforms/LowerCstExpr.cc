@@ -4,7 +4,8 @@
 #include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
-#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 
 namespace crab_llvm {
   
@@ -13,8 +14,8 @@ namespace crab_llvm {
   class LowerCstExpr: public ModulePass {
     
     ConstantExpr* hasCstExpr(Value *V) {
-      // We only handle top-level constant expressions ignoring
-      // constant subexpressions
+      // Only top-level constant expressions: constant subexpressions
+      // are lowered together with their parent
       if (Constant * cst = dyn_cast<Constant>(V)) {
         if (ConstantExpr * ce = dyn_cast<ConstantExpr>(cst)) {
           return ce;
@@ -23,52 +24,74 @@ namespace crab_llvm {
       return nullptr;
     }
 
+    // Lowered constant expressions indexed by the block where they
+    // were inserted. A lowered instruction is inserted before its
+    // first use in the block so it dominates the next uses.
+    typedef std::pair<ConstantExpr*, BasicBlock*> cst_expr_key_t;
+    DenseMap<cst_expr_key_t, Instruction*> m_lowered;
+    
+    // Lower CstExp (and its constant subexpressions) before
+    // InsertionLoc or reuse the instruction already lowered in the
+    // same block.
     Instruction * lowerCstExpr(ConstantExpr* CstExp, 
                                Instruction* InsertionLoc) {
+      BasicBlock *BB = InsertionLoc->getParent();
+      auto it = m_lowered.find(std::make_pair(CstExp, BB));
+      if (it != m_lowered.end()) {
+        return it->second;
+      }
+      
       Instruction* NewI = CstExp->getAsInstruction ();
+      // subexpressions are lowered bottom-up before NewI
+      for (unsigned int i=0; i < NewI->getNumOperands(); ++i) {
+        if (ConstantExpr* SubExp = hasCstExpr (NewI->getOperand(i))) {
+          NewI->setOperand (i, lowerCstExpr (SubExp, InsertionLoc));
+        }
+      }
       // insert before
-      InsertionLoc->getParent()->getInstList().insert(InsertionLoc->getIterator(), NewI); 
+      BB->getInstList().insert(InsertionLoc->getIterator(), NewI); 
+      m_lowered.insert(std::make_pair(std::make_pair(CstExp, BB), NewI));
       return NewI;
     }
         
     bool runOnFunction(Function & F) {
-      SmallPtrSet<Instruction*, 8> worklist;
+      m_lowered.clear();
+      SmallVector<Instruction*, 16> worklist;
+      SmallVector<PHINode*, 8> phis;
       for (inst_iterator It = inst_begin(F), E = inst_end(F); It != E; ++It) {
         Instruction *I = &*It;
         for (unsigned int i=0; i < I->getNumOperands(); ++i) {
-          if (hasCstExpr (I->getOperand(i))) 
-            worklist.insert (I);
+          if (hasCstExpr (I->getOperand(i))) {
+            if (PHINode * PHI = dyn_cast<PHINode>(I)) {
+              phis.push_back (PHI);
+            } else {
+              worklist.push_back (I);
+            }
+            break;
+          }
         }
       }
       
-      bool change = !worklist.empty ();
-      while (!worklist.empty()) {
-        auto It = worklist.begin ();
-        Instruction*I = *It;
-        worklist.erase (*It);
-        
-        if (PHINode * PHI = dyn_cast<PHINode>(I)) {
-          for (unsigned int i = 0; i < PHI->getNumIncomingValues (); ++i) {
+      bool change = !worklist.empty () || !phis.empty ();
+      // -- instructions are visited in program order so the lowered
+      //    instruction reused in a block is always before the use.
+      for (Instruction *I: worklist) {
+        for (unsigned int i=0; i < I->getNumOperands (); ++i) {
+          if (ConstantExpr* CstExp = hasCstExpr (I->getOperand(i))) {
+            Instruction * NewInst = lowerCstExpr (CstExp, I);
+            I->replaceUsesOfWith (CstExp, NewInst);
+          }
+        }
+      }
+      // -- phi nodes are done last: the incoming value is lowered at
+      //    the end of the incoming block so any instruction already
+      //    lowered in that block can be reused.
+      for (PHINode *PHI: phis) {
+        for (unsigned int i = 0; i < PHI->getNumIncomingValues (); ++i) {
+          if (ConstantExpr * CstExp = hasCstExpr (PHI->getIncomingValue(i))) {
             Instruction* InsertLoc = PHI->getIncomingBlock (i)->getTerminator ();        
             assert(InsertLoc);
-            if (ConstantExpr * CstExp = hasCstExpr (PHI->getIncomingValue(i))) {
-              Instruction* NewInst = lowerCstExpr (CstExp, InsertLoc);
-              for (unsigned int j=i; j < PHI->getNumIncomingValues(); j++) {
-                if ( (PHI->getIncomingValue (j) == PHI->getIncomingValue (i)) &&
-                     (PHI->getIncomingBlock (j) == PHI->getIncomingBlock (i))) {
-                  PHI->setIncomingValue (j, NewInst);
-                }
-              }
-              worklist.insert (NewInst);
-            }
-          }
-        } else { 
-          for (unsigned int i=0; i < I->getNumOperands (); ++i) {
-            if (ConstantExpr* CstExp = hasCstExpr (I->getOperand(i))) {
-              Instruction * NewInst = lowerCstExpr (CstExp, I);
-              I->replaceUsesOfWith (CstExp, NewInst);
-              worklist.insert (NewInst);
-            }
+            PHI->setIncomingValue (i, lowerCstExpr (CstExp, InsertLoc));
           }
         }
       }
@@ -20,7 +20,8 @@
  * }
  * 
  * Note: initializers can be partially lowered if they get too complex
- * for analysis.
+ * for analysis. Arrays of aggregates are lowered by initializing only
+ * their first element.
  * 
  */
 
@@ -30,6 +31,7 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Transforms/Utils/GlobalStatus.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/SmallSet.h"
@@ -40,6 +42,13 @@
 
 using namespace llvm;
 
+static cl::opt<unsigned>
+LowerGvMaxCalls("crab-lower-gv-max-calls",
+		cl::desc("Do not lower the initializer of a global variable if it "
+			 "requires more initialization calls than this number "
+			 "(0 means unlimited)"),
+		cl::init(0));
+
 //#define DEBUG_LOWER_GV
 
 #define DEBUG_TYPE "lower-gv"
@@ -179,6 +188,14 @@ namespace crab_llvm {
 
 	  CreateZeroInitializerCallSite(base, stack, Builder, LLVMUsed, M);	  
 	  change = true;
+	} else if (ATy->getNumElements() > 0 &&
+		   (ATy->getElementType()->isStructTy() ||
+		    ATy->getElementType()->isArrayTy())) {
+	  // All the elements of an array are in the same memory
+	  // regions so it is enough to initialize the first one.
+	  stack.push_back(0);
+	  change |= LowerZeroInitializer(ATy->getElementType(), base, Builder, M,
+					 LLVMUsed, stack);
 	} else {
 	  //llvm::errs () << "CRABLLVM WARNING: skipped initialization of " << *ATy << "\n";
 	}
@@ -204,6 +221,29 @@ namespace crab_llvm {
       return change;
     }
 
+    /// Return the number of calls that LowerZeroInitializer(T)
+    /// would create.
+    static uint64_t countZeroInitializerCalls(Type *T) {
+      if (isa<IntegerType>(T) || isa<PointerType>(T)) {
+	return 1;
+      } else if (StructType *STy = dyn_cast<StructType>(T)) {
+	uint64_t n = 0;
+	for (unsigned i=0; i < STy->getNumElements(); i++) {
+	  n += countZeroInitializerCalls(STy->getElementType(i));
+	}
+	return n;
+      } else if (ArrayType *ATy = dyn_cast<ArrayType>(T)) {
+	if (ATy->getElementType()->isIntegerTy()) {
+	  return 1;
+	} else if (ATy->getNumElements() > 0 &&
+		   (ATy->getElementType()->isStructTy() ||
+		    ATy->getElementType()->isArrayTy())) {
+	  return countZeroInitializerCalls(ATy->getElementType());
+	}
+      }
+      return 0;
+    }
+    
     /// C may have non-instruction users. Can all of those users be turned into
     /// instructions?
     static bool allNonInstructionUsersCanBeMadeInstructions(Constant *C) {
@@ -343,6 +383,11 @@ namespace crab_llvm {
 	  }
 	  change = true;
 	} else if (isa<ConstantAggregateZero>(gv->getInitializer())) {
+	  if (LowerGvMaxCalls > 0 &&
+	      countZeroInitializerCalls(gv->getInitializer()->getType()) > LowerGvMaxCalls) {
+	    // -- too large: the analysis will not know its initial contents
+	    continue;
+	  }
 	  std::vector<uint64_t> stack = {0};
 	  change |= LowerZeroInitializer(gv->getInitializer()->getType(), *gv,
 					 Builder, M, MergedVars, stack);
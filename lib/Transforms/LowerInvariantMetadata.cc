@@ -0,0 +1,128 @@
+/*
+ * Lower the invariants attached as !crab.inv metadata by
+ * --crab-add-invariants-metadata (see Support/InvariantMetadata.hh)
+ * to verifier.assume instructions. Each call to crab.inv is replaced
+ * with the computation of its constraints and the verifier.assume
+ * calls on them, in the same way that --crab-add-invariants inserts
+ * them directly.
+ */
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "crab_llvm/Support/InvariantMetadata.hh"
+
+#include <vector>
+
+using namespace llvm;
+
+namespace crab_llvm
+{
+
+  struct LowerInvariantMetadata : public ModulePass
+  {
+    static char ID;
+    Function* m_assumeFn;
+
+    LowerInvariantMetadata () : ModulePass (ID), m_assumeFn (0) {}
+
+    static int64_t getInt (const Metadata *md) {
+      return mdconst::extract<ConstantInt> (md)->getSExtValue ();
+    }
+
+    // Insert before CI the verifier.assume of the constraint cst
+    void lowerConstraint (CallInst *CI, const MDNode *cst, IRBuilder<> &B) {
+      LLVMContext &ctx = CI->getContext ();
+      Type *i64 = Type::getInt64Ty (ctx);
+      StringRef kind = cast<MDString> (cst->getOperand (0))->getString ();
+      Value *k = ConstantInt::get (i64, getInt (cst->getOperand (1)), true);
+      // -- the operands are extended as InsertInvariants does
+      Value *e = ConstantInt::get (i64, 0);
+      for (unsigned i = 2; i + 1 < cst->getNumOperands (); i += 2) {
+	Value *v = CI->getArgOperand (getInt (cst->getOperand (i)));
+	int64_t coeff = getInt (cst->getOperand (i + 1));
+	v = B.CreateZExtOrBitCast (v, i64, "crab_");
+	if (coeff == 1) {
+	  e = B.CreateAdd (e, v, "crab_");
+	} else if (coeff == -1) {
+	  e = B.CreateSub (e, v, "crab_");
+	} else {
+	  e = B.CreateAdd (e, B.CreateMul (ConstantInt::get (i64, coeff, true), v, "crab_"),
+			   "crab_");
+	}
+      }
+      Value *cond = nullptr;
+      if (kind == inv_metadata::le ()) {
+	cond = B.CreateICmpSLE (e, k, "crab_");
+      } else if (kind == inv_metadata::eq ()) {
+	cond = B.CreateICmpEQ (e, k, "crab_");
+      } else {
+	cond = B.CreateICmpNE (e, k, "crab_");
+      }
+      B.CreateCall (m_assumeFn, cond);
+    }
+
+    virtual bool runOnModule (Module &M)
+    {
+      Function *invFn = M.getFunction (inv_metadata::markerName ());
+      if (!invFn) return false;
+
+      LLVMContext& ctx = M.getContext ();
+      AttrBuilder AB;
+      AttributeSet as = AttributeSet::get (ctx,
+                                           AttributeSet::FunctionIndex,
+                                           AB);
+      m_assumeFn = dyn_cast<Function>
+          (M.getOrInsertFunction ("verifier.assume",
+                                  as,
+                                  Type::getVoidTy (ctx),
+                                  Type::getInt1Ty (ctx),
+                                  NULL));
+
+      std::vector<CallInst*> calls;
+      for (User *U : invFn->users ()) {
+	if (CallInst *CI = dyn_cast<CallInst> (U))
+	  calls.push_back (CI);
+      }
+
+      IRBuilder<> B (ctx);
+      for (CallInst *CI : calls) {
+	B.SetInsertPoint (CI);
+	if (MDNode *csts = CI->getMetadata (inv_metadata::kindName ())) {
+	  for (const MDOperand &op : csts->operands ()) {
+	    lowerConstraint (CI, cast<MDNode> (op), B);
+	  }
+	}
+	CI->eraseFromParent ();
+      }
+      if (invFn->use_empty ())
+	invFn->eraseFromParent ();
+      return true;
+    }
+
+    // It might not preserve the call graph ...
+    void getAnalysisUsage (AnalysisUsage &AU) const {
+      //AU.setPreservesAll ();
+    }
+
+    virtual const char * getPassName() const {
+      return "Lower invariant metadata to assume instructions";
+    }
+  };
+
+  char crab_llvm::LowerInvariantMetadata::ID = 0;
+  Pass* createLowerInvariantMetadataPass () {
+    return new LowerInvariantMetadata ();
+  }
+
+} // end namespace
+
+static llvm::RegisterPass<crab_llvm::LowerInvariantMetadata>
+X ("lower-crab-inv-metadata",
+   "Lower invariants attached as crab.inv metadata to verifier.assume");
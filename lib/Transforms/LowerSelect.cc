@@ -6,6 +6,10 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SCCIterator.h"
 #include "llvm/Support/Debug.h"
 
 #include <vector>
@@ -20,6 +24,55 @@ namespace crab_llvm
 
   class LowerSelect: public FunctionPass 
   {
+    // Lower only the select instructions whose precision matters
+    bool m_only_relevant;
+
+    static bool isAssertFn(const Function *F) {
+      return (F->getName().equals("verifier.assert") || 
+	      F->getName().equals("crab.assert") || 
+	      F->getName().equals("__CRAB_assert"));
+    }
+    
+    // Return the select instructions that flow into an assertion or
+    // into the condition of a branch inside a loop. The analysis
+    // joins the two values of the other selects, which is cheaper
+    // than joining two new blocks.
+    DenseSet<SelectInst*> getRelevantSelects(Function &F)
+    {
+      std::vector<Value*> worklist;
+      // -- conditions of branches inside loops
+      for (auto it = scc_begin(&F); !it.isAtEnd(); ++it) {
+	if (!it.hasLoop()) continue;
+	for (BasicBlock *B: *it) {
+	  BranchInst *BI = dyn_cast<BranchInst>(B->getTerminator());
+	  if (BI && BI->isConditional()) worklist.push_back(BI->getCondition());
+	}
+      }
+      // -- arguments of assertions
+      for (inst_iterator It = inst_begin(F), E = inst_end(F); It != E; ++It) {
+	CallSite CS(&*It);
+	if (!CS) continue;
+	const Function *callee = CS.getCalledFunction();
+	if (callee && isAssertFn(callee)) {
+	  worklist.insert(worklist.end(), CS.arg_begin(), CS.arg_end());
+	}
+      }
+      
+      // -- backward slice through the operands
+      DenseSet<Value*> visited;
+      DenseSet<SelectInst*> res;
+      while (!worklist.empty()) {
+	Value *V = worklist.back();
+	worklist.pop_back();
+	Instruction *I = dyn_cast<Instruction>(V);
+	if (!I || !visited.insert(I).second) continue;
+	if (isa<LoadInst>(I) || isa<CallInst>(I)) continue;
+	if (SelectInst *SI = dyn_cast<SelectInst>(I)) res.insert(SI);
+	for (Value *Op: I->operands()) worklist.push_back(Op);
+      }
+      return res;
+    }
+    
     // Lower the select instruction into three new blocks.
     void processSelectInst(SelectInst *SI)
     {
@@ -79,13 +132,16 @@ namespace crab_llvm
     
     static char ID;   
 
-    LowerSelect(): FunctionPass(ID){ }    
+    LowerSelect(bool only_relevant = false)
+      : FunctionPass(ID), m_only_relevant(only_relevant) { }    
 
     virtual bool runOnFunction(Function &F)
     {
       
       std::vector<SelectInst *> worklist;
       bool modified=false;
+      DenseSet<SelectInst*> relevant;
+      if (m_only_relevant) relevant = getRelevantSelects(F);
       // Initialization of the worklist with all select instructions from
       // the function
       for (inst_iterator It = inst_begin(F), E = inst_end(F); It != E; ++It)
@@ -99,7 +155,8 @@ namespace crab_llvm
             // note that the flag can be a vector of Boolean
             assert(false);
           }
-          worklist.push_back(SI);
+          if (!m_only_relevant || relevant.count(SI) > 0)
+            worklist.push_back(SI);
         }
       } 
       
@@ -125,7 +182,9 @@ namespace crab_llvm
   };
 
   char LowerSelect::ID = 0;
-  Pass* createLowerSelectPass () { return new LowerSelect (); }
+  Pass* createLowerSelectPass (bool only_relevant) {
+    return new LowerSelect (only_relevant);
+  }
 
 } // end namespace
 
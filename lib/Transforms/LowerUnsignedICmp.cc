@@ -1,5 +1,9 @@
 /**
  *  Replace ULT and ULE comparison instructions with SLT and SLE.
+ *
+ *  If both operands are known to be non-negative the predicate is
+ *  replaced in place. Otherwise, new blocks check the sign of the
+ *  operands.
  **/
 
 #include "llvm/Pass.h"
@@ -7,6 +11,8 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/Support/Debug.h"
@@ -39,6 +45,37 @@ namespace crab_llvm {
     return false;
   }
 
+  // Return true if V is an induction variable that starts at a
+  // non-negative value and it is incremented by a non-negative
+  // constant without signed overflow.
+  static bool isNonNegInductionVar(PHINode *PHI, const DataLayout &DL) {
+    for (Value *V : PHI->incoming_values()) {
+      if (auto *Add = dyn_cast<OverflowingBinaryOperator>(V)) {
+	if (Add->getOpcode() == Instruction::Add && Add->hasNoSignedWrap() &&
+	    Add->getOperand(0) == PHI && isNonNegIntCst(Add->getOperand(1))) {
+	  continue;
+	}
+      }
+      bool KnownZero = false, KnownOne = false;
+      ComputeSignBit(V, KnownZero, KnownOne, DL);
+      if (!KnownZero) return false;
+    }
+    return true;
+  }
+  
+  // Cheap check that is enough for zext, masks, shifts and induction
+  // variables counting up from zero.
+  static bool isKnownNonNeg(Value *V, const DataLayout &DL) {
+    if (isNonNegIntCst(V)) return true;
+    bool KnownZero = false, KnownOne = false;
+    ComputeSignBit(V, KnownZero, KnownOne, DL);
+    if (KnownZero) return true;
+    if (PHINode *PHI = dyn_cast<PHINode>(V)) {
+      return isNonNegInductionVar(PHI, DL);
+    }
+    return false;
+  }
+  
   static void normalizeCmpInst(CmpInst *I) {
     switch (I->getPredicate()){
       case ICmpInst::ICMP_UGT:	
@@ -54,6 +91,7 @@ namespace crab_llvm {
   }
   
   STATISTIC(totalUnsignedICmpLowered, "Number of Lowered ULT and ULE Instructions");
+  STATISTIC(totalUnsignedICmpInPlace, "Number of ULT and ULE Instructions replaced in place");
 
   class LowerUnsignedICmp: public FunctionPass {
 
@@ -244,10 +282,18 @@ namespace crab_llvm {
       }
 
       bool change = !worklist.empty();
+      const DataLayout &DL = F.getParent()->getDataLayout();
       while (!worklist.empty())  {
         ICmpInst  *CI = worklist.back();
         worklist.pop_back();
-        processUnsignedICmp(CI);
+	if (isKnownNonNeg(CI->getOperand(0), DL) &&
+	    isKnownNonNeg(CI->getOperand(1), DL)) {
+	  // -- signed and unsigned comparisons are equivalent
+	  CI->setPredicate(CI->getSignedPredicate());
+	  totalUnsignedICmpInPlace++;
+	} else {
+	  processUnsignedICmp(CI);
+	}
       }
 
       //llvm::errs () << F << "\n";
@@ -1,21 +1,114 @@
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SCCIterator.h"
 
 using namespace llvm;
 
 namespace crab_llvm {
 
-  /// marks all internal functions with AlwaysInline attribute
+  /// marks internal functions with AlwaysInline attribute
+  ///
+  /// If the budget is zero then all internal functions are
+  /// marked. Otherwise, the decision is driven by the cost of the
+  /// analysis rather than by the runtime performance: a function is
+  /// inlined if it is small, if it has a single callsite or if it has
+  /// assertions (they are checked for each calling context), as long
+  /// as the callers do not exceed budget instructions. Larger
+  /// functions would exceed relational thresholds and lose the
+  /// precision that inlining was supposed to gain.
   struct MarkInternalInline : public ModulePass
   {
     static char ID;
-    MarkInternalInline () : ModulePass (ID) {}
-    
+    unsigned m_budget;
+
+    MarkInternalInline (unsigned budget = 0) : ModulePass (ID), m_budget (budget) {}
+
     void getAnalysisUsage (AnalysisUsage &AU) const
     {AU.setPreservesAll ();}
-    
+
+    static bool isAssertFn (const Function *F)
+    {
+      return (F->getName ().equals ("verifier.assert") ||
+	      F->getName ().equals ("crab.assert") ||
+	      F->getName ().equals ("__CRAB_assert"));
+    }
+
+    bool isCandidate (const Function &F) const
+    {
+      return !F.isDeclaration () && F.hasLocalLinkage () && !F.isVarArg ();
+    }
+
+    // Mark the functions whose inlining is cheap for the analysis.
+    // The call graph is traversed bottom-up so the size of a
+    // function includes the functions already inlined into it.
+    void markWithBudget (Module &M)
+    {
+      DenseMap<const Function*, unsigned> size;
+      DenseMap<const Function*, bool> has_assert;
+      // direct callsites of each function per caller
+      DenseMap<const Function*, DenseMap<const Function*, unsigned>> callsites;
+      for (Function &F : M)
+      {
+	if (F.isDeclaration ()) continue;
+	unsigned n = 0;
+	for (auto &I : instructions (&F))
+	{
+	  n++;
+	  CallSite CS (&I);
+	  if (!CS) continue;
+	  if (const Function *callee = CS.getCalledFunction ())
+	  {
+	    if (isAssertFn (callee)) has_assert[&F] = true;
+	    callsites[callee][&F]++;
+	  }
+	}
+	size[&F] = n;
+      }
+
+      // small functions are inlined regardless of their callsites
+      const unsigned small = std::max (1U, m_budget / 20);
+      CallGraph cg (M);
+      for (auto it = scc_begin (&cg); !it.isAtEnd (); ++it)
+      {
+	// -- recursive functions are not inlined
+	if (it.hasLoop ()) continue;
+	Function *F = (*it).front ()->getFunction ();
+	if (!F || !isCandidate (*F)) continue;
+	auto &callers = callsites[F];
+	if (callers.empty ()) continue;
+
+	unsigned num_callsites = 0;
+	bool fits = true;
+	for (auto &kv : callers)
+	{
+	  num_callsites += kv.second;
+	  fits &= (size[kv.first] + kv.second * size[F] <= m_budget);
+	}
+	if (!fits) continue;
+	if (size[F] <= small || num_callsites == 1 ||
+	    (has_assert[F] && num_callsites * size[F] <= m_budget))
+	{
+	  F->addFnAttr (Attribute::AlwaysInline);
+	  for (auto &kv : callers)
+	  {
+	    size[kv.first] += kv.second * size[F];
+	    if (has_assert[F]) has_assert[kv.first] = true;
+	  }
+	}
+      }
+    }
+
     bool runOnModule (Module &M)
     {
+      if (m_budget > 0)
+      {
+	markWithBudget (M);
+	return true;
+      }
       for (Function &F : M)
         if (!F.isDeclaration () && F.hasLocalLinkage ())
           F.addFnAttr (Attribute::AlwaysInline);
@@ -25,9 +118,11 @@ namespace crab_llvm {
     virtual const char * getPassName() const {
       return "Mark internal functions with AlwaysInline attribute";
     }
-    
+
   };
 
-  char MarkInternalInline::ID = 0;  
-  Pass* createMarkInternalInlinePass () { return new MarkInternalInline (); }
+  char MarkInternalInline::ID = 0;
+  Pass* createMarkInternalInlinePass (unsigned budget) {
+    return new MarkInternalInline (budget);
+  }
 }
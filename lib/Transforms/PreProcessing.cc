@@ -0,0 +1,316 @@
+#include "llvm/LinkAllPasses.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/IPO.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/Passes.hh"
+#include "crab_llvm/Transforms/PreProcessing.hh"
+
+#ifdef HAVE_LLVM_SEAHORN
+#include "llvm_seahorn/Transforms/Scalar.h"
+#endif 
+
+namespace crab_llvm {
+
+static const char *normalized_flag = "crab-llvm.normalized";
+
+unsigned getPreProcessingNormalizations(const PreProcessingOptions &opts) {
+  unsigned norms = NORM_ALL & ~NORM_UNDEF_NONDET;
+  #ifdef HAVE_LLVM_SEAHORN
+  if (opts.turn_undef_nondet)
+    norms |= NORM_UNDEF_NONDET;
+  #endif
+  return norms;
+}
+
+unsigned getNormalizations(const llvm::Module &M) {
+  auto *val = llvm::mdconst::extract_or_null<llvm::ConstantInt>
+    (M.getModuleFlag(normalized_flag));
+  return val ? (unsigned) val->getZExtValue() : 0;
+}
+
+void setNormalizations(llvm::Module &M, unsigned norms) {
+  llvm::LLVMContext &ctx = M.getContext();
+  llvm::Type *i32 = llvm::Type::getInt32Ty(ctx);
+  if (llvm::NamedMDNode *flags = M.getModuleFlagsMetadata()) {
+    // -- module flags must be unique so replace the old one if any
+    for (unsigned i = 0, e = flags->getNumOperands(); i < e; ++i) {
+      llvm::MDNode *flag = flags->getOperand(i);
+      auto *key = llvm::dyn_cast_or_null<llvm::MDString>(flag->getOperand(1));
+      if (!key || key->getString() != normalized_flag) continue;
+      llvm::Metadata *ops[3] = {
+	flag->getOperand(0),
+	key,
+	llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(i32, norms))};
+      flags->setOperand(i, llvm::MDNode::get(ctx, ops));
+      return;
+    }
+  }
+  M.addModuleFlag(llvm::Module::Warning, normalized_flag, norms);
+}
+
+namespace {
+  // Record the normalizations applied by the crabllvm-pp pipeline
+  struct MarkNormalized: public llvm::ModulePass {
+    static char ID;
+    unsigned m_norms;
+    
+    MarkNormalized(unsigned norms = 0)
+      : llvm::ModulePass(ID), m_norms(norms) {}
+
+    virtual bool runOnModule(llvm::Module &M) override {
+      unsigned norms = getNormalizations(M) | m_norms;
+      if (norms == getNormalizations(M)) return false;
+      setNormalizations(M, norms);
+      return true;
+    }
+
+    virtual void getAnalysisUsage(llvm::AnalysisUsage &AU) const override {
+      AU.setPreservesAll();
+    }
+
+    virtual const char* getPassName() const override {
+      return "CrabLlvm: mark module as normalized";
+    }
+  };
+  char MarkNormalized::ID = 0;
+}
+
+static void break_allocas(llvm::legacy::PassManager &pass_manager,
+			    const PreProcessingOptions &opts) {
+    #ifdef HAVE_LLVM_SEAHORN
+    // -- can remove bitcast from bitcast(alloca(...))
+    pass_manager.add(llvm_seahorn::createInstructionCombiningPass());
+    #endif     
+    pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
+    // -- break alloca's into scalars
+    pass_manager.add(llvm::createScalarReplAggregatesPass
+    		     (opts.sroa_threshold,
+    		       true,
+    		       opts.sroa_struct_mem_threshold,
+    		       opts.sroa_array_element_threshold,
+    		       opts.sroa_scalar_load_threshold));
+    #ifdef HAVE_LLVM_SEAHORN
+    if (opts.turn_undef_nondet) {
+      // -- Turn undef into nondet (undef are created by SROA when it calls mem2reg)
+      pass_manager.add(llvm_seahorn::createNondetInitPass());
+    }
+    #endif
+}
+
+// Interprocedural passes that run before the others
+static void addModulePrefixPasses(llvm::legacy::PassManager &pass_manager,
+				  const PreProcessingOptions &opts) {
+  // -- promote top-level mallocs to alloca
+  pass_manager.add(crab_llvm::createPromoteMallocPass());  
+
+  // -- turn all functions internal so that we can apply some global
+  // -- optimizations inline them if requested
+  if (opts.export_list.empty())
+    pass_manager.add(llvm::createInternalizePass(llvm::ArrayRef<const char*>("main")));
+  else
+    pass_manager.add(llvm::createInternalizePass(opts.export_list));
+
+  if (opts.devirtualize) {
+    // -- resolve indirect calls
+    pass_manager.add(crab_llvm::createDevirtualizeFunctionsPass());
+  }
+  
+ if (opts.externalize_addr_taken_funcs) {
+    // -- externalize uses of address-taken functions
+    pass_manager.add(crab_llvm::createExternalizeAddressTakenFunctionsPass());
+  }
+  
+  // kill unused internal global    
+  pass_manager.add(llvm::createGlobalDCEPass()); 
+  pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
+  // -- global optimizations
+  pass_manager.add(llvm::createGlobalOptimizerPass());
+
+  if (opts.lower_gv) {
+    // -- lower initializers of global variables
+    pass_manager.add(crab_llvm::createLowerGvInitializersPass());   
+  }
+}
+
+// Passes that transform each function independently, before the
+// inliner
+static void addScalarPasses(llvm::legacy::PassManager &pass_manager,
+			    const PreProcessingOptions &opts) {
+  // -- SSA
+  pass_manager.add(llvm::createPromoteMemoryToRegisterPass());
+  #ifdef HAVE_LLVM_SEAHORN
+  if (opts.turn_undef_nondet) {
+    // -- Turn undef into nondet
+    pass_manager.add(llvm_seahorn::createNondetInitPass());
+  }
+  #endif 
+
+  // -- cleanup after SSA
+  #ifdef HAVE_LLVM_SEAHORN
+  pass_manager.add(llvm_seahorn::createInstructionCombiningPass());
+  #endif 
+  pass_manager.add(llvm::createCFGSimplificationPass());
+  break_allocas(pass_manager, opts);
+  // // -- break aggregates
+  // pass_manager.add(llvm::createScalarReplAggregatesPass
+  // 		    (opts.sroa_threshold,
+  // 		     true,
+  // 		     opts.sroa_struct_mem_threshold,
+  // 		     opts.sroa_array_element_threshold,
+  // 		     opts.sroa_scalar_load_threshold));
+  
+  // #ifdef HAVE_LLVM_SEAHORN
+  // if (opts.turn_undef_nondet) {
+  //    // -- Turn undef into nondet (undef are created by SROA when it calls mem2reg)
+  //    pass_manager.add(llvm_seahorn::createNondetInitPass());
+  // }
+  // #endif
+
+  // -- global value numbering and redundant load elimination
+  pass_manager.add(llvm::createGVNPass());
+  
+  // -- cleanup after break aggregates
+  #ifdef HAVE_LLVM_SEAHORN
+  pass_manager.add(llvm_seahorn::createInstructionCombiningPass());
+  #endif 
+  pass_manager.add(llvm::createCFGSimplificationPass());
+  
+  #ifdef HAVE_LLVM_SEAHORN
+  if (opts.turn_undef_nondet) {
+     // eliminate unused calls to verifier.nondet() functions
+     pass_manager.add(llvm_seahorn::createDeadNondetElimPass());
+  }
+  #endif 
+
+  // -- lower invoke's
+  pass_manager.add(llvm::createLowerInvokePass());
+  // cleanup after lowering invoke's
+  pass_manager.add(llvm::createCFGSimplificationPass());
+}
+
+static void addInliningPasses(llvm::legacy::PassManager &pass_manager,
+			      const PreProcessingOptions &opts) {
+  if (!needsInlining(opts)) return;
+  pass_manager.add(crab_llvm::createMarkInternalInlinePass
+		     (opts.inline_all ? 0 : opts.inline_budget));
+  pass_manager.add(llvm::createAlwaysInlinerPass());
+  // // after inlining we promote malloc to alloca instructions
+  // pass_manager.add(crab_llvm::createPromoteMallocPass());    
+  // // kill unused internal global    
+  // pass_manager.add(llvm::createGlobalDCEPass());
+  pass_manager.add(llvm::createGlobalDCEPass()); // kill unused internal global
+  // -- promote malloc to alloca
+  pass_manager.add(crab_llvm::createPromoteMallocPass());
+  pass_manager.add(llvm::createGlobalDCEPass()); // kill unused internal global
+  // XXX: for svcomp ssh programs we need to run twice to break all
+  // relevant allocas
+  break_allocas(pass_manager, opts);
+  break_allocas(pass_manager, opts);
+}
+
+// Passes that transform each function independently, after the
+// inliner, up to a single exit per function
+static void addCleanupPasses(llvm::legacy::PassManager &pass_manager,
+			     const PreProcessingOptions &opts) {
+  pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
+  pass_manager.add(llvm::createDeadInstEliminationPass());
+  
+  if (opts.optimize_loops) {
+    // canonical form for loops
+    pass_manager.add(llvm::createLoopSimplifyPass());
+    // cleanup unnecessary blocks     
+    pass_manager.add(llvm::createCFGSimplificationPass());  
+    // loop-closed SSA 
+    pass_manager.add(llvm::createLCSSAPass());
+    #ifdef HAVE_LLVM_SEAHORN
+    // induction variable
+    pass_manager.add(llvm_seahorn::createIndVarSimplifyPass());
+    #endif 
+  }
+
+  // trivial invariants outside loops 
+  pass_manager.add(llvm::createBasicAAWrapperPass());
+  pass_manager.add(llvm::createLICMPass()); //LICM needs alias analysis
+  pass_manager.add(llvm::createPromoteMemoryToRegisterPass());
+  // dead loop elimination
+  pass_manager.add(llvm::createLoopDeletionPass());
+  // cleanup unnecessary blocks   
+  pass_manager.add(llvm::createCFGSimplificationPass()); 
+  
+  // -- ensure one single exit point per function
+  pass_manager.add(llvm::createUnifyFunctionExitNodesPass());
+}
+
+// Passes that transform each function independently and lower the
+// remaining constructs
+static void addLoweringPasses(llvm::legacy::PassManager &pass_manager,
+			      const PreProcessingOptions &opts) {
+  pass_manager.add(llvm::createDeadCodeEliminationPass());
+  // -- remove unreachable blocks also dead cycles
+  pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
+
+  // -- remove switch constructions
+  pass_manager.add(llvm::createLowerSwitchPass());
+  // cleanup unnecessary blocks     
+  pass_manager.add(llvm::createCFGSimplificationPass());  
+  
+  // -- lower constant expressions to instructions
+  pass_manager.add(crab_llvm::createLowerCstExprPass());   
+  pass_manager.add(llvm::createDeadCodeEliminationPass());
+
+  // -- lower ULT and ULE instructions  
+  if(opts.lower_unsigned_icmp) {
+    pass_manager.add(crab_llvm::createLowerUnsignedICmpPass());   
+    // cleanup unnecessary and unreachable blocks   
+    pass_manager.add(llvm::createCFGSimplificationPass());
+    pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
+  }
+  
+  // -- must be the last one to avoid llvm undoing it
+  if (opts.lower_select)
+    pass_manager.add(crab_llvm::createLowerSelectPass());
+  else if (opts.lower_relevant_select)
+    pass_manager.add(crab_llvm::createLowerSelectPass(true));
+}
+
+bool needsInlining(const PreProcessingOptions &opts) {
+  return opts.inline_all || opts.inline_budget > 0;
+}
+
+void addPreProcessingPasses(llvm::legacy::PassManager &pass_manager,
+			    const PreProcessingOptions &opts) {
+  addModulePrefixPasses(pass_manager, opts);
+  addScalarPasses(pass_manager, opts);
+  addInliningPasses(pass_manager, opts);
+  addCleanupPasses(pass_manager, opts);
+  // kill unused internal global
+  pass_manager.add(llvm::createGlobalDCEPass()); 
+  addLoweringPasses(pass_manager, opts);
+  pass_manager.add(new MarkNormalized(getPreProcessingNormalizations(opts)));
+}
+
+void addPreProcessingModulePasses(llvm::legacy::PassManager &pass_manager,
+				  const PreProcessingOptions &opts) {
+  addModulePrefixPasses(pass_manager, opts);
+}
+
+void addPreProcessingFunctionPasses(llvm::legacy::PassManager &pass_manager,
+				    const PreProcessingOptions &opts) {
+  addScalarPasses(pass_manager, opts);
+  addCleanupPasses(pass_manager, opts);
+  addLoweringPasses(pass_manager, opts);
+}
+
+void addPreProcessingFinalPasses(llvm::legacy::PassManager &pass_manager,
+				 const PreProcessingOptions &opts) {
+  // kill unused internal global
+  pass_manager.add(llvm::createGlobalDCEPass()); 
+  pass_manager.add(new MarkNormalized(getPreProcessingNormalizations(opts)));
+}
+
+} // end namespace crab_llvm
@@ -1,4 +1,10 @@
-/* Simplify void verifier.assume(i1) instructions */
+/* 
+ * Simplify void verifier.assume(i1) instructions: assumptions on
+ * constants are removed (or turned into unreachable), repeated
+ * assumptions within a block are removed and, optionally, the rest
+ * are promoted to llvm.assume intrinsics. Everything is done in a
+ * single traversal of the function.
+ */
 
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
@@ -7,22 +13,41 @@
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/PatternMatch.h"
+#include "llvm/Transforms/Utils/Local.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/ADT/SmallPtrSet.h"
 
 using namespace llvm;
+using namespace llvm::PatternMatch;
 
 namespace crab_llvm
 {
 
+  /// Returns true if v is used by assume
+  static bool hasAssumeUsers (Value &v)
+  {
+    for (User *U : v.users ())
+      if (CallInst *ci = dyn_cast<CallInst> (U))
+        if (match (ci, m_Intrinsic<Intrinsic::assume>()))
+          return true;
+          
+    return false;
+  }
+
   struct SimplifyAssume : public ModulePass
   {
     static char ID;
     Function* m_assumeFn;
+    // promote verifier.assume to llvm.assume
+    bool m_promote;
+    unsigned m_mdKind;
 
-    SimplifyAssume () : ModulePass (ID), m_assumeFn (0) {}
+    SimplifyAssume (bool promote = false)
+      : ModulePass (ID), m_assumeFn (0), m_promote (promote), m_mdKind (0) {}
         
     virtual bool runOnModule (Module &M)
     {
@@ -37,6 +62,7 @@ namespace crab_llvm
                                   Type::getVoidTy (ctx),
                                   Type::getInt1Ty (ctx),
                                   NULL));
+      m_mdKind = M.getMDKindID ("crabllvm");
       
       bool change=false;
       for (auto &f : M) 
@@ -45,36 +71,90 @@ namespace crab_llvm
       return change;
     }
 
-    bool runOnFunction (llvm::Function &F)
+    // Return true if I is verifier.assume or verifier.assume.not
+    bool isAssume (Instruction &I, bool &negated) const
     {
-      if (F.isDeclaration () || F.empty ()) 
-        return false;
-      
-      IRBuilder<> Builder (F.getContext());
+      CallInst* CI = dyn_cast<CallInst> (&I);
+      if (!CI) return false;
+      Function *callee = CI->getCalledFunction ();
+      if (!callee) return false;
+      if (callee == m_assumeFn) {
+        negated = false;
+        return true;
+      }
+      if (callee->getName ().equals ("verifier.assume.not")) {
+        negated = true;
+        return true;
+      }
+      return false;
+    }
+
+    // Simplify, deduplicate and promote all the assumptions of a
+    // block in a single traversal
+    bool runOnBasicBlock (BasicBlock &B, IRBuilder<> &Builder)
+    {
+      LLVMContext &ctx = B.getContext ();
+      std::vector<Instruction*> to_remove;
+      // conditions already assumed (or assumed false) in B
+      SmallPtrSet<Value*, 16> seen, seen_not;
+      CallInst* unreachable = nullptr;
+      bool change = false;
 
-      SmallPtrSet<Instruction*, 16> to_remove;
-      for(inst_iterator I = inst_begin(&F); I != inst_end(&F); ++I) {
-        if (CallInst* CI = dyn_cast<CallInst> (&*I)) {
-          Function *callee = CI->getCalledFunction ();
-          if (callee && callee == m_assumeFn) {
-            CallSite CS (CI);          
-            Value* Cond = CS.getArgument (0);
-            if (ConstantInt* C = dyn_cast<ConstantInt> (Cond)) {
-              if (C == ConstantInt::getTrue (F.getContext ())) {
-                to_remove.insert (CI);
-              }
-              else if (C == ConstantInt::getFalse (F.getContext ())) {
-                Builder.SetInsertPoint (CI);
-                Builder.CreateUnreachable ();
-              }
-            }
+      for (Instruction &I : B) {
+        bool negated;
+        if (!isAssume (I, negated)) continue;
+        CallInst* CI = cast<CallInst> (&I);
+        Value* Cond = CI->getArgOperand (0);
+        if (ConstantInt* C = dyn_cast<ConstantInt> (Cond)) {
+          if (C->isOne () != negated) {
+            to_remove.push_back (CI);
+            continue;
+          } else {
+            // -- the rest of the block is dead
+            unreachable = CI;
+            break;
           }
         }
+
+        if (!(negated ? seen_not : seen).insert (Cond).second) {
+          to_remove.push_back (CI);
+          continue;
+        }
+
+        if (m_promote) {
+          // -- already used in llvm.assume
+          if (!hasAssumeUsers (*Cond)) {
+            Builder.SetInsertPoint (CI);
+            Value* Arg = negated ? Builder.CreateNot (Cond) : Cond;
+            CallInst* A = Builder.CreateAssumption (Arg);
+            // mark this assumption so that we know who inserted it
+            A->setMetadata (m_mdKind, MDNode::get (ctx, None));
+          }
+          to_remove.push_back (CI);
+        }
       }
+
       for (Instruction* I: to_remove) {
         I->eraseFromParent ();
+        change = true;
+      }
+      if (unreachable) {
+        changeToUnreachable (unreachable, false);
+        change = true;
       }
-      return !to_remove.empty ();
+      return change;
+    }
+
+    bool runOnFunction (llvm::Function &F)
+    {
+      if (F.isDeclaration () || F.empty ()) 
+        return false;
+      
+      IRBuilder<> Builder (F.getContext());
+      bool change = false;
+      for (auto &B : F)
+        change |= runOnBasicBlock (B, Builder);
+      return change;
     }
     
     // It might not preserve the call graph ...
@@ -89,7 +169,9 @@ namespace crab_llvm
   };
 
   char crab_llvm::SimplifyAssume::ID = 0;
-  Pass* createSimplifyAssumePass () { return new SimplifyAssume (); }
+  Pass* createSimplifyAssumePass (bool promote) {
+    return new SimplifyAssume (promote);
+  }
 
 } // end namespace 
 
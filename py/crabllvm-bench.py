@@ -0,0 +1,163 @@
+#!/usr/bin/env python2
+
+# Run crabllvm.py on a set of benchmarks with several abstract domains
+# and tracking levels, record the results and compare them with a
+# baseline.
+
+import sys
+import os
+import os.path
+import time
+import json
+import csv
+import subprocess as sub
+
+root = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+
+default_doms = ['int', 'ric', 'term-int', 'dis-int', 'term-dis-int', 'boxes',
+                'zones', 'oct', 'pk', 'rtz', 'w-int']
+default_tracks = ['num', 'ptr', 'arr']
+default_dirs = [os.path.join(root, 'tests', 'ssh'),
+                os.path.join(root, 'tests', 'ntdrivers-simplified')]
+
+def parseArgs(argv):
+    import argparse as a
+    p = a.ArgumentParser(description='Benchmark crab-llvm')
+    p.add_argument('--crabllvm', help='Path to crabllvm.py', dest='crabllvm',
+                   default=os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                        'crabllvm.py'))
+    p.add_argument('--dom', help='Abstract domains (comma separated)',
+                   dest='doms', default=','.join(default_doms))
+    p.add_argument('--track', help='Tracking levels (comma separated)',
+                   dest='tracks', default=','.join(default_tracks))
+    p.add_argument('--repeat', type=int, help='Number of runs of each configuration',
+                   dest='repeat', default=3)
+    p.add_argument('--cpu', type=int, help='CPU time limit (seconds) of each run',
+                   dest='cpu', default=300)
+    p.add_argument('--mem', type=int, help='Memory limit (MB) of each run',
+                   dest='mem', default=4096)
+    p.add_argument('--out', help='Write the results in FILE (.json or .csv)',
+                   dest='out', default='crab-bench.json', metavar='FILE')
+    p.add_argument('--baseline', help='Compare the results with FILE (.json)',
+                   dest='baseline', default=None, metavar='FILE')
+    p.add_argument('--tolerance', type=float,
+                   help='Max allowed slowdown/memory increase with respect to the baseline (percentage)',
+                   dest='tolerance', default=20.0)
+    p.add_argument('--min-time', type=float,
+                   help='Ignore time regressions of runs faster than SECS',
+                   dest='min_time', default=0.5, metavar='SECS')
+    p.add_argument('dirs', nargs='*', help='Directories or files with benchmarks',
+                   default=default_dirs)
+    return p.parse_args(argv)
+
+def getBenchmarks(dirs):
+    res = []
+    for d in dirs:
+        if os.path.isfile(d):
+            res.append(d)
+            continue
+        for f in sorted(os.listdir(d)):
+            if f.endswith('.c'):
+                res.append(os.path.join(d, f))
+    return res
+
+# Run cmd and return (exit code, wall time in seconds, peak RSS in KB, output)
+def runOne(cmd):
+    start = time.time()
+    p = sub.Popen(cmd, stdout=sub.PIPE, stderr=sub.STDOUT)
+    out = p.stdout.read()
+    # the rusage of the child includes all its (waited) descendants
+    _, status, ru = os.wait4(p.pid, 0)
+    wall = time.time() - start
+    if os.WIFEXITED(status):
+        code = os.WEXITSTATUS(status)
+    else:
+        code = -os.WTERMSIG(status)
+    return (code, wall, ru.ru_maxrss, out)
+
+def parseStats(out):
+    stats = {}
+    for line in out.splitlines():
+        if line.startswith('BRUNCH_STAT'):
+            parts = line.split()
+            if len(parts) >= 3:
+                stats[parts[1]] = ' '.join(parts[2:])
+    return stats
+
+def run(args):
+    results = []
+    for bench in getBenchmarks(args.dirs):
+        for dom in args.doms.split(','):
+            for track in args.tracks.split(','):
+                cmd = [args.crabllvm, '-O0', '--crab-dom=' + dom,
+                       '--crab-track=' + track, '--crab-check=assert',
+                       '--crab-do-not-print-invariants', '--crab-stats',
+                       '--cpu={0}'.format(args.cpu), '--mem={0}'.format(args.mem),
+                       bench]
+                walls, rsss, stats, code = [], [], {}, 0
+                for i in range(args.repeat):
+                    code, wall, rss, out = runOne(cmd)
+                    walls.append(wall)
+                    rsss.append(rss)
+                    stats = parseStats(out)
+                res = {'benchmark': os.path.basename(bench), 'dom': dom, 'track': track,
+                       'exit': code,
+                       'wall': min(walls), 'rss_kb': max(rsss),
+                       'result': stats.get('Result', 'UNKNOWN'),
+                       'stats': stats}
+                print '{benchmark} {dom} {track}: {result} {wall:.2f}s {rss_kb}KB'.format(**res)
+                results.append(res)
+    return results
+
+def write(results, out):
+    if out.endswith('.csv'):
+        with open(out, 'wb') as f:
+            w = csv.writer(f)
+            w.writerow(['benchmark', 'dom', 'track', 'exit', 'result', 'wall', 'rss_kb'])
+            for r in results:
+                w.writerow([r['benchmark'], r['dom'], r['track'], r['exit'],
+                            r['result'], '{0:.3f}'.format(r['wall']), r['rss_kb']])
+    else:
+        with open(out, 'w') as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+
+# Return the number of regressions with respect to baseline
+def compare(results, baseline, tolerance, min_time):
+    base = {}
+    for r in baseline:
+        base[(r['benchmark'], r['dom'], r['track'])] = r
+    regressions = 0
+    factor = 1.0 + tolerance / 100.0
+    for r in results:
+        b = base.get((r['benchmark'], r['dom'], r['track']))
+        if b is None: continue
+        msgs = []
+        if r['result'] != b['result']:
+            msgs.append('result {0} -> {1}'.format(b['result'], r['result']))
+        if r['wall'] > min_time and r['wall'] > b['wall'] * factor:
+            msgs.append('time {0:.2f}s -> {1:.2f}s'.format(b['wall'], r['wall']))
+        if r['rss_kb'] > b['rss_kb'] * factor:
+            msgs.append('memory {0}KB -> {1}KB'.format(b['rss_kb'], r['rss_kb']))
+        if msgs:
+            regressions += 1
+            print 'REGRESSION {0} {1} {2}: {3}'.format(r['benchmark'], r['dom'],
+                                                     r['track'], ', '.join(msgs))
+    return regressions
+
+def main(argv):
+    args = parseArgs(argv[1:])
+    results = run(args)
+    write(results, args.out)
+    if args.baseline is not None:
+        if not os.path.isfile(args.baseline):
+            print 'No baseline found in {0}'.format(args.baseline)
+            return 0
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        n = compare(results, baseline, args.tolerance, args.min_time)
+        print '{0} regressions found'.format(n)
+        return 1 if n > 0 else 0
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
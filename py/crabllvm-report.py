@@ -0,0 +1,168 @@
+#!/usr/bin/env python2
+
+# Aggregate the performance results of many runs of crabllvm.py into
+# percentiles (p50/p90/p99/max) per phase, stage and domain, list the
+# slowest functions and compare the summary with a baseline.
+#
+# The inputs can be:
+#  - --batch-report files of crabllvm.py (BRUNCH_STAT and BRUNCH_STAGES
+#    of each file)
+#  - --crab-profile files (time of each phase per function)
+#  - outputs of crabllvm.py (lines BRUNCH_STAT and BRUNCH_STAGES)
+
+import sys
+import os
+import os.path
+import json
+
+def parseArgs(argv):
+    import argparse as a
+    p = a.ArgumentParser(description='Aggregate crab-llvm performance results')
+    p.add_argument('--top', type=int, help='Number of slowest functions listed',
+                   dest='top', default=10, metavar='N')
+    p.add_argument('--out', help='Write the summary in FILE (.json)',
+                   dest='out', default=None, metavar='FILE')
+    p.add_argument('--baseline', help='Compare the summary with FILE (written by --out)',
+                   dest='baseline', default=None, metavar='FILE')
+    p.add_argument('--tolerance', type=float,
+                   help='Max allowed increase of a percentile with respect to the baseline (percentage)',
+                   dest='tolerance', default=20.0)
+    p.add_argument('--min-value', type=float,
+                   help='Ignore increases of percentiles smaller than VAL',
+                   dest='min_value', default=0.5, metavar='VAL')
+    p.add_argument('files', nargs='+',
+                   help='Batch reports, --crab-profile files or outputs of crabllvm.py')
+    return p.parse_args(argv)
+
+# nearest-rank percentile of the sorted list vals
+def percentile(vals, p):
+    if not vals: return 0.0
+    k = int(max(0, min(len(vals) - 1, -(-p * len(vals) // 100) - 1)))
+    return vals[k]
+
+def summarize(vals):
+    vals = sorted(vals)
+    return {'n': len(vals), 'p50': percentile(vals, 50), 'p90': percentile(vals, 90),
+            'p99': percentile(vals, 99), 'max': vals[-1] if vals else 0.0}
+
+class Collector(object):
+    def __init__(self):
+        # key -> list of values
+        self.samples = {}
+        # (time, file, function, blocks, stmts, domain)
+        self.functions = []
+
+    def add(self, key, val):
+        self.samples.setdefault(key, []).append(float(val))
+
+    def addBrunch(self, brunch):
+        for k, v in brunch.iteritems():
+            try: self.add('stat.' + k, float(v))
+            except ValueError: pass
+
+    def addStages(self, stages):
+        for s in stages:
+            for k in ['wall', 'user', 'sys', 'max_rss_kb', 'peak_mem_bytes']:
+                if k in s: self.add('stage.{0}.{1}'.format(s['stage'], k), s[k])
+
+    def addProfile(self, name, prof):
+        for f in prof.get('functions', []):
+            dom = f.get('domain', 'unknown')
+            total = 0.0
+            for k, v in f.iteritems():
+                if k in ['function', 'max_csts', 'blocks', 'stmts', 'domain', 'counters']:
+                    continue
+                self.add('phase.{0}'.format(k), v)
+                self.add('phase.{0}.{1}'.format(k, dom), v)
+                total += v
+            self.add('function.total.{0}'.format(dom), total)
+            self.add('function.max_csts', f.get('max_csts', 0))
+            self.functions.append((total, name, f['function'], f.get('blocks', 0),
+                                   f.get('stmts', 0), dom))
+
+    def addFile(self, name):
+        with open(name) as f:
+            text = f.read()
+        try:
+            data = json.loads(text)
+        except ValueError:
+            data = None
+        if isinstance(data, list):
+            # -- batch report
+            for r in data:
+                self.addBrunch(r.get('stats', {}))
+                self.addStages(r.get('stages', []))
+                if 'time' in r: self.add('file.time', r['time'])
+        elif isinstance(data, dict):
+            self.addProfile(name, data)
+        else:
+            # -- output of crabllvm.py
+            brunch = {}
+            for line in text.splitlines():
+                if line.startswith('BRUNCH_STAGES '):
+                    self.addStages(json.loads(line.split(None, 1)[1]))
+                elif line.startswith('BRUNCH_STAT'):
+                    parts = line.split(None, 2)
+                    if len(parts) == 3: brunch[parts[1]] = parts[2]
+            self.addBrunch(brunch)
+
+def printSummary(summary):
+    print '{0:<48} {1:>6} {2:>10} {3:>10} {4:>10} {5:>10}'.format(
+        'key', 'n', 'p50', 'p90', 'p99', 'max')
+    for k in sorted(summary.keys()):
+        s = summary[k]
+        print '{0:<48} {1:>6} {2:>10.3f} {3:>10.3f} {4:>10.3f} {5:>10.3f}'.format(
+            k, s['n'], s['p50'], s['p90'], s['p99'], s['max'])
+
+def printTop(functions, n):
+    if not functions or n <= 0: return
+    print
+    print 'Slowest functions:'
+    print '{0:>10} {1:>8} {2:>8} {3:<12} {4}'.format('time', 'blocks', 'stmts', 'domain',
+                                                    'function')
+    for (t, name, fun, blocks, stmts, dom) in sorted(functions, reverse=True)[:n]:
+        print '{0:>10.3f} {1:>8} {2:>8} {3:<12} {4} ({5})'.format(t, blocks, stmts, dom,
+                                                                fun, name)
+
+# Return the number of percentiles that increased more than tolerance
+def compare(summary, baseline, tolerance, min_value):
+    factor = 1.0 + tolerance / 100.0
+    regressions = 0
+    print
+    for k in sorted(summary.keys()):
+        b = baseline.get(k)
+        if b is None: continue
+        msgs = []
+        for p in ['p50', 'p90', 'p99', 'max']:
+            cur = summary[k][p]
+            if cur > min_value and cur > b[p] * factor:
+                msgs.append('{0} {1:.3f} -> {2:.3f}'.format(p, b[p], cur))
+        if msgs:
+            regressions += 1
+            print 'REGRESSION {0}: {1}'.format(k, ', '.join(msgs))
+    return regressions
+
+def main(argv):
+    args = parseArgs(argv[1:])
+    c = Collector()
+    for f in args.files:
+        c.addFile(f)
+    summary = dict((k, summarize(v)) for k, v in c.samples.iteritems())
+    printSummary(summary)
+    printTop(c.functions, args.top)
+    if args.out is not None:
+        with open(args.out, 'w') as f:
+            json.dump(summary, f, indent=1, sort_keys=True)
+    if args.baseline is not None:
+        if not os.path.isfile(args.baseline):
+            print 'No baseline found in {0}'.format(args.baseline)
+            return 0
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        n = compare(summary, baseline, args.tolerance, args.min_value)
+        print '{0} regressions found'.format(n)
+        return 1 if n > 0 else 0
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
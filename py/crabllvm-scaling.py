@@ -0,0 +1,186 @@
+#!/usr/bin/env python2
+
+# Generate synthetic C programs of increasing size along one axis
+# (variables, loop nesting depth, functions, call graph width or heap
+# regions), run crabllvm.py on them with several abstract domains and
+# report the growth rate of time and memory with each size.
+
+import sys
+import os
+import os.path
+import math
+import json
+import imp
+
+bench = imp.load_source('crabllvm_bench',
+                        os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                     'crabllvm-bench.py'))
+
+default_doms = ['int', 'zones', 'oct', 'pk', 'term-int', 'boxes']
+default_axes = ['vars', 'depth', 'funcs', 'width', 'regions']
+default_sizes = {'vars': [8, 16, 32, 64, 128],
+                 'depth': [1, 2, 3, 4, 5],
+                 'funcs': [16, 32, 64, 128, 256],
+                 'width': [16, 32, 64, 128, 256],
+                 'regions': [8, 16, 32, 64, 128]}
+
+header = ('extern void __CRAB_assert(int);\n'
+          'extern int nd(void);\n\n')
+
+# n variables related to each other in one loop
+def genVars(n):
+    decls = ''.join('  int x{0} = {0};\n'.format(i) for i in range(n))
+    body = ''.join('    x{0} = x{1} + 1;\n'.format(i, i - 1) for i in range(1, n))
+    return (header + 'int main() {\n' + decls +
+            '  int i;\n  for (i = 0; i < 100; i++) {\n'
+            '    x0 = x0 + 1;\n' + body + '  }\n' +
+            '  __CRAB_assert(x{0} >= x0);\n  return 0;\n}}\n'.format(n - 1))
+
+# d nested loops
+def genDepth(d):
+    s = header + 'int main() {\n  int s = 0;\n'
+    for k in range(d):
+        s += '  int i{0};\n'.format(k)
+    for k in range(d):
+        s += ('  ' * (k + 1) +
+              'for (i{0} = 0; i{0} < 10; i{0}++) {{\n'.format(k))
+    s += '  ' * (d + 1) + 's++;\n'
+    for k in reversed(range(d)):
+        s += '  ' * (k + 1) + '}\n'
+    return s + '  __CRAB_assert(s >= 0);\n  return 0;\n}\n'
+
+# chain of n functions
+def genFuncs(n):
+    s = header + 'int f0(int x) { return x + 1; }\n'
+    for i in range(1, n):
+        s += ('int f{0}(int x) {{ int y = f{1}(x); if (nd()) y++; '
+              'return y; }}\n'.format(i, i - 1))
+    return s + ('int main() {{ int r = f{0}(0); __CRAB_assert(r >= 1); '
+                'return 0; }}\n'.format(n - 1))
+
+# main calls w different leaf functions
+def genWidth(w):
+    s = header
+    for i in range(w):
+        s += 'int g{0}(int x) {{ return x + {0}; }}\n'.format(i)
+    s += 'int main() {\n  int r = 0;\n'
+    s += ''.join('  r = g{0}(r);\n'.format(i) for i in range(w))
+    return s + '  __CRAB_assert(r >= 0);\n  return 0;\n}\n'
+
+# r disjoint global arrays accessed in one loop
+def genRegions(r):
+    s = header + ''.join('int a{0}[10];\n'.format(i) for i in range(r))
+    s += 'int main() {\n  int i;\n  for (i = 0; i < 10; i++) {\n'
+    s += ''.join('    a{0}[i] = i;\n'.format(k) for k in range(r))
+    return s + '  }\n  __CRAB_assert(a0[0] >= 0);\n  return 0;\n}\n'
+
+generators = {'vars': genVars, 'depth': genDepth, 'funcs': genFuncs,
+              'width': genWidth, 'regions': genRegions}
+
+def parseArgs(argv):
+    import argparse as a
+    p = a.ArgumentParser(description='Measure how crab-llvm scales on synthetic programs')
+    p.add_argument('--crabllvm', help='Path to crabllvm.py', dest='crabllvm',
+                   default=os.path.join(os.path.dirname(os.path.realpath(__file__)),
+                                        'crabllvm.py'))
+    p.add_argument('--dom', help='Abstract domains (comma separated)',
+                   dest='doms', default=','.join(default_doms))
+    p.add_argument('--axis', help='Axes to scale (comma separated): ' + ','.join(default_axes),
+                   dest='axes', default=','.join(default_axes))
+    p.add_argument('--sizes', help='Sizes of each axis (comma separated, default depends on the axis)',
+                   dest='sizes', default=None)
+    p.add_argument('--track', help='Tracking level', dest='track', default='arr')
+    p.add_argument('--inter', help='Run the inter-procedural analysis',
+                   dest='inter', default=False, action='store_true')
+    p.add_argument('--repeat', type=int, help='Number of runs of each configuration',
+                   dest='repeat', default=1)
+    p.add_argument('--cpu', type=int, help='CPU time limit (seconds) of each run',
+                   dest='cpu', default=300)
+    p.add_argument('--mem', type=int, help='Memory limit (MB) of each run',
+                   dest='mem', default=4096)
+    p.add_argument('--work-dir', help='Directory of the generated programs',
+                   dest='work_dir', default='crab-scaling')
+    p.add_argument('--out', help='Write the results in FILE (.json)',
+                   dest='out', default='crab-scaling.json', metavar='FILE')
+    return p.parse_args(argv)
+
+# Least-squares slope of log(y) with respect to log(x): y ~ x^slope
+def fitExponent(xs, ys):
+    pts = [(math.log(x), math.log(y)) for x, y in zip(xs, ys) if x > 0 and y > 0]
+    if len(pts) < 2: return None
+    mx = sum(p[0] for p in pts) / len(pts)
+    my = sum(p[1] for p in pts) / len(pts)
+    sxx = sum((p[0] - mx) ** 2 for p in pts)
+    if sxx == 0: return None
+    return sum((p[0] - mx) * (p[1] - my) for p in pts) / sxx
+
+def fmtExponent(k):
+    return '   n/a' if k is None else '{0:6.2f}'.format(k)
+
+def run(args):
+    if not os.path.isdir(args.work_dir):
+        os.makedirs(args.work_dir)
+    results = []
+    for axis in args.axes.split(','):
+        sizes = default_sizes[axis]
+        if args.sizes is not None:
+            sizes = [int(s) for s in args.sizes.split(',')]
+        progs = []
+        for n in sizes:
+            prog = os.path.join(args.work_dir, '{0}-{1}.c'.format(axis, n))
+            with open(prog, 'w') as f:
+                f.write(generators[axis](n))
+            progs.append((n, prog))
+        for dom in args.doms.split(','):
+            runs = []
+            for n, prog in progs:
+                cmd = [args.crabllvm, '-O0', '--crab-dom=' + dom,
+                       '--crab-track=' + args.track, '--crab-check=assert',
+                       '--crab-do-not-print-invariants',
+                       '--cpu={0}'.format(args.cpu), '--mem={0}'.format(args.mem)]
+                if args.inter: cmd.append('--crab-inter')
+                cmd.append(prog)
+                walls, rsss, code = [], [], 0
+                for i in range(args.repeat):
+                    code, wall, rss, _ = bench.runOne(cmd)
+                    walls.append(wall)
+                    rsss.append(rss)
+                runs.append({'size': n, 'exit': code, 'wall': min(walls), 'rss_kb': max(rsss)})
+                print '{0}={1} {2}: {3:.2f}s {4}KB{5}'.format(
+                    axis, n, dom, min(walls), max(rsss),
+                    '' if code == 0 else ' (exit {0})'.format(code))
+                if code != 0:
+                    # -- larger sizes would also fail
+                    break
+            ok = [r for r in runs if r['exit'] == 0]
+            results.append({'axis': axis, 'dom': dom, 'runs': runs,
+                            'time_exp': fitExponent([r['size'] for r in ok],
+                                                    [r['wall'] for r in ok]),
+                            'mem_exp': fitExponent([r['size'] for r in ok],
+                                                   [r['rss_kb'] for r in ok]),
+                            'max_size': max([r['size'] for r in ok]) if ok else None})
+    return results
+
+def report(results):
+    print
+    print '{0:<8} {1:<14} {2:>8} {3:>8} {4:>9}'.format('axis', 'dom', 'time~n^', 'mem~n^',
+                                                    'max size')
+    for r in results:
+        print '{0:<8} {1:<14} {2:>8} {3:>8} {4:>9}'.format(
+            r['axis'], r['dom'], fmtExponent(r['time_exp']), fmtExponent(r['mem_exp']),
+            'none' if r['max_size'] is None else r['max_size'])
+
+def main(argv):
+    args = parseArgs(argv[1:])
+    for axis in args.axes.split(','):
+        if axis not in generators:
+            print 'Unknown axis {0}'.format(axis)
+            return 2
+    results = run(args)
+    report(results)
+    with open(args.out, 'w') as f:
+        json.dump(results, f, indent=1, sort_keys=True)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
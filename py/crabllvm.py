@@ -14,6 +14,8 @@ import stats
 
 root = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
 verbose = False
+## if not None, outputs of clang, crabllvm-pp and opt are reused from this directory
+cache_dir = None
 
 running_process = None
 
@@ -60,15 +62,93 @@ def which(program):
 # Return a tuple (returnvalue:int, timeout:bool, out_of_memory:bool, segfault:bool, unknown:bool)
 #   - Only one boolean flag can be enabled at any time.
 #   - If all flags are false then returnvalue cannot be None.
+## cgroup (v2) in which a stage runs: it enforces --mem on the memory
+## actually used instead of the address space (RLIMIT_AS also counts
+## virtual reservations) and accounts the peak memory and I/O of the
+## stage. Only used if a child of the cgroup of this process can be
+## created with the memory controller.
+_cgroup_count = [0]
+
+def _cgroupBase():
+    try:
+        with open('/proc/self/cgroup') as f:
+            for line in f:
+                parts = line.strip().split(':', 2)
+                if len(parts) == 3 and parts[0] == '0' and parts[1] == '':
+                    return os.path.join('/sys/fs/cgroup', parts[2].lstrip('/'))
+    except IOError: pass
+    return None
+
+def _readCgroupFile(cg, name):
+    try:
+        with open(os.path.join(cg, name)) as f: return f.read()
+    except IOError: return None
+
+def _writeCgroupFile(cg, name, val):
+    with open(os.path.join(cg, name), 'w') as f: f.write(val)
+
+def removeCgroup(cg):
+    try: os.rmdir(cg)
+    except OSError: pass
+
+def createCgroup(mem):
+    base = _cgroupBase()
+    if base is None or not os.access(base, os.W_OK): return None
+    _cgroup_count[0] += 1
+    cg = os.path.join(base, 'crabllvm-{0}-{1}'.format(os.getpid(), _cgroup_count[0]))
+    try: os.mkdir(cg)
+    except OSError: return None
+    if not os.path.isfile(os.path.join(cg, 'memory.max')):
+        removeCgroup(cg)
+        return None
+    try:
+        if mem > 0:
+            _writeCgroupFile(cg, 'memory.max', str(mem * 1024 * 1024))
+            if os.path.isfile(os.path.join(cg, 'memory.swap.max')):
+                _writeCgroupFile(cg, 'memory.swap.max', '0')
+    except IOError:
+        removeCgroup(cg)
+        return None
+    return cg
+
+## peak memory (bytes), number of OOM kills, bytes read and bytes
+## written by the processes of the cgroup (None if not available)
+def readCgroup(cg):
+    peak = _readCgroupFile(cg, 'memory.peak')
+    peak = int(peak) if peak is not None and peak.strip().isdigit() else None
+    oom_kills = 0
+    events = _readCgroupFile(cg, 'memory.events')
+    if events is not None:
+        for line in events.splitlines():
+            kv = line.split()
+            if len(kv) == 2 and kv[0] == 'oom_kill': oom_kills = int(kv[1])
+    rbytes = None
+    wbytes = None
+    io = _readCgroupFile(cg, 'io.stat')
+    if io is not None:
+        rbytes = 0
+        wbytes = 0
+        for line in io.splitlines():
+            for kv in line.split()[1:]:
+                (k, _, v) = kv.partition('=')
+                if k == 'rbytes': rbytes += int(v)
+                elif k == 'wbytes': wbytes += int(v)
+    return (peak, oom_kills, rbytes, wbytes)
+
 def run_command_with_limits(cmd, cpu, mem, out = None):
+    import time
     timeout = False
     out_of_memory = False
     segfault = False
     unknown_error = False
     returnvalue = 0
+    ru_child = None
+    cg = createCgroup(mem)
     
     def set_limits():
-        if mem > 0:
+        if cg is not None:
+            _writeCgroupFile(cg, 'cgroup.procs', str(os.getpid()))
+        elif mem > 0:
             mem_bytes = mem * 1024 * 1024
             resource.setrlimit(resource.RLIMIT_AS, [mem_bytes, mem_bytes])
     def kill(proc):
@@ -80,6 +160,7 @@ def run_command_with_limits(cmd, cpu, mem, out = None):
             running_process = None
         except OSError: pass
         
+    wall = time.time()
     if out is not None:
         p = sub.Popen(cmd, stdout = out, preexec_fn=set_limits)
     else:
@@ -123,6 +204,32 @@ def run_command_with_limits(cmd, cpu, mem, out = None):
     finally:
         ## kill the timer if the process has terminated already
         if timer.isAlive(): timer.cancel()
+    wall = time.time() - wall
+
+    ## -- per-stage accounting
+    record = {'stage': os.path.basename(cmd[0]), 'wall': round(wall, 3),
+              'returncode': returnvalue, 'cgroup': cg is not None}
+    if ru_child is not None:
+        record['user'] = round(ru_child.ru_utime, 3)
+        record['sys'] = round(ru_child.ru_stime, 3)
+        ## kilobytes on Linux
+        record['max_rss_kb'] = ru_child.ru_maxrss
+        ## blocks of 512 bytes
+        record['read_bytes'] = ru_child.ru_inblock * 512
+        record['write_bytes'] = ru_child.ru_oublock * 512
+    if cg is not None:
+        (peak, oom_kills, rbytes, wbytes) = readCgroup(cg)
+        removeCgroup(cg)
+        if peak is not None: record['peak_mem_bytes'] = peak
+        if rbytes is not None: record['read_bytes'] = rbytes
+        if wbytes is not None: record['write_bytes'] = wbytes
+        if oom_kills > 0:
+            ## -- killed by the OOM killer of the cgroup, not by the timer
+            out_of_memory = True
+            timeout = False
+    record['timeout'] = timeout
+    record['out_of_memory'] = out_of_memory
+    stats.stage(record)
         
     return (returnvalue, timeout, out_of_memory, segfault, unknown_error)        
 
@@ -139,7 +246,7 @@ def loadEnv(filename):
         os.environ [key] = os.path.expandvars(val.rstrip())
 
         
-def parseArgs(argv):
+def argParser():
     import argparse as a
     from argparse import RawTextHelpFormatter
 
@@ -168,6 +275,9 @@ def parseArgs(argv):
     p.add_argument("--only-preprocess", dest="only_preprocess", 
                     help='Run only the preprocessor', action='store_true',
                     default=False)
+    p.add_argument("--single-process", dest="single_process", 
+                    help='Run the preprocessor and the analyzer in the same process (ignored if -O > 0)',
+                    action='store_true', default=False)
     p.add_argument('-O', type=int, dest='L', metavar='INT',
                     help='Optimization level L:[0,1,2,3]', default=0)
     p.add_argument('--cpu', type=int, dest='cpu', metavar='SEC',
@@ -198,15 +308,28 @@ def parseArgs(argv):
                     default=150, metavar='NUM')
     p.add_argument('--inline', dest='inline', help='Inline all functions',
                     default=False, action='store_true')
+    p.add_argument('--inline-budget', dest='inline_budget', type=int,
+                    help='Inline functions only if the callers do not exceed NUM instructions',
+                    default=0, metavar='NUM')
+    p.add_argument('--pp-jobs', dest='pp_jobs', type=int,
+                    help='Run crabllvm-pp on NUM partitions of the module in parallel (ignored with inlining)',
+                    default=1, metavar='NUM')
     p.add_argument('--turn-undef-nondet',
                     help='Turn undefined behaviour into non-determinism',
                     dest='undef_nondet', default=False, action='store_true')
     p.add_argument('--lower-select',
                     help='Lower select instructions',
                     dest='lower_select', default=False, action='store_true')
+    p.add_argument('--lower-relevant-select',
+                    help='Lower only the select instructions that flow into assertions or loop guards',
+                    dest='lower_relevant_select', default=False, action='store_true')
     p.add_argument('--disable-lower-gv',
                     help='Disable lowering of global variable initializers into main',
                     dest='disable_lower_gv', default=False, action='store_true')
+    p.add_argument('--lower-gv-max-calls', metavar='INT',
+                    help='Do not lower the initializer of a global variable if it requires '
+                    'more initialization calls than this number (0 means unlimited)',
+                    dest='lower_gv_max_calls', type=int, default=0)
     p.add_argument('--lower-unsigned-icmp',
                     help='Lower ULT and ULE instructions',
                     dest='lower_unsigned_icmp', default=False, action='store_true')
@@ -218,22 +341,69 @@ def parseArgs(argv):
                     dest='devirt',
                     choices=['none','types','dsa'],
                     default='none')
+    p.add_argument('--devirt-max-bounce-targets', metavar='INT',
+                    help='Replace with a call to an external function the indirect calls '
+                    'with more targets than this number (0 means unlimited)',
+                    dest='devirt_max_bounce_targets', type=int, default=0)
     p.add_argument('--externalize-addr-taken-functions',
                     help='Externalize uses of address-taken functions',
                     dest='enable_ext_funcs', default=False,
                     action='store_true')
-    p.add_argument('file', metavar='FILE', help='Input file')
+    p.add_argument('file', metavar='FILE', nargs='*',
+                    help='Input file. Several files or glob patterns are analyzed in batch mode')
+    p.add_argument('--project', dest='project', metavar='FILE',
+                    help='Compile in parallel the files of the compilation database FILE '
+                    '(compile_commands.json), link them and analyze the whole program',
+                    default=None)
+    p.add_argument('--cache-dir', dest='cache_dir', metavar='DIR',
+                    help='Reuse the outputs of clang, crabllvm-pp and opt stored in DIR',
+                    default=None)
+    p.add_argument('--jobs', type=int, dest='jobs', metavar='NUM',
+                    help='Number of files analyzed (or compiled with --project) in parallel '
+                    'in batch mode (default = number of CPUs)',
+                    default=0)
+    p.add_argument('--batch-report', dest='batch_report', metavar='FILE',
+                    help='Write the results of each file in batch mode in FILE (json)',
+                    default=None)
+    p.add_argument('--shards', type=int, dest='shards', metavar='NUM',
+                    help='Split the trackable functions in NUM shards analyzed by separate '
+                    'crabllvm workers (distributed mode)',
+                    default=0)
+    p.add_argument('--shard-hosts', dest='shard_hosts', metavar='HOSTS',
+                    help='Comma-separated hosts where the workers run (round-robin)',
+                    default=None)
+    p.add_argument('--shard-launcher', dest='shard_launcher', metavar='CMD',
+                    help='Command that launches a worker, {host} is replaced by the host and '
+                    '{cmd} by the quoted worker command line which is otherwise appended '
+                    '(default: "ssh {host} {cmd}" with --shard-hosts, local processes otherwise)',
+                    default=None)
+    p.add_argument('--shard-dir', dest='shard_dir', metavar='DIR',
+                    help='Directory shared by all the workers (default: working directory)',
+                    default=None)
     ### BEGIN CRAB
     p.add_argument('--crab-verbose', type=int,
                     help='Enable verbose messages',
                     dest='crab_verbose',
                     default=0, metavar='UINT')
+    p.add_argument('--crab-verbose-rate', type=int,
+                    help='Max number of lines per second of verbose messages (0: no limit)',
+                    dest='crab_verbose_rate',
+                    default=0, metavar='UINT')
     p.add_argument("--crab-only-cfg", dest="crab_only_cfg", 
                     help='Build only the Crab CFG', action='store_true',
                     default=False)    
     p.add_argument('--crab-cfg-simplify',
                     help='Perform some crab CFG transformations',
                     dest='crab_cfg_simplify', default=False, action='store_true')    
+    p.add_argument('--crab-cfg-dce',
+                    help='Remove statements that define variables never used from the Crab CFG',
+                    dest='crab_cfg_dce', default=False, action='store_true')
+    p.add_argument('--crab-cfg-threads', type=int,
+                    help='Number of threads to translate the blocks of a large function',
+                    dest='crab_cfg_threads', default=1, metavar='NUM')
+    p.add_argument('--crab-cfg-parallel-blocks', type=int,
+                    help='Minimum number of blocks of a function to use --crab-cfg-threads',
+                    dest='crab_cfg_parallel_blocks', default=2000, metavar='NUM')
     p.add_argument('--crab-dom',
                     help="Choose abstract domain:\n"
                           "- int: intervals\n"
@@ -246,18 +416,35 @@ def parseArgs(argv):
                           "- oct: octagons domain\n"
                           "- pk: polyhedra domain\n"
                           "- rtz: reduced product of term-dis-int with zones\n"
-                          "- w-int: wrapped intervals\n",
+                          "- w-int: wrapped intervals\n"
+                          "- dense-int: intervals with dense int64 bounds\n"
+                          "- w-int-fast: w-int with native uint64_t bounds\n"
+                          "- zones-fast: zones with int64 weights\n"
+                          "- adapt-rtz: rtz while its fixpoint is cheap, otherwise term-int and then int\n"
+                          "- ptr-offsets: dense-int with the base region and offsets of the pointers (--crab-track=ptr)\n"
+                          "- zones-dense: zones-fast with dense DBMs for small dense states\n",
                     choices=['int', 'ric', 'term-int',
                              'dis-int', 'term-dis-int', 'boxes',  
                              'zones', 'oct', 'pk', 'rtz',
-                             'w-int'],
+                             'w-int', 'dense-int', 'zones-fast', 'adapt-rtz',
+                             'w-int-fast', 'ptr-offsets', 'zones-dense'],
                     dest='crab_dom', default='zones')
+    p.add_argument('--crab-adapt-cost-ms', type=int,
+                    help='Max time in milliseconds of each domain tried by --crab-dom=adapt-rtz',
+                    dest='crab_adapt_cost', default=None, metavar='MS')
     p.add_argument('--crab-widening-delay', 
                     type=int, dest='widening_delay', 
                     help='Max number of iterations until performing widening', default=1)
     p.add_argument('--crab-widening-jump-set', 
                     type=int, dest='widening_jump_set', 
                     help='Size of the jump set used in widening', default=0)
+    p.add_argument('--crab-widening-auto-jump-set',
+                    type=int, dest='widening_auto_jump_set',
+                    help='Size of the jump set of each function is the number of constants compared in its loops, up to N (0: disabled)',
+                    default=0, metavar='N')
+    p.add_argument('--crab-lazy-names',
+                    help='Do not name unnamed values before the analysis (names are only computed when printing)',
+                    dest='lazy_names', default=False, action='store_true')
     p.add_argument('--crab-narrowing-iterations', 
                     type=int, dest='narrowing_iterations', 
                     help='Max number of narrowing iterations', default=3)
@@ -265,6 +452,18 @@ def parseArgs(argv):
                     type=int, dest='num_threshold', 
                     help='Max number of live vars per block before switching to a non-relational domain',
                     default=10000)
+    p.add_argument('--crab-relational-threshold-loops',
+                    help='Apply --crab-relational-threshold only to the blocks inside loops',
+                    dest='num_threshold_loops', default=False, action='store_true')
+    p.add_argument('--crab-relational-threshold-packs',
+                    help='Compare --crab-relational-threshold with the size of the largest pack of related variables (only zones)',
+                    dest='num_threshold_packs', default=False, action='store_true')
+    p.add_argument('--crab-relational-threshold-estimate',
+                    help='Apply --crab-relational-threshold to the live LLVM values instead of running the Crab liveness analysis',
+                    dest='num_threshold_estimate', default=False, action='store_true')
+    p.add_argument('--crab-terms-max', type=int,
+                    help='Max number of terms created by the term domains in a function before switching to their base domain (0: no limit)',
+                    dest='crab_terms_max', default=0, metavar='NUM')
     p.add_argument('--crab-track',
                     help="Track integers (num), pointer offsets (ptr), and memory contents (arr)\n"
                     "- ptr: subsumes num\n"
@@ -273,22 +472,151 @@ def parseArgs(argv):
                     choices=['num', 'ptr', 'arr', 'arr-no-ptr'], dest='track', default='num')
     p.add_argument('--crab-heap-analysis',
                     help='Heap analysis used for memory disambiguation',
-                    choices=['llvm-dsa', 'ci-sea-dsa', 'cs-sea-dsa'],
+                    choices=['llvm-dsa', 'ci-sea-dsa', 'cs-sea-dsa', 'type', 'auto-sea-dsa'],
                     dest='crab_heap_analysis',
                     default='ci-sea-dsa')
+    p.add_argument('--crab-dsa-auto-ms', dest='crab_dsa_auto_ms', type=int, metavar='MS',
+                    help='Max time in milliseconds of cs-sea-dsa with --crab-heap-analysis=auto-sea-dsa (0: no limit)',
+                    default=30000)
+    p.add_argument('--crab-dsa-auto-mb', dest='crab_dsa_auto_mb', type=int, metavar='MB',
+                    help='Max memory in MB of cs-sea-dsa with --crab-heap-analysis=auto-sea-dsa (0: no limit)',
+                    default=0)
+    p.add_argument('--crab-dsa-auto-fn-regions', dest='crab_dsa_auto_fn_regions', type=int, metavar='N',
+                    help='With --crab-heap-analysis=auto-sea-dsa, functions accessing more than N regions '
+                    'use ci-sea-dsa (0: no limit)',
+                    default=1000)
+    p.add_argument('--crab-heap-snapshot', dest='crab_heap_snapshot', metavar='FILE',
+                    help='Reuse the heap abstraction stored in FILE if it was computed for the same program, '
+                    'otherwise compute it and store it in FILE',
+                    default=None)
+    p.add_argument('--crab-region-budget', dest='crab_region_budget', type=int, metavar='N',
+                    help='Merge the least accessed regions of a function by type beyond N regions '
+                    '(only with --crab-track=arr)',
+                    default=0)
     p.add_argument('--crab-singleton-aliases',
                     help='Translate singleton alias sets (mostly globals) as scalar values',
                     dest='crab_singleton_aliases', default=False, action='store_true')
+    p.add_argument('--crab-dead-regions',
+                    help='Forget the arrays of regions that are not read anymore (only with --crab-track=arr)',
+                    dest='crab_dead_regions', default=False, action='store_true')
     p.add_argument('--crab-inter',
                     help='Run summary-based, inter-procedural analysis',
                     dest='crab_inter', default=False, action='store_true')
     p.add_argument('--crab-inter-sum-dom',
                     help='Choose abstract domain for computing summaries',
-                    choices=['zones','oct','rtz'],
+                    choices=['zones','zones-fast','oct','rtz'],
                     dest='crab_inter_sum_dom', default='zones')
+    p.add_argument('--crab-inter-prune',
+                    help='Remove from the call graph the functions without checks nor effects on their callers (if --crab-inter)',
+                    dest='inter_prune', default=False, action='store_true')
+    p.add_argument('--crab-inter-sum-threshold',
+                    type=int, dest='inter_sum_threshold',
+                    help='Max number of parameters and return values of the functions of a call graph SCC before using cheaper domains (0: disabled)',
+                    default=0, metavar='N')
+    p.add_argument('--crab-threads', type=int,
+                    help='Number of threads to analyze functions in parallel (only intra-procedural analysis)',
+                    dest='crab_threads', default=1, metavar='NUM')
+    p.add_argument('--crab-fixpoint-threads', type=int,
+                    help='Experimental: number of threads of the forward fixpoint over the independent components of a function',
+                    dest='crab_fixpoint_threads', default=1, metavar='NUM')
+    p.add_argument('--crab-sparse',
+                    help='Experimental: propagate values along def-use chains instead of computing the invariants of each block (only non-relational domains)',
+                    dest='crab_sparse', default=False, action='store_true')
+    p.add_argument('--crab-adaptive-fixpoint',
+                    help='Experimental: decide the widening delay and the narrowing iterations per loop head',
+                    dest='crab_adaptive_fixpoint', default=False, action='store_true')
+    p.add_argument('--crab-widening-max-delay', type=int,
+                    help='Max number of iterations until widening a loop head whose join is still more precise (only with --crab-adaptive-fixpoint)',
+                    dest='widening_max_delay', default=4, metavar='NUM')
+    p.add_argument('--crab-accelerate-loops',
+                    help='Experimental: widen the simple counting loops with the bounds implied by their guards',
+                    dest='crab_accelerate_loops', default=False, action='store_true')
+    p.add_argument('--crab-no-arena',
+                    help='Do not recycle the big numbers of the abstract domains in thread-local pools',
+                    dest='crab_arena', default=True, action='store_false')
+    p.add_argument('--crab-incremental',
+                    help='Store analysis results in DIR and reuse them for unchanged functions (only intra-procedural analysis)',
+                    dest='crab_incremental', default=None, metavar='DIR')
+    p.add_argument('--crab-checks-cache',
+                    help='Store the checks of each function in DIR and replay them for unchanged functions',
+                    dest='crab_checks_cache', default=None, metavar='DIR')
+    p.add_argument('--crab-invariants-storage',
+                    help='How invariants are stored: eager copies pre and post of each block, lazy builds them on demand, pre copies only pre of each block, '
+                    'spill writes them to a temporary file and keeps in memory only the most recently used ones, '
+                    'delta copies pre of each block as a difference with the pre of its immediate dominator (only intra-procedural analysis)',
+                    choices=['eager','lazy','pre','spill','delta'],
+                    dest='crab_invariants_storage', default='eager')
+    p.add_argument('--crab-invariants-in-memory', type=int,
+                    help='Max number of invariants kept in memory with --crab-invariants-storage=spill',
+                    dest='crab_invariants_in_memory', default=10000, metavar='NUM')
+    p.add_argument('--crab-max-cfgs', type=int,
+                    help='Max number of CFGs kept in memory after the analysis (0: no limit). The others are rebuilt on demand (only intra-procedural analysis)',
+                    dest='crab_max_cfgs', default=0, metavar='NUM')
+    p.add_argument('--crab-share-invariants',
+                    help='Stored invariants that are equal share the same abstract value',
+                    dest='crab_share_invariants', default=False, action='store_true')
+    p.add_argument('--crab-boxes-scoped',
+                    help='Store the invariants of boxes as linear constraints so that its decision diagrams are released after each function',
+                    dest='crab_boxes_scoped', default=False, action='store_true')
+    p.add_argument('--crab-export-invariants',
+                    help='Write the invariants of each block in FILE',
+                    dest='crab_export_invariants', default=None, metavar='FILE')
+    p.add_argument('--crab-only-functions',
+                    help='Analyze only the functions matching REGEX (or listed in the file) and their callees',
+                    dest='crab_only_functions', default=None, metavar='REGEX|FILE')
+    p.add_argument('--server',
+                    help='Keep the analyzed program in memory and answer queries from stdin',
+                    dest='server', default=False, action='store_true')
+    p.add_argument('--crab-profile',
+                    help='Write the time of each analysis phase per function in FILE (only intra-procedural analysis)',
+                    dest='crab_profile', default=None, metavar='FILE')
+    p.add_argument('--crab-config-profile',
+                    help='Analyze each function with the options recorded in FILE by a previous run '
+                    'and record them again (only intra-procedural analysis)',
+                    dest='crab_config_profile', default=None, metavar='FILE')
+    p.add_argument('--crab-profile-counters',
+                    help='Add hardware performance counters (cycles, instructions, LLC and branch misses) '
+                    'of each phase to --crab-profile (Linux only)',
+                    dest='crab_profile_counters', default=False, action='store_true')
+    p.add_argument('--crab-trace',
+                    help='Write a timeline of the analysis phases per function and thread in FILE '
+                    '(Chrome trace-event format)',
+                    dest='crab_trace', default=None, metavar='FILE')
+    p.add_argument('--crab-extract-slow',
+                    help='Write a reproducer of each function whose analysis takes at least MS milliseconds '
+                    '(only intra-procedural analysis)',
+                    dest='crab_extract_slow', type=int, default=0, metavar='MS')
+    p.add_argument('--crab-extract-dir',
+                    help='Directory of the reproducers of --crab-extract-slow',
+                    dest='crab_extract_dir', default='crab-repro', metavar='DIR')
+    p.add_argument('--crab-checks-stream',
+                    help='Write the checks of each function in FILE as soon as it is analyzed',
+                    dest='crab_checks_stream', default=None, metavar='FILE')
+    p.add_argument('--crab-export-invariants-db',
+                    help='Write the invariants of all blocks in FILE as a memory-mappable database',
+                    dest='crab_export_invariants_db', default=None, metavar='FILE')
+    p.add_argument('--crab-export-json',
+                    help='Use JSON lines instead of binary format with --crab-export-invariants',
+                    dest='crab_export_json', default=False, action='store_true')
+    p.add_argument('--crab-reduce-constraints',
+                    help='Remove redundant constraints from the invariants exported or inserted in the bitcode',
+                    dest='crab_reduce_constraints', default=False, action='store_true')
+    p.add_argument('--crab-fn-timeout-ms', type=int,
+                    help='Max time in milliseconds to analyze a function before switching to intervals (only intra-procedural analysis)',
+                    dest='crab_fn_timeout_ms', default=0, metavar='MS')
+    p.add_argument('--crab-fn-mem-mb', type=int,
+                    help='Max memory in MB to analyze a function before switching to intervals (only intra-procedural analysis)',
+                    dest='crab_fn_mem_mb', default=0, metavar='MB')
+    p.add_argument('--crab-module-budget', type=int,
+                    help='Time in seconds to analyze the whole module: expensive functions are analyzed '
+                    'with cheaper options if it would be exceeded (only intra-procedural analysis)',
+                    dest='crab_module_budget', default=0, metavar='SEC')
     p.add_argument('--crab-backward',
                     help='Run iterative forward/backward analysis (only intra version available and very experimental)',
                     dest='crab_backward', default=False, action='store_true')
+    p.add_argument('--crab-backward-cone',
+                    help='Run the backward analysis only on the blocks that can reach assertions not proven by the forward analysis',
+                    dest='crab_backward_cone', default=False, action='store_true')
     # --crab-live may lose precision e.g. when computing summaries.
     # However, note that due to non-monotonicity of operators such as widening the use of
     # liveness information may actually improve precision. Thus, it's quite unpredictable
@@ -296,29 +624,99 @@ def parseArgs(argv):
     p.add_argument('--crab-live',
                     help='Use of liveness information: may lose precision with relational domains.',
                     dest='crab_live', default=False, action='store_true')        
+    p.add_argument('--crab-no-live-compact',
+                    help='Do not remove the dimensions of the dead variables from the oct and pk states',
+                    dest='crab_no_live_compact', default=False, action='store_true')
+    p.add_argument('--crab-reuse-live',
+                    help='Use the liveness computed for --crab-relational-threshold to remove dead variables',
+                    dest='crab_reuse_live', default=False, action='store_true')
     p.add_argument('--crab-add-invariants',
                     help='Instrument code with invariants',
-                    choices=['none', 'block-entry', 'after-load', 'all'],
+                    choices=['none', 'block-entry', 'after-load', 'loop-header', 'all'],
                     dest='insert_invs', default='none')
+    p.add_argument('--crab-add-invariants-relevant-vars',
+                    help='Only add constraints over variables that appear in assertions or branch conditions',
+                    dest='insert_invs_relevant_vars', default=False, action='store_true')
+    p.add_argument('--crab-add-invariants-threads', metavar='INT',
+                    help='Number of threads used to compute the invariants to be inserted',
+                    dest='insert_invs_threads', type=int, default=1)
+    p.add_argument('--crab-add-invariants-metadata',
+                    help='Attach the invariants as !crab.inv metadata instead of inserting verifier.assume instructions',
+                    dest='insert_invs_metadata', default=False, action='store_true')
     p.add_argument('--crab-do-not-store-invariants',
                     help='Do not store invariants',
                     dest='store_invariants', default=True, action='store_false')        
     p.add_argument('--crab-promote-assume',
                     help='Promote verifier.assume calls to llvm.assume intrinsics',
                     dest='crab_promote_assume', default=False, action='store_true')
+    p.add_argument('--crab-streaming',
+                    help='Insert the invariants of each function as soon as it is analyzed and then release its invariants and CFG',
+                    dest='crab_streaming', default=False, action='store_true')
     p.add_argument('--crab-check',
                     help='Check assertions: user assertions, null dereference, etc',
                     choices=['none', 'assert', 'null'],
                     dest='assert_check', default='none')
+    p.add_argument('--crab-check-null-fast',
+                    help='Check null dereferences with a dedicated nullity analysis instead of the abstract domain',
+                    dest='crab_check_null_fast', default=False, action='store_true')
+    p.add_argument('--crab-discharge-trivial-checks',
+                    help='Decide the assertions that only depend on constants before the analysis',
+                    dest='crab_discharge_trivial_checks', default=False, action='store_true')
     p.add_argument('--crab-check-verbose', metavar='INT',
                     help='Print verbose information about checks\n' + 
                          '>=1: only error checks\n' + 
                          '>=2: error and warning checks\n' + 
                          '>=3: error, warning, and safe checks',
                     dest='check_verbose', type=int, default=0)
+    p.add_argument('--crab-schedule-checks',
+                    help='Analyze first the functions that are more likely to fail (only intra-procedural analysis)',
+                    dest='crab_schedule_checks', default=False, action='store_true')
+    p.add_argument('--crab-stop-on-error',
+                    help='Stop the analysis after the first function with an error check (only intra-procedural analysis)',
+                    dest='crab_stop_on_error', default=False, action='store_true')
+    p.add_argument('--crab-dedup-functions',
+                    help='Analyze only once the functions that are identical up to the names of their values (only intra-procedural analysis)',
+                    dest='crab_dedup_functions', default=False, action='store_true')
+    p.add_argument('--crab-check-layered',
+                    help='Prove assertions with intervals first and try terms+zones, octagons and polyhedra '
+                    'only on functions with unproven assertions (only intra-procedural analysis)',
+                    dest='crab_check_layered', default=False, action='store_true')
+    p.add_argument('--crab-check-asserting-blocks',
+                    help='Check assertions by revisiting only the blocks with assertions '
+                    '(only intra-procedural analysis)',
+                    dest='crab_check_asserting_blocks', default=False, action='store_true')
+    p.add_argument('--crab-portfolio',
+                    help='Analyze each function with these comma-separated domains at the same time, '
+                    'from the least to the most precise, and keep the best result '
+                    '(only intra-procedural analysis)',
+                    dest='crab_portfolio', default=None, metavar='DOMAINS')
+    p.add_argument('--crab-slice-checks',
+                    help='Remove statements that cannot affect the checks before the analysis '
+                    '(only intra-procedural analysis and if invariants are not printed)',
+                    dest='crab_slice_checks', default=False, action='store_true')
+    p.add_argument('--crab-check-only',
+                    help='Check only the assertion at FILE:LINE. Only the functions needed to prove it are analyzed',
+                    dest='crab_check_only', default=None, metavar='FILE:LINE')
+    p.add_argument('--crab-roots',
+                    help='Analyze only the functions reachable in the call graph from these '
+                    'comma-separated functions',
+                    dest='crab_roots', default=None, metavar='FUNCTIONS')
     p.add_argument('--crab-print-summaries',
                     help='Display computed summaries (if --crab-inter)',
                     dest='print_summs', default=False, action='store_true')
+    p.add_argument('--crab-export-summaries',
+                    help='Write the computed summaries in FILE (if --crab-inter)',
+                    dest='export_summs', default=None, metavar='FILE')
+    p.add_argument('--crab-import-summaries',
+                    help='Compare the computed summaries with the ones written in FILE by --crab-export-summaries (if --crab-inter)',
+                    dest='import_summs', default=None, metavar='FILE')
+    p.add_argument('--crab-compact-summaries',
+                    help='Project the printed and exported summaries onto the inputs and outputs '
+                    'and remove their redundant constraints',
+                    dest='compact_summs', default=False, action='store_true')
+    p.add_argument('--crab-summary-max-relational', type=int,
+                    help='Keep at most N relational constraints of each compacted summary (0: no limit)',
+                    dest='summ_max_relational', default=0, metavar='N')
     p.add_argument('--crab-print-preconditions',
                     help='Display computed necessary preconditions (if --crab-backward)',
                     dest='print_preconds', default=False, action='store_true')
@@ -334,6 +732,12 @@ def parseArgs(argv):
     p.add_argument('--crab-stats',
                     help='Display crab statistics',
                     dest='print_stats', default=False, action='store_true')    
+    p.add_argument('--crab-stats-constraints',
+                    help='Measure the size of invariants in --crab-stats by their number of linear constraints (more expensive)',
+                    dest='stats_constraints', default=False, action='store_true')
+    p.add_argument('--crab-alloc-stats',
+                    help='Print with --crab-stats the allocations of each analysis phase and function',
+                    dest='alloc_stats', default=False, action='store_true')
     p.add_argument('--crab-disable-warnings',
                     help='Disable crab-llvm and crab warnings',
                     dest='crab_disable_warnings', default=False, action='store_true')
@@ -367,6 +771,10 @@ def parseArgs(argv):
     
     #### END CRAB
     
+    return p
+
+def parseArgs(argv):
+    p = argParser()
     args = p.parse_args(argv)
     
     if args.L < 0 or args.L > 3:
@@ -375,8 +783,107 @@ def parseArgs(argv):
     if args.machine != 32 and args.machine != 64:
         p.error("Unknown option -m%s" % args.machine)
 
+    if args.project is None and not args.file:
+        p.error("too few arguments")
+    if args.project is not None and args.file:
+        p.error("--project does not take input files")
+
     return args
 
+# Return the input files denoted by the (possibly glob) patterns
+def expandInputs(patterns):
+    import glob
+    res = []
+    for pat in patterns:
+        matches = sorted(glob.glob(pat))
+        if matches: res.extend(matches)
+        else: res.append(pat)
+    return res
+
+# Command line of batch mode without the inputs and the batch
+# options. The inputs are removed by position, so an option value
+# equal to an input is kept.
+def batchChildArgs(argv):
+    p = argParser()
+    res = []
+    i = 0
+    only_inputs = False
+    while i < len(argv):
+        a = argv[i]
+        i += 1
+        if only_inputs or a == '-' or not a.startswith('-'):
+            # -- an input
+            continue
+        if a == '--':
+            only_inputs = True
+            continue
+        name = a.split('=', 1)[0]
+        act = p._option_string_actions.get(name)
+        takes_value = act is not None and act.nargs != 0 and '=' not in a
+        if name in ['--jobs', '--batch-report']:
+            if takes_value: i += 1
+            continue
+        res.append(a)
+        if takes_value and i < len(argv):
+            res.append(argv[i])
+            i += 1
+    return res
+
+def runBatchJob(job):
+    import json
+    (cmd, in_name) = job
+    sw = stats.Stopwatch()
+    p = sub.Popen(cmd + [in_name], stdout=sub.PIPE, stderr=sub.STDOUT)
+    out = p.communicate()[0]
+    sw.stop()
+    brunch = {}
+    stages = []
+    for line in out.splitlines():
+        if line.startswith('BRUNCH_STAGES '):
+            stages = json.loads(line.split(None, 1)[1])
+        elif line.startswith('BRUNCH_STAT'):
+            parts = line.split(None, 2)
+            if len(parts) == 3: brunch[parts[1]] = parts[2]
+    return {'file': in_name, 'returncode': p.returncode,
+            'time': sw.elapsed, 'stats': brunch, 'stages': stages, 'output': out}
+
+# Analyze each input file in a separate process. Each process enforces
+# its own --cpu and --mem limits.
+def batchMain(argv, args, inputs):
+    import multiprocessing
+    import json
+    jobs = args.jobs if args.jobs > 0 else multiprocessing.cpu_count()
+    cmd = [sys.executable, os.path.realpath(__file__)] + \
+          batchChildArgs(argv[1:])
+    pool = multiprocessing.Pool(jobs)
+    try:
+        results = pool.map(runBatchJob, [(cmd, f) for f in inputs])
+    finally:
+        pool.close()
+        pool.join()
+
+    failed = 0
+    for r in results:
+        print 'BATCH {0} exit={1} time={2:.2f} result={3}'.format(
+            r['file'], r['returncode'], r['time'], r['stats'].get('Result', 'UNKNOWN'))
+        if r['returncode'] != 0: failed += 1
+        # aggregate numeric statistics of all files
+        for k, v in r['stats'].iteritems():
+            try: val = float(v)
+            except ValueError:
+                stats.count('{0}.{1}'.format(k, v))
+                continue
+            prev = stats.get(k)
+            stats.put(k, val if prev is None else prev + val)
+    stats.put('BatchFiles', len(results))
+    stats.put('BatchFailed', failed)
+
+    if args.batch_report is not None:
+        with open(args.batch_report, 'w') as f:
+            json.dump([dict((k, v) for k, v in r.iteritems() if k != 'output')
+                       for r in results], f, indent=1, sort_keys=True)
+    return 0 if failed == 0 else 1
+
 def createWorkDir(dname = None, save = False):
     if dname is None:
         workdir = tempfile.mkdtemp(prefix='crabllvm-')
@@ -435,6 +942,11 @@ def getClang(is_plus_plus):
         raise IOError('clang was not found')
     return cmd_name
 
+def getLlvmLink():
+    cmd_name = which(['llvm-link-mp-3.8', 'llvm-link-3.8', 'llvm-link'])
+    if cmd_name is None: raise IOError('llvm-link was not found')
+    return cmd_name
+
 def getOptLlvm():
     cmd_name = which(['seaopt', 'opt-mp-3.8', 'opt-3.8', 'opt'])
     if cmd_name is None: raise IOError('neither seaopt nor opt where found')
@@ -464,6 +976,44 @@ def defOutPPName(name, wd=None):
     return os.path.join(wd, fname)
 
 
+### Cache of the frontend outputs (--cache-dir)
+# The name of a cached file is a hash of the command (without the
+# input and output file names), the tool binary and the content of
+# the input file. Files included by a source file are not considered.
+def _cacheFile(cmd, in_name, out_name):
+    import hashlib
+    h = hashlib.sha1()
+    for a in cmd:
+        if a == in_name: a = '<in>'
+        elif a == out_name: a = '<out>'
+        h.update(a + '\0')
+    tool = os.stat(os.path.realpath(cmd[0]))
+    h.update('{0}:{1}\0'.format(tool.st_size, tool.st_mtime))
+    h.update(os.environ.get('C_INCLUDE_PATH', '') + '\0')
+    with open(in_name, 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 16), ''):
+            h.update(chunk)
+    return os.path.join(cache_dir, h.hexdigest() + os.path.splitext(out_name)[1])
+
+# Copy in out_name the cached output of cmd (if any)
+def fromCache(cmd, in_name, out_name):
+    if cache_dir is None: return False
+    cached = _cacheFile(cmd, in_name, out_name)
+    if not os.path.isfile(cached): return False
+    if verbose: print '--- Reused {0} from {1}'.format(out_name, cached)
+    shutil.copy2(cached, out_name)
+    return True
+
+# Store out_name as the output of cmd
+def toCache(cmd, in_name, out_name):
+    if cache_dir is None: return
+    if not os.path.isdir(cache_dir): os.makedirs(cache_dir)
+    cached = _cacheFile(cmd, in_name, out_name)
+    # several processes can share the cache (e.g., batch mode)
+    tmp = '{0}.{1}.tmp'.format(cached, os.getpid())
+    shutil.copy2(out_name, tmp)
+    os.rename(tmp, cached)
+
 def _plus_plus_file(name):
     ext = os.path.splitext(name)[1]
     return ext == '.cpp' or ext == '.cc'
@@ -491,6 +1041,7 @@ def clang(in_name, out_name, arch=32, extra_args=[]):
     clang_args.extend(extra_args)
     clang_args.append('-m{0}'.format(arch))
 
+    if fromCache(clang_args, in_name, out_name): return
     if verbose: print ' '.join(clang_args)
     returnvalue, timeout, out_of_mem, segfault, unknown = run_command_with_limits(clang_args, -1, -1)
     if timeout:
@@ -499,6 +1050,96 @@ def clang(in_name, out_name, arch=32, extra_args=[]):
         sys.exit(FRONTEND_MEMORY_OUT)
     elif segfault or unknown or returnvalue <> 0:
         sys.exit(CLANG_ERROR)    
+    toCache(clang_args, in_name, out_name)
+
+### Project mode (--project)
+# The clang command of a compilation database entry: the original
+# command without the compiler, the input, the output, the
+# optimization level (see -O) and the dependency options, that emits
+# bitcode in out_name.
+def projectClangArgs(entry, out_name, arch):
+    import shlex
+    if 'arguments' in entry: cmd = list(entry['arguments'])
+    else: cmd = shlex.split(entry['command'])
+    in_name = entry['file']
+    full_name = os.path.normpath(os.path.join(entry['directory'], in_name))
+    res = [getClang(_plus_plus_file(in_name)), '-emit-llvm', '-c', '-o', out_name]
+    skip = False
+    for a in cmd[1:]:
+        if skip:
+            skip = False
+            continue
+        if a in ['-o', '-MF', '-MT', '-MQ']:
+            skip = True
+            continue
+        if a in ['-c', '-S', '-M', '-MM', '-MD', '-MMD', '-MP'] or \
+           os.path.normpath(os.path.join(entry['directory'], a)) == full_name or \
+           a.startswith('-o') or a.startswith('-O') or a in ['-m32', '-m64']:
+            continue
+        res.append(a)
+    res.append('-m{0}'.format(arch))
+    res.append(in_name)
+    return res
+
+# Compile one entry of the compilation database. Return an error
+# message or None.
+def projectCompile(job):
+    (entry, out_name, arch) = job
+    in_name = os.path.join(entry['directory'], entry['file'])
+    if os.path.splitext(in_name)[1] == '.bc':
+        shutil.copy2(in_name, out_name)
+        return None
+    clang_args = projectClangArgs(entry, out_name, arch)
+    if fromCache(clang_args, in_name, out_name): return None
+    if verbose: print ' '.join(clang_args)
+    p = sub.Popen(clang_args, cwd=entry['directory'], stdout=sub.PIPE, stderr=sub.STDOUT)
+    out = p.communicate()[0]
+    if p.returncode != 0:
+        return '{0}: clang failed\n{1}'.format(in_name, out)
+    toCache(clang_args, in_name, out_name)
+    return None
+
+# Compile in parallel the files of the compilation database and link
+# them in out_name
+def projectBuild(args, workdir, out_name):
+    import json
+    import multiprocessing
+    from multiprocessing.pool import ThreadPool
+    with open(args.project) as f:
+        entries = json.load(f)
+    if not entries:
+        print 'ERROR: no files in ' + args.project
+        sys.exit(CLANG_ERROR)
+    jobs = args.jobs if args.jobs > 0 else multiprocessing.cpu_count()
+    bcs = []
+    work = []
+    for i, e in enumerate(entries):
+        e = dict(e)
+        e['directory'] = os.path.abspath(e.get('directory', '.'))
+        bc = os.path.join(workdir, '{0}-{1}'.format(i, os.path.basename(defBCName(e['file']))))
+        bcs.append(bc)
+        work.append((e, bc, args.machine))
+    # -- the compilations are subprocesses so threads are enough
+    pool = ThreadPool(jobs)
+    try:
+        errors = [e for e in pool.map(projectCompile, work) if e is not None]
+    finally:
+        pool.close()
+        pool.join()
+    if errors:
+        for e in errors: print 'ERROR: ' + e
+        sys.exit(CLANG_ERROR)
+
+    link_args = [getLlvmLink(), '-o', out_name] + bcs
+    if verbose: print ' '.join(link_args)
+    returnvalue, timeout, out_of_mem, segfault, unknown = \
+        run_command_with_limits(link_args, args.cpu, args.mem)
+    if timeout:
+        sys.exit(FRONTEND_TIMEOUT)
+    elif out_of_mem:
+        sys.exit(FRONTEND_MEMORY_OUT)
+    elif segfault or unknown or returnvalue <> 0:
+        sys.exit(CLANG_ERROR)
 
 # Run llvm optimizer
 def optLlvm(in_name, out_name, args, extra_args=[], cpu = -1, mem = -1):
@@ -526,6 +1167,7 @@ def optLlvm(in_name, out_name, args, extra_args=[], cpu = -1, mem = -1):
     opt_args.extend(extra_args)
     opt_args.append(in_name)
 
+    if fromCache(opt_args, in_name, out_name): return
     if verbose: print ' '.join(opt_args)
     returnvalue, timeout, out_of_mem, segfault, unknown = run_command_with_limits(opt_args, cpu, mem)
     if timeout:
@@ -534,6 +1176,7 @@ def optLlvm(in_name, out_name, args, extra_args=[], cpu = -1, mem = -1):
         sys.exit(FRONTEND_MEMORY_OUT)
     elif unknown or returnvalue <> 0:
         sys.exit(OPT_ERROR)
+    toCache(opt_args, in_name, out_name)
 
 # Generate dot files for each LLVM function.
 def dot(in_name, view_dot = False, cpu = -1, mem = -1):
@@ -544,32 +1187,47 @@ def dot(in_name, view_dot = False, cpu = -1, mem = -1):
     ## We don't bother here analyzing the exit code
     run_command_with_limits(args, cpu, mem, fnull)
     
-# Run crabpp
-def crabpp(in_name, out_name, args, extra_args=[], cpu = -1, mem = -1):
-    if out_name == '' or out_name == None:
-        out_name = defPPName(in_name)
-
-    crabpp_args = [getCrabLlvmPP(), '-o', out_name, in_name ]
+# Options of crabpp that are also understood by crabllvm --with-pp
+def crabppOpts(args):
+    opts = []
     if args.inline: 
-        crabpp_args.append('--crab-inline-all')
+        opts.append('--crab-inline-all')
+    if args.inline_budget > 0:
+        opts.append('--crab-inline-budget={0}'.format(args.inline_budget))
     if args.pp_loops: 
-        crabpp_args.append('--crab-llvm-pp-loops')
-    if args.undef_nondet:
-        crabpp_args.append( '--crab-turn-undef-nondet')
+        opts.append('--crab-llvm-pp-loops')
     if args.disable_lower_gv:
-        crabpp_args.append( '--crab-lower-gv=false')
+        opts.append( '--crab-lower-gv=false')
+    if args.lower_gv_max_calls > 0:
+        opts.append('--crab-lower-gv-max-calls={0}'.format(args.lower_gv_max_calls))
     if args.lower_unsigned_icmp:
-        crabpp_args.append( '--crab-lower-unsigned-icmp')
+        opts.append( '--crab-lower-unsigned-icmp')
     if args.devirt is not 'none':
-        crabpp_args.append('--crab-devirt')
+        opts.append('--crab-devirt')
         if args.devirt == 'types':
-            crabpp_args.append('--devirt-resolver=types')            
+            opts.append('--devirt-resolver=types')            
         elif args.devirt == 'dsa':
-            crabpp_args.append('--devirt-resolver=dsa')            
+            opts.append('--devirt-resolver=dsa')            
+        if args.devirt_max_bounce_targets > 0:
+            opts.append('--devirt-max-bounce-targets={0}'.format(args.devirt_max_bounce_targets))
     if args.enable_ext_funcs:
-        crabpp_args.append('--crab-externalize-addr-taken-funcs')
+        opts.append('--crab-externalize-addr-taken-funcs')
+    return opts
+
+# Run crabpp
+def crabpp(in_name, out_name, args, extra_args=[], cpu = -1, mem = -1):
+    if out_name == '' or out_name == None:
+        out_name = defPPName(in_name)
+
+    crabpp_args = [getCrabLlvmPP(), '-o', out_name, in_name ]
+    crabpp_args.extend(crabppOpts(args))
+    if args.undef_nondet:
+        crabpp_args.append( '--crab-turn-undef-nondet')
+    if args.pp_jobs > 1:
+        crabpp_args.append('--crab-pp-jobs={0}'.format(args.pp_jobs))
         
     crabpp_args.extend(extra_args)
+    if fromCache(crabpp_args, in_name, out_name): return
     if verbose: print ' '.join(crabpp_args)
     returnvalue, timeout, out_of_mem, segfault, unknown = run_command_with_limits(crabpp_args, cpu, mem)
     if timeout:
@@ -578,9 +1236,10 @@ def crabpp(in_name, out_name, args, extra_args=[], cpu = -1, mem = -1):
         sys.exit(FRONTEND_MEMORY_OUT)
     elif segfault or unknown or returnvalue <> 0:
         sys.exit(PP_ERROR)
+    toCache(crabpp_args, in_name, out_name)
     
-# Run crabllvm
-def crabllvm(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
+# Command line of crabllvm
+def crabllvmCmd(in_name, out_name, args, extra_opts):
     crabllvm_cmd = [ getCrabLlvm(), in_name, '-oll', out_name]
     crabllvm_cmd = crabllvm_cmd + extra_opts
     
@@ -589,37 +1248,151 @@ def crabllvm(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
 
     if args.crab_verbose:
         crabllvm_cmd.append('--crab-verbose={0}'.format(args.crab_verbose))
+    if args.crab_verbose_rate > 0:
+        crabllvm_cmd.append('--crab-verbose-rate={0}'.format(args.crab_verbose_rate))
     if args.crab_only_cfg:
         crabllvm_cmd.append('--crab-only-cfg')
     ## This option already run in crabpp    
     if args.undef_nondet: crabllvm_cmd.append( '--crab-turn-undef-nondet')
         
     if args.lower_select: crabllvm_cmd.append( '--crab-lower-select')
+    if args.lower_relevant_select: crabllvm_cmd.append( '--crab-lower-relevant-select')
     crabllvm_cmd.append('--crab-dom={0}'.format(args.crab_dom))
     crabllvm_cmd.append('--crab-inter-sum-dom={0}'.format(args.crab_inter_sum_dom))
+    if args.inter_prune: crabllvm_cmd.append('--crab-inter-prune')
+    if args.inter_sum_threshold > 0:
+        crabllvm_cmd.append('--crab-inter-sum-threshold={0}'.format(args.inter_sum_threshold))
     crabllvm_cmd.append('--crab-widening-delay={0}'.format(args.widening_delay))
     crabllvm_cmd.append('--crab-widening-jump-set={0}'.format(args.widening_jump_set))
+    if args.widening_auto_jump_set > 0:
+        crabllvm_cmd.append('--crab-widening-auto-jump-set={0}'.format(args.widening_auto_jump_set))
+    if args.lazy_names: crabllvm_cmd.append('--crab-lazy-names')
     crabllvm_cmd.append('--crab-narrowing-iterations={0}'.format(args.narrowing_iterations))
     crabllvm_cmd.append('--crab-relational-threshold={0}'.format(args.num_threshold))
+    if args.num_threshold_loops: crabllvm_cmd.append('--crab-relational-threshold-loops')
+    if args.num_threshold_packs: crabllvm_cmd.append('--crab-relational-threshold-packs')
+    if args.num_threshold_estimate: crabllvm_cmd.append('--crab-relational-threshold-estimate')
+    if args.crab_adapt_cost is not None:
+        crabllvm_cmd.append('--crab-adapt-cost-ms={0}'.format(args.crab_adapt_cost))
+    if args.crab_terms_max > 0:
+        crabllvm_cmd.append('--crab-terms-max={0}'.format(args.crab_terms_max))
     if args.track == 'arr-no-ptr':    
         crabllvm_cmd.append('--crab-track=arr')
         crabllvm_cmd.append('--crab-disable-ptr')        
     else:
         crabllvm_cmd.append('--crab-track={0}'.format(args.track))        
     crabllvm_cmd.append('--crab-heap-analysis={0}'.format(args.crab_heap_analysis))
+    if args.crab_heap_analysis == 'auto-sea-dsa':
+        crabllvm_cmd.append('--crab-dsa-auto-ms={0}'.format(args.crab_dsa_auto_ms))
+        crabllvm_cmd.append('--crab-dsa-auto-mb={0}'.format(args.crab_dsa_auto_mb))
+        crabllvm_cmd.append('--crab-dsa-auto-fn-regions={0}'.format(args.crab_dsa_auto_fn_regions))
+    if args.crab_heap_snapshot is not None:
+        crabllvm_cmd.append('--crab-heap-snapshot={0}'.format(os.path.abspath(args.crab_heap_snapshot)))
+    if args.crab_region_budget > 0:
+        crabllvm_cmd.append('--crab-region-budget={0}'.format(args.crab_region_budget))
     if args.crab_singleton_aliases: crabllvm_cmd.append('--crab-singleton-aliases')
+    if args.crab_dead_regions: crabllvm_cmd.append('--crab-dead-regions')
     if args.crab_inter: crabllvm_cmd.append('--crab-inter')
+    if args.crab_threads > 1:
+        crabllvm_cmd.append('--crab-threads={0}'.format(args.crab_threads))
+    if args.crab_fixpoint_threads > 1:
+        crabllvm_cmd.append('--crab-fixpoint-threads={0}'.format(args.crab_fixpoint_threads))
+    if args.crab_sparse:
+        crabllvm_cmd.append('--crab-sparse')
+    if args.crab_adaptive_fixpoint:
+        crabllvm_cmd.append('--crab-adaptive-fixpoint')
+        crabllvm_cmd.append('--crab-widening-max-delay={0}'.format(args.widening_max_delay))
+    if args.crab_accelerate_loops:
+        crabllvm_cmd.append('--crab-accelerate-loops')
+    if not args.crab_arena:
+        crabllvm_cmd.append('--crab-arena=false')
+    if args.crab_incremental is not None:
+        crabllvm_cmd.append('--crab-incremental={0}'.format(args.crab_incremental))
+    if args.crab_checks_cache is not None:
+        crabllvm_cmd.append('--crab-checks-cache={0}'.format(args.crab_checks_cache))
+    if args.crab_invariants_storage != 'eager':
+        crabllvm_cmd.append('--crab-invariants-storage={0}'.format(args.crab_invariants_storage))
+    if args.crab_invariants_in_memory != 10000:
+        crabllvm_cmd.append('--crab-invariants-in-memory={0}'.format(args.crab_invariants_in_memory))
+    if args.crab_max_cfgs > 0:
+        crabllvm_cmd.append('--crab-max-cfgs={0}'.format(args.crab_max_cfgs))
+    if args.crab_share_invariants:
+        crabllvm_cmd.append('--crab-share-invariants')
+    if args.crab_boxes_scoped:
+        crabllvm_cmd.append('--crab-boxes-scoped')
+    if args.crab_export_invariants is not None:
+        crabllvm_cmd.append('--crab-export-invariants={0}'.format(args.crab_export_invariants))
+    if args.crab_export_json: crabllvm_cmd.append('--crab-export-json')
+    if args.crab_reduce_constraints: crabllvm_cmd.append('--crab-reduce-constraints')
+    if args.crab_export_invariants_db is not None:
+        crabllvm_cmd.append('--crab-export-invariants-db={0}'.format(args.crab_export_invariants_db))
+    if args.crab_only_functions is not None:
+        crabllvm_cmd.append('--crab-only-functions={0}'.format(args.crab_only_functions))
+    if args.server: crabllvm_cmd.append('--server')
+    if args.crab_profile is not None:
+        crabllvm_cmd.append('--crab-profile={0}'.format(args.crab_profile))
+    if args.crab_config_profile is not None:
+        crabllvm_cmd.append('--crab-config-profile={0}'.format(args.crab_config_profile))
+    if args.crab_profile_counters:
+        crabllvm_cmd.append('--crab-profile-counters')
+    if args.crab_trace is not None:
+        crabllvm_cmd.append('--crab-trace={0}'.format(os.path.abspath(args.crab_trace)))
+    if args.crab_extract_slow > 0:
+        crabllvm_cmd.append('--crab-extract-slow={0}'.format(args.crab_extract_slow))
+        crabllvm_cmd.append('--crab-extract-dir={0}'.format(os.path.abspath(args.crab_extract_dir)))
+    if args.crab_checks_stream is not None:
+        crabllvm_cmd.append('--crab-checks-stream={0}'.format(args.crab_checks_stream))
+    if args.crab_fn_timeout_ms > 0:
+        crabllvm_cmd.append('--crab-fn-timeout-ms={0}'.format(args.crab_fn_timeout_ms))
+    if args.crab_fn_mem_mb > 0:
+        crabllvm_cmd.append('--crab-fn-mem-mb={0}'.format(args.crab_fn_mem_mb))
+    if args.crab_module_budget > 0:
+        crabllvm_cmd.append('--crab-module-budget={0}'.format(args.crab_module_budget))
     if args.crab_backward: crabllvm_cmd.append('--crab-backward')
+    if args.crab_backward_cone: crabllvm_cmd.append('--crab-backward-cone')
     if args.crab_live: crabllvm_cmd.append('--crab-live')
+    if args.crab_reuse_live: crabllvm_cmd.append('--crab-reuse-live')
+    if args.crab_no_live_compact: crabllvm_cmd.append('--crab-live-compact=false')
     crabllvm_cmd.append('--crab-add-invariants={0}'.format(args.insert_invs))
+    if args.insert_invs_relevant_vars:
+        crabllvm_cmd.append('--crab-add-invariants-relevant-vars')
+    if args.insert_invs_threads > 1:
+        crabllvm_cmd.append('--crab-add-invariants-threads={0}'.format(args.insert_invs_threads))
+    if args.insert_invs_metadata:
+        crabllvm_cmd.append('--crab-add-invariants-metadata')
     if args.crab_promote_assume: crabllvm_cmd.append('--crab-promote-assume')
+    if args.crab_streaming: crabllvm_cmd.append('--crab-streaming')
     if args.assert_check: crabllvm_cmd.append('--crab-check={0}'.format(args.assert_check))
     if args.check_verbose:
         crabllvm_cmd.append('--crab-check-verbose={0}'.format(args.check_verbose))
+    if args.crab_check_null_fast: crabllvm_cmd.append('--crab-check-null-fast')
+    if args.crab_discharge_trivial_checks:
+        crabllvm_cmd.append('--crab-discharge-trivial-checks')
+    if args.crab_schedule_checks: crabllvm_cmd.append('--crab-schedule-checks')
+    if args.crab_stop_on_error: crabllvm_cmd.append('--crab-stop-on-error')
+    if args.crab_dedup_functions: crabllvm_cmd.append('--crab-dedup-functions')
+    if args.crab_check_layered: crabllvm_cmd.append('--crab-check-layered')
+    if args.crab_check_asserting_blocks: crabllvm_cmd.append('--crab-check-asserting-blocks')
+    if args.crab_portfolio is not None:
+        crabllvm_cmd.append('--crab-portfolio={0}'.format(args.crab_portfolio))
+    if args.crab_slice_checks: crabllvm_cmd.append('--crab-slice-checks')
+    if args.crab_check_only is not None:
+        crabllvm_cmd.append('--crab-check-only={0}'.format(args.crab_check_only))
+    if args.crab_roots is not None:
+        crabllvm_cmd.append('--crab-roots={0}'.format(args.crab_roots))
     if args.print_summs: crabllvm_cmd.append('--crab-print-summaries')
+    if args.export_summs is not None:
+        crabllvm_cmd.append('--crab-export-summaries={0}'.format(args.export_summs))
+    if args.import_summs is not None:
+        crabllvm_cmd.append('--crab-import-summaries={0}'.format(args.import_summs))
+    if args.compact_summs: crabllvm_cmd.append('--crab-compact-summaries')
+    if args.summ_max_relational > 0:
+        crabllvm_cmd.append('--crab-summary-max-relational={0}'.format(args.summ_max_relational))
     if args.print_preconds: crabllvm_cmd.append('--crab-print-preconditions')    
     if args.print_cfg: crabllvm_cmd.append('--crab-print-cfg')
     if args.print_stats: crabllvm_cmd.append('--crab-stats')
+    if args.stats_constraints: crabllvm_cmd.append('--crab-stats-constraints')
+    if args.alloc_stats: crabllvm_cmd.append('--crab-alloc-stats')
     if args.print_assumptions: crabllvm_cmd.append('--crab-print-unjustified-assumptions')
     if args.crab_disable_warnings:
         ## crab-llvm warning messages
@@ -628,6 +1401,10 @@ def crabllvm(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
         crabllvm_cmd.append('--crab-enable-warnings={0}'.format('false'))
     if args.crab_sanity_checks: crabllvm_cmd.append('--crab-sanity-checks')
     if args.crab_cfg_simplify: crabllvm_cmd.append('--crab-cfg-simplify')
+    if args.crab_cfg_dce: crabllvm_cmd.append('--crab-cfg-dce')
+    if args.crab_cfg_threads > 1:
+        crabllvm_cmd.append('--crab-cfg-threads={0}'.format(args.crab_cfg_threads))
+        crabllvm_cmd.append('--crab-cfg-parallel-blocks={0}'.format(args.crab_cfg_parallel_blocks))
     if args.crab_print_invariants:
         crabllvm_cmd.append('--crab-print-invariants')
     if args.store_invariants:
@@ -641,7 +1418,11 @@ def crabllvm(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
     if args.crab_unsound_array_init: crabllvm_cmd.append('--crab-unsound-array-init') 
     if args.crab_keep_shadows: crabllvm_cmd.append('--crab-keep-shadows')
     if args.unsigned_to_signed: crabllvm_cmd.append('--crab-unsigned-to-signed')
-    
+    return crabllvm_cmd
+
+# Run crabllvm
+def crabllvm(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
+    crabllvm_cmd = crabllvmCmd(in_name, out_name, args, extra_opts)
     if verbose: print ' '.join(crabllvm_cmd)
 
     if args.out_name is not None:
@@ -658,6 +1439,154 @@ def crabllvm(in_name, out_name, args, extra_opts, cpu = -1, mem = -1):
         # crab returns EXIT_FAILURE which in most platforms is 1 but not in all.
         sys.exit(CRAB_ERROR)
     
+### Distributed mode (--shards)
+# The trackable functions are split into shards and each shard is
+# analyzed by a crabllvm worker with --crab-only-functions. The
+# workers write their checks and invariants as JSON lines in the
+# shard directory and they are merged here. The bitcode and the
+# shard directory must be visible from all hosts.
+
+## workers that are still running (killed by killall)
+shard_processes = []
+
+def getLlvmNm():
+    cmd_name = which(['llvm-nm-mp-3.8', 'llvm-nm-3.8', 'llvm-nm'])
+    if cmd_name is None: raise IOError('llvm-nm was not found')
+    return cmd_name
+
+# Return the names of the functions defined in the bitcode file
+def definedFunctions(in_name):
+    p = sub.Popen([getLlvmNm(), '--defined-only', in_name], stdout=sub.PIPE)
+    out, _ = p.communicate()
+    if p.returncode <> 0:
+        raise IOError('llvm-nm failed on {0}'.format(in_name))
+    names = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[-2] in ['T', 't', 'W', 'w']:
+            names.append(parts[-1])
+    return sorted(set(names))
+
+# Command line of the worker of a shard
+def shardCmd(in_name, args, extra_opts, shard_dir, i):
+    import copy
+    prefix = os.path.join(shard_dir, 'shard{0}'.format(i))
+    wargs = copy.copy(args)
+    wargs.crab_only_functions = prefix + '.functions'
+    wargs.crab_checks_stream = prefix + '.checks' if args.assert_check else None
+    wargs.crab_export_invariants = prefix + '.inv' if args.crab_export_invariants else None
+    wargs.crab_export_json = True
+    # -- outputs that cannot be merged
+    wargs.crab_export_invariants_db = None
+    wargs.crab_profile = None
+    wargs.crab_config_profile = None
+    wargs.crab_trace = None
+    wargs.export_summs = None
+    wargs.server = False
+    wargs.crab_streaming = False
+    wargs.out_name = None
+    cmd = crabllvmCmd(in_name, prefix + '.ll', wargs, extra_opts)
+    hosts = args.shard_hosts.split(',') if args.shard_hosts else []
+    launcher = args.shard_launcher
+    if launcher is None and hosts: launcher = 'ssh {host} {cmd}'
+    if launcher is None: return cmd
+    import shlex
+    import pipes
+    host = hosts[i % len(hosts)] if hosts else ''
+    quoted = ' '.join(pipes.quote(a) for a in cmd)
+    res = []
+    for a in shlex.split(launcher):
+        if a == '{cmd}': res.append(quoted)
+        else: res.append(a.replace('{host}', host))
+    if '{cmd}' not in launcher: res.extend(cmd)
+    return res
+
+# Copy in out the JSON lines of in_name about the functions of the shard
+def mergeShardFile(in_name, out, functions):
+    import json
+    records = []
+    if not os.path.isfile(in_name): return records
+    with open(in_name) as f:
+        for line in f:
+            if not line.strip(): continue
+            rec = json.loads(line)
+            # -- the callees of the shard are also analyzed by its worker
+            if functions is not None and rec.get('function') not in functions: continue
+            records.append(rec)
+            if out is not None: out.write(line)
+    return records
+
+def distributedMain(in_name, args, extra_opts, workdir):
+    if args.shard_dir is not None:
+        shard_dir = os.path.abspath(args.shard_dir)
+        if not os.path.isdir(shard_dir): os.makedirs(shard_dir)
+        # -- the workers must see the bitcode
+        shared_in = os.path.join(shard_dir, os.path.basename(in_name))
+        if shared_in != os.path.abspath(in_name): shutil.copy2(in_name, shared_in)
+        in_name = shared_in
+    else:
+        shard_dir = workdir
+    in_name = os.path.abspath(in_name)
+    if args.crab_export_invariants_db is not None or args.crab_streaming or \
+       args.server or args.out_name is not None:
+        print 'WARNING crabllvm.py: --crab-export-invariants-db, --crab-streaming, ' \
+            '--server and -o are ignored with --shards'
+
+    functions = definedFunctions(in_name)
+    num_shards = min(args.shards, len(functions))
+    shards = [functions[i::num_shards] for i in range(num_shards)]
+    for i, shard in enumerate(shards):
+        with open(os.path.join(shard_dir, 'shard{0}.functions'.format(i)), 'w') as f:
+            f.write('\n'.join(shard) + '\n')
+    stats.put('Shards', num_shards)
+
+    results = [None] * num_shards
+    lock = threading.Lock()
+    def runShard(i):
+        cmd = shardCmd(in_name, args, extra_opts, shard_dir, i)
+        if verbose: print ' '.join(cmd)
+        sw = stats.Stopwatch()
+        log = open(os.path.join(shard_dir, 'shard{0}.log'.format(i)), 'w')
+        p = sub.Popen(cmd, stdout=log, stderr=sub.STDOUT)
+        with lock: shard_processes.append(p)
+        p.wait()
+        sw.stop()
+        log.close()
+        with lock: shard_processes.remove(p)
+        results[i] = (p.returncode, sw.elapsed)
+    threads = [threading.Thread(target=runShard, args=(i,)) for i in range(num_shards)]
+    for t in threads: t.start()
+    for t in threads: t.join()
+
+    failed = 0
+    checks = []
+    checks_out = open(args.crab_checks_stream, 'w') if args.crab_checks_stream else None
+    inv_out = open(args.crab_export_invariants, 'w') if args.crab_export_invariants else None
+    try:
+        for i, shard in enumerate(shards):
+            (returncode, elapsed) = results[i]
+            print 'SHARD {0} functions={1} exit={2} time={3:.2f}'.format(
+                i, len(shard), returncode, elapsed)
+            if returncode <> 0:
+                failed += 1
+                continue
+            prefix = os.path.join(shard_dir, 'shard{0}'.format(i))
+            names = set(shard)
+            # -- the inter-procedural checks are written per module
+            checks.extend(mergeShardFile(prefix + '.checks', checks_out,
+                                         None if args.crab_inter else names))
+            mergeShardFile(prefix + '.inv', inv_out, names)
+    finally:
+        if checks_out is not None: checks_out.close()
+        if inv_out is not None: inv_out.close()
+
+    stats.put('ShardsFailed', failed)
+    if args.assert_check:
+        for k in ['safe', 'error', 'warning']:
+            stats.put('Checks.{0}'.format(k), sum(c[k] for c in checks))
+    if failed > 0: sys.exit(CRAB_ERROR)
+    return 0
+
 def main(argv):
     def stat(key, val): stats.put(key, val)
     os.setpgrp()
@@ -676,9 +1605,24 @@ def main(argv):
         return 0
     
     args  = parseArgs(argv[1:])
+    if args.project is None:
+        inputs = expandInputs(args.file)
+        if len(inputs) > 1:
+            return batchMain(argv, args, inputs)
+        args.file = inputs[0]
+    global cache_dir
+    if args.cache_dir is not None:
+        cache_dir = os.path.abspath(args.cache_dir)
     workdir = createWorkDir(args.temp_dir, args.save_temps)
+    if args.project is not None:
+        # -- the whole program is then analyzed as a single bitcode file
+        args.file = os.path.join(workdir, os.path.splitext(os.path.basename(
+            os.path.dirname(os.path.abspath(args.project))) or 'project')[0] + '.bc')
+        with stats.timer('Clang'):
+            projectBuild(args, workdir, args.file)
     in_name = args.file
 
+    with_pp = False
     if args.preprocess:
         bc_out = defBCName(in_name, workdir)
         if bc_out != in_name:
@@ -689,12 +1633,16 @@ def main(argv):
                 #stat('Progress', 'Clang')
         in_name = bc_out
 
-        pp_out = defPPName(in_name, workdir)
-        if pp_out != in_name:
-            with stats.timer('CrabLlvmPP'):
-                crabpp(in_name, pp_out, args=args, cpu=args.cpu, mem=args.mem)
-            #stat('Progress', 'Crab Llvm preprocessor')
-        in_name = pp_out
+        if args.single_process and args.L == 0 and args.shards <= 1:
+            # -- crabllvm runs the preprocessor (--with-pp)
+            with_pp = True
+        else:
+            pp_out = defPPName(in_name, workdir)
+            if pp_out != in_name:
+                with stats.timer('CrabLlvmPP'):
+                    crabpp(in_name, pp_out, args=args, cpu=args.cpu, mem=args.mem)
+                #stat('Progress', 'Crab Llvm preprocessor')
+            in_name = pp_out
 
     if args.L > 0:
         o_out = defOptName(in_name, workdir)
@@ -710,6 +1658,11 @@ def main(argv):
         extra_opts = []
         if args.only_preprocess:
             extra_opts.append('-no-crab')
+        if with_pp:
+            extra_opts.append('--with-pp')
+            extra_opts.extend(crabppOpts(args))
+        if args.shards > 1 and not args.only_preprocess:
+            return distributedMain(in_name, args, extra_opts, workdir)
         crabllvm(in_name, pp_out, args, extra_opts, cpu=args.cpu, mem=args.mem)
 
     if args.dot_cfg: dot(pp_out)
@@ -724,6 +1677,11 @@ def main(argv):
 
 def killall():
     global running_process
+    for p in list(shard_processes):
+        try:
+            p.terminate()
+            p.kill()
+        except OSError: pass
     if running_process != None:
         try:
             running_process.terminate()
@@ -0,0 +1,119 @@
+"""In-process bindings of the crab-llvm library (libCrabLlvmC).
+
+A module is loaded and analyzed once and then queried without
+running crabllvm or parsing its output:
+
+    import crabllvm_lib
+    crabllvm_lib.init(['--crab-dom=zones', '--crab-check=assert'])
+    m = crabllvm_lib.Module('test.pp.bc')
+    print m.checks()
+    for f in m.functions():
+        for b in f['blocks']:
+            print m.invariant(f['name'], b)
+    print m.analyze('main', domain='pk')
+
+The bitcode is expected to be produced by clang (and optionally
+crabllvm-pp). The options of init are the ones of crabllvm and they
+apply to all the modules of the process.
+"""
+
+import ctypes
+import json
+import os
+import os.path
+import sys
+
+root = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+
+class Error(Exception):
+    pass
+
+def _find_library():
+    name = 'libCrabLlvmC.dylib' if sys.platform == 'darwin' else 'libCrabLlvmC.so'
+    if 'CRABLLVM_LIB' in os.environ: return os.environ['CRABLLVM_LIB']
+    for d in [os.path.join(root, 'lib'), os.path.dirname(os.path.realpath(__file__))]:
+        p = os.path.join(d, name)
+        if os.path.isfile(p): return p
+    return name
+
+_lib = None
+
+def _get_lib():
+    global _lib
+    if _lib is not None: return _lib
+    lib = ctypes.CDLL(_find_library())
+    lib.crabllvm_init.argtypes = [ctypes.c_int, ctypes.POINTER(ctypes.c_char_p)]
+    lib.crabllvm_init.restype = ctypes.c_int
+    lib.crabllvm_load.argtypes = [ctypes.c_char_p]
+    lib.crabllvm_load.restype = ctypes.c_void_p
+    lib.crabllvm_dispose.argtypes = [ctypes.c_void_p]
+    lib.crabllvm_dispose.restype = None
+    # -- strings are returned as void* so they can be released with crabllvm_free
+    lib.crabllvm_functions.argtypes = [ctypes.c_void_p]
+    lib.crabllvm_functions.restype = ctypes.c_void_p
+    lib.crabllvm_invariant.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int]
+    lib.crabllvm_invariant.restype = ctypes.c_void_p
+    lib.crabllvm_checks.argtypes = [ctypes.c_void_p]
+    lib.crabllvm_checks.restype = ctypes.c_void_p
+    lib.crabllvm_analyze.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p]
+    lib.crabllvm_analyze.restype = ctypes.c_void_p
+    lib.crabllvm_last_error.argtypes = []
+    lib.crabllvm_last_error.restype = ctypes.c_char_p
+    lib.crabllvm_free.argtypes = [ctypes.c_void_p]
+    lib.crabllvm_free.restype = None
+    _lib = lib
+    return lib
+
+def _result(ptr):
+    lib = _get_lib()
+    if not ptr: raise Error(lib.crabllvm_last_error())
+    try:
+        return json.loads(ctypes.cast(ptr, ctypes.c_char_p).value)
+    finally:
+        lib.crabllvm_free(ptr)
+
+def init(options):
+    """Set the crabllvm options (only the first call has effect)"""
+    args = ['crabllvm'] + list(options)
+    argv = (ctypes.c_char_p * len(args))(*args)
+    lib = _get_lib()
+    if not lib.crabllvm_init(len(args), argv):
+        raise Error(lib.crabllvm_last_error())
+
+class Module(object):
+    """A module analyzed with the options of init"""
+    def __init__(self, filename):
+        lib = _get_lib()
+        self._ref = lib.crabllvm_load(filename)
+        if not self._ref: raise Error(lib.crabllvm_last_error())
+
+    def close(self):
+        if self._ref:
+            _get_lib().crabllvm_dispose(self._ref)
+            self._ref = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def functions(self):
+        """List of {'name': function, 'blocks': [block names]}"""
+        return _result(_get_lib().crabllvm_functions(self._ref))
+
+    def invariant(self, function, block, post=False):
+        """{'bottom': bool, 'constraints': [constraint strings]}"""
+        return _result(_get_lib().crabllvm_invariant(self._ref, function, block,
+                                                     1 if post else 0))
+
+    def checks(self):
+        """{'safe': N, 'error': N, 'warning': N}"""
+        return _result(_get_lib().crabllvm_checks(self._ref))
+
+    def analyze(self, function, domain=None):
+        """Analyze again function (e.g., with another domain) and return its checks"""
+        return _result(_get_lib().crabllvm_analyze(self._ref, function, domain))
@@ -10,6 +10,6 @@ setup(name='crabllvm',
       description='An Abstract Interpretation-based Analyzer for LLVM bitecode',
       url='https://github.com/seahorn/crab-llvm',
       package_dir={'': '${CMAKE_CURRENT_SOURCE_DIR}'},
-      py_modules=['stats'],
+      py_modules=['stats', 'crabllvm_lib'],
       scripts=scripts
       )
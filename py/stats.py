@@ -67,6 +67,8 @@ def lap (name):
 
 
 _statistics = dict()
+# resources used by each command (see stage)
+_stages = list()
 
 def get (key):
     """ Gets a value from statistics table """
@@ -89,6 +91,10 @@ def stop (key):
     sw = get (key)
     if sw is not None: sw.stop ()
 
+def stage (record):
+    """ Records the resources used by a command (a dict) """
+    _stages.append (record)
+
 def count (key):
     """ Increments a named counter """
     c = get (key)
@@ -98,12 +104,15 @@ def count (key):
 def brunch_print ():
     """ Prints the result in brunch format """
 
-    if not _statistics:
+    if not _statistics and not _stages:
       return
 
     print '----------------------------------------------------------------------'
     for k in sorted (_statistics.keys ()):
         print 'BRUNCH_STAT {name} {value}'.format (name=k, value=_statistics [k])
+    if _stages:
+        import json
+        print 'BRUNCH_STAGES {0}'.format (json.dumps (_stages, sort_keys=True))
     print '----------------------------------------------------------------------'
         
 
@@ -0,0 +1,27 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-backward --crab-backward-cone --crab-check=assert --crab-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^BRUNCH_STAT CrabLlvm.count.backward_skipped 2$
+// CHECK: ^BRUNCH_STAT CrabLlvm.count.cone_blocks [1-9][0-9]*$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+// proven by the forward analysis: no backward analysis (as main)
+int f(int n) {
+  int i, x = 0;
+  for (i = 0; i < n; i++) {
+    x++;
+  }
+  __CRAB_assert(x >= 0);
+  return x;
+}
+
+// not proven: the backward analysis runs on its cone
+int g(void) {
+  int x = nd();
+  __CRAB_assert(x > 0);
+  return x;
+}
+
+int main() {
+  return f(nd()) + g();
+}
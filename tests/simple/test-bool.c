@@ -0,0 +1,33 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %crabllvm -O0 --crab-dom=zones --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^3  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+/** 
+   The boolean component of the numerical domains links a flag with
+   the constraint it was computed from. The links must survive the
+   assumptions on the flags and the joins and widenings of the loop.
+**/
+
+int main() {
+  int i, n = 0;
+  int x = nd();
+  int y = nd();
+  _Bool pos = x > 0;
+  _Bool both = x > 0 && y > 0;
+  for (i = 0; i < 10; i++) {
+    n++;
+  }
+  if (pos) {
+    __CRAB_assert(x >= 1);
+  }
+  if (both) {
+    __CRAB_assert(x >= 1);
+    __CRAB_assert(y >= 1);
+  }
+  return n;
+}
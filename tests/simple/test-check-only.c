@@ -0,0 +1,20 @@
+// RUN: %crabllvm -O0 -g --crab-dom=int --crab-check-only=test-check-only.c:17 --crab-check=assert "%s" 2>&1 | OutputCheck %s
+// CHECK: ^1  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+// CHECK: ^Check at test-check-only.c:17: safe$
+
+extern void __CRAB_assert(int);
+
+int main() {
+  int i;
+  int x = 0;
+  for (i = 0; i < 10; i++) {
+    x++;
+  }
+  // only the assertion at line 17 is checked: the next one is an
+  // error otherwise
+  __CRAB_assert(x >= 0);
+  __CRAB_assert(i < 10);
+  return x;
+}
@@ -0,0 +1,22 @@
+// RUN: rm -f %t.prof
+// RUN: %crabllvm -O0 --crab-dom=zones --crab-config-profile=%t.prof --crab-check=assert "%s" > /dev/null 2>&1
+// RUN: %crabllvm -O0 --crab-dom=int --crab-config-profile=%t.prof --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+int main() {
+  int i, x = 0, y = 0;
+  int n = nd();
+  for (i = 0; i < n; i++) {
+    x++;
+    y++;
+  }
+  __CRAB_assert(x >= 0);
+  // needs the zones recorded by the first run: a warning with intervals
+  __CRAB_assert(x == y);
+  return 0;
+}
@@ -0,0 +1,31 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-dedup-functions --crab-check=assert --crab-sanity-checks --crab-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^BRUNCH_STAT CrabLlvm.count.dedup_functions 1$
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+// f and g are identical: only f is analyzed
+int f(int n) {
+  int i, x = 0;
+  for (i = 0; i < n; i++) {
+    x++;
+  }
+  __CRAB_assert(x >= 0);
+  return x;
+}
+
+int g(int n) {
+  int i, x = 0;
+  for (i = 0; i < n; i++) {
+    x++;
+  }
+  __CRAB_assert(x >= 0);
+  return x;
+}
+
+int main() {
+  return f(nd()) + g(nd());
+}
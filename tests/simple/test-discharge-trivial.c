@@ -0,0 +1,20 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-check=assert --crab-discharge-trivial-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^1  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+
+void foo(void) {
+  int x = 5;
+  __CRAB_assert(x > 10);
+}
+
+int main() {
+  int i, x = 0, y = 3;
+  __CRAB_assert(y == 3);
+  for (i = 0; i < 10; i++) x++;
+  __CRAB_assert(x >= 0);
+  foo();
+  return 0;
+}
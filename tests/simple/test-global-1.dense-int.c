@@ -0,0 +1,38 @@
+// RUN: %crabllvm -O0 --lower-unsigned-icmp --crab-dom=dense-int --crab-widening-delay=2 --crab-check=assert --crab-sanity-checks "%s"  2>&1 | OutputCheck %s
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern int __VERIFIER_NONDET();
+extern void __VERIFIER_error() __attribute__((noreturn));
+extern void __CRAB_assert(int);
+
+int e=0;
+int s=2;  
+
+// we should get e=[0,2] and s=[2,5] with thresholds or without applying widening
+// we should get e=[0,+oo] and s=[2,5] otherwise
+
+int main () {
+
+  while (__VERIFIER_NONDET()) {
+    if (s == 2){
+      if (e ==0) e=1;
+      s = 3;
+    }
+    else if (s == 3){
+      if (e ==1) e=2;
+      s=4;
+    }
+    else if (s == 4){
+      if (e == 3) {
+        __VERIFIER_error();
+      }
+      s=5;
+    }
+  }
+  __CRAB_assert (e >= 0 && e <=2);
+  __CRAB_assert (s >= 2 && s <=5);
+  
+  return 42;
+}
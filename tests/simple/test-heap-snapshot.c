@@ -0,0 +1,35 @@
+// RUN: rm -f %t.heap
+// RUN: %crabllvm -O0 --lower-unsigned-icmp --crab-dom=int --crab-track=arr --crab-heap-analysis=ci-sea-dsa --crab-heap-snapshot=%t.heap --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %crabllvm -O0 --lower-unsigned-icmp --crab-dom=int --crab-track=arr --crab-heap-analysis=ci-sea-dsa --crab-heap-snapshot=%t.heap --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+
+/** 
+   The fields of g are accessed through constant GEP expressions.
+   The second run loads their regions from the snapshot.
+**/
+
+struct pair {
+  int x;
+  int y;
+};
+
+struct pair g;
+
+int main (){
+
+  int i;
+  g.x = 0;
+  g.y = 5;
+  for (i=0;i<10;i++) {
+    g.x = 1;
+  }
+
+  __CRAB_assert(g.x >= 0 && g.x <= 1);
+  __CRAB_assert(g.y == 5);
+
+  return g.x + g.y;
+}
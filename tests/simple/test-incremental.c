@@ -0,0 +1,21 @@
+// RUN: rm -rf %t.dir
+// RUN: %crabllvm -O0 --crab-dom=int --crab-incremental=%t.dir --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// RUN: %crabllvm -O0 --crab-dom=int --crab-incremental=%t.dir --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+
+int main() {
+  int i;
+  int x = 1;
+  int y = 0;
+  for (i = 0; i < 10; i++) {
+    x = x + y;
+    y++;
+  }
+  __CRAB_assert(x >= 1);
+  __CRAB_assert(y >= 0);
+  return 0;
+}
@@ -0,0 +1,25 @@
+// RUN: rm -f %t.prof
+// RUN: %crabllvm -O0 --crab-dom=zones --crab-config-profile=%t.prof --crab-check=assert "%s" > /dev/null 2>&1
+// Pretend that main took 100000 seconds so it cannot fit in the budget
+// RUN: sed -i -E 's/^(([^ ]+ ){5})[0-9]+ /\1100000000 /' %t.prof
+// RUN: %crabllvm -O0 --crab-dom=zones --crab-config-profile=%t.prof --crab-module-budget=1 --crab-check=assert "%s" 2>&1 | OutputCheck %s
+// CHECK: ^Warning: 1 functions were analyzed with cheaper options to meet --crab-module-budget$
+// CHECK: ^1  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^1  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+int main() {
+  int i, x = 0, y = 0;
+  int n = nd();
+  for (i = 0; i < n; i++) {
+    x++;
+    y++;
+  }
+  __CRAB_assert(x >= 0);
+  // a warning once main is downgraded to intervals
+  __CRAB_assert(x == y);
+  return 0;
+}
@@ -0,0 +1,17 @@
+// RUN: %crabllvm -O0 --crab-track=ptr --crab-check=null --crab-check-null-fast --crab-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^BRUNCH_STAT CrabLlvm.count.null_dataflow_functions 2$
+// CHECK: ^0  Number of total error checks$
+
+// f and main are checked by the nullity dataflow
+int f(int *p) {
+  if (p) {
+    *p = 1;
+    return *p;
+  }
+  return 0;
+}
+
+int main() {
+  int a;
+  return f(&a) + f(0);
+}
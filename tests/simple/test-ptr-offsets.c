@@ -0,0 +1,35 @@
+// RUN: %crabllvm -O0 --crab-dom=ptr-offsets --crab-track=ptr --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^3  Number of total safe checks$
+// CHECK: ^1  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+int a[10];
+
+int main() {
+  int i, n = 0;
+  int *p = a;
+  for (i = 0; i < 10; i++) {
+    p[i] = i;
+    n++;
+  }
+  __CRAB_assert(n >= 0);
+  __CRAB_assert(i >= 10);
+  int k = nd();
+  if (k > 3) {
+    __CRAB_assert(k < 2); // error
+  }
+  // -- q can be equal to r only if their offsets are not tracked
+  int buf[10];
+  int *q = &buf[1];
+  if (nd()) q = &buf[2];
+  int *r = &buf[7];
+  int x = 0;
+  if (q == r) {
+    x = 1;
+  }
+  __CRAB_assert(x == 0); // warning without ptr-offsets
+  return n;
+}
@@ -0,0 +1,29 @@
+// RUN: %crabllvm -O0 --lower-unsigned-icmp --crab-dom=int --crab-track=arr --crab-heap-analysis=ci-sea-dsa --crab-region-budget=1 --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^1  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^1  Number of total warning checks$
+
+extern int nd ();
+extern void __CRAB_assert(int);
+
+/** 
+   With a budget of one region, a and b are merged into a summary
+   region: the sum is still bounded but a alone is not.
+**/
+
+int a[10];
+int b[10];
+
+int main ()
+{
+  int i;
+  for (i=0;i<10;i++)
+  {
+    a[i] = 1;
+    b[i] = 2;
+  }
+  int res = a[i-1] + b[i-1];
+  __CRAB_assert(res >= 0 && res <= 4);
+  __CRAB_assert(a[i-1] <= 1); // warning
+  return res;
+}
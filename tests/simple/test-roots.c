@@ -0,0 +1,27 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-roots=f --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^1  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+int f(int n) {
+  int i, x = 0;
+  for (i = 0; i < n; i++) {
+    x++;
+  }
+  __CRAB_assert(x >= 0);
+  return x;
+}
+
+// not reachable from f: not analyzed
+int g(int n) {
+  int x = 5;
+  __CRAB_assert(x < 2);
+  return x + n;
+}
+
+int main() {
+  return f(nd()) + g(nd());
+}
@@ -0,0 +1,30 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-schedule-checks --crab-stop-on-error --crab-check=assert "%s" 2>&1 | OutputCheck %s
+// CHECK: ^1  Number of total safe checks$
+// CHECK: ^1  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+// one assertion: analyzed after f, so never analyzed
+int g(int n) {
+  int x = n > 0 ? n : 0;
+  __CRAB_assert(x >= 0);
+  return x;
+}
+
+// two assertions: analyzed first
+int f(int n) {
+  int i, x = 0;
+  int k = 5;
+  for (i = 0; i < n; i++) {
+    x++;
+  }
+  __CRAB_assert(x >= 0);
+  __CRAB_assert(k < 2); // error
+  return x + k;
+}
+
+int main() {
+  return g(nd()) + f(nd());
+}
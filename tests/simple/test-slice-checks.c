@@ -0,0 +1,29 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-slice-checks --crab-check=assert --crab-sanity-checks --crab-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^BRUNCH_STAT CrabLlvm.count.sliced_stmts [1-9][0-9]*$
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^1  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern int nd ();
+extern void __CRAB_assert(int);
+
+int main (){
+
+  int i, j, n, m, k;
+  n = 0;
+  for (i=0;i<10;i++) {
+    n++;
+  }
+  // irrelevant for the checks: sliced away
+  m = 0;
+  for (j=0;j<nd();j++) {
+    m += 2;
+  }
+  k = 5;
+
+  __CRAB_assert(n >= 0);
+  __CRAB_assert(i >= 10);
+  __CRAB_assert(k < 2); // error
+
+  return n+i+k;
+}
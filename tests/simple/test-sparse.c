@@ -0,0 +1,23 @@
+// RUN: %crabllvm -O0 --crab-dom=int --crab-sparse --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^2  Number of total safe checks$
+// CHECK: ^1  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern int nd ();
+extern void __CRAB_assert(int);
+
+int main (){
+
+  int i, n, k;
+  n = 0;
+  for (i=0;i<10;i++) {
+    n++;
+  }
+  k = 5;
+
+  __CRAB_assert(n >= 0);
+  __CRAB_assert(i >= 10);
+  __CRAB_assert(k < 2); // error
+
+  return n+i+k;
+}
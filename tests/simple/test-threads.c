@@ -0,0 +1,36 @@
+// RUN: %crabllvm -O0 --crab-dom=zones --crab-threads=4 --crab-do-not-print-invariants --crab-check=assert --crab-sanity-checks "%s" 2>&1 | OutputCheck %s
+// CHECK: ^4  Number of total safe checks$
+// CHECK: ^0  Number of total error checks$
+// CHECK: ^0  Number of total warning checks$
+
+extern void __CRAB_assert(int);
+extern int nd(void);
+
+void foo(int n) {
+  int i, x = 0;
+  for (i = 0; i < n; i++) x++;
+  __CRAB_assert(x >= 0);
+}
+
+void bar(int n) {
+  int i, y = n;
+  for (i = 0; i < 10; i++) y++;
+  __CRAB_assert(y >= n);
+}
+
+void baz(void) {
+  int x = nd();
+  if (x > 5) {
+    __CRAB_assert(x >= 6);
+  }
+}
+
+int main() {
+  int i, j = 0;
+  for (i = 0; i < 100; i++) j += 2;
+  __CRAB_assert(j >= 0);
+  foo(nd());
+  bar(nd());
+  baz();
+  return 0;
+}
@@ -0,0 +1,16 @@
+// RUN: %crabllvm -O0 --crab-dom=zones --crab-warm-reanalysis --crab-stats "%s" 2>&1 | OutputCheck %s
+// CHECK: ^BRUNCH_STAT CrabLlvm.count.warm_analyses 1$
+
+extern int nd(void);
+
+// the invariants of the first analysis are refined instead of
+// recomputed: no checks since they need a full analysis
+int main() {
+  int i, x = 0, y = 0;
+  int n = nd();
+  for (i = 0; i < n; i++) {
+    x++;
+    y++;
+  }
+  return x - y;
+}
@@ -0,0 +1,62 @@
+///
+// Replacement of operator new and delete that counts the allocations
+// of each thread for --crab-alloc-stats (see Support/AllocStats.hh).
+// Memory obtained directly with malloc (e.g., by llvm bump
+// allocators) is not counted.
+///
+
+#include "crab_llvm/Support/AllocStats.hh"
+
+#include <cstdlib>
+#include <new>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+  struct install_hooks {
+    install_hooks() { crab_llvm::alloc_impl::installed() = true; }
+  } hooks;
+
+  // size of the block, so that frees can be counted as well
+  inline size_t block_size(void *p, size_t n) {
+    #ifdef __GLIBC__
+    return malloc_usable_size(p);
+    #else
+    return n;
+    #endif
+  }
+}
+
+void* operator new(std::size_t n) {
+  void *p = std::malloc(n ? n : 1);
+  if (!p) throw std::bad_alloc();
+  crab_llvm::alloc_impl::on_alloc(block_size(p, n));
+  return p;
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+  void *p = std::malloc(n ? n : 1);
+  if (p) crab_llvm::alloc_impl::on_alloc(block_size(p, n));
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  if (!p) return;
+  #ifdef __GLIBC__
+  crab_llvm::alloc_impl::on_free(malloc_usable_size(p));
+  #endif
+  std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept { operator delete(p); }
+
+void* operator new[](std::size_t n) { return operator new(n); }
+
+void* operator new[](std::size_t n, const std::nothrow_t &t) noexcept {
+  return operator new(n, t);
+}
+
+void operator delete[](void *p) noexcept { operator delete(p); }
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept { operator delete(p); }
@@ -0,0 +1,169 @@
+///
+// Micro-benchmark of the translation from LLVM bitcode to Crab CFG
+///
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/Format.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CfgBuilder.hh"
+#include "crab_llvm/DummyHeapAbstraction.hh"
+#include "crab_llvm/SeaDsaHeapAbstraction.hh"
+#include "crab_llvm/Support/NameValues.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Count all the allocations done by the process with new. This is
+ * the only reason why this benchmark is a separate
+ * executable. Memory obtained directly with malloc (e.g., by llvm
+ * bump allocators) is not counted.
+ **/
+static std::atomic<size_t> num_allocs(0);
+static std::atomic<size_t> num_bytes(0);
+
+void* operator new(std::size_t n) {
+  num_allocs++;
+  num_bytes += n;
+  if (void *p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void* operator new[](std::size_t n) { return operator new(n); }
+
+void operator delete[](void *p) noexcept { operator delete(p); }
+
+static llvm::cl::opt<std::string>
+InputFilename(llvm::cl::Positional, llvm::cl::desc("<input LLVM bitcode file>"),
+              llvm::cl::Required, llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<unsigned>
+Repeat("bench-repeat",
+       llvm::cl::desc("Number of times each CFG is built"),
+       llvm::cl::init(10));
+
+static llvm::cl::opt<crab::cfg::tracked_precision>
+TrackLev("bench-track",
+	 llvm::cl::desc("Track abstraction level of the Crab Cfg"),
+	 llvm::cl::values
+	 (clEnumValN(crab::cfg::NUM, "num", "Integer and Boolean registers only"),
+	  clEnumValN(crab::cfg::PTR, "ptr", "num + pointer offsets"),
+	  clEnumValN(crab::cfg::ARR, "arr", "ptr + memory contents via array abstraction"),
+	  clEnumValEnd),
+	 llvm::cl::init(crab::cfg::NUM));
+
+static llvm::cl::opt<bool>
+UseSeaDsa("bench-sea-dsa",
+	  llvm::cl::desc("Use sea-dsa as heap abstraction (only with -bench-track=arr)"),
+	  llvm::cl::init(true));
+
+using namespace crab_llvm;
+
+int main(int argc, char **argv) {
+  llvm::llvm_shutdown_obj shutdown;  // calls llvm_shutdown() on exit
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+  "CrabLlvm-- Micro-benchmark of the translation to Crab CFG\n"
+  "The input must be already preprocessed (e.g., crabllvm -oll)\n");
+
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::PrettyStackTraceProgram PSTP(argc, argv);
+
+  llvm::SMDiagnostic err;
+  llvm::LLVMContext &context = llvm::getGlobalContext();
+  std::unique_ptr<llvm::Module> module = llvm::parseIRFile(InputFilename, err, context);
+  if (!module) {
+    llvm::errs() << "error: "
+                 << "Bitcode was not properly read; " << err.getMessage() << "\n";
+    return 3;
+  }
+
+  // the translation requires all values to have names
+  NameValues names;
+  names.runOnModule(*module);
+
+  llvm::TargetLibraryInfoImpl tlii(llvm::Triple(module->getTargetTriple()));
+  llvm::TargetLibraryInfo tli(tlii);
+  llvm::CallGraph cg(*module);
+  std::unique_ptr<HeapAbstraction> mem;
+  if (TrackLev == crab::cfg::ARR && UseSeaDsa) {
+    mem.reset(new SeaDsaHeapAbstraction(*module, cg, module->getDataLayout(), tli,
+				       false /*context-insensitive*/));
+  } else {
+    mem.reset(new DummyHeapAbstraction());
+  }
+
+  CfgBuilderProfile profile;
+  profile.num_allocs = []() -> size_t { return num_allocs; };
+  llvm_variable_factory vfac;
+  size_t total_insts = 0;
+  double total_secs = 0;
+
+  llvm::outs() << llvm::format("%-30s %8s %12s %12s %12s\n", "function", "insts",
+			       "insts/sec", "allocs/inst", "bytes/cfg");
+  for (auto &F : *module) {
+    if (F.isDeclaration() || F.empty() || F.isVarArg()) continue;
+
+    size_t insts = 0;
+    for (auto &B : F) insts += B.size();
+
+    double secs = 0;
+    size_t allocs = 0, bytes = 0;
+    unsigned repeat = std::max(1U, (unsigned) Repeat);
+    for (unsigned i = 0; i < repeat; ++i) {
+      size_t allocs_before = num_allocs, bytes_before = num_bytes;
+      auto start = std::chrono::steady_clock::now();
+      {
+	CfgBuilder builder(F, vfac, *mem, TrackLev, false, &tli);
+	// only the first run is profiled by instruction kind since
+	// profiling adds overhead. It is measured only if it is the
+	// only run.
+	if (i == 0) builder.set_profile(&profile);
+	std::unique_ptr<cfg_t> cfg(builder.get_cfg());
+	if (i > 0 || repeat == 1) {
+	  std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+	  secs += d.count();
+	  allocs += num_allocs - allocs_before;
+	  bytes += num_bytes - bytes_before;
+	}
+      }
+    }
+    unsigned runs = (repeat == 1 ? 1U : repeat - 1);
+    total_insts += insts * runs;
+    total_secs += secs;
+    llvm::outs() << llvm::format("%-30s %8zu %12.0f %12.2f %12zu\n",
+				 F.getName().str().c_str(), insts,
+				 secs > 0 ? (insts * runs) / secs : 0.0,
+				 insts > 0 ? (double) allocs / (insts * runs) : 0.0,
+				 bytes / runs);
+  }
+  llvm::outs() << llvm::format("%-30s %8s %12.0f\n\n", "total", "",
+			       total_secs > 0 ? total_insts / total_secs : 0.0);
+
+  llvm::outs() << llvm::format("%-20s %8s %12s %12s\n", "instruction", "count",
+			       "usecs/inst", "allocs/inst");
+  for (unsigned op = 0; op < profile.costs.size(); ++op) {
+    const CfgBuilderProfile::cost &c = profile.costs[op];
+    if (c.count == 0) continue;
+    llvm::outs() << llvm::format("%-20s %8u %12.3f %12.2f\n",
+				 llvm::Instruction::getOpcodeName(op), c.count,
+				 (c.secs * 1e6) / c.count, (double) c.allocs / c.count);
+  }
+  return 0;
+}
@@ -20,13 +20,19 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 #include "crab_llvm/config.h"
 #include "crab_llvm/Passes.hh"
+#include "crab_llvm/Transforms/PreProcessing.hh"
 
-#ifdef HAVE_LLVM_SEAHORN
-#include "llvm_seahorn/Transforms/Scalar.h"
-#endif 
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <thread>
+#include <vector>
 
 static llvm::cl::opt<std::string>
 InputFilename(llvm::cl::Positional, llvm::cl::desc("<input LLVM bitcode file>"),
@@ -54,6 +60,11 @@ InlineAll("crab-inline-all",
 	   llvm::cl::desc("Inline all functions"),
            llvm::cl::init(false));
 
+static llvm::cl::opt<unsigned>
+InlineBudget("crab-inline-budget",
+	     llvm::cl::desc("Inline functions only if the callers do not exceed this number of instructions"),
+	     llvm::cl::init(0));
+
 static llvm::cl::opt<bool>
 Devirtualize("crab-devirt", 
               llvm::cl::desc("Resolve indirect calls"),
@@ -64,6 +75,12 @@ LowerSelect("crab-lower-select",
 	     llvm::cl::desc("Lower all select instructions"),
              llvm::cl::init(false));
 
+static llvm::cl::opt<bool>
+LowerRelevantSelect("crab-lower-relevant-select",
+	     llvm::cl::desc("Lower only the select instructions that flow into "
+			    "assertions or loop guards"),
+             llvm::cl::init(false));
+
 static llvm::cl::opt<bool>
 LowerGv("crab-lower-gv",
 	 llvm::cl::desc("Lower global initializers in main"),
@@ -106,6 +123,181 @@ SROA_ScalarLoadThreshold("sroa-scalar-load",
                 llvm::cl::desc("Scalar load threshold for ScalarReplAggregates"),
                 llvm::cl::init(-1));
 
+static llvm::cl::opt<unsigned>
+PPJobs("crab-pp-jobs",
+       llvm::cl::desc("Run the function passes on N partitions of the module in parallel "
+		      "(ignored if inlining)"),
+       llvm::cl::init(1), llvm::cl::value_desc("N"));
+
+namespace parallel_pp_impl {
+  using namespace llvm;
+
+  // A partition is a copy of the module where only the functions of
+  // the partition keep their bodies. All partitions keep the
+  // definitions of the global variables so the function passes see
+  // their initializers, but only the first one keeps them after the
+  // passes so the partitions can be linked back.
+  struct partition {
+    std::vector<std::string> functions;
+    unsigned size;
+    std::string bitcode;
+    std::string error;
+    partition(): size(0) {}
+  };
+
+  static std::string toBitcode(const Module &M) {
+    std::string buf;
+    raw_string_ostream os(buf);
+    WriteBitcodeToFile(&M, os);
+    return os.str();
+  }
+
+  static std::unique_ptr<Module> fromBitcode(const std::string &bitcode,
+					     LLVMContext &ctx, std::string &error) {
+    ErrorOr<std::unique_ptr<Module>> M =
+      parseBitcodeFile(MemoryBufferRef(bitcode, "crab-pp-partition"), ctx);
+    if (!M) {
+      error = M.getError().message();
+      return nullptr;
+    }
+    return std::move(M.get());
+  }
+
+  // Run in its own context so the partitions do not share anything
+  static void runPartition(partition &p, unsigned id,
+			   const crab_llvm::PreProcessingOptions &opts) {
+    LLVMContext ctx;
+    std::unique_ptr<Module> M = fromBitcode(p.bitcode, ctx, p.error);
+    if (!M) return;
+    legacy::PassManager pass_manager;
+    crab_llvm::addPreProcessingFunctionPasses(pass_manager, opts);
+    pass_manager.run(*M);
+    if (id > 0) {
+      // -- each partition numbers the nondet functions created by
+      //    --crab-turn-undef-nondet from 0 so the same name can have
+      //    different types in two partitions. A nondet function has
+      //    no body so it can be renamed.
+      const StringRef nondet_prefix("verifier.nondet.");
+      for (Function &F: *M) {
+	if (F.isDeclaration() && F.getName().startswith(nondet_prefix)) {
+	  F.setName(nondet_prefix.str() + "pp" + std::to_string(id) + "." +
+		    F.getName().substr(nondet_prefix.size()).str());
+	}
+      }
+      for (GlobalVariable &GV: M->globals()) {
+	if (GV.isDeclaration()) continue;
+	GV.setInitializer(nullptr);
+	GV.setLinkage(GlobalValue::ExternalLinkage);
+	GV.setComdat(nullptr);
+      }
+    }
+    p.bitcode = toBitcode(*M);
+  }
+
+  // Run the pipeline of crab_llvm::addPreProcessingPasses with the
+  // function passes running on num_parts partitions in parallel.
+  // Return false if some partition cannot be read back or linked.
+  static bool run(std::unique_ptr<Module> &M,
+		  const crab_llvm::PreProcessingOptions &opts,
+		  unsigned num_parts) {
+    {
+      legacy::PassManager pass_manager;
+      crab_llvm::addPreProcessingModulePasses(pass_manager, opts);
+      pass_manager.run(*M);
+    }
+
+    // -- the declarations in a partition must resolve to the
+    //    definitions in another one so local symbols are externalized
+    //    and restored after linking
+    std::map<std::string, std::pair<GlobalValue::LinkageTypes,
+				    GlobalValue::VisibilityTypes>> locals;
+    auto externalize = [&locals](GlobalValue &GV) {
+      if (!GV.hasLocalLinkage()) return;
+      if (!GV.hasName()) GV.setName("crab.pp.local");
+      locals[GV.getName()] = std::make_pair(GV.getLinkage(), GV.getVisibility());
+      GV.setLinkage(GlobalValue::ExternalLinkage);
+      GV.setVisibility(GlobalValue::HiddenVisibility);
+    };
+    for (Function &F: *M) externalize(F);
+    for (GlobalVariable &GV: M->globals()) externalize(GV);
+    for (GlobalAlias &GA: M->aliases()) externalize(GA);
+
+    // -- balance the number of instructions: largest function first
+    //    into the smallest partition
+    std::vector<std::pair<unsigned, std::string>> funcs;
+    for (Function &F: *M) {
+      if (F.isDeclaration()) continue;
+      unsigned size = 0;
+      for (BasicBlock &B: F) size += B.size();
+      funcs.push_back(std::make_pair(size, F.getName().str()));
+    }
+    std::stable_sort(funcs.begin(), funcs.end(),
+		     [](const std::pair<unsigned, std::string> &a,
+			const std::pair<unsigned, std::string> &b) {
+		       return a.first > b.first;
+		     });
+    num_parts = std::max(1u, std::min(num_parts, (unsigned) funcs.size()));
+    std::vector<partition> parts(num_parts);
+    for (auto &f: funcs) {
+      auto it = std::min_element(parts.begin(), parts.end(),
+				 [](const partition &a, const partition &b) {
+				   return a.size < b.size;
+				 });
+      it->functions.push_back(f.second);
+      it->size += f.first;
+    }
+
+    for (partition &p: parts) {
+      std::unique_ptr<Module> clone = CloneModule(M.get());
+      std::vector<std::string> &fs = p.functions;
+      std::sort(fs.begin(), fs.end());
+      for (Function &F: *clone) {
+	if (!F.isDeclaration() &&
+	    !std::binary_search(fs.begin(), fs.end(), F.getName().str())) {
+	  F.deleteBody();
+	  F.setComdat(nullptr);
+	}
+      }
+      p.bitcode = toBitcode(*clone);
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < num_parts; ++i) {
+      workers.push_back(std::thread(runPartition, std::ref(parts[i]), i, std::cref(opts)));
+    }
+    runPartition(parts[0], 0, opts);
+    for (std::thread &t: workers) t.join();
+
+    // -- link the partitions back into the main context
+    LLVMContext &ctx = M->getContext();
+    std::unique_ptr<Module> linked;
+    for (partition &p: parts) {
+      std::unique_ptr<Module> part;
+      if (p.error.empty()) part = fromBitcode(p.bitcode, ctx, p.error);
+      if (!part) {
+	errs() << "error: cannot read back a partition of the module: "
+	       << p.error << "\n";
+	return false;
+      }
+      if (!linked) {
+	linked = std::move(part);
+      } else if (Linker::linkModules(*linked, std::move(part))) {
+	errs() << "error: cannot link the partitions of the module\n";
+	return false;
+      }
+    }
+
+    for (auto &kv: locals) {
+      if (GlobalValue *GV = linked->getNamedValue(kv.first)) {
+	GV->setLinkage(kv.second.first);
+	GV->setVisibility(kv.second.second);
+      }
+    }
+    M = std::move(linked);
+    return true;
+  }
+}
+
 // removes extension from filename if there is one
 std::string getFileName(const std::string &str) {
   std::string filename = str;
@@ -115,27 +307,6 @@ std::string getFileName(const std::string &str) {
   return filename;
 }
 
-void break_allocas(llvm::legacy::PassManager &pass_manager) {
-    #ifdef HAVE_LLVM_SEAHORN
-    // -- can remove bitcast from bitcast(alloca(...))
-    pass_manager.add(llvm_seahorn::createInstructionCombiningPass());
-    #endif     
-    pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
-    // -- break alloca's into scalars
-    pass_manager.add(llvm::createScalarReplAggregatesPass
-    		     (SROA_Threshold,
-    		       true,
-    		       SROA_StructMemThreshold,
-    		       SROA_ArrayElementThreshold,
-    		       SROA_ScalarLoadThreshold));
-    #ifdef HAVE_LLVM_SEAHORN
-    if (TurnUndefNondet) {
-      // -- Turn undef into nondet (undef are created by SROA when it calls mem2reg)
-      pass_manager.add(llvm_seahorn::createNondetInitPass());
-    }
-    #endif
-}
-
 int main(int argc, char **argv) {
   llvm::llvm_shutdown_obj shutdown;  // calls llvm_shutdown() on exit
   llvm::cl::ParseCommandLineOptions(argc, argv,
@@ -218,154 +389,34 @@ int main(int argc, char **argv) {
 
   assert(dl && "Could not find Data Layout for the module");
 
-  // -- promote top-level mallocs to alloca
-  pass_manager.add(crab_llvm::createPromoteMallocPass());  
-
-  // -- turn all functions internal so that we can apply some global
-  // -- optimizations inline them if requested
-  pass_manager.add(llvm::createInternalizePass(llvm::ArrayRef<const char*>("main")));
-
-  if (Devirtualize) {
-    // -- resolve indirect calls
-    pass_manager.add(crab_llvm::createDevirtualizeFunctionsPass());
+  crab_llvm::PreProcessingOptions opts;
+  opts.inline_all = InlineAll;
+  opts.inline_budget = InlineBudget;
+  opts.devirtualize = Devirtualize;
+  opts.lower_select = LowerSelect;
+  opts.lower_relevant_select = LowerRelevantSelect;
+  opts.lower_gv = LowerGv;
+  opts.externalize_addr_taken_funcs = ExternalizeAddrTakenFuncs;
+  opts.lower_unsigned_icmp = LowerUnsignedICmp;
+  opts.optimize_loops = OptimizeLoops;
+  opts.turn_undef_nondet = TurnUndefNondet;
+  opts.sroa_threshold = SROA_Threshold;
+  opts.sroa_struct_mem_threshold = SROA_StructMemThreshold;
+  opts.sroa_array_element_threshold = SROA_ArrayElementThreshold;
+  opts.sroa_scalar_load_threshold = SROA_ScalarLoadThreshold;
+
+  bool parallel = PPJobs > 1;
+  if (parallel && crab_llvm::needsInlining(opts)) {
+    llvm::errs() << "warning: --crab-pp-jobs is ignored with inlining\n";
+    parallel = false;
   }
   
- if (ExternalizeAddrTakenFuncs) {
-    // -- externalize uses of address-taken functions
-    pass_manager.add(crab_llvm::createExternalizeAddressTakenFunctionsPass());
+  if (parallel) {
+    if (!parallel_pp_impl::run(module, opts, PPJobs)) return 3;
+    crab_llvm::addPreProcessingFinalPasses(pass_manager, opts);
+  } else {
+    crab_llvm::addPreProcessingPasses(pass_manager, opts);
   }
-  
-  // kill unused internal global    
-  pass_manager.add(llvm::createGlobalDCEPass()); 
-  pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
-  // -- global optimizations
-  pass_manager.add(llvm::createGlobalOptimizerPass());
-
-  if (LowerGv) {
-    // -- lower initializers of global variables
-    pass_manager.add(crab_llvm::createLowerGvInitializersPass());   
-  }
-
-  // -- SSA
-  pass_manager.add(llvm::createPromoteMemoryToRegisterPass());
-  #ifdef HAVE_LLVM_SEAHORN
-  if (TurnUndefNondet) {
-    // -- Turn undef into nondet
-    pass_manager.add(llvm_seahorn::createNondetInitPass());
-  }
-  #endif 
-
-  // -- cleanup after SSA
-  #ifdef HAVE_LLVM_SEAHORN
-  pass_manager.add(llvm_seahorn::createInstructionCombiningPass());
-  #endif 
-  pass_manager.add(llvm::createCFGSimplificationPass());
-  break_allocas(pass_manager);
-  // // -- break aggregates
-  // pass_manager.add(llvm::createScalarReplAggregatesPass
-  // 		    (SROA_Threshold,
-  // 		     true,
-  // 		     SROA_StructMemThreshold,
-  // 		     SROA_ArrayElementThreshold,
-  // 		     SROA_ScalarLoadThreshold));
-  
-  // #ifdef HAVE_LLVM_SEAHORN
-  // if (TurnUndefNondet) {
-  //    // -- Turn undef into nondet (undef are created by SROA when it calls mem2reg)
-  //    pass_manager.add(llvm_seahorn::createNondetInitPass());
-  // }
-  // #endif
-
-  // -- global value numbering and redundant load elimination
-  pass_manager.add(llvm::createGVNPass());
-  
-  // -- cleanup after break aggregates
-  #ifdef HAVE_LLVM_SEAHORN
-  pass_manager.add(llvm_seahorn::createInstructionCombiningPass());
-  #endif 
-  pass_manager.add(llvm::createCFGSimplificationPass());
-  
-  #ifdef HAVE_LLVM_SEAHORN
-  if (TurnUndefNondet) {
-     // eliminate unused calls to verifier.nondet() functions
-     pass_manager.add(llvm_seahorn::createDeadNondetElimPass());
-  }
-  #endif 
-
-  // -- lower invoke's
-  pass_manager.add(llvm::createLowerInvokePass());
-  // cleanup after lowering invoke's
-  pass_manager.add(llvm::createCFGSimplificationPass());  
-  
-  if (InlineAll) {
-    pass_manager.add(crab_llvm::createMarkInternalInlinePass());   
-    pass_manager.add(llvm::createAlwaysInlinerPass());
-    // // after inlining we promote malloc to alloca instructions
-    // pass_manager.add(crab_llvm::createPromoteMallocPass());    
-    // // kill unused internal global    
-    // pass_manager.add(llvm::createGlobalDCEPass());
-    pass_manager.add(llvm::createGlobalDCEPass()); // kill unused internal global
-    // -- promote malloc to alloca
-    pass_manager.add(crab_llvm::createPromoteMallocPass());
-    pass_manager.add(llvm::createGlobalDCEPass()); // kill unused internal global
-    // XXX: for svcomp ssh programs we need to run twice to break all
-    // relevant allocas
-    break_allocas(pass_manager);
-    break_allocas(pass_manager);
-  }
-  
-  pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
-  pass_manager.add(llvm::createDeadInstEliminationPass());
-  
-  if (OptimizeLoops) {
-    // canonical form for loops
-    pass_manager.add(llvm::createLoopSimplifyPass());
-    // cleanup unnecessary blocks     
-    pass_manager.add(llvm::createCFGSimplificationPass());  
-    // loop-closed SSA 
-    pass_manager.add(llvm::createLCSSAPass());
-    #ifdef HAVE_LLVM_SEAHORN
-    // induction variable
-    pass_manager.add(llvm_seahorn::createIndVarSimplifyPass());
-    #endif 
-  }
-
-  // trivial invariants outside loops 
-  pass_manager.add(llvm::createBasicAAWrapperPass());
-  pass_manager.add(llvm::createLICMPass()); //LICM needs alias analysis
-  pass_manager.add(llvm::createPromoteMemoryToRegisterPass());
-  // dead loop elimination
-  pass_manager.add(llvm::createLoopDeletionPass());
-  // cleanup unnecessary blocks   
-  pass_manager.add(llvm::createCFGSimplificationPass()); 
-  
-  // -- ensure one single exit point per function
-  pass_manager.add(llvm::createUnifyFunctionExitNodesPass());
-  pass_manager.add(llvm::createGlobalDCEPass()); 
-  pass_manager.add(llvm::createDeadCodeEliminationPass());
-  // -- remove unreachable blocks also dead cycles
-  pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
-
-  // -- remove switch constructions
-  pass_manager.add(llvm::createLowerSwitchPass());
-  // cleanup unnecessary blocks     
-  pass_manager.add(llvm::createCFGSimplificationPass());  
-  
-  // -- lower constant expressions to instructions
-  pass_manager.add(crab_llvm::createLowerCstExprPass());   
-  pass_manager.add(llvm::createDeadCodeEliminationPass());
-
-  // -- lower ULT and ULE instructions  
-  if(LowerUnsignedICmp) {
-    pass_manager.add(crab_llvm::createLowerUnsignedICmpPass());   
-    // cleanup unnecessary and unreachable blocks   
-    pass_manager.add(llvm::createCFGSimplificationPass());
-    pass_manager.add(crab_llvm::createRemoveUnreachableBlocksPass());
-  }
-  
-  // -- must be the last one to avoid llvm undoing it
-  if (LowerSelect)
-    pass_manager.add(crab_llvm::createLowerSelectPass());   
 
   if(!AsmOutputFilename.empty()) 
     pass_manager.add(createPrintModulePass(asmOutput->os()));
@@ -0,0 +1,119 @@
+///
+// Replay the analysis of a reproducer written by --crab-extract-slow
+///
+
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/Format.h"
+
+#include "crab_llvm/config.h"
+#include "crab_llvm/CrabLlvm.hh"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static llvm::cl::opt<std::string>
+InputFilename(llvm::cl::Positional, llvm::cl::desc("<reproducer .bc file>"),
+              llvm::cl::Required, llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<std::string>
+ArgsFilename("replay-args",
+	     llvm::cl::desc("Options of the analysis, one per line "
+			    "(default: the .args file next to the reproducer)"),
+	     llvm::cl::init(""), llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<unsigned>
+Repeat("replay-repeat",
+       llvm::cl::desc("Number of times the analysis is run"),
+       llvm::cl::init(1));
+
+// Read the options of the analysis. Options that are not registered
+// in this executable (e.g., options of crabllvm-pp) are skipped.
+static bool readArgs(const std::string &file, std::vector<std::string> &args) {
+  std::ifstream in(file);
+  if (!in) return false;
+  llvm::StringMap<llvm::cl::Option*> &opts = llvm::cl::getRegisteredOptions();
+  std::string line;
+  while (std::getline(in, line)) {
+    llvm::StringRef name = llvm::StringRef(line).trim();
+    if (name.empty()) continue;
+    name = name.ltrim('-').split('=').first;
+    if (!opts.count(name)) {
+      llvm::errs() << "Warning: ignored unknown option " << line << "\n";
+      continue;
+    }
+    args.push_back(line);
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  llvm::llvm_shutdown_obj shutdown;  // calls llvm_shutdown() on exit
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+  "CrabLlvm-- Replay the analysis of a reproducer written by --crab-extract-slow\n"
+  "The options on the command line are overridden by the ones of the reproducer\n");
+
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::PrettyStackTraceProgram PSTP(argc, argv);
+
+  std::string args_file = ArgsFilename;
+  if (args_file.empty()) {
+    llvm::StringRef bc(InputFilename);
+    args_file = (bc.endswith(".bc") ? bc.drop_back(3) : bc).str() + ".args";
+  }
+  std::vector<std::string> args = {argv[0]};
+  if (!readArgs(args_file, args)) {
+    llvm::errs() << "error: cannot read " << args_file << "\n";
+    return 3;
+  }
+  std::vector<const char*> cargs;
+  for (auto &a : args) cargs.push_back(a.c_str());
+  llvm::cl::ParseCommandLineOptions(cargs.size(), &cargs[0]);
+
+  llvm::SMDiagnostic err;
+  llvm::LLVMContext &context = llvm::getGlobalContext();
+  std::unique_ptr<llvm::Module> module = llvm::parseIRFile(InputFilename, err, context);
+  if (!module) {
+    llvm::errs() << "error: "
+                 << "Bitcode was not properly read; " << err.getMessage() << "\n";
+    return 3;
+  }
+
+  llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
+  llvm::initializeAnalysis(Registry);
+  llvm::initializeCallGraphWrapperPassPass(Registry);
+
+  llvm::outs() << llvm::format("%-8s %12s\n", "run", "ms");
+  double total_ms = 0;
+  for (unsigned i = 0; i < Repeat; ++i) {
+    // -- a new pass manager so the heap abstraction and the CFGs are
+    //    computed again as in the original run
+    llvm::legacy::PassManager pass_manager;
+    pass_manager.add(new llvm::TargetLibraryInfoWrapperPass
+		     (llvm::Triple(module->getTargetTriple())));
+    pass_manager.add(new crab_llvm::CrabLlvmPass());
+    auto start = std::chrono::steady_clock::now();
+    pass_manager.run(*module);
+    std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    total_ms += d.count();
+    llvm::outs() << llvm::format("%-8u %12.1f\n", i + 1, d.count());
+  }
+  if (Repeat > 1) {
+    llvm::outs() << llvm::format("%-8s %12.1f\n", "mean", total_ms / Repeat);
+  }
+  return 0;
+}
@@ -20,6 +20,9 @@
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "crab_llvm/config.h"
 
 #ifdef HAVE_LLVM_SEAHORN
@@ -29,11 +32,35 @@
 #include "crab_llvm/Passes.hh"
 #include "crab_llvm/CrabLlvm.hh"
 #include "crab_llvm/Transforms/InsertInvariants.hh"
+#include "crab_llvm/Transforms/PreProcessing.hh"
+#include "crab_llvm/wrapper_domain.hh"
 #include "crab/common/debug.hpp"
-
-static llvm::cl::opt<std::string>
-InputFilename(llvm::cl::Positional, llvm::cl::desc("<input LLVM bitcode file>"),
-              llvm::cl::Required, llvm::cl::value_desc("filename"));
+#include "crab_llvm/Support/Stats.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <ctime>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+static llvm::cl::list<std::string>
+InputFilenames(llvm::cl::Positional, llvm::cl::desc("<input LLVM bitcode files>"),
+               llvm::cl::OneOrMore, llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<unsigned>
+BatchJobs("crab-batch-jobs", 
+	  llvm::cl::desc("Number of input files analyzed at the same time by "
+			 "separate processes (only with several input files)"),
+	  llvm::cl::init(1), llvm::cl::value_desc("uint"));
 
 static llvm::cl::opt<std::string>
 OutputFilename("o", llvm::cl::desc("Override output filename"),
@@ -68,11 +95,90 @@ LowerSelect ("crab-lower-select",
              llvm::cl::desc ("Lower all select instructions"),
              llvm::cl::init (false));
 
+static llvm::cl::opt<bool>
+LowerRelevantSelect ("crab-lower-relevant-select", 
+             llvm::cl::desc ("Lower only the select instructions that flow into "
+			     "assertions or loop guards"),
+             llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+Server ("server", 
+	llvm::cl::desc ("Keep the analyzed module in memory and answer queries from stdin"),
+	llvm::cl::init (false));
+
 static llvm::cl::opt<bool>
 PromoteAssume ("crab-promote-assume", 
 	       llvm::cl::desc ("Promote verifier.assume to llvm.assume intrinsics"),
 	       llvm::cl::init (false));
 
+static llvm::cl::opt<bool>
+LowerInvMetadata ("crab-lower-invariant-metadata", 
+	       llvm::cl::desc ("Lower the invariants attached as !crab.inv metadata "
+			       "to verifier.assume instructions"),
+	       llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+Streaming ("crab-streaming", 
+	   llvm::cl::desc ("Insert the invariants of each function as soon as it is analyzed "
+			   "and then release its invariants and CFG"),
+	   llvm::cl::init (false));
+
+
+static llvm::cl::opt<bool>
+WithPP ("with-pp", 
+	llvm::cl::desc ("Run the crabllvm-pp pipeline before the analysis in the same process"),
+	llvm::cl::init (false));
+
+static llvm::cl::opt<std::string>
+OnlyFunctions ("crab-only-functions", 
+	llvm::cl::desc ("Load lazily the bitcode and analyze only the functions "
+			"whose names match the regex or are listed in the file "
+			"(one per line), and their callees"),
+	llvm::cl::init (""),
+	llvm::cl::value_desc ("regex|file"));
+
+static llvm::cl::opt<bool>
+ForceNormalize ("crab-force-normalize", 
+	llvm::cl::desc ("Run all normalization passes even if the module records "
+			"that they were already applied by crabllvm-pp"),
+	llvm::cl::init (false),
+	llvm::cl::Hidden);
+
+/* crabllvm-pp options (only with --with-pp) */
+static llvm::cl::opt<bool>
+InlineAll ("crab-inline-all",
+	   llvm::cl::desc ("Inline all functions (only with --with-pp)"),
+	   llvm::cl::init (false));
+
+static llvm::cl::opt<unsigned>
+InlineBudget ("crab-inline-budget",
+	      llvm::cl::desc ("Inline functions only if the callers do not exceed this number of instructions (only with --with-pp)"),
+	      llvm::cl::init (0));
+
+static llvm::cl::opt<bool>
+Devirtualize ("crab-devirt", 
+	      llvm::cl::desc ("Resolve indirect calls (only with --with-pp)"),
+	      llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+LowerGv ("crab-lower-gv",
+	 llvm::cl::desc ("Lower global initializers in main (only with --with-pp)"),
+	 llvm::cl::init (true));
+
+static llvm::cl::opt<bool>
+ExternalizeAddrTakenFuncs ("crab-externalize-addr-taken-funcs", 
+	 llvm::cl::desc ("Externalize uses of address-taken functions (only with --with-pp)"),
+	 llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+LowerUnsignedICmp ("crab-lower-unsigned-icmp",
+	 llvm::cl::desc ("Lower ULT and ULE instructions (only with --with-pp)"),
+	 llvm::cl::init (false));
+
+static llvm::cl::opt<bool>
+OptimizeLoops ("crab-llvm-pp-loops", 
+	       llvm::cl::desc ("Perform loop optimizations (only with --with-pp)"),
+	       llvm::cl::init (false));
 
 /* logging and verbosity */
 
@@ -141,23 +247,237 @@ std::string getFileName(const std::string &str) {
   return filename;
 }
 
-int main(int argc, char **argv) {
-  llvm::llvm_shutdown_obj shutdown;  // calls llvm_shutdown() on exit
-  llvm::cl::ParseCommandLineOptions(argc, argv,
-  "CrabLlvm-- Abstract Interpretation-based Analyzer of LLVM bitcode\n");
+/** 
+ * Server mode (--server)
+ *
+ * After the analysis, requests are read from stdin, one per line, and
+ * each one is answered with a JSON object in a separate line:
+ *
+ *   pre FUNCTION BLOCK       invariants at the entry of BLOCK
+ *   post FUNCTION BLOCK      invariants at the exit of BLOCK
+ *   checks                   checks of the last analysis of the module
+ *   analyze FUNCTION [DOM]   analyze again FUNCTION (optionally with DOM)
+ *   quit
+ **/
+namespace server_impl {
+
+  static std::string escape(const std::string &str) {
+    std::string res;
+    for (char c : str) {
+      switch (c) {
+      case '"':  res += "\\\""; break;
+      case '\\': res += "\\\\"; break;
+      case '\n': res += "\\n"; break;
+      case '\t': res += "\\t"; break;
+      default:   res += c;
+      }
+    }
+    return res;
+  }
 
-  llvm::sys::PrintStackTraceOnErrorSignal();
-  llvm::PrettyStackTraceProgram PSTP(argc, argv);
-  llvm::EnableDebugBuffering = true;
+  static void error(const std::string &msg) {
+    std::cout << "{\"status\":\"error\",\"message\":\"" << escape(msg) << "\"}" << std::endl;
+  }
+
+  static bool getDomain(const std::string &name, CrabDomain &dom) {
+    static const std::map<std::string, CrabDomain> doms = {
+      {"int", INTERVALS}, {"term-int", TERMS_INTERVALS},
+      {"ric", INTERVALS_CONGRUENCES}, {"dis-int", DIS_INTERVALS},
+      {"term-dis-int", TERMS_DIS_INTERVALS}, {"boxes", BOXES},
+      {"zones", ZONES_SPLIT_DBM}, {"oct", OCT}, {"pk", PK},
+      {"rtz", TERMS_ZONES}, {"w-int", WRAPPED_INTERVALS},
+      {"dense-int", DENSE_INTERVALS}, {"zones-fast", ZONES_SPLIT_DBM_FAST},
+      {"w-int-fast", WRAPPED_INTERVALS_FAST}, {"ptr-offsets", PTR_OFFSETS},
+      {"zones-dense", ZONES_DENSE_DBM}};
+    auto it = doms.find(name);
+    if (it == doms.end()) return false;
+    dom = it->second;
+    return true;
+  }
+  
+  static const llvm::BasicBlock* getBlock(llvm::Function &F, const std::string &name) {
+    for (auto &B : F) {
+      if (B.getName() == name) return &B;
+    }
+    return nullptr;
+  }
 
+  static void printChecks(const char *status, unsigned safe, unsigned err, unsigned warn) {
+    std::cout << "{\"status\":\"" << status << "\",\"safe\":" << safe
+	      << ",\"error\":" << err << ",\"warning\":" << warn << "}" << std::endl;
+  }
+  
+  static void serve(llvm::Module &M, CrabLlvmPass &crab) {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+      std::istringstream req(line);
+      std::string cmd, fname, arg;
+      req >> cmd >> fname >> arg;
+      if (cmd == "") continue;
+      if (cmd == "quit") break;
+      if (cmd == "checks") {
+	printChecks("ok", crab.get_total_safe_checks(), crab.get_total_error_checks(),
+		    crab.get_total_warning_checks());
+	continue;
+      }
+      
+      llvm::Function *F = M.getFunction(fname);
+      if (!F || F->isDeclaration()) {
+	error("unknown function " + fname);
+	continue;
+      }
+      
+      if (cmd == "pre" || cmd == "post") {
+	const llvm::BasicBlock *B = getBlock(*F, arg);
+	if (!B) {
+	  error("unknown block " + arg);
+	  continue;
+	}
+	auto dom = (cmd == "pre" ? crab.get_pre(B) : crab.get_post(B));
+	if (!dom) {
+	  error("no invariants for " + arg);
+	  continue;
+	}
+	crab::crab_string_os o;
+	dom->write(o);
+	std::cout << "{\"status\":\"ok\",\"invariant\":\"" << escape(o.str()) << "\"}"
+		  << std::endl;
+      } else if (cmd == "analyze") {
+	AnalysisParams params(crab.get_analysis_params());
+	if (arg != "" && !getDomain(arg, params.dom)) {
+	  error("unknown domain " + arg);
+	  continue;
+	}
+	auto checks = crab.analyze_function(*F, params);
+	printChecks("ok", checks.get_total_safe(), checks.get_total_error(),
+		    checks.get_total_warning());
+      } else {
+	error("unknown request " + cmd);
+      }
+    }
+  }
+} // end namespace server_impl
+
+/**
+ * Function-subset analysis (--crab-only-functions)
+ *
+ * The bitcode is loaded lazily and only the bodies of the selected
+ * functions and of the functions they (transitively) call directly
+ * are materialized. The other functions become declarations so the
+ * rest of the pipeline, the analysis and the insertion of invariants
+ * skip them.
+ **/
+namespace subset_impl {
+
+  // Add to names the selected functions of M. Return false if the
+  // selection cannot be parsed.
+  static bool select(llvm::Module &M, const std::string &sel,
+		     std::set<std::string> &names, std::string &error) {
+    if (llvm::sys::fs::is_regular_file(sel)) {
+      auto buf = llvm::MemoryBuffer::getFile(sel);
+      if (!buf) {
+	error = "cannot read " + sel + ": " + buf.getError().message();
+	return false;
+      }
+      llvm::SmallVector<llvm::StringRef, 32> lines;
+      (*buf)->getBuffer().split(lines, '\n', -1, false);
+      for (llvm::StringRef l : lines) {
+	l = l.trim();
+	if (!l.empty()) names.insert(l.str());
+      }
+      return true;
+    }
+
+    llvm::Regex re(sel);
+    if (!re.isValid(error)) return false;
+    for (auto &F : M) {
+      if (re.match(F.getName())) names.insert(F.getName().str());
+    }
+    return true;
+  }
+
+  // Materialize the selected functions and their direct callees and
+  // drop the bodies of all the other functions.
+  static bool materialize(llvm::Module &M, const std::set<std::string> &names,
+			  std::string &error) {
+    std::set<llvm::Function*> reached;
+    std::vector<llvm::Function*> worklist;
+    for (auto &name : names) {
+      if (llvm::Function *F = M.getFunction(name)) {
+	if (reached.insert(F).second) worklist.push_back(F);
+      }
+    }
+    while (!worklist.empty()) {
+      llvm::Function *F = worklist.back();
+      worklist.pop_back();
+      if (std::error_code ec = F->materialize()) {
+	error = "cannot materialize " + F->getName().str() + ": " + ec.message();
+	return false;
+      }
+      for (auto &B : *F) {
+	for (auto &I : B) {
+	  llvm::CallSite CS(&I);
+	  if (!CS.getInstruction()) continue;
+	  auto *callee = llvm::dyn_cast<llvm::Function>
+	    (CS.getCalledValue()->stripPointerCasts());
+	  if (callee && reached.insert(callee).second) worklist.push_back(callee);
+	}
+      }
+    }
+    for (auto &F : M) {
+      if (!reached.count(&F) && !F.isDeclaration()) F.deleteBody();
+    }
+    // -- the rest of the module (e.g., metadata)
+    if (std::error_code ec = M.materializeAll()) {
+      error = ec.message();
+      return false;
+    }
+    return true;
+  }
+} // end namespace subset_impl
+
+/**
+ * Startup time (--crab-stats)
+ *
+ * The time spent before the analysis starts: loading the executable
+ * and running the static constructors (pre-main), parsing the
+ * options, registering the passes and parsing the bitcode. The time
+ * of the heap analysis is reported by the pass.
+ **/
+namespace startup_impl {
+
+  typedef std::chrono::steady_clock wall_clock;
+
+  // CPU time of the process so far, in microseconds
+  static uint64_t processTime() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0;
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+  }
+
+  static void record(const std::string &phase, wall_clock::time_point start) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>
+      (wall_clock::now() - start).count();
+    crab_llvm::count_max_stat("CrabLlvm.startup." + phase + "_us", us);
+  }
+} // end namespace startup_impl
+
+// Analyze the bitcode file InputFilename in its own context. Return
+// the exit code of crabllvm.
+static int analyzeFile(const std::string &InputFilename, int argc, char **argv) {
   std::error_code error_code;
   llvm::SMDiagnostic err;
-  llvm::LLVMContext &context = llvm::getGlobalContext();
+  llvm::LLVMContext context;
   std::unique_ptr<llvm::Module> module;
   std::unique_ptr<llvm::tool_output_file> output;
   std::unique_ptr<llvm::tool_output_file> asmOutput;
   
-  module = llvm::parseIRFile(InputFilename, err, context);
+  auto parse_start = startup_impl::wall_clock::now();
+  if (OnlyFunctions.empty())
+    module = llvm::parseIRFile(InputFilename, err, context);
+  else
+    module = llvm::getLazyIRFileModule(InputFilename, err, context);
+  startup_impl::record("bitcode", parse_start);
   if (!module) {
     if (llvm::errs().has_colors()) llvm::errs().changeColor(llvm::raw_ostream::RED);
     llvm::errs() << "error: "
@@ -166,6 +486,24 @@ int main(int argc, char **argv) {
     return 3;
   }
 
+  // -- functions that must not be internalized
+  std::set<std::string> externals = {"main"};
+  if (!OnlyFunctions.empty()) {
+    std::set<std::string> names;
+    std::string msg;
+    if (!subset_impl::select(*module, OnlyFunctions, names, msg) ||
+	!subset_impl::materialize(*module, names, msg)) {
+      if (llvm::errs().has_colors()) llvm::errs().changeColor(llvm::raw_ostream::RED);
+      llvm::errs() << "error: --crab-only-functions: " << msg << "\n";
+      if (llvm::errs().has_colors()) llvm::errs().resetColor();
+      return 3;
+    }
+    // -- otherwise the selected functions can be removed by GlobalDCE
+    externals.insert(names.begin(), names.end());
+  }
+  std::vector<const char*> export_list;
+  for (auto &name : externals) export_list.push_back(name.c_str());
+
   if (!AsmOutputFilename.empty ())
     asmOutput = 
       llvm::make_unique<llvm::tool_output_file>(AsmOutputFilename.c_str(), error_code, 
@@ -196,17 +534,6 @@ int main(int argc, char **argv) {
   ///////////////////////////////
 
   llvm::legacy::PassManager pass_manager;
-  llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
-  llvm::initializeAnalysis(Registry);
-  
-  /// call graph and other IPA passes
-  // llvm::initializeIPA (Registry);
-  // XXX: porting to 3.8 
-  llvm::initializeCallGraphWrapperPassPass(Registry);
-  llvm::initializeCallGraphPrinterPass(Registry);
-  llvm::initializeCallGraphViewerPass(Registry);
-  // XXX: not sure if needed anymore
-  llvm::initializeGlobalsAAWrapperPassPass(Registry);  
     
   // add an appropriate DataLayout instance for the module
   const llvm::DataLayout *dl = &module->getDataLayout ();
@@ -218,54 +545,120 @@ int main(int argc, char **argv) {
 
   assert (dl && "Could not find Data Layout for the module");
   
+  // -- e.g., the input was produced with --crab-add-invariants-metadata
+  if (LowerInvMetadata)
+    pass_manager.add (crab_llvm::createLowerInvariantMetadataPass ());
+
+  // -- normalizations already applied to the module
+  unsigned norms = 0;
+  if (WithPP) {
+    // -- the passes of crabllvm-pp: the module is not serialized
+    // -- between preprocessing and analysis
+    crab_llvm::PreProcessingOptions opts;
+    opts.inline_all = InlineAll;
+    opts.inline_budget = InlineBudget;
+    opts.devirtualize = Devirtualize;
+    opts.lower_select = LowerSelect;
+    opts.lower_relevant_select = LowerRelevantSelect;
+    opts.lower_gv = LowerGv;
+    opts.externalize_addr_taken_funcs = ExternalizeAddrTakenFuncs;
+    opts.lower_unsigned_icmp = LowerUnsignedICmp;
+    opts.optimize_loops = OptimizeLoops;
+    opts.turn_undef_nondet = TurnUndefNondet;
+    opts.export_list = export_list;
+    crab_llvm::addPreProcessingPasses(pass_manager, opts);
+    norms = crab_llvm::getPreProcessingNormalizations(opts);
+  } else if (!ForceNormalize) {
+    // -- e.g., the input was produced by crabllvm-pp 
+    norms = crab_llvm::getNormalizations(*module);
+  }
+  
   /**
    * Here only passes that are strictly necessary to avoid crashes or
    * useless results. Passes that are only for improving precision
    * should be run in crabllvm-pp.
    **/
 
-  // -- turn all functions internal so that we can use DSA
-  pass_manager.add (llvm::createInternalizePass (llvm::ArrayRef<const char*>("main")));
-  // kill unused internal global    
-  pass_manager.add (llvm::createGlobalDCEPass ()); 
-  pass_manager.add (crab_llvm::createRemoveUnreachableBlocksPass ());
+  if (!(norms & crab_llvm::NORM_INTERNALIZE)) {
+    // -- turn all functions internal so that we can use DSA
+    pass_manager.add (llvm::createInternalizePass (export_list));
+    // kill unused internal global    
+    pass_manager.add (llvm::createGlobalDCEPass ()); 
+    pass_manager.add (crab_llvm::createRemoveUnreachableBlocksPass ());
+  }
 
-  // -- promote alloca's to registers
-  pass_manager.add (llvm::createPromoteMemoryToRegisterPass());
+  if (!(norms & crab_llvm::NORM_MEM2REG)) {
+    // -- promote alloca's to registers
+    pass_manager.add (llvm::createPromoteMemoryToRegisterPass());
+  }
   #ifdef HAVE_LLVM_SEAHORN
-  if (TurnUndefNondet) {
+  if (TurnUndefNondet && !(norms & crab_llvm::NORM_UNDEF_NONDET)) {
     // -- Turn undef into nondet
     pass_manager.add (llvm_seahorn::createNondetInitPass ());
   }
   #endif 
-  // -- lower invoke's
-  pass_manager.add(llvm::createLowerInvokePass());
-  // cleanup after lowering invoke's
-  pass_manager.add (llvm::createCFGSimplificationPass ());  
-  // -- ensure one single exit point per function
-  pass_manager.add (llvm::createUnifyFunctionExitNodesPass ());
-  // -- remove unreachable blocks 
-  pass_manager.add (crab_llvm::createRemoveUnreachableBlocksPass ());
-  // -- remove switch constructions
-  pass_manager.add (llvm::createLowerSwitchPass());
-  // cleanup after lowering switches
-  pass_manager.add (llvm::createCFGSimplificationPass ());  
-  // -- lower constant expressions to instructions
-  pass_manager.add (crab_llvm::createLowerCstExprPass ());
-  // cleanup after lowering constant expressions
-  pass_manager.add (llvm::createDeadCodeEliminationPass());
+  if (!(norms & crab_llvm::NORM_LOWER_INVOKE)) {
+    // -- lower invoke's
+    pass_manager.add(llvm::createLowerInvokePass());
+    // cleanup after lowering invoke's
+    pass_manager.add (llvm::createCFGSimplificationPass ());  
+  }
+  if (!(norms & crab_llvm::NORM_UNIFY_EXITS)) {
+    // -- ensure one single exit point per function
+    pass_manager.add (llvm::createUnifyFunctionExitNodesPass ());
+    // -- remove unreachable blocks 
+    pass_manager.add (crab_llvm::createRemoveUnreachableBlocksPass ());
+  }
+  if (!(norms & crab_llvm::NORM_LOWER_SWITCH)) {
+    // -- remove switch constructions
+    pass_manager.add (llvm::createLowerSwitchPass());
+    // cleanup after lowering switches
+    pass_manager.add (llvm::createCFGSimplificationPass ());  
+  }
+  if (!(norms & crab_llvm::NORM_LOWER_CST_EXPR)) {
+    // -- lower constant expressions to instructions
+    pass_manager.add (crab_llvm::createLowerCstExprPass ());
+    // cleanup after lowering constant expressions
+    pass_manager.add (llvm::createDeadCodeEliminationPass());
+  }
   #ifdef HAVE_LLVM_SEAHORN
-  if (TurnUndefNondet) 
+  if (TurnUndefNondet && !(norms & crab_llvm::NORM_UNDEF_NONDET)) 
     pass_manager.add (llvm_seahorn::createDeadNondetElimPass ());
   #endif 
 
   // -- must be the last ones before running crab.
   if (LowerSelect)
     pass_manager.add (crab_llvm::createLowerSelectPass ());   
-
+  else if (LowerRelevantSelect)
+    pass_manager.add (crab_llvm::createLowerSelectPass (true));   
+
+  crab_llvm::CrabLlvmPass *crab = nullptr;
+  // instruments each function as soon as it is analyzed
+  std::unique_ptr<crab_llvm::InsertInvariants> inserter;
+  if (Streaming && Server) {
+    llvm::errs() << "Warning: --crab-streaming ignored with --server\n";
+  }
   if (!NoCrab) {
     /// -- run the crab analyzer
-    pass_manager.add (new crab_llvm::CrabLlvmPass ());
+    crab = new crab_llvm::CrabLlvmPass ();
+    crab->set_keep_results(Server);
+    // -- options written in the reproducers of --crab-extract-slow
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+      if (std::find(InputFilenames.begin(), InputFilenames.end(), argv[i]) ==
+	  InputFilenames.end()) {
+	args.push_back(argv[i]);
+      }
+    }
+    crab->set_command_line(args);
+    if (Streaming && !Server) {
+      inserter.reset (new crab_llvm::InsertInvariants ());
+      crab_llvm::InsertInvariants *ins = inserter.get ();
+      crab->set_streaming_callback([crab, ins](llvm::Function &F, llvm::CallGraph *cg) {
+	  return ins->instrument (*crab, F, cg);
+	});
+    }
+    pass_manager.add (crab);
   }
 
   if (!AsmOutputFilename.empty ()) 
@@ -273,16 +666,19 @@ int main(int argc, char **argv) {
  
   if (!NoCrab) {
     /// -- insert invariants as assume instructions
-    pass_manager.add (new crab_llvm::InsertInvariants ());
+    if (!inserter)
+      pass_manager.add (new crab_llvm::InsertInvariants ());
+  }
+  
+  // -- invariants attached as metadata do not need the cleanup
+  if ((!NoCrab && !crab_llvm::InsertInvariants::usesMetadata ()) || LowerInvMetadata) {
     /// -- simplify invariants added in the bytecode.
     #ifdef HAVE_LLVM_SEAHORN
     pass_manager.add (llvm_seahorn::createInstructionCombiningPass ());      
     #endif 
-    pass_manager.add (crab_llvm::createSimplifyAssumePass ());
-    if (PromoteAssume) {
-      // -- promote verifier.assume to llvm.assume intrinsics
-      pass_manager.add (crab_llvm::createPromoteAssumePass());
-    }    
+    /// -- remove redundant assumptions and (optionally) promote
+    /// -- verifier.assume to llvm.assume intrinsics in the same pass
+    pass_manager.add (crab_llvm::createSimplifyAssumePass (PromoteAssume));
   }
       
   if (!OutputFilename.empty ()) {
@@ -294,8 +690,187 @@ int main(int argc, char **argv) {
   
   pass_manager.run(*module.get());
 
+  if (Server) {
+    // the pass manager owns crab so it is alive until analyzeFile returns
+    if (crab) {
+      server_impl::serve(*module, *crab);
+    } else {
+      llvm::errs() << "Warning: --server ignored with -no-crab\n";
+    }
+  }
+
   if (!AsmOutputFilename.empty ()) asmOutput->keep ();
   if (!OutputFilename.empty ()) output->keep();
 
   return 0;
 }
+
+/**
+ * Batch mode (several input files)
+ *
+ * The files are analyzed one after the other in the same process,
+ * each one in its own LLVMContext, so the startup and the
+ * initialization of the options and passes are paid once. With
+ * --crab-batch-jobs=N up to N files are analyzed at the same time by
+ * processes forked after the initialization. The output of each file
+ * is written in a block:
+ *
+ *   === begin FILE ===
+ *   ...
+ *   === end FILE (exit CODE) ===
+ *
+ * in the order of the input files.
+ **/
+namespace batch_impl {
+
+  static void begin(const std::string &file) {
+    llvm::outs() << "=== begin " << file << " ===\n";
+    llvm::outs().flush();
+  }
+
+  static void end(const std::string &file, int rc) {
+    llvm::outs() << "=== end " << file << " (exit " << rc << ") ===\n";
+    llvm::outs().flush();
+  }
+
+  static void flushAll() {
+    llvm::outs().flush();
+    llvm::errs().flush();
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(nullptr);
+  }
+
+  // -- sequential: in this process
+  static int runSequential(int argc, char **argv) {
+    int res = 0;
+    for (auto &file : InputFilenames) {
+      begin(file);
+      int rc = analyzeFile(file, argc, argv);
+      flushAll();
+      end(file, rc);
+      res = std::max(res, rc);
+    }
+    return res;
+  }
+
+  struct job {
+    std::string file;
+    pid_t pid;
+    llvm::SmallString<128> out;
+  };
+
+  // Fork a process that analyzes j.file and writes its output in a
+  // temporary file. Return false if it cannot be started.
+  static bool start(job &j, int argc, char **argv) {
+    int fd;
+    if (llvm::sys::fs::createTemporaryFile("crabllvm-batch", "out", fd, j.out)) {
+      return false;
+    }
+    flushAll();
+    j.pid = fork();
+    if (j.pid < 0) {
+      close(fd);
+      llvm::sys::fs::remove(j.out);
+      return false;
+    }
+    if (j.pid == 0) {
+      dup2(fd, 1);
+      dup2(fd, 2);
+      close(fd);
+      int rc = analyzeFile(j.file, argc, argv);
+      flushAll();
+      _exit(rc);
+    }
+    close(fd);
+    return true;
+  }
+
+  // Wait for j and print its output. Return its exit code.
+  static int finish(job &j) {
+    int status = 0;
+    while (waitpid(j.pid, &status, 0) < 0 && errno == EINTR);
+    int rc = (WIFEXITED(status) ? WEXITSTATUS(status) :
+	      WIFSIGNALED(status) ? 128 + WTERMSIG(status) : 3);
+    begin(j.file);
+    if (auto buf = llvm::MemoryBuffer::getFile(j.out)) {
+      llvm::outs() << (*buf)->getBuffer();
+    }
+    llvm::sys::fs::remove(j.out);
+    end(j.file, rc);
+    return rc;
+  }
+
+  // -- parallel: at most jobs forked processes at the same time
+  static int runParallel(int argc, char **argv, unsigned jobs) {
+    int res = 0;
+    std::deque<job> running;
+    for (auto &file : InputFilenames) {
+      if (running.size() >= jobs) {
+	res = std::max(res, finish(running.front()));
+	running.pop_front();
+      }
+      job j;
+      j.file = file;
+      if (start(j, argc, argv)) {
+	running.push_back(j);
+	continue;
+      }
+      // -- cannot fork: in this process after the running ones
+      while (!running.empty()) {
+	res = std::max(res, finish(running.front()));
+	running.pop_front();
+      }
+      begin(file);
+      int rc = analyzeFile(file, argc, argv);
+      flushAll();
+      end(file, rc);
+      res = std::max(res, rc);
+    }
+    while (!running.empty()) {
+      res = std::max(res, finish(running.front()));
+      running.pop_front();
+    }
+    return res;
+  }
+} // end namespace batch_impl
+
+int main(int argc, char **argv) {
+  crab_llvm::count_max_stat("CrabLlvm.startup.premain_us", startup_impl::processTime());
+  auto start = startup_impl::wall_clock::now();
+  llvm::llvm_shutdown_obj shutdown;  // calls llvm_shutdown() on exit
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+  "CrabLlvm-- Abstract Interpretation-based Analyzer of LLVM bitcode\n");
+  startup_impl::record("options", start);
+  start = startup_impl::wall_clock::now();
+
+  llvm::sys::PrintStackTraceOnErrorSignal();
+  llvm::PrettyStackTraceProgram PSTP(argc, argv);
+  llvm::EnableDebugBuffering = true;
+
+  llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
+  llvm::initializeAnalysis(Registry);
+  
+  /// call graph and other IPA passes
+  // llvm::initializeIPA (Registry);
+  // XXX: porting to 3.8 
+  llvm::initializeCallGraphWrapperPassPass(Registry);
+  llvm::initializeCallGraphPrinterPass(Registry);
+  llvm::initializeCallGraphViewerPass(Registry);
+  // XXX: not sure if needed anymore
+  llvm::initializeGlobalsAAWrapperPassPass(Registry);  
+  startup_impl::record("registry", start);
+
+  if (InputFilenames.size() == 1) {
+    return analyzeFile(InputFilenames[0], argc, argv);
+  }
+
+  if (!OutputFilename.empty() || !AsmOutputFilename.empty() || Server) {
+    llvm::errs() << "error: -o, -oll and --server need a single input file\n";
+    return 3;
+  }
+  if (BatchJobs <= 1) {
+    return batch_impl::runSequential(argc, argv);
+  }
+  return batch_impl::runParallel(argc, argv, BatchJobs);
+}